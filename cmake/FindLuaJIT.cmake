@@ -0,0 +1,79 @@
+#
+#	CMake Find LuaJIT by Parra Studios
+#	CMake script to find LuaJIT 2 library.
+#
+#	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+#
+#	Licensed under the Apache License, Version 2.0 (the "License");
+#	you may not use this file except in compliance with the License.
+#	You may obtain a copy of the License at
+#
+#		http://www.apache.org/licenses/LICENSE-2.0
+#
+#	Unless required by applicable law or agreed to in writing, software
+#	distributed under the License is distributed on an "AS IS" BASIS,
+#	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#	See the License for the specific language governing permissions and
+#	limitations under the License.
+#
+
+# Find LuaJIT library and include paths
+#
+# LUAJIT_FOUND - True if LuaJIT library was found
+# LUAJIT_INCLUDE_DIR - LuaJIT headers path (lua.h, lauxlib.h, lualib.h and luajit.h)
+# LUAJIT_LIBRARY - LuaJIT library
+# LUAJIT_VERSION - LuaJIT version string
+
+# Prevent vervosity if already included
+if(LUAJIT_INCLUDE_DIR)
+	set(LUAJIT_FIND_QUIETLY TRUE)
+endif()
+
+include(FindPackageHandleStandardArgs)
+
+set(LUAJIT_SUFFIXES
+	luajit-2.1
+	luajit-2.0
+	luajit
+)
+
+find_path(LUAJIT_INCLUDE_DIR luajit.h
+	PATHS /usr /usr/include /usr/local /usr/local/include /opt/local
+	PATH_SUFFIXES ${LUAJIT_SUFFIXES} include/luajit-2.1 include/luajit-2.0
+)
+
+find_library(LUAJIT_LIBRARY
+	NAMES luajit-5.1 luajit libluajit
+	PATHS /usr /usr/lib /usr/local /opt/local
+	PATH_SUFFIXES lib lib64
+)
+
+# Try to load by using PkgConfig
+if(NOT LUAJIT_LIBRARY OR NOT LUAJIT_INCLUDE_DIR)
+	# Find package configuration module
+	find_package(PkgConfig)
+
+	# Find module
+	pkg_check_modules(PC_LUAJIT QUIET luajit)
+
+	# Find include path
+	find_path(LUAJIT_INCLUDE_DIR luajit.h HINTS ${PC_LUAJIT_INCLUDEDIR} ${PC_LUAJIT_INCLUDE_DIRS})
+
+	# Find library
+	find_library(LUAJIT_LIBRARY NAMES luajit-5.1 luajit HINTS ${PC_LUAJIT_LIBDIR} ${PC_LUAJIT_LIBRARY_DIRS})
+endif()
+
+if(LUAJIT_INCLUDE_DIR AND EXISTS "${LUAJIT_INCLUDE_DIR}/luajit.h")
+	file(STRINGS "${LUAJIT_INCLUDE_DIR}/luajit.h" LUAJIT_VERSION_LINE REGEX "^#define[ \t]+LUAJIT_VERSION[ \t]+\"LuaJIT .+\"")
+	string(REGEX REPLACE "^#define[ \t]+LUAJIT_VERSION[ \t]+\"LuaJIT ([^\"]+)\".*" "\\1" LUAJIT_VERSION "${LUAJIT_VERSION_LINE}")
+	unset(LUAJIT_VERSION_LINE)
+endif()
+
+# Define LuaJIT cmake module
+find_package_handle_standard_args(LuaJIT
+	REQUIRED_VARS LUAJIT_LIBRARY LUAJIT_INCLUDE_DIR
+	VERSION_VAR LUAJIT_VERSION
+)
+
+# Mark cmake module as advanced
+mark_as_advanced(LUAJIT_INCLUDE_DIR LUAJIT_LIBRARY)
@@ -0,0 +1,70 @@
+#
+#	CMake Find SimdJSON by Parra Studios
+#	CMake script to find SimdJSON library.
+#
+#	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+#
+#	Licensed under the Apache License, Version 2.0 (the "License");
+#	you may not use this file except in compliance with the License.
+#	You may obtain a copy of the License at
+#
+#		http://www.apache.org/licenses/LICENSE-2.0
+#
+#	Unless required by applicable law or agreed to in writing, software
+#	distributed under the License is distributed on an "AS IS" BASIS,
+#	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#	See the License for the specific language governing permissions and
+#	limitations under the License.
+#
+
+# The following variables are set:
+#
+# SIMDJSON_FOUND - True if SimdJSON was found.
+# SIMDJSON_INCLUDE_DIRS - A list of directories where the SimdJSON headers are located.
+# SIMDJSON_LIBRARIES - A list of SimdJSON libraries to link against.
+
+# Prevent vervosity if already included
+if(SIMDJSON_FOUND)
+	set(SIMDJSON_FIND_QUIETLY TRUE)
+endif()
+
+foreach(opt SIMDJSON_ROOT_DIR)
+	if(${opt} AND DEFINED ENV{${opt}} AND NOT ${opt} STREQUAL "$ENV{${opt}}")
+		message(WARNING "Conflicting ${opt} values: ignoring environment variable and using CMake cache entry")
+	elseif(DEFINED ENV{${opt}} AND NOT ${opt})
+		set(${opt} "$ENV{${opt}}")
+	endif()
+endforeach()
+
+find_path(
+	SIMDJSON_INCLUDE_DIRS
+	NAMES simdjson.h
+	HINTS ${SIMDJSON_ROOT_DIR}
+	PATH_SUFFIXES include
+	DOC "Include directory for the SimdJSON library"
+)
+
+find_library(
+	SIMDJSON_LIBRARIES
+	NAMES simdjson
+	HINTS ${SIMDJSON_ROOT_DIR}
+	PATH_SUFFIXES lib lib64
+	DOC "SimdJSON library"
+)
+
+mark_as_advanced(SIMDJSON_INCLUDE_DIRS SIMDJSON_LIBRARIES)
+
+if(SIMDJSON_INCLUDE_DIRS AND SIMDJSON_LIBRARIES)
+	set(SIMDJSON_FOUND TRUE)
+endif()
+
+mark_as_advanced(SIMDJSON_FOUND)
+
+if(SIMDJSON_FOUND)
+	if(NOT SIMDJSON_FIND_QUIETLY)
+		message(STATUS "Found SimdJSON header files in ${SIMDJSON_INCLUDE_DIRS}")
+		message(STATUS "Found SimdJSON library: ${SIMDJSON_LIBRARIES}")
+	endif()
+elseif(SIMDJSON_FIND_REQUIRED)
+	message(FATAL_ERROR "Could not find SimdJSON")
+endif()
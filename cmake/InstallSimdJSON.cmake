@@ -0,0 +1,63 @@
+#
+#	CMake Install SimdJSON by Parra Studios
+#	CMake script to install SimdJSON library.
+#
+#	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+#
+#	Licensed under the Apache License, Version 2.0 (the "License");
+#	you may not use this file except in compliance with the License.
+#	You may obtain a copy of the License at
+#
+#		http://www.apache.org/licenses/LICENSE-2.0
+#
+#	Unless required by applicable law or agreed to in writing, software
+#	distributed under the License is distributed on an "AS IS" BASIS,
+#	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#	See the License for the specific language governing permissions and
+#	limitations under the License.
+#
+
+# The following variables are set:
+#
+# SIMDJSON_INCLUDE_DIRS - A list of directories where the SimdJSON headers are located.
+# SIMDJSON_LIBRARIES - A list of SimdJSON libraries to link against.
+
+if(NOT SIMDJSON_FOUND OR USE_BUNDLED_SIMDJSON)
+	if(NOT SIMDJSON_VERSION OR USE_BUNDLED_SIMDJSON)
+		set(SIMDJSON_VERSION 3.10.1)
+	endif()
+
+	if(MSVC)
+		set(SIMDJSON_LIB_PREFIX "")
+		set(SIMDJSON_LIB_SUFFIX "lib")
+	else()
+		set(SIMDJSON_LIB_PREFIX "lib")
+		set(SIMDJSON_LIB_SUFFIX "a")
+	endif()
+
+	# Build it as a static position independent library so it can be embedded into the serial module,
+	# SimdJSON selects the best kernel (AVX-512, AVX2, SSE4.2, NEON or fallback) at runtime
+	ExternalProject_Add(simd-json-depends
+		GIT_REPOSITORY	"https://github.com/simdjson/simdjson.git"
+		GIT_TAG			"v${SIMDJSON_VERSION}"
+		CMAKE_ARGS
+			-DCMAKE_BUILD_TYPE=Release
+			-DCMAKE_INSTALL_PREFIX=<INSTALL_DIR>
+			-DCMAKE_INSTALL_LIBDIR=lib
+			-DCMAKE_POSITION_INDEPENDENT_CODE=ON
+			-DBUILD_SHARED_LIBS=OFF
+			-DSIMDJSON_DEVELOPER_MODE=OFF
+		TEST_COMMAND	""
+	)
+
+	ExternalProject_Get_Property(simd-json-depends INSTALL_DIR)
+
+	set(SIMDJSON_ROOT_DIR		${INSTALL_DIR})
+	set(SIMDJSON_INCLUDE_DIRS	${SIMDJSON_ROOT_DIR}/include)
+	set(SIMDJSON_LIBRARIES		${SIMDJSON_ROOT_DIR}/lib/${SIMDJSON_LIB_PREFIX}simdjson.${SIMDJSON_LIB_SUFFIX})
+	set(SIMDJSON_FOUND			TRUE)
+
+	mark_as_advanced(SIMDJSON_INCLUDE_DIRS SIMDJSON_LIBRARIES)
+
+	message(STATUS "Installing SimdJSON v${SIMDJSON_VERSION}")
+endif()
@@ -25,6 +25,7 @@
 
 #include <adt/adt_comparable.h>
 #include <adt/adt_hash.h>
+#include <adt/adt_intern.h>
 #include <adt/adt_trie.h>
 #include <adt/adt_vector.h>
 
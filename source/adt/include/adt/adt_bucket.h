@@ -14,6 +14,7 @@
 #include <adt/adt_api.h>
 
 #include <adt/adt_comparable.h>
+#include <adt/adt_hash.h>
 #include <adt/adt_vector.h>
 
 #ifdef __cplusplus
@@ -22,6 +23,7 @@ extern "C" {
 
 /* -- Headers -- */
 
+#include <stdint.h>
 #include <stdlib.h>
 
 /* -- Forward Declarations -- */
@@ -38,34 +40,158 @@ typedef struct bucket_type *bucket;
 
 struct pair_type
 {
+	hash h;
 	void *key;
 	void *value;
 };
 
+/*
+*  Open addressing table shared by set and map, every slot has a control byte
+*  which is either empty, deleted (tombstone) or holds 7 bits of the hash of the
+*  stored key, so lookups can discard a whole group of slots at once and only
+*  call the compare callback for the slots whose hash matches
+*/
 struct bucket_type
 {
 	size_t count;
+	size_t deleted;
 	size_t capacity;
+	uint8_t *control;
 	pair pairs;
 };
 
 /* -- Methods -- */
 
-ADT_API size_t bucket_capacity(size_t prime);
-
-ADT_API bucket bucket_create(size_t size);
-
-ADT_API int bucket_alloc_pairs(bucket b, size_t capacity);
-
-ADT_API int bucket_realloc_pairs(bucket b, size_t new_capacity);
-
-ADT_API pair bucket_get_pair(bucket b, comparable_callback compare_cb, void *key);
-
-ADT_API vector bucket_get_pairs_value(bucket b, comparable_callback compare_cb, void *key);
-
-ADT_API int bucket_insert(bucket b, void *key, void *value);
-
-ADT_API int bucket_remove(bucket b, comparable_callback compare_cb, void *key, void **value);
+/**
+*  @brief
+*    Create an empty bucket table, no slots are allocated until the first insertion
+*
+*  @return
+*    Pointer to the bucket table if success, null otherwise
+*/
+ADT_API bucket bucket_create(void);
+
+/**
+*  @brief
+*    Retrieve the first pair whose key matches @key
+*
+*  @param[in] b
+*    Bucket table to be searched
+*
+*  @param[in] compare_cb
+*    Callback used to compare the keys with the same hash
+*
+*  @param[in] h
+*    Hash of @key
+*
+*  @param[in] key
+*    Key to be searched
+*
+*  @return
+*    Pointer to the pair if found, null otherwise
+*/
+ADT_API pair bucket_get_pair(bucket b, comparable_callback compare_cb, hash h, void *key);
+
+/**
+*  @brief
+*    Retrieve the values of all pairs whose key matches @key
+*
+*  @param[in] b
+*    Bucket table to be searched
+*
+*  @param[in] compare_cb
+*    Callback used to compare the keys with the same hash
+*
+*  @param[in] h
+*    Hash of @key
+*
+*  @param[in] key
+*    Key to be searched
+*
+*  @return
+*    Vector of values if any pair was found, null otherwise
+*/
+ADT_API vector bucket_get_pairs_value(bucket b, comparable_callback compare_cb, hash h, void *key);
+
+/**
+*  @brief
+*    Insert a new pair without checking for duplicated keys, the
+*    table is grown (which invalidates all pairs) when it is full
+*
+*  @param[in] b
+*    Bucket table where the pair will be inserted
+*
+*  @param[in] h
+*    Hash of @key
+*
+*  @param[in] key
+*    Key of the pair
+*
+*  @param[in] value
+*    Value of the pair
+*
+*  @return
+*    Zero if success, different from zero otherwise
+*/
+ADT_API int bucket_insert(bucket b, hash h, void *key, void *value);
+
+/**
+*  @brief
+*    Remove the first pair whose key matches @key, the table is
+*    shrunk (which invalidates all pairs) when it becomes too sparse
+*
+*  @param[in] b
+*    Bucket table where the pair will be removed from
+*
+*  @param[in] compare_cb
+*    Callback used to compare the keys with the same hash
+*
+*  @param[in] h
+*    Hash of @key
+*
+*  @param[in] key
+*    Key to be removed
+*
+*  @param[out] value
+*    Value of the removed pair, it can be null
+*
+*  @return
+*    Zero if success, different from zero otherwise
+*/
+ADT_API int bucket_remove(bucket b, comparable_callback compare_cb, hash h, void *key, void **value);
+
+/**
+*  @brief
+*    Get the index of the first used slot starting at @index (included)
+*
+*  @param[in] b
+*    Bucket table to be iterated
+*
+*  @param[in] index
+*    Slot where the search starts
+*
+*  @return
+*    Index of the slot, or the capacity of @b if there are no more pairs
+*/
+ADT_API size_t bucket_next(bucket b, size_t index);
+
+/**
+*  @brief
+*    Remove all pairs and release the slots of the table
+*
+*  @param[in] b
+*    Bucket table to be cleared
+*/
+ADT_API void bucket_clear(bucket b);
+
+/**
+*  @brief
+*    Destroy the bucket table, keys and values are not released
+*
+*  @param[in] b
+*    Bucket table to be destroyed
+*/
+ADT_API void bucket_destroy(bucket b);
 
 #ifdef __cplusplus
 }
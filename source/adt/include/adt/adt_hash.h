@@ -29,6 +29,7 @@ extern "C" {
 
 /* -- Headers -- */
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* -- Type Definitions -- */
@@ -41,6 +42,8 @@ typedef hash (*hash_callback)(const hash_key);
 
 /* -- Methods -- */
 
+ADT_API hash hash_bytes(const void *data, size_t size);
+
 ADT_API hash hash_callback_str(const hash_key key);
 
 ADT_API hash hash_callback_ptr(const hash_key key);
@@ -0,0 +1,102 @@
+/*
+ *	Abstract Data Type Library by Parra Studios
+ *	A abstract data type library providing generic containers.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#ifndef ADT_INTERN_H
+#define ADT_INTERN_H 1
+
+/* -- Headers -- */
+
+#include <adt/adt_api.h>
+
+#include <adt/adt_hash.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -- Methods -- */
+
+/**
+*  @brief
+*    Initialize the pool of interned strings, if it is not initialized
+*    the first interned string initializes it
+*
+*  @return
+*    Zero if success, different from zero otherwise
+*/
+ADT_API int intern_initialize(void);
+
+/**
+*  @brief
+*    Get the canonical copy of the string @str, the copy is created the first
+*    time and it lives until the pool is destroyed, it is meant for symbol names
+*    (functions, classes, arguments) which are registered once and looked up often
+*
+*  @param[in] str
+*    String to be interned
+*
+*  @return
+*    Pointer to the interned string (which may be @str itself if it was already
+*    interned) or null if there was an allocation error
+*/
+ADT_API const char *intern_str(const char *str);
+
+/**
+*  @brief
+*    Retrieve the hash precomputed when @str was interned, it is the same
+*    value returned by hash_callback_str, which uses it to avoid hashing
+*    interned strings again
+*
+*  @param[in] str
+*    String to be checked
+*
+*  @param[out] h
+*    Hash of the string if it is interned
+*
+*  @return
+*    Zero if @str is an interned string, different from zero otherwise
+*/
+ADT_API int intern_hash(const char *str, hash *h);
+
+/**
+*  @brief
+*    Lock the pool of interned strings before forking, so the child
+*    does not inherit it in the middle of an insertion
+*/
+ADT_API void intern_fork_prepare(void);
+
+/**
+*  @brief
+*    Unlock the pool of interned strings after forking, it must be
+*    called in both the parent and the child
+*/
+ADT_API void intern_fork_release(void);
+
+/**
+*  @brief
+*    Release all the interned strings, they must not be referenced anymore
+*/
+ADT_API void intern_destroy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADT_INTERN_H */
@@ -26,240 +26,364 @@
 
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define BUCKET_GROUP_SSE2 1
+#endif
+
 /* -- Definitions -- */
 
-#define BUCKET_PAIRS_DEFAULT ((size_t)0x04)
+#define BUCKET_CONTROL_EMPTY	((uint8_t)0x80)
+#define BUCKET_CONTROL_DELETED	((uint8_t)0xFE)
+#define BUCKET_CONTROL_HASH(h)	((uint8_t)((h)&0x7F))
+#define BUCKET_CONTROL_FULL(c)	(((c)&0x80) == 0)
+
+#if defined(BUCKET_GROUP_SSE2)
+	/* One bit per slot of the group in the mask */
+	#define BUCKET_GROUP_SIZE  ((size_t)16)
+	#define BUCKET_GROUP_SHIFT 0
+#else
+	/* One bit per byte (the most significant one) of the group in the mask */
+	#define BUCKET_GROUP_SIZE  ((size_t)8)
+	#define BUCKET_GROUP_SHIFT 3
+	#define BUCKET_GROUP_LSB   ((uint64_t)0x0101010101010101ULL)
+	#define BUCKET_GROUP_MSB   ((uint64_t)0x8080808080808080ULL)
+#endif
 
-/* -- Methods -- */
+/* The table is grown when it is 7/8 full (including tombstones) */
+#define BUCKET_LOAD_MAX(capacity) ((capacity) - ((capacity) >> 3))
+
+/* -- Type Definitions -- */
 
-size_t bucket_capacity(size_t prime)
+typedef uint64_t bucket_mask;
+
+/* -- Private Methods -- */
+
+static size_t bucket_hash_mix(hash h)
 {
-	static const size_t capacity_primes[] = {
-		5UL,
-		11UL,
-		23UL,
-		47UL,
-		97UL,
-		199UL,
-		409UL,
-		823UL,
-		1741UL,
-		3469UL,
-		6949UL,
-		14033UL,
-		28411UL,
-		57557UL,
-		116731UL,
-		236897UL,
-		480881UL,
-		976369UL,
-		1982627UL,
-		4026031UL,
-		8175383UL,
-		16601593UL,
-		33712729UL,
-		68460391UL,
-		139022417UL,
-		282312799UL,
-		573292817UL,
-		1164186217UL,
-		2364114217UL,
-		4294967291UL,
-
-#if (SIZE_MAX > 0xFFFFFFFF)
-		(size_t)8589934583ULL,
-		(size_t)17179869143ULL,
-		(size_t)34359738337ULL,
-		(size_t)68719476731ULL,
-		(size_t)137438953447ULL,
-		(size_t)274877906899ULL,
-		(size_t)549755813881ULL,
-		(size_t)1099511627689ULL,
-		(size_t)2199023255531ULL,
-		(size_t)4398046511093ULL,
-		(size_t)8796093022151ULL,
-		(size_t)17592186044399ULL,
-		(size_t)35184372088777ULL,
-		(size_t)70368744177643ULL,
-		(size_t)140737488355213ULL,
-		(size_t)281474976710597ULL,
-		(size_t)562949953421231ULL,
-		(size_t)1125899906842597ULL,
-		(size_t)2251799813685119ULL,
-		(size_t)4503599627370449ULL,
-		(size_t)9007199254740881ULL,
-		(size_t)18014398509481951ULL,
-		(size_t)36028797018963913ULL,
-		(size_t)72057594037927931ULL,
-		(size_t)144115188075855859ULL,
-		(size_t)288230376151711717ULL,
-		(size_t)576460752303423433ULL,
-		(size_t)1152921504606846883ULL,
-		(size_t)2305843009213693951ULL,
-		(size_t)4611686018427387847ULL,
-		(size_t)9223372036854775783ULL,
-		(size_t)18446744073709551557ULL
-#endif
-	};
+	/* The control byte is taken from the lower bits and the group from the
+	* upper ones, spread the entropy of weak hashes (like djb2 for short strings) */
+	uint64_t x = (uint64_t)h;
+
+	x ^= x >> 33;
+	x *= (uint64_t)0xFF51AFD7ED558CCDULL;
+	x ^= x >> 33;
+	x *= (uint64_t)0xC4CEB9FE1A85EC53ULL;
+	x ^= x >> 33;
+
+	return (size_t)x;
+}
 
-	static const size_t capacity_primes_size = sizeof(capacity_primes) / sizeof(capacity_primes[0]);
+static size_t bucket_mask_first(bucket_mask mask)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return (size_t)__builtin_ctzll((unsigned long long)mask) >> BUCKET_GROUP_SHIFT;
+#else
+	size_t index = 0;
 
-	if (prime < capacity_primes_size)
+	while ((mask & 0x01) == 0)
 	{
-		return capacity_primes[prime];
+		mask >>= 1;
+		++index;
 	}
 
-	return 0;
+	return index >> BUCKET_GROUP_SHIFT;
+#endif
 }
 
-bucket bucket_create(size_t size)
+#if defined(BUCKET_GROUP_SSE2)
+
+static bucket_mask bucket_group_match(const uint8_t *control, uint8_t h2)
 {
-	bucket buckets;
+	__m128i group = _mm_loadu_si128((const __m128i *)control);
 
-	size_t iterator;
+	return (bucket_mask)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+}
 
-	if (size == 0)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket size: %" PRIuS, size);
-		return NULL;
-	}
+static bucket_mask bucket_group_match_empty(const uint8_t *control)
+{
+	return bucket_group_match(control, BUCKET_CONTROL_EMPTY);
+}
 
-	buckets = malloc(sizeof(struct bucket_type) * size);
+static bucket_mask bucket_group_match_free(const uint8_t *control)
+{
+	/* Empty and deleted are the only control bytes with the high bit set */
+	return (bucket_mask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)control));
+}
 
-	if (buckets == NULL)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Bad allocation for bucket");
-		return NULL;
-	}
+#else
+
+static uint64_t bucket_group_load(const uint8_t *control)
+{
+	uint64_t group;
+
+	memcpy(&group, control, sizeof(uint64_t));
+
+	return group;
+}
+
+static bucket_mask bucket_group_match(const uint8_t *control, uint8_t h2)
+{
+	/* It may report false positives, they are discarded when comparing the stored hash */
+	uint64_t x = bucket_group_load(control) ^ (BUCKET_GROUP_LSB * h2);
+
+	return (x - BUCKET_GROUP_LSB) & ~x & BUCKET_GROUP_MSB;
+}
+
+static bucket_mask bucket_group_match_empty(const uint8_t *control)
+{
+	/* Empty has the high bit set and the second lowest bit unset, deleted has both set */
+	uint64_t group = bucket_group_load(control);
+
+	return group & ~(group << 6) & BUCKET_GROUP_MSB;
+}
 
-	for (iterator = 0; iterator < size; ++iterator)
+static bucket_mask bucket_group_match_free(const uint8_t *control)
+{
+	return bucket_group_load(control) & BUCKET_GROUP_MSB;
+}
+
+#endif
+
+static size_t bucket_probe_find(bucket b, comparable_callback compare_cb, hash h, void *key)
+{
+	size_t mix = bucket_hash_mix(h);
+	uint8_t h2 = BUCKET_CONTROL_HASH(mix);
+	size_t groups = b->capacity / BUCKET_GROUP_SIZE;
+	size_t group = (mix >> 7) & (groups - 1);
+	size_t step;
+
+	/* Groups are visited in triangular order, which covers all of them for power of two sizes */
+	for (step = 1; step <= groups; ++step)
 	{
-		buckets[iterator].count = 0;
-		buckets[iterator].capacity = 0;
-		buckets[iterator].pairs = NULL;
+		const size_t offset = group * BUCKET_GROUP_SIZE;
+		const uint8_t *control = &b->control[offset];
+		bucket_mask mask = bucket_group_match(control, h2);
+
+		while (mask != 0)
+		{
+			size_t index = offset + bucket_mask_first(mask);
+			pair p = &b->pairs[index];
+
+			if (BUCKET_CONTROL_FULL(b->control[index]) && p->h == h && compare_cb(key, p->key) == 0)
+			{
+				return index;
+			}
+
+			mask &= mask - 1;
+		}
+
+		if (bucket_group_match_empty(control) != 0)
+		{
+			break;
+		}
+
+		group = (group + step) & (groups - 1);
 	}
 
-	return buckets;
+	return b->capacity;
 }
 
-int bucket_alloc_pairs(bucket b, size_t capacity)
+static size_t bucket_probe_free(uint8_t *control, size_t capacity, hash h)
 {
-	if (b == NULL)
+	size_t mix = bucket_hash_mix(h);
+	size_t groups = capacity / BUCKET_GROUP_SIZE;
+	size_t group = (mix >> 7) & (groups - 1);
+	size_t step;
+
+	for (step = 1; step <= groups; ++step)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket");
-		return 1;
+		const size_t offset = group * BUCKET_GROUP_SIZE;
+		bucket_mask mask = bucket_group_match_free(&control[offset]);
+
+		if (mask != 0)
+		{
+			return offset + bucket_mask_first(mask);
+		}
+
+		group = (group + step) & (groups - 1);
 	}
 
-	if (b->pairs != NULL)
+	return capacity;
+}
+
+static int bucket_rehash(bucket b, size_t capacity)
+{
+	size_t iterator;
+	size_t pairs_size = sizeof(struct pair_type) * capacity;
+	pair pairs = malloc(pairs_size + capacity);
+	uint8_t *control;
+
+	if (pairs == NULL)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Set bucket pairs already allocated");
+		log_write("metacall", LOG_LEVEL_ERROR, "Bad bucket pairs allocation");
 		return 1;
 	}
 
-	b->pairs = malloc(sizeof(struct pair_type) * capacity);
+	/* Slots and control bytes share the same allocation */
+	control = (uint8_t *)pairs + pairs_size;
 
-	if (b->pairs == NULL)
+	memset(control, BUCKET_CONTROL_EMPTY, capacity);
+
+	for (iterator = 0; iterator < b->capacity; ++iterator)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Bad pairs allocation");
-		return 1;
+		if (BUCKET_CONTROL_FULL(b->control[iterator]))
+		{
+			pair p = &b->pairs[iterator];
+			size_t index = bucket_probe_free(control, capacity, p->h);
+
+			control[index] = b->control[iterator];
+			pairs[index] = *p;
+		}
 	}
 
-	b->count = 0;
+	free(b->pairs);
+
+	b->pairs = pairs;
+	b->control = control;
 	b->capacity = capacity;
+	b->deleted = 0;
 
 	return 0;
 }
 
-int bucket_realloc_pairs(bucket b, size_t new_capacity)
+/* -- Methods -- */
+
+bucket bucket_create(void)
 {
-	pair pairs = realloc(b->pairs, sizeof(struct pair_type) * new_capacity);
+	bucket b = malloc(sizeof(struct bucket_type));
 
-	if (pairs == NULL)
+	if (b == NULL)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Bad pairs reallocation");
-		return 1;
+		log_write("metacall", LOG_LEVEL_ERROR, "Bad bucket allocation");
+		return NULL;
 	}
 
-	b->pairs = pairs;
-	b->capacity = new_capacity;
+	b->count = 0;
+	b->deleted = 0;
+	b->capacity = 0;
+	b->control = NULL;
+	b->pairs = NULL;
 
-	return 0;
+	return b;
 }
 
-pair bucket_get_pair(bucket b, comparable_callback compare_cb, void *key)
+pair bucket_get_pair(bucket b, comparable_callback compare_cb, hash h, void *key)
 {
-	size_t iterator;
+	size_t index;
 
-	if (b->pairs == NULL || b->count == 0)
+	if (b == NULL || b->count == 0)
 	{
 		return NULL;
 	}
 
-	for (iterator = 0; iterator < b->count; ++iterator)
-	{
-		pair p = &b->pairs[iterator];
+	index = bucket_probe_find(b, compare_cb, h, key);
 
-		if (compare_cb(key, p->key) == 0)
-		{
-			return p;
-		}
+	if (index == b->capacity)
+	{
+		return NULL;
 	}
 
-	return NULL;
+	return &b->pairs[index];
 }
 
-vector bucket_get_pairs_value(bucket b, comparable_callback compare_cb, void *key)
+vector bucket_get_pairs_value(bucket b, comparable_callback compare_cb, hash h, void *key)
 {
-	size_t iterator;
-	vector v;
+	size_t mix, groups, group, step;
+	uint8_t h2;
+	vector v = NULL;
 
-	if (b->pairs == NULL)
+	if (b == NULL || b->count == 0)
 	{
 		return NULL;
 	}
 
-	v = vector_create(sizeof(void *));
+	mix = bucket_hash_mix(h);
+	h2 = BUCKET_CONTROL_HASH(mix);
+	groups = b->capacity / BUCKET_GROUP_SIZE;
+	group = (mix >> 7) & (groups - 1);
 
-	for (iterator = 0; iterator < b->count; ++iterator)
+	/* Same probe sequence as bucket_probe_find but collecting all the duplicated keys */
+	for (step = 1; step <= groups; ++step)
 	{
-		pair p = &b->pairs[iterator];
+		const size_t offset = group * BUCKET_GROUP_SIZE;
+		const uint8_t *control = &b->control[offset];
+		bucket_mask mask = bucket_group_match(control, h2);
+
+		while (mask != 0)
+		{
+			size_t index = offset + bucket_mask_first(mask);
+			pair p = &b->pairs[index];
+
+			if (BUCKET_CONTROL_FULL(b->control[index]) && p->h == h && compare_cb(key, p->key) == 0)
+			{
+				if (v == NULL)
+				{
+					v = vector_create(sizeof(void *));
 
-		if (compare_cb(key, p->key) == 0)
+					if (v == NULL)
+					{
+						log_write("metacall", LOG_LEVEL_ERROR, "Bad bucket pairs value allocation");
+						return NULL;
+					}
+				}
+
+				vector_push_back(v, &p->value);
+			}
+
+			mask &= mask - 1;
+		}
+
+		if (bucket_group_match_empty(control) != 0)
 		{
-			vector_push_back(v, &p->value);
+			break;
 		}
+
+		group = (group + step) & (groups - 1);
 	}
 
 	return v;
 }
 
-int bucket_insert(bucket b, void *key, void *value)
+int bucket_insert(bucket b, hash h, void *key, void *value)
 {
+	size_t index;
 	pair p;
 
-	if (b == NULL || key == NULL || value == NULL)
+	if (b == NULL || key == NULL)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket insert parameters");
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket insertion parameters");
 		return 1;
 	}
 
-	if (b->pairs == NULL && bucket_alloc_pairs(b, BUCKET_PAIRS_DEFAULT) != 0)
+	if (b->count + b->deleted + 1 > BUCKET_LOAD_MAX(b->capacity))
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket insertion pairs allocation");
-		return 1;
-	}
+		size_t capacity = b->capacity == 0 ? BUCKET_GROUP_SIZE : b->capacity;
 
-	if ((b->count + 1) >= b->capacity)
-	{
-		if (bucket_realloc_pairs(b, b->capacity << 1) != 0)
+		/* Purge the tombstones in place if they are what fills the table, otherwise grow it */
+		if (b->count + 1 > BUCKET_LOAD_MAX(capacity) / 2)
+		{
+			capacity <<= 1;
+		}
+
+		if (bucket_rehash(b, capacity) != 0)
 		{
-			log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket insertion pairs reallocation");
 			return 1;
 		}
 	}
 
-	p = &b->pairs[b->count];
+	index = bucket_probe_free(b->control, b->capacity, h);
+
+	if (b->control[index] == BUCKET_CONTROL_DELETED)
+	{
+		--b->deleted;
+	}
+
+	b->control[index] = BUCKET_CONTROL_HASH(bucket_hash_mix(h));
+
+	p = &b->pairs[index];
 
+	p->h = h;
 	p->key = key;
 	p->value = value;
 
@@ -268,9 +392,9 @@ int bucket_insert(bucket b, void *key, void *value)
 	return 0;
 }
 
-int bucket_remove(bucket b, comparable_callback compare_cb, void *key, void **value)
+int bucket_remove(bucket b, comparable_callback compare_cb, hash h, void *key, void **value)
 {
-	size_t iterator;
+	size_t index, offset;
 
 	if (b == NULL || compare_cb == NULL || key == NULL)
 	{
@@ -278,45 +402,87 @@ int bucket_remove(bucket b, comparable_callback compare_cb, void *key, void **va
 		return 1;
 	}
 
-	if (b->pairs == NULL || b->count == 0)
+	if (b->count == 0)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket remove pairs");
 		return 1;
 	}
 
-	for (iterator = 0; iterator < b->count; ++iterator)
-	{
-		pair p = &b->pairs[iterator];
+	index = bucket_probe_find(b, compare_cb, h, key);
 
-		if (compare_cb(key, p->key) == 0)
-		{
-			void *deleted_value = p->value;
+	if (index == b->capacity)
+	{
+		return 1;
+	}
 
-			size_t next = iterator + 1;
+	if (value != NULL)
+	{
+		*value = b->pairs[index].value;
+	}
 
-			size_t new_capacity = b->capacity >> 1;
+	/* Probes never go beyond a group with an empty slot, so
+	* the slot can be reused directly instead of leaving a tombstone */
+	offset = index - (index % BUCKET_GROUP_SIZE);
 
-			memmove(p, &b->pairs[next], sizeof(struct pair_type) * (b->count - next));
+	if (bucket_group_match_empty(&b->control[offset]) != 0)
+	{
+		b->control[index] = BUCKET_CONTROL_EMPTY;
+	}
+	else
+	{
+		b->control[index] = BUCKET_CONTROL_DELETED;
+		++b->deleted;
+	}
 
-			--b->count;
+	--b->count;
 
-			if (b->count <= new_capacity && new_capacity > BUCKET_PAIRS_DEFAULT)
-			{
-				if (bucket_realloc_pairs(b, new_capacity) != 0)
-				{
-					log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket remove pairs reallocation");
-					return 1;
-				}
-			}
+	if (b->count == 0)
+	{
+		bucket_clear(b);
+	}
+	else if (b->capacity > BUCKET_GROUP_SIZE && b->count < (b->capacity >> 3))
+	{
+		if (bucket_rehash(b, b->capacity >> 1) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid bucket remove reallocation");
+			return 1;
+		}
+	}
 
-			if (value != NULL)
-			{
-				*value = deleted_value;
-			}
+	return 0;
+}
 
-			return 0;
+size_t bucket_next(bucket b, size_t index)
+{
+	for (; index < b->capacity; ++index)
+	{
+		if (BUCKET_CONTROL_FULL(b->control[index]))
+		{
+			return index;
 		}
 	}
 
-	return 1;
+	return b->capacity;
+}
+
+void bucket_clear(bucket b)
+{
+	if (b != NULL)
+	{
+		free(b->pairs);
+
+		b->count = 0;
+		b->deleted = 0;
+		b->capacity = 0;
+		b->control = NULL;
+		b->pairs = NULL;
+	}
+}
+
+void bucket_destroy(bucket b)
+{
+	if (b != NULL)
+	{
+		free(b->pairs);
+		free(b);
+	}
 }
@@ -27,6 +27,12 @@ int comparable_callback_str(const comparable a, const comparable b)
 	const char *str_a = a;
 	const char *str_b = b;
 
+	/* Interned strings are compared by address most of the time */
+	if (str_a == str_b)
+	{
+		return 0;
+	}
+
 	return strcmp(str_a, str_b);
 }
 
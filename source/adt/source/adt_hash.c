@@ -19,22 +19,154 @@
  */
 
 #include <adt/adt_hash.h>
+#include <adt/adt_intern.h>
 
 #include <string.h>
 
+#if defined(_MSC_VER) && defined(_M_X64)
+	#include <intrin.h>
+	#pragma intrinsic(_umul128)
+#endif
+
+/* -- Private Methods -- */
+
+/* Based on wyhash final version 4 (public domain) https://github.com/wangyi-fudan/wyhash */
+static const uint64_t hash_secret[] = {
+	UINT64_C(0x2D358DCCAA6C78A5),
+	UINT64_C(0x8BB84B93962EACC9),
+	UINT64_C(0x4B33A62ED433D4A3),
+	UINT64_C(0x4D5A2DA51DE1AA47)
+};
+
+static void hash_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+	__extension__ typedef unsigned __int128 hash_uint128;
+
+	hash_uint128 r = (hash_uint128)*a * *b;
+
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	*a = _umul128(*a, *b, b);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+	uint64_t c = t < rl, lo = t + (rm1 << 32);
+
+	c += lo < t;
+
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+	hash_mum(&a, &b);
+
+	return a ^ b;
+}
+
+static uint64_t hash_read8(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(uint64_t));
+
+	return v;
+}
+
+static uint64_t hash_read4(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(uint32_t));
+
+	return v;
+}
+
+static uint64_t hash_read3(const uint8_t *p, size_t k)
+{
+	return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+/* -- Methods -- */
+
+hash hash_bytes(const void *data, size_t size)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	uint64_t seed = hash_mix(hash_secret[0], hash_secret[1]);
+	uint64_t a, b;
+
+	if (size <= 16)
+	{
+		if (size >= 4)
+		{
+			a = (hash_read4(p) << 32) | hash_read4(p + ((size >> 3) << 2));
+			b = (hash_read4(p + size - 4) << 32) | hash_read4(p + size - 4 - ((size >> 3) << 2));
+		}
+		else if (size > 0)
+		{
+			a = hash_read3(p, size);
+			b = 0;
+		}
+		else
+		{
+			a = b = 0;
+		}
+	}
+	else
+	{
+		size_t i = size;
+
+		if (i > 48)
+		{
+			uint64_t see1 = seed, see2 = seed;
+
+			do
+			{
+				seed = hash_mix(hash_read8(p) ^ hash_secret[1], hash_read8(p + 8) ^ seed);
+				see1 = hash_mix(hash_read8(p + 16) ^ hash_secret[2], hash_read8(p + 24) ^ see1);
+				see2 = hash_mix(hash_read8(p + 32) ^ hash_secret[3], hash_read8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+
+			seed ^= see1 ^ see2;
+		}
+
+		while (i > 16)
+		{
+			seed = hash_mix(hash_read8(p) ^ hash_secret[1], hash_read8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+
+		a = hash_read8(p + i - 16);
+		b = hash_read8(p + i - 8);
+	}
+
+	a ^= hash_secret[1];
+	b ^= seed;
+
+	hash_mum(&a, &b);
+
+	return (hash)hash_mix(a ^ hash_secret[0] ^ (uint64_t)size, b ^ hash_secret[1]);
+}
+
 hash hash_callback_str(const hash_key key)
 {
-	/* djb2 */
 	const char *str = (const char *)key;
+	hash h;
 
-	hash h = 0x1505;
-
-	while (*str++ != '\0')
+	/* Interned strings already carry their hash */
+	if (intern_hash(str, &h) == 0)
 	{
-		h = (hash)(((h << 5) + h) + *str);
+		return h;
 	}
 
-	return h;
+	return hash_bytes(str, strlen(str));
 }
 
 hash hash_callback_ptr(const hash_key key)
@@ -0,0 +1,279 @@
+/*
+ *	Abstract Data Type Library by Parra Studios
+ *	A abstract data type library providing generic containers.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <adt/adt_intern.h>
+#include <adt/adt_set.h>
+
+#include <threading/threading_atomic.h>
+#include <threading/threading_mutex.h>
+
+#include <log/log.h>
+
+#include <string.h>
+
+/* -- Definitions -- */
+
+/* Interned strings are stored in chunks, so checking if a pointer is interned
+* is just a range comparison; each new chunk doubles the size of the previous one */
+#define INTERN_CHUNK_SIZE ((size_t)0x4000)
+#define INTERN_CHUNK_MAX  ((size_t)0x20)
+
+#define INTERN_ALIGN(size) (((size) + sizeof(struct intern_header_type) - 1) & ~(sizeof(struct intern_header_type) - 1))
+
+/* -- Member Data -- */
+
+struct intern_header_type
+{
+	const char *str;
+	hash h;
+};
+
+struct intern_chunk_type
+{
+	uintptr_t begin;
+	uintptr_t end;
+};
+
+/* -- Private Data -- */
+
+static struct intern_chunk_type intern_chunks[INTERN_CHUNK_MAX];
+static atomic_size_t intern_chunk_count;
+static struct threading_mutex_type intern_mutex;
+static int intern_initialized = 1;
+static char *intern_chunk_next = NULL;
+static set intern_table = NULL;
+
+/* -- Private Methods -- */
+
+static int intern_chunk_create(size_t size)
+{
+	size_t count = atomic_load_explicit(&intern_chunk_count, memory_order_relaxed);
+	size_t chunk_size = INTERN_CHUNK_SIZE << count;
+	char *chunk;
+
+	if (count == INTERN_CHUNK_MAX)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Intern string chunks exhausted");
+		return 1;
+	}
+
+	if (chunk_size < size)
+	{
+		chunk_size = size;
+	}
+
+	chunk = malloc(chunk_size);
+
+	if (chunk == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Bad intern string chunk allocation");
+		return 1;
+	}
+
+	intern_chunks[count].begin = (uintptr_t)chunk;
+	intern_chunks[count].end = (uintptr_t)chunk + chunk_size;
+	intern_chunk_next = chunk;
+
+	/* Publish the chunk to the readers once it is filled in */
+	atomic_store_explicit(&intern_chunk_count, count + 1, memory_order_release);
+
+	return 0;
+}
+
+/* -- Methods -- */
+
+int intern_initialize(void)
+{
+	if (intern_initialized == 0)
+	{
+		return 0;
+	}
+
+	if (threading_mutex_initialize(&intern_mutex) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Intern string mutex failed to initialize");
+		return 1;
+	}
+
+	intern_initialized = 0;
+
+	return 0;
+}
+
+const char *intern_str(const char *str)
+{
+	struct intern_header_type header;
+	size_t length, size, count;
+	char *interned;
+
+	if (str == NULL)
+	{
+		return NULL;
+	}
+
+	if (intern_hash(str, &header.h) == 0)
+	{
+		return str;
+	}
+
+	/* Reflection can be used without initializing MetaCall, in that case the first string initializes the pool */
+	if (intern_initialized != 0 && intern_initialize() != 0)
+	{
+		return NULL;
+	}
+
+	threading_mutex_lock(&intern_mutex);
+
+	if (intern_table == NULL)
+	{
+		intern_table = set_create(&hash_callback_str, &comparable_callback_str);
+
+		if (intern_table == NULL)
+		{
+			interned = NULL;
+			goto unlock;
+		}
+	}
+
+	interned = set_get(intern_table, (set_key)str);
+
+	if (interned != NULL)
+	{
+		goto unlock;
+	}
+
+	length = strlen(str);
+	size = INTERN_ALIGN(sizeof(struct intern_header_type) + length + 1);
+	count = atomic_load_explicit(&intern_chunk_count, memory_order_relaxed);
+
+	if (count == 0 || (uintptr_t)intern_chunk_next + size > intern_chunks[count - 1].end)
+	{
+		if (intern_chunk_create(size) != 0)
+		{
+			interned = NULL;
+			goto unlock;
+		}
+	}
+
+	interned = intern_chunk_next + sizeof(struct intern_header_type);
+
+	header.str = interned;
+	header.h = hash_bytes(str, length);
+
+	memcpy(intern_chunk_next, &header, sizeof(struct intern_header_type));
+	memcpy(interned, str, length + 1);
+
+	intern_chunk_next += size;
+
+	if (set_insert(intern_table, (set_key)interned, (set_value)interned) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid intern string insertion: %s", str);
+		interned = NULL;
+	}
+
+unlock:
+	threading_mutex_unlock(&intern_mutex);
+
+	return interned;
+}
+
+int intern_hash(const char *str, hash *h)
+{
+	size_t iterator, count = atomic_load_explicit(&intern_chunk_count, memory_order_acquire);
+	uintptr_t ptr = (uintptr_t)str;
+
+	for (iterator = 0; iterator < count; ++iterator)
+	{
+		const struct intern_chunk_type *chunk = &intern_chunks[iterator];
+
+		if (ptr >= chunk->begin + sizeof(struct intern_header_type) && ptr < chunk->end)
+		{
+			struct intern_header_type header;
+
+			/* Pointers to the middle of an interned string are not interned, detect them by the back reference */
+			memcpy(&header, str - sizeof(struct intern_header_type), sizeof(struct intern_header_type));
+
+			if (header.str != str)
+			{
+				return 1;
+			}
+
+			*h = header.h;
+
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+void intern_fork_prepare(void)
+{
+	/* Do not fork while a string is being interned, the child would inherit the pool half updated */
+	if (intern_initialized == 0)
+	{
+		threading_mutex_lock(&intern_mutex);
+	}
+}
+
+void intern_fork_release(void)
+{
+	if (intern_initialized == 0)
+	{
+		threading_mutex_unlock(&intern_mutex);
+	}
+}
+
+void intern_destroy(void)
+{
+	size_t iterator, count;
+
+	if (intern_initialized != 0)
+	{
+		return;
+	}
+
+	count = atomic_load_explicit(&intern_chunk_count, memory_order_relaxed);
+
+	/* Unpublish the chunks before releasing them, so the strings are not considered interned anymore */
+	atomic_store_explicit(&intern_chunk_count, 0, memory_order_release);
+
+	for (iterator = 0; iterator < count; ++iterator)
+	{
+		free((void *)intern_chunks[iterator].begin);
+
+		intern_chunks[iterator].begin = 0;
+		intern_chunks[iterator].end = 0;
+	}
+
+	intern_chunk_next = NULL;
+
+	if (intern_table != NULL)
+	{
+		set_destroy(intern_table);
+		intern_table = NULL;
+	}
+
+	threading_mutex_destroy(&intern_mutex);
+
+	intern_initialized = 1;
+}
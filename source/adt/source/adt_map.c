@@ -25,19 +25,11 @@
 
 #include <log/log.h>
 
-/* -- Definitions -- */
-
-#define MAP_BUCKET_RATIO_MIN 0.1f
-#define MAP_BUCKET_RATIO_MAX 0.77f
-
 /* -- Member Data -- */
 
 struct map_type
 {
-	size_t count;
-	size_t capacity;
-	size_t prime;
-	bucket buckets;
+	bucket table;
 	map_cb_hash hash_cb;
 	map_cb_compare compare_cb;
 };
@@ -45,8 +37,7 @@ struct map_type
 struct map_iterator_type
 {
 	map m;
-	size_t current_bucket;
-	size_t current_pair;
+	size_t current;
 };
 
 struct map_contains_any_cb_iterator_type
@@ -79,12 +70,9 @@ map map_create(map_cb_hash hash_cb, map_cb_compare compare_cb)
 
 	m->hash_cb = hash_cb;
 	m->compare_cb = compare_cb;
-	m->count = 0;
-	m->prime = 0;
-	m->capacity = bucket_capacity(m->prime);
-	m->buckets = bucket_create(m->capacity);
+	m->table = bucket_create();
 
-	if (m->buckets == NULL)
+	if (m->table == NULL)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Bad map bucket creation");
 		free(m);
@@ -98,119 +86,28 @@ size_t map_size(map m)
 {
 	if (m != NULL)
 	{
-		return m->count;
+		return m->table->count;
 	}
 
 	return 0;
 }
 
-static int map_bucket_realloc_iterator(map m, map_key key, map_value value, map_cb_iterate_args args)
-{
-	map new_map = (map)args;
-
-	if (new_map != m && key != NULL && args != NULL)
-	{
-		map_hash h = new_map->hash_cb(key);
-
-		size_t index = h % new_map->capacity;
-
-		bucket b = &new_map->buckets[index];
-
-		if (bucket_insert(b, key, value) != 0)
-		{
-			log_write("metacall", LOG_LEVEL_ERROR, "Invalid map bucket realloc insertion");
-			return 1;
-		}
-
-		++new_map->count;
-
-		return 0;
-	}
-
-	return 1;
-}
-
-static int map_bucket_realloc(map m)
-{
-	struct map_type new_map;
-	size_t prime = m->prime;
-	float ratio = (float)((float)m->count / (float)m->capacity);
-
-	if (prime > 0 && ratio <= MAP_BUCKET_RATIO_MIN)
-	{
-		--prime;
-	}
-	else if (ratio >= MAP_BUCKET_RATIO_MAX)
-	{
-		++prime;
-	}
-	else
-	{
-		return 0;
-	}
-
-	new_map.hash_cb = m->hash_cb;
-	new_map.compare_cb = m->compare_cb;
-	new_map.count = 0;
-	new_map.prime = prime;
-	new_map.capacity = bucket_capacity(prime);
-	new_map.buckets = bucket_create(new_map.capacity);
-
-	if (new_map.buckets != NULL)
-	{
-		size_t iterator;
-
-		map_iterate(m, &map_bucket_realloc_iterator, &new_map);
-
-		for (iterator = 0; iterator < m->capacity; ++iterator)
-		{
-			bucket b = &m->buckets[iterator];
-
-			if (b->pairs != NULL)
-			{
-				free(b->pairs);
-			}
-		}
-
-		free(m->buckets);
-
-		m->capacity = new_map.capacity;
-		m->prime = new_map.prime;
-		m->buckets = new_map.buckets;
-
-		return 0;
-	}
-
-	return 1;
-}
-
 int map_insert(map m, map_key key, map_value value)
 {
-	map_hash h;
-	size_t index;
-	bucket b;
-
 	if (m == NULL || key == NULL || value == NULL)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Invalid map insertion parameters");
 		return 1;
 	}
 
-	h = m->hash_cb(key);
-
-	index = h % m->capacity;
-
-	b = &m->buckets[index];
-
-	if (bucket_insert(b, key, value) != 0)
+	/* Duplicated keys are allowed, so there is no need to look for the key first */
+	if (bucket_insert(m->table, m->hash_cb(key), key, value) != 0)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Invalid map bucket insertion");
 		return 1;
 	}
 
-	++m->count;
-
-	return map_bucket_realloc(m);
+	return 0;
 }
 
 int map_insert_array(map m, map_key keys[], map_value values[], size_t size)
@@ -219,7 +116,7 @@ int map_insert_array(map m, map_key keys[], map_value values[], size_t size)
 
 	if (m == NULL || keys == NULL || values == NULL)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid map insertion parameters");
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid map array insertion parameters");
 		return 1;
 	}
 
@@ -239,13 +136,7 @@ vector map_get(map m, map_key key)
 {
 	if (m != NULL && key != NULL)
 	{
-		map_hash hash = m->hash_cb(key);
-
-		size_t index = hash % m->capacity;
-
-		bucket b = &m->buckets[index];
-
-		return bucket_get_pairs_value(b, m->compare_cb, key);
+		return bucket_get_pairs_value(m->table, m->compare_cb, m->hash_cb(key), key);
 	}
 
 	return NULL;
@@ -255,13 +146,7 @@ int map_contains(map m, map_key key)
 {
 	if (m != NULL && key != NULL)
 	{
-		map_hash hash = m->hash_cb(key);
-
-		size_t index = hash % m->capacity;
-
-		bucket b = &m->buckets[index];
-
-		pair p = bucket_get_pair(b, m->compare_cb, key);
+		pair p = bucket_get_pair(m->table, m->compare_cb, m->hash_cb(key), key);
 
 		if (p != NULL)
 		{
@@ -299,9 +184,6 @@ int map_contains_any(map dest, map src)
 
 map_value map_remove(map m, map_key key)
 {
-	map_hash h;
-	size_t index;
-	bucket b;
 	map_value value = NULL;
 
 	if (m == NULL || key == NULL)
@@ -310,34 +192,19 @@ map_value map_remove(map m, map_key key)
 		return NULL;
 	}
 
-	h = m->hash_cb(key);
-
-	index = h % m->capacity;
-
-	b = &m->buckets[index];
-
-	if (bucket_remove(b, m->compare_cb, key, &value) != 0)
+	if (bucket_remove(m->table, m->compare_cb, m->hash_cb(key), key, &value) != 0)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Invalid map bucket remove: %p", key);
 		return NULL;
 	}
 
-	--m->count;
-
-	if (map_bucket_realloc(m) != 0)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid map bucket remove reallocation");
-		return NULL;
-	}
-
 	return value;
 }
 
 vector map_remove_all(map m, map_key key)
 {
 	map_hash h;
-	size_t index, iterator, size;
-	bucket b;
+	size_t iterator, size;
 	vector v = NULL;
 
 	if (m == NULL || key == NULL)
@@ -348,11 +215,7 @@ vector map_remove_all(map m, map_key key)
 
 	h = m->hash_cb(key);
 
-	index = h % m->capacity;
-
-	b = &m->buckets[index];
-
-	v = map_get(m, key);
+	v = bucket_get_pairs_value(m->table, m->compare_cb, h, key);
 
 	size = vector_size(v);
 
@@ -365,21 +228,12 @@ vector map_remove_all(map m, map_key key)
 
 	for (iterator = 0; iterator < size; ++iterator)
 	{
-		if (bucket_remove(b, m->compare_cb, key, NULL) != 0)
+		if (bucket_remove(m->table, m->compare_cb, h, key, NULL) != 0)
 		{
 			log_write("metacall", LOG_LEVEL_ERROR, "Invalid map bucket remove: %p", key);
 			vector_destroy(v);
 			return NULL;
 		}
-
-		--m->count;
-	}
-
-	if (map_bucket_realloc(m) != 0)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid map bucket remove reallocation");
-		vector_destroy(v);
-		return NULL;
 	}
 
 	return v;
@@ -387,27 +241,18 @@ vector map_remove_all(map m, map_key key)
 
 void map_iterate(map m, map_cb_iterate iterate_cb, map_cb_iterate_args args)
 {
-	if (m != NULL && m->buckets != NULL && iterate_cb != NULL)
+	if (m != NULL && iterate_cb != NULL)
 	{
-		size_t bucket_iterator;
+		bucket b = m->table;
+		size_t iterator;
 
-		for (bucket_iterator = 0; bucket_iterator < m->capacity; ++bucket_iterator)
+		for (iterator = bucket_next(b, 0); iterator < b->capacity; iterator = bucket_next(b, iterator + 1))
 		{
-			bucket b = &m->buckets[bucket_iterator];
+			pair p = &b->pairs[iterator];
 
-			if (b->pairs != NULL && b->count > 0)
+			if (iterate_cb(m, p->key, p->value, args) != 0)
 			{
-				size_t pair_iterator;
-
-				for (pair_iterator = 0; pair_iterator < b->count; ++pair_iterator)
-				{
-					pair p = &b->pairs[pair_iterator];
-
-					if (iterate_cb(m, p->key, p->value, args) != 0)
-					{
-						return;
-					}
-				}
+				return;
 			}
 		}
 	}
@@ -438,33 +283,7 @@ int map_clear(map m)
 		return 1;
 	}
 
-	if (m->buckets != NULL)
-	{
-		size_t iterator;
-
-		for (iterator = 0; iterator < m->capacity; ++iterator)
-		{
-			bucket b = &m->buckets[iterator];
-
-			if (b->pairs != NULL)
-			{
-				free(b->pairs);
-			}
-		}
-
-		free(m->buckets);
-	}
-
-	m->count = 0;
-	m->prime = 0;
-	m->capacity = bucket_capacity(m->prime);
-	m->buckets = bucket_create(m->capacity);
-
-	if (m->buckets == NULL)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Bad map clear bucket creation");
-		return 1;
-	}
+	bucket_clear(m->table);
 
 	return 0;
 }
@@ -476,39 +295,21 @@ void map_destroy(map m)
 		return;
 	}
 
-	if (m->buckets != NULL)
-	{
-		size_t iterator;
-
-		for (iterator = 0; iterator < m->capacity; ++iterator)
-		{
-			bucket b = &m->buckets[iterator];
-
-			if (b->pairs != NULL)
-			{
-				free(b->pairs);
-			}
-		}
-
-		free(m->buckets);
-	}
+	bucket_destroy(m->table);
 
 	free(m);
 }
 
 map_iterator map_iterator_begin(map m)
 {
-	if (m != NULL && m->buckets != NULL && map_size(m) > 0)
+	if (m != NULL && map_size(m) > 0)
 	{
 		map_iterator it = malloc(sizeof(struct map_iterator_type));
 
 		if (it != NULL)
 		{
 			it->m = m;
-			it->current_bucket = 0;
-			it->current_pair = 0;
-
-			map_iterator_next(it);
+			it->current = bucket_next(m->table, 0);
 
 			return it;
 		}
@@ -519,9 +320,9 @@ map_iterator map_iterator_begin(map m)
 
 map_key map_iterator_get_key(map_iterator it)
 {
-	if (it != NULL && it->current_bucket < it->m->capacity && it->current_pair > 0)
+	if (it != NULL && it->current < it->m->table->capacity)
 	{
-		return it->m->buckets[it->current_bucket].pairs[it->current_pair - 1].key;
+		return it->m->table->pairs[it->current].key;
 	}
 
 	return NULL;
@@ -529,9 +330,9 @@ map_key map_iterator_get_key(map_iterator it)
 
 map_value map_iterator_get_value(map_iterator it)
 {
-	if (it != NULL && it->current_bucket < it->m->capacity && it->current_pair > 0)
+	if (it != NULL && it->current < it->m->table->capacity)
 	{
-		return it->m->buckets[it->current_bucket].pairs[it->current_pair - 1].value;
+		return it->m->table->pairs[it->current].value;
 	}
 
 	return NULL;
@@ -539,27 +340,9 @@ map_value map_iterator_get_value(map_iterator it)
 
 void map_iterator_next(map_iterator it)
 {
-	if (it != NULL)
+	if (it != NULL && it->current < it->m->table->capacity)
 	{
-		for (; it->current_bucket < it->m->capacity; ++it->current_bucket)
-		{
-			bucket b = &it->m->buckets[it->current_bucket];
-
-			if (b->pairs != NULL && b->count > 0)
-			{
-				for (; it->current_pair < b->count; ++it->current_pair)
-				{
-					pair p = &b->pairs[it->current_pair];
-
-					if (p != NULL)
-					{
-						++it->current_pair;
-
-						return;
-					}
-				}
-			}
-		}
+		it->current = bucket_next(it->m->table, it->current + 1);
 	}
 }
 
@@ -567,7 +350,7 @@ int map_iterator_end(map_iterator *it)
 {
 	if (it != NULL && *it != NULL)
 	{
-		if ((*it)->current_bucket >= (*it)->m->capacity)
+		if ((*it)->current >= (*it)->m->table->capacity)
 		{
 			free(*it);
 
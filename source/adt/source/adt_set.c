@@ -25,19 +25,11 @@
 
 #include <log/log.h>
 
-/* -- Definitions -- */
-
-#define SET_BUCKET_RATIO_MIN 0.1f
-#define SET_BUCKET_RATIO_MAX 0.77f
-
 /* -- Member Data -- */
 
 struct set_type
 {
-	size_t count;
-	size_t capacity;
-	size_t prime;
-	bucket buckets;
+	bucket table;
 	set_cb_hash hash_cb;
 	set_cb_compare compare_cb;
 };
@@ -45,8 +37,7 @@ struct set_type
 struct set_iterator_type
 {
 	set s;
-	size_t current_bucket;
-	size_t current_pair;
+	size_t current;
 };
 
 struct set_contains_any_cb_iterator_type
@@ -87,12 +78,9 @@ set set_create(set_cb_hash hash_cb, set_cb_compare compare_cb)
 
 	s->hash_cb = hash_cb;
 	s->compare_cb = compare_cb;
-	s->count = 0;
-	s->prime = 0;
-	s->capacity = bucket_capacity(s->prime);
-	s->buckets = bucket_create(s->capacity);
+	s->table = bucket_create();
 
-	if (s->buckets == NULL)
+	if (s->table == NULL)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Bad set bucket creation");
 		free(s);
@@ -106,97 +94,15 @@ size_t set_size(set s)
 {
 	if (s != NULL)
 	{
-		return s->count;
+		return s->table->count;
 	}
 
 	return 0;
 }
 
-static int set_bucket_realloc_iterator(set s, set_key key, set_value value, set_cb_iterate_args args)
-{
-	set new_set = (set)args;
-
-	if (new_set != s && key != NULL && args != NULL)
-	{
-		set_hash h = new_set->hash_cb(key);
-
-		size_t index = h % new_set->capacity;
-
-		bucket b = &new_set->buckets[index];
-
-		if (bucket_insert(b, key, value) != 0)
-		{
-			log_write("metacall", LOG_LEVEL_ERROR, "Invalid set bucket realloc insertion");
-			return 1;
-		}
-
-		++new_set->count;
-
-		return 0;
-	}
-
-	return 1;
-}
-
-static int set_bucket_realloc(set s)
-{
-	struct set_type new_set;
-	size_t prime = s->prime;
-	float ratio = (float)((float)s->count / (float)s->capacity);
-
-	if (prime > 0 && ratio <= SET_BUCKET_RATIO_MIN)
-	{
-		--prime;
-	}
-	else if (ratio >= SET_BUCKET_RATIO_MAX)
-	{
-		++prime;
-	}
-	else
-	{
-		return 0;
-	}
-
-	new_set.hash_cb = s->hash_cb;
-	new_set.compare_cb = s->compare_cb;
-	new_set.count = 0;
-	new_set.prime = prime;
-	new_set.capacity = bucket_capacity(prime);
-	new_set.buckets = bucket_create(new_set.capacity);
-
-	if (new_set.buckets != NULL)
-	{
-		size_t iterator;
-
-		set_iterate(s, &set_bucket_realloc_iterator, &new_set);
-
-		for (iterator = 0; iterator < s->capacity; ++iterator)
-		{
-			bucket b = &s->buckets[iterator];
-
-			if (b->pairs != NULL)
-			{
-				free(b->pairs);
-			}
-		}
-
-		free(s->buckets);
-
-		s->capacity = new_set.capacity;
-		s->prime = new_set.prime;
-		s->buckets = new_set.buckets;
-
-		return 0;
-	}
-
-	return 1;
-}
-
 int set_insert(set s, set_key key, set_value value)
 {
 	set_hash h;
-	size_t index;
-	bucket b;
 	pair p;
 
 	if (s == NULL || key == NULL || value == NULL)
@@ -207,11 +113,7 @@ int set_insert(set s, set_key key, set_value value)
 
 	h = s->hash_cb(key);
 
-	index = h % s->capacity;
-
-	b = &s->buckets[index];
-
-	p = bucket_get_pair(b, s->compare_cb, key);
+	p = bucket_get_pair(s->table, s->compare_cb, h, key);
 
 	if (p != NULL)
 	{
@@ -219,15 +121,13 @@ int set_insert(set s, set_key key, set_value value)
 		return 0;
 	}
 
-	if (bucket_insert(b, key, value) != 0)
+	if (bucket_insert(s->table, h, key, value) != 0)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Invalid set bucket insertion");
 		return 1;
 	}
 
-	++s->count;
-
-	return set_bucket_realloc(s);
+	return 0;
 }
 
 int set_insert_array(set s, set_key keys[], set_value values[], size_t size)
@@ -256,13 +156,7 @@ set_value set_get(set s, set_key key)
 {
 	if (s != NULL && key != NULL)
 	{
-		set_hash hash = s->hash_cb(key);
-
-		size_t index = hash % s->capacity;
-
-		bucket b = &s->buckets[index];
-
-		pair p = bucket_get_pair(b, s->compare_cb, key);
+		pair p = bucket_get_pair(s->table, s->compare_cb, s->hash_cb(key), key);
 
 		if (p != NULL)
 		{
@@ -277,13 +171,7 @@ int set_contains(set s, set_key key)
 {
 	if (s != NULL && key != NULL)
 	{
-		set_hash hash = s->hash_cb(key);
-
-		size_t index = hash % s->capacity;
-
-		bucket b = &s->buckets[index];
-
-		pair p = bucket_get_pair(b, s->compare_cb, key);
+		pair p = bucket_get_pair(s->table, s->compare_cb, s->hash_cb(key), key);
 
 		if (p != NULL)
 		{
@@ -355,9 +243,6 @@ int set_contains_which(set dest, set src, set_key *key)
 
 set_value set_remove(set s, set_key key)
 {
-	set_hash h;
-	size_t index;
-	bucket b;
 	set_value value = NULL;
 
 	if (s == NULL || key == NULL)
@@ -366,52 +251,29 @@ set_value set_remove(set s, set_key key)
 		return NULL;
 	}
 
-	h = s->hash_cb(key);
-
-	index = h % s->capacity;
-
-	b = &s->buckets[index];
-
-	if (bucket_remove(b, s->compare_cb, key, &value) != 0)
+	if (bucket_remove(s->table, s->compare_cb, s->hash_cb(key), key, &value) != 0)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Invalid set bucket remove: %p", key);
 		return NULL;
 	}
 
-	--s->count;
-
-	if (set_bucket_realloc(s) != 0)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Invalid set bucket remove reallocation");
-		return NULL;
-	}
-
 	return value;
 }
 
 void set_iterate(set s, set_cb_iterate iterate_cb, set_cb_iterate_args args)
 {
-	if (s != NULL && s->buckets != NULL && iterate_cb != NULL)
+	if (s != NULL && iterate_cb != NULL)
 	{
-		size_t bucket_iterator;
+		bucket b = s->table;
+		size_t iterator;
 
-		for (bucket_iterator = 0; bucket_iterator < s->capacity; ++bucket_iterator)
+		for (iterator = bucket_next(b, 0); iterator < b->capacity; iterator = bucket_next(b, iterator + 1))
 		{
-			bucket b = &s->buckets[bucket_iterator];
+			pair p = &b->pairs[iterator];
 
-			if (b->pairs != NULL && b->count > 0)
+			if (iterate_cb(s, p->key, p->value, args) != 0)
 			{
-				size_t pair_iterator;
-
-				for (pair_iterator = 0; pair_iterator < b->count; ++pair_iterator)
-				{
-					pair p = &b->pairs[pair_iterator];
-
-					if (iterate_cb(s, p->key, p->value, args) != 0)
-					{
-						return;
-					}
-				}
+				return;
 			}
 		}
 	}
@@ -462,33 +324,7 @@ int set_clear(set s)
 		return 1;
 	}
 
-	if (s->buckets != NULL)
-	{
-		size_t iterator;
-
-		for (iterator = 0; iterator < s->capacity; ++iterator)
-		{
-			bucket b = &s->buckets[iterator];
-
-			if (b->pairs != NULL)
-			{
-				free(b->pairs);
-			}
-		}
-
-		free(s->buckets);
-	}
-
-	s->count = 0;
-	s->prime = 0;
-	s->capacity = bucket_capacity(s->prime);
-	s->buckets = bucket_create(s->capacity);
-
-	if (s->buckets == NULL)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "Bad set clear bucket creation");
-		return 1;
-	}
+	bucket_clear(s->table);
 
 	return 0;
 }
@@ -500,39 +336,21 @@ void set_destroy(set s)
 		return;
 	}
 
-	if (s->buckets != NULL)
-	{
-		size_t iterator;
-
-		for (iterator = 0; iterator < s->capacity; ++iterator)
-		{
-			bucket b = &s->buckets[iterator];
-
-			if (b->pairs != NULL)
-			{
-				free(b->pairs);
-			}
-		}
-
-		free(s->buckets);
-	}
+	bucket_destroy(s->table);
 
 	free(s);
 }
 
 set_iterator set_iterator_begin(set s)
 {
-	if (s != NULL && s->buckets != NULL && set_size(s) > 0)
+	if (s != NULL && set_size(s) > 0)
 	{
 		set_iterator it = malloc(sizeof(struct set_iterator_type));
 
 		if (it != NULL)
 		{
 			it->s = s;
-			it->current_bucket = 0;
-			it->current_pair = 0;
-
-			set_iterator_next(it);
+			it->current = bucket_next(s->table, 0);
 
 			return it;
 		}
@@ -543,9 +361,9 @@ set_iterator set_iterator_begin(set s)
 
 set_key set_iterator_get_key(set_iterator it)
 {
-	if (it != NULL && it->current_bucket < it->s->capacity && it->current_pair > 0)
+	if (it != NULL && it->current < it->s->table->capacity)
 	{
-		return it->s->buckets[it->current_bucket].pairs[it->current_pair - 1].key;
+		return it->s->table->pairs[it->current].key;
 	}
 
 	return NULL;
@@ -553,9 +371,9 @@ set_key set_iterator_get_key(set_iterator it)
 
 set_value set_iterator_get_value(set_iterator it)
 {
-	if (it != NULL && it->current_bucket < it->s->capacity && it->current_pair > 0)
+	if (it != NULL && it->current < it->s->table->capacity)
 	{
-		return it->s->buckets[it->current_bucket].pairs[it->current_pair - 1].value;
+		return it->s->table->pairs[it->current].value;
 	}
 
 	return NULL;
@@ -563,27 +381,9 @@ set_value set_iterator_get_value(set_iterator it)
 
 void set_iterator_next(set_iterator it)
 {
-	if (it != NULL)
+	if (it != NULL && it->current < it->s->table->capacity)
 	{
-		for (; it->current_bucket < it->s->capacity; ++it->current_bucket)
-		{
-			bucket b = &it->s->buckets[it->current_bucket];
-
-			if (b->pairs != NULL && b->count > 0)
-			{
-				for (; it->current_pair < b->count; ++it->current_pair)
-				{
-					pair p = &b->pairs[it->current_pair];
-
-					if (p != NULL)
-					{
-						++it->current_pair;
-
-						return;
-					}
-				}
-			}
-		}
+		it->current = bucket_next(it->s->table, it->current + 1);
 	}
 }
 
@@ -591,7 +391,7 @@ int set_iterator_end(set_iterator *it)
 {
 	if (it != NULL && *it != NULL)
 	{
-		if ((*it)->current_bucket >= (*it)->s->capacity)
+		if ((*it)->current >= (*it)->s->table->capacity)
 		{
 			free(*it);
 
@@ -0,0 +1,300 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <adt/adt_intern.h>
+#include <adt/adt_map.h>
+#include <adt/adt_set.h>
+
+#include <log/log.h>
+
+#include <string>
+#include <vector>
+
+static int stream_write(void *, const char *, const size_t)
+{
+	// Disable stream write so we do not count stdout on the benchmark
+	return 0;
+}
+
+static int stream_flush(void *)
+{
+	// Disable stream flush so we do not count stdout on the benchmark
+	return 0;
+}
+
+class adt_bench : public benchmark::Fixture
+{
+public:
+	void SetUp(benchmark::State &state)
+	{
+		if (log_configure("metacall",
+				log_policy_format_text(),
+				log_policy_schedule_sync(),
+				log_policy_storage_sequential(),
+				log_policy_stream_custom(NULL, &stream_write, &stream_flush)) != 0)
+		{
+			state.SkipWithError("Error creating the log");
+			return;
+		}
+
+		const size_t size = (size_t)state.range(0);
+
+		keys.resize(size);
+		missing.resize(size);
+		values.resize(size);
+
+		// Keys are similar to the function and attribute names stored in scopes and classes
+		for (size_t iterator = 0; iterator < size; ++iterator)
+		{
+			keys[iterator] = "function_name_" + std::to_string(iterator);
+			missing[iterator] = "missing_name_" + std::to_string(iterator);
+			values[iterator] = (int)iterator;
+		}
+	}
+
+	void TearDown(benchmark::State &)
+	{
+		keys.clear();
+		missing.clear();
+		values.clear();
+	}
+
+	set set_fill()
+	{
+		set s = set_create(&hash_callback_str, &comparable_callback_str);
+
+		for (size_t iterator = 0; iterator < keys.size(); ++iterator)
+		{
+			set_insert(s, (set_key)keys[iterator].c_str(), &values[iterator]);
+		}
+
+		return s;
+	}
+
+	map map_fill()
+	{
+		map m = map_create(&hash_callback_str, &comparable_callback_str);
+
+		for (size_t iterator = 0; iterator < keys.size(); ++iterator)
+		{
+			map_insert(m, (map_key)keys[iterator].c_str(), &values[iterator]);
+		}
+
+		return m;
+	}
+
+	std::vector<std::string> keys;
+	std::vector<std::string> missing;
+	std::vector<int> values;
+};
+
+BENCHMARK_DEFINE_F(adt_bench, set_insert)
+(benchmark::State &state)
+{
+	for (auto _ : state)
+	{
+		set s = set_fill();
+
+		state.PauseTiming();
+
+		if (set_size(s) != keys.size())
+		{
+			state.SkipWithError("Invalid set size");
+		}
+
+		set_destroy(s);
+
+		state.ResumeTiming();
+	}
+
+	state.SetLabel("ADT Benchmark - Set Insert");
+	state.SetItemsProcessed(state.iterations() * (int64_t)keys.size());
+}
+
+BENCHMARK_REGISTER_F(adt_bench, set_insert)
+	->Unit(benchmark::kMicrosecond)
+	->Arg(64)
+	->Arg(4096)
+	->Arg(65536)
+	->MinTime(0.1)
+	->Repetitions(3);
+
+BENCHMARK_DEFINE_F(adt_bench, set_get)
+(benchmark::State &state)
+{
+	set s = set_fill();
+
+	for (auto _ : state)
+	{
+		for (size_t iterator = 0; iterator < keys.size(); ++iterator)
+		{
+			benchmark::DoNotOptimize(set_get(s, (set_key)keys[iterator].c_str()));
+		}
+	}
+
+	set_destroy(s);
+
+	state.SetLabel("ADT Benchmark - Set Get");
+	state.SetItemsProcessed(state.iterations() * (int64_t)keys.size());
+}
+
+BENCHMARK_REGISTER_F(adt_bench, set_get)
+	->Unit(benchmark::kMicrosecond)
+	->Arg(64)
+	->Arg(4096)
+	->Arg(65536)
+	->MinTime(0.1)
+	->Repetitions(3);
+
+BENCHMARK_DEFINE_F(adt_bench, set_get_interned)
+(benchmark::State &state)
+{
+	std::vector<const char *> interned(keys.size());
+
+	for (size_t iterator = 0; iterator < keys.size(); ++iterator)
+	{
+		interned[iterator] = intern_str(keys[iterator].c_str());
+	}
+
+	set s = set_create(&hash_callback_str, &comparable_callback_str);
+
+	for (size_t iterator = 0; iterator < interned.size(); ++iterator)
+	{
+		set_insert(s, (set_key)interned[iterator], &values[iterator]);
+	}
+
+	for (auto _ : state)
+	{
+		for (size_t iterator = 0; iterator < interned.size(); ++iterator)
+		{
+			benchmark::DoNotOptimize(set_get(s, (set_key)interned[iterator]));
+		}
+	}
+
+	set_destroy(s);
+
+	state.SetLabel("ADT Benchmark - Set Get Interned");
+	state.SetItemsProcessed(state.iterations() * (int64_t)interned.size());
+}
+
+BENCHMARK_REGISTER_F(adt_bench, set_get_interned)
+	->Unit(benchmark::kMicrosecond)
+	->Arg(64)
+	->Arg(4096)
+	->Arg(65536)
+	->MinTime(0.1)
+	->Repetitions(3);
+
+BENCHMARK_DEFINE_F(adt_bench, set_get_missing)
+(benchmark::State &state)
+{
+	set s = set_fill();
+
+	for (auto _ : state)
+	{
+		for (size_t iterator = 0; iterator < missing.size(); ++iterator)
+		{
+			benchmark::DoNotOptimize(set_contains(s, (set_key)missing[iterator].c_str()));
+		}
+	}
+
+	set_destroy(s);
+
+	state.SetLabel("ADT Benchmark - Set Get Missing");
+	state.SetItemsProcessed(state.iterations() * (int64_t)missing.size());
+}
+
+BENCHMARK_REGISTER_F(adt_bench, set_get_missing)
+	->Unit(benchmark::kMicrosecond)
+	->Arg(64)
+	->Arg(4096)
+	->Arg(65536)
+	->MinTime(0.1)
+	->Repetitions(3);
+
+BENCHMARK_DEFINE_F(adt_bench, set_remove)
+(benchmark::State &state)
+{
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+
+		set s = set_fill();
+
+		state.ResumeTiming();
+
+		for (size_t iterator = 0; iterator < keys.size(); ++iterator)
+		{
+			benchmark::DoNotOptimize(set_remove(s, (set_key)keys[iterator].c_str()));
+		}
+
+		state.PauseTiming();
+
+		set_destroy(s);
+
+		state.ResumeTiming();
+	}
+
+	state.SetLabel("ADT Benchmark - Set Remove");
+	state.SetItemsProcessed(state.iterations() * (int64_t)keys.size());
+}
+
+BENCHMARK_REGISTER_F(adt_bench, set_remove)
+	->Unit(benchmark::kMicrosecond)
+	->Arg(64)
+	->Arg(4096)
+	->Arg(65536)
+	->MinTime(0.1)
+	->Repetitions(3);
+
+BENCHMARK_DEFINE_F(adt_bench, map_get)
+(benchmark::State &state)
+{
+	map m = map_fill();
+
+	for (auto _ : state)
+	{
+		for (size_t iterator = 0; iterator < keys.size(); ++iterator)
+		{
+			vector v = map_get(m, (map_key)keys[iterator].c_str());
+
+			benchmark::DoNotOptimize(v);
+
+			vector_destroy(v);
+		}
+	}
+
+	map_destroy(m);
+
+	state.SetLabel("ADT Benchmark - Map Get");
+	state.SetItemsProcessed(state.iterations() * (int64_t)keys.size());
+}
+
+BENCHMARK_REGISTER_F(adt_bench, map_get)
+	->Unit(benchmark::kMicrosecond)
+	->Arg(64)
+	->Arg(4096)
+	->Arg(65536)
+	->MinTime(0.1)
+	->Repetitions(3);
+
+BENCHMARK_MAIN();
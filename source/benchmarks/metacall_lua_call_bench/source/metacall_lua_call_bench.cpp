@@ -0,0 +1,239 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+
+class metacall_lua_call_bench : public benchmark::Fixture
+{
+public:
+};
+
+BENCHMARK_DEFINE_F(metacall_lua_call_bench, call_va_args)
+(benchmark::State &state)
+{
+	const int64_t call_count = 1000000;
+	const int64_t call_size = sizeof(long) * 3; // (long, long) -> long
+
+	for (auto _ : state)
+	{
+/* Lua */
+#if defined(OPTION_BUILD_LOADERS_LUA)
+		{
+			const enum metacall_value_id ids[] = {
+				METACALL_LONG, METACALL_LONG
+			};
+
+			for (int64_t it = 0; it < call_count; ++it)
+			{
+				void *ret = metacallt_s("int_mem_type", ids, 2, 0L, 0L);
+
+				state.PauseTiming();
+
+				if (ret == NULL)
+				{
+					state.SkipWithError("Null return value from int_mem_type");
+				}
+
+				if (metacall_value_cast_long(&ret) != 0L)
+				{
+					state.SkipWithError("Invalid return value from int_mem_type");
+				}
+
+				metacall_value_destroy(ret);
+
+				state.ResumeTiming();
+			}
+		}
+#endif /* OPTION_BUILD_LOADERS_LUA */
+	}
+
+	state.SetLabel("MetaCall Lua Call Benchmark - Variadic Argument Call");
+	state.SetBytesProcessed(call_size * call_count);
+	state.SetItemsProcessed(call_count);
+}
+
+BENCHMARK_REGISTER_F(metacall_lua_call_bench, call_va_args)
+	->Unit(benchmark::kMillisecond)
+	->Iterations(1)
+	->Repetitions(5);
+
+BENCHMARK_DEFINE_F(metacall_lua_call_bench, call_array_args)
+(benchmark::State &state)
+{
+	const int64_t call_count = 1000000;
+	const int64_t call_size = sizeof(long) * 3; // (long, long) -> long
+
+	for (auto _ : state)
+	{
+/* Lua */
+#if defined(OPTION_BUILD_LOADERS_LUA)
+		{
+			state.PauseTiming();
+
+			void *args[2] = {
+				metacall_value_create_long(0L),
+				metacall_value_create_long(0L)
+			};
+
+			state.ResumeTiming();
+
+			for (int64_t it = 0; it < call_count; ++it)
+			{
+				void *ret = metacallv_s("int_mem_type", args, 2);
+
+				state.PauseTiming();
+
+				if (ret == NULL)
+				{
+					state.SkipWithError("Null return value from int_mem_type");
+				}
+
+				if (metacall_value_cast_long(&ret) != 0L)
+				{
+					state.SkipWithError("Invalid return value from int_mem_type");
+				}
+
+				metacall_value_destroy(ret);
+
+				state.ResumeTiming();
+			}
+
+			state.PauseTiming();
+
+			for (auto arg : args)
+			{
+				metacall_value_destroy(arg);
+			}
+
+			state.ResumeTiming();
+		}
+#endif /* OPTION_BUILD_LOADERS_LUA */
+	}
+
+	state.SetLabel("MetaCall Lua Call Benchmark - Array Argument Call");
+	state.SetBytesProcessed(call_size * call_count);
+	state.SetItemsProcessed(call_count);
+}
+
+BENCHMARK_REGISTER_F(metacall_lua_call_bench, call_array_args)
+	->Unit(benchmark::kMillisecond)
+	->Iterations(1)
+	->Repetitions(5);
+
+BENCHMARK_DEFINE_F(metacall_lua_call_bench, call_array_args_threaded)
+(benchmark::State &state)
+{
+	const int64_t call_count = 100000;
+	const int64_t call_size = sizeof(long) * 3; // (long, long) -> long
+
+	for (auto _ : state)
+	{
+/* Lua */
+#if defined(OPTION_BUILD_LOADERS_LUA)
+		{
+			/* Each benchmark thread gets its own lua_State from the loader pool */
+			void *func = metacall_function("int_mem_type");
+
+			void *args[2] = {
+				metacall_value_create_long(0L),
+				metacall_value_create_long(0L)
+			};
+
+			for (int64_t it = 0; it < call_count; ++it)
+			{
+				void *ret = metacallfv_s(func, args, 2);
+
+				if (ret == NULL)
+				{
+					state.SkipWithError("Null return value from int_mem_type");
+					break;
+				}
+
+				metacall_value_destroy(ret);
+			}
+
+			for (auto arg : args)
+			{
+				metacall_value_destroy(arg);
+			}
+		}
+#endif /* OPTION_BUILD_LOADERS_LUA */
+	}
+
+	state.SetLabel("MetaCall Lua Call Benchmark - Array Argument Call (Multiple Threads)");
+	state.SetBytesProcessed(call_size * call_count);
+	state.SetItemsProcessed(call_count);
+}
+
+BENCHMARK_REGISTER_F(metacall_lua_call_bench, call_array_args_threaded)
+	->Unit(benchmark::kMillisecond)
+	->Iterations(1)
+	->Threads(1)
+	->Threads(4)
+	->Repetitions(5);
+
+int main(int argc, char *argv[])
+{
+	metacall_print_info();
+
+	metacall_log_null();
+
+	if (metacall_initialize() != 0)
+	{
+		return 1;
+	}
+
+/* Lua */
+#if defined(OPTION_BUILD_LOADERS_LUA)
+	{
+		static const char tag[] = "lua";
+
+		static const char int_mem_type[] =
+			"function int_mem_type(left, right)\n"
+			"	return 0\n"
+			"end\n";
+
+		if (metacall_load_from_memory(tag, int_mem_type, sizeof(int_mem_type), NULL) != 0)
+		{
+			return 2;
+		}
+	}
+#endif /* OPTION_BUILD_LOADERS_LUA */
+
+	::benchmark::Initialize(&argc, argv);
+
+	if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 3;
+	}
+
+	::benchmark::RunSpecifiedBenchmarks();
+	::benchmark::Shutdown();
+
+	if (metacall_destroy() != 0)
+	{
+		return 4;
+	}
+
+	return 0;
+}
@@ -136,6 +136,69 @@ BENCHMARK_REGISTER_F(metacall_rb_call_bench, call_array_args)
 	->Iterations(1)
 	->Repetitions(5);
 
+BENCHMARK_DEFINE_F(metacall_rb_call_bench, call_duck_array_args)
+(benchmark::State &state)
+{
+	const int64_t call_count = 1000000;
+	const int64_t call_size = sizeof(int) * 3; // (int, int) -> int
+
+	for (auto _ : state)
+	{
+/* Ruby */
+#if defined(OPTION_BUILD_LOADERS_RB)
+		{
+			state.PauseTiming();
+
+			void *args[2] = {
+				metacall_value_create_int(0),
+				metacall_value_create_int(0)
+			};
+
+			state.ResumeTiming();
+
+			for (int64_t it = 0; it < call_count; ++it)
+			{
+				void *ret = metacallv("int_mem_duck_type", args);
+
+				state.PauseTiming();
+
+				if (ret == NULL)
+				{
+					state.SkipWithError("Null return value from int_mem_duck_type");
+				}
+
+				if (metacall_value_to_int(ret) != 0)
+				{
+					state.SkipWithError("Invalid return value from int_mem_duck_type");
+				}
+
+				metacall_value_destroy(ret);
+
+				state.ResumeTiming();
+			}
+
+			state.PauseTiming();
+
+			for (auto arg : args)
+			{
+				metacall_value_destroy(arg);
+			}
+
+			state.ResumeTiming();
+		}
+#endif /* OPTION_BUILD_LOADERS_RB */
+	}
+
+	state.SetLabel("MetaCall Ruby Call Benchmark - Duck Typed Array Argument Call");
+	state.SetBytesProcessed(call_size * call_count);
+	state.SetItemsProcessed(call_count);
+}
+
+BENCHMARK_REGISTER_F(metacall_rb_call_bench, call_duck_array_args)
+	->Unit(benchmark::kMillisecond)
+	->Iterations(1)
+	->Repetitions(5);
+
 /* Use main for initializing MetaCall once. There's a bug in Ruby 3.2 on MacOS which prevents reinitialization */
 /*
 	Stack trace (most recent call last):
@@ -181,10 +244,21 @@ int main(int argc, char *argv[])
 			"\treturn 0\n"
 			"end\n";
 
+		static const char int_mem_duck_type[] =
+			"#!/usr/bin/env ruby\n"
+			"def int_mem_duck_type(left, right)\n"
+			"\treturn 0\n"
+			"end\n";
+
 		if (metacall_load_from_memory(tag, int_mem_type, sizeof(int_mem_type), NULL) != 0)
 		{
 			return 2;
 		}
+
+		if (metacall_load_from_memory(tag, int_mem_duck_type, sizeof(int_mem_duck_type), NULL) != 0)
+		{
+			return 2;
+		}
 	}
 #endif /* OPTION_BUILD_LOADERS_RB */
 
@@ -0,0 +1,286 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <metacall/metacall.h>
+
+#include <cstdlib>
+#include <string>
+
+/* Payloads shared by all the benchmarks, built once in main */
+enum metacall_serial_bench_payload
+{
+	METACALL_SERIAL_BENCH_ARRAY,
+	METACALL_SERIAL_BENCH_MAP,
+	METACALL_SERIAL_BENCH_BUFFER,
+
+	METACALL_SERIAL_BENCH_SIZE
+};
+
+static const char *serial_names[] = { "rapid_json", "msgpack" };
+static const char *payload_names[] = { "double array", "string map", "buffer" };
+
+static void *payloads[METACALL_SERIAL_BENCH_SIZE] = { NULL };
+static void *allocator = NULL;
+
+/* Multi-megabyte JSON document, for comparing the JSON parsers */
+static const char *json_serial_names[] = { "rapid_json", "simd_json" };
+static std::string json_document;
+
+class metacall_serial_bench : public benchmark::Fixture
+{
+public:
+};
+
+BENCHMARK_DEFINE_F(metacall_serial_bench, serialize)
+(benchmark::State &state)
+{
+	const int64_t call_count = 1000;
+	const char *name = serial_names[state.range(0)];
+	void *v = payloads[state.range(1)];
+	size_t size = 0;
+
+	for (auto _ : state)
+	{
+		for (int64_t it = 0; it < call_count; ++it)
+		{
+			char *buffer = metacall_serialize(name, v, &size, allocator);
+
+			state.PauseTiming();
+
+			if (buffer == NULL)
+			{
+				state.SkipWithError("Invalid serialization");
+			}
+
+			metacall_allocator_free(allocator, buffer);
+
+			state.ResumeTiming();
+		}
+	}
+
+	state.SetLabel(std::string(name) + " serialize " + payload_names[state.range(1)]);
+	state.SetBytesProcessed((int64_t)size * call_count);
+	state.SetItemsProcessed(call_count);
+}
+
+BENCHMARK_REGISTER_F(metacall_serial_bench, serialize)
+	->ArgsProduct({ { 0, 1 }, { METACALL_SERIAL_BENCH_ARRAY, METACALL_SERIAL_BENCH_MAP, METACALL_SERIAL_BENCH_BUFFER } })
+	->Unit(benchmark::kMillisecond)
+	->Iterations(1)
+	->Repetitions(5);
+
+BENCHMARK_DEFINE_F(metacall_serial_bench, deserialize)
+(benchmark::State &state)
+{
+	const int64_t call_count = 1000;
+	const char *name = serial_names[state.range(0) & 1];
+	const bool borrowed = state.range(0) > 1;
+	size_t size = 0;
+	char *buffer = metacall_serialize(name, payloads[state.range(1)], &size, allocator);
+
+	if (buffer == NULL)
+	{
+		state.SkipWithError("Invalid serialization");
+		return;
+	}
+
+	for (auto _ : state)
+	{
+		for (int64_t it = 0; it < call_count; ++it)
+		{
+			void *v = borrowed ? metacall_deserialize_borrowed(name, buffer, size, allocator) : metacall_deserialize(name, buffer, size, allocator);
+
+			state.PauseTiming();
+
+			if (v == NULL)
+			{
+				state.SkipWithError("Invalid deserialization");
+			}
+
+			metacall_value_destroy(v);
+
+			state.ResumeTiming();
+		}
+	}
+
+	metacall_allocator_free(allocator, buffer);
+
+	state.SetLabel(std::string(name) + (borrowed ? " deserialize borrowed " : " deserialize ") + payload_names[state.range(1)]);
+	state.SetBytesProcessed((int64_t)size * call_count);
+	state.SetItemsProcessed(call_count);
+}
+
+/* Serial 3 is MessagePack deserializing buffers without copying them (borrowed) */
+BENCHMARK_REGISTER_F(metacall_serial_bench, deserialize)
+	->ArgsProduct({ { 0, 1, 3 }, { METACALL_SERIAL_BENCH_ARRAY, METACALL_SERIAL_BENCH_MAP, METACALL_SERIAL_BENCH_BUFFER } })
+	->Unit(benchmark::kMillisecond)
+	->Iterations(1)
+	->Repetitions(5);
+
+BENCHMARK_DEFINE_F(metacall_serial_bench, deserialize_document)
+(benchmark::State &state)
+{
+	const int64_t call_count = 10;
+	const char *name = json_serial_names[state.range(0)];
+
+	for (auto _ : state)
+	{
+		for (int64_t it = 0; it < call_count; ++it)
+		{
+			void *v = metacall_deserialize(name, json_document.c_str(), json_document.length() + 1, allocator);
+
+			state.PauseTiming();
+
+			if (v == NULL)
+			{
+				state.SkipWithError("Invalid deserialization");
+			}
+
+			metacall_value_destroy(v);
+
+			state.ResumeTiming();
+		}
+	}
+
+	state.SetLabel(std::string(name) + " deserialize document");
+	state.SetBytesProcessed((int64_t)json_document.length() * call_count);
+	state.SetItemsProcessed(call_count);
+}
+
+BENCHMARK_REGISTER_F(metacall_serial_bench, deserialize_document)
+#if defined(OPTION_BUILD_SERIALS_SIMD_JSON)
+	->DenseRange(0, 1)
+#else
+	->Arg(0)
+#endif
+	->Unit(benchmark::kMillisecond)
+	->Iterations(1)
+	->Repetitions(5);
+
+int main(int argc, char *argv[])
+{
+	metacall_print_info();
+
+	metacall_log_null();
+
+	if (metacall_initialize() != 0)
+	{
+		return 1;
+	}
+
+	struct metacall_allocator_std_type std_ctx = { &std::malloc, &std::realloc, &std::free };
+
+	allocator = metacall_allocator_create(METACALL_ALLOCATOR_STD, (void *)&std_ctx);
+
+	/* Array of doubles */
+	{
+		const size_t size = 1000;
+
+		payloads[METACALL_SERIAL_BENCH_ARRAY] = metacall_value_create_array(NULL, size);
+
+		void **values = metacall_value_to_array(payloads[METACALL_SERIAL_BENCH_ARRAY]);
+
+		for (size_t iterator = 0; iterator < size; ++iterator)
+		{
+			values[iterator] = metacall_value_create_double((double)iterator * 0.25);
+		}
+	}
+
+	/* Map of strings */
+	{
+		const size_t size = 100;
+
+		payloads[METACALL_SERIAL_BENCH_MAP] = metacall_value_create_map(NULL, size);
+
+		void **tuples = metacall_value_to_map(payloads[METACALL_SERIAL_BENCH_MAP]);
+
+		for (size_t iterator = 0; iterator < size; ++iterator)
+		{
+			std::string key = "key_" + std::to_string(iterator);
+			std::string value = "value number " + std::to_string(iterator);
+
+			void *tupla[] = {
+				metacall_value_create_string(key.c_str(), key.length()),
+				metacall_value_create_string(value.c_str(), value.length())
+			};
+
+			tuples[iterator] = metacall_value_create_array((const void **)tupla, sizeof(tupla) / sizeof(tupla[0]));
+		}
+	}
+
+	/* Binary buffer */
+	{
+		static char buffer[16 * 1024];
+
+		for (size_t iterator = 0; iterator < sizeof(buffer); ++iterator)
+		{
+			buffer[iterator] = (char)iterator;
+		}
+
+		payloads[METACALL_SERIAL_BENCH_BUFFER] = metacall_value_create_buffer(buffer, sizeof(buffer));
+	}
+
+	/* JSON document of around 4 MB */
+	{
+		const size_t size = 40000;
+
+		json_document = "[";
+
+		for (size_t iterator = 0; iterator < size; ++iterator)
+		{
+			std::string id = std::to_string(iterator);
+
+			if (iterator > 0)
+			{
+				json_document += ",";
+			}
+
+			json_document += "{\"id\":" + id + ",\"name\":\"item number " + id + "\",\"score\":" + id + ".25,\"active\":true,\"tags\":[\"alpha\",\"beta\",\"gamma\"]}";
+		}
+
+		json_document += "]";
+	}
+
+	::benchmark::Initialize(&argc, argv);
+
+	if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 2;
+	}
+
+	::benchmark::RunSpecifiedBenchmarks();
+	::benchmark::Shutdown();
+
+	for (void *v : payloads)
+	{
+		metacall_value_destroy(v);
+	}
+
+	metacall_allocator_destroy(allocator);
+
+	if (metacall_destroy() != 0)
+	{
+		return 3;
+	}
+
+	return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <metacall/metacall.h>
+
+#include <cstdio>
+
+#define TRACE_BENCH_FILE "metacall_trace_bench.json"
+
+class metacall_trace_bench : public benchmark::Fixture
+{
+public:
+};
+
+void *c_noop(size_t argc, void *args[], void *data)
+{
+	(void)argc;
+	(void)args;
+	(void)data;
+
+	return metacall_value_create_long(0L);
+}
+
+static int trace_bench_start(double rate)
+{
+	void *args[] = {
+		metacall_value_create_string(TRACE_BENCH_FILE, sizeof(TRACE_BENCH_FILE) - 1),
+		metacall_value_create_double(rate)
+	};
+
+	void *ret = metacallhv_s(metacall_plugin_core(), "trace_start", args, 2);
+
+	int result = (ret != NULL && metacall_value_id(ret) == METACALL_INT) ? metacall_value_to_int(ret) : 1;
+
+	metacall_value_destroy(args[0]);
+	metacall_value_destroy(args[1]);
+	metacall_value_destroy(ret);
+
+	return result;
+}
+
+static void trace_bench_stop()
+{
+	metacall_value_destroy(metacallhv_s(metacall_plugin_core(), "trace_stop", metacall_null_args, 0));
+
+	std::remove(TRACE_BENCH_FILE);
+}
+
+static void trace_bench_call(benchmark::State &state)
+{
+	void *args[] = {
+		metacall_value_create_long(0L)
+	};
+
+	for (auto _ : state)
+	{
+		void *ret = metacallv_s("c_noop", args, 1);
+
+		if (ret == NULL)
+		{
+			state.SkipWithError("Null return value from c_noop");
+		}
+
+		metacall_value_destroy(ret);
+	}
+
+	metacall_value_destroy(args[0]);
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(metacall_trace_bench, call_untraced)
+(benchmark::State &state)
+{
+	trace_bench_call(state);
+
+	state.SetLabel("MetaCall Trace Benchmark - Call without tracing");
+}
+
+BENCHMARK_REGISTER_F(metacall_trace_bench, call_untraced)
+	->Unit(benchmark::kNanosecond)
+	->Repetitions(5);
+
+/* The overhead of the tracing when a call is sampled out is the difference with call_untraced, it must stay below 100ns */
+BENCHMARK_DEFINE_F(metacall_trace_bench, call_sampled_out)
+(benchmark::State &state)
+{
+	if (trace_bench_start(0.0) != 0)
+	{
+		state.SkipWithError("Trace plugin failed to start");
+		return;
+	}
+
+	trace_bench_call(state);
+
+	trace_bench_stop();
+
+	state.SetLabel("MetaCall Trace Benchmark - Call sampled out");
+}
+
+BENCHMARK_REGISTER_F(metacall_trace_bench, call_sampled_out)
+	->Unit(benchmark::kNanosecond)
+	->Repetitions(5);
+
+BENCHMARK_DEFINE_F(metacall_trace_bench, call_sampled_in)
+(benchmark::State &state)
+{
+	if (trace_bench_start(1.0) != 0)
+	{
+		state.SkipWithError("Trace plugin failed to start");
+		return;
+	}
+
+	trace_bench_call(state);
+
+	trace_bench_stop();
+
+	state.SetLabel("MetaCall Trace Benchmark - Call sampled in");
+}
+
+BENCHMARK_REGISTER_F(metacall_trace_bench, call_sampled_in)
+	->Unit(benchmark::kNanosecond)
+	->Repetitions(5);
+
+/* Use main for initializing MetaCall once */
+int main(int argc, char *argv[])
+{
+	metacall_print_info();
+
+	metacall_log_null();
+
+	if (metacall_initialize() != 0)
+	{
+		return 1;
+	}
+
+	if (metacall_register("c_noop", c_noop, NULL, METACALL_LONG, 1, METACALL_LONG) != 0)
+	{
+		return 2;
+	}
+
+	::benchmark::Initialize(&argc, argv);
+
+	if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 3;
+	}
+
+	::benchmark::RunSpecifiedBenchmarks();
+	::benchmark::Shutdown();
+
+	if (metacall_destroy() != 0)
+	{
+		return 4;
+	}
+
+	return 0;
+}
@@ -452,7 +452,7 @@ void application::run()
 				struct await_data_type *await_data = static_cast<struct await_data_type *>(ctx);
 				std::unique_lock<std::mutex> lock(await_data->mutex);
 				/* Value must be always copied, it gets deleted after the scope */
-				await_data->v = metacall_value_copy(result);
+				await_data->v = metacall_value_share(result);
 				await_data->cond.notify_one();
 				return NULL;
 			},
@@ -460,7 +460,7 @@ void application::run()
 				struct await_data_type *await_data = static_cast<struct await_data_type *>(ctx);
 				std::unique_lock<std::mutex> lock(await_data->mutex);
 				/* Value must be always copied, it gets deleted after the scope */
-				await_data->v = metacall_value_copy(result);
+				await_data->v = metacall_value_share(result);
 				await_data->exit_condition = true;
 				await_data->cond.notify_one();
 				return NULL;
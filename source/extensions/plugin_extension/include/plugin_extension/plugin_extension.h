@@ -33,6 +33,10 @@ PLUGIN_EXTENSION_API int plugin_extension(void *loader, void *handle);
 
 DYNLINK_SYMBOL_EXPORT(plugin_extension);
 
+PLUGIN_EXTENSION_API int plugin_extension_destroy(void);
+
+DYNLINK_SYMBOL_EXPORT(plugin_extension_destroy);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,10 +36,503 @@ namespace fs = std::experimental::filesystem;
 	#error "C++ standard too old for compiling this file."
 #endif
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <vector>
+
+/* Environment variable pointing to the folder where the plugin manifests are stored */
+#define PLUGIN_EXTENSION_CACHE_PATH "PLUGIN_EXTENSION_CACHE_PATH"
+
+/* Bump this whenever the manifest layout changes */
+#define PLUGIN_EXTENSION_MANIFEST_VERSION "metacall-plugin-manifest 2"
+
+struct plugin_manifest_file
+{
+	std::string path;
+	long long mtime;
+	unsigned long long size;
+};
+
+struct plugin_manifest_function
+{
+	std::string name;
+	enum metacall_value_id ret;
+	std::vector<enum metacall_value_id> args;
+};
+
+struct plugin_manifest_entry
+{
+	std::string config;
+	bool lazy;
+	std::vector<plugin_manifest_function> functions;
+};
+
+struct plugin_manifest
+{
+	std::vector<plugin_manifest_file> files;
+	std::vector<plugin_manifest_entry> entries;
+};
+
+struct plugin_lazy
+{
+	std::string config;
+	std::mutex mutex;
+	void *handle;
+	bool loaded;
+};
+
+struct plugin_lazy_function
+{
+	plugin_lazy *plugin;
+	std::string name;
+};
 
 static void *extension_loader = NULL;
 
+/* Plugins registered lazily, they are loaded the first time one of their functions is called */
+static std::mutex plugin_lazy_mutex;
+static std::vector<std::unique_ptr<plugin_lazy>> plugin_lazy_list;
+static std::vector<std::unique_ptr<plugin_lazy_function>> plugin_lazy_function_list;
+
+static std::string plugin_manifest_path(const std::string &ext_path)
+{
+	const char *cache_path = std::getenv(PLUGIN_EXTENSION_CACHE_PATH);
+
+	if (cache_path == NULL || *cache_path == '\0')
+	{
+		return std::string();
+	}
+
+	std::stringstream ss;
+
+	ss << "plugin-" << std::hex << std::hash<std::string>{}(fs::absolute(fs::path(ext_path)).string()) << ".manifest";
+
+	return (fs::path(cache_path) / ss.str()).string();
+}
+
+static bool plugin_manifest_file_stat(const std::string &path, plugin_manifest_file &file)
+{
+	std::error_code ec;
+	fs::path p(path);
+
+	file.path = path;
+
+	/* Loading a plugin may write into its folder (i.e Python __pycache__), so directories are tracked by the names they contain */
+	if (fs::is_directory(p, ec))
+	{
+		std::vector<std::string> names;
+
+		for (fs::directory_iterator it(p, ec), end; !ec && it != end; it.increment(ec))
+		{
+			std::string name = it->path().filename().string();
+
+			if (name != "__pycache__")
+			{
+				names.push_back(name);
+			}
+		}
+
+		std::sort(names.begin(), names.end());
+
+		std::string listing;
+
+		for (const std::string &name : names)
+		{
+			listing += name;
+			listing += '\0';
+		}
+
+		file.mtime = 0;
+		file.size = static_cast<unsigned long long>(std::hash<std::string>{}(listing));
+
+		return !ec;
+	}
+
+	auto mtime = fs::last_write_time(p, ec);
+
+	if (ec)
+	{
+		return false;
+	}
+
+	file.mtime = static_cast<long long>(mtime.time_since_epoch().count());
+	file.size = static_cast<unsigned long long>(fs::file_size(p, ec));
+
+	return !ec;
+}
+
+static bool plugin_manifest_validate(const plugin_manifest &manifest)
+{
+	/* Directories are part of the list, so adding or removing a plugin changes their timestamp */
+	for (const plugin_manifest_file &file : manifest.files)
+	{
+		plugin_manifest_file current;
+
+		if (plugin_manifest_file_stat(file.path, current) == false || current.mtime != file.mtime || current.size != file.size)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool plugin_manifest_load(const std::string &path, plugin_manifest &manifest)
+{
+	std::ifstream stream(path);
+	std::string line;
+
+	if (!stream.is_open() || !std::getline(stream, line) || line != PLUGIN_EXTENSION_MANIFEST_VERSION)
+	{
+		return false;
+	}
+
+	while (std::getline(stream, line))
+	{
+		std::istringstream ss(line);
+		std::string kind;
+
+		ss >> kind;
+
+		if (kind == "file")
+		{
+			plugin_manifest_file file;
+
+			ss >> file.mtime >> file.size;
+			ss.get();
+
+			if (!ss || !std::getline(ss, file.path))
+			{
+				return false;
+			}
+
+			manifest.files.push_back(file);
+		}
+		else if (kind == "plugin")
+		{
+			plugin_manifest_entry entry;
+			int lazy;
+
+			ss >> lazy;
+			ss.get();
+
+			if (!ss || !std::getline(ss, entry.config))
+			{
+				return false;
+			}
+
+			entry.lazy = (lazy != 0);
+			manifest.entries.push_back(entry);
+		}
+		else if (kind == "function" && !manifest.entries.empty())
+		{
+			plugin_manifest_function func;
+			int ret;
+			size_t size;
+
+			ss >> ret >> size;
+
+			func.ret = static_cast<enum metacall_value_id>(ret);
+
+			for (size_t iterator = 0; iterator < size; ++iterator)
+			{
+				int arg;
+
+				ss >> arg;
+
+				func.args.push_back(static_cast<enum metacall_value_id>(arg));
+			}
+
+			ss >> func.name;
+
+			if (!ss)
+			{
+				return false;
+			}
+
+			manifest.entries.back().functions.push_back(func);
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void plugin_manifest_store(const std::string &path, const plugin_manifest &manifest)
+{
+	std::error_code ec;
+
+	/* The files keep the state taken by the scan, a change done while the plugins were loading invalidates the manifest */
+	fs::path manifest_path(path);
+
+	fs::create_directories(manifest_path.parent_path(), ec);
+
+	/* Write into a temporary file and rename it, so concurrent processes never read a partial manifest */
+	fs::path temp_path(path + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+
+	{
+		std::ofstream stream(temp_path.string(), std::ios::trunc);
+
+		if (!stream.is_open())
+		{
+			log_write("metacall", LOG_LEVEL_WARNING, "Failed to write plugin manifest: %s", path.c_str());
+			return;
+		}
+
+		stream << PLUGIN_EXTENSION_MANIFEST_VERSION << "\n";
+
+		for (const plugin_manifest_file &file : manifest.files)
+		{
+			stream << "file " << file.mtime << " " << file.size << " " << file.path << "\n";
+		}
+
+		for (const plugin_manifest_entry &entry : manifest.entries)
+		{
+			stream << "plugin " << (entry.lazy ? 1 : 0) << " " << entry.config << "\n";
+
+			for (const plugin_manifest_function &func : entry.functions)
+			{
+				stream << "function " << static_cast<int>(func.ret) << " " << func.args.size();
+
+				for (enum metacall_value_id arg : func.args)
+				{
+					stream << " " << static_cast<int>(arg);
+				}
+
+				stream << " " << func.name << "\n";
+			}
+		}
+	}
+
+	fs::rename(temp_path, manifest_path, ec);
+
+	if (ec)
+	{
+		log_write("metacall", LOG_LEVEL_WARNING, "Failed to store plugin manifest: %s", path.c_str());
+		fs::remove(temp_path, ec);
+	}
+}
+
+static void plugin_manifest_scan(const std::string &ext_path, plugin_manifest &manifest)
+{
+	static std::string m_begins = "metacall-";
+	static std::string m_ends = ".json";
+
+	plugin_manifest_file file;
+
+	if (plugin_manifest_file_stat(ext_path, file))
+	{
+		manifest.files.push_back(file);
+	}
+
+	auto i = fs::recursive_directory_iterator(ext_path);
+	while (i != fs::recursive_directory_iterator())
+	{
+		if (i.depth() == 1)
+		{
+			i.disable_recursion_pending();
+		}
+
+		fs::directory_entry dir(*i);
+
+		if (i.depth() == 0 && dir.is_directory() && plugin_manifest_file_stat(dir.path().string(), file))
+		{
+			manifest.files.push_back(file);
+		}
+
+		if (dir.is_regular_file())
+		{
+			std::string config = dir.path().filename().string();
+
+			if (config == "metacall.json" ||
+				(config.substr(0, m_begins.size()) == m_begins &&
+					config.substr(config.size() - m_ends.size()) == m_ends))
+			{
+				plugin_manifest_entry entry;
+
+				entry.config = dir.path().string();
+				entry.lazy = false;
+
+				manifest.entries.push_back(entry);
+
+				/* Track the scripts next to the configuration, so modifying them regenerates the manifest */
+				for (const fs::directory_entry &script : fs::directory_iterator(dir.path().parent_path()))
+				{
+					if (script.is_regular_file() && plugin_manifest_file_stat(script.path().string(), file))
+					{
+						manifest.files.push_back(file);
+					}
+				}
+
+				i++;
+
+				if (i != fs::end(i) && i.depth() == 1)
+				{
+					i.pop();
+				}
+				continue;
+			}
+		}
+
+		i++;
+	}
+}
+
+static void plugin_manifest_describe(plugin_manifest_entry &entry, void *handle)
+{
+	void *exports = metacall_handle_export(handle);
+
+	if (exports == NULL)
+	{
+		return;
+	}
+
+	size_t size = metacall_value_count(exports);
+	void **pairs = metacall_value_to_map(exports);
+
+	/* Only plugins exporting synchronous functions can be proxied, anything else is loaded eagerly */
+	entry.lazy = true;
+
+	for (size_t iterator = 0; iterator < size; ++iterator)
+	{
+		void **pair = metacall_value_to_array(pairs[iterator]);
+
+		if (metacall_value_id(pair[1]) != METACALL_FUNCTION)
+		{
+			entry.lazy = false;
+			break;
+		}
+
+		void *func = metacall_value_to_function(pair[1]);
+
+		if (metacall_function_async(func) != 0)
+		{
+			entry.lazy = false;
+			break;
+		}
+
+		plugin_manifest_function desc;
+		size_t args_size = metacall_function_size(func);
+
+		desc.name = metacall_value_to_string(pair[0]);
+
+		metacall_function_return_type(func, &desc.ret);
+
+		for (size_t arg = 0; arg < args_size; ++arg)
+		{
+			enum metacall_value_id id;
+
+			metacall_function_parameter_type(func, arg, &id);
+
+			desc.args.push_back(id);
+		}
+
+		entry.functions.push_back(desc);
+	}
+
+	if (entry.lazy == false)
+	{
+		entry.functions.clear();
+	}
+
+	metacall_value_destroy(exports);
+}
+
+static void *plugin_lazy_invoke(size_t argc, void *args[], void *data)
+{
+	plugin_lazy_function *lazy_func = static_cast<plugin_lazy_function *>(data);
+	plugin_lazy *lazy = lazy_func->plugin;
+	void *handle = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(lazy->mutex);
+
+		if (lazy->loaded == false)
+		{
+			struct metacall_allocator_std_type std_ctx = { &std::malloc, &std::realloc, &std::free };
+			void *config_allocator = metacall_allocator_create(METACALL_ALLOCATOR_STD, (void *)&std_ctx);
+
+			/* The plugin outlives the call, so it must not be loaded into the allocator of the caller (i.e an arena) */
+			void *previous = metacall_allocator_scope_begin(NULL);
+
+			log_write("metacall", LOG_LEVEL_DEBUG, "Loading lazy plugin: %s", lazy->config.c_str());
+
+			if (metacall_load_from_configuration(lazy->config.c_str(), &lazy->handle, config_allocator) != 0)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Failed to load lazy plugin: %s", lazy->config.c_str());
+				lazy->handle = NULL;
+			}
+
+			metacall_allocator_scope_end(previous);
+
+			metacall_allocator_destroy(config_allocator);
+
+			lazy->loaded = true;
+		}
+
+		handle = lazy->handle;
+	}
+
+	void *func = handle != NULL ? metacall_handle_function(handle, lazy_func->name.c_str()) : NULL;
+
+	if (func == NULL)
+	{
+		std::string error = "Failed to resolve the function '" + lazy_func->name + "' from plugin: " + lazy->config;
+		EXTENSION_FUNCTION_THROW(error.c_str());
+	}
+
+	/* Calls without arguments may reach the proxy with a null argument array */
+	return metacallfv_s(func, args != NULL ? args : metacall_null_args, argc);
+}
+
+static int plugin_lazy_register(const plugin_manifest_entry &entry, void *handle)
+{
+	std::lock_guard<std::mutex> lock(plugin_lazy_mutex);
+
+	plugin_lazy_list.emplace_back(new plugin_lazy());
+
+	plugin_lazy *lazy = plugin_lazy_list.back().get();
+
+	lazy->config = entry.config;
+	lazy->handle = NULL;
+	lazy->loaded = false;
+
+	for (const plugin_manifest_function &desc : entry.functions)
+	{
+		std::vector<enum metacall_value_id> args(desc.args);
+
+		plugin_lazy_function_list.emplace_back(new plugin_lazy_function());
+
+		plugin_lazy_function *lazy_func = plugin_lazy_function_list.back().get();
+
+		lazy_func->plugin = lazy;
+		lazy_func->name = desc.name;
+
+		/* The scope does not copy the name, so it must outlive the handle */
+		const char *name = lazy_func->name.c_str();
+
+		if (metacall_register_loaderv(extension_loader, handle, name, &plugin_lazy_invoke, desc.ret, args.size(), args.data()) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Failed to register lazy function '%s' from plugin: %s", name, entry.config.c_str());
+			return 1;
+		}
+
+		function_bind(static_cast<function>(metacall_handle_function(handle, name)), lazy_func);
+	}
+
+	return 0;
+}
+
 void *plugin_load_from_path(size_t argc, void *args[], void *data)
 {
 	/* TODO: Improve return values with throwable in the future */
@@ -90,63 +583,81 @@ void *plugin_load_from_path(size_t argc, void *args[], void *data)
 		}
 	}
 
-	static std::string m_begins = "metacall-";
-	static std::string m_ends = ".json";
+	/* Reuse the manifest of the last scan if the plugin folder did not change */
+	std::string manifest_path = plugin_manifest_path(ext_path);
+	plugin_manifest manifest;
+	bool manifest_valid = false;
+
+	if (!manifest_path.empty())
+	{
+		manifest_valid = plugin_manifest_load(manifest_path, manifest) && plugin_manifest_validate(manifest);
+
+		if (manifest_valid == false)
+		{
+			manifest = plugin_manifest();
+		}
+	}
+
+	if (manifest_valid == false)
+	{
+		plugin_manifest_scan(ext_path, manifest);
+	}
+
+	/* Plugins can only be described and proxied when they are loaded into their own handle */
+	bool private_handle = (handle_ptr != NULL && *handle_ptr != NULL);
 
 	struct metacall_allocator_std_type std_ctx = { &std::malloc, &std::realloc, &std::free };
 	void *config_allocator = metacall_allocator_create(METACALL_ALLOCATOR_STD, (void *)&std_ctx);
 
-	auto i = fs::recursive_directory_iterator(ext_path);
-	while (i != fs::recursive_directory_iterator())
+	for (plugin_manifest_entry &entry : manifest.entries)
 	{
-		if (i.depth() == 1)
-		{
-			i.disable_recursion_pending();
-		}
+		const char *dir_path = entry.config.c_str();
 
-		fs::directory_entry dir(*i);
-		if (dir.is_regular_file())
+		if (manifest_valid && private_handle && entry.lazy)
 		{
-			std::string config = dir.path().filename().string();
+			log_write("metacall", LOG_LEVEL_DEBUG, "Registering lazy plugin: %s", dir_path);
 
-			if (config == "metacall.json" ||
-				(config.substr(0, m_begins.size()) == m_begins &&
-					config.substr(config.size() - m_ends.size()) == m_ends))
+			if (plugin_lazy_register(entry, *handle_ptr) != 0)
 			{
-				std::string dir_path = dir.path().string();
-				void *current_handle = NULL;
-				void **current_handle_ptr = (handle_ptr != NULL && *handle_ptr != NULL) ? &current_handle : NULL;
+				metacall_allocator_destroy(config_allocator);
+				return metacall_value_create_int(4);
+			}
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Loading plugin: %s", dir_path.c_str());
+			continue;
+		}
 
-				/* On each iteration, pass a new handle to metacall_load_from_configuration */
-				if (metacall_load_from_configuration(dir_path.c_str(), current_handle_ptr, config_allocator) != 0)
-				{
-					log_write("metacall", LOG_LEVEL_ERROR, "Failed to load plugin: %s", dir_path.c_str());
-					metacall_allocator_destroy(config_allocator);
-					return metacall_value_create_int(4);
-				}
+		void *current_handle = NULL;
+		void **current_handle_ptr = private_handle ? &current_handle : NULL;
 
-				/* Populate the current handle into the handle_ptr */
-				if (handle_ptr != NULL && *handle_ptr != NULL)
-				{
-					if (metacall_handle_populate(*handle_ptr, current_handle) != 0)
-					{
-						log_write("metacall", LOG_LEVEL_ERROR, "Failed to populate handle in plugin: %s", dir_path.c_str());
-					}
-				}
+		log_write("metacall", LOG_LEVEL_DEBUG, "Loading plugin: %s", dir_path);
 
-				i++;
+		/* On each iteration, pass a new handle to metacall_load_from_configuration */
+		if (metacall_load_from_configuration(dir_path, current_handle_ptr, config_allocator) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Failed to load plugin: %s", dir_path);
+			metacall_allocator_destroy(config_allocator);
+			return metacall_value_create_int(4);
+		}
 
-				if (i != fs::end(i) && i.depth() == 1)
-				{
-					i.pop();
-				}
-				continue;
+		/* Populate the current handle into the handle_ptr */
+		if (private_handle)
+		{
+			if (manifest_valid == false)
+			{
+				plugin_manifest_describe(entry, current_handle);
+			}
+
+			if (metacall_handle_populate(*handle_ptr, current_handle) != 0)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Failed to populate handle in plugin: %s", dir_path);
 			}
 		}
+	}
 
-		i++;
+	/* Only store manifests that describe the plugin exports, so they can be loaded lazily later on */
+	if (manifest_valid == false && private_handle && !manifest_path.empty())
+	{
+		plugin_manifest_store(manifest_path, manifest);
 	}
 
 	metacall_allocator_destroy(config_allocator);
@@ -164,3 +675,16 @@ int plugin_extension(void *loader, void *handle)
 
 	return 0;
 }
+
+int plugin_extension_destroy(void)
+{
+	std::lock_guard<std::mutex> lock(plugin_lazy_mutex);
+
+	/* The handles of the lazy plugins have been already destroyed along with their loaders */
+	plugin_lazy_function_list.clear();
+	plugin_lazy_list.clear();
+
+	extension_loader = NULL;
+
+	return 0;
+}
@@ -25,11 +25,12 @@
 
 #include <filesystem/filesystem_api.h>
 
+#include <filesystem/filesystem_watcher.h>
+
 /*
 #include <filesystem/filesystem_directory.h>
 #include <filesystem/filesystem_file.h>
 #include <filesystem/filesystem_interface.h>
-#include <filesystem/filesystem_watcher.h>
 */
 
 #include <adt/adt_set.h>
@@ -0,0 +1,109 @@
+/*
+ *	File System Library by Parra Studios
+ *	A cross-platform library for managing file system, paths and files.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#ifndef FILESYSTEM_WATCHER_H
+#define FILESYSTEM_WATCHER_H 1
+
+/* -- Headers -- */
+
+#include <filesystem/filesystem_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -- Definitions -- */
+
+#define FILESYSTEM_WATCHER_PATH_SIZE 0x1000
+
+/* -- Forward Declarations -- */
+
+struct filesystem_watcher_type;
+
+/* -- Type Definitions -- */
+
+typedef struct filesystem_watcher_type *filesystem_watcher;
+
+typedef void (*filesystem_watcher_cb)(filesystem_watcher watcher, const char *path, void *data);
+
+/* -- Methods -- */
+
+/**
+*  @brief
+*    Create a file watcher with its own background thread, the callback is
+*    executed from that thread each time a watched file is written or replaced
+*
+*  @param[in] cb
+*    Callback invoked with the path of the modified file and the data passed when adding it
+*
+*  @return
+*    A handle to the watcher if success, null otherwhise (or if the platform is not supported)
+*/
+FILESYSTEM_API filesystem_watcher filesystem_watcher_create(filesystem_watcher_cb cb);
+
+/**
+*  @brief
+*    Start watching a file, the parent directory is watched so the file can
+*    be replaced atomically (i.e. by editors that write and rename)
+*
+*  @param[in] watcher
+*    A handle to the watcher
+*
+*  @param[in] path
+*    Path to the file
+*
+*  @param[in] data
+*    User data passed to the callback when the file changes
+*
+*  @return
+*    Returns zero on success, different from zero otherwhise
+*/
+FILESYSTEM_API int filesystem_watcher_add(filesystem_watcher watcher, const char *path, void *data);
+
+/**
+*  @brief
+*    Stop watching all the files registered with @data
+*
+*  @param[in] watcher
+*    A handle to the watcher
+*
+*  @param[in] data
+*    User data used when adding the files
+*
+*  @return
+*    Returns zero on success, different from zero otherwhise
+*/
+FILESYSTEM_API int filesystem_watcher_remove(filesystem_watcher watcher, void *data);
+
+/**
+*  @brief
+*    Stop the background thread and destroy the watcher, it must not be
+*    called from the watcher callback
+*
+*  @param[in] watcher
+*    A handle to the watcher
+*/
+FILESYSTEM_API void filesystem_watcher_destroy(filesystem_watcher watcher);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILESYSTEM_WATCHER_H */
@@ -0,0 +1,413 @@
+/*
+ *	File System Library by Parra Studios
+ *	A cross-platform library for managing file system, paths and files.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <filesystem/filesystem_watcher.h>
+
+#include <log/log.h>
+
+#include <stdlib.h>
+
+#if defined(__linux__)
+	#include <adt/adt_vector.h>
+
+	#include <threading/threading_mutex.h>
+	#include <threading/threading_thread.h>
+
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <string.h>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+
+	#define FILESYSTEM_WATCHER_MASK (IN_CLOSE_WRITE | IN_MOVED_TO)
+#endif
+
+/* -- Member Data -- */
+
+#if defined(__linux__)
+struct filesystem_watcher_entry_type
+{
+	int wd;									 /**< Watch descriptor of the parent directory */
+	char path[FILESYSTEM_WATCHER_PATH_SIZE]; /**< Path of the file */
+	size_t name;							 /**< Offset to the file name inside the path */
+	void *data;								 /**< User data passed to the callback */
+	int notified;							 /**< Used for coalescing multiple events of the same batch */
+};
+
+struct filesystem_watcher_type
+{
+	filesystem_watcher_cb cb;			 /**< Callback executed when a file changes */
+	struct threading_mutex_type mutex;	 /**< Protects the entries between the user and the watcher thread */
+	vector entries;						 /**< Vector of watched files (filesystem_watcher_entry) */
+	int fd;								 /**< Inotify instance */
+	int pipe[2];						 /**< Used for waking up the thread on destroy */
+	struct threading_thread_type thread; /**< Background thread polling the events */
+};
+
+/* -- Type Definitions -- */
+
+typedef struct filesystem_watcher_entry_type *filesystem_watcher_entry;
+#endif
+
+/* -- Private Methods -- */
+
+#if defined(__linux__)
+static void filesystem_watcher_dispatch(filesystem_watcher watcher, const char *buffer, ssize_t length);
+
+static void filesystem_watcher_thread(void *data);
+#endif
+
+/* -- Methods -- */
+
+filesystem_watcher filesystem_watcher_create(filesystem_watcher_cb cb)
+{
+#if defined(__linux__)
+	filesystem_watcher watcher;
+
+	if (cb == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid file system watcher callback");
+		return NULL;
+	}
+
+	watcher = malloc(sizeof(struct filesystem_watcher_type));
+
+	if (watcher == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher invalid allocation");
+		return NULL;
+	}
+
+	watcher->cb = cb;
+
+	watcher->entries = vector_create(sizeof(struct filesystem_watcher_entry_type));
+
+	if (watcher->entries == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher invalid entries allocation");
+		goto error_entries;
+	}
+
+	watcher->fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+
+	if (watcher->fd == -1)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher failed to initialize inotify: %s", strerror(errno));
+		goto error_inotify;
+	}
+
+	if (pipe(watcher->pipe) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher failed to create the wake up pipe: %s", strerror(errno));
+		goto error_pipe;
+	}
+
+	if (fcntl(watcher->pipe[0], F_SETFD, FD_CLOEXEC) != 0 || fcntl(watcher->pipe[1], F_SETFD, FD_CLOEXEC) != 0 ||
+		threading_mutex_initialize(&watcher->mutex) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher failed to initialize the mutex");
+		goto error_mutex;
+	}
+
+	if (threading_thread_create(&watcher->thread, &filesystem_watcher_thread, watcher) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher failed to create the thread");
+		goto error_thread;
+	}
+
+	return watcher;
+
+error_thread:
+	threading_mutex_destroy(&watcher->mutex);
+error_mutex:
+	close(watcher->pipe[0]);
+	close(watcher->pipe[1]);
+error_pipe:
+	close(watcher->fd);
+error_inotify:
+	vector_destroy(watcher->entries);
+error_entries:
+	free(watcher);
+	return NULL;
+#else
+	(void)cb;
+
+	log_write("metacall", LOG_LEVEL_ERROR, "File system watcher is not supported in this platform");
+
+	return NULL;
+#endif
+}
+
+#if defined(__linux__)
+void filesystem_watcher_dispatch(filesystem_watcher watcher, const char *buffer, ssize_t length)
+{
+	const char *iterator;
+	size_t entry_iterator, size;
+	vector notify = vector_create(sizeof(struct filesystem_watcher_entry_type));
+
+	if (notify == NULL)
+	{
+		return;
+	}
+
+	threading_mutex_lock(&watcher->mutex);
+
+	size = vector_size(watcher->entries);
+
+	for (entry_iterator = 0; entry_iterator < size; ++entry_iterator)
+	{
+		filesystem_watcher_entry entry = vector_at(watcher->entries, entry_iterator);
+
+		entry->notified = 1;
+	}
+
+	for (iterator = buffer; iterator < buffer + length;)
+	{
+		const struct inotify_event *event = (const struct inotify_event *)iterator;
+
+		if ((event->mask & FILESYSTEM_WATCHER_MASK) && event->len > 0)
+		{
+			for (entry_iterator = 0; entry_iterator < size; ++entry_iterator)
+			{
+				filesystem_watcher_entry entry = vector_at(watcher->entries, entry_iterator);
+
+				if (entry->notified != 0 && entry->wd == event->wd && strcmp(&entry->path[entry->name], event->name) == 0)
+				{
+					/* Editors usually generate many events per save, notify each file once per batch */
+					entry->notified = 0;
+
+					vector_push_back(notify, entry);
+				}
+			}
+		}
+
+		iterator += sizeof(struct inotify_event) + event->len;
+	}
+
+	threading_mutex_unlock(&watcher->mutex);
+
+	/* Run the callbacks without the lock, so they can add or remove files */
+	size = vector_size(notify);
+
+	for (entry_iterator = 0; entry_iterator < size; ++entry_iterator)
+	{
+		filesystem_watcher_entry entry = vector_at(notify, entry_iterator);
+
+		watcher->cb(watcher, entry->path, entry->data);
+	}
+
+	vector_destroy(notify);
+}
+
+void filesystem_watcher_thread(void *data)
+{
+	filesystem_watcher watcher = (filesystem_watcher)data;
+	char buffer[0x1000] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd fds[2];
+
+	fds[0].fd = watcher->fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = watcher->pipe[0];
+	fds[1].events = POLLIN;
+
+	for (;;)
+	{
+		ssize_t length;
+
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			log_write("metacall", LOG_LEVEL_ERROR, "File system watcher failed to poll: %s", strerror(errno));
+			break;
+		}
+
+		if (fds[1].revents != 0)
+		{
+			break;
+		}
+
+		while ((length = read(watcher->fd, buffer, sizeof(buffer))) > 0)
+		{
+			filesystem_watcher_dispatch(watcher, buffer, length);
+		}
+	}
+}
+#endif
+
+int filesystem_watcher_add(filesystem_watcher watcher, const char *path, void *data)
+{
+#if defined(__linux__)
+	struct filesystem_watcher_entry_type entry;
+	size_t length, separator;
+
+	if (watcher == NULL || path == NULL)
+	{
+		return 1;
+	}
+
+	length = strnlen(path, FILESYSTEM_WATCHER_PATH_SIZE);
+
+	if (length == 0 || length == FILESYSTEM_WATCHER_PATH_SIZE)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher invalid path length");
+		return 1;
+	}
+
+	memcpy(entry.path, path, length + 1);
+	entry.data = data;
+	entry.notified = 1;
+
+	separator = length;
+
+	while (separator > 0 && entry.path[separator - 1] != '/')
+	{
+		--separator;
+	}
+
+	entry.name = separator;
+
+	/* Watch the parent directory, the separator is removed temporarily for obtaining its path */
+	if (separator == 0)
+	{
+		entry.wd = inotify_add_watch(watcher->fd, ".", FILESYSTEM_WATCHER_MASK);
+	}
+	else if (separator == 1)
+	{
+		entry.wd = inotify_add_watch(watcher->fd, "/", FILESYSTEM_WATCHER_MASK);
+	}
+	else
+	{
+		entry.path[separator - 1] = '\0';
+		entry.wd = inotify_add_watch(watcher->fd, entry.path, FILESYSTEM_WATCHER_MASK);
+		entry.path[separator - 1] = '/';
+	}
+
+	if (entry.wd == -1)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File system watcher failed to watch %s: %s", path, strerror(errno));
+		return 1;
+	}
+
+	threading_mutex_lock(&watcher->mutex);
+
+	vector_push_back(watcher->entries, &entry);
+
+	threading_mutex_unlock(&watcher->mutex);
+
+	return 0;
+#else
+	(void)watcher;
+	(void)path;
+	(void)data;
+
+	return 1;
+#endif
+}
+
+int filesystem_watcher_remove(filesystem_watcher watcher, void *data)
+{
+#if defined(__linux__)
+	size_t iterator = 0;
+
+	if (watcher == NULL)
+	{
+		return 1;
+	}
+
+	threading_mutex_lock(&watcher->mutex);
+
+	while (iterator < vector_size(watcher->entries))
+	{
+		filesystem_watcher_entry entry = vector_at(watcher->entries, iterator);
+
+		if (entry->data == data)
+		{
+			int wd = entry->wd;
+			size_t wd_iterator, wd_count = 0;
+
+			vector_erase(watcher->entries, iterator);
+
+			/* The directory is shared between all the files inside of it, remove it only when it is not used */
+			for (wd_iterator = 0; wd_iterator < vector_size(watcher->entries); ++wd_iterator)
+			{
+				filesystem_watcher_entry wd_entry = vector_at(watcher->entries, wd_iterator);
+
+				if (wd_entry->wd == wd)
+				{
+					++wd_count;
+				}
+			}
+
+			if (wd_count == 0)
+			{
+				inotify_rm_watch(watcher->fd, wd);
+			}
+		}
+		else
+		{
+			++iterator;
+		}
+	}
+
+	threading_mutex_unlock(&watcher->mutex);
+
+	return 0;
+#else
+	(void)watcher;
+	(void)data;
+
+	return 1;
+#endif
+}
+
+void filesystem_watcher_destroy(filesystem_watcher watcher)
+{
+#if defined(__linux__)
+	if (watcher != NULL)
+	{
+		static const char stop = 0;
+
+		if (write(watcher->pipe[1], &stop, sizeof(stop)) != sizeof(stop))
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "File system watcher failed to stop the thread: %s", strerror(errno));
+		}
+		else
+		{
+			threading_thread_join(&watcher->thread);
+		}
+
+		threading_mutex_destroy(&watcher->mutex);
+		close(watcher->pipe[0]);
+		close(watcher->pipe[1]);
+		close(watcher->fd);
+		vector_destroy(watcher->entries);
+		free(watcher);
+	}
+#else
+	(void)watcher;
+#endif
+}
@@ -77,6 +77,8 @@ LOADER_API loader_impl loader_get_impl(const loader_tag tag);
 
 LOADER_API loader_data loader_get(const char *name);
 
+LOADER_API int loader_get_multithread(function func);
+
 LOADER_API void *loader_get_handle(const loader_tag tag, const char *name);
 
 LOADER_API void loader_set_options(const loader_tag tag, void *options);
@@ -95,8 +97,18 @@ LOADER_API int loader_handle_populate(void *handle_dest, void *handle_src);
 
 LOADER_API value loader_metadata(void);
 
+LOADER_API value loader_metrics(void);
+
+LOADER_API int loader_reload(void *handle);
+
+LOADER_API int loader_watch(void *handle);
+
 LOADER_API int loader_clear(void *handle);
 
+LOADER_API size_t loader_generation(void);
+
+LOADER_API int loader_fork(enum loader_impl_fork_id id);
+
 LOADER_API int loader_is_destroyed(loader_impl impl);
 
 LOADER_API void loader_set_destroyed(loader_impl impl);
@@ -71,6 +71,14 @@ LOADER_API void *loader_impl_get_options(loader_impl impl);
 
 LOADER_API int loader_impl_handle_initialize(plugin_manager manager, plugin p, loader_impl impl, const loader_path name, void **handle_ptr);
 
+LOADER_API int loader_impl_reload(plugin_manager manager, void *handle);
+
+LOADER_API size_t loader_impl_handle_retired_size(void *handle);
+
+LOADER_API const loader_path *loader_impl_handle_paths(void *handle, size_t *size);
+
+LOADER_API int loader_impl_handle_path_resolve(void *handle, const loader_path path, loader_path result);
+
 LOADER_API vector loader_impl_handle_populated(void *handle);
 
 LOADER_API const char *loader_impl_handle_id(void *handle);
@@ -85,8 +93,14 @@ LOADER_API int loader_impl_handle_validate(void *handle);
 
 LOADER_API value loader_impl_metadata(loader_impl impl);
 
+LOADER_API value loader_impl_metrics(loader_impl impl);
+
 LOADER_API int loader_impl_clear(void *handle);
 
+LOADER_API int loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id);
+
+LOADER_API int loader_impl_multithread(loader_impl impl);
+
 LOADER_API void loader_impl_destroy_objects(loader_impl impl);
 
 LOADER_API void loader_impl_destroy_deallocate(loader_impl impl);
@@ -57,6 +57,15 @@ typedef int (*loader_impl_interface_discover)(loader_impl, loader_handle, contex
 
 typedef int (*loader_impl_interface_destroy)(loader_impl);
 
+enum loader_impl_fork_id
+{
+	LOADER_IMPL_FORK_PREPARE, /* Executed in the parent before the fork */
+	LOADER_IMPL_FORK_PARENT,  /* Executed in the parent after the fork */
+	LOADER_IMPL_FORK_CHILD    /* Executed in the child after the fork */
+};
+
+typedef int (*loader_impl_interface_fork)(loader_impl, enum loader_impl_fork_id);
+
 typedef struct loader_impl_interface_type
 {
 	loader_impl_interface_initialize initialize;
@@ -67,6 +76,8 @@ typedef struct loader_impl_interface_type
 	loader_impl_interface_clear clear;
 	loader_impl_interface_discover discover;
 	loader_impl_interface_destroy destroy;
+	loader_impl_interface_fork fork; /* Optional, NULL if the runtime cannot survive a fork (it must be initialized again in the child) */
+	int multithread;				 /* Non zero if the functions can be called from any thread, otherwise only from the thread that initialized the loader */
 
 } * loader_impl_interface;
 
@@ -29,14 +29,19 @@
 #include <reflect/reflect_context.h>
 #include <reflect/reflect_scope.h>
 
+#include <adt/adt_intern.h>
 #include <adt/adt_vector.h>
 
 #include <serial/serial.h>
 
 #include <detour/detour.h>
 
+#include <filesystem/filesystem_watcher.h>
+
 #include <log/log.h>
 
+#include <threading/threading_atomic.h>
+#include <threading/threading_mutex.h>
 #include <threading/threading_thread_id.h>
 
 #include <stdlib.h>
@@ -62,10 +67,18 @@ struct loader_get_cb_iterator_type
 	value obj; /* scope_object */
 };
 
+struct loader_get_multithread_cb_iterator_type
+{
+	function func;
+	int multithread;
+};
+
 /* -- Type Definitions -- */
 
 typedef struct loader_get_cb_iterator_type *loader_get_cb_iterator;
 
+typedef struct loader_get_multithread_cb_iterator_type *loader_get_multithread_cb_iterator;
+
 typedef struct loader_metadata_cb_iterator_type *loader_metadata_cb_iterator;
 
 /* -- Private Methods -- */
@@ -78,14 +91,32 @@ static plugin loader_get_impl_plugin(const loader_tag tag);
 
 static int loader_get_cb_iterate(plugin_manager manager, plugin p, void *data);
 
+static int loader_get_multithread_cb_iterate(plugin_manager manager, plugin p, void *data);
+
 static int loader_metadata_cb_iterate(plugin_manager manager, plugin p, void *data);
 
+static int loader_metrics_cb_iterate(plugin_manager manager, plugin p, void *data);
+
+static void loader_watcher_cb(filesystem_watcher watcher, const char *path, void *data);
+
+static void loader_watcher_remove(void *handle);
+
 /* -- Member Data -- */
 
 static plugin_manager_declare(loader_manager);
 
 static int loader_manager_initialized = 1;
 
+static struct threading_mutex_type loader_reload_mutex; /* Serializes reload, watch and clear of handles */
+
+static filesystem_watcher loader_watcher = NULL; /* Created on demand by loader_watch */
+
+static uint64_t loader_fork_thread_id = THREAD_ID_INVALID; /* Thread which forks, it is the only one that exists in the child */
+
+static vector loader_watcher_handles = NULL; /* Handles being watched */
+
+static atomic_size_t loader_handle_generation = 0; /* Increased each time the functions of a handle are replaced or destroyed */
+
 /* -- Methods -- */
 
 int loader_initialize(void)
@@ -134,6 +165,13 @@ int loader_initialize(void)
 	/* Insert into destruction list */
 	loader_initialization_register_plugin(manager_impl->host);
 
+	if (threading_mutex_initialize(&loader_reload_mutex) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Loader reload mutex failed to initialize");
+		plugin_manager_destroy(&loader_manager);
+		return 1;
+	}
+
 	/* TODO: Disable logs here until log is completely thread safe and async signal safe */
 	/* log_write("metacall", LOG_LEVEL_DEBUG, "Loader host initialized"); */
 
@@ -533,6 +571,42 @@ loader_data loader_get(const char *name)
 	return (loader_data)get_iterator.obj;
 }
 
+int loader_get_multithread_cb_iterate(plugin_manager manager, plugin p, void *data)
+{
+	loader_impl impl = plugin_impl_type(p, loader_impl);
+	loader_get_multithread_cb_iterator multithread_iterator = data;
+	value v = loader_impl_get_value(impl, function_name(multithread_iterator->func));
+
+	(void)manager;
+
+	/* The same name can be defined by another loader, so the function must match too */
+	if (v != NULL && type_id_function(value_type_id(v)) == 0 && value_to_function(v) == multithread_iterator->func)
+	{
+		multithread_iterator->multithread = loader_impl_multithread(impl);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+int loader_get_multithread(function func)
+{
+	struct loader_get_multithread_cb_iterator_type multithread_iterator;
+
+	multithread_iterator.func = func;
+	multithread_iterator.multithread = 0;
+
+	if (func == NULL || function_name(func) == NULL)
+	{
+		return 0;
+	}
+
+	plugin_manager_iterate(&loader_manager, &loader_get_multithread_cb_iterate, (void *)&multithread_iterator);
+
+	return multithread_iterator.multithread;
+}
+
 void *loader_get_handle(const loader_tag tag, const char *name)
 {
 	plugin p = loader_get_impl_plugin(tag);
@@ -680,9 +754,338 @@ value loader_metadata(void)
 	return v;
 }
 
+int loader_metrics_cb_iterate(plugin_manager manager, plugin p, void *data)
+{
+	loader_impl impl = plugin_impl_type(p, loader_impl);
+	loader_metadata_cb_iterator metrics_iterator = data;
+	const char *tag = plugin_name(p);
+	value *v_ptr, v = value_create_array(NULL, 2);
+
+	(void)manager;
+
+	if (v == NULL)
+	{
+		return 0;
+	}
+
+	v_ptr = value_to_array(v);
+
+	v_ptr[0] = value_create_string(tag, strnlen(tag, LOADER_TAG_SIZE));
+	v_ptr[1] = loader_impl_metrics(impl);
+
+	if (v_ptr[0] == NULL || v_ptr[1] == NULL)
+	{
+		value_type_destroy(v);
+
+		return 0;
+	}
+
+	metrics_iterator->values[metrics_iterator->iterator++] = v;
+
+	return 0;
+}
+
+value loader_metrics(void)
+{
+	struct loader_metadata_cb_iterator_type metrics_iterator;
+	value v = value_create_map(NULL, plugin_manager_size(&loader_manager));
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	metrics_iterator.iterator = 0;
+	metrics_iterator.values = value_to_map(v);
+
+	plugin_manager_iterate(&loader_manager, &loader_metrics_cb_iterate, (void *)&metrics_iterator);
+
+	/* The loaders whose metrics could not be created are skipped, so do not leave empty slots in the map */
+	if (metrics_iterator.iterator != value_type_count(v))
+	{
+		value shrink = value_create_map(metrics_iterator.values, metrics_iterator.iterator);
+
+		if (shrink == NULL)
+		{
+			value_type_destroy(v);
+			return NULL;
+		}
+
+		value_destroy(v);
+
+		return shrink;
+	}
+
+	return v;
+}
+
+int loader_reload(void *handle)
+{
+	int result;
+
+	threading_mutex_lock(&loader_reload_mutex);
+
+	result = loader_impl_reload(&loader_manager, handle);
+
+	if (result == 0)
+	{
+		atomic_fetch_add_explicit(&loader_handle_generation, 1, memory_order_release);
+	}
+
+	threading_mutex_unlock(&loader_reload_mutex);
+
+	return result;
+}
+
+void loader_watcher_cb(filesystem_watcher watcher, const char *path, void *data)
+{
+	size_t iterator;
+
+	(void)watcher;
+
+	threading_mutex_lock(&loader_reload_mutex);
+
+	/* The handle may have been cleared meanwhile the event was being dispatched */
+	for (iterator = 0; iterator < vector_size(loader_watcher_handles); ++iterator)
+	{
+		if (vector_at_type(loader_watcher_handles, iterator, void *) == data)
+		{
+			if (loader_impl_reload(&loader_manager, data) != 0)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Failed to reload the handle after a change in: %s", path);
+			}
+			else
+			{
+				atomic_fetch_add_explicit(&loader_handle_generation, 1, memory_order_release);
+			}
+
+			break;
+		}
+	}
+
+	threading_mutex_unlock(&loader_reload_mutex);
+}
+
+int loader_watch(void *handle)
+{
+	const loader_path *paths;
+	size_t iterator, size;
+	int result = 1;
+
+	if (loader_impl_handle_validate(handle) != 0)
+	{
+		return 1;
+	}
+
+	threading_mutex_lock(&loader_reload_mutex);
+
+	paths = loader_impl_handle_paths(handle, &size);
+
+	if (paths == NULL || size == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Failed to watch the handle %s, only handles loaded from file can be watched", loader_impl_handle_id(handle));
+		goto unlock;
+	}
+
+	if (loader_watcher == NULL)
+	{
+		loader_watcher_handles = vector_create_type(void *);
+
+		if (loader_watcher_handles == NULL)
+		{
+			goto unlock;
+		}
+
+		loader_watcher = filesystem_watcher_create(&loader_watcher_cb);
+
+		if (loader_watcher == NULL)
+		{
+			vector_destroy(loader_watcher_handles);
+			loader_watcher_handles = NULL;
+			goto unlock;
+		}
+	}
+
+	/* Avoid registering the same handle twice */
+	loader_watcher_remove(handle);
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		loader_path path;
+
+		/* Watch the file that the loader has loaded, not the one relative to the current working directory */
+		if (loader_impl_handle_path_resolve(handle, paths[iterator], path) != 0 ||
+			filesystem_watcher_add(loader_watcher, path, handle) != 0)
+		{
+			filesystem_watcher_remove(loader_watcher, handle);
+			goto unlock;
+		}
+	}
+
+	vector_push_back_var(loader_watcher_handles, handle);
+
+	result = 0;
+
+unlock:
+	threading_mutex_unlock(&loader_reload_mutex);
+
+	return result;
+}
+
+void loader_watcher_remove(void *handle)
+{
+	size_t iterator;
+
+	if (loader_watcher == NULL)
+	{
+		return;
+	}
+
+	filesystem_watcher_remove(loader_watcher, handle);
+
+	for (iterator = 0; iterator < vector_size(loader_watcher_handles); ++iterator)
+	{
+		if (vector_at_type(loader_watcher_handles, iterator, void *) == handle)
+		{
+			vector_erase(loader_watcher_handles, iterator);
+			break;
+		}
+	}
+}
+
 int loader_clear(void *handle)
 {
-	return loader_impl_clear(handle);
+	int result;
+
+	threading_mutex_lock(&loader_reload_mutex);
+
+	loader_watcher_remove(handle);
+
+	result = loader_impl_clear(handle);
+
+	if (result == 0)
+	{
+		atomic_fetch_add_explicit(&loader_handle_generation, 1, memory_order_release);
+	}
+
+	threading_mutex_unlock(&loader_reload_mutex);
+
+	return result;
+}
+
+size_t loader_generation(void)
+{
+	return atomic_load_explicit(&loader_handle_generation, memory_order_acquire);
+}
+
+int loader_fork(enum loader_impl_fork_id id)
+{
+	loader_manager_impl manager_impl;
+	size_t iterator, size;
+	int result = 0;
+
+	if (loader_manager_initialized != 0)
+	{
+		return 0;
+	}
+
+	manager_impl = plugin_manager_impl_type(&loader_manager, loader_manager_impl);
+
+	if (manager_impl->initialization_order == NULL)
+	{
+		return 0;
+	}
+
+	/* Do not fork in the middle of a reload, the child would inherit the handles half replaced */
+	if (id == LOADER_IMPL_FORK_PREPARE)
+	{
+		threading_mutex_lock(&loader_reload_mutex);
+
+		loader_fork_thread_id = thread_id_get_current();
+	}
+
+	size = vector_size(manager_impl->initialization_order);
+
+	/* The pool of interned strings is locked the last one (once the loaders are ready to fork), so it is released the first one */
+	if (id != LOADER_IMPL_FORK_PREPARE)
+	{
+		intern_fork_release();
+	}
+
+	/* The forking thread has a different id in the child, the loaders initialized by it must be destroyed from the new one */
+	if (id == LOADER_IMPL_FORK_CHILD)
+	{
+		uint64_t current = thread_id_get_current();
+
+		if (manager_impl->init_thread_id == loader_fork_thread_id)
+		{
+			manager_impl->init_thread_id = current;
+		}
+
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			loader_initialization_order order = vector_at(manager_impl->initialization_order, iterator);
+
+			if (order->id == loader_fork_thread_id)
+			{
+				order->id = current;
+			}
+		}
+	}
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		loader_initialization_order order = vector_at(manager_impl->initialization_order, iterator);
+		loader_impl impl;
+
+		if (order->p == NULL || order->p == manager_impl->host)
+		{
+			continue;
+		}
+
+		impl = plugin_impl_type(order->p, loader_impl);
+
+		if (loader_impl_fork(impl, id) == 0 || id != LOADER_IMPL_FORK_CHILD)
+		{
+			continue;
+		}
+
+		/* The runtime did not survive the fork (its threads do not exist in the child), so it cannot
+		* be destroyed either. Detach it from the manager and mark it as destroyed, the next use of
+		* its tag will create and initialize a new instance of the loader */
+		log_write("metacall", LOG_LEVEL_DEBUG, "Loader %s is not fork safe, it will be initialized again on demand", plugin_name(order->p));
+
+		if (plugin_manager_unregister(&loader_manager, order->p) != 0)
+		{
+			result = 1;
+		}
+
+		loader_manager_impl_set_destroyed(manager_impl, impl);
+
+		order->being_deleted = 1;
+		order->p = NULL;
+		order->id = THREAD_ID_INVALID;
+	}
+
+	if (id == LOADER_IMPL_FORK_PREPARE)
+	{
+		intern_fork_prepare();
+	}
+	else
+	{
+		/* The watcher thread does not exist in the child, drop it without joining */
+		if (id == LOADER_IMPL_FORK_CHILD && loader_watcher != NULL)
+		{
+			loader_watcher = NULL;
+
+			vector_destroy(loader_watcher_handles);
+			loader_watcher_handles = NULL;
+		}
+
+		threading_mutex_unlock(&loader_reload_mutex);
+	}
+
+	return result;
 }
 
 int loader_is_destroyed(loader_impl impl)
@@ -767,6 +1170,16 @@ void loader_destroy(void)
 {
 	loader_manager_impl manager_impl = plugin_manager_impl_type(&loader_manager, loader_manager_impl);
 
+	/* Stop watching before destroying the handles, this waits until any reload in progress finishes */
+	if (loader_watcher != NULL)
+	{
+		filesystem_watcher_destroy(loader_watcher);
+		loader_watcher = NULL;
+
+		vector_destroy(loader_watcher_handles);
+		loader_watcher_handles = NULL;
+	}
+
 	/* TODO: Disable logs here until log is completely thread safe and async signal safe */
 	/* log_write("metacall", LOG_LEVEL_DEBUG, "Begin to destroy all the loaders"); */
 
@@ -803,6 +1216,11 @@ void loader_destroy(void)
 
 	plugin_manager_destroy(&loader_manager);
 
+	if (loader_manager_initialized == 0)
+	{
+		threading_mutex_destroy(&loader_reload_mutex);
+	}
+
 	loader_manager_initialized = 1;
 }
 
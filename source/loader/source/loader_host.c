@@ -156,6 +156,9 @@ int loader_host_register(loader_impl host, context ctx, const char *name, loader
 		return 1;
 	}
 
+	/* The function value is stored in the scope, so it must not come from a scoped allocator (i.e an arena) */
+	memory_allocator previous = value_allocator(NULL);
+
 	signature s = function_signature(f);
 
 	if (arg_size > 0)
@@ -189,10 +192,13 @@ int loader_host_register(loader_impl host, context ctx, const char *name, loader
 		if (scope_define(sp, name, v) != 0)
 		{
 			value_type_destroy(v);
+			(void)value_allocator(previous);
 			return 1;
 		}
 	}
 
+	(void)value_allocator(previous);
+
 	if (func != NULL)
 	{
 		*func = f;
@@ -39,6 +39,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <sys/stat.h>
+
 /* -- Macros -- */
 
 #define loader_iface(l) \
@@ -67,10 +69,18 @@ struct loader_impl_metadata_cb_iterator_type;
 
 struct loader_impl_handle_register_cb_iterator_type;
 
+struct loader_impl_handle_retired_type;
+
+struct loader_impl_reload_cb_iterator_type;
+
 /* -- Type Definitions -- */
 
 typedef struct loader_handle_impl_type *loader_handle_impl;
 
+typedef struct loader_impl_handle_retired_type *loader_impl_handle_retired;
+
+typedef struct loader_impl_reload_cb_iterator_type *loader_impl_reload_cb_iterator;
+
 typedef struct loader_impl_metadata_cb_iterator_type *loader_impl_metadata_cb_iterator;
 
 typedef struct loader_impl_handle_register_cb_iterator_type *loader_impl_handle_register_cb_iterator;
@@ -89,6 +99,7 @@ struct loader_impl_type
 	set type_info_map;			   /* Stores a set indexed by type name of all of the types existing in the loader (global scope (TODO: may need refactor per handle)) */
 	void *options;				   /* Additional initialization options passed in the initialize phase */
 	set exec_path_map;			   /* Set of execution paths passed by the end user */
+	vector exec_paths;			   /* Execution paths already loaded into the loader, used for resolving relative paths of the handles */
 };
 
 struct loader_handle_impl_type
@@ -101,6 +112,23 @@ struct loader_handle_impl_type
 	context ctx;				 /* Contains the objects, classes and functions loaded in the handle */
 	int populated;				 /* If it is populated (0), the handle context is also stored in loader context (global scope), otherwise it is private */
 	vector populated_handles;	 /* Vector containing all the references to which this handle has been populated into, it is necessary for detach the symbols when destroying (used in load_from_* when passing an input parameter) */
+	loader_path *paths;			 /* Paths of the files of the handle, only defined when it is loaded from file, used for reloading it */
+	size_t paths_size;			 /* Number of paths of the handle */
+	vector retired;				 /* Previous versions of the handle replaced by a reload, they are kept while their symbols are referenced */
+};
+
+struct loader_impl_handle_retired_type
+{
+	loader_handle module; /* Implementation handle of the previous version */
+	context ctx;		  /* Context of the previous version, it owns the old functions */
+};
+
+struct loader_impl_reload_cb_iterator_type
+{
+	loader_handle_impl handle_impl;
+	context handle_ctx;
+	char *duplicated_key;
+	int populated;
 };
 
 struct loader_impl_handle_register_cb_iterator_type
@@ -127,6 +155,14 @@ static int loader_impl_initialize(plugin_manager manager, plugin p, loader_impl
 
 static loader_handle_impl loader_impl_load_handle(loader_impl impl, loader_impl_interface iface, loader_handle module, const char *path, size_t size);
 
+static int loader_impl_load_from_file_heap(plugin_manager manager, plugin p, loader_impl impl, const loader_path paths[], size_t size, void **handle_ptr);
+
+static int loader_impl_load_from_memory_heap(plugin_manager manager, plugin p, loader_impl impl, const char *buffer, size_t size, void **handle_ptr);
+
+static int loader_impl_load_from_package_heap(plugin_manager manager, plugin p, loader_impl impl, const loader_path path, void **handle_ptr);
+
+static int loader_impl_reload_heap(plugin_manager manager, void *handle);
+
 static int loader_impl_handle_init(loader_impl impl, const char *path, loader_handle_impl handle_impl, void **handle_ptr, int populated);
 
 static int loader_impl_handle_register_cb_iterate(plugin_manager manager, plugin p, void *data);
@@ -147,6 +183,10 @@ static int loader_impl_metadata_cb_iterate(set s, set_key key, set_value val, se
 
 static void loader_impl_destroy_handle(loader_handle_impl handle_impl);
 
+static void loader_impl_destroy_handle_retired(loader_handle_impl handle_impl, int force);
+
+static int loader_impl_reload_cb_iterate(plugin_manager manager, plugin p, void *data);
+
 static int loader_impl_destroy_type_map_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
 
 /* -- Private Member Data -- */
@@ -209,8 +249,17 @@ loader_impl loader_impl_allocate(const loader_tag tag)
 		goto alloc_exec_path_map_error;
 	}
 
+	impl->exec_paths = vector_create(sizeof(loader_path));
+
+	if (impl->exec_paths == NULL)
+	{
+		goto alloc_exec_paths_error;
+	}
+
 	return impl;
 
+alloc_exec_paths_error:
+	set_destroy(impl->exec_path_map);
 alloc_exec_path_map_error:
 	context_destroy(impl->ctx);
 alloc_ctx_error:
@@ -535,6 +584,9 @@ loader_handle_impl loader_impl_load_handle(loader_impl impl, loader_impl_interfa
 	handle_impl->iface = iface;
 	strncpy(handle_impl->path, path, size);
 	handle_impl->module = module;
+	handle_impl->paths = NULL;
+	handle_impl->paths_size = 0;
+	handle_impl->retired = NULL;
 	handle_impl->ctx = context_create(handle_impl->path);
 
 	if (handle_impl->ctx == NULL)
@@ -585,6 +637,8 @@ void loader_impl_destroy_handle(loader_handle_impl handle_impl)
 			}
 		}
 
+		loader_impl_destroy_handle_retired(handle_impl, 1);
+
 		if (handle_impl->populated == 0)
 		{
 			context_remove(handle_impl->impl->ctx, handle_impl->ctx);
@@ -604,6 +658,12 @@ void loader_impl_destroy_handle(loader_handle_impl handle_impl)
 
 		context_destroy(handle_impl->ctx);
 		vector_destroy(handle_impl->populated_handles);
+
+		if (handle_impl->paths != NULL)
+		{
+			free(handle_impl->paths);
+		}
+
 		handle_impl->magic = (uintptr_t)loader_handle_impl_magic_free;
 
 		free(handle_impl);
@@ -621,7 +681,20 @@ int loader_impl_execution_path(plugin p, loader_impl impl, const loader_path pat
 
 			if (iface != NULL)
 			{
-				return iface->execution_path(impl, path);
+				loader_path exec_path;
+
+				if (iface->execution_path(impl, path) != 0)
+				{
+					return 1;
+				}
+
+				/* Keep track of the execution path so relative paths of the handles can be resolved later on */
+				strncpy(exec_path, path, LOADER_PATH_SIZE - 1);
+				exec_path[LOADER_PATH_SIZE - 1] = '\0';
+
+				vector_push_back(impl->exec_paths, exec_path);
+
+				return 0;
 			}
 		}
 		else
@@ -801,7 +874,7 @@ size_t loader_impl_handle_name(plugin_manager manager, const loader_path path, l
 	return length;
 }
 
-int loader_impl_load_from_file(plugin_manager manager, plugin p, loader_impl impl, const loader_path paths[], size_t size, void **handle_ptr)
+int loader_impl_load_from_file_heap(plugin_manager manager, plugin p, loader_impl impl, const loader_path paths[], size_t size, void **handle_ptr)
 {
 	if (impl != NULL)
 	{
@@ -855,6 +928,15 @@ int loader_impl_load_from_file(plugin_manager manager, plugin p, loader_impl imp
 				{
 					handle_impl->populated = 1;
 
+					/* Keep the paths so the handle can be reloaded later on */
+					handle_impl->paths = malloc(sizeof(loader_path) * size);
+
+					if (handle_impl->paths != NULL)
+					{
+						memcpy(handle_impl->paths, paths, sizeof(loader_path) * size);
+						handle_impl->paths_size = size;
+					}
+
 					if (set_insert(impl->handle_impl_path_map, handle_impl->path, handle_impl) == 0)
 					{
 						if (set_insert(impl->handle_impl_map, handle_impl->module, handle_impl) == 0)
@@ -912,6 +994,18 @@ int loader_impl_load_from_file(plugin_manager manager, plugin p, loader_impl imp
 	return 1;
 }
 
+int loader_impl_load_from_file(plugin_manager manager, plugin p, loader_impl impl, const loader_path paths[], size_t size, void **handle_ptr)
+{
+	/* The handle outlives the caller, so the values of the loader must not come from a scoped allocator (i.e an arena) */
+	memory_allocator previous = value_allocator(NULL);
+
+	int result = loader_impl_load_from_file_heap(manager, p, impl, paths, size, handle_ptr);
+
+	(void)value_allocator(previous);
+
+	return result;
+}
+
 int loader_impl_load_from_memory_name(loader_impl impl, loader_name name, const char *buffer, size_t size)
 {
 	/* TODO: Improve name with time or uuid */
@@ -934,7 +1028,7 @@ int loader_impl_load_from_memory_name(loader_impl impl, loader_name name, const
 	return 1;
 }
 
-int loader_impl_load_from_memory(plugin_manager manager, plugin p, loader_impl impl, const char *buffer, size_t size, void **handle_ptr)
+int loader_impl_load_from_memory_heap(plugin_manager manager, plugin p, loader_impl impl, const char *buffer, size_t size, void **handle_ptr)
 {
 	if (impl != NULL && buffer != NULL && size > 0)
 	{
@@ -1042,7 +1136,18 @@ int loader_impl_load_from_memory(plugin_manager manager, plugin p, loader_impl i
 	return 1;
 }
 
-int loader_impl_load_from_package(plugin_manager manager, plugin p, loader_impl impl, const loader_path path, void **handle_ptr)
+int loader_impl_load_from_memory(plugin_manager manager, plugin p, loader_impl impl, const char *buffer, size_t size, void **handle_ptr)
+{
+	memory_allocator previous = value_allocator(NULL);
+
+	int result = loader_impl_load_from_memory_heap(manager, p, impl, buffer, size, handle_ptr);
+
+	(void)value_allocator(previous);
+
+	return result;
+}
+
+int loader_impl_load_from_package_heap(plugin_manager manager, plugin p, loader_impl impl, const loader_path path, void **handle_ptr)
 {
 	if (impl != NULL)
 	{
@@ -1140,6 +1245,17 @@ int loader_impl_load_from_package(plugin_manager manager, plugin p, loader_impl
 	return 1;
 }
 
+int loader_impl_load_from_package(plugin_manager manager, plugin p, loader_impl impl, const loader_path path, void **handle_ptr)
+{
+	memory_allocator previous = value_allocator(NULL);
+
+	int result = loader_impl_load_from_package_heap(manager, p, impl, path, handle_ptr);
+
+	(void)value_allocator(previous);
+
+	return result;
+}
+
 void *loader_impl_get_handle(loader_impl impl, const char *name)
 {
 	if (impl != NULL && name != NULL)
@@ -1236,6 +1352,281 @@ int loader_impl_handle_initialize(plugin_manager manager, plugin p, loader_impl
 	return 1;
 }
 
+void loader_impl_destroy_handle_retired(loader_handle_impl handle_impl, int force)
+{
+	static const char func_fini_name[] = LOADER_IMPL_FUNCTION_FINI;
+	size_t iterator;
+
+	if (handle_impl->retired == NULL)
+	{
+		return;
+	}
+
+	/* Destroy the previous versions from the newest to the oldest one, unless forced
+	* only the ones whose functions, classes and objects are not referenced anymore
+	*/
+	for (iterator = vector_size(handle_impl->retired); iterator > 0; --iterator)
+	{
+		loader_impl_handle_retired retired = vector_at(handle_impl->retired, iterator - 1);
+
+		if (force == 0 && context_references(retired->ctx) > 0)
+		{
+			continue;
+		}
+
+		if (handle_impl->impl->init == 0)
+		{
+			if (loader_impl_function_hook_call(retired->ctx, func_fini_name) != 0)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Error when calling destructor from retired handle: %p (%s)", (void *)retired->module, func_fini_name);
+			}
+
+			if (retired->module != NULL && handle_impl->iface->clear(handle_impl->impl, retired->module) != 0)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Error when clearing retired handle: %p", (void *)retired->module);
+			}
+		}
+
+		context_destroy(retired->ctx);
+
+		vector_erase(handle_impl->retired, iterator - 1);
+	}
+
+	if (force != 0)
+	{
+		vector_destroy(handle_impl->retired);
+
+		handle_impl->retired = NULL;
+	}
+}
+
+int loader_impl_reload_cb_iterate(plugin_manager manager, plugin p, void *data)
+{
+	loader_impl impl = plugin_impl_type(p, loader_impl);
+	loader_impl_reload_cb_iterator iterator = (loader_impl_reload_cb_iterator)data;
+	size_t handle_iterator;
+
+	(void)manager;
+
+	/* The symbols of the previous version are in its own loader context, they are checked when replacing */
+	if (impl != iterator->handle_impl->impl && context_contains(impl->ctx, iterator->handle_ctx, &iterator->duplicated_key) == 0)
+	{
+		return 1;
+	}
+
+	/* Find if other handles have been populated into the reloaded handle */
+	for (handle_iterator = 0; handle_iterator < vector_size(impl->handle_impl_init_order); ++handle_iterator)
+	{
+		loader_handle_impl handle_impl = vector_at_type(impl->handle_impl_init_order, handle_iterator, loader_handle_impl);
+		size_t populated_iterator;
+
+		if (handle_impl == NULL)
+		{
+			continue;
+		}
+
+		for (populated_iterator = 0; populated_iterator < vector_size(handle_impl->populated_handles); ++populated_iterator)
+		{
+			if (vector_at_type(handle_impl->populated_handles, populated_iterator, loader_handle_impl) == iterator->handle_impl)
+			{
+				iterator->populated = 0;
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int loader_impl_reload_heap(plugin_manager manager, void *handle)
+{
+	static const char func_init_name[] = LOADER_IMPL_FUNCTION_INIT;
+	loader_handle_impl handle_impl = handle;
+	struct loader_impl_reload_cb_iterator_type iterator;
+	struct loader_impl_handle_retired_type retired;
+	loader_impl impl;
+	loader_handle module;
+	context ctx;
+
+	if (loader_impl_handle_validate(handle) != 0)
+	{
+		return 1;
+	}
+
+	impl = handle_impl->impl;
+
+	if (handle_impl->paths == NULL || handle_impl->paths_size == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Reload of handle %s failed, only handles loaded from file can be reloaded", handle_impl->path);
+		return 1;
+	}
+
+	if (vector_size(handle_impl->populated_handles) > 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Reload of handle %s failed, handles populated into other handles cannot be reloaded", handle_impl->path);
+		return 1;
+	}
+
+	if (handle_impl->retired == NULL)
+	{
+		handle_impl->retired = vector_create(sizeof(struct loader_impl_handle_retired_type));
+
+		if (handle_impl->retired == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Reload of handle %s failed, invalid allocation of the previous versions", handle_impl->path);
+			return 1;
+		}
+	}
+	else
+	{
+		/* Release the previous versions which are not referenced anymore, they have been replaced
+		* at least since the last reload, so a function looked up before its swap is already in flight
+		*/
+		loader_impl_destroy_handle_retired(handle_impl, 0);
+	}
+
+	module = handle_impl->iface->load_from_file(impl, (const loader_path *)handle_impl->paths, handle_impl->paths_size);
+
+	if (module == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Reload of handle %s failed, the previous version will be kept", handle_impl->path);
+		return 1;
+	}
+
+	/* Discover into a fresh context, the current version keeps serving calls meanwhile */
+	ctx = context_create(handle_impl->path);
+
+	if (ctx == NULL)
+	{
+		goto error_context;
+	}
+
+	if (handle_impl->iface->discover(impl, module, ctx) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Reload of handle %s failed, invalid discover", handle_impl->path);
+		goto error_discover;
+	}
+
+	iterator.handle_impl = handle_impl;
+	iterator.handle_ctx = ctx;
+	iterator.duplicated_key = NULL;
+	iterator.populated = 1;
+
+	if (handle_impl->populated == 0)
+	{
+		plugin_manager_iterate(manager, &loader_impl_reload_cb_iterate, &iterator);
+	}
+
+	if (iterator.populated == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Reload of handle %s failed, handles populated into it cannot be reloaded", handle_impl->path);
+		goto error_discover;
+	}
+
+	if (iterator.duplicated_key != NULL ||
+		(handle_impl->populated == 0 && context_replace(impl->ctx, handle_impl->ctx, ctx, &iterator.duplicated_key) != 0))
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Reload of handle %s failed, duplicated symbol found named '%s' already defined in the global scope", handle_impl->path, iterator.duplicated_key ? iterator.duplicated_key : "");
+		goto error_discover;
+	}
+
+	if (set_insert(impl->handle_impl_map, module, handle_impl) != 0)
+	{
+		/* Undo the replacement so the global scope does not point to the new version */
+		if (handle_impl->populated == 0)
+		{
+			context_replace(impl->ctx, ctx, handle_impl->ctx, NULL);
+		}
+
+		goto error_discover;
+	}
+
+	set_remove(impl->handle_impl_map, handle_impl->module);
+
+	/* Retire the previous version, calls in flight and values of its functions hold a reference to them, so it
+	* is kept until they are released, the raw functions obtained from it (i.e. metacall_function) are only valid
+	* until the next reload, as it is signaled by the generation counter
+	*/
+	retired.module = handle_impl->module;
+	retired.ctx = handle_impl->ctx;
+
+	vector_push_back(handle_impl->retired, &retired);
+
+	handle_impl->module = module;
+	handle_impl->ctx = ctx;
+
+	if (loader_impl_function_hook_call(ctx, func_init_name) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Error when calling to init hook function (" LOADER_IMPL_FUNCTION_INIT ") of reloaded handle: %s", handle_impl->path);
+	}
+
+	return 0;
+
+error_discover:
+	context_destroy(ctx);
+error_context:
+	if (handle_impl->iface->clear(impl, module) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Error when clearing the reloaded handle: %s", handle_impl->path);
+	}
+
+	return 1;
+}
+
+int loader_impl_reload(plugin_manager manager, void *handle)
+{
+	memory_allocator previous = value_allocator(NULL);
+
+	int result = loader_impl_reload_heap(manager, handle);
+
+	(void)value_allocator(previous);
+
+	return result;
+}
+
+size_t loader_impl_handle_retired_size(void *handle)
+{
+	loader_handle_impl handle_impl = handle;
+
+	return handle_impl->retired != NULL ? vector_size(handle_impl->retired) : 0;
+}
+
+const loader_path *loader_impl_handle_paths(void *handle, size_t *size)
+{
+	loader_handle_impl handle_impl = handle;
+
+	*size = handle_impl->paths_size;
+
+	return (const loader_path *)handle_impl->paths;
+}
+
+int loader_impl_handle_path_resolve(void *handle, const loader_path path, loader_path result)
+{
+	loader_handle_impl handle_impl = handle;
+	size_t path_size = strnlen(path, LOADER_PATH_SIZE) + 1;
+
+	/* Loaders search relative paths in their execution paths, so the first one that exists is the loaded one */
+	if (portability_path_is_absolute(path, path_size) != 0)
+	{
+		size_t iterator, size = vector_size(handle_impl->impl->exec_paths);
+
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			char *exec_path = vector_at(handle_impl->impl->exec_paths, iterator);
+			loader_path join_path;
+			struct stat path_stat;
+			size_t join_path_size = portability_path_join(exec_path, strnlen(exec_path, LOADER_PATH_SIZE) + 1, path, path_size, join_path, LOADER_PATH_SIZE);
+
+			if (stat(join_path, &path_stat) == 0)
+			{
+				return portability_path_canonical(join_path, join_path_size, result, LOADER_PATH_SIZE) == 0;
+			}
+		}
+	}
+
+	return portability_path_canonical(path, path_size, result, LOADER_PATH_SIZE) == 0;
+}
+
 vector loader_impl_handle_populated(void *handle)
 {
 	loader_handle_impl handle_impl = handle;
@@ -1417,6 +1808,72 @@ value loader_impl_metadata(loader_impl impl)
 	return v;
 }
 
+value loader_impl_metrics(loader_impl impl)
+{
+	static const char total_str[] = "total";
+	static const char functions_str[] = "functions";
+
+	struct metrics_snapshot_type total;
+	value *v_map, v, functions, tuple;
+	scope sp = context_scope(impl->ctx);
+
+	memset(&total, 0, sizeof(struct metrics_snapshot_type));
+
+	/* The loader scope holds the functions of all the handles, so the
+	* loader latency is the merge of the histograms of its functions
+	*/
+	functions = scope_metrics(sp, &total);
+
+	if (functions == NULL)
+	{
+		return NULL;
+	}
+
+	v = value_create_map(NULL, 2);
+
+	if (v == NULL)
+	{
+		value_type_destroy(functions);
+		return NULL;
+	}
+
+	v_map = value_to_map(v);
+
+	tuple = value_create_array(NULL, 2);
+
+	if (tuple == NULL)
+	{
+		value_type_destroy(functions);
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	v_map[0] = tuple;
+	value_to_array(tuple)[0] = value_create_string(total_str, sizeof(total_str) - 1);
+	value_to_array(tuple)[1] = metrics_value(&total);
+
+	tuple = value_create_array(NULL, 2);
+
+	if (tuple == NULL)
+	{
+		value_type_destroy(functions);
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	v_map[1] = tuple;
+	value_to_array(tuple)[0] = value_create_string(functions_str, sizeof(functions_str) - 1);
+	value_to_array(tuple)[1] = functions;
+
+	if (value_to_array(v_map[0])[0] == NULL || value_to_array(v_map[0])[1] == NULL || value_to_array(v_map[1])[0] == NULL)
+	{
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	return v;
+}
+
 int loader_impl_clear(void *handle)
 {
 	if (handle != NULL)
@@ -1453,6 +1910,31 @@ int loader_impl_clear(void *handle)
 	return 1;
 }
 
+int loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id)
+{
+	loader_impl_interface iface;
+
+	/* Not initialized yet, there is no runtime state to preserve */
+	if (impl->init != 0)
+	{
+		return 0;
+	}
+
+	iface = loader_iface(impl->p);
+
+	if (iface->fork == NULL)
+	{
+		return 1;
+	}
+
+	return iface->fork(impl, id);
+}
+
+int loader_impl_multithread(loader_impl impl)
+{
+	return loader_iface(impl->p)->multithread != 0;
+}
+
 int loader_impl_destroy_type_map_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args)
 {
 	(void)s;
@@ -1537,6 +2019,8 @@ void loader_impl_destroy_deallocate(loader_impl impl)
 
 	set_destroy(impl->exec_path_map);
 
+	vector_destroy(impl->exec_paths);
+
 	context_destroy(impl->ctx);
 
 	free(impl);
@@ -45,6 +45,8 @@ C_LOADER_API int c_loader_impl_discover(loader_impl impl, loader_handle handle,
 
 C_LOADER_API int c_loader_impl_destroy(loader_impl impl);
 
+C_LOADER_API int c_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id);
+
 #ifdef __cplusplus
 }
 #endif
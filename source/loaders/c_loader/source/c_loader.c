@@ -33,7 +33,9 @@ loader_impl_interface c_loader_impl_interface_singleton(void)
 		&c_loader_impl_load_from_package,
 		&c_loader_impl_clear,
 		&c_loader_impl_discover,
-		&c_loader_impl_destroy
+		&c_loader_impl_destroy,
+		&c_loader_impl_fork,
+		0
 	};
 
 	return &loader_impl_interface_c;
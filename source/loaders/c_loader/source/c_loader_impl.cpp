@@ -1289,3 +1289,12 @@ int c_loader_impl_destroy(loader_impl impl)
 
 	return 1;
 }
+
+int c_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id)
+{
+	(void)impl;
+	(void)id;
+
+	/* Compiled functions and their libffi closures are plain memory, they remain valid in the child */
+	return 0;
+}
@@ -47,6 +47,8 @@ EXT_LOADER_API int ext_loader_impl_discover(loader_impl impl, loader_handle hand
 
 EXT_LOADER_API int ext_loader_impl_destroy(loader_impl impl);
 
+EXT_LOADER_API int ext_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id);
+
 #ifdef __cplusplus
 }
 #endif
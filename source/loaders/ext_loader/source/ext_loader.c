@@ -33,7 +33,9 @@ loader_impl_interface ext_loader_impl_interface_singleton(void)
 		&ext_loader_impl_load_from_package,
 		&ext_loader_impl_clear,
 		&ext_loader_impl_discover,
-		&ext_loader_impl_destroy
+		&ext_loader_impl_destroy,
+		&ext_loader_impl_fork,
+		0
 	};
 
 	return &loader_impl_interface_ext;
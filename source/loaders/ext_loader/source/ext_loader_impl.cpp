@@ -58,6 +58,7 @@ typedef struct loader_impl_ext_handle_lib_type
 	std::string name;
 	dynlink handle;
 	dynlink_symbol_addr addr;
+	dynlink_symbol_addr destroy_addr; /* Optional, called before the extension is unloaded */
 
 } * loader_impl_ext_handle_lib;
 
@@ -80,10 +81,17 @@ union loader_impl_function_cast
 	int (*fn)(void *, void *);
 };
 
+union loader_impl_destroy_cast
+{
+	void *ptr;
+	int (*fn)(void);
+};
+
 static dynlink ext_loader_impl_load_from_file_dynlink(const char *path, const char *library_name);
 static dynlink ext_loader_impl_load_from_file_dynlink(loader_impl_ext ext_impl, const loader_path path);
 static int ext_loader_impl_load_from_file_handle(loader_impl_ext ext_impl, loader_impl_ext_handle ext_handle, const loader_path path);
 static void ext_loader_impl_destroy_handle(loader_impl_ext_handle ext_handle);
+static void ext_loader_impl_unload(loader_impl_ext_handle_lib ext_handle_lib);
 
 int ext_loader_impl_initialize_types(loader_impl impl)
 {
@@ -204,7 +212,7 @@ int ext_loader_impl_load_from_file_handle(loader_impl_ext ext_impl, loader_impl_
 	if (iterator != ext_impl->destroy_list.end())
 	{
 		log_write("metacall", LOG_LEVEL_DEBUG, "Unloading handle: %s <%p>", iterator->second.name.c_str(), iterator->second.handle);
-		dynlink_unload(iterator->second.handle);
+		ext_loader_impl_unload(&iterator->second);
 		ext_impl->destroy_list.erase(path);
 	}
 
@@ -231,7 +239,16 @@ int ext_loader_impl_load_from_file_handle(loader_impl_ext ext_impl, loader_impl_
 		return 1;
 	}
 
-	loader_impl_ext_handle_lib_type ext_handle_lib = { path, lib, symbol_address };
+	/* Extensions holding state can export <name>_destroy in order to release it before being unloaded */
+	dynlink_symbol_addr destroy_address = NULL;
+	std::string destroy_name = symbol_name + "_destroy";
+
+	if (dynlink_symbol(lib, destroy_name.c_str(), &destroy_address) != 0)
+	{
+		destroy_address = NULL;
+	}
+
+	loader_impl_ext_handle_lib_type ext_handle_lib = { path, lib, symbol_address, destroy_address };
 
 	ext_handle->extensions.push_back(ext_handle_lib);
 
@@ -307,13 +324,30 @@ void ext_loader_impl_destroy_handle(loader_impl_ext_handle ext_handle)
 	{
 		if (ext.handle != NULL)
 		{
-			dynlink_unload(ext.handle);
+			ext_loader_impl_unload(&ext);
 		}
 	}
 
 	delete ext_handle;
 }
 
+void ext_loader_impl_unload(loader_impl_ext_handle_lib ext_handle_lib)
+{
+	if (ext_handle_lib->destroy_addr != NULL)
+	{
+		loader_impl_destroy_cast destroy_cast;
+
+		destroy_cast.ptr = static_cast<void *>(ext_handle_lib->destroy_addr);
+
+		if (destroy_cast.fn() != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Failed to destroy extension: %s", ext_handle_lib->name.c_str());
+		}
+	}
+
+	dynlink_unload(ext_handle_lib->handle);
+}
+
 int ext_loader_impl_clear(loader_impl impl, loader_handle handle)
 {
 	loader_impl_ext ext_impl = static_cast<loader_impl_ext>(loader_impl_get(impl));
@@ -378,7 +412,7 @@ int ext_loader_impl_destroy(loader_impl impl)
 			for (auto iterator : ext_impl->destroy_list)
 			{
 				log_write("metacall", LOG_LEVEL_DEBUG, "Unloading handle: %s <%p>", iterator.second.name.c_str(), iterator.second.handle);
-				dynlink_unload(iterator.second.handle);
+				ext_loader_impl_unload(&iterator.second);
 			}
 		}
 
@@ -389,3 +423,12 @@ int ext_loader_impl_destroy(loader_impl impl)
 
 	return 1;
 }
+
+int ext_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id)
+{
+	(void)impl;
+	(void)id;
+
+	/* Extensions are shared libraries mapped into the process, they remain valid in the child */
+	return 0;
+}
@@ -47,6 +47,8 @@ FILE_LOADER_API int file_loader_impl_discover(loader_impl impl, loader_handle ha
 
 FILE_LOADER_API int file_loader_impl_destroy(loader_impl impl);
 
+FILE_LOADER_API int file_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,7 @@
 
 #include <log/log.h>
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -79,9 +80,26 @@ typedef struct stat file_stat_type;
 	#if defined(_POSIX_VERSION)
 		#define FILE_LOADER_GLOB_SUPPORT 1
 		#include <glob.h>
+
+		/* Support for mapping the files into memory (TODO: Implement Windows support) */
+		#define FILE_LOADER_MMAP_SUPPORT 1
+		#include <fcntl.h>
+		#include <sys/mman.h>
 	#endif
 #endif
 
+#define FILE_LOADER_IMPL_MMAP	  "FILE_LOADER_MMAP"
+#define FILE_LOADER_IMPL_MADVISE  "FILE_LOADER_MADVISE"
+#define FILE_LOADER_IMPL_POPULATE "FILE_LOADER_POPULATE"
+
+enum file_loader_impl_advice_id
+{
+	FILE_LOADER_IMPL_ADVICE_NORMAL,
+	FILE_LOADER_IMPL_ADVICE_SEQUENTIAL,
+	FILE_LOADER_IMPL_ADVICE_RANDOM,
+	FILE_LOADER_IMPL_ADVICE_WILLNEED
+};
+
 typedef struct loader_impl_file_descriptor_type
 {
 	loader_path path;
@@ -92,6 +110,9 @@ typedef struct loader_impl_file_descriptor_type
 typedef struct loader_impl_file_type
 {
 	vector execution_paths;
+	int mmap;
+	int populate;
+	enum file_loader_impl_advice_id advice;
 
 } * loader_impl_file;
 
@@ -103,6 +124,7 @@ typedef struct loader_impl_file_handle_type
 
 typedef struct loader_impl_file_function_type
 {
+	loader_impl_file file_impl;
 	loader_impl_file_descriptor descriptor;
 
 } * loader_impl_file_function;
@@ -112,6 +134,9 @@ static int file_loader_impl_load_path(loader_impl_file_handle handle, const load
 static int file_loader_impl_load_glob(loader_impl_file_handle handle, const loader_path path, size_t path_size);
 #endif
 static int file_loader_impl_load_execution_path(loader_impl_file file_impl, loader_impl_file_handle handle, const loader_path path);
+static int file_loader_impl_env_flag(const char *name);
+static enum file_loader_impl_advice_id file_loader_impl_env_advice(const char *name);
+static value file_loader_impl_read(loader_impl_file file_impl, loader_impl_file_descriptor descriptor);
 
 int function_file_interface_create(function func, function_impl impl)
 {
@@ -129,6 +154,11 @@ function_return function_file_interface_invoke(function func, function_impl impl
 	(void)args;
 	(void)size;
 
+	if (file_function->file_impl->mmap == 0)
+	{
+		return file_loader_impl_read(file_function->file_impl, file_function->descriptor);
+	}
+
 	return value_create_string(file_function->descriptor->path, file_function->descriptor->length);
 }
 
@@ -179,6 +209,7 @@ int file_loader_impl_initialize_types(loader_impl impl)
 		const char *name;
 	} type_id_name_pair[] = {
 		{ TYPE_STRING, "File" },
+		{ TYPE_BUFFER, "Buffer" },
 	};
 
 	size_t index, size = sizeof(type_id_name_pair) / sizeof(type_id_name_pair[0]);
@@ -230,12 +261,209 @@ loader_impl_data file_loader_impl_initialize(loader_impl impl, configuration con
 		return NULL;
 	}
 
+	/* Expose the contents of the files as read only buffers instead of their paths */
+	file_impl->mmap = file_loader_impl_env_flag(FILE_LOADER_IMPL_MMAP);
+	file_impl->populate = file_loader_impl_env_flag(FILE_LOADER_IMPL_POPULATE);
+	file_impl->advice = file_loader_impl_env_advice(FILE_LOADER_IMPL_MADVISE);
+
 	/* Register initialization */
 	loader_initialization_register(impl);
 
 	return (loader_impl_data)file_impl;
 }
 
+int file_loader_impl_env_flag(const char *name)
+{
+	static const char *enabled[] = { "1", "on", "true", "yes" };
+	const char *env = getenv(name);
+	char flag[sizeof("true")];
+	size_t iterator, length;
+
+	if (env == NULL)
+	{
+		return 1;
+	}
+
+	length = strnlen(env, sizeof(flag));
+
+	if (length == sizeof(flag))
+	{
+		return 1;
+	}
+
+	for (iterator = 0; iterator <= length; ++iterator)
+	{
+		flag[iterator] = (char)tolower((unsigned char)env[iterator]);
+	}
+
+	for (iterator = 0; iterator < sizeof(enabled) / sizeof(enabled[0]); ++iterator)
+	{
+		if (strcmp(flag, enabled[iterator]) == 0)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+enum file_loader_impl_advice_id file_loader_impl_env_advice(const char *name)
+{
+	static const struct
+	{
+		const char *name;
+		enum file_loader_impl_advice_id id;
+	} advice_name_pair[] = {
+		{ "sequential", FILE_LOADER_IMPL_ADVICE_SEQUENTIAL },
+		{ "random", FILE_LOADER_IMPL_ADVICE_RANDOM },
+		{ "willneed", FILE_LOADER_IMPL_ADVICE_WILLNEED }
+	};
+
+	const char *env = getenv(name);
+	size_t iterator;
+
+	if (env != NULL)
+	{
+		for (iterator = 0; iterator < sizeof(advice_name_pair) / sizeof(advice_name_pair[0]); ++iterator)
+		{
+			if (strcmp(env, advice_name_pair[iterator].name) == 0)
+			{
+				return advice_name_pair[iterator].id;
+			}
+		}
+	}
+
+	return FILE_LOADER_IMPL_ADVICE_NORMAL;
+}
+
+#if defined(FILE_LOADER_MMAP_SUPPORT)
+static void file_loader_impl_unmap(value v, void *data)
+{
+	size_t length = (size_t)(uintptr_t)data;
+
+	if (munmap(value_to_buffer(v), length) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File loader failed to unmap a buffer of %" PRIuS " bytes", length);
+	}
+}
+
+static value file_loader_impl_map(loader_impl_file file_impl, loader_impl_file_descriptor descriptor, int fd, size_t length)
+{
+	int flags = MAP_PRIVATE;
+	void *addr;
+	value v;
+
+	#if defined(MAP_POPULATE)
+	if (file_impl->populate == 0)
+	{
+		/* Fault in the whole file now instead of on first access */
+		flags |= MAP_POPULATE;
+	}
+	#endif
+
+	addr = mmap(NULL, length, PROT_READ, flags, fd, 0);
+
+	if (addr == MAP_FAILED)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File loader failed to map file: %s", descriptor->path);
+		return NULL;
+	}
+
+	switch (file_impl->advice)
+	{
+		case FILE_LOADER_IMPL_ADVICE_SEQUENTIAL: {
+			(void)madvise(addr, length, MADV_SEQUENTIAL);
+			break;
+		}
+		case FILE_LOADER_IMPL_ADVICE_RANDOM: {
+			(void)madvise(addr, length, MADV_RANDOM);
+			break;
+		}
+		case FILE_LOADER_IMPL_ADVICE_WILLNEED: {
+			(void)madvise(addr, length, MADV_WILLNEED);
+			break;
+		}
+		default: {
+			break;
+		}
+	}
+
+	v = value_create_buffer_borrowed(addr, length);
+
+	if (v == NULL)
+	{
+		munmap(addr, length);
+		return NULL;
+	}
+
+	/* The mapping lives as long as the value does */
+	value_finalizer(v, &file_loader_impl_unmap, (void *)(uintptr_t)length);
+
+	return v;
+}
+#endif
+
+value file_loader_impl_read(loader_impl_file file_impl, loader_impl_file_descriptor descriptor)
+{
+#if defined(FILE_LOADER_MMAP_SUPPORT)
+	file_stat_type fs;
+	value v = NULL;
+	int fd = open(descriptor->path, O_RDONLY);
+
+	if (fd == -1)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File loader failed to open file: %s", descriptor->path);
+		return NULL;
+	}
+
+	if (fstat(fd, &fs) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File loader failed to stat file: %s", descriptor->path);
+	}
+	else if (fs.st_size == 0)
+	{
+		/* Empty files cannot be mapped */
+		v = value_create_buffer(NULL, 0);
+	}
+	else
+	{
+		v = file_loader_impl_map(file_impl, descriptor, fd, (size_t)fs.st_size);
+	}
+
+	/* The mapping keeps its own reference to the file */
+	close(fd);
+
+	return v;
+#else
+	FILE *file = fopen(descriptor->path, "rb");
+	value v = NULL;
+	long length;
+
+	(void)file_impl;
+
+	if (file == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "File loader failed to open file: %s", descriptor->path);
+		return NULL;
+	}
+
+	if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0)
+	{
+		v = value_create_buffer(NULL, (size_t)length);
+
+		if (v != NULL && fread(value_to_buffer(v), 1, (size_t)length, file) != (size_t)length)
+		{
+			value_type_destroy(v);
+			v = NULL;
+		}
+	}
+
+	fclose(file);
+
+	return v;
+#endif
+}
+
 int file_loader_impl_execution_path(loader_impl impl, const loader_path path)
 {
 	loader_impl_file file_impl = loader_impl_get(impl);
@@ -511,8 +739,6 @@ int file_loader_impl_discover(loader_impl impl, loader_handle handle, context ct
 
 	size_t iterator, size = vector_size(file_handle->paths);
 
-	(void)file_impl;
-
 	log_write("metacall", LOG_LEVEL_DEBUG, "File module %p discovering", handle);
 
 	for (iterator = 0; iterator < size; ++iterator)
@@ -529,6 +755,7 @@ int file_loader_impl_discover(loader_impl impl, loader_handle handle, context ct
 			signature s;
 			value v;
 
+			file_function->file_impl = file_impl;
 			file_function->descriptor = descriptor;
 
 			if (script_path != NULL)
@@ -550,7 +777,7 @@ int file_loader_impl_discover(loader_impl impl, loader_handle handle, context ct
 
 			s = function_signature(f);
 
-			signature_set_return(s, loader_impl_type(impl, "Path"));
+			signature_set_return(s, loader_impl_type(impl, file_impl->mmap == 0 ? "Buffer" : "Path"));
 
 			v = value_create_function(f);
 
@@ -586,3 +813,12 @@ int file_loader_impl_destroy(loader_impl impl)
 
 	return 1;
 }
+
+int file_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id)
+{
+	(void)impl;
+	(void)id;
+
+	/* Files are only tracked by path, there is nothing to do across the fork */
+	return 0;
+}
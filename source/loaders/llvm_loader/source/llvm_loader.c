@@ -33,7 +33,9 @@ loader_impl_interface llvm_loader_impl_interface_singleton(void)
 		&llvm_loader_impl_load_from_package,
 		&llvm_loader_impl_clear,
 		&llvm_loader_impl_discover,
-		&llvm_loader_impl_destroy
+		&llvm_loader_impl_destroy,
+		NULL,
+		0
 	};
 
 	return &loader_impl_interface_llvm;
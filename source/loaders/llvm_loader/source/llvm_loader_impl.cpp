@@ -32,6 +32,18 @@
 
 #include <log/log.h>
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <ffi.h>
+
 /* Disable warnings from LLVM */
 #if defined(_MSC_VER)
 	#pragma warning(push)
@@ -40,28 +52,38 @@
 	#pragma clang diagnostic push
 	#pragma clang diagnostic ignored "-Wunused-parameter"
 	#pragma clang diagnostic ignored "-Wredundant-decls"
+	#pragma clang diagnostic ignored "-Wredundant-move"
 #elif defined(__GNUC__)
 	#pragma GCC diagnostic push
 	#pragma GCC diagnostic ignored "-Wunused-parameter"
 	#pragma GCC diagnostic ignored "-Wredundant-decls"
+	#pragma GCC diagnostic ignored "-Wredundant-move"
 #endif
 
 // LLVM
-#include <llvm/ExecutionEngine/ExecutionEngine.h>
-#include <llvm/ExecutionEngine/GenericValue.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 #include <llvm/ExecutionEngine/Orc/CompileUtils.h>
-#include <llvm/ExecutionEngine/SectionMemoryManager.h>
-#include <llvm/IR/IRBuilder.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Process.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <llvm/Target/TargetMachine.h>
 
 // Optimizations
-#include <llvm/Analysis/BasicAliasAnalysis.h>
-#include <llvm/Transforms/Scalar.h>
+#include <llvm/Passes/PassBuilder.h>
 
 /* Disable warnings from LLVM */
 #if defined(_MSC_VER)
@@ -72,29 +94,184 @@
 	#pragma GCC diagnostic pop
 #endif
 
+#if LLVM_VERSION_MAJOR >= 14
+typedef llvm::OptimizationLevel llvm_loader_impl_optimization_level;
+#else
+typedef llvm::PassBuilder::OptimizationLevel llvm_loader_impl_optimization_level;
+#endif
+
+#define LLVM_LOADER_IMPL_OPTIMIZATION "LLVM_LOADER_OPTIMIZATION"
+#define LLVM_LOADER_IMPL_OPTIMIZATION_DEFAULT 2
+#define LLVM_LOADER_IMPL_TARGET_CPU "LLVM_LOADER_TARGET_CPU"
+#define LLVM_LOADER_IMPL_TARGET_CPU_NATIVE "native"
+#define LLVM_LOADER_IMPL_CACHE_PATH "LLVM_LOADER_CACHE_PATH"
+#define LLVM_LOADER_IMPL_CACHE_EXTENSION ".o"
+
+class loader_impl_llvm_object_cache : public llvm::ObjectCache
+{
+public:
+	std::string path;
+
+	std::string file(const std::string &key) const
+	{
+		return path + "/" + key + LLVM_LOADER_IMPL_CACHE_EXTENSION;
+	}
+
+	/* Load and verify the cached object of a module, a corrupt entry is removed so the module is optimized and compiled again */
+	bool load(const std::string &key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		return load_object(key);
+	}
+
+	void notifyObjectCompiled(const llvm::Module *module, llvm::MemoryBufferRef object) override
+	{
+		const std::string object_file = file(module->getModuleIdentifier());
+		const std::string tmp_file = object_file + "." + std::to_string(llvm::sys::Process::getProcessId()) + ".tmp";
+		const uint64_t checksum = llvm::xxHash64(object.getBuffer());
+		std::error_code ec;
+
+		/* Write into a temporary file and rename it, so concurrent processes never read a partial object */
+		{
+			llvm::raw_fd_ostream stream(tmp_file, ec);
+
+			if (ec)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to create the object cache file %s: %s", tmp_file.c_str(), ec.message().c_str());
+				return;
+			}
+
+			/* The checksum of the object is appended at the end, so truncated or corrupt entries are detected when loading */
+			stream << object.getBuffer();
+			stream.write(reinterpret_cast<const char *>(&checksum), sizeof(checksum));
+		}
+
+		ec = llvm::sys::fs::rename(tmp_file, object_file);
+
+		if (ec)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to store the object cache file %s: %s", object_file.c_str(), ec.message().c_str());
+			llvm::sys::fs::remove(tmp_file);
+		}
+	}
+
+	std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *module) override
+	{
+		const std::string key = module->getModuleIdentifier();
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (!load_object(key))
+		{
+			return nullptr;
+		}
+
+		auto it = objects.find(key);
+		std::unique_ptr<llvm::MemoryBuffer> object = std::move(it->second);
+
+		objects.erase(it);
+
+		log_write("metacall", LOG_LEVEL_DEBUG, "LLVM loader object cache hit: %s", object->getBufferIdentifier().str().c_str());
+
+		return object;
+	}
+
+private:
+	std::mutex mutex;
+	std::map<std::string, std::unique_ptr<llvm::MemoryBuffer>> objects;
+
+	bool load_object(const std::string &key)
+	{
+		if (path.empty())
+		{
+			return false;
+		}
+
+		if (objects.find(key) != objects.end())
+		{
+			return true;
+		}
+
+		const std::string object_file = file(key);
+		llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(object_file);
+
+		if (!buffer)
+		{
+			return false;
+		}
+
+		llvm::StringRef data = (*buffer)->getBuffer();
+		uint64_t checksum = 0;
+
+		if (data.size() > sizeof(checksum))
+		{
+			llvm::StringRef object = data.drop_back(sizeof(checksum));
+
+			std::memcpy(&checksum, data.data() + object.size(), sizeof(checksum));
+
+			if (llvm::xxHash64(object) == checksum)
+			{
+				objects[key] = llvm::MemoryBuffer::getMemBufferCopy(object, object_file);
+				return true;
+			}
+		}
+
+		log_write("metacall", LOG_LEVEL_WARNING, "LLVM loader object cache file %s is corrupt, the module will be compiled again", object_file.c_str());
+
+		llvm::sys::fs::remove(object_file);
+
+		return false;
+	}
+};
+
 typedef struct loader_impl_llvm_function_type
 {
-	// TODO: The reference to LLVM function must be stored here
-	void *todo;
+	ffi_cif cif;
+	ffi_type *ret_type;
+	std::vector<ffi_type *> arg_types;
+	void *address;
 
 } * loader_impl_llvm_function;
 
+typedef struct loader_impl_llvm_signature_type
+{
+	std::string name;
+	std::string ret_type;
+	std::vector<std::string> arg_names;
+	std::vector<std::string> arg_types;
+
+} * loader_impl_llvm_signature;
+
 typedef struct loader_impl_llvm_handle_type
 {
-	// TODO: The references to LLVM modules must be stored here
-	// This should contain a vector with all LLVM modules loaded (input.ll)
-	void *todo;
+	llvm::orc::JITDylib *dylib;
+	std::vector<loader_impl_llvm_signature_type> signatures;
 
 } * loader_impl_llvm_handle;
 
 typedef struct loader_impl_llvm_type
 {
-	// TODO: The reference to LLVM interpreter must be stored here (Is this correct?)
-	llvm::LLVMContext context;
-	llvm::SMDiagnostic error;
+	std::unique_ptr<llvm::orc::LLJIT> jit;
+	std::unique_ptr<llvm::TargetMachine> target_machine;
+	unsigned int optimization;
+	std::string cpu;
+	std::string features;
+	std::string options_hash;
+	loader_impl_llvm_object_cache cache;
+	std::vector<std::string> execution_paths;
+	uint64_t handle_count;
 
 } * loader_impl_llvm;
 
+/* Retrieve the equivalent FFI type from type id */
+static ffi_type *llvm_loader_impl_ffi_type(type_id id);
+
+/* Retrieve the name of the type registered in the loader from the LLVM type */
+static bool llvm_loader_impl_type_name(llvm::Type *t, std::string &name);
+
+/* Run the optimization pipeline over the module before compiling it */
+static void llvm_loader_impl_optimize(loader_impl_llvm llvm_impl, llvm::Module &module);
+
 int type_llvm_interface_create(type t, type_impl impl)
 {
 	/* TODO */
@@ -125,8 +302,6 @@ type_interface type_llvm_singleton(void)
 
 int function_llvm_interface_create(function func, function_impl impl)
 {
-	/* TODO */
-
 	(void)func;
 	(void)impl;
 
@@ -135,14 +310,100 @@ int function_llvm_interface_create(function func, function_impl impl)
 
 function_return function_llvm_interface_invoke(function func, function_impl impl, function_args args, size_t size)
 {
-	/* TODO */
+	loader_impl_llvm_function llvm_function = static_cast<loader_impl_llvm_function>(impl);
+	signature s = function_signature(func);
 
-	(void)func;
-	(void)impl;
-	(void)args;
-	(void)size;
+	if (size != signature_count(s))
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid number of arguments when calling %s (canceling call in order to avoid a segfault)", function_name(func));
+		return NULL;
+	}
 
-	return NULL;
+	std::vector<void *> values(size);
+	std::vector<const char *> strings(size);
+	std::vector<int64_t> integers(size);
+
+	for (size_t args_count = 0; args_count < size; ++args_count)
+	{
+		type t = signature_get_type(s, args_count);
+		type_id id = type_index(t);
+		type_id value_id = value_type_id((value)args[args_count]);
+
+		if (id != value_id)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR,
+				"Type mismatch in when calling %s in argument number %" PRIuS
+				" (expected %s of type %s and received %s)."
+				" Canceling call in order to avoid a segfault.",
+				function_name(func),
+				args_count,
+				type_name(t),
+				type_id_name(id),
+				type_id_name(value_id));
+			return NULL;
+		}
+
+		if (id == TYPE_STRING)
+		{
+			/* Strings are passed as i8*, so FFI needs the address of the pointer */
+			strings[args_count] = value_to_string((value)args[args_count]);
+			values[args_count] = &strings[args_count];
+		}
+		else if (id == TYPE_LONG)
+		{
+			/* The i64 of the IR is wider than long in LLP64 platforms, so it is passed through a 64-bit copy */
+			integers[args_count] = (int64_t)value_to_long((value)args[args_count]);
+			values[args_count] = &integers[args_count];
+		}
+		else
+		{
+			values[args_count] = value_data((value)args[args_count]);
+		}
+	}
+
+	union
+	{
+		ffi_arg integer;
+		int64_t i64;
+		float f;
+		double d;
+		void *ptr;
+	} result;
+
+	ffi_call(&llvm_function->cif, FFI_FN(llvm_function->address), &result, values.data());
+
+	switch (type_index(signature_get_return(s)))
+	{
+		case TYPE_BOOL:
+			return value_create_bool((boolean)result.integer);
+		case TYPE_CHAR:
+			return value_create_char((char)result.integer);
+		case TYPE_SHORT:
+			return value_create_short((short)result.integer);
+		case TYPE_INT:
+			return value_create_int((int)result.integer);
+		case TYPE_LONG: {
+			const int64_t i64 = sizeof(ffi_arg) >= sizeof(int64_t) ? (int64_t)result.integer : result.i64;
+
+			if (i64 < (int64_t)std::numeric_limits<long>::min() || i64 > (int64_t)std::numeric_limits<long>::max())
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "The i64 returned by %s does not fit into a long in this platform", function_name(func));
+				return NULL;
+			}
+
+			return value_create_long((long)i64);
+		}
+		case TYPE_FLOAT:
+			return value_create_float(result.f);
+		case TYPE_DOUBLE:
+			return value_create_double(result.d);
+		case TYPE_STRING:
+			return result.ptr == NULL ? value_create_null() : value_create_string(static_cast<const char *>(result.ptr), strlen(static_cast<const char *>(result.ptr)));
+		case TYPE_PTR:
+			return value_create_ptr(result.ptr);
+		default:
+			return value_create_null();
+	}
 }
 
 function_return function_llvm_interface_await(function func, function_impl impl, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context)
@@ -162,10 +423,11 @@ function_return function_llvm_interface_await(function func, function_impl impl,
 
 void function_llvm_interface_destroy(function func, function_impl impl)
 {
-	/* TODO */
+	loader_impl_llvm_function llvm_function = static_cast<loader_impl_llvm_function>(impl);
 
 	(void)func;
-	(void)impl;
+
+	delete llvm_function;
 }
 
 function_interface function_llvm_singleton(void)
@@ -180,6 +442,140 @@ function_interface function_llvm_singleton(void)
 	return &llvm_function_interface;
 }
 
+ffi_type *llvm_loader_impl_ffi_type(type_id id)
+{
+	switch (id)
+	{
+		case TYPE_BOOL:
+			return &ffi_type_uint8;
+		case TYPE_CHAR:
+			return &ffi_type_schar;
+		case TYPE_SHORT:
+			return &ffi_type_sshort;
+		case TYPE_INT:
+			return &ffi_type_sint;
+		case TYPE_LONG:
+			return &ffi_type_sint64;
+		case TYPE_FLOAT:
+			return &ffi_type_float;
+		case TYPE_DOUBLE:
+			return &ffi_type_double;
+		case TYPE_STRING:
+			return &ffi_type_pointer;
+		case TYPE_PTR:
+			return &ffi_type_pointer;
+	}
+
+	return &ffi_type_void;
+}
+
+bool llvm_loader_impl_type_name(llvm::Type *t, std::string &name)
+{
+	if (t->isVoidTy())
+	{
+		name = "void";
+	}
+	else if (t->isIntegerTy())
+	{
+		switch (t->getIntegerBitWidth())
+		{
+			case 1:
+			case 8:
+			case 16:
+			case 32:
+			case 64:
+				name = "i" + std::to_string(t->getIntegerBitWidth());
+				break;
+			default:
+				return false;
+		}
+	}
+	else if (t->isFloatTy())
+	{
+		name = "float";
+	}
+	else if (t->isDoubleTy())
+	{
+		name = "double";
+	}
+	else if (t->isPointerTy())
+	{
+#if LLVM_VERSION_MAJOR < 15
+		/* With typed pointers i8* is treated as a string, opaque pointers cannot be distinguished */
+		if (!llvm::cast<llvm::PointerType>(t)->isOpaque() && t->getPointerElementType()->isIntegerTy(8))
+		{
+			name = "i8*";
+		}
+		else
+#endif
+		{
+			name = "Ptr";
+		}
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void llvm_loader_impl_optimize(loader_impl_llvm llvm_impl, llvm::Module &module)
+{
+	/* The machine code is already cached and valid, it will not be compiled so there is no need to optimize it */
+	if (llvm_impl->cache.load(module.getModuleIdentifier()))
+	{
+		return;
+	}
+
+	/* Functions emitted by a compiler pin the target of the compiler, retarget them to the JIT machine */
+	for (llvm::Function &f : module)
+	{
+		if (f.isDeclaration())
+		{
+			continue;
+		}
+
+		f.addFnAttr("target-cpu", llvm_impl->cpu);
+		f.addFnAttr("target-features", llvm_impl->features);
+
+		/* Code emitted at -O0 is marked as optnone, the optimization level of the loader takes precedence */
+		if (llvm_impl->optimization > 0 && f.hasFnAttribute(llvm::Attribute::OptimizeNone))
+		{
+			f.removeFnAttr(llvm::Attribute::OptimizeNone);
+			f.removeFnAttr(llvm::Attribute::NoInline);
+		}
+	}
+
+	if (llvm_impl->optimization == 0)
+	{
+		return;
+	}
+
+	static const llvm_loader_impl_optimization_level levels[] = {
+		llvm_loader_impl_optimization_level::O0,
+		llvm_loader_impl_optimization_level::O1,
+		llvm_loader_impl_optimization_level::O2,
+		llvm_loader_impl_optimization_level::O3
+	};
+
+	llvm::LoopAnalysisManager lam;
+	llvm::FunctionAnalysisManager fam;
+	llvm::CGSCCAnalysisManager cgam;
+	llvm::ModuleAnalysisManager mam;
+	llvm::PassBuilder pb(llvm_impl->target_machine.get());
+
+	pb.registerModuleAnalyses(mam);
+	pb.registerCGSCCAnalyses(cgam);
+	pb.registerFunctionAnalyses(fam);
+	pb.registerLoopAnalyses(lam);
+	pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+	llvm::ModulePassManager mpm = pb.buildPerModuleDefaultPipeline(levels[llvm_impl->optimization]);
+
+	mpm.run(module, mam);
+}
+
 int llvm_loader_impl_register_types(loader_impl impl)
 {
 	static struct
@@ -195,11 +591,10 @@ int llvm_loader_impl_register_types(loader_impl impl)
 		{ TYPE_FLOAT, "float" },
 		{ TYPE_DOUBLE, "double" },
 		{ TYPE_STRING, "i8*" },
+		{ TYPE_PTR, "Ptr" },
+		{ TYPE_NULL, "void" }
 
-		// TODO: Implement the rest of the types (Buffer and pointer remaining)
-		{ TYPE_BUFFER, "Buffer" }, // TODO
-		{ TYPE_PTR, "Ptr" }		   // TODO
-
+		// TODO: Implement the rest of the types (Buffer, structs and vectors remaining)
 	};
 
 	for (auto &pair : type_id_name_pair)
@@ -224,6 +619,128 @@ int llvm_loader_impl_register_types(loader_impl impl)
 	return 0;
 }
 
+static int llvm_loader_impl_initialize_jit(loader_impl_llvm llvm_impl)
+{
+	llvm::InitializeNativeTarget();
+	llvm::InitializeNativeTargetAsmPrinter();
+	llvm::InitializeNativeTargetAsmParser();
+
+	/* Optimization level (0-3) */
+	const char *optimization = std::getenv(LLVM_LOADER_IMPL_OPTIMIZATION);
+
+	llvm_impl->optimization = LLVM_LOADER_IMPL_OPTIMIZATION_DEFAULT;
+
+	if (optimization != NULL)
+	{
+		if (optimization[0] >= '0' && optimization[0] <= '3' && optimization[1] == '\0')
+		{
+			llvm_impl->optimization = (unsigned int)(optimization[0] - '0');
+		}
+		else
+		{
+			log_write("metacall", LOG_LEVEL_WARNING, "Invalid %s value '%s', using the default optimization level %d", LLVM_LOADER_IMPL_OPTIMIZATION, optimization, LLVM_LOADER_IMPL_OPTIMIZATION_DEFAULT);
+		}
+	}
+
+	/* Target machine, by default the host CPU with all its features */
+	llvm::Expected<llvm::orc::JITTargetMachineBuilder> jtmb = llvm::orc::JITTargetMachineBuilder::detectHost();
+
+	if (!jtmb)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to detect the host: %s", llvm::toString(jtmb.takeError()).c_str());
+		return 1;
+	}
+
+	const char *cpu = std::getenv(LLVM_LOADER_IMPL_TARGET_CPU);
+
+	if (cpu != NULL && std::strcmp(cpu, LLVM_LOADER_IMPL_TARGET_CPU_NATIVE) != 0)
+	{
+		jtmb->setCPU(cpu);
+		jtmb->getFeatures() = llvm::SubtargetFeatures();
+	}
+
+	static const llvm::CodeGenOpt::Level codegen_levels[] = {
+		llvm::CodeGenOpt::None,
+		llvm::CodeGenOpt::Less,
+		llvm::CodeGenOpt::Default,
+		llvm::CodeGenOpt::Aggressive
+	};
+
+	jtmb->setCodeGenOptLevel(codegen_levels[llvm_impl->optimization]);
+
+	llvm_impl->cpu = jtmb->getCPU();
+	llvm_impl->features = jtmb->getFeatures().getString();
+
+	llvm::Expected<std::unique_ptr<llvm::TargetMachine>> target_machine = jtmb->createTargetMachine();
+
+	if (!target_machine)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to create the target machine: %s", llvm::toString(target_machine.takeError()).c_str());
+		return 1;
+	}
+
+	llvm_impl->target_machine = std::move(*target_machine);
+
+	/* Everything that changes the generated code is part of the object cache key */
+	const std::string options = std::string(LLVM_VERSION_STRING) + ";" + std::to_string(llvm_impl->optimization) + ";" + llvm_impl->cpu + ";" + llvm_impl->features;
+
+	llvm_impl->options_hash = llvm::utohexstr(llvm::xxHash64(options), true);
+
+	/* Object cache */
+	const char *cache_path = std::getenv(LLVM_LOADER_IMPL_CACHE_PATH);
+
+	if (cache_path != NULL && cache_path[0] != '\0')
+	{
+		std::error_code ec = llvm::sys::fs::create_directories(cache_path);
+
+		if (ec)
+		{
+			log_write("metacall", LOG_LEVEL_WARNING, "LLVM loader failed to create the cache directory %s, object cache disabled: %s", cache_path, ec.message().c_str());
+		}
+		else
+		{
+			llvm_impl->cache.path = cache_path;
+		}
+	}
+
+	/* Compile with the object cache attached, so warm starts load the machine code instead of generating it */
+	auto compile_function_creator = [llvm_impl](llvm::orc::JITTargetMachineBuilder jtmb) -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+		llvm::Expected<std::unique_ptr<llvm::TargetMachine>> tm = jtmb.createTargetMachine();
+
+		if (!tm)
+		{
+			return tm.takeError();
+		}
+
+		return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*tm), llvm_impl->cache.path.empty() ? nullptr : &llvm_impl->cache);
+	};
+
+	llvm::orc::LLJITBuilder builder;
+
+	builder.setJITTargetMachineBuilder(std::move(*jtmb));
+	builder.setCompileFunctionCreator(compile_function_creator);
+
+	llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>> jit = builder.create();
+
+	if (!jit)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to create the JIT: %s", llvm::toString(jit.takeError()).c_str());
+		return 1;
+	}
+
+	llvm_impl->jit = std::move(*jit);
+
+	llvm_impl->jit->getIRTransformLayer().setTransform([llvm_impl](llvm::orc::ThreadSafeModule module, const llvm::orc::MaterializationResponsibility &) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+		module.withModuleDo([llvm_impl](llvm::Module &m) {
+			llvm_loader_impl_optimize(llvm_impl, m);
+		});
+
+		return module;
+	});
+
+	return 0;
+}
+
 loader_impl_data llvm_loader_impl_initialize(loader_impl impl, configuration config)
 {
 	loader_impl_llvm llvm_impl = new loader_impl_llvm_type();
@@ -234,10 +751,13 @@ loader_impl_data llvm_loader_impl_initialize(loader_impl impl, configuration con
 		return NULL;
 	}
 
-	/* TODO */
-	// Initialize here all the fields of llvm_impl if any is required,
-	// it is possible to initialize it in the constructor of the struct loader_impl_llvm_type,
-	// or class if you refactor it
+	llvm_impl->handle_count = 0;
+
+	if (llvm_loader_impl_initialize_jit(llvm_impl) != 0)
+	{
+		delete llvm_impl;
+		return NULL;
+	}
 
 	/* Register the types */
 	if (llvm_loader_impl_register_types(impl) != 0)
@@ -259,26 +779,177 @@ loader_impl_data llvm_loader_impl_initialize(loader_impl impl, configuration con
 int llvm_loader_impl_execution_path(loader_impl impl, const loader_path path)
 {
 	loader_impl_llvm llvm_impl = static_cast<loader_impl_llvm>(loader_impl_get(impl));
+
+	llvm_impl->execution_paths.push_back(path);
+
+	return 0;
+}
+
+static loader_impl_llvm_handle llvm_loader_impl_handle_create(loader_impl_llvm llvm_impl)
+{
+	/* Each handle has its own dylib, so its symbols can be removed when the handle is cleared */
+	llvm::Expected<llvm::orc::JITDylib &> dylib = llvm_impl->jit->createJITDylib("handle_" + std::to_string(llvm_impl->handle_count++));
+
+	if (!dylib)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to create the dylib: %s", llvm::toString(dylib.takeError()).c_str());
+		return NULL;
+	}
+
+	/* Allow the modules to call to the symbols already loaded in the process (libc, etc) */
+	llvm::Expected<std::unique_ptr<llvm::orc::DynamicLibrarySearchGenerator>> generator = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(llvm_impl->jit->getDataLayout().getGlobalPrefix());
+
+	if (!generator)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to create the process symbol generator: %s", llvm::toString(generator.takeError()).c_str());
+		llvm::consumeError(llvm_impl->jit->getExecutionSession().removeJITDylib(*dylib));
+		return NULL;
+	}
+
+	dylib->addGenerator(std::move(*generator));
+
 	loader_impl_llvm_handle llvm_handle = new loader_impl_llvm_handle_type();
 
-	if (llvm_handle == nullptr)
+	llvm_handle->dylib = &*dylib;
+
+	return llvm_handle;
+}
+
+static void llvm_loader_impl_handle_destroy(loader_impl_llvm llvm_impl, loader_impl_llvm_handle llvm_handle)
+{
+	llvm::Error err = llvm_impl->jit->getExecutionSession().removeJITDylib(*llvm_handle->dylib);
+
+	if (err)
 	{
-		// TODO: Emit exception when exception handling is implemented
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to remove the dylib: %s", llvm::toString(std::move(err)).c_str());
+	}
+
+	delete llvm_handle;
+}
+
+static int llvm_loader_impl_load_module(loader_impl_llvm llvm_impl, loader_impl_llvm_handle llvm_handle, const llvm::MemoryBuffer &buffer)
+{
+	auto context = std::make_unique<llvm::LLVMContext>();
+	llvm::SMDiagnostic error;
+	std::unique_ptr<llvm::Module> module = llvm::parseIR(buffer.getMemBufferRef(), error, *context);
+
+	if (module == nullptr)
+	{
+		std::string message;
+		llvm::raw_string_ostream stream(message);
+
+		error.print(buffer.getBufferIdentifier().str().c_str(), stream);
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to parse the module: %s", stream.str().c_str());
 		return 1;
 	}
 
-	/* TODO */
+	/* Modules emitted by a different compiler may carry another data layout, code is generated for the JIT target */
+	module->setDataLayout(llvm_impl->jit->getDataLayout());
+	module->setTargetTriple(llvm_impl->jit->getTargetTriple().str());
+
+	std::string verify;
+	llvm::raw_string_ostream verify_stream(verify);
+
+	if (llvm::verifyModule(*module, &verify_stream))
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to verify the module %s: %s", buffer.getBufferIdentifier().str().c_str(), verify_stream.str().c_str());
+		return 1;
+	}
+
+	/* The identifier of the module is the key of the object cache */
+	module->setModuleIdentifier(llvm::utohexstr(llvm::xxHash64(buffer.getBuffer()), true) + llvm_impl->options_hash);
+
+	/* Store the signatures now because the module is owned by the JIT once it has been added */
+	for (llvm::Function &f : *module)
+	{
+		if (f.isDeclaration() || f.hasLocalLinkage() || f.isIntrinsic())
+		{
+			continue;
+		}
 
-	(void)llvm_impl;
-	(void)path;
+		loader_impl_llvm_signature_type s;
+		bool supported = llvm_loader_impl_type_name(f.getReturnType(), s.ret_type);
+
+		s.name = f.getName().str();
+
+		for (llvm::Argument &arg : f.args())
+		{
+			std::string arg_type;
+
+			supported = supported && llvm_loader_impl_type_name(arg.getType(), arg_type);
+
+			s.arg_names.push_back(arg.hasName() ? arg.getName().str() : "arg" + std::to_string(arg.getArgNo()));
+			s.arg_types.push_back(arg_type);
+		}
+
+		if (supported == false || f.isVarArg())
+		{
+			log_write("metacall", LOG_LEVEL_WARNING, "LLVM loader skipping function '%s' because its signature is not supported", s.name.c_str());
+			continue;
+		}
+
+		llvm_handle->signatures.push_back(std::move(s));
+	}
+
+	llvm::Error err = llvm_impl->jit->addIRModule(*llvm_handle->dylib, llvm::orc::ThreadSafeModule(std::move(module), std::move(context)));
+
+	if (err)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to add the module %s: %s", buffer.getBufferIdentifier().str().c_str(), llvm::toString(std::move(err)).c_str());
+		return 1;
+	}
 
 	return 0;
 }
 
+static int llvm_loader_impl_load_path(loader_impl_llvm llvm_impl, loader_impl_llvm_handle llvm_handle, const loader_path path)
+{
+	std::string file;
+	size_t path_size = strnlen(path, LOADER_PATH_SIZE) + 1;
+
+	/* We assume it is a path so we load from path */
+	if (portability_path_is_absolute(path, path_size) == 0)
+	{
+		file = path;
+	}
+	else
+	{
+		/* Otherwise, check the execution paths */
+		for (auto exec_path : llvm_impl->execution_paths)
+		{
+			loader_path join_path;
+
+			portability_path_join(exec_path.c_str(), exec_path.length() + 1, path, path_size, join_path, LOADER_PATH_SIZE);
+
+			if (llvm::sys::fs::exists(join_path))
+			{
+				file = join_path;
+				break;
+			}
+		}
+	}
+
+	if (file.empty())
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to find the file: %s", path);
+		return 1;
+	}
+
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(file);
+
+	if (!buffer)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to read the file %s: %s", file.c_str(), buffer.getError().message().c_str());
+		return 1;
+	}
+
+	return llvm_loader_impl_load_module(llvm_impl, llvm_handle, **buffer);
+}
+
 loader_handle llvm_loader_impl_load_from_file(loader_impl impl, const loader_path paths[], size_t size)
 {
 	loader_impl_llvm llvm_impl = static_cast<loader_impl_llvm>(loader_impl_get(impl));
-	loader_impl_llvm_handle llvm_handle = new loader_impl_llvm_handle_type();
+	loader_impl_llvm_handle llvm_handle = llvm_loader_impl_handle_create(llvm_impl);
 
 	if (llvm_handle == nullptr)
 	{
@@ -286,21 +957,22 @@ loader_handle llvm_loader_impl_load_from_file(loader_impl impl, const loader_pat
 		return NULL;
 	}
 
-	/* TODO */
-	// Load here the list of paths using modules to store them into loader_impl_llvm_handle_type
-
-	(void)llvm_impl;
-	(void)paths;
-	(void)size;
+	for (size_t iterator = 0; iterator < size; ++iterator)
+	{
+		if (llvm_loader_impl_load_path(llvm_impl, llvm_handle, paths[iterator]) != 0)
+		{
+			llvm_loader_impl_handle_destroy(llvm_impl, llvm_handle);
+			return NULL;
+		}
+	}
 
-	// TODO: Return here the pointer to loader_impl_llvm_handle_type
 	return static_cast<loader_handle>(llvm_handle);
 }
 
 loader_handle llvm_loader_impl_load_from_memory(loader_impl impl, const loader_name name, const char *buffer, size_t size)
 {
 	loader_impl_llvm llvm_impl = static_cast<loader_impl_llvm>(loader_impl_get(impl));
-	loader_impl_llvm_handle llvm_handle = new loader_impl_llvm_handle_type();
+	loader_impl_llvm_handle llvm_handle = llvm_loader_impl_handle_create(llvm_impl);
 
 	if (llvm_handle == nullptr)
 	{
@@ -308,22 +980,22 @@ loader_handle llvm_loader_impl_load_from_memory(loader_impl impl, const loader_n
 		return NULL;
 	}
 
-	/* TODO */
-	// The same as previous module but you have to load from the string buffer instead of from file
+	/* The size includes the null terminator of the buffer */
+	std::unique_ptr<llvm::MemoryBuffer> memory = llvm::MemoryBuffer::getMemBuffer(llvm::StringRef(buffer, size > 0 ? size - 1 : 0), name);
 
-	(void)llvm_impl;
-	(void)name;
-	(void)buffer;
-	(void)size;
+	if (llvm_loader_impl_load_module(llvm_impl, llvm_handle, *memory) != 0)
+	{
+		llvm_loader_impl_handle_destroy(llvm_impl, llvm_handle);
+		return NULL;
+	}
 
-	// TODO: Return here the pointer to loader_impl_llvm_handle_type
 	return static_cast<loader_handle>(llvm_handle);
 }
 
 loader_handle llvm_loader_impl_load_from_package(loader_impl impl, const loader_path path)
 {
 	loader_impl_llvm llvm_impl = static_cast<loader_impl_llvm>(loader_impl_get(impl));
-	loader_impl_llvm_handle llvm_handle = new loader_impl_llvm_handle_type();
+	loader_impl_llvm_handle llvm_handle = llvm_loader_impl_handle_create(llvm_impl);
 
 	if (llvm_handle == nullptr)
 	{
@@ -331,13 +1003,13 @@ loader_handle llvm_loader_impl_load_from_package(loader_impl impl, const loader_
 		return NULL;
 	}
 
-	/* TODO */
-	// The same as load_from_file but this should load from binary format instead of readable format (input.ll)
-
-	(void)llvm_impl;
-	(void)path;
+	/* The IR parser detects the bitcode format (input.bc) from the magic of the file */
+	if (llvm_loader_impl_load_path(llvm_impl, llvm_handle, path) != 0)
+	{
+		llvm_loader_impl_handle_destroy(llvm_impl, llvm_handle);
+		return NULL;
+	}
 
-	// TODO: Return here the pointer to loader_impl_llvm_handle_type
 	return static_cast<loader_handle>(llvm_handle);
 }
 
@@ -346,12 +1018,7 @@ int llvm_loader_impl_clear(loader_impl impl, loader_handle handle)
 	loader_impl_llvm llvm_impl = static_cast<loader_impl_llvm>(loader_impl_get(impl));
 	loader_impl_llvm_handle llvm_handle = static_cast<loader_impl_llvm_handle>(handle);
 
-	/* TODO */
-	// Clear the array of modules from the llvm_handle and free all the memory related to it
-	(void)llvm_impl;
-
-	// Then delete the LLVM handle itself
-	delete llvm_handle;
+	llvm_loader_impl_handle_destroy(llvm_impl, llvm_handle);
 
 	return 0;
 }
@@ -360,14 +1027,58 @@ int llvm_loader_impl_discover(loader_impl impl, loader_handle handle, context ct
 {
 	loader_impl_llvm llvm_impl = static_cast<loader_impl_llvm>(loader_impl_get(impl));
 	loader_impl_llvm_handle llvm_handle = static_cast<loader_impl_llvm_handle>(handle);
+	scope sp = context_scope(ctx);
 
-	/* TODO */
-	// Iterate all the modules loaded by this llvm_handle,
-	// introspect the functions and structs and store them in ctx
+	for (loader_impl_llvm_signature_type &s : llvm_handle->signatures)
+	{
+		/* Looking up the symbol materializes (optimizes and compiles, or loads from the cache) the module */
+		auto symbol = llvm_impl->jit->lookup(*llvm_handle->dylib, s.name);
 
-	(void)llvm_impl;
-	(void)llvm_handle;
-	(void)ctx;
+		if (!symbol)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "LLVM loader failed to compile the function '%s': %s", s.name.c_str(), llvm::toString(symbol.takeError()).c_str());
+			return 1;
+		}
+
+		loader_impl_llvm_function llvm_function = new loader_impl_llvm_function_type();
+
+#if LLVM_VERSION_MAJOR >= 15
+		llvm_function->address = symbol->toPtr<void *>();
+#else
+		llvm_function->address = reinterpret_cast<void *>(static_cast<uintptr_t>(symbol->getAddress()));
+#endif
+
+		function f = function_create(s.name.c_str(), s.arg_types.size(), llvm_function, &function_llvm_singleton);
+		signature sig = function_signature(f);
+		type ret_type = loader_impl_type(impl, s.ret_type.c_str());
+
+		signature_set_return(sig, ret_type);
+
+		llvm_function->ret_type = llvm_loader_impl_ffi_type(type_index(ret_type));
+
+		for (size_t args_count = 0; args_count < s.arg_types.size(); ++args_count)
+		{
+			type t = loader_impl_type(impl, s.arg_types[args_count].c_str());
+
+			signature_set(sig, args_count, s.arg_names[args_count].c_str(), t);
+			llvm_function->arg_types.push_back(llvm_loader_impl_ffi_type(type_index(t)));
+		}
+
+		if (ffi_prep_cif(&llvm_function->cif, FFI_DEFAULT_ABI, (unsigned int)llvm_function->arg_types.size(), llvm_function->ret_type, llvm_function->arg_types.data()) != FFI_OK)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Failed to create the FFI CIF in function '%s', skipping the function", s.name.c_str());
+			function_destroy(f);
+			continue;
+		}
+
+		value v = value_create_function(f);
+
+		if (scope_define(sp, function_name(f), v) != 0)
+		{
+			value_type_destroy(v);
+			return 1;
+		}
+	}
 
 	return 0;
 }
@@ -379,12 +1090,7 @@ int llvm_loader_impl_destroy(loader_impl impl)
 	/* Destroy children loaders */
 	loader_unload_children(impl);
 
-	/* TODO */
-	// Clear here the resources, it must free all memory related to llvm_impl.
-	// The destruction of the llvm_impl contents (the bytecode interpreter for example),
-	// must be done always after loader_unload_children
-
-	// Then delete the LLVM loader itself
+	/* Destroy the JIT and the modules owned by it, then delete the LLVM loader itself */
 	delete llvm_impl;
 
 	return 0;
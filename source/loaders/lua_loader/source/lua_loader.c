@@ -33,7 +33,9 @@ loader_impl_interface lua_loader_impl_interface_singleton(void)
 		&lua_loader_impl_load_from_package,
 		&lua_loader_impl_clear,
 		&lua_loader_impl_discover,
-		&lua_loader_impl_destroy
+		&lua_loader_impl_destroy,
+		NULL,
+		0
 	};
 
 	return &loader_impl_interface_lua;
@@ -23,231 +23,532 @@
 #include <loader/loader.h>
 #include <loader/loader_impl.h>
 
+#include <portability/portability_path.h>
+
 #include <reflect/reflect_context.h>
 #include <reflect/reflect_function.h>
+#include <reflect/reflect_future.h>
 #include <reflect/reflect_scope.h>
 #include <reflect/reflect_type.h>
 
+#include <threading/threading_atomic.h>
+#include <threading/threading_mutex.h>
+
+#include <adt/adt_vector.h>
+
 #include <log/log.h>
 
+#include <format/format_specifier.h>
+
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+
+	#include <windows.h>
+#else
+	#include <pthread.h>
+#endif
 
 /*
 	Note that the expected include convention is #include "lua.h"
 	and not #include <lua/lua.h>. This is because, the lua location is not
-	standardized and may exist in locations other than lua/
+	standardized and may exist in locations other than lua/ (for example,
+	LuaJIT installs its headers into luajit-2.1/)
 */
+#include "lauxlib.h"
 #include "lua.h"
+#include "lualib.h"
 
-typedef struct loader_impl_lua_type
+/* Compatibility layer between Lua 5.1 (and LuaJIT) and Lua 5.2+ */
+#if LUA_VERSION_NUM < 502
+	#define lua_pushglobaltable(L) lua_pushvalue(L, LUA_GLOBALSINDEX)
+	#define lua_rawlen(L, i)	   lua_objlen(L, i)
+#endif
+
+/* Default amount of lua_State that can be created (main state included) */
+#define LUA_LOADER_IMPL_STATE_POOL_SIZE 0x40
+
+/* Key used in the loader configuration for overriding the pool size */
+#define LUA_LOADER_IMPL_STATE_POOL_SIZE_KEY "lua_state_pool_size"
+
+/* Maximum nesting of tables converted into values, it also stops the conversion of cyclic tables */
+#define LUA_LOADER_IMPL_TABLE_DEPTH_MAX 0x40
+
+/* Thread specific storage used for releasing the state of a thread when it exits */
+#if defined(WIN32) || defined(_WIN32)
+typedef DWORD lua_loader_impl_thread_key;
+#else
+typedef pthread_key_t lua_loader_impl_thread_key;
+#endif
+
+struct loader_impl_lua_type;
+
+typedef struct loader_impl_lua_chunk_type
+{
+	char *name;
+	char *buffer;
+	size_t size;
+
+} * loader_impl_lua_chunk;
+
+typedef struct loader_impl_lua_state_type
 {
+	struct loader_impl_lua_type *lua_impl;
+	size_t index;
+	int owned;
 	lua_State *vm;
+	size_t chunk_count;
+	struct threading_mutex_type mutex;
+
+} * loader_impl_lua_state;
+
+typedef struct loader_impl_lua_type
+{
+	lua_loader_impl_thread_key key;
+	size_t pool_size;
+	int exhausted;
+	vector states;
+	vector chunks;
+	vector execution_paths;
+	atomic_size_t chunk_count;
+	struct threading_mutex_type mutex;
 
 } * loader_impl_lua;
 
 typedef struct loader_impl_lua_handle_type
 {
-	/* TODO: This probably won't be needed as Lua does not use any
-		descriptor for the handles (aka scripts), all of them are loaded
-		into global scope and they do not have references
-	*/
-	void *handle_lua_data;
+	vector functions;
 
 } * loader_impl_lua_handle;
 
 typedef struct loader_impl_lua_function_type
 {
-	/* TODO */
-	loader_impl_lua_handle lua_handle;
-	void *function_lua_data;
+	loader_impl_lua lua_impl;
+	int *refs;
 
 } * loader_impl_lua_function;
 
-int function_lua_interface_create(function func, function_impl impl)
+static int lua_loader_impl_chunk_run(lua_State *vm, loader_impl_lua_chunk chunk);
+static int lua_loader_impl_state_replay(loader_impl_lua lua_impl, loader_impl_lua_state state);
+static int lua_loader_impl_state_sync(loader_impl_lua lua_impl, loader_impl_lua_state state);
+static loader_impl_lua_state lua_loader_impl_state(loader_impl_lua lua_impl);
+static int lua_loader_impl_value_to_lua(lua_State *vm, value v);
+static value lua_loader_impl_lua_to_value(lua_State *vm, int index, size_t depth);
+
+int future_lua_interface_create(future f, future_impl impl)
 {
-	(void)func;
+	(void)f;
 	(void)impl;
 
 	return 0;
 }
 
-function_return function_lua_interface_invoke(function func, function_impl impl, function_args args, size_t size)
+future_return future_lua_interface_await(future f, future_impl impl, future_resolve_callback resolve_callback, future_reject_callback reject_callback, void *context)
 {
-	loader_impl_lua_function lua_function = (loader_impl_lua_function)impl;
+	value result = (value)impl;
+
+	(void)f;
+
+	/* Lua calls are synchronous, so the future is already settled when it is created */
+	if (value_type_id(result) == TYPE_THROWABLE)
+	{
+		return reject_callback != NULL ? reject_callback(result, context) : NULL;
+	}
+
+	return resolve_callback != NULL ? resolve_callback(result, context) : NULL;
+}
+
+void future_lua_interface_destroy(future f, future_impl impl)
+{
+	(void)f;
+
+	value_type_destroy((value)impl);
+}
 
-	signature s = function_signature(func);
+future_interface future_lua_singleton(void)
+{
+	static struct future_interface_type lua_future_interface = {
+		&future_lua_interface_create,
+		&future_lua_interface_await,
+		&future_lua_interface_destroy
+	};
 
-	const char *name = function_name(func);
+	return &lua_future_interface;
+}
 
-	type ret_type = signature_get_return(s);
+int function_lua_interface_create(function func, function_impl impl)
+{
+	(void)func;
+	(void)impl;
 
-	(void)lua_function;
+	return 0;
+}
 
-	log_write("metacall", LOG_LEVEL_DEBUG, "Invoking lua function %s", name);
+int lua_loader_impl_value_to_lua(lua_State *vm, value v)
+{
+	type_id id = value_type_id(v);
 
-	/* TODO: Convert properly the arguments */
-	if (size > 0)
+	switch (id)
 	{
-		size_t args_count;
+		case TYPE_BOOL: {
+			lua_pushboolean(vm, value_to_bool(v) != 0L);
+			return 0;
+		}
+		case TYPE_CHAR: {
+			lua_pushinteger(vm, (lua_Integer)value_to_char(v));
+			return 0;
+		}
+		case TYPE_SHORT: {
+			lua_pushinteger(vm, (lua_Integer)value_to_short(v));
+			return 0;
+		}
+		case TYPE_INT: {
+			lua_pushinteger(vm, (lua_Integer)value_to_int(v));
+			return 0;
+		}
+		case TYPE_LONG: {
+			lua_pushinteger(vm, (lua_Integer)value_to_long(v));
+			return 0;
+		}
+		case TYPE_FLOAT: {
+			lua_pushnumber(vm, (lua_Number)value_to_float(v));
+			return 0;
+		}
+		case TYPE_DOUBLE: {
+			lua_pushnumber(vm, (lua_Number)value_to_double(v));
+			return 0;
+		}
+		case TYPE_STRING: {
+			size_t length = value_type_size(v);
 
-		for (args_count = 0; args_count < size; ++args_count)
-		{
-			/* This is only in case Lua adds types in the signature */
-			type t = signature_get_type(s, args_count);
+			lua_pushlstring(vm, value_to_string(v), length > 0 ? length - 1 : 0);
+			return 0;
+		}
+		case TYPE_BUFFER: {
+			lua_pushlstring(vm, (const char *)value_to_buffer(v), value_type_size(v));
+			return 0;
+		}
+		case TYPE_ARRAY: {
+			value *array_value = value_to_array(v);
+			size_t iterator, size = value_type_count(v);
 
-			type_id id = TYPE_INVALID;
+			lua_createtable(vm, (int)size, 0);
 
-			if (t == NULL)
-			{
-				id = value_type_id((value)args[args_count]);
-			}
-			else
+			for (iterator = 0; iterator < size; ++iterator)
 			{
-				id = type_index(t);
+				if (lua_loader_impl_value_to_lua(vm, array_value[iterator]) != 0)
+				{
+					lua_pop(vm, 1);
+					return 1;
+				}
+
+				lua_rawseti(vm, -2, (int)(iterator + 1));
 			}
 
-			log_write("metacall", LOG_LEVEL_DEBUG, "Type %p, %d", (void *)t, id);
+			return 0;
+		}
+		case TYPE_MAP: {
+			value *map_value = value_to_map(v);
+			size_t iterator, size = value_type_count(v);
 
-			if (id == TYPE_BOOL)
-			{
-				boolean *value_ptr = (boolean *)(args[args_count]);
+			lua_createtable(vm, 0, (int)size);
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Boolean value: %d", *value_ptr);
-			}
-			else if (id == TYPE_CHAR)
+			for (iterator = 0; iterator < size; ++iterator)
 			{
-				char *value_ptr = (char *)(args[args_count]);
+				value *tuple = value_to_array(map_value[iterator]);
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Char value: %c", *value_ptr);
-			}
-			else if (id == TYPE_SHORT)
-			{
-				short *value_ptr = (short *)(args[args_count]);
+				if (lua_loader_impl_value_to_lua(vm, tuple[0]) != 0)
+				{
+					lua_pop(vm, 1);
+					return 1;
+				}
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Short value: %d", *value_ptr);
-			}
-			else if (id == TYPE_INT)
-			{
-				int *value_ptr = (int *)(args[args_count]);
+				if (lua_loader_impl_value_to_lua(vm, tuple[1]) != 0)
+				{
+					lua_pop(vm, 2);
+					return 1;
+				}
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Int value: %d", *value_ptr);
+				lua_rawset(vm, -3);
 			}
-			else if (id == TYPE_LONG)
-			{
-				long *value_ptr = (long *)(args[args_count]);
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Long value: %ld", *value_ptr);
-			}
-			else if (id == TYPE_FLOAT)
-			{
-				float *value_ptr = (float *)(args[args_count]);
+			return 0;
+		}
+		case TYPE_PTR: {
+			lua_pushlightuserdata(vm, value_to_ptr(v));
+			return 0;
+		}
+		case TYPE_NULL: {
+			lua_pushnil(vm);
+			return 0;
+		}
+		default: {
+			log_write("metacall", LOG_LEVEL_ERROR, "Lua loader does not support conversion of type %s", type_id_name(id));
+			lua_pushnil(vm);
+			return 1;
+		}
+	}
+}
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Float value: %f", *value_ptr);
-			}
-			else if (id == TYPE_DOUBLE)
-			{
-				double *value_ptr = (double *)(args[args_count]);
+value lua_loader_impl_lua_to_value(lua_State *vm, int index, size_t depth)
+{
+	int lua_type_id = lua_type(vm, index);
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Double value: %f", *value_ptr);
+	switch (lua_type_id)
+	{
+		case LUA_TNONE:
+		case LUA_TNIL: {
+			return value_create_null();
+		}
+		case LUA_TBOOLEAN: {
+			return value_create_bool(lua_toboolean(vm, index) ? 1L : 0L);
+		}
+		case LUA_TNUMBER: {
+#if LUA_VERSION_NUM >= 503
+			/* Integer and float subtypes are kept, so the result does not depend on the argument types */
+			if (lua_isinteger(vm, index))
+			{
+				return value_create_long((long)lua_tointeger(vm, index));
 			}
-			else if (id == TYPE_STRING)
+#endif
+			/* Lua 5.1 and 5.2 (and LuaJIT) only have floating point numbers */
+			return value_create_double((double)lua_tonumber(vm, index));
+		}
+		case LUA_TSTRING: {
+			size_t length = 0;
+			const char *str = lua_tolstring(vm, index, &length);
+
+			return value_create_string(str, length);
+		}
+		case LUA_TTABLE: {
+			size_t length = (size_t)lua_rawlen(vm, index), count = 0;
+			value v;
+
+			if (depth >= LUA_LOADER_IMPL_TABLE_DEPTH_MAX || lua_checkstack(vm, 4) == 0)
 			{
-				const char *value_ptr = (const char *)(args[args_count]);
+				log_write("metacall", LOG_LEVEL_ERROR, "Lua table nesting exceeds the maximum depth (%d), the table may be cyclic", LUA_LOADER_IMPL_TABLE_DEPTH_MAX);
+				return NULL;
+			}
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "String value: %s", value_ptr);
+			if (index < 0)
+			{
+				index = lua_gettop(vm) + index + 1;
 			}
-			else if (id == TYPE_PTR)
+
+			/* Count the keys in order to know if the table is a sequence */
+			lua_pushnil(vm);
+
+			while (lua_next(vm, index) != 0)
 			{
-				void *value_ptr = (void *)(args[args_count]);
+				++count;
+				lua_pop(vm, 1);
+			}
 
-				log_write("metacall", LOG_LEVEL_DEBUG, "Pointer value: %p", value_ptr);
+			if (length > 0 && count == length)
+			{
+				value *array_value;
+				size_t iterator;
+
+				v = value_create_array(NULL, length);
+
+				if (v == NULL)
+				{
+					return NULL;
+				}
+
+				array_value = value_to_array(v);
+
+				for (iterator = 0; iterator < length; ++iterator)
+				{
+					lua_rawgeti(vm, index, (int)(iterator + 1));
+					array_value[iterator] = lua_loader_impl_lua_to_value(vm, -1, depth + 1);
+					lua_pop(vm, 1);
+
+					if (array_value[iterator] == NULL)
+					{
+						value_type_destroy(v);
+						return NULL;
+					}
+				}
 			}
 			else
 			{
-				log_write("metacall", LOG_LEVEL_ERROR, "Unrecognized value: %p", args[args_count]);
-			}
-		}
+				value *map_value;
+				size_t iterator = 0;
 
-		log_write("metacall", LOG_LEVEL_DEBUG, "Calling lua function with arguments (%lu)", size);
-	}
-	else
-	{
-		log_write("metacall", LOG_LEVEL_DEBUG, "Calling lua function without arguments");
-	}
+				v = value_create_map(NULL, count);
 
-	/* TODO: Execute the call */
+				if (v == NULL)
+				{
+					return NULL;
+				}
 
-	/* TODO: Convert properly the return value */
-	if (ret_type != NULL)
-	{
-		type_id id = type_index(ret_type);
+				map_value = value_to_map(v);
 
-		log_write("metacall", LOG_LEVEL_DEBUG, "Return type %p, %d", (void *)ret_type, id);
+				lua_pushnil(vm);
 
-		if (id == TYPE_BOOL)
-		{
-			boolean b = 1;
+				while (lua_next(vm, index) != 0)
+				{
+					value *tuple;
 
-			return value_create_bool(b);
-		}
-		else if (id == TYPE_CHAR)
-		{
-			return value_create_char('A');
-		}
-		else if (id == TYPE_SHORT)
-		{
-			return value_create_short(124);
+					map_value[iterator] = value_create_array(NULL, 2);
+
+					if (map_value[iterator] == NULL)
+					{
+						lua_pop(vm, 2);
+						value_type_destroy(v);
+						return NULL;
+					}
+
+					tuple = value_to_array(map_value[iterator]);
+
+					/* Convert a copy of the key, lua_tolstring modifies numeric keys in place and breaks lua_next */
+					lua_pushvalue(vm, -2);
+					tuple[0] = lua_loader_impl_lua_to_value(vm, -1, depth + 1);
+					tuple[1] = lua_loader_impl_lua_to_value(vm, -2, depth + 1);
+					lua_pop(vm, 2);
+
+					if (tuple[0] == NULL || tuple[1] == NULL)
+					{
+						lua_pop(vm, 1);
+						value_type_destroy(v);
+						return NULL;
+					}
+
+					++iterator;
+				}
+			}
+
+			return v;
 		}
-		else if (id == TYPE_INT)
-		{
-			return value_create_int(1234);
+		case LUA_TLIGHTUSERDATA: {
+			return value_create_ptr(lua_touserdata(vm, index));
 		}
-		else if (id == TYPE_LONG)
-		{
-			return value_create_long(90000L);
+		default: {
+			log_write("metacall", LOG_LEVEL_ERROR, "Lua loader does not support conversion of type %s", lua_typename(vm, lua_type_id));
+			return value_create_null();
 		}
-		else if (id == TYPE_FLOAT)
+	}
+}
+
+function_return function_lua_interface_invoke(function func, function_impl impl, function_args args, size_t size)
+{
+	loader_impl_lua_function lua_function = (loader_impl_lua_function)impl;
+	loader_impl_lua_state state = lua_loader_impl_state(lua_function->lua_impl);
+	value ret = NULL;
+	lua_State *vm;
+	size_t iterator;
+	int top;
+
+	if (state == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid Lua state when calling function %s", function_name(func));
+		return NULL;
+	}
+
+	threading_mutex_lock(&state->mutex);
+
+	vm = state->vm;
+	top = lua_gettop(vm);
+
+	/* Resolve the function into the registry of this state only once */
+	if (lua_function->refs[state->index] == LUA_NOREF)
+	{
+		lua_getglobal(vm, function_name(func));
+
+		if (lua_type(vm, -1) != LUA_TFUNCTION)
 		{
-			return value_create_float(0.2f);
+			lua_pop(vm, 1);
+			threading_mutex_unlock(&state->mutex);
+			log_write("metacall", LOG_LEVEL_ERROR, "Lua function %s not found in state #%" PRIuS, function_name(func), state->index);
+			return NULL;
 		}
-		else if (id == TYPE_DOUBLE)
+
+		lua_function->refs[state->index] = luaL_ref(vm, LUA_REGISTRYINDEX);
+	}
+
+	lua_rawgeti(vm, LUA_REGISTRYINDEX, lua_function->refs[state->index]);
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		if (lua_loader_impl_value_to_lua(vm, (value)args[iterator]) != 0)
 		{
-			return value_create_double(3.1416);
+			lua_settop(vm, top);
+			threading_mutex_unlock(&state->mutex);
+			return NULL;
 		}
-		else if (id == TYPE_STRING)
-		{
-			static const char str[] = "Hello World";
+	}
 
-			return value_create_string(str, sizeof(str) - 1);
-		}
-		else if (id == TYPE_PTR)
-		{
-			static int int_val = 15;
+	if (lua_pcall(vm, (int)size, 1, 0) != 0)
+	{
+		exception ex = exception_create_const(lua_tostring(vm, -1), "LuaError", 0, "");
+		throwable th = throwable_create(value_create_exception(ex));
 
-			return value_create_ptr(&int_val);
-		}
-		else
+		ret = value_create_throwable(th);
+	}
+	else
+	{
+		ret = lua_loader_impl_lua_to_value(vm, -1, 0);
+
+		if (ret == NULL)
 		{
-			log_write("metacall", LOG_LEVEL_ERROR, "Unrecognized return type");
+			exception ex = exception_create_const("Lua return value could not be converted", "LuaError", 0, "");
+			throwable th = throwable_create(value_create_exception(ex));
+
+			ret = value_create_throwable(th);
 		}
 	}
 
-	return NULL;
+	lua_settop(vm, top);
+
+	threading_mutex_unlock(&state->mutex);
+
+	return ret;
 }
 
 function_return function_lua_interface_await(function func, function_impl impl, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context)
 {
-	/* TODO */
+	value result = function_lua_interface_invoke(func, impl, args, size);
+	future f;
+	value v;
 
-	(void)func;
-	(void)impl;
-	(void)args;
-	(void)size;
-	(void)resolve_callback;
-	(void)reject_callback;
-	(void)context;
+	if (result == NULL)
+	{
+		return NULL;
+	}
 
-	return NULL;
+	/* The future owns the result of the call, so it can be awaited again later on */
+	f = future_create(result, &future_lua_singleton);
+
+	if (f == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid future creation when awaiting function %s", function_name(func));
+		value_type_destroy(result);
+		return NULL;
+	}
+
+	v = value_create_future(f);
+
+	if (v == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid future value creation when awaiting function %s", function_name(func));
+		future_destroy(f);
+		return NULL;
+	}
+
+	/* The value returned by the callbacks has no continuation to be passed to, so it is discarded */
+	value_type_destroy(future_lua_interface_await(f, result, resolve_callback, reject_callback, context));
+
+	return v;
 }
 
 void function_lua_interface_destroy(function func, function_impl impl)
@@ -258,6 +559,28 @@ void function_lua_interface_destroy(function func, function_impl impl)
 
 	if (lua_function != NULL)
 	{
+		loader_impl_lua lua_impl = lua_function->lua_impl;
+		size_t iterator, size;
+
+		threading_mutex_lock(&lua_impl->mutex);
+
+		size = vector_size(lua_impl->states);
+
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			loader_impl_lua_state state = vector_at_type(lua_impl->states, iterator, loader_impl_lua_state);
+
+			if (lua_function->refs[state->index] != LUA_NOREF)
+			{
+				threading_mutex_lock(&state->mutex);
+				luaL_unref(state->vm, LUA_REGISTRYINDEX, lua_function->refs[state->index]);
+				threading_mutex_unlock(&state->mutex);
+			}
+		}
+
+		threading_mutex_unlock(&lua_impl->mutex);
+
+		free(lua_function->refs);
 		free(lua_function);
 	}
 }
@@ -282,11 +605,6 @@ int lua_loader_impl_initialize_types(loader_impl impl)
 		const char *name;
 	} type_id_name_pair[] = {
 		{ TYPE_BOOL, "boolean" },
-		{ TYPE_CHAR, "string" },
-		{ TYPE_SHORT, "number" },
-		{ TYPE_INT, "number" },
-		{ TYPE_LONG, "number" },
-		{ TYPE_FLOAT, "number" },
 		{ TYPE_DOUBLE, "number" },
 		{ TYPE_STRING, "string" },
 		{ TYPE_PTR, "userdata" },
@@ -315,207 +633,907 @@ int lua_loader_impl_initialize_types(loader_impl impl)
 	return 0;
 }
 
-loader_impl_data lua_loader_impl_initialize(loader_impl impl, configuration config)
+static loader_impl_lua_state lua_loader_impl_state_create(loader_impl_lua lua_impl, size_t index)
 {
-	loader_impl_lua lua_impl;
-
-	(void)config;
+	loader_impl_lua_state state = malloc(sizeof(struct loader_impl_lua_state_type));
 
-	lua_impl = malloc(sizeof(struct loader_impl_lua_type));
-
-	if (lua_impl == NULL)
-	{
-		return NULL;
-	}
-
-	if (lua_loader_impl_initialize_types(impl) != 0)
+	if (state == NULL)
 	{
-		free(lua_impl);
-
 		return NULL;
 	}
 
-	/* Initialize Lua VM */
-	lua_impl->vm = luaL_newstate();
+	state->vm = luaL_newstate();
 
-	if (lua_impl->vm == NULL)
+	if (state->vm == NULL)
 	{
-		free(lua_impl);
-
+		free(state);
 		return NULL;
 	}
 
 	/* Open all standard libraries into current Lua state */
-	luaL_openlibs(lua_impl->vm);
+	luaL_openlibs(state->vm);
 
-	/* Register initialization */
-	loader_initialization_register(impl);
+	state->lua_impl = lua_impl;
+	state->index = index;
+	state->owned = 1;
+	state->chunk_count = 0;
 
-	return lua_impl;
+	threading_mutex_initialize(&state->mutex);
+
+	return state;
 }
 
-int lua_loader_impl_execution_path(loader_impl impl, const loader_path path)
+static void lua_loader_impl_state_destroy(loader_impl_lua_state state)
 {
-	/* TODO */
-	(void)impl;
-	(void)path;
+	lua_close(state->vm);
+	threading_mutex_destroy(&state->mutex);
+	free(state);
+}
+
+int lua_loader_impl_chunk_run(lua_State *vm, loader_impl_lua_chunk chunk)
+{
+	if (luaL_loadbuffer(vm, chunk->buffer, chunk->size, chunk->name) != 0 || lua_pcall(vm, 0, 0, 0) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Lua module %s failed to load: %s", chunk->name, lua_tostring(vm, -1));
+		lua_pop(vm, 1);
+		return 1;
+	}
 
 	return 0;
 }
 
-loader_handle lua_loader_impl_load_from_file(loader_impl impl, const loader_path paths[], size_t size)
+static int lua_loader_impl_chunk_push(loader_impl_lua lua_impl, const char *name, const char *buffer, size_t size)
 {
-	loader_impl_lua_handle handle = malloc(sizeof(struct loader_impl_lua_handle_type));
-
-	(void)impl;
+	loader_impl_lua_chunk chunk = malloc(sizeof(struct loader_impl_lua_chunk_type));
+	size_t name_length = strlen(name) + 1;
 
-	if (handle != NULL)
+	if (chunk == NULL)
 	{
-		size_t iterator;
+		return 1;
+	}
 
-		/* TODO */
+	chunk->name = malloc(sizeof(char) * name_length);
+	chunk->buffer = malloc(sizeof(char) * size);
 
-		for (iterator = 0; iterator < size; ++iterator)
-		{
-			log_write("metacall", LOG_LEVEL_DEBUG, "Lua module %s loaded from file", paths[iterator]);
-		}
+	if (chunk->name == NULL || chunk->buffer == NULL)
+	{
+		free(chunk->name);
+		free(chunk->buffer);
+		free(chunk);
+		return 1;
+	}
 
-		handle->handle_lua_data = NULL;
+	memcpy(chunk->name, name, name_length);
+	memcpy(chunk->buffer, buffer, size);
+	chunk->size = size;
 
-		return (loader_handle)handle;
-	}
+	vector_push_back_var(lua_impl->chunks, chunk);
 
-	return NULL;
+	atomic_store_explicit(&lua_impl->chunk_count, vector_size(lua_impl->chunks), memory_order_release);
+
+	return 0;
 }
 
-loader_handle lua_loader_impl_load_from_memory(loader_impl impl, const loader_name name, const char *buffer, size_t size)
+int lua_loader_impl_state_replay(loader_impl_lua lua_impl, loader_impl_lua_state state)
 {
-	loader_impl_lua lua_impl = loader_impl_get(impl);
-	loader_impl_lua_handle handle = malloc(sizeof(struct loader_impl_lua_handle_type));
+	size_t size = vector_size(lua_impl->chunks);
+	int result = 0;
 
-	if (handle != NULL)
+	/* Replay all the chunks loaded since the last synchronization, in order */
+	while (state->chunk_count < size)
 	{
-		if (luaL_loadbuffer(lua_impl->vm, buffer, size, name) != 0)
+		loader_impl_lua_chunk chunk = vector_at_type(lua_impl->chunks, state->chunk_count, loader_impl_lua_chunk);
+
+		if (lua_loader_impl_chunk_run(state->vm, chunk) != 0)
 		{
-			log_write("metacall", LOG_LEVEL_Error, "Lua module %s failed to load: %s", name, lua_tostring(lua_impl->vm, -1));
-			free(handle);
-			return NULL;
+			result = 1;
 		}
 
-		log_write("metacall", LOG_LEVEL_DEBUG, "Lua module %s. loaded from memory", name);
-
-		return (loader_handle)handle;
+		++state->chunk_count;
 	}
 
-	return NULL;
+	return result;
 }
 
-loader_handle lua_loader_impl_load_from_package(loader_impl impl, const loader_path path)
+int lua_loader_impl_state_sync(loader_impl_lua lua_impl, loader_impl_lua_state state)
 {
-	loader_impl_lua_handle handle = malloc(sizeof(struct loader_impl_lua_handle_type));
-
-	(void)impl;
-
-	if (handle != NULL)
-	{
-		/* TODO */
+	int result;
 
-		log_write("metacall", LOG_LEVEL_DEBUG, "Lua module %s loaded from package", path);
+	threading_mutex_lock(&lua_impl->mutex);
+	threading_mutex_lock(&state->mutex);
 
-		handle->handle_lua_data = NULL;
+	result = lua_loader_impl_state_replay(lua_impl, state);
 
-		return (loader_handle)handle;
-	}
+	threading_mutex_unlock(&state->mutex);
+	threading_mutex_unlock(&lua_impl->mutex);
 
-	return NULL;
+	return result;
 }
 
-int lua_loader_impl_clear(loader_impl impl, loader_handle handle)
+static void lua_loader_impl_state_release(void *data)
 {
-	loader_impl_lua_handle lua_handle = (loader_impl_lua_handle)handle;
+	loader_impl_lua_state state = (loader_impl_lua_state)data;
+	loader_impl_lua lua_impl = state->lua_impl;
 
-	(void)impl;
+	/* The thread owning the state has exited, the state is kept alive so other threads can reuse it */
+	threading_mutex_lock(&lua_impl->mutex);
 
-	if (lua_handle != NULL)
-	{
-		/* TODO */
+	state->owned = 0;
+	lua_impl->exhausted = 0;
 
-		free(lua_handle);
+	threading_mutex_unlock(&lua_impl->mutex);
+}
 
-		return 0;
+#if defined(WIN32) || defined(_WIN32)
+static VOID WINAPI lua_loader_impl_state_release_fls(PVOID data)
+{
+	if (data != NULL)
+	{
+		lua_loader_impl_state_release(data);
 	}
-
-	return 1;
 }
 
-loader_impl_lua_function lua_function_create(loader_impl_lua_handle lua_handle)
+static int lua_loader_impl_thread_key_create(lua_loader_impl_thread_key *key)
 {
-	loader_impl_lua_function lua_function = malloc(sizeof(struct loader_impl_lua_function_type));
+	*key = FlsAlloc(&lua_loader_impl_state_release_fls);
 
-	if (lua_function != NULL)
-	{
-		/* TODO */
+	return *key == FLS_OUT_OF_INDEXES;
+}
 
-		lua_function->lua_handle = lua_handle;
+	#define lua_loader_impl_thread_key_get(key)	       ((loader_impl_lua_state)FlsGetValue(key))
+	#define lua_loader_impl_thread_key_set(key, state) (FlsSetValue(key, (PVOID)(state)) == 0)
+	#define lua_loader_impl_thread_key_delete(key)	   FlsFree(key)
+#else
+static int lua_loader_impl_thread_key_create(lua_loader_impl_thread_key *key)
+{
+	return pthread_key_create(key, &lua_loader_impl_state_release) != 0;
+}
 
-		lua_function->function_lua_data = NULL;
+	#define lua_loader_impl_thread_key_get(key)	       ((loader_impl_lua_state)pthread_getspecific(key))
+	#define lua_loader_impl_thread_key_set(key, state) (pthread_setspecific(key, (const void *)(state)) != 0)
+	#define lua_loader_impl_thread_key_delete(key)	   pthread_key_delete(key)
+#endif
 
-		return lua_function;
+loader_impl_lua_state lua_loader_impl_state(loader_impl_lua lua_impl)
+{
+	loader_impl_lua_state state = lua_loader_impl_thread_key_get(lua_impl->key);
+	int pending;
+
+	if (state == NULL)
+	{
+		size_t iterator, size;
+		int owned = 1;
+
+		threading_mutex_lock(&lua_impl->mutex);
+
+		size = vector_size(lua_impl->states);
+
+		/* Reuse the state of a thread which has already exited */
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			loader_impl_lua_state it = vector_at_type(lua_impl->states, iterator, loader_impl_lua_state);
+
+			if (it->owned == 0)
+			{
+				state = it;
+				break;
+			}
+		}
+
+		if (state == NULL)
+		{
+			if (size < lua_impl->pool_size)
+			{
+				state = lua_loader_impl_state_create(lua_impl, size);
+
+				if (state != NULL)
+				{
+					vector_push_back_var(lua_impl->states, state);
+				}
+			}
+			else
+			{
+				/* The pool is exhausted, share the main state until a thread exits, calls are serialized by its mutex */
+				state = vector_front_type(lua_impl->states, loader_impl_lua_state);
+				owned = 0;
+
+				if (lua_impl->exhausted == 0)
+				{
+					log_write("metacall", LOG_LEVEL_WARNING, "Lua state pool exhausted (%" PRIuS " states), falling back into the main state", lua_impl->pool_size);
+					lua_impl->exhausted = 1;
+				}
+			}
+		}
+
+		if (state != NULL && owned == 1)
+		{
+			if (lua_loader_impl_thread_key_set(lua_impl->key, state) != 0)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Lua state #%" PRIuS " could not be assigned to the current thread", state->index);
+				state = NULL;
+			}
+			else
+			{
+				state->owned = 1;
+			}
+		}
+
+		threading_mutex_unlock(&lua_impl->mutex);
+
+		if (state == NULL)
+		{
+			return NULL;
+		}
 	}
 
-	return NULL;
+	/* The main state may be shared with other threads, so the chunk count is read under its lock */
+	threading_mutex_lock(&state->mutex);
+	pending = state->chunk_count != atomic_load_explicit(&lua_impl->chunk_count, memory_order_acquire);
+	threading_mutex_unlock(&state->mutex);
+
+	/* Load the chunks that have been loaded into the main state since the last call */
+	if (pending)
+	{
+		lua_loader_impl_state_sync(lua_impl, state);
+	}
+
+	return state;
 }
 
-int lua_loader_impl_discover(loader_impl impl, loader_handle handle, context ctx)
+loader_impl_data lua_loader_impl_initialize(loader_impl impl, configuration config)
+{
+	loader_impl_lua lua_impl;
+	loader_impl_lua_state state;
+
+	lua_impl = malloc(sizeof(struct loader_impl_lua_type));
+
+	if (lua_impl == NULL)
+	{
+		return NULL;
+	}
+
+	if (lua_loader_impl_initialize_types(impl) != 0)
+	{
+		free(lua_impl);
+
+		return NULL;
+	}
+
+	lua_impl->pool_size = LUA_LOADER_IMPL_STATE_POOL_SIZE;
+	lua_impl->exhausted = 0;
+
+	if (config != NULL)
+	{
+		value pool_size_value = configuration_value_type(config, LUA_LOADER_IMPL_STATE_POOL_SIZE_KEY, TYPE_INT);
+
+		if (pool_size_value != NULL && value_to_int(pool_size_value) > 0)
+		{
+			lua_impl->pool_size = (size_t)value_to_int(pool_size_value);
+		}
+	}
+
+	lua_impl->states = vector_create_type(loader_impl_lua_state);
+
+	if (lua_impl->states == NULL)
+	{
+		free(lua_impl);
+
+		return NULL;
+	}
+
+	lua_impl->chunks = vector_create_type(loader_impl_lua_chunk);
+
+	if (lua_impl->chunks == NULL)
+	{
+		vector_destroy(lua_impl->states);
+		free(lua_impl);
+
+		return NULL;
+	}
+
+	lua_impl->execution_paths = vector_create(sizeof(loader_path));
+
+	if (lua_impl->execution_paths == NULL)
+	{
+		vector_destroy(lua_impl->chunks);
+		vector_destroy(lua_impl->states);
+		free(lua_impl);
+
+		return NULL;
+	}
+
+	if (lua_loader_impl_thread_key_create(&lua_impl->key) != 0)
+	{
+		vector_destroy(lua_impl->execution_paths);
+		vector_destroy(lua_impl->chunks);
+		vector_destroy(lua_impl->states);
+		free(lua_impl);
+
+		return NULL;
+	}
+
+	/* Initialize the main Lua VM, it is always the first state of the pool */
+	state = lua_loader_impl_state_create(lua_impl, 0);
+
+	if (state == NULL || lua_loader_impl_thread_key_set(lua_impl->key, state) != 0)
+	{
+		if (state != NULL)
+		{
+			lua_loader_impl_state_destroy(state);
+		}
+
+		lua_loader_impl_thread_key_delete(lua_impl->key);
+		vector_destroy(lua_impl->execution_paths);
+		vector_destroy(lua_impl->chunks);
+		vector_destroy(lua_impl->states);
+		free(lua_impl);
+
+		return NULL;
+	}
+
+	vector_push_back_var(lua_impl->states, state);
+
+	atomic_init(&lua_impl->chunk_count, 0);
+
+	threading_mutex_initialize(&lua_impl->mutex);
+
+	/* Register initialization */
+	loader_initialization_register(impl);
+
+	return lua_impl;
+}
+
+int lua_loader_impl_execution_path(loader_impl impl, const loader_path path)
 {
 	loader_impl_lua lua_impl = loader_impl_get(impl);
+	static const char prefix[] = "package.path = [==[";
+	static const char suffix[] = "/?.lua;]==] .. package.path\n";
+	size_t path_length = strnlen(path, LOADER_PATH_SIZE);
+	char buffer[sizeof(prefix) + LOADER_PATH_SIZE + sizeof(suffix)];
+	size_t size = 0;
+	loader_path *execution_path;
+	int result;
+
+	/* Execution paths are recorded as chunks so every state in the pool gets them too */
+	memcpy(&buffer[size], prefix, sizeof(prefix) - 1);
+	size += sizeof(prefix) - 1;
+	memcpy(&buffer[size], path, path_length);
+	size += path_length;
+	memcpy(&buffer[size], suffix, sizeof(suffix) - 1);
+	size += sizeof(suffix) - 1;
+
+	threading_mutex_lock(&lua_impl->mutex);
+
+	vector_push_back_empty(lua_impl->execution_paths);
+	execution_path = vector_back(lua_impl->execution_paths);
+	strncpy(*execution_path, path, LOADER_PATH_SIZE - 1);
+	(*execution_path)[LOADER_PATH_SIZE - 1] = '\0';
+
+	result = lua_loader_impl_chunk_push(lua_impl, path, buffer, size);
+
+	threading_mutex_unlock(&lua_impl->mutex);
+
+	if (result != 0)
+	{
+		return 1;
+	}
+
+	return lua_loader_impl_state(lua_impl) == NULL;
+}
 
+static loader_impl_lua_handle lua_loader_impl_handle_create(void)
+{
+	loader_impl_lua_handle handle = malloc(sizeof(struct loader_impl_lua_handle_type));
+
+	if (handle == NULL)
+	{
+		return NULL;
+	}
+
+	handle->functions = vector_create_type(char *);
+
+	if (handle->functions == NULL)
+	{
+		free(handle);
+		return NULL;
+	}
+
+	return handle;
+}
+
+static void lua_loader_impl_handle_destroy(loader_impl_lua_handle handle)
+{
+	size_t iterator, size = vector_size(handle->functions);
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		free(vector_at_type(handle->functions, iterator, char *));
+	}
+
+	vector_destroy(handle->functions);
+	free(handle);
+}
+
+/* Pushes a shallow copy of the global table, used for detecting what a chunk defines */
+static void lua_loader_impl_globals_snapshot(lua_State *vm)
+{
+	lua_newtable(vm);
+	lua_pushglobaltable(vm);
+	lua_pushnil(vm);
+
+	while (lua_next(vm, -2) != 0)
+	{
+		lua_pushvalue(vm, -2);
+		lua_insert(vm, -2);
+		lua_rawset(vm, -5);
+	}
+
+	lua_pop(vm, 1);
+}
+
+/* Compares the globals against the snapshot on the top of the stack and pops it */
+static int lua_loader_impl_globals_diff(lua_State *vm, loader_impl_lua_handle handle)
+{
+	int snapshot = lua_gettop(vm);
+
+	lua_pushglobaltable(vm);
+	lua_pushnil(vm);
+
+	while (lua_next(vm, -2) != 0)
+	{
+		if (lua_type(vm, -2) == LUA_TSTRING && lua_type(vm, -1) == LUA_TFUNCTION)
+		{
+			int defined;
+
+			lua_pushvalue(vm, -2);
+			lua_rawget(vm, snapshot);
+			defined = lua_rawequal(vm, -1, -2);
+			lua_pop(vm, 1);
+
+			if (!defined)
+			{
+				size_t length = 0;
+				const char *name = lua_tolstring(vm, -2, &length);
+				char *function_name = malloc(sizeof(char) * (length + 1));
+
+				if (function_name == NULL)
+				{
+					lua_pop(vm, 4);
+					return 1;
+				}
+
+				memcpy(function_name, name, length + 1);
+
+				vector_push_back_var(handle->functions, function_name);
+			}
+		}
+
+		lua_pop(vm, 1);
+	}
+
+	lua_pop(vm, 2);
+
+	return 0;
+}
+
+static loader_handle lua_loader_impl_load_chunks(loader_impl impl, const char *names[], const char *buffers[], size_t sizes[], size_t count)
+{
+	loader_impl_lua lua_impl = loader_impl_get(impl);
+	loader_impl_lua_state state = lua_loader_impl_state(lua_impl);
+	loader_impl_lua_handle handle;
+	size_t iterator;
+
+	if (state == NULL)
+	{
+		return NULL;
+	}
+
+	handle = lua_loader_impl_handle_create();
+
+	if (handle == NULL)
+	{
+		return NULL;
+	}
+
+	threading_mutex_lock(&lua_impl->mutex);
+	threading_mutex_lock(&state->mutex);
+
+	/* Chunks pushed by other threads in the meantime must be run before the snapshot */
+	lua_loader_impl_state_replay(lua_impl, state);
+
+	lua_loader_impl_globals_snapshot(state->vm);
+
+	for (iterator = 0; iterator < count; ++iterator)
+	{
+		struct loader_impl_lua_chunk_type chunk = { (char *)names[iterator], (char *)buffers[iterator], sizes[iterator] };
+
+		if (lua_loader_impl_chunk_run(state->vm, &chunk) != 0 ||
+			lua_loader_impl_chunk_push(lua_impl, names[iterator], buffers[iterator], sizes[iterator]) != 0)
+		{
+			lua_pop(state->vm, 1);
+			goto load_error;
+		}
+
+		/* The current state already contains this chunk, avoid replaying it */
+		state->chunk_count = vector_size(lua_impl->chunks);
+	}
+
+	if (lua_loader_impl_globals_diff(state->vm, handle) != 0)
+	{
+		goto load_error;
+	}
+
+	threading_mutex_unlock(&state->mutex);
+	threading_mutex_unlock(&lua_impl->mutex);
+
+	return (loader_handle)handle;
+
+load_error:
+	threading_mutex_unlock(&state->mutex);
+	threading_mutex_unlock(&lua_impl->mutex);
+	lua_loader_impl_handle_destroy(handle);
+	return NULL;
+}
+
+static char *lua_loader_impl_read_file(const char *path, size_t *size)
+{
+	FILE *file = fopen(path, "rb");
+	char *buffer;
+	long length;
+
+	if (file == NULL)
+	{
+		return NULL;
+	}
+
+	if (fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0)
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	buffer = malloc(sizeof(char) * ((size_t)length + 1));
+
+	if (buffer == NULL)
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	*size = fread(buffer, sizeof(char), (size_t)length, file);
+
+	fclose(file);
+
+	if (*size != (size_t)length)
+	{
+		free(buffer);
+		return NULL;
+	}
+
+	return buffer;
+}
+
+static char *lua_loader_impl_read_script(loader_impl impl, const loader_path path, size_t *size)
+{
+	size_t path_size = strnlen(path, LOADER_PATH_SIZE) + 1;
+	char *buffer = lua_loader_impl_read_file(path, size);
+
+	if (buffer == NULL && portability_path_is_absolute(path, path_size) != 0)
+	{
+		loader_impl_lua lua_impl = loader_impl_get(impl);
+		size_t iterator, count;
+
+		threading_mutex_lock(&lua_impl->mutex);
+
+		count = vector_size(lua_impl->execution_paths);
+
+		for (iterator = 0; iterator < count && buffer == NULL; ++iterator)
+		{
+			loader_path *execution_path = vector_at(lua_impl->execution_paths, iterator);
+			loader_path absolute_path;
+
+			portability_path_join(*execution_path, strnlen(*execution_path, LOADER_PATH_SIZE) + 1, path, path_size, absolute_path, LOADER_PATH_SIZE);
+
+			buffer = lua_loader_impl_read_file(absolute_path, size);
+		}
+
+		threading_mutex_unlock(&lua_impl->mutex);
+	}
+
+	return buffer;
+}
+
+loader_handle lua_loader_impl_load_from_file(loader_impl impl, const loader_path paths[], size_t size)
+{
+	const char **names = malloc(sizeof(const char *) * size);
+	const char **buffers = malloc(sizeof(const char *) * size);
+	size_t *sizes = malloc(sizeof(size_t) * size);
+	loader_handle handle = NULL;
+	size_t iterator, loaded = 0;
+
+	if (names == NULL || buffers == NULL || sizes == NULL)
+	{
+		goto load_end;
+	}
+
+	for (iterator = 0; iterator < size; ++iterator, ++loaded)
+	{
+		buffers[iterator] = lua_loader_impl_read_script(impl, paths[iterator], &sizes[iterator]);
+
+		if (buffers[iterator] == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Lua module %s not found", paths[iterator]);
+			goto load_end;
+		}
+
+		names[iterator] = paths[iterator];
+	}
+
+	handle = lua_loader_impl_load_chunks(impl, names, buffers, sizes, size);
+
+	if (handle != NULL)
+	{
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			log_write("metacall", LOG_LEVEL_DEBUG, "Lua module %s loaded from file", paths[iterator]);
+		}
+	}
+
+load_end:
+	for (iterator = 0; iterator < loaded; ++iterator)
+	{
+		free((char *)buffers[iterator]);
+	}
+
+	free(names);
+	free(buffers);
+	free(sizes);
+
+	return handle;
+}
+
+loader_handle lua_loader_impl_load_from_memory(loader_impl impl, const loader_name name, const char *buffer, size_t size)
+{
+	const char *names[] = { name };
+	const char *buffers[] = { buffer };
+	size_t sizes[] = { size };
+
+	/* Ignore the null terminator if any, Lua does not accept it inside of a chunk */
+	if (size > 0 && buffer[size - 1] == '\0')
+	{
+		--sizes[0];
+	}
+
+	loader_handle handle = lua_loader_impl_load_chunks(impl, names, buffers, sizes, 1);
+
+	if (handle != NULL)
+	{
+		log_write("metacall", LOG_LEVEL_DEBUG, "Lua module %s loaded from memory", name);
+	}
+
+	return handle;
+}
+
+loader_handle lua_loader_impl_load_from_package(loader_impl impl, const loader_path path)
+{
+	/* Precompiled Lua chunks (luac or LuaJIT bytecode) can be loaded as a normal buffer */
+	loader_path paths[1];
+
+	strncpy(paths[0], path, LOADER_PATH_SIZE - 1);
+	paths[0][LOADER_PATH_SIZE - 1] = '\0';
+
+	return lua_loader_impl_load_from_file(impl, (const loader_path *)paths, 1);
+}
+
+int lua_loader_impl_clear(loader_impl impl, loader_handle handle)
+{
 	loader_impl_lua_handle lua_handle = (loader_impl_lua_handle)handle;
 
-	loader_impl_lua_function lua_function;
+	(void)impl;
 
-	scope sp = context_scope(ctx);
+	if (lua_handle != NULL)
+	{
+		/* Lua chunks are loaded into the global scope and they cannot be unloaded,
+		the functions are unreferenced from the registry when they are destroyed */
+		lua_loader_impl_handle_destroy(lua_handle);
 
-	(void)lua_impl;
+		return 0;
+	}
 
-	log_write("metacall", LOG_LEVEL_DEBUG, "Lua module %p discovering", handle);
+	return 1;
+}
+
+static int lua_loader_impl_discover_function(loader_impl_lua lua_impl, loader_impl_lua_state state, const char *name, scope sp)
+{
+	lua_State *vm = state->vm;
+	loader_impl_lua_function lua_function;
+	size_t iterator, args_count = 0;
+	function f;
+	value v;
 
-	/* TODO: Introspect all functions */
+	lua_getglobal(vm, name);
 
-	/* This is an example of how to create a function */
-	lua_function = lua_function_create(lua_handle);
+	if (lua_type(vm, -1) != LUA_TFUNCTION)
+	{
+		lua_pop(vm, 1);
+		return 0;
+	}
 
-	if (lua_function != NULL)
+#if LUA_VERSION_NUM >= 502
 	{
-		function f = function_create("my_empty_func", 0, lua_function, &function_lua_singleton);
+		lua_Debug ar;
 
-		signature s = function_signature(f);
+		lua_pushvalue(vm, -1);
 
-		signature_set_return(s, loader_impl_type(impl, "Integer"));
+		if (lua_getinfo(vm, ">u", &ar) != 0)
+		{
+			args_count = (size_t)ar.nparams;
+		}
+	}
+#else
+	/* Lua 5.1 does not expose the arity in the C API, LuaJIT does it through debug.getinfo */
+	lua_getglobal(vm, "debug");
 
-		value v = value_create_function(f);
+	if (lua_type(vm, -1) == LUA_TTABLE)
+	{
+		lua_getfield(vm, -1, "getinfo");
+		lua_pushvalue(vm, -3);
+		lua_pushstring(vm, "u");
 
-		if (scope_define(sp, function_name(f), v) != 0)
+		if (lua_pcall(vm, 2, 1, 0) == 0 && lua_type(vm, -1) == LUA_TTABLE)
 		{
-			value_type_destroy(v);
-			return 1;
+			lua_getfield(vm, -1, "nparams");
+
+			if (lua_type(vm, -1) == LUA_TNUMBER)
+			{
+				args_count = (size_t)lua_tointeger(vm, -1);
+			}
+
+			lua_pop(vm, 1);
 		}
+
+		lua_pop(vm, 1);
+	}
+
+	lua_pop(vm, 1);
+#endif
+
+	lua_function = malloc(sizeof(struct loader_impl_lua_function_type));
+
+	if (lua_function == NULL)
+	{
+		lua_pop(vm, 1);
+		return 1;
+	}
+
+	lua_function->lua_impl = lua_impl;
+	lua_function->refs = malloc(sizeof(int) * lua_impl->pool_size);
+
+	if (lua_function->refs == NULL)
+	{
+		free(lua_function);
+		lua_pop(vm, 1);
+		return 1;
+	}
+
+	for (iterator = 0; iterator < lua_impl->pool_size; ++iterator)
+	{
+		lua_function->refs[iterator] = LUA_NOREF;
+	}
+
+	f = function_create(name, args_count, lua_function, &function_lua_singleton);
+
+	if (f == NULL)
+	{
+		free(lua_function->refs);
+		free(lua_function);
+		lua_pop(vm, 1);
+		return 1;
+	}
+
+	/* Parameter names are only available when the function has not been called yet (Lua 5.2+) */
+	for (iterator = 0; iterator < args_count; ++iterator)
+	{
+		const char *parameter_name = NULL;
+
+#if LUA_VERSION_NUM >= 502
+		lua_pushvalue(vm, -1);
+		parameter_name = lua_getlocal(vm, NULL, (int)(iterator + 1));
+		lua_pop(vm, 1);
+#endif
+
+		signature_set(function_signature(f), iterator, parameter_name != NULL ? parameter_name : "", NULL);
+	}
+
+	/* Resolve the function into the registry of the current state at discovery time */
+	lua_function->refs[state->index] = luaL_ref(vm, LUA_REGISTRYINDEX);
+
+	v = value_create_function(f);
+
+	if (scope_define(sp, function_name(f), v) != 0)
+	{
+		value_type_destroy(v);
+		return 1;
 	}
 
 	return 0;
 }
 
+int lua_loader_impl_discover(loader_impl impl, loader_handle handle, context ctx)
+{
+	loader_impl_lua lua_impl = loader_impl_get(impl);
+	loader_impl_lua_handle lua_handle = (loader_impl_lua_handle)handle;
+	loader_impl_lua_state state = lua_loader_impl_state(lua_impl);
+	scope sp = context_scope(ctx);
+	size_t iterator, size = vector_size(lua_handle->functions);
+	int result = 0;
+
+	if (state == NULL)
+	{
+		return 1;
+	}
+
+	log_write("metacall", LOG_LEVEL_DEBUG, "Lua module %p discovering", handle);
+
+	threading_mutex_lock(&state->mutex);
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		const char *name = vector_at_type(lua_handle->functions, iterator, char *);
+
+		if (lua_loader_impl_discover_function(lua_impl, state, name, sp) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Lua function %s could not be discovered", name);
+			result = 1;
+			break;
+		}
+	}
+
+	threading_mutex_unlock(&state->mutex);
+
+	return result;
+}
+
 int lua_loader_impl_destroy(loader_impl impl)
 {
 	loader_impl_lua lua_impl = loader_impl_get(impl);
 
 	if (lua_impl != NULL)
 	{
+		size_t iterator, size;
+
 		/* Destroy children loaders */
 		loader_unload_children(impl);
 
-		/* Destroy Lua VM */
-		lua_close(lua_impl->vm);
+		/* Stop releasing states on thread exit before destroying them */
+		lua_loader_impl_thread_key_delete(lua_impl->key);
+
+		/* Destroy all Lua VMs of the pool */
+		size = vector_size(lua_impl->states);
+
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			lua_loader_impl_state_destroy(vector_at_type(lua_impl->states, iterator, loader_impl_lua_state));
+		}
+
+		vector_destroy(lua_impl->states);
+
+		size = vector_size(lua_impl->chunks);
+
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			loader_impl_lua_chunk chunk = vector_at_type(lua_impl->chunks, iterator, loader_impl_lua_chunk);
+
+			free(chunk->name);
+			free(chunk->buffer);
+			free(chunk);
+		}
+
+		vector_destroy(lua_impl->chunks);
+
+		vector_destroy(lua_impl->execution_paths);
+
+		threading_mutex_destroy(&lua_impl->mutex);
 
 		free(lua_impl);
 
@@ -47,6 +47,8 @@ MOCK_LOADER_API int mock_loader_impl_discover(loader_impl impl, loader_handle ha
 
 MOCK_LOADER_API int mock_loader_impl_destroy(loader_impl impl);
 
+MOCK_LOADER_API int mock_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id);
+
 #ifdef __cplusplus
 }
 #endif
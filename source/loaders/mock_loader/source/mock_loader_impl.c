@@ -628,3 +628,12 @@ int mock_loader_impl_destroy(loader_impl impl)
 
 	return 1;
 }
+
+int mock_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id)
+{
+	(void)impl;
+	(void)id;
+
+	/* The mock loader does not hold any runtime state */
+	return 0;
+}
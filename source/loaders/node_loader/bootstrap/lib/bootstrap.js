@@ -5,6 +5,8 @@ const Module = require('module');
 const path = require('path');
 const util = require('util');
 const fs = require('fs');
+const vm = require('vm');
+const crypto = require('crypto');
 
 // Require the JavaScript parser
 const espree = require(path.join(__dirname, 'node_modules', 'espree'));
@@ -12,12 +14,136 @@ const espree = require(path.join(__dirname, 'node_modules', 'espree'));
 const node_require = Module.prototype.require;
 const node_resolve = require.resolve;
 const node_cache = require.cache;
+const node_compile = Module.prototype._compile;
 
 // Store in the module prototype the original functions for future use in derived loaders like TypeScript
 Module.prototype.node_require = node_require;
 Module.prototype.node_resolve = node_resolve;
 Module.prototype.node_cache = node_cache;
 
+// Directory of the V8 code cache, if it is not defined the cache is disabled
+const node_loader_trampoline_cache_path = process.env['NODE_LOADER_CACHE_PATH'];
+
+// Files loaded by MetaCall which are compiled with the code cache when NodeJS does not provide its own compile cache
+const node_loader_trampoline_cache_entries = new Set();
+
+function node_loader_trampoline_cache_file(filename, content) {
+	// V8 validates the source of the cached data too, the key only avoids collisions between scripts
+	const hash = crypto.createHash('sha256')
+		.update(process.version).update('\0')
+		.update(filename).update('\0')
+		.update(content)
+		.digest('hex');
+
+	return path.join(node_loader_trampoline_cache_path, `${hash}.cache`);
+}
+
+function node_loader_trampoline_cache_write(file, data) {
+	try {
+		// Write and rename so other processes never read an incomplete entry
+		const tmp = `${file}.${process.pid}.tmp`;
+		fs.writeFileSync(tmp, data);
+		fs.renameSync(tmp, file);
+	} catch (ex) {
+		// The cache is an optimization, failing to write it is not an error
+	}
+}
+
+// Equivalent to Module.prototype._compile but reusing the V8 code cache produced by previous runs
+function node_loader_trampoline_cache_compile(content, filename) {
+	const file = node_loader_trampoline_cache_file(filename, content);
+	let cachedData;
+
+	try {
+		cachedData = fs.readFileSync(file);
+	} catch (ex) {
+		cachedData = undefined;
+	}
+
+	// The wrapper moves the shebang out of the first line, where it would be a syntax error
+	const script = new vm.Script(Module.wrap(content.replace(/^#!.*/, '')), {
+		filename,
+		cachedData,
+		// Resolve dynamic import() as any other CommonJS module does
+		importModuleDynamically: vm.constants.USE_MAIN_CONTEXT_DEFAULT_LOADER,
+	});
+
+	const compiledWrapper = script.runInThisContext({ displayErrors: true });
+	const dirname = path.dirname(filename);
+	const m = this;
+
+	function require(id) {
+		return m.require(id);
+	}
+
+	require.resolve = (request, options) => Module._resolveFilename(request, m, false, options);
+	require.resolve.paths = (request) => Module._resolveLookupPaths(request, m);
+	require.main = process.mainModule;
+	require.extensions = Module._extensions;
+	require.cache = Module._cache;
+
+	const result = compiledWrapper.call(m.exports, m.exports, require, m, filename, dirname);
+
+	// Generate the cache after the execution so it includes the functions compiled lazily during the load
+	if (cachedData === undefined || script.cachedDataRejected === true) {
+		node_loader_trampoline_cache_write(file, script.createCachedData());
+	}
+
+	return result;
+}
+
+// Only the scripts loaded by MetaCall use the fallback, the rest of modules keep the compilation of NodeJS (policies, inspector...)
+function node_loader_trampoline_cache_compile_entry(content, filename, ...args) {
+	if (node_loader_trampoline_cache_entries.has(filename)) {
+		return node_loader_trampoline_cache_compile.call(this, content, filename);
+	}
+
+	return node_compile.call(this, content, filename, ...args);
+}
+
+// Returns true if the scripts loaded by MetaCall must be registered in the entries of the fallback code cache
+function node_loader_trampoline_cache_initialize() {
+	if (!node_loader_trampoline_cache_path) {
+		return false;
+	}
+
+	try {
+		fs.mkdirSync(node_loader_trampoline_cache_path, { recursive: true });
+	} catch (ex) {
+		console.log(`NodeJS Warning: Code cache disabled, invalid NODE_LOADER_CACHE_PATH: ${ex.message}`);
+		return false;
+	}
+
+	// The compile cache of NodeJS (22.1.0 or newer) covers every module, including their dependencies
+	if (typeof Module.enableCompileCache === 'function') {
+		const { status, message } = Module.enableCompileCache(node_loader_trampoline_cache_path);
+
+		if (status === Module.constants.compileCacheStatus.FAILED) {
+			console.log(`NodeJS Warning: Code cache disabled: ${message}`);
+		}
+
+		return false;
+	}
+
+	// Without the default loader for dynamic import(), a script compiled with vm.Script could not use import()
+	if (!vm.constants || vm.constants.USE_MAIN_CONTEXT_DEFAULT_LOADER === undefined) {
+		console.log('NodeJS Warning: Code cache disabled, it requires NodeJS 21.7.0 or newer');
+		return false;
+	}
+
+	Module.prototype._compile = node_loader_trampoline_cache_compile_entry;
+
+	return true;
+}
+
+const node_loader_trampoline_cache_fallback = node_loader_trampoline_cache_initialize();
+
+function node_loader_trampoline_cache_entry(filename) {
+	if (node_loader_trampoline_cache_fallback) {
+		node_loader_trampoline_cache_entries.add(filename);
+	}
+}
+
 function node_loader_trampoline_initialize(loader_library_path) {
 	// Restore the argv (this is used for tricking node::Start method)
 	process.argv = [ process.argv[0] ];
@@ -143,6 +269,15 @@ function node_loader_trampoline_load_from_file(paths) {
 
 		for (let i = 0; i < paths.length; ++i) {
 			const p = paths[i];
+
+			if (node_loader_trampoline_cache_fallback) {
+				try {
+					node_loader_trampoline_cache_entry(node_loader_trampoline_import(node_resolve, p));
+				} catch (_) {
+					// The error is reported by the require below
+				}
+			}
+
 			const m = node_loader_trampoline_import(node_require, p);
 
 			handle[p] = node_loader_trampoline_module(m);
@@ -180,6 +315,8 @@ function node_loader_trampoline_load_from_memory(name, buffer, opts) {
 		...opts.append_paths || [],
 	];
 
+	node_loader_trampoline_cache_entry(name);
+
 	try {
 		// eslint-disable-next-line no-underscore-dangle
 		m._compile(buffer, name);
@@ -408,6 +545,127 @@ function node_loader_trampoline_await_future(trampoline) {
 	};
 }
 
+function node_loader_trampoline_proxy_array(length, element) {
+	// Elements are converted by the loader on first access and kept in the target
+	const target = new Array(length);
+
+	const index = prop => {
+		if (typeof prop !== 'string') {
+			return -1;
+		}
+
+		const i = Number(prop);
+
+		return Number.isInteger(i) && i >= 0 && i < length && String(i) === prop ? i : -1;
+	};
+
+	const load = i => {
+		if (!(i in target)) {
+			target[i] = element(i);
+		}
+
+		return target[i];
+	};
+
+	return new Proxy(target, {
+		get: (target, prop, receiver) => {
+			const i = index(prop);
+
+			return i < 0 ? Reflect.get(target, prop, receiver) : load(i);
+		},
+		has: (target, prop) => index(prop) >= 0 || Reflect.has(target, prop),
+		ownKeys: target => {
+			for (let i = 0; i < length; ++i) {
+				load(i);
+			}
+
+			return Reflect.ownKeys(target);
+		},
+		getOwnPropertyDescriptor: (target, prop) => {
+			const i = index(prop);
+
+			if (i >= 0) {
+				load(i);
+			}
+
+			return Reflect.getOwnPropertyDescriptor(target, prop);
+		},
+	});
+}
+
+function node_loader_trampoline_proxy_map(find, entries) {
+	// Values are converted by the loader on first access by key, enumerating the keys converts all of them
+	const target = {};
+	const missing = new Set();
+	const deleted = new Set();
+	let complete = false;
+
+	const has = prop => Object.prototype.hasOwnProperty.call(target, prop);
+
+	const define = (key, value) => Object.defineProperty(target, key, {
+		value, writable: true, enumerable: true, configurable: true,
+	});
+
+	const load = prop => {
+		if (complete || typeof prop !== 'string' || has(prop) || missing.has(prop) || deleted.has(prop)) {
+			return;
+		}
+
+		// The value is wrapped into an array so a null value can be told apart from a missing key
+		const found = find(prop);
+
+		if (found === undefined) {
+			missing.add(prop);
+		} else {
+			define(prop, found[0]);
+		}
+	};
+
+	const load_all = () => {
+		if (complete) {
+			return;
+		}
+
+		for (const entry of entries()) {
+			if (Array.isArray(entry) && !has(entry[0]) && !deleted.has(entry[0])) {
+				define(entry[0], entry[1]);
+			}
+		}
+
+		complete = true;
+	};
+
+	return new Proxy(target, {
+		get: (target, prop, receiver) => {
+			load(prop);
+
+			return Reflect.get(target, prop, receiver);
+		},
+		has: (target, prop) => {
+			load(prop);
+
+			return Reflect.has(target, prop);
+		},
+		ownKeys: target => {
+			load_all();
+
+			return Reflect.ownKeys(target);
+		},
+		getOwnPropertyDescriptor: (target, prop) => {
+			load(prop);
+
+			return Reflect.getOwnPropertyDescriptor(target, prop);
+		},
+		deleteProperty: (target, prop) => {
+			if (typeof prop === 'string') {
+				deleted.add(prop);
+			}
+
+			return Reflect.deleteProperty(target, prop);
+		},
+	});
+}
+
 module.exports = ((impl, ptr) => {
 	try {
 		if (typeof impl === 'undefined' || typeof ptr === 'undefined') {
@@ -429,6 +687,8 @@ module.exports = ((impl, ptr) => {
 			'test': node_loader_trampoline_test,
 			'await_function': node_loader_trampoline_await_function(trampoline),
 			'await_future': node_loader_trampoline_await_future(trampoline),
+			'proxy_array': node_loader_trampoline_proxy_array,
+			'proxy_map': node_loader_trampoline_proxy_map,
 		});
 	} catch (ex) {
 		console.log('Exception in bootstrap.js trampoline initialization:', ex);
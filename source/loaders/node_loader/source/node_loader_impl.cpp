@@ -702,9 +702,25 @@ typedef struct loader_impl_napi_to_value_callback_closure_type
 
 } * loader_impl_napi_to_value_callback_closure;
 
+typedef struct loader_impl_napi_view_closure_type
+{
+	value v;
+	loader_impl_node node_impl;
+
+} * loader_impl_napi_view_closure;
+
 /* Type conversion */
 static napi_value node_loader_impl_napi_to_value_callback(napi_env env, napi_callback_info info);
 
+/* Views */
+static napi_value node_loader_impl_napi_view_element(napi_env env, napi_callback_info info);
+
+static napi_value node_loader_impl_napi_view_find(napi_env env, napi_callback_info info);
+
+static napi_value node_loader_impl_napi_view_entries(napi_env env, napi_callback_info info);
+
+static napi_value node_loader_impl_value_view_to_napi(loader_impl_node node_impl, napi_env env, value arg_value, type_id id);
+
 /* Function */
 static int function_node_interface_create(function func, function_impl impl);
 
@@ -1367,6 +1383,191 @@ napi_value node_loader_impl_napi_to_value_callback(napi_env env, napi_callback_i
 	return result;
 }
 
+napi_value node_loader_impl_napi_view_element(napi_env env, napi_callback_info info)
+{
+	size_t argc = 1;
+	napi_value argv[1], result;
+	uint32_t index = 0;
+	loader_impl_async_safe_cast<loader_impl_napi_view_closure> closure_cast = { nullptr };
+
+	napi_status status = napi_get_cb_info(env, info, &argc, argv, nullptr, &closure_cast.ptr);
+
+	node_loader_impl_exception(env, status);
+
+	status = napi_get_value_uint32(env, argv[0], &index);
+
+	node_loader_impl_exception(env, status);
+
+	value element = value_type_at(closure_cast.safe->v, static_cast<size_t>(index));
+
+	if (element == NULL)
+	{
+		status = napi_get_undefined(env, &result);
+
+		node_loader_impl_exception(env, status);
+
+		return result;
+	}
+
+	return node_loader_impl_value_to_napi(closure_cast.safe->node_impl, env, element);
+}
+
+napi_value node_loader_impl_napi_view_find(napi_env env, napi_callback_info info)
+{
+	size_t argc = 1, length = 0;
+	napi_value argv[1], result;
+	loader_impl_async_safe_cast<loader_impl_napi_view_closure> closure_cast = { nullptr };
+
+	napi_status status = napi_get_cb_info(env, info, &argc, argv, nullptr, &closure_cast.ptr);
+
+	node_loader_impl_exception(env, status);
+
+	status = napi_get_value_string_utf8(env, argv[0], nullptr, 0, &length);
+
+	node_loader_impl_exception(env, status);
+
+	char *key = new char[length + 1];
+
+	status = napi_get_value_string_utf8(env, argv[0], key, length + 1, &length);
+
+	node_loader_impl_exception(env, status);
+
+	value element = value_type_find(closure_cast.safe->v, key, length);
+
+	delete[] key;
+
+	if (element == NULL)
+	{
+		status = napi_get_undefined(env, &result);
+
+		node_loader_impl_exception(env, status);
+
+		return result;
+	}
+
+	/* Wrap the element, so the proxy can tell a null element apart from a missing key */
+	napi_value element_v = node_loader_impl_value_to_napi(closure_cast.safe->node_impl, env, element);
+
+	status = napi_create_array_with_length(env, 1, &result);
+
+	node_loader_impl_exception(env, status);
+
+	status = napi_set_element(env, result, 0, element_v);
+
+	node_loader_impl_exception(env, status);
+
+	return result;
+}
+
+napi_value node_loader_impl_napi_view_entries(napi_env env, napi_callback_info info)
+{
+	napi_value result;
+	loader_impl_async_safe_cast<loader_impl_napi_view_closure> closure_cast = { nullptr };
+
+	napi_status status = napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &closure_cast.ptr);
+
+	node_loader_impl_exception(env, status);
+
+	size_t size = value_type_count(closure_cast.safe->v);
+
+	status = napi_create_array_with_length(env, size, &result);
+
+	node_loader_impl_exception(env, status);
+
+	for (uint32_t iterator = 0; iterator < size; ++iterator)
+	{
+		/* Each entry is a [key, value] tuple, converted as a plain array */
+		value tuple = value_type_at(closure_cast.safe->v, static_cast<size_t>(iterator));
+
+		if (tuple == NULL)
+		{
+			continue;
+		}
+
+		napi_value entry_v = node_loader_impl_value_to_napi(closure_cast.safe->node_impl, env, tuple);
+
+		status = napi_set_element(env, result, iterator, entry_v);
+
+		node_loader_impl_exception(env, status);
+	}
+
+	return result;
+}
+
+napi_value node_loader_impl_value_view_to_napi(loader_impl_node node_impl, napi_env env, value arg_value, type_id id)
+{
+	const char *proxy_str = (id == TYPE_ARRAY) ? "proxy_array" : "proxy_map";
+	napi_value function_table_object, function_trampoline_proxy, global, v = nullptr;
+	napi_valuetype valuetype;
+	napi_value argv[2];
+
+	/* Get function table object from reference */
+	napi_status status = napi_get_reference_value(env, node_impl->function_table_object_ref, &function_table_object);
+
+	node_loader_impl_exception(env, status);
+
+	status = napi_get_named_property(env, function_table_object, proxy_str, &function_trampoline_proxy);
+
+	node_loader_impl_exception(env, status);
+
+	status = napi_typeof(env, function_trampoline_proxy, &valuetype);
+
+	node_loader_impl_exception(env, status);
+
+	if (valuetype != napi_function)
+	{
+		napi_throw_type_error(env, nullptr, "Invalid function proxy in function table object");
+
+		return v;
+	}
+
+	loader_impl_napi_view_closure closure = new loader_impl_napi_view_closure_type();
+
+	/* The caller owns the view, share it so the proxy can keep converting elements after the call */
+	closure->v = value_type_share(arg_value);
+	closure->node_impl = node_impl;
+
+	if (id == TYPE_ARRAY)
+	{
+		status = napi_create_uint32(env, static_cast<uint32_t>(value_type_count(arg_value)), &argv[0]);
+
+		node_loader_impl_exception(env, status);
+
+		status = napi_create_function(env, nullptr, 0, node_loader_impl_napi_view_element, closure, &argv[1]);
+
+		node_loader_impl_exception(env, status);
+	}
+	else
+	{
+		status = napi_create_function(env, nullptr, 0, node_loader_impl_napi_view_find, closure, &argv[0]);
+
+		node_loader_impl_exception(env, status);
+
+		status = napi_create_function(env, nullptr, 0, node_loader_impl_napi_view_entries, closure, &argv[1]);
+
+		node_loader_impl_exception(env, status);
+	}
+
+	auto finalizer = [](napi_env, void *finalize_data, void *) {
+		loader_impl_napi_view_closure closure = static_cast<loader_impl_napi_view_closure>(finalize_data);
+		value_type_destroy(closure->v);
+		delete closure;
+	};
+
+	/* Both callbacks are only reachable from the proxy, so they are collected together */
+	node_loader_impl_finalizer_impl(env, argv[1], closure, finalizer);
+
+	status = napi_get_reference_value(env, node_impl->global_ref, &global);
+
+	node_loader_impl_exception(env, status);
+
+	status = napi_call_function(env, global, function_trampoline_proxy, 2, argv, &v);
+
+	node_loader_impl_exception(env, status);
+
+	return v;
+}
+
 napi_value node_loader_impl_value_to_napi(loader_impl_node node_impl, napi_env env, value arg_value)
 {
 	type_id id = value_type_id(arg_value);
@@ -1453,6 +1654,11 @@ napi_value node_loader_impl_value_to_napi(loader_impl_node node_impl, napi_env e
 
 		node_loader_impl_exception(env, status);
 	}
+	else if ((id == TYPE_ARRAY || id == TYPE_MAP) && value_view(arg_value, NULL) != NULL)
+	{
+		/* Values backed by a foreign object are converted on access through a proxy */
+		v = node_loader_impl_value_view_to_napi(node_impl, env, arg_value, id);
+	}
 	else if (id == TYPE_ARRAY)
 	{
 		value *array_value = value_to_array(arg_value);
@@ -33,7 +33,9 @@ loader_impl_interface py_loader_impl_interface_singleton(void)
 		&py_loader_impl_load_from_package,
 		&py_loader_impl_clear,
 		&py_loader_impl_discover,
-		&py_loader_impl_destroy
+		&py_loader_impl_destroy,
+		&py_loader_impl_fork,
+		1
 	};
 
 	return &loader_impl_interface_py;
@@ -21,6 +21,7 @@
 #include <py_loader/py_loader_dict.h>
 #include <py_loader/py_loader_impl.h>
 #include <py_loader/py_loader_port.h>
+#include <py_loader/py_loader_proxy.h>
 #include <py_loader/py_loader_threading.h>
 
 #include <loader/loader.h>
@@ -41,13 +42,35 @@
 
 #include <metacall/metacall.h>
 
+#include <inttypes.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32)
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
 
 #include <Python.h>
+#include <marshal.h>
 
 #define PY_LOADER_IMPL_FUNCTION_TYPE_INVOKE_FUNC "__py_loader_impl_function_type_invoke__"
 #define PY_LOADER_IMPL_FINALIZER_FUNC			 "__py_loader_impl_finalizer__"
+#define PY_LOADER_IMPL_CACHE_PATH				 "PY_LOADER_CACHE_PATH"
+#define PY_LOADER_IMPL_CACHE_EXTENSION			 ".marshal"
+#define PY_LOADER_IMPL_PROXY_THRESHOLD			 "PY_LOADER_PROXY_THRESHOLD"
+
+/* Arguments that fit in the stack array are passed through vectorcall without allocating */
+#define PY_LOADER_IMPL_VECTORCALL_STACK_SIZE 8
+
+#if PY_VERSION_HEX >= 0x03090000
+	#define PY_LOADER_IMPL_VECTORCALL 1
+#else
+	#define PY_LOADER_IMPL_VECTORCALL 0
+#endif
 
 #if (!defined(NDEBUG) || defined(DEBUG) || defined(_DEBUG) || defined(__DEBUG) || defined(__DEBUG__))
 	#define DEBUG_ENABLED 1
@@ -55,10 +78,19 @@
 	#define DEBUG_ENABLED 0
 #endif
 
+typedef PyObject *(*py_loader_impl_value_to_capi_func)(loader_impl, type_id, value);
+
+typedef struct loader_impl_py_function_converter_type
+{
+	type_id id;
+	py_loader_impl_value_to_capi_func to_capi;
+} * loader_impl_py_function_converter;
+
 typedef struct loader_impl_py_function_type
 {
 	PyObject *func;
-	PyObject **values; // Cache and re-use the values array
+	PyObject **values;							  // Cache and re-use the values array
+	loader_impl_py_function_converter converters; // Argument converters resolved from the signature at discovery
 	loader_impl impl;
 } * loader_impl_py_function;
 
@@ -131,8 +163,25 @@ struct loader_impl_py_type
 	PyObject *gc_debug_leak;
 	PyObject *gc_debug_stats;
 #endif
+
+	/* Directory of the compiled code cache, disabled if the size is zero */
+	char cache_path[PORTABILITY_PATH_SIZE];
+	size_t cache_path_size;
+
+	/* Minimum amount of elements of an array or map for converting it lazily, disabled if it is zero */
+	size_t proxy_threshold;
 };
 
+/* Header of the compiled code cache entries, the code object follows in marshal format */
+typedef struct loader_impl_py_cache_header_type
+{
+	long magic;
+	uint64_t hash;
+	uint64_t name_size;
+	uint64_t size;
+
+} * loader_impl_py_cache_header;
+
 typedef struct loader_impl_py_function_type_invoke_state_type
 {
 	loader_impl impl;
@@ -182,6 +231,12 @@ static size_t py_loader_impl_discover_callable_args_count(loader_impl_py py_impl
 
 static int py_loader_impl_discover_func(loader_impl impl, PyObject *func, function f);
 
+static void py_loader_impl_discover_func_converters(loader_impl_py_function py_func, function f);
+
+static py_loader_impl_value_to_capi_func py_loader_impl_value_to_capi_converter(type_id id);
+
+static value py_loader_impl_capi_to_value_fast(loader_impl impl, PyObject *obj);
+
 static int py_loader_impl_discover_method(loader_impl impl, PyObject *callable, method m, bool is_static);
 
 static type py_loader_impl_get_type(loader_impl impl, PyObject *obj);
@@ -371,14 +426,25 @@ int function_py_interface_create(function func, function_impl impl)
 			return 1;
 		}
 
+		py_func->converters = malloc(sizeof(struct loader_impl_py_function_converter_type) * args_size);
+
+		if (py_func->converters == NULL)
+		{
+			free(py_func->values);
+			return 1;
+		}
+
 		for (size_t iterator = 0; iterator < args_size; ++iterator)
 		{
 			py_func->values[iterator] = NULL;
+			py_func->converters[iterator].id = TYPE_INVALID;
+			py_func->converters[iterator].to_capi = NULL;
 		}
 	}
 	else
 	{
 		py_func->values = NULL;
+		py_func->converters = NULL;
 	}
 
 	return 0;
@@ -920,6 +986,10 @@ type_id py_loader_impl_capi_to_value_type(loader_impl impl, PyObject *obj)
 	{
 		return TYPE_MAP;
 	}
+	else if (py_loader_impl_proxy_value(obj) != NULL)
+	{
+		return value_type_id(py_loader_impl_proxy_value(obj));
+	}
 	else if (PyCapsule_CheckExact(obj))
 	{
 		return TYPE_PTR;
@@ -961,6 +1031,35 @@ value py_loader_impl_capi_to_value(loader_impl impl, PyObject *obj, type_id id)
 {
 	value v = NULL;
 
+	if (id == TYPE_ARRAY || id == TYPE_MAP)
+	{
+		loader_impl_py py_impl = loader_impl_get(impl);
+
+		/* Lazy views already hold the value, share it instead of walking the elements */
+		value proxy_value = py_loader_impl_proxy_value(obj);
+
+		if (proxy_value != NULL && value_type_id(proxy_value) == id)
+		{
+			return value_type_share(proxy_value);
+		}
+
+		/* Large lists, tuples and dicts are backed by the Python object, their elements are converted when accessed */
+		if (py_impl->proxy_threshold > 0 && ((id == TYPE_ARRAY && (PyList_Check(obj) || PyTuple_Check(obj))) || (id == TYPE_MAP && PyDict_Check(obj))))
+		{
+			Py_ssize_t size = PyDict_Check(obj) ? PyDict_Size(obj) : PyList_Check(obj) ? PyList_Size(obj) : PyTuple_Size(obj);
+
+			if ((size_t)size >= py_impl->proxy_threshold)
+			{
+				v = py_loader_impl_view_create(impl, obj, id);
+
+				if (v != NULL)
+				{
+					return v;
+				}
+			}
+		}
+	}
+
 	if (id == TYPE_BOOL)
 	{
 		boolean b = (PyObject_IsTrue(obj) == 1) ? 1 : 0;
@@ -1209,6 +1308,8 @@ value py_loader_impl_capi_to_value(loader_impl impl, PyObject *obj, type_id id)
 			return NULL;
 		}
 
+		py_loader_impl_discover_func_converters(py_func, f);
+
 		return value_create_function(f);
 	}
 	else if (id == TYPE_NULL)
@@ -1324,6 +1425,34 @@ value py_loader_impl_capi_to_value(loader_impl impl, PyObject *obj, type_id id)
 	return v;
 }
 
+value py_loader_impl_capi_to_value_fast(loader_impl impl, PyObject *obj)
+{
+	/* Check the exact types first, this skips the generic type detection for the most common results */
+#if PY_MAJOR_VERSION == 3
+	if (PyLong_CheckExact(obj))
+	{
+		return value_create_long(PyLong_AsLong(obj));
+	}
+	else if (PyFloat_CheckExact(obj))
+	{
+		return value_create_double(PyFloat_AS_DOUBLE(obj));
+	}
+	else if (PyUnicode_CheckExact(obj))
+	{
+		Py_ssize_t length = 0;
+		const char *str = PyUnicode_AsUTF8AndSize(obj, &length);
+
+		return value_create_string(str, (size_t)length);
+	}
+	else if (obj == Py_None)
+	{
+		return value_create_null();
+	}
+#endif
+
+	return py_loader_impl_capi_to_value(impl, obj, py_loader_impl_capi_to_value_type(impl, obj));
+}
+
 PyObject *py_loader_impl_value_to_capi(loader_impl impl, type_id id, value v)
 {
 	if (id == TYPE_BOOL)
@@ -1406,6 +1535,21 @@ PyObject *py_loader_impl_value_to_capi(loader_impl impl, type_id id, value v)
 	}
 	else if (id == TYPE_ARRAY)
 	{
+		loader_impl_py py_impl = loader_impl_get(impl);
+		PyObject *view_obj = py_loader_impl_view_object(v);
+
+		/* Values still backed by a Python object go back to it instead of being converted again */
+		if (view_obj != NULL)
+		{
+			Py_INCREF(view_obj);
+			return view_obj;
+		}
+
+		if (py_impl->proxy_threshold > 0 && value_type_count(v) >= py_impl->proxy_threshold)
+		{
+			return py_loader_impl_proxy_create(impl, v);
+		}
+
 		value *array_value = value_to_array(v);
 
 		Py_ssize_t iterator, array_size = (Py_ssize_t)value_type_count(v);
@@ -1426,6 +1570,20 @@ PyObject *py_loader_impl_value_to_capi(loader_impl impl, type_id id, value v)
 	}
 	else if (id == TYPE_MAP)
 	{
+		loader_impl_py py_impl = loader_impl_get(impl);
+		PyObject *view_obj = py_loader_impl_view_object(v);
+
+		if (view_obj != NULL)
+		{
+			Py_INCREF(view_obj);
+			return view_obj;
+		}
+
+		if (py_impl->proxy_threshold > 0 && value_type_count(v) >= py_impl->proxy_threshold)
+		{
+			return py_loader_impl_proxy_create(impl, v);
+		}
+
 		value *map_value = value_to_map(v);
 
 		Py_ssize_t iterator, map_size = (Py_ssize_t)value_type_count(v);
@@ -1535,6 +1693,116 @@ PyObject *py_loader_impl_value_to_capi(loader_impl impl, type_id id, value v)
 	return NULL;
 }
 
+static PyObject *py_loader_impl_value_to_capi_bool(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+	return PyBool_FromLong(value_to_bool(v) == 0 ? 0L : 1L);
+}
+
+static PyObject *py_loader_impl_value_to_capi_char(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+	return PyLong_FromLong((long)value_to_char(v));
+}
+
+static PyObject *py_loader_impl_value_to_capi_short(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+	return PyLong_FromLong((long)value_to_short(v));
+}
+
+static PyObject *py_loader_impl_value_to_capi_int(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+#if PY_MAJOR_VERSION == 2
+	return PyInt_FromLong((long)value_to_int(v));
+#elif PY_MAJOR_VERSION == 3
+	return PyLong_FromLong((long)value_to_int(v));
+#endif
+}
+
+static PyObject *py_loader_impl_value_to_capi_long(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+	return PyLong_FromLong(value_to_long(v));
+}
+
+static PyObject *py_loader_impl_value_to_capi_float(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+	return PyFloat_FromDouble((double)value_to_float(v));
+}
+
+static PyObject *py_loader_impl_value_to_capi_double(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+	return PyFloat_FromDouble(value_to_double(v));
+}
+
+static PyObject *py_loader_impl_value_to_capi_string(loader_impl impl, type_id id, value v)
+{
+	(void)impl;
+	(void)id;
+
+#if PY_MAJOR_VERSION == 2
+	return PyString_FromString(value_to_string(v));
+#elif PY_MAJOR_VERSION == 3
+	/* The size of the value includes the null terminator, use it to avoid measuring the string again */
+	size_t size = value_type_size(v);
+
+	return PyUnicode_FromStringAndSize(value_to_string(v), size > 0 ? (Py_ssize_t)(size - 1) : 0);
+#endif
+}
+
+py_loader_impl_value_to_capi_func py_loader_impl_value_to_capi_converter(type_id id)
+{
+	switch (id)
+	{
+		case TYPE_BOOL: {
+			return &py_loader_impl_value_to_capi_bool;
+		}
+		case TYPE_CHAR: {
+			return &py_loader_impl_value_to_capi_char;
+		}
+		case TYPE_SHORT: {
+			return &py_loader_impl_value_to_capi_short;
+		}
+		case TYPE_INT: {
+			return &py_loader_impl_value_to_capi_int;
+		}
+		case TYPE_LONG: {
+			return &py_loader_impl_value_to_capi_long;
+		}
+		case TYPE_FLOAT: {
+			return &py_loader_impl_value_to_capi_float;
+		}
+		case TYPE_DOUBLE: {
+			return &py_loader_impl_value_to_capi_double;
+		}
+		case TYPE_STRING: {
+			return &py_loader_impl_value_to_capi_string;
+		}
+		default: {
+			/* Complex types go through the generic conversion */
+			return &py_loader_impl_value_to_capi;
+		}
+	}
+}
+
 PyObject *py_task_callback_handler_impl(PyObject *self, PyObject *pyfuture)
 {
 	py_loader_thread_acquire();
@@ -1650,29 +1918,71 @@ function_return function_py_interface_invoke(function func, function_impl impl,
 		goto finalize;
 	}
 
-	PyObject *tuple_args = PyTuple_New(args_size);
+	/* The first slot is reserved so the callee can prepend a bound argument without copying the array */
+	PyObject *stack_args[PY_LOADER_IMPL_VECTORCALL_STACK_SIZE + 1];
+	PyObject **call_args = args_size <= PY_LOADER_IMPL_VECTORCALL_STACK_SIZE ? stack_args : malloc(sizeof(PyObject *) * (args_size + 1));
 
-	/* Allocate dynamically more space for values in case of variable arguments */
-	bool is_var_args = args_size > signature_args_size || py_func->values == NULL;
-	PyObject **values = is_var_args ? malloc(sizeof(PyObject *) * args_size) : py_func->values;
+	if (call_args == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid allocation of arguments in Python function call");
+		Py_LeaveRecursiveCall();
+		goto finalize;
+	}
+
+	PyObject **values = &call_args[1];
 
 	for (size_t args_count = 0; args_count < args_size; ++args_count)
 	{
-		type t = args_count < signature_args_size ? signature_get_type(s, args_count) : NULL;
-		type_id id = t == NULL ? value_type_id((value)args[args_count]) : type_index(t);
-		values[args_count] = py_loader_impl_value_to_capi(py_func->impl, id, args[args_count]);
+		if (args_count < signature_args_size && py_func->converters != NULL && py_func->converters[args_count].to_capi != NULL)
+		{
+			loader_impl_py_function_converter converter = &py_func->converters[args_count];
 
-		if (values[args_count] != NULL)
+			values[args_count] = converter->to_capi(py_func->impl, converter->id, args[args_count]);
+		}
+		else
+		{
+			type t = args_count < signature_args_size ? signature_get_type(s, args_count) : NULL;
+			type_id id = t == NULL ? value_type_id((value)args[args_count]) : type_index(t);
+
+			values[args_count] = py_loader_impl_value_to_capi_converter(id)(py_func->impl, id, args[args_count]);
+		}
+
+		if (values[args_count] == NULL)
 		{
-			PyTuple_SET_ITEM(tuple_args, args_count, values[args_count]);
+			Py_INCREF(Py_None);
+			values[args_count] = Py_None;
 		}
 	}
 
+#if PY_LOADER_IMPL_VECTORCALL
+	PyObject *result = PyObject_Vectorcall(py_func->func, values, args_size | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+#else
+	PyObject *tuple_args = PyTuple_New(args_size);
+
+	for (size_t args_count = 0; args_count < args_size; ++args_count)
+	{
+		Py_INCREF(values[args_count]);
+		PyTuple_SET_ITEM(tuple_args, args_count, values[args_count]);
+	}
+
 	PyObject *result = PyObject_CallObject(py_func->func, tuple_args);
 
+	Py_DECREF(tuple_args);
+#endif
+
 	/* End of recursive call */
 	Py_LeaveRecursiveCall();
 
+	for (size_t args_count = 0; args_count < args_size; ++args_count)
+	{
+		Py_DECREF(values[args_count]);
+	}
+
+	if (call_args != stack_args)
+	{
+		free(call_args);
+	}
+
 	if (PyErr_Occurred() != NULL)
 	{
 		v = py_loader_impl_error_value(py_impl);
@@ -1683,20 +1993,13 @@ function_return function_py_interface_invoke(function func, function_impl impl,
 		}
 	}
 
-	Py_XDECREF(tuple_args);
-
-	if (is_var_args)
-	{
-		free(values);
-	}
-
 	if (result == NULL || v != NULL)
 	{
+		Py_XDECREF(result);
 		goto finalize;
 	}
 
-	type_id id = ret_type == NULL ? py_loader_impl_capi_to_value_type(py_func->impl, result) : type_index(ret_type);
-	v = py_loader_impl_capi_to_value(py_func->impl, result, id);
+	v = ret_type == NULL ? py_loader_impl_capi_to_value_fast(py_func->impl, result) : py_loader_impl_capi_to_value(py_func->impl, result, type_index(ret_type));
 
 	Py_DECREF(result);
 finalize:
@@ -1856,12 +2159,18 @@ void function_py_interface_destroy(function func, function_impl impl)
 
 	if (py_func != NULL)
 	{
+		(void)func;
+
 		if (py_func->values != NULL)
 		{
-			(void)func;
 			free(py_func->values);
 		}
 
+		if (py_func->converters != NULL)
+		{
+			free(py_func->converters);
+		}
+
 		if (loader_is_destroyed(py_func->impl) != 0)
 		{
 			py_loader_thread_acquire();
@@ -2287,8 +2596,38 @@ int py_loader_impl_initialize_import(loader_impl_py py_impl)
 		"import sys\n"
 		"import importlib.util\n"
 		"import importlib\n"
+		"import marshal\n"
+		"from importlib.machinery import SourceFileLoader, SOURCE_SUFFIXES\n"
 		"from pathlib import Path\n"
 		"\n"
+		/* The default bytecode cache is validated with the modification time (in seconds) and the size of the source,
+		so a file rewritten within the same second with the same size (i.e. when reloading it) would run stale bytecode,
+		instead the bytecode is validated with the hash of the source (checked hash based pyc, PEP 552) */
+		"class SourceHashFileLoader(SourceFileLoader):\n"
+		"	flags = (3).to_bytes(4, 'little')\n"
+		"	def get_code(self, fullname):\n"
+		"		path = self.get_filename(fullname)\n"
+		"		source = self.get_data(path)\n"
+		"		source_hash = importlib.util.source_hash(source)\n"
+		"		try:\n"
+		"			bytecode_path = importlib.util.cache_from_source(path)\n"
+		"		except NotImplementedError:\n"
+		"			bytecode_path = None\n"
+		"		if bytecode_path is not None:\n"
+		"			try:\n"
+		"				data = self.get_data(bytecode_path)\n"
+		"				if data[:4] == importlib.util.MAGIC_NUMBER and data[4:8] == self.flags and data[8:16] == source_hash:\n"
+		"					return marshal.loads(data[16:])\n"
+		"			except (OSError, EOFError, ValueError, TypeError):\n"
+		"				pass\n"
+		"		code = self.source_to_code(source, path)\n"
+		"		if bytecode_path is not None and not sys.dont_write_bytecode:\n"
+		"			try:\n"
+		"				self.set_data(bytecode_path, importlib.util.MAGIC_NUMBER + self.flags + source_hash + marshal.dumps(code))\n"
+		"			except OSError:\n"
+		"				pass\n"
+		"		return code\n"
+		"\n"
 		"def load_from_spec(module_name, spec):\n"
 		"	m = importlib.util.module_from_spec(spec)\n"
 		"	spec.loader.exec_module(m)\n"
@@ -2311,7 +2650,8 @@ int py_loader_impl_initialize_import(loader_impl_py py_impl)
 		"			if not current_search_location in sys.path:\n"
 		"				search_location = current_search_location\n"
 		"				sys.path.insert(0, current_search_location)\n"
-		"			spec = importlib.util.spec_from_file_location(module_name, path, submodule_search_locations=[current_search_location])\n"
+		"			loader = SourceHashFileLoader(module_name, path) if hasattr(importlib.util, 'source_hash') and path.endswith(tuple(SOURCE_SUFFIXES)) else None\n"
+		"			spec = importlib.util.spec_from_file_location(module_name, path, loader=loader, submodule_search_locations=[current_search_location])\n"
 		"			if spec is None:\n"
 		"				if search_location is not None:\n"
 		"					sys.path.pop(0)\n"
@@ -2607,6 +2947,60 @@ static void PyCFunction_dealloc(PyObject *obj)
 	py_loader_thread_release();
 }
 
+static void py_loader_impl_initialize_cache(loader_impl_py py_impl)
+{
+	const char *cache_path = getenv(PY_LOADER_IMPL_CACHE_PATH);
+
+	py_impl->cache_path_size = 0;
+
+	if (cache_path == NULL || *cache_path == '\0')
+	{
+		return;
+	}
+
+	size_t size = strnlen(cache_path, PORTABILITY_PATH_SIZE) + 1;
+
+	if (size > PORTABILITY_PATH_SIZE)
+	{
+		log_write("metacall", LOG_LEVEL_WARNING, "Python loader cache path is too long, the cache will be disabled");
+		return;
+	}
+
+	memcpy(py_impl->cache_path, cache_path, size);
+
+	/* The cache directory is created if it does not exist, the parent must exist */
+#if defined(WIN32) || defined(_WIN32)
+	(void)_mkdir(py_impl->cache_path);
+#else
+	(void)mkdir(py_impl->cache_path, 0755);
+#endif
+
+	py_impl->cache_path_size = size;
+}
+
+static void py_loader_impl_initialize_proxy(loader_impl_py py_impl)
+{
+	const char *threshold = getenv(PY_LOADER_IMPL_PROXY_THRESHOLD);
+
+	py_impl->proxy_threshold = 0;
+
+	if (threshold == NULL || *threshold == '\0')
+	{
+		return;
+	}
+
+	char *end = NULL;
+	unsigned long long result = strtoull(threshold, &end, 10);
+
+	if (end == threshold || *end != '\0')
+	{
+		log_write("metacall", LOG_LEVEL_WARNING, "Invalid Python loader proxy threshold '%s', lazy views will be disabled", threshold);
+		return;
+	}
+
+	py_impl->proxy_threshold = (size_t)result;
+}
+
 loader_impl_data py_loader_impl_initialize(loader_impl impl, configuration config)
 {
 	(void)impl;
@@ -2623,6 +3017,10 @@ loader_impl_data py_loader_impl_initialize(loader_impl impl, configuration confi
 		goto error_alloc_py_impl;
 	}
 
+	py_loader_impl_initialize_cache(py_impl);
+
+	py_loader_impl_initialize_proxy(py_impl);
+
 	Py_InitializeEx(0);
 
 	if (Py_IsInitialized() == 0)
@@ -2714,6 +3112,11 @@ loader_impl_data py_loader_impl_initialize(loader_impl impl, configuration confi
 		goto error_after_asyncio_module;
 	}
 
+	if (py_loader_impl_proxy_type_init() < 0)
+	{
+		goto error_after_asyncio_module;
+	}
+
 	py_loader_thread_initialize();
 
 	/* Register initialization */
@@ -3193,14 +3596,188 @@ error_create_handle:
 	return NULL;
 }
 
+static uint64_t py_loader_impl_cache_hash(const loader_name name, const char *buffer, size_t size)
+{
+	/* FNV-1a of the module name and the source, the name is part of the code object so it belongs to the key */
+	uint64_t hash = UINT64_C(0xCBF29CE484222325);
+	size_t iterator, length = strnlen(name, LOADER_NAME_SIZE);
+
+	for (iterator = 0; iterator < length; ++iterator)
+	{
+		hash = (hash ^ (uint8_t)name[iterator]) * UINT64_C(0x100000001B3);
+	}
+
+	hash = (hash ^ 0) * UINT64_C(0x100000001B3);
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		hash = (hash ^ (uint8_t)buffer[iterator]) * UINT64_C(0x100000001B3);
+	}
+
+	return hash;
+}
+
+static int py_loader_impl_cache_file(loader_impl_py py_impl, uint64_t hash, char *path)
+{
+	char file[0x20];
+	int length = snprintf(file, sizeof(file), "%016" PRIx64 PY_LOADER_IMPL_CACHE_EXTENSION, hash);
+
+	if (length <= 0 || (size_t)length >= sizeof(file))
+	{
+		return 1;
+	}
+
+	return portability_path_join(py_impl->cache_path, py_impl->cache_path_size, file, (size_t)length + 1, path, PORTABILITY_PATH_SIZE) == 0;
+}
+
+static PyObject *py_loader_impl_cache_load(const char *path, const struct loader_impl_py_cache_header_type *key, const loader_name name, const char *buffer)
+{
+	struct loader_impl_py_cache_header_type header;
+	PyObject *compiled = NULL;
+	char *data = NULL;
+	long data_size, key_size;
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL)
+	{
+		return NULL;
+	}
+
+	if (fread(&header, sizeof(struct loader_impl_py_cache_header_type), 1, file) != 1 ||
+		header.magic != key->magic || header.hash != key->hash || header.name_size != key->name_size || header.size != key->size)
+	{
+		goto close;
+	}
+
+	/* The entry is made of the header, the name and the source which generated it, and the marshaled code */
+	key_size = (long)(header.name_size + header.size);
+
+	if (fseek(file, 0, SEEK_END) != 0 || (data_size = ftell(file) - (long)sizeof(struct loader_impl_py_cache_header_type)) <= key_size ||
+		fseek(file, (long)sizeof(struct loader_impl_py_cache_header_type), SEEK_SET) != 0)
+	{
+		goto close;
+	}
+
+	data = malloc(sizeof(char) * data_size);
+
+	if (data == NULL || fread(data, sizeof(char), (size_t)data_size, file) != (size_t)data_size)
+	{
+		goto close;
+	}
+
+	/* The hash only selects the entry, a collision with another module is detected by comparing the name and the source */
+	if (memcmp(data, name, (size_t)header.name_size) != 0 || memcmp(&data[header.name_size], buffer, (size_t)header.size) != 0)
+	{
+		goto close;
+	}
+
+	compiled = PyMarshal_ReadObjectFromString(&data[key_size], (Py_ssize_t)(data_size - key_size));
+
+	if (compiled == NULL || !PyCode_Check(compiled))
+	{
+		/* A corrupted entry is not an error, the source will be compiled again */
+		Py_XDECREF(compiled);
+		compiled = NULL;
+
+		if (PyErr_Occurred() != NULL)
+		{
+			PyErr_Clear();
+		}
+	}
+
+close:
+	free(data);
+	fclose(file);
+
+	return compiled;
+}
+
+static void py_loader_impl_cache_store(const char *path, const struct loader_impl_py_cache_header_type *header, const loader_name name, const char *buffer, PyObject *compiled)
+{
+	char tmp[PORTABILITY_PATH_SIZE];
+	PyObject *bytes = PyMarshal_WriteObjectToString(compiled, Py_MARSHAL_VERSION);
+	FILE *file;
+	int length;
+
+	if (bytes == NULL)
+	{
+		PyErr_Clear();
+		return;
+	}
+
+	/* Write into a temporary file and rename it, so other processes never read an incomplete entry */
+	length = snprintf(tmp, PORTABILITY_PATH_SIZE, "%s.%lu.tmp", path, (unsigned long)thread_id_get_current());
+
+	if (length <= 0 || length >= PORTABILITY_PATH_SIZE)
+	{
+		goto error;
+	}
+
+	file = fopen(tmp, "wb");
+
+	if (file == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_WARNING, "Python loader failed to create the cache file: %s", tmp);
+		goto error;
+	}
+
+	if (fwrite(header, sizeof(struct loader_impl_py_cache_header_type), 1, file) != 1 ||
+		fwrite(name, sizeof(char), (size_t)header->name_size, file) != (size_t)header->name_size ||
+		fwrite(buffer, sizeof(char), (size_t)header->size, file) != (size_t)header->size ||
+		fwrite(PyBytes_AS_STRING(bytes), sizeof(char), (size_t)PyBytes_GET_SIZE(bytes), file) != (size_t)PyBytes_GET_SIZE(bytes))
+	{
+		fclose(file);
+		remove(tmp);
+		goto error;
+	}
+
+	if (fclose(file) != 0 || rename(tmp, path) != 0)
+	{
+		remove(tmp);
+	}
+
+error:
+	Py_DECREF(bytes);
+}
+
 PyObject *py_loader_impl_load_from_memory_compile(loader_impl_py py_impl, const loader_name name, const char *buffer)
 {
-	PyObject *compiled = Py_CompileString(buffer, name, Py_file_input);
+	char path[PORTABILITY_PATH_SIZE];
+	struct loader_impl_py_cache_header_type header;
+	PyObject *compiled = NULL;
+	int cached = 1;
+
+	if (py_impl->cache_path_size > 0)
+	{
+		size_t size = strlen(buffer);
+
+		header.magic = PyImport_GetMagicNumber();
+		header.hash = py_loader_impl_cache_hash(name, buffer, size);
+		header.name_size = (uint64_t)strnlen(name, LOADER_NAME_SIZE);
+		header.size = (uint64_t)size;
+
+		cached = py_loader_impl_cache_file(py_impl, header.hash, path);
+
+		if (cached == 0)
+		{
+			compiled = py_loader_impl_cache_load(path, &header, name, buffer);
+		}
+	}
 
 	if (compiled == NULL)
 	{
-		py_loader_impl_error_print(py_impl);
-		return NULL;
+		compiled = Py_CompileString(buffer, name, Py_file_input);
+
+		if (compiled == NULL)
+		{
+			py_loader_impl_error_print(py_impl);
+			return NULL;
+		}
+
+		if (cached == 0)
+		{
+			py_loader_impl_cache_store(path, &header, name, buffer, compiled);
+		}
 	}
 
 	PyObject *instance = PyImport_ExecCodeModule(name, compiled);
@@ -3466,6 +4043,31 @@ int py_loader_impl_discover_func(loader_impl impl, PyObject *func, function f)
 	return 1;
 }
 
+void py_loader_impl_discover_func_converters(loader_impl_py_function py_func, function f)
+{
+	signature s = function_signature(f);
+	const size_t args_size = signature_count(s);
+
+	if (py_func->converters == NULL)
+	{
+		return;
+	}
+
+	/* Untyped arguments are left without converter, they are resolved by the value type on each call */
+	for (size_t iterator = 0; iterator < args_size; ++iterator)
+	{
+		type t = signature_get_type(s, iterator);
+
+		if (t != NULL)
+		{
+			type_id id = type_index(t);
+
+			py_func->converters[iterator].id = id;
+			py_func->converters[iterator].to_capi = py_loader_impl_value_to_capi_converter(id);
+		}
+	}
+}
+
 int py_loader_impl_discover_method(loader_impl impl, PyObject *callable, method m, bool is_static)
 {
 	loader_impl_py py_impl = loader_impl_get(impl);
@@ -3936,6 +4538,8 @@ int py_loader_impl_discover_module(loader_impl impl, PyObject *module, context c
 
 			if (py_loader_impl_discover_func(impl, module_dict_val, f) == 0)
 			{
+				py_loader_impl_discover_func_converters(py_func, f);
+
 				scope sp = context_scope(ctx);
 				value v = value_create_function(f);
 				if (scope_define(sp, func_name, v) != 0)
@@ -4233,3 +4837,65 @@ int py_loader_impl_destroy(loader_impl impl)
 
 	return result;
 }
+
+int py_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id)
+{
+	switch (id)
+	{
+		case LOADER_IMPL_FORK_PREPARE: {
+			/* Hold the GIL across the fork, so the child does not inherit the interpreter in an inconsistent state */
+			py_loader_thread_acquire();
+#if PY_VERSION_HEX >= 0x03070000
+			PyOS_BeforeFork();
+#endif
+			return 0;
+		}
+
+		case LOADER_IMPL_FORK_PARENT: {
+#if PY_VERSION_HEX >= 0x03070000
+			PyOS_AfterFork_Parent();
+#endif
+			py_loader_thread_release();
+			return 0;
+		}
+
+		case LOADER_IMPL_FORK_CHILD: {
+			loader_impl_py py_impl = loader_impl_get(impl);
+			PyObject *args_tuple, *asyncio_loop;
+
+			/* Reinitialize the GIL, the import lock and the thread states of the threads that do not exist anymore */
+#if PY_VERSION_HEX >= 0x03070000
+			PyOS_AfterFork_Child();
+#else
+			PyOS_AfterFork();
+#endif
+
+			/* The thread of the asyncio event loop does not exist in the child, the inherited loop is still marked
+			* as running so it cannot be run nor closed again, start a new event loop thread for the async calls */
+			args_tuple = PyTuple_New(0);
+			asyncio_loop = PyObject_Call(py_impl->thread_background_start, args_tuple, NULL);
+			Py_XDECREF(args_tuple);
+
+			if (asyncio_loop == NULL)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Error produced while starting the asyncio thread in the forked child");
+
+				if (PyErr_Occurred() != NULL)
+				{
+					py_loader_impl_error_print(py_impl);
+				}
+
+				py_loader_thread_release();
+				return 1;
+			}
+
+			Py_DECREF(py_impl->asyncio_loop);
+			py_impl->asyncio_loop = asyncio_loop;
+
+			py_loader_thread_release();
+			return 0;
+		}
+	}
+
+	return 1;
+}
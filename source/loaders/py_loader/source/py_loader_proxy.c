@@ -0,0 +1,1050 @@
+/*
+ *	Loader Library by Parra Studios
+ *	A plugin for loading python code at run-time into a process.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <py_loader/py_loader_impl.h>
+#include <py_loader/py_loader_proxy.h>
+#include <py_loader/py_loader_threading.h>
+
+#include <loader/loader.h>
+
+#include <reflect/reflect_value_type.h>
+
+#include <log/log.h>
+
+#include <stdlib.h>
+
+/* Lazy views of arrays and maps, they keep a shared reference to the value and convert */
+/* each element only when it is accessed, so the cost depends on the elements touched */
+struct py_loader_impl_proxy_obj
+{
+	PyObject_HEAD
+
+	loader_impl impl;
+	value v;
+	PyObject **items; /* Converted elements (or map values), allocated on first access */
+	PyObject *index;  /* Dictionary from key to position (only for maps), built on first lookup */
+};
+
+/* Views of lists, tuples and dicts, the values backed by them convert each element */
+/* only when it is accessed, so passing them to another loader does not walk them */
+struct py_loader_impl_view_type
+{
+	loader_impl impl;
+	PyObject *obj;
+	PyObject *keys;	 /* String keys in iteration order (only for maps), they define the position of each tuple */
+	PyObject *index; /* Dictionary from key to position (only for maps), built on first lookup */
+};
+
+static value py_loader_impl_view_element(void *source, size_t index);
+
+static int py_loader_impl_view_find(void *source, const char *key, size_t length, size_t *index);
+
+static void py_loader_impl_view_destroy(void *source);
+
+static struct value_view_interface_type py_loader_impl_view_interface = {
+	&py_loader_impl_view_element,
+	&py_loader_impl_view_find,
+	&py_loader_impl_view_destroy
+};
+
+static void py_loader_impl_proxy_dealloc(struct py_loader_impl_proxy_obj *self);
+
+static PyObject *py_loader_impl_proxy_repr(struct py_loader_impl_proxy_obj *self);
+
+static Py_ssize_t py_loader_impl_proxy_length(struct py_loader_impl_proxy_obj *self);
+
+static PyObject *py_loader_impl_proxy_array_item(struct py_loader_impl_proxy_obj *self, Py_ssize_t i);
+
+static PyObject *py_loader_impl_proxy_array_subscript(struct py_loader_impl_proxy_obj *self, PyObject *key);
+
+static int py_loader_impl_proxy_array_contains(struct py_loader_impl_proxy_obj *self, PyObject *key);
+
+static PyObject *py_loader_impl_proxy_array_iter(struct py_loader_impl_proxy_obj *self);
+
+static PyObject *py_loader_impl_proxy_array_index(struct py_loader_impl_proxy_obj *self, PyObject *args);
+
+static PyObject *py_loader_impl_proxy_array_count(struct py_loader_impl_proxy_obj *self, PyObject *key);
+
+static PyObject *py_loader_impl_proxy_map_subscript(struct py_loader_impl_proxy_obj *self, PyObject *key);
+
+static int py_loader_impl_proxy_map_contains(struct py_loader_impl_proxy_obj *self, PyObject *key);
+
+static PyObject *py_loader_impl_proxy_map_iter(struct py_loader_impl_proxy_obj *self);
+
+static PyObject *py_loader_impl_proxy_map_keys(struct py_loader_impl_proxy_obj *self, PyObject *Py_UNUSED(unused));
+
+static PyObject *py_loader_impl_proxy_map_values(struct py_loader_impl_proxy_obj *self, PyObject *Py_UNUSED(unused));
+
+static PyObject *py_loader_impl_proxy_map_items(struct py_loader_impl_proxy_obj *self, PyObject *Py_UNUSED(unused));
+
+static PyObject *py_loader_impl_proxy_map_get(struct py_loader_impl_proxy_obj *self, PyObject *args);
+
+static PyObject *py_loader_impl_proxy_map_richcompare(struct py_loader_impl_proxy_obj *self, PyObject *other, int op);
+
+static PySequenceMethods py_loader_impl_proxy_array_as_sequence = {
+	(lenfunc)py_loader_impl_proxy_length,			 /* sq_length */
+	0,												 /* sq_concat */
+	0,												 /* sq_repeat */
+	(ssizeargfunc)py_loader_impl_proxy_array_item,	 /* sq_item */
+	0,												 /* was_sq_slice */
+	0,												 /* sq_ass_item */
+	0,												 /* was_sq_ass_slice */
+	(objobjproc)py_loader_impl_proxy_array_contains, /* sq_contains */
+	0,												 /* sq_inplace_concat */
+	0,												 /* sq_inplace_repeat */
+};
+
+static PyMappingMethods py_loader_impl_proxy_array_as_mapping = {
+	(lenfunc)py_loader_impl_proxy_length,			  /* mp_length */
+	(binaryfunc)py_loader_impl_proxy_array_subscript, /* mp_subscript */
+	0,												  /* mp_ass_subscript */
+};
+
+static PySequenceMethods py_loader_impl_proxy_map_as_sequence = {
+	0,											   /* sq_length */
+	0,											   /* sq_concat */
+	0,											   /* sq_repeat */
+	0,											   /* sq_item */
+	0,											   /* was_sq_slice */
+	0,											   /* sq_ass_item */
+	0,											   /* was_sq_ass_slice */
+	(objobjproc)py_loader_impl_proxy_map_contains, /* sq_contains */
+	0,											   /* sq_inplace_concat */
+	0,											   /* sq_inplace_repeat */
+};
+
+static PyMappingMethods py_loader_impl_proxy_map_as_mapping = {
+	(lenfunc)py_loader_impl_proxy_length,			/* mp_length */
+	(binaryfunc)py_loader_impl_proxy_map_subscript,	/* mp_subscript */
+	0,												/* mp_ass_subscript */
+};
+
+/* Same methods as the mixins of collections.abc.Sequence, which are not inherited by registering the type, reversed works through the index */
+static struct PyMethodDef py_loader_impl_proxy_array_methods[] = {
+	{ "index", (PyCFunction)py_loader_impl_proxy_array_index, METH_VARARGS, PyDoc_STR("Get the first index of a value.") },
+	{ "count", (PyCFunction)py_loader_impl_proxy_array_count, METH_O, PyDoc_STR("Get the number of occurrences of a value.") },
+	{ NULL, NULL, 0, NULL }
+};
+
+/* Same methods as the mixins of collections.abc.Mapping, which are not inherited by registering the type */
+static struct PyMethodDef py_loader_impl_proxy_map_methods[] = {
+	{ "keys", (PyCFunction)py_loader_impl_proxy_map_keys, METH_NOARGS, PyDoc_STR("Get the list of keys.") },
+	{ "values", (PyCFunction)py_loader_impl_proxy_map_values, METH_NOARGS, PyDoc_STR("Get the list of values.") },
+	{ "items", (PyCFunction)py_loader_impl_proxy_map_items, METH_NOARGS, PyDoc_STR("Get the list of key and value pairs.") },
+	{ "get", (PyCFunction)py_loader_impl_proxy_map_get, METH_VARARGS, PyDoc_STR("Get the value of a key or a default value.") },
+	{ NULL, NULL, 0, NULL }
+};
+
+static PyTypeObject py_loader_impl_proxy_array_type = {
+	PyVarObject_HEAD_INIT(NULL, 0) "ArrayProxy",
+	sizeof(struct py_loader_impl_proxy_obj),
+	0,
+	(destructor)py_loader_impl_proxy_dealloc,	  /* tp_dealloc */
+	0,											  /* tp_vectorcall_offset */
+	0,											  /* tp_getattr */
+	0,											  /* tp_setattr */
+	0,											  /* tp_as_async */
+	(reprfunc)py_loader_impl_proxy_repr,		  /* tp_repr */
+	0,											  /* tp_as_number */
+	&py_loader_impl_proxy_array_as_sequence,	  /* tp_as_sequence */
+	&py_loader_impl_proxy_array_as_mapping,		  /* tp_as_mapping */
+	0,											  /* tp_hash */
+	0,											  /* tp_call */
+	0,											  /* tp_str */
+	0,											  /* tp_getattro */
+	0,											  /* tp_setattro */
+	0,											  /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,							  /* tp_flags */
+	PyDoc_STR("Lazy view of a MetaCall array"),	  /* tp_doc */
+	0,											  /* tp_traverse */
+	0,											  /* tp_clear */
+	0,											  /* tp_richcompare */
+	0,											  /* tp_weaklistoffset */
+	(getiterfunc)py_loader_impl_proxy_array_iter, /* tp_iter */
+	0,											  /* tp_iternext */
+	py_loader_impl_proxy_array_methods,			  /* tp_methods */
+	0,											  /* tp_members */
+	0,											  /* tp_getset */
+	0,											  /* tp_base */
+	0,											  /* tp_dict */
+	0,											  /* tp_descr_get */
+	0,											  /* tp_descr_set */
+	0,											  /* tp_dictoffset */
+	0,											  /* tp_init */
+	0,											  /* tp_alloc */
+	0,											  /* tp_new */
+	0,											  /* tp_free */
+	0,											  /* tp_is_gc */
+	0,											  /* tp_bases */
+	0,											  /* tp_mro */
+	0,											  /* tp_cache */
+	0,											  /* tp_subclasses */
+	0,											  /* tp_weaklist */
+	0,											  /* tp_del */
+	0,											  /* tp_version_tag */
+	0,											  /* tp_finalize */
+	0,											  /* tp_vectorcall */
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 12
+	0, /* tp_watched */
+#endif
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 13
+	0, /* tp_versions_used */
+#endif
+};
+
+static PyTypeObject py_loader_impl_proxy_map_type = {
+	PyVarObject_HEAD_INIT(NULL, 0) "MapProxy",
+	sizeof(struct py_loader_impl_proxy_obj),
+	0,
+	(destructor)py_loader_impl_proxy_dealloc,		   /* tp_dealloc */
+	0,												   /* tp_vectorcall_offset */
+	0,												   /* tp_getattr */
+	0,												   /* tp_setattr */
+	0,												   /* tp_as_async */
+	(reprfunc)py_loader_impl_proxy_repr,			   /* tp_repr */
+	0,												   /* tp_as_number */
+	&py_loader_impl_proxy_map_as_sequence,			   /* tp_as_sequence */
+	&py_loader_impl_proxy_map_as_mapping,			   /* tp_as_mapping */
+	0,												   /* tp_hash */
+	0,												   /* tp_call */
+	0,												   /* tp_str */
+	0,												   /* tp_getattro */
+	0,												   /* tp_setattro */
+	0,												   /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,								   /* tp_flags */
+	PyDoc_STR("Lazy view of a MetaCall map"),		   /* tp_doc */
+	0,												   /* tp_traverse */
+	0,												   /* tp_clear */
+	(richcmpfunc)py_loader_impl_proxy_map_richcompare, /* tp_richcompare */
+	0,												   /* tp_weaklistoffset */
+	(getiterfunc)py_loader_impl_proxy_map_iter,		   /* tp_iter */
+	0,												   /* tp_iternext */
+	py_loader_impl_proxy_map_methods,				   /* tp_methods */
+	0,												   /* tp_members */
+	0,												   /* tp_getset */
+	0,												   /* tp_base */
+	0,												   /* tp_dict */
+	0,												   /* tp_descr_get */
+	0,												   /* tp_descr_set */
+	0,												   /* tp_dictoffset */
+	0,												   /* tp_init */
+	0,												   /* tp_alloc */
+	0,												   /* tp_new */
+	0,												   /* tp_free */
+	0,												   /* tp_is_gc */
+	0,												   /* tp_bases */
+	0,												   /* tp_mro */
+	0,												   /* tp_cache */
+	0,												   /* tp_subclasses */
+	0,												   /* tp_weaklist */
+	0,												   /* tp_del */
+	0,												   /* tp_version_tag */
+	0,												   /* tp_finalize */
+	0,												   /* tp_vectorcall */
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 12
+	0, /* tp_watched */
+#endif
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 13
+	0, /* tp_versions_used */
+#endif
+};
+
+void py_loader_impl_proxy_dealloc(struct py_loader_impl_proxy_obj *self)
+{
+	if (self->items != NULL)
+	{
+		Py_ssize_t iterator, size = (Py_ssize_t)value_type_count(self->v);
+
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			Py_XDECREF(self->items[iterator]);
+		}
+
+		free(self->items);
+	}
+
+	Py_XDECREF(self->index);
+
+	value_type_destroy(self->v);
+
+	PyObject_Del((PyObject *)self);
+}
+
+static PyObject *py_loader_impl_proxy_map_dict(PyObject *obj)
+{
+	PyObject *dict = PyDict_New();
+
+	if (dict == NULL)
+	{
+		return NULL;
+	}
+
+	if (PyDict_Merge(dict, obj, 1) != 0)
+	{
+		Py_DECREF(dict);
+		return NULL;
+	}
+
+	return dict;
+}
+
+PyObject *py_loader_impl_proxy_repr(struct py_loader_impl_proxy_obj *self)
+{
+	/* Representation requires converting everything, it is only intended for debugging */
+	PyObject *materialized = Py_TYPE(self) == &py_loader_impl_proxy_map_type ? py_loader_impl_proxy_map_dict((PyObject *)self) : PySequence_List((PyObject *)self);
+
+	if (materialized == NULL)
+	{
+		return NULL;
+	}
+
+	PyObject *repr = PyObject_Repr(materialized);
+
+	Py_DECREF(materialized);
+
+	return repr;
+}
+
+Py_ssize_t py_loader_impl_proxy_length(struct py_loader_impl_proxy_obj *self)
+{
+	return (Py_ssize_t)value_type_count(self->v);
+}
+
+static PyObject *py_loader_impl_proxy_element(struct py_loader_impl_proxy_obj *self, Py_ssize_t i, value element)
+{
+	if (self->items == NULL)
+	{
+		size_t size = value_type_count(self->v);
+
+		self->items = calloc(size, sizeof(PyObject *));
+
+		if (self->items == NULL)
+		{
+			return PyErr_NoMemory();
+		}
+	}
+
+	if (self->items[i] == NULL)
+	{
+		PyObject *item = py_loader_impl_value_to_capi(self->impl, value_type_id(element), element);
+
+		if (item == NULL)
+		{
+			if (PyErr_Occurred() == NULL)
+			{
+				PyErr_Format(PyExc_TypeError, "Element %zd of the proxy cannot be converted", i);
+			}
+
+			return NULL;
+		}
+
+		self->items[i] = item;
+	}
+
+	Py_INCREF(self->items[i]);
+
+	return self->items[i];
+}
+
+PyObject *py_loader_impl_proxy_array_item(struct py_loader_impl_proxy_obj *self, Py_ssize_t i)
+{
+	if (i < 0 || i >= (Py_ssize_t)value_type_count(self->v))
+	{
+		PyErr_SetString(PyExc_IndexError, "ArrayProxy index out of range");
+		return NULL;
+	}
+
+	return py_loader_impl_proxy_element(self, i, value_type_at(self->v, (size_t)i));
+}
+
+PyObject *py_loader_impl_proxy_array_subscript(struct py_loader_impl_proxy_obj *self, PyObject *key)
+{
+	Py_ssize_t size = (Py_ssize_t)value_type_count(self->v);
+
+	if (PyIndex_Check(key))
+	{
+		Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+
+		if (i == -1 && PyErr_Occurred() != NULL)
+		{
+			return NULL;
+		}
+
+		if (i < 0)
+		{
+			i += size;
+		}
+
+		return py_loader_impl_proxy_array_item(self, i);
+	}
+	else if (PySlice_Check(key))
+	{
+		Py_ssize_t start, stop, step, length, iterator, i;
+
+		if (PySlice_Unpack(key, &start, &stop, &step) < 0)
+		{
+			return NULL;
+		}
+
+		length = PySlice_AdjustIndices(size, &start, &stop, step);
+
+		PyObject *list = PyList_New(length);
+
+		if (list == NULL)
+		{
+			return NULL;
+		}
+
+		for (iterator = 0, i = start; iterator < length; ++iterator, i += step)
+		{
+			PyObject *item = py_loader_impl_proxy_array_item(self, i);
+
+			if (item == NULL)
+			{
+				Py_DECREF(list);
+				return NULL;
+			}
+
+			PyList_SET_ITEM(list, iterator, item);
+		}
+
+		return list;
+	}
+
+	PyErr_Format(PyExc_TypeError, "ArrayProxy indices must be integers or slices, not %.200s", Py_TYPE(key)->tp_name);
+
+	return NULL;
+}
+
+int py_loader_impl_proxy_array_contains(struct py_loader_impl_proxy_obj *self, PyObject *key)
+{
+	Py_ssize_t iterator, size = (Py_ssize_t)value_type_count(self->v);
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		PyObject *item = py_loader_impl_proxy_array_item(self, iterator);
+
+		if (item == NULL)
+		{
+			return -1;
+		}
+
+		int result = PyObject_RichCompareBool(item, key, Py_EQ);
+
+		Py_DECREF(item);
+
+		if (result != 0)
+		{
+			return result;
+		}
+	}
+
+	return 0;
+}
+
+PyObject *py_loader_impl_proxy_array_iter(struct py_loader_impl_proxy_obj *self)
+{
+	/* Elements are converted one by one while iterating */
+	return PySeqIter_New((PyObject *)self);
+}
+
+PyObject *py_loader_impl_proxy_array_index(struct py_loader_impl_proxy_obj *self, PyObject *args)
+{
+	Py_ssize_t size = (Py_ssize_t)value_type_count(self->v);
+	Py_ssize_t start = 0, stop = PY_SSIZE_T_MAX, iterator;
+	PyObject *key;
+
+	if (!PyArg_ParseTuple(args, "O|nn:index", &key, &start, &stop))
+	{
+		return NULL;
+	}
+
+	/* Same bounds as list.index */
+	if (start < 0)
+	{
+		start = start + size < 0 ? 0 : start + size;
+	}
+
+	if (stop < 0)
+	{
+		stop += size;
+	}
+
+	for (iterator = start; iterator < stop && iterator < size; ++iterator)
+	{
+		PyObject *item = py_loader_impl_proxy_array_item(self, iterator);
+
+		if (item == NULL)
+		{
+			return NULL;
+		}
+
+		int result = PyObject_RichCompareBool(item, key, Py_EQ);
+
+		Py_DECREF(item);
+
+		if (result > 0)
+		{
+			return PyLong_FromSsize_t(iterator);
+		}
+		else if (result < 0)
+		{
+			return NULL;
+		}
+	}
+
+	PyErr_SetString(PyExc_ValueError, "ArrayProxy.index(x): x not in proxy");
+
+	return NULL;
+}
+
+PyObject *py_loader_impl_proxy_array_count(struct py_loader_impl_proxy_obj *self, PyObject *key)
+{
+	Py_ssize_t iterator, size = (Py_ssize_t)value_type_count(self->v), count = 0;
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		PyObject *item = py_loader_impl_proxy_array_item(self, iterator);
+
+		if (item == NULL)
+		{
+			return NULL;
+		}
+
+		int result = PyObject_RichCompareBool(item, key, Py_EQ);
+
+		Py_DECREF(item);
+
+		if (result < 0)
+		{
+			return NULL;
+		}
+
+		count += result;
+	}
+
+	return PyLong_FromSsize_t(count);
+}
+
+static PyObject *py_loader_impl_proxy_map_index(struct py_loader_impl_proxy_obj *self)
+{
+	if (self->index == NULL)
+	{
+		size_t iterator, size = value_type_count(self->v);
+		PyObject *index = PyDict_New();
+
+		if (index == NULL)
+		{
+			return NULL;
+		}
+
+		/* Only the keys are converted, values are left until they are accessed */
+		for (iterator = 0; iterator < size; ++iterator)
+		{
+			value *pair_value = value_to_array(value_type_at(self->v, iterator));
+			PyObject *key = py_loader_impl_value_to_capi(self->impl, value_type_id(pair_value[0]), pair_value[0]);
+			PyObject *position = PyLong_FromSize_t(iterator);
+			int result = (key == NULL || position == NULL) ? -1 : PyDict_SetItem(index, key, position);
+
+			Py_XDECREF(key);
+			Py_XDECREF(position);
+
+			if (result != 0)
+			{
+				if (PyErr_Occurred() == NULL)
+				{
+					PyErr_SetString(PyExc_TypeError, "MapProxy key cannot be converted");
+				}
+
+				Py_DECREF(index);
+				return NULL;
+			}
+		}
+
+		self->index = index;
+	}
+
+	return self->index;
+}
+
+PyObject *py_loader_impl_proxy_map_subscript(struct py_loader_impl_proxy_obj *self, PyObject *key)
+{
+	PyObject *index = py_loader_impl_proxy_map_index(self);
+
+	if (index == NULL)
+	{
+		return NULL;
+	}
+
+	PyObject *position = PyDict_GetItemWithError(index, key);
+
+	if (position == NULL)
+	{
+		if (PyErr_Occurred() == NULL)
+		{
+			PyErr_SetObject(PyExc_KeyError, key);
+		}
+
+		return NULL;
+	}
+
+	Py_ssize_t i = PyLong_AsSsize_t(position);
+	value *pair_value = value_to_array(value_type_at(self->v, (size_t)i));
+
+	return py_loader_impl_proxy_element(self, i, pair_value[1]);
+}
+
+int py_loader_impl_proxy_map_contains(struct py_loader_impl_proxy_obj *self, PyObject *key)
+{
+	PyObject *index = py_loader_impl_proxy_map_index(self);
+
+	if (index == NULL)
+	{
+		return -1;
+	}
+
+	return PyDict_Contains(index, key);
+}
+
+PyObject *py_loader_impl_proxy_map_iter(struct py_loader_impl_proxy_obj *self)
+{
+	PyObject *index = py_loader_impl_proxy_map_index(self);
+
+	if (index == NULL)
+	{
+		return NULL;
+	}
+
+	/* Maps preserve the insertion order, so keys are iterated in the same order of the value */
+	return PyObject_GetIter(index);
+}
+
+PyObject *py_loader_impl_proxy_map_keys(struct py_loader_impl_proxy_obj *self, PyObject *Py_UNUSED(unused))
+{
+	PyObject *index = py_loader_impl_proxy_map_index(self);
+
+	if (index == NULL)
+	{
+		return NULL;
+	}
+
+	return PyDict_Keys(index);
+}
+
+static PyObject *py_loader_impl_proxy_map_list(struct py_loader_impl_proxy_obj *self, int with_keys)
+{
+	PyObject *index = py_loader_impl_proxy_map_index(self);
+
+	if (index == NULL)
+	{
+		return NULL;
+	}
+
+	PyObject *list = PyList_New(PyDict_Size(index));
+	PyObject *key, *position;
+	Py_ssize_t iterator = 0, list_iterator = 0;
+
+	if (list == NULL)
+	{
+		return NULL;
+	}
+
+	/* Iterate through the index so duplicated keys resolve to the same value as the subscript */
+	while (PyDict_Next(index, &iterator, &key, &position))
+	{
+		Py_ssize_t i = PyLong_AsSsize_t(position);
+		value *pair_value = value_to_array(value_type_at(self->v, (size_t)i));
+		PyObject *item = py_loader_impl_proxy_element(self, i, pair_value[1]);
+
+		if (item != NULL && with_keys)
+		{
+			PyObject *pair = PyTuple_Pack(2, key, item);
+
+			Py_DECREF(item);
+			item = pair;
+		}
+
+		if (item == NULL)
+		{
+			Py_DECREF(list);
+			return NULL;
+		}
+
+		PyList_SET_ITEM(list, list_iterator++, item);
+	}
+
+	return list;
+}
+
+PyObject *py_loader_impl_proxy_map_values(struct py_loader_impl_proxy_obj *self, PyObject *Py_UNUSED(unused))
+{
+	return py_loader_impl_proxy_map_list(self, 0);
+}
+
+PyObject *py_loader_impl_proxy_map_items(struct py_loader_impl_proxy_obj *self, PyObject *Py_UNUSED(unused))
+{
+	return py_loader_impl_proxy_map_list(self, 1);
+}
+
+PyObject *py_loader_impl_proxy_map_get(struct py_loader_impl_proxy_obj *self, PyObject *args)
+{
+	PyObject *key, *default_value = Py_None;
+
+	if (!PyArg_ParseTuple(args, "O|O:get", &key, &default_value))
+	{
+		return NULL;
+	}
+
+	PyObject *result = py_loader_impl_proxy_map_subscript(self, key);
+
+	if (result == NULL && PyErr_ExceptionMatches(PyExc_KeyError))
+	{
+		PyErr_Clear();
+		Py_INCREF(default_value);
+		return default_value;
+	}
+
+	return result;
+}
+
+PyObject *py_loader_impl_proxy_map_richcompare(struct py_loader_impl_proxy_obj *self, PyObject *other, int op)
+{
+	/* Same as collections.abc.Mapping, two mappings are equal if they have the same items */
+	if ((op != Py_EQ && op != Py_NE) || (!PyDict_Check(other) && Py_TYPE(other) != &py_loader_impl_proxy_map_type))
+	{
+		Py_RETURN_NOTIMPLEMENTED;
+	}
+
+	PyObject *dict = py_loader_impl_proxy_map_dict((PyObject *)self);
+
+	if (dict == NULL)
+	{
+		return NULL;
+	}
+
+	PyObject *other_dict = PyDict_Check(other) ? (Py_INCREF(other), other) : py_loader_impl_proxy_map_dict(other);
+
+	if (other_dict == NULL)
+	{
+		Py_DECREF(dict);
+		return NULL;
+	}
+
+	PyObject *result = PyObject_RichCompare(dict, other_dict, op);
+
+	Py_DECREF(dict);
+	Py_DECREF(other_dict);
+
+	return result;
+}
+
+static int py_loader_impl_proxy_register(PyObject *abc, const char *name, PyTypeObject *type)
+{
+	PyObject *base = PyObject_GetAttrString(abc, name);
+
+	if (base == NULL)
+	{
+		return -1;
+	}
+
+	PyObject *result = PyObject_CallMethod(base, "register", "O", (PyObject *)type);
+
+	Py_DECREF(base);
+
+	if (result == NULL)
+	{
+		return -1;
+	}
+
+	Py_DECREF(result);
+
+	return 0;
+}
+
+int py_loader_impl_proxy_type_init(void)
+{
+	if (PyType_Ready(&py_loader_impl_proxy_array_type) < 0 || PyType_Ready(&py_loader_impl_proxy_map_type) < 0)
+	{
+		return -1;
+	}
+
+	/* Register the proxies as abstract sequence and mapping, so isinstance checks keep working, the mixin methods are implemented by the types */
+	PyObject *abc = PyImport_ImportModule("collections.abc");
+
+	if (abc == NULL)
+	{
+		return -1;
+	}
+
+	int result = py_loader_impl_proxy_register(abc, "Sequence", &py_loader_impl_proxy_array_type) != 0 ||
+		py_loader_impl_proxy_register(abc, "Mapping", &py_loader_impl_proxy_map_type) != 0;
+
+	Py_DECREF(abc);
+
+	return result == 0 ? 0 : -1;
+}
+
+PyObject *py_loader_impl_proxy_create(loader_impl impl, value v)
+{
+	type_id id = value_type_id(v);
+	PyTypeObject *type = NULL;
+
+	if (id == TYPE_ARRAY)
+	{
+		type = &py_loader_impl_proxy_array_type;
+	}
+	else if (id == TYPE_MAP)
+	{
+		type = &py_loader_impl_proxy_map_type;
+	}
+	else
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid type %d for creating a Python proxy", id);
+		return NULL;
+	}
+
+	struct py_loader_impl_proxy_obj *proxy = PyObject_New(struct py_loader_impl_proxy_obj, type);
+
+	if (proxy == NULL)
+	{
+		return NULL;
+	}
+
+	/* The value is owned by the caller, keep a shared reference so it outlives the call. The proxy
+	* can outlive the allocator of the caller too (i.e an arena), so values reserved from it are copied
+	* into the heap instead of being shared
+	*/
+	memory_allocator previous = value_allocator(NULL);
+
+	proxy->impl = impl;
+	proxy->v = value_type_share(v);
+
+	(void)value_allocator(previous);
+	proxy->items = NULL;
+	proxy->index = NULL;
+
+	if (proxy->v == NULL)
+	{
+		PyObject_Del((PyObject *)proxy);
+		return NULL;
+	}
+
+	return (PyObject *)proxy;
+}
+
+value py_loader_impl_proxy_value(PyObject *obj)
+{
+	if (Py_TYPE(obj) == &py_loader_impl_proxy_array_type || Py_TYPE(obj) == &py_loader_impl_proxy_map_type)
+	{
+		return ((struct py_loader_impl_proxy_obj *)obj)->v;
+	}
+
+	return NULL;
+}
+
+value py_loader_impl_view_element(void *source, size_t index)
+{
+	struct py_loader_impl_view_type *view = source;
+	value v = NULL;
+
+	/* Elements can be accessed from the thread of another loader */
+	py_loader_thread_acquire();
+
+	if (view->keys == NULL)
+	{
+		Py_ssize_t size = PyList_Check(view->obj) ? PyList_Size(view->obj) : PyTuple_Size(view->obj);
+		PyObject *element = NULL;
+
+		/* The list may have shrunk since the view was created */
+		if ((Py_ssize_t)index < size)
+		{
+			element = PyList_Check(view->obj) ? PyList_GetItem(view->obj, (Py_ssize_t)index) : PyTuple_GetItem(view->obj, (Py_ssize_t)index);
+		}
+
+		v = element == NULL ? value_create_null() : py_loader_impl_capi_to_value(view->impl, element, py_loader_impl_capi_to_value_type(view->impl, element));
+	}
+	else
+	{
+		PyObject *key = PyList_GetItem(view->keys, (Py_ssize_t)index);
+		PyObject *element = PyDict_GetItem(view->obj, key);
+		Py_ssize_t key_length = 0;
+		const char *key_str = PyUnicode_AsUTF8AndSize(key, &key_length);
+
+		v = value_create_array(NULL, 2);
+
+		if (v != NULL)
+		{
+			value *tuple = value_to_array(v);
+
+			tuple[0] = value_create_string(key_str, (size_t)key_length);
+
+			/* The key may have been removed since the view was created */
+			tuple[1] = element == NULL ? value_create_null() : py_loader_impl_capi_to_value(view->impl, element, py_loader_impl_capi_to_value_type(view->impl, element));
+		}
+	}
+
+	py_loader_thread_release();
+
+	return v;
+}
+
+int py_loader_impl_view_find(void *source, const char *key, size_t length, size_t *index)
+{
+	struct py_loader_impl_view_type *view = source;
+	PyObject *key_obj, *position = NULL;
+	int result = 1;
+
+	py_loader_thread_acquire();
+
+	if (view->index == NULL)
+	{
+		Py_ssize_t iterator, size = PyList_Size(view->keys);
+
+		view->index = PyDict_New();
+
+		/* Only the keys are indexed, the values are left until they are accessed */
+		for (iterator = 0; view->index != NULL && iterator < size; ++iterator)
+		{
+			PyObject *key_position = PyLong_FromSsize_t(iterator);
+
+			if (key_position == NULL || PyDict_SetItem(view->index, PyList_GetItem(view->keys, iterator), key_position) != 0)
+			{
+				Py_CLEAR(view->index);
+			}
+
+			Py_XDECREF(key_position);
+		}
+	}
+
+	key_obj = PyUnicode_FromStringAndSize(key, (Py_ssize_t)length);
+
+	if (view->index != NULL && key_obj != NULL)
+	{
+		position = PyDict_GetItem(view->index, key_obj);
+	}
+
+	if (position != NULL)
+	{
+		*index = PyLong_AsSize_t(position);
+		result = 0;
+	}
+
+	Py_XDECREF(key_obj);
+
+	if (PyErr_Occurred() != NULL)
+	{
+		PyErr_Clear();
+	}
+
+	py_loader_thread_release();
+
+	return result;
+}
+
+void py_loader_impl_view_destroy(void *source)
+{
+	struct py_loader_impl_view_type *view = source;
+
+	if (loader_is_destroyed(view->impl) != 0)
+	{
+		py_loader_thread_acquire();
+
+		Py_DECREF(view->obj);
+		Py_XDECREF(view->keys);
+		Py_XDECREF(view->index);
+
+		py_loader_thread_release();
+	}
+
+	free(view);
+}
+
+value py_loader_impl_view_create(loader_impl impl, PyObject *obj, type_id id)
+{
+	struct py_loader_impl_view_type *view = malloc(sizeof(struct py_loader_impl_view_type));
+	Py_ssize_t size;
+	value v;
+
+	if (view == NULL)
+	{
+		return NULL;
+	}
+
+	view->impl = impl;
+	view->obj = obj;
+	view->keys = NULL;
+	view->index = NULL;
+
+	if (id == TYPE_MAP)
+	{
+		PyObject *key, *element;
+		Py_ssize_t iterator = 0;
+
+		view->keys = PyList_New(0);
+
+		if (view->keys == NULL)
+		{
+			free(view);
+			return NULL;
+		}
+
+		/* Allow only string keys, the same as when converting the whole dict */
+		while (PyDict_Next(obj, &iterator, &key, &element))
+		{
+			if (PyUnicode_Check(key) && PyList_Append(view->keys, key) != 0)
+			{
+				Py_DECREF(view->keys);
+				free(view);
+				return NULL;
+			}
+		}
+
+		size = PyList_Size(view->keys);
+	}
+	else
+	{
+		size = PyList_Check(obj) ? PyList_Size(obj) : PyTuple_Size(obj);
+	}
+
+	v = id == TYPE_MAP ? value_create_map_view(view, (size_t)size, &py_loader_impl_view_interface) : value_create_array_view(view, (size_t)size, &py_loader_impl_view_interface);
+
+	if (v == NULL)
+	{
+		Py_XDECREF(view->keys);
+		free(view);
+		return NULL;
+	}
+
+	Py_INCREF(obj);
+
+	return v;
+}
+
+PyObject *py_loader_impl_view_object(value v)
+{
+	void *source;
+
+	if (value_view(v, &source) == &py_loader_impl_view_interface)
+	{
+		return ((struct py_loader_impl_view_type *)source)->obj;
+	}
+
+	return NULL;
+}
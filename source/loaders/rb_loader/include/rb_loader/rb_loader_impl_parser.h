@@ -30,7 +30,7 @@ extern "C" {
 #define RB_LOADER_IMPL_PARSER_FUNC	0x40
 #define RB_LOADER_IMPL_PARSER_KEY	0x40
 #define RB_LOADER_IMPL_PARSER_TYPE	0x20
-#define RB_LOADER_IMPL_PARSER_PARAM 0x10
+#define RB_LOADER_IMPL_PARSER_PARAM 0x10 /* Initial capacity of the parameters */
 
 typedef struct rb_function_parameter_parser_type
 {
@@ -43,7 +43,7 @@ typedef struct rb_function_parameter_parser_type
 typedef struct rb_function_parser_type
 {
 	char name[RB_LOADER_IMPL_PARSER_FUNC];
-	struct rb_function_parameter_parser_type params[RB_LOADER_IMPL_PARSER_PARAM];
+	struct rb_function_parameter_parser_type *params;
 	size_t params_size;
 
 } * rb_function_parser;
@@ -87,8 +87,7 @@
 	#define rb_eval_cmd_kwd(c, a, kw)						rb_eval_cmd(c, a, 0)
 #endif
 
-#define LOADER_IMPL_RB_FUNCTION_ARGS_SIZE 0x10
-#define LOADER_IMPL_RB_PROTECT_ARGS_SIZE  0x10
+#define LOADER_IMPL_RB_PROTECT_ARGS_SIZE 0x10
 
 typedef struct loader_impl_rb_module_type
 {
@@ -112,6 +111,9 @@ typedef struct loader_impl_rb_function_type
 	VALUE module_instance;
 	ID method_id;
 	VALUE args_hash;
+	VALUE *args_keys;
+	size_t args_keys_size;
+	size_t positional_size;
 	loader_impl impl;
 
 } * loader_impl_rb_function;
@@ -361,14 +363,6 @@ static VALUE rb_loader_impl_funcallv_protect(VALUE args)
 	return rb_funcallv(protect->module_instance, protect->id, protect->argc, protect->argv);
 }
 
-static VALUE rb_loader_impl_funcall2_protect(VALUE args)
-{
-	/* TODO: Do this properly */
-	loader_impl_rb_funcall_protect protect = (loader_impl_rb_funcall_protect)args;
-
-	return rb_funcall2(protect->module_instance, protect->id, protect->argc, protect->argv);
-}
-
 static VALUE rb_loader_impl_funcallv_kw_protect(VALUE args)
 {
 	/* TODO: Do this properly */
@@ -394,154 +388,86 @@ static VALUE rb_loader_impl_funcallv_kw_protect(VALUE args)
 		} \
 	} while (0)
 
-function_return function_rb_interface_invoke(function func, function_impl impl, function_args args, size_t size)
+static int rb_loader_impl_thread_check(void)
 {
-	loader_impl_rb_function rb_function = (loader_impl_rb_function)impl;
+	/* There is no multi-thread entry into the loader: Ruby has no public API to adopt a thread that it did
+	* not create, nor to know if the current thread holds the GVL (and rb_thread_call_with_gvl aborts the VM
+	* when called with it held). Only threads known by Ruby (the one which initialized the loader or the ones
+	* created by Ruby) are accepted, and they must hold the GVL; a thread that released it has to reacquire
+	* it with rb_thread_call_with_gvl by itself before calling into the loader
+	*/
+	if (ruby_native_thread_p() == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Ruby cannot be called from a thread which has not been created by Ruby, multi-thread entry is not supported by the Ruby Loader");
+		return 1;
+	}
 
-	signature s = function_signature(func);
+	return 0;
+}
 
+function_return function_rb_interface_invoke(function func, function_impl impl, function_args args, size_t size)
+{
+	loader_impl_rb_function rb_function = (loader_impl_rb_function)impl;
 	const size_t args_size = size;
+	const size_t positional_size = args_size < rb_function->positional_size ? args_size : rb_function->positional_size;
+	const int keywords = positional_size < args_size;
+	const size_t argc = keywords ? positional_size + 1 : args_size;
+	struct loader_impl_rb_funcall_protect_type protect;
+	VALUE result_value, argv_buffer;
+	VALUE *argv;
+	size_t args_count;
+	int state;
 
-	VALUE result_value = Qnil;
+	(void)func;
 
-	if (args_size > LOADER_IMPL_RB_FUNCTION_ARGS_SIZE)
+	if (rb_loader_impl_thread_check() != 0)
 	{
 		return NULL;
 	}
 
-	if (args_size > 0)
-	{
-		enum function_rb_interface_invoke_id
-		{
-			FUNCTION_RB_UNKNOWN,
-			FUNCTION_RB_TYPED,
-			FUNCTION_RB_DUCKTYPED,
-			FUNCTION_RB_MIXED
-		} invoke_type = FUNCTION_RB_UNKNOWN;
-
-		size_t args_count, ducktype_args_count = 0;
+	argv = ALLOCV_N(VALUE, argv_buffer, argc);
 
-		VALUE args_value[LOADER_IMPL_RB_FUNCTION_ARGS_SIZE + 1];
+	/* Positional arguments are passed directly */
+	for (args_count = 0; args_count < positional_size; ++args_count)
+	{
+		argv[args_count] = rb_type_serialize(args[args_count]);
+	}
 
-		for (args_count = 0; args_count < args_size; ++args_count)
+	/* Typed arguments are keyword arguments, their symbols have been interned at discover time */
+	if (keywords)
+	{
+		if (args_size < rb_function->args_keys_size)
 		{
-			type t = signature_get_type(s, args_count);
-
-			type_id id = TYPE_INVALID;
-
-			if (t == NULL)
-			{
-				id = value_type_id((value)args[args_count]);
-
-				if (invoke_type == FUNCTION_RB_UNKNOWN)
-				{
-					invoke_type = FUNCTION_RB_DUCKTYPED;
-				}
-			}
-			else
-			{
-				if (invoke_type == FUNCTION_RB_UNKNOWN)
-				{
-					invoke_type = FUNCTION_RB_TYPED;
-				}
-				else if (invoke_type == FUNCTION_RB_DUCKTYPED)
-				{
-					invoke_type = FUNCTION_RB_MIXED;
-
-					ducktype_args_count = args_count;
-				}
-
-				id = type_index(t);
-			}
-
-			log_write("metacall", LOG_LEVEL_DEBUG, "Type %p, %d", (void *)t, id);
-
-			args_value[args_count] = rb_type_serialize(args[args_count]);
-
-			if (t != NULL)
-			{
-				rb_hash_aset(rb_function->args_hash, ID2SYM(rb_intern(signature_get_name(s, args_count))), args_value[args_count]);
-			}
+			rb_hash_clear(rb_function->args_hash);
 		}
 
-		if (invoke_type == FUNCTION_RB_TYPED)
-		{
-			struct loader_impl_rb_funcall_protect_type protect;
-			int state;
-
-			protect.argc = 1;
-			protect.argv = &rb_function->args_hash;
-			protect.module_instance = rb_function->module_instance;
-			protect.id = rb_function->method_id;
-
-			result_value = rb_protect(rb_loader_impl_funcallv_kw_protect, (VALUE)&protect, &state);
-
-			if (state != 0)
-			{
-				rb_loader_impl_print_last_exception();
-
-				// TODO: Throw exception?
-			}
-		}
-		else if (invoke_type == FUNCTION_RB_DUCKTYPED)
+		for (; args_count < args_size && args_count < rb_function->args_keys_size; ++args_count)
 		{
-			struct loader_impl_rb_funcall_protect_type protect;
-			int state;
+			VALUE key = rb_function->args_keys[args_count];
 
-			protect.argc = args_size;
-			protect.argv = args_value;
-			protect.module_instance = rb_function->module_instance;
-			protect.id = rb_function->method_id;
-
-			result_value = rb_protect(rb_loader_impl_funcall2_protect, (VALUE)&protect, &state);
-
-			if (state != 0)
+			if (key != Qundef)
 			{
-				rb_loader_impl_print_last_exception();
-
-				// TODO: Throw exception ?
+				rb_hash_aset(rb_function->args_hash, key, rb_type_serialize(args[args_count]));
 			}
 		}
-		else if (invoke_type == FUNCTION_RB_MIXED)
-		{
-			struct loader_impl_rb_funcall_protect_type protect;
-			int state;
 
-			args_value[ducktype_args_count] = rb_function->args_hash;
+		argv[positional_size] = rb_function->args_hash;
+	}
 
-			protect.argc = ducktype_args_count + 1;
-			protect.argv = args_value;
-			protect.module_instance = rb_function->module_instance;
-			protect.id = rb_function->method_id;
+	protect.argc = argc;
+	protect.argv = argc > 0 ? argv : NULL;
+	protect.module_instance = rb_function->module_instance;
+	protect.id = rb_function->method_id;
 
-			result_value = rb_protect(rb_loader_impl_funcallv_kw_protect, (VALUE)&protect, &state);
+	result_value = rb_protect(keywords ? rb_loader_impl_funcallv_kw_protect : rb_loader_impl_funcallv_protect, (VALUE)&protect, &state);
 
-			if (state != 0)
-			{
-				rb_loader_impl_print_last_exception();
+	ALLOCV_END(argv_buffer);
 
-				// TODO: Throw exception ?
-			}
-		}
-	}
-	else
+	if (state != 0)
 	{
-		struct loader_impl_rb_funcall_protect_type protect;
-		int state;
-
-		protect.argc = 0;
-		protect.argv = NULL;
-		protect.module_instance = rb_function->module_instance;
-		protect.id = rb_function->method_id;
-
-		result_value = rb_protect(rb_loader_impl_funcallv_protect, (VALUE)&protect, &state);
+		rb_loader_impl_print_last_exception();
 
-		if (state != 0)
-		{
-			rb_loader_impl_print_last_exception();
-
-			// TODO: Throw exception ?
-		}
+		// TODO: Throw exception?
 	}
 
 	value v = NULL;
@@ -581,6 +507,13 @@ void function_rb_interface_destroy(function func, function_impl impl)
 			log_write("metacall", LOG_LEVEL_DEBUG, "Unreferencing Ruby function '%s' from module", function_name(func));
 
 			rb_undef(rb_function->module, rb_to_id(name));
+
+			rb_gc_unregister_address(&rb_function->args_hash);
+		}
+
+		if (rb_function->args_keys != NULL)
+		{
+			free(rb_function->args_keys);
 		}
 
 		free(rb_function);
@@ -671,7 +604,8 @@ value rb_object_interface_method_invoke(object obj, object_impl impl, method m,
 		return NULL;
 	}
 
-	VALUE *argv = malloc(sizeof(VALUE) * argc);
+	VALUE argv_buffer;
+	VALUE *argv = ALLOCV_N(VALUE, argv_buffer, argc);
 	for (size_t i = 0; i < argc; i++)
 	{
 		argv[i] = rb_type_serialize(args[i]);
@@ -679,7 +613,7 @@ value rb_object_interface_method_invoke(object obj, object_impl impl, method m,
 
 	VALUE rb_retval = rb_funcallv(rb_obj->object, rb_intern(method_name(m)), argc, argv);
 
-	free(argv);
+	ALLOCV_END(argv_buffer);
 
 	if (rb_retval == Qnil)
 	{
@@ -774,7 +708,8 @@ object rb_class_interface_constructor(klass cls, class_impl impl, const char *na
 
 	object obj = object_create(name, ACCESSOR_TYPE_DYNAMIC, rb_obj, &rb_object_interface_singleton, cls);
 
-	VALUE *argv = malloc(sizeof(VALUE) * argc);
+	VALUE argv_buffer;
+	VALUE *argv = ALLOCV_N(VALUE, argv_buffer, argc);
 	for (size_t i = 0; i < argc; i++)
 	{
 		argv[i] = rb_type_serialize(args[i]);
@@ -782,7 +717,7 @@ object rb_class_interface_constructor(klass cls, class_impl impl, const char *na
 
 	VALUE rbval_object = rb_funcallv(rb_cls->class, rb_intern("new"), argc, argv);
 
-	free(argv);
+	ALLOCV_END(argv_buffer);
 
 	rb_obj->object = rbval_object;
 	rb_obj->object_class = rb_cls->class;
@@ -862,7 +797,8 @@ value rb_class_interface_static_invoke(klass cls, class_impl impl, method m, cla
 		return NULL;
 	}
 
-	VALUE *argv = malloc(sizeof(VALUE) * argc);
+	VALUE argv_buffer;
+	VALUE *argv = ALLOCV_N(VALUE, argv_buffer, argc);
 	for (size_t i = 0; i < argc; i++)
 	{
 		argv[i] = rb_type_serialize(args[i]);
@@ -870,7 +806,7 @@ value rb_class_interface_static_invoke(klass cls, class_impl impl, method m, cla
 
 	VALUE rb_retval = rb_funcallv(rb_class->class, rb_intern(methodname), argc, argv);
 
-	free(argv);
+	ALLOCV_END(argv_buffer);
 
 	if (rb_retval == Qnil)
 	{
@@ -1206,6 +1142,9 @@ loader_impl_rb_module rb_loader_impl_load_from_file_module(loader_impl impl, con
 						log_write("metacall", LOG_LEVEL_DEBUG, "Ruby module %s loaded", path);
 
 						rb_loader_impl_key_print(rb_module->function_map);
+
+						/* The instance is an anonymous class only referenced from here, keep it alive */
+						rb_gc_register_address(&rb_module->instance);
 					}
 					else
 					{
@@ -1334,6 +1273,9 @@ loader_impl_rb_module rb_loader_impl_load_from_memory_module(loader_impl impl, c
 						log_write("metacall", LOG_LEVEL_DEBUG, "Ruby module %s loaded", name);
 
 						rb_loader_impl_key_print(rb_module->function_map);
+
+						/* The instance is an anonymous class only referenced from here, keep it alive */
+						rb_gc_register_address(&rb_module->instance);
 					}
 					else
 					{
@@ -1436,6 +1378,8 @@ int rb_loader_impl_clear(loader_impl impl, loader_handle handle)
 			}
 
 			rb_loader_impl_key_clear((*rb_module)->function_map);
+
+			rb_gc_unregister_address(&(*rb_module)->instance);
 		}
 
 		free(*rb_module);
@@ -1448,7 +1392,7 @@ int rb_loader_impl_clear(loader_impl impl, loader_handle handle)
 	return 0;
 }
 
-int rb_loader_impl_discover_func(loader_impl impl, function f, rb_function_parser function_parser)
+int rb_loader_impl_discover_func(loader_impl impl, loader_impl_rb_function rb_function, function f, rb_function_parser function_parser)
 {
 	signature s = function_signature(f);
 
@@ -1458,9 +1402,47 @@ int rb_loader_impl_discover_func(loader_impl impl, function f, rb_function_parse
 
 		size_t index;
 
+		int positional = 1;
+
+		if (size > 0)
+		{
+			rb_function->args_keys = malloc(sizeof(VALUE) * size);
+
+			if (rb_function->args_keys == NULL)
+			{
+				return 1;
+			}
+
+			rb_function->args_keys_size = size;
+		}
+
 		for (index = 0; index < size; ++index)
 		{
-			signature_set(s, index, function_parser->params[index].name, loader_impl_type(impl, function_parser->params[index].type));
+			type t = loader_impl_type(impl, function_parser->params[index].type);
+
+			signature_set(s, index, function_parser->params[index].name, t);
+
+			/* Typed parameters are keyword arguments, intern their symbols once instead of on each call */
+			if (t != NULL)
+			{
+				rb_function->args_keys[index] = ID2SYM(rb_intern(function_parser->params[index].name));
+				positional = 0;
+			}
+			else
+			{
+				rb_function->args_keys[index] = Qundef;
+			}
+
+			if (positional == 1)
+			{
+				++rb_function->positional_size;
+			}
+		}
+
+		/* Only functions with keyword arguments need the hash */
+		if (rb_function->positional_size < size)
+		{
+			rb_function->args_hash = rb_hash_new();
 		}
 
 		return 0;
@@ -1478,9 +1460,15 @@ loader_impl_rb_function rb_function_create(loader_impl impl, loader_impl_rb_modu
 		rb_function->module = rb_module->module;
 		rb_function->module_instance = rb_module->instance;
 		rb_function->method_id = id;
-		rb_function->args_hash = rb_hash_new();
+		rb_function->args_hash = Qnil;
+		rb_function->args_keys = NULL;
+		rb_function->args_keys_size = 0;
+		rb_function->positional_size = 0;
 		rb_function->impl = impl;
 
+		/* The hash is reused between calls, keep it alive while the function exists */
+		rb_gc_register_address(&rb_function->args_hash);
+
 		return rb_function;
 	}
 
@@ -1614,7 +1602,7 @@ int rb_loader_impl_discover_module(loader_impl impl, loader_impl_rb_module rb_mo
 			{
 				function f = function_create(method_name_str, function_parser->params_size, rb_function, &function_rb_singleton);
 
-				if (f != NULL && rb_loader_impl_discover_func(impl, f, function_parser) == 0)
+				if (f != NULL && rb_loader_impl_discover_func(impl, rb_function, f, function_parser) == 0)
 				{
 					scope sp = context_scope(ctx);
 					value v = value_create_function(f);
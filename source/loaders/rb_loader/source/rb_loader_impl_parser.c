@@ -22,6 +22,7 @@
 
 #include <log/log.h>
 
+#include <stdlib.h>
 #include <string.h>
 
 /* -- Enumerations -- */
@@ -44,12 +45,37 @@ enum rb_loader_impl_comment_state
 
 /* -- Private Methods -- */
 
+static int rb_loader_impl_key_parse_parameter(struct rb_function_parameter_parser_type **parameters, size_t *capacity, size_t size, rb_function_parameter_parser parameter);
+
 static int rb_loader_impl_key_print_cb_iterate(set s, set_key key, set_value v, set_cb_iterate_args args);
 
 static int rb_loader_impl_key_clear_cb_iterate(set s, set_key key, set_value v, set_cb_iterate_args args);
 
 /* -- Methods -- */
 
+int rb_loader_impl_key_parse_parameter(struct rb_function_parameter_parser_type **parameters, size_t *capacity, size_t size, rb_function_parameter_parser parameter)
+{
+	/* The parameters are stored in a growing buffer, functions are not limited in the number of parameters */
+	if (size == *capacity)
+	{
+		size_t new_capacity = *capacity == 0 ? RB_LOADER_IMPL_PARSER_PARAM : *capacity << 1;
+		struct rb_function_parameter_parser_type *new_parameters = realloc(*parameters, new_capacity * sizeof(struct rb_function_parameter_parser_type));
+
+		if (new_parameters == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid ruby parser parameters allocation");
+			return 1;
+		}
+
+		*parameters = new_parameters;
+		*capacity = new_capacity;
+	}
+
+	(*parameters)[size] = *parameter;
+
+	return 0;
+}
+
 int rb_loader_impl_key_parse(const char *source, set function_map)
 {
 	static const char func_def_name[] = "def", func_do_name[] = "do", func_end_name[] = "end";
@@ -65,11 +91,13 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 
 	size_t iterator, length = strlen(source);
 
-	struct rb_function_parameter_parser_type parameters[RB_LOADER_IMPL_PARSER_PARAM];
+	struct rb_function_parameter_parser_type *parameters = NULL;
 
 	struct rb_function_parameter_parser_type parameter;
 
-	size_t parameter_size = 0;
+	size_t parameter_size = 0, parameter_capacity = 0;
+
+	int result = 0;
 
 	int reading_parameter_type = 1;
 
@@ -213,7 +241,6 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 
 							reading_parameter_type = 1;
 
-							memset(parameters, 0, RB_LOADER_IMPL_PARSER_PARAM * sizeof(struct rb_function_parameter_parser_type));
 							memset(&parameter, 0, sizeof(struct rb_function_parameter_parser_type));
 						}
 					}
@@ -236,7 +263,7 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 							parameter_size = function_index = 0;
 						}
 					}
-					else
+					else if (function_index < RB_LOADER_IMPL_PARSER_FUNC - 1)
 					{
 						function_name[function_index] = character;
 
@@ -255,9 +282,11 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 
 						if (parameter_name_size > 0)
 						{
-							parameters[parameter_size].index = parameter.index;
-							strncpy(parameters[parameter_size].name, parameter.name, RB_LOADER_IMPL_PARSER_KEY);
-							strncpy(parameters[parameter_size].type, parameter.type, RB_LOADER_IMPL_PARSER_TYPE);
+							if (rb_loader_impl_key_parse_parameter(&parameters, &parameter_capacity, parameter_size, &parameter) != 0)
+							{
+								result = 1;
+								goto parse_end;
+							}
 
 							++parameter_size;
 						}
@@ -271,10 +300,28 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 						if (function == NULL)
 						{
 							log_write("metacall", LOG_LEVEL_ERROR, "Invalid ruby parser function allocation");
+							result = 1;
+							goto parse_end;
+						}
+
+						function->params = NULL;
+
+						if (parameter_size > 0)
+						{
+							function->params = malloc(parameter_size * sizeof(struct rb_function_parameter_parser_type));
+
+							if (function->params == NULL)
+							{
+								log_write("metacall", LOG_LEVEL_ERROR, "Invalid ruby parser function parameters allocation");
+								free(function);
+								result = 1;
+								goto parse_end;
+							}
+
+							memcpy(function->params, parameters, parameter_size * sizeof(struct rb_function_parameter_parser_type));
 						}
 
 						strncpy(function->name, function_name, RB_LOADER_IMPL_PARSER_FUNC);
-						memcpy(function->params, parameters, parameter_size * sizeof(struct rb_function_parameter_parser_type));
 						function->params_size = parameter_size;
 
 						/* TODO: This is not skipping class functions, that is a wrong behavior */
@@ -293,9 +340,11 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 					{
 						if (character == ',')
 						{
-							parameters[parameter_size].index = parameter.index;
-							strncpy(parameters[parameter_size].name, parameter.name, RB_LOADER_IMPL_PARSER_KEY);
-							strncpy(parameters[parameter_size].type, parameter.type, RB_LOADER_IMPL_PARSER_TYPE);
+							if (rb_loader_impl_key_parse_parameter(&parameters, &parameter_capacity, parameter_size, &parameter) != 0)
+							{
+								result = 1;
+								goto parse_end;
+							}
 
 							++parameter_size;
 
@@ -317,11 +366,14 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 							{
 								if (reading_parameter_type == 0)
 								{
-									parameter.type[parameter_type_size] = character;
+									if (parameter_type_size < RB_LOADER_IMPL_PARSER_TYPE - 1)
+									{
+										parameter.type[parameter_type_size] = character;
 
-									++parameter_type_size;
+										++parameter_type_size;
+									}
 								}
-								else
+								else if (parameter_name_size < RB_LOADER_IMPL_PARSER_KEY - 1)
 								{
 									parameter.name[parameter_name_size] = character;
 
@@ -383,7 +435,8 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 				}
 
 				default: {
-					return 1;
+					result = 1;
+					goto parse_end;
 				}
 			}
 		}
@@ -393,7 +446,10 @@ int rb_loader_impl_key_parse(const char *source, set function_map)
 		}
 	}
 
-	return 0;
+parse_end:
+	free(parameters);
+
+	return result;
 }
 
 int rb_loader_impl_key_print_cb_iterate(set s, set_key key, set_value v, set_cb_iterate_args args)
@@ -434,6 +490,7 @@ int rb_loader_impl_key_clear_cb_iterate(set s, set_key key, set_value v, set_cb_
 
 	if (function != NULL)
 	{
+		free(function->params);
 		free(function);
 	}
 
@@ -33,7 +33,9 @@ loader_impl_interface rpc_loader_impl_interface_singleton(void)
 		&rpc_loader_impl_load_from_package,
 		&rpc_loader_impl_clear,
 		&rpc_loader_impl_discover,
-		&rpc_loader_impl_destroy
+		&rpc_loader_impl_destroy,
+		NULL,
+		0
 	};
 
 	return &loader_impl_interface_rpc;
@@ -26,9 +26,13 @@
 #include <portability/portability_path.h>
 
 #include <reflect/reflect_context.h>
+#include <reflect/reflect_exception.h>
 #include <reflect/reflect_function.h>
+#include <reflect/reflect_future.h>
 #include <reflect/reflect_scope.h>
+#include <reflect/reflect_throwable.h>
 #include <reflect/reflect_type.h>
+#include <reflect/reflect_value_type.h>
 
 #include <serial/serial.h>
 
@@ -44,19 +48,31 @@
 #include <algorithm>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+typedef struct loader_impl_rpc_await_type *loader_impl_rpc_await;
+
 typedef struct loader_impl_rpc_type
 {
 	CURL *discover_curl;
 	CURL *invoke_curl;
+	struct curl_slist *headers;
 	void *allocator;
 	std::map<type_id, type> types;
 	std::set<std::string> execution_paths;
 
+	/* Asynchronous calls are performed concurrently by a worker thread with its own multi handle */
+	CURLM *await_multi;
+	std::thread await_thread;
+	std::mutex await_mutex;
+	std::vector<loader_impl_rpc_await> await_requests;
+	bool await_stop;
+
 } * loader_impl_rpc;
 
 typedef struct loader_impl_rpc_handle_type
@@ -78,7 +94,50 @@ typedef struct loader_impl_rpc_write_data_type
 
 } * loader_impl_rpc_write_data;
 
+struct loader_impl_rpc_await_type
+{
+	loader_impl_rpc rpc_impl;
+	std::string url;
+	CURL *curl;
+	char *body;
+	size_t body_size;
+	loader_impl_rpc_write_data_type write_data;
+	function_resolve_callback resolve_callback;
+	function_reject_callback reject_callback;
+	void *context;
+};
+
 static size_t rpc_loader_impl_write_data(void *buffer, size_t size, size_t nmemb, void *userp);
+static char *rpc_loader_impl_serialize_args(loader_impl_rpc rpc_impl, function_args args, size_t size, size_t *body_size);
+static int future_rpc_interface_create(future f, future_impl impl)
+{
+	(void)f;
+	(void)impl;
+
+	return 0;
+}
+
+void future_rpc_interface_destroy(future f, future_impl impl)
+{
+	(void)f;
+	(void)impl;
+}
+
+future_interface future_rpc_singleton(void)
+{
+	/* The callbacks are registered when the request is sent, so the future cannot be awaited again */
+	static struct future_interface_type rpc_future_interface = {
+		&future_rpc_interface_create,
+		NULL,
+		&future_rpc_interface_destroy
+	};
+
+	return &rpc_future_interface;
+}
+
+void rpc_loader_impl_await_settle(loader_impl_rpc_await await_data, CURLcode res);
+static void rpc_loader_impl_await_destroy(loader_impl_rpc_await await_data);
+static void rpc_loader_impl_await_worker(loader_impl_rpc rpc_impl);
 static int rpc_loader_impl_discover_value(loader_impl_rpc rpc_impl, std::string &url, value v, context ctx);
 static int rpc_loader_impl_initialize_types(loader_impl impl, loader_impl_rpc rpc_impl);
 
@@ -135,14 +194,16 @@ int function_rpc_interface_create(function func, function_impl impl)
 	return 0;
 }
 
-function_return function_rpc_interface_invoke(function func, function_impl impl, function_args args, size_t size)
+char *rpc_loader_impl_serialize_args(loader_impl_rpc rpc_impl, function_args args, size_t size, size_t *body_size)
 {
-	loader_impl_rpc_function rpc_function = static_cast<loader_impl_rpc_function>(impl);
-	loader_impl_rpc rpc_impl = rpc_function->rpc_impl;
 	value v = metacall_value_create_array(NULL, size);
-	size_t body_request_size = 0;
 
-	(void)func;
+	*body_size = 0;
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
 
 	if (size > 0)
 	{
@@ -154,11 +215,24 @@ function_return function_rpc_interface_invoke(function func, function_impl impl,
 		}
 	}
 
-	char *buffer = metacall_serialize(metacall_serial(), v, &body_request_size, rpc_impl->allocator);
+	char *buffer = metacall_serialize(metacall_serial(), v, body_size, rpc_impl->allocator);
 
 	/* Destroy the value without destroying the contents of the array */
 	value_destroy(v);
 
+	return buffer;
+}
+
+function_return function_rpc_interface_invoke(function func, function_impl impl, function_args args, size_t size)
+{
+	loader_impl_rpc_function rpc_function = static_cast<loader_impl_rpc_function>(impl);
+	loader_impl_rpc rpc_impl = rpc_function->rpc_impl;
+	size_t body_request_size = 0;
+
+	(void)func;
+
+	char *buffer = rpc_loader_impl_serialize_args(rpc_impl, args, size, &body_request_size);
+
 	if (body_request_size == 0)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Invalid serialization of the values to the endpoint %s", rpc_function->url.c_str());
@@ -197,19 +271,249 @@ function_return function_rpc_interface_invoke(function func, function_impl impl,
 	return result_value;
 }
 
+void rpc_loader_impl_await_settle(loader_impl_rpc_await await_data, CURLcode res)
+{
+	loader_impl_rpc rpc_impl = await_data->rpc_impl;
+	value result = NULL, ret = NULL;
+	long status = 0;
+	std::string message;
+
+	if (res == CURLE_OK)
+	{
+		curl_easy_getinfo(await_data->curl, CURLINFO_RESPONSE_CODE, &status);
+
+		/* Deserialize the result of the future, it can be a remote exception */
+		result = metacall_deserialize(metacall_serial(), await_data->write_data.buffer.c_str(), await_data->write_data.buffer.length() + 1, rpc_impl->allocator);
+
+		if (result == NULL)
+		{
+			message = "Could not deserialize the await result from API endpoint " + await_data->url;
+		}
+	}
+	else
+	{
+		message = "Could not await the API endpoint " + await_data->url + " [" + curl_easy_strerror(res) + "]";
+	}
+
+	if (result != NULL && status < 400)
+	{
+		type_id id = value_type_id(result);
+
+		if (id == TYPE_EXCEPTION || id == TYPE_THROWABLE)
+		{
+			if (await_data->reject_callback != NULL)
+			{
+				ret = await_data->reject_callback(result, await_data->context);
+			}
+		}
+		else if (await_data->resolve_callback != NULL)
+		{
+			ret = await_data->resolve_callback(result, await_data->context);
+		}
+	}
+	else
+	{
+		if (message.empty())
+		{
+			message = "API endpoint " + await_data->url + " failed with status " + std::to_string(status);
+		}
+
+		log_write("metacall", LOG_LEVEL_ERROR, "%s", message.c_str());
+
+		exception ex = exception_create_const(message.c_str(), "RPCError", status, "");
+		throwable th = throwable_create(value_create_exception(ex));
+		value error = value_create_throwable(th);
+
+		if (await_data->reject_callback != NULL)
+		{
+			ret = await_data->reject_callback(error, await_data->context);
+		}
+
+		value_type_destroy(error);
+	}
+
+	if (result != NULL)
+	{
+		value_type_destroy(result);
+	}
+
+	/* Nobody waits for the value returned by the callbacks */
+	if (ret != NULL)
+	{
+		value_type_destroy(ret);
+	}
+}
+
+void rpc_loader_impl_await_destroy(loader_impl_rpc_await await_data)
+{
+	if (await_data->curl != NULL)
+	{
+		curl_easy_cleanup(await_data->curl);
+	}
+
+	metacall_allocator_free(await_data->rpc_impl->allocator, await_data->body);
+
+	delete await_data;
+}
+
+void rpc_loader_impl_await_worker(loader_impl_rpc rpc_impl)
+{
+	std::map<CURL *, loader_impl_rpc_await> running;
+
+	for (;;)
+	{
+		std::vector<loader_impl_rpc_await> requests;
+		bool stop;
+
+		{
+			std::lock_guard<std::mutex> lock(rpc_impl->await_mutex);
+
+			requests.swap(rpc_impl->await_requests);
+			stop = rpc_impl->await_stop;
+		}
+
+		for (loader_impl_rpc_await await_data : requests)
+		{
+			/* Each request owns its easy handle, so the calls do not share the state of the synchronous invoke handle */
+			CURLcode res = CURLE_OUT_OF_MEMORY;
+
+			await_data->curl = curl_easy_init();
+
+			if (await_data->curl != NULL)
+			{
+				curl_easy_setopt(await_data->curl, CURLOPT_VERBOSE, 0L);
+				curl_easy_setopt(await_data->curl, CURLOPT_HEADER, 0L);
+				curl_easy_setopt(await_data->curl, CURLOPT_CUSTOMREQUEST, "POST");
+				curl_easy_setopt(await_data->curl, CURLOPT_HTTPHEADER, rpc_impl->headers);
+				curl_easy_setopt(await_data->curl, CURLOPT_USERAGENT, "librpc_loader/0.1");
+				curl_easy_setopt(await_data->curl, CURLOPT_WRITEFUNCTION, rpc_loader_impl_write_data);
+				curl_easy_setopt(await_data->curl, CURLOPT_WRITEDATA, static_cast<loader_impl_rpc_write_data>(&await_data->write_data));
+				curl_easy_setopt(await_data->curl, CURLOPT_URL, await_data->url.c_str());
+				curl_easy_setopt(await_data->curl, CURLOPT_POSTFIELDS, await_data->body);
+				curl_easy_setopt(await_data->curl, CURLOPT_POSTFIELDSIZE, await_data->body_size - 1);
+
+				if (curl_multi_add_handle(rpc_impl->await_multi, await_data->curl) == CURLM_OK)
+				{
+					running[await_data->curl] = await_data;
+					continue;
+				}
+
+				res = CURLE_FAILED_INIT;
+			}
+
+			rpc_loader_impl_await_settle(await_data, res);
+			rpc_loader_impl_await_destroy(await_data);
+		}
+
+		if (stop)
+		{
+			/* The loader is being destroyed, the requests still in flight are rejected */
+			for (auto &pair : running)
+			{
+				curl_multi_remove_handle(rpc_impl->await_multi, pair.first);
+				rpc_loader_impl_await_settle(pair.second, CURLE_ABORTED_BY_CALLBACK);
+				rpc_loader_impl_await_destroy(pair.second);
+			}
+
+			return;
+		}
+
+		int still_running = 0;
+
+		curl_multi_perform(rpc_impl->await_multi, &still_running);
+
+		CURLMsg *msg;
+		int msgs_left = 0;
+
+		while ((msg = curl_multi_info_read(rpc_impl->await_multi, &msgs_left)) != NULL)
+		{
+			if (msg->msg == CURLMSG_DONE)
+			{
+				CURL *curl = msg->easy_handle;
+				CURLcode res = msg->data.result;
+				auto it = running.find(curl);
+
+				curl_multi_remove_handle(rpc_impl->await_multi, curl);
+
+				if (it != running.end())
+				{
+					loader_impl_rpc_await await_data = it->second;
+
+					running.erase(it);
+
+					rpc_loader_impl_await_settle(await_data, res);
+					rpc_loader_impl_await_destroy(await_data);
+				}
+			}
+		}
+
+		/* Sleep until there is network activity or a new request wakes up the multi handle */
+		curl_multi_poll(rpc_impl->await_multi, NULL, 0, 1000, NULL);
+	}
+}
+
 function_return function_rpc_interface_await(function func, function_impl impl, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context)
 {
-	/* TODO */
+	loader_impl_rpc_function rpc_function = static_cast<loader_impl_rpc_function>(impl);
+	loader_impl_rpc rpc_impl = rpc_function->rpc_impl;
+	size_t body_request_size = 0;
 
 	(void)func;
-	(void)impl;
-	(void)args;
-	(void)size;
-	(void)resolve_callback;
-	(void)reject_callback;
-	(void)context;
 
-	return NULL;
+	char *buffer = rpc_loader_impl_serialize_args(rpc_impl, args, size, &body_request_size);
+
+	if (body_request_size == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid serialization of the values to the endpoint %s", rpc_function->url.c_str());
+		return NULL;
+	}
+
+	future f = future_create(NULL, &future_rpc_singleton);
+
+	if (f == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid future creation for the endpoint %s", rpc_function->url.c_str());
+		metacall_allocator_free(rpc_impl->allocator, buffer);
+		return NULL;
+	}
+
+	value v = value_create_future(f);
+
+	if (v == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid future value creation for the endpoint %s", rpc_function->url.c_str());
+		future_destroy(f);
+		metacall_allocator_free(rpc_impl->allocator, buffer);
+		return NULL;
+	}
+
+	/* The url of asynchronous functions points to the await endpoint, which replies once the remote future settles */
+	loader_impl_rpc_await await_data = new loader_impl_rpc_await_type();
+
+	await_data->rpc_impl = rpc_impl;
+	await_data->url = rpc_function->url;
+	await_data->curl = NULL;
+	await_data->body = buffer;
+	await_data->body_size = body_request_size;
+	await_data->resolve_callback = resolve_callback;
+	await_data->reject_callback = reject_callback;
+	await_data->context = context;
+
+	{
+		std::lock_guard<std::mutex> lock(rpc_impl->await_mutex);
+
+		/* The worker is started with the first asynchronous call */
+		if (!rpc_impl->await_thread.joinable())
+		{
+			rpc_impl->await_thread = std::thread(rpc_loader_impl_await_worker, rpc_impl);
+		}
+
+		rpc_impl->await_requests.push_back(await_data);
+	}
+
+	curl_multi_wakeup(rpc_impl->await_multi);
+
+	return v;
 }
 
 void function_rpc_interface_destroy(function func, function_impl impl)
@@ -347,6 +651,8 @@ loader_impl_data rpc_loader_impl_initialize(loader_impl impl, configuration conf
 		headers = curl_slist_append(headers, "charset: utf-8");
 	}
 
+	rpc_impl->headers = headers;
+
 	curl_easy_setopt(rpc_impl->invoke_curl, CURLOPT_VERBOSE, 0L);
 	curl_easy_setopt(rpc_impl->invoke_curl, CURLOPT_HEADER, 0L);
 	curl_easy_setopt(rpc_impl->invoke_curl, CURLOPT_CUSTOMREQUEST, "POST");
@@ -354,6 +660,25 @@ loader_impl_data rpc_loader_impl_initialize(loader_impl impl, configuration conf
 	curl_easy_setopt(rpc_impl->invoke_curl, CURLOPT_USERAGENT, "librpc_loader/0.1");
 	curl_easy_setopt(rpc_impl->invoke_curl, CURLOPT_WRITEFUNCTION, rpc_loader_impl_write_data);
 
+	/* Initialize await CURL multi object */
+	rpc_impl->await_multi = curl_multi_init();
+	rpc_impl->await_stop = false;
+
+	if (rpc_impl->await_multi == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Could not create CURL await object");
+
+		curl_easy_cleanup(rpc_impl->discover_curl);
+
+		curl_easy_cleanup(rpc_impl->invoke_curl);
+
+		metacall_allocator_destroy(rpc_impl->allocator);
+
+		delete rpc_impl;
+
+		return NULL;
+	}
+
 	if (rpc_loader_impl_initialize_types(impl, rpc_impl) != 0)
 	{
 		log_write("metacall", LOG_LEVEL_ERROR, "Could not create CURL object");
@@ -362,6 +687,8 @@ loader_impl_data rpc_loader_impl_initialize(loader_impl impl, configuration conf
 
 		curl_easy_cleanup(rpc_impl->invoke_curl);
 
+		curl_multi_cleanup(rpc_impl->await_multi);
+
 		metacall_allocator_destroy(rpc_impl->allocator);
 
 		delete rpc_impl;
@@ -684,6 +1011,22 @@ int rpc_loader_impl_destroy(loader_impl impl)
 	/* Destroy children loaders */
 	loader_unload_children(impl);
 
+	/* Stop the await worker, the requests in flight are rejected */
+	{
+		std::lock_guard<std::mutex> lock(rpc_impl->await_mutex);
+
+		rpc_impl->await_stop = true;
+	}
+
+	if (rpc_impl->await_thread.joinable())
+	{
+		curl_multi_wakeup(rpc_impl->await_multi);
+
+		rpc_impl->await_thread.join();
+	}
+
+	curl_multi_cleanup(rpc_impl->await_multi);
+
 	metacall_allocator_destroy(rpc_impl->allocator);
 
 	curl_easy_cleanup(rpc_impl->discover_curl);
@@ -0,0 +1,272 @@
+// Persistent cache of compiled wrapper libraries and their discovered metadata.
+//
+// When RS_LOADER_CACHE_PATH is set, every successful compilation stores the
+// generated library together with the functions and classes found while
+// parsing. The entry is keyed by the entry source, the compiler version and
+// the compiler options. The files the library was built from, as reported by
+// the rustc dep-info, are stored with their hashes and checked again before an
+// entry is used, so a later load of an unchanged crate can dlopen the cached
+// artifact directly without invoking rustc at all.
+use crate::{compiler_options, compiler_sys_root, CompilerState, Source, SourceImpl};
+
+use serde::{Deserialize, Serialize};
+use std::path::{Path, PathBuf};
+
+const CACHE_PATH_ENV: &str = "RS_LOADER_CACHE_PATH";
+const CACHE_METADATA: &str = "metadata.json";
+const CACHE_DEPENDENCIES: &str = "dependencies.json";
+
+// Name of the dep-info emitted by rustc into the compilation directory
+pub const DEP_INFO_FILE: &str = "metacall.d";
+
+// Bump this whenever the wrapper generator or the metadata layout changes
+const CACHE_VERSION: u32 = 2;
+
+// FNV-1a, unlike DefaultHasher its output is specified, so the keys and the
+// dependency hashes do not change between Rust releases
+struct CacheHasher(u64);
+
+impl CacheHasher {
+    fn new() -> CacheHasher {
+        CacheHasher(0xcbf29ce484222325)
+    }
+
+    // Every field is prefixed by its length so consecutive fields cannot be confused
+    fn write(&mut self, bytes: &[u8]) {
+        for byte in (bytes.len() as u64).to_le_bytes().iter().chain(bytes) {
+            self.0 ^= *byte as u64;
+            self.0 = self.0.wrapping_mul(0x100000001b3);
+        }
+    }
+
+    fn write_path(&mut self, path: &Path) {
+        self.write(path.to_string_lossy().as_bytes());
+    }
+
+    fn finish(&self) -> String {
+        format!("{:016x}", self.0)
+    }
+}
+
+#[derive(Serialize, Deserialize)]
+struct CacheDependency {
+    path: PathBuf,
+    hash: String,
+}
+
+pub struct CacheEntry {
+    path: PathBuf,
+}
+
+impl CacheEntry {
+    pub fn new(source: &SourceImpl) -> Option<CacheEntry> {
+        let cache_path = std::env::var_os(CACHE_PATH_ENV).map(PathBuf::from)?;
+
+        if cache_path.as_os_str().is_empty() {
+            return None;
+        }
+
+        let key = cache_key(source)?;
+
+        Some(CacheEntry {
+            path: cache_path.join(key),
+        })
+    }
+
+    pub fn load(&self) -> Option<CompilerState> {
+        // The entry is stale if any of the files it was built from has changed
+        let dependencies = std::fs::read(self.path.join(CACHE_DEPENDENCIES)).ok()?;
+        let dependencies: Vec<CacheDependency> = serde_json::from_slice(&dependencies).ok()?;
+
+        for dependency in &dependencies {
+            if file_hash(&dependency.path).as_ref() != Some(&dependency.hash) {
+                return None;
+            }
+        }
+
+        let metadata = std::fs::read(self.path.join(CACHE_METADATA)).ok()?;
+        let mut state: CompilerState = serde_json::from_slice(&metadata).ok()?;
+        let library = self.path.join(state.output.file_name()?);
+
+        if !library.is_file() {
+            return None;
+        }
+
+        state.output = library;
+        state.cached = true;
+
+        Some(state)
+    }
+
+    pub fn store(
+        &self,
+        state: &CompilerState,
+        dep_info: &Path,
+        destination: &Path,
+    ) -> Result<(), String> {
+        let parent = self
+            .path
+            .parent()
+            .ok_or_else(|| String::from("Invalid cache path"))?;
+
+        std::fs::create_dir_all(parent).map_err(|error| error.to_string())?;
+
+        // Populate a temporary directory first and rename it into place, so
+        // concurrent loaders never observe a partially written entry
+        let temp = parent.join(format!(
+            ".{}.{}",
+            self.path
+                .file_name()
+                .and_then(|name| name.to_str())
+                .unwrap_or("entry"),
+            std::process::id()
+        ));
+
+        let result = (|| -> Result<(), String> {
+            let dependencies = dependencies(dep_info, destination)?;
+
+            std::fs::create_dir_all(&temp).map_err(|error| error.to_string())?;
+
+            let file_name = state
+                .output
+                .file_name()
+                .ok_or_else(|| String::from("Invalid compiler output path"))?;
+
+            std::fs::copy(&state.output, temp.join(file_name))
+                .map_err(|error| error.to_string())?;
+
+            let metadata = serde_json::to_vec(state).map_err(|error| error.to_string())?;
+
+            std::fs::write(temp.join(CACHE_METADATA), metadata)
+                .map_err(|error| error.to_string())?;
+
+            let dependencies =
+                serde_json::to_vec(&dependencies).map_err(|error| error.to_string())?;
+
+            std::fs::write(temp.join(CACHE_DEPENDENCIES), dependencies)
+                .map_err(|error| error.to_string())?;
+
+            // A stale entry with the same key is replaced
+            if self.path.exists() {
+                let _ = std::fs::remove_dir_all(&self.path);
+            }
+
+            match std::fs::rename(&temp, &self.path) {
+                Ok(()) => Ok(()),
+                // Another process stored the same entry first
+                Err(_) if self.path.exists() => Ok(()),
+                Err(error) => Err(error.to_string()),
+            }
+        })();
+
+        if temp.exists() {
+            let _ = std::fs::remove_dir_all(&temp);
+        }
+
+        result
+    }
+}
+
+fn file_hash(path: &Path) -> Option<String> {
+    let mut hasher = CacheHasher::new();
+
+    hasher.write(&std::fs::read(path).ok()?);
+
+    Some(hasher.finish())
+}
+
+// Parse the files listed by the rustc dep-info (make syntax, spaces escaped
+// with a backslash), skipping the toolchain files, which are covered by the
+// key, and the files generated in the compilation directory
+fn dependencies(dep_info: &Path, destination: &Path) -> Result<Vec<CacheDependency>, String> {
+    let contents = std::fs::read_to_string(dep_info).map_err(|error| error.to_string())?;
+    let rule = contents
+        .lines()
+        .next()
+        .ok_or_else(|| String::from("Empty dep-info"))?;
+    let (_, prerequisites) = rule
+        .split_once(": ")
+        .ok_or_else(|| String::from("Invalid dep-info"))?;
+    let sys_root = compiler_sys_root();
+    let mut result = Vec::new();
+    let mut path = String::new();
+    let mut chars = prerequisites.chars().peekable();
+
+    loop {
+        let c = chars.next();
+
+        match c {
+            Some('\\') if chars.peek() == Some(&' ') => {
+                path.push(' ');
+                chars.next();
+            }
+            Some(' ') | None => {
+                if !path.is_empty() {
+                    let dependency = PathBuf::from(std::mem::take(&mut path));
+                    let generated = dependency.starts_with(destination);
+                    let toolchain = sys_root
+                        .as_ref()
+                        .map_or(false, |sys_root| dependency.starts_with(sys_root));
+
+                    // In-memory sources are listed by name, they are hashed in the key
+                    if !generated && !toolchain && dependency.is_file() {
+                        let hash = file_hash(&dependency).ok_or_else(|| {
+                            format!("Unable to read dependency '{}'", dependency.display())
+                        })?;
+
+                        result.push(CacheDependency {
+                            path: dependency,
+                            hash,
+                        });
+                    }
+                }
+
+                if c.is_none() {
+                    break;
+                }
+            }
+            Some(c) => path.push(c),
+        }
+    }
+
+    Ok(result)
+}
+
+fn cache_key(source: &SourceImpl) -> Option<String> {
+    let mut hasher = CacheHasher::new();
+
+    hasher.write(&CACHE_VERSION.to_le_bytes());
+
+    // Compiler version and sysroot, a toolchain update invalidates all entries
+    hasher.write(
+        rustc_interface::util::version_str()
+            .unwrap_or("unknown")
+            .as_bytes(),
+    );
+    hasher.write_path(&compiler_sys_root().unwrap_or_default());
+
+    // Compiler options, the hash covers every option that changes the generated code
+    hasher.write(&compiler_options().dep_tracking_hash(false).to_le_bytes());
+
+    // Entry source, the rest of the files are validated from the dep-info when loading
+    match &source.source {
+        Source::File { path } => {
+            hasher.write(b"file");
+            hasher.write_path(path);
+        }
+        Source::Memory { name, code } => {
+            hasher.write(b"memory");
+            hasher.write(name.as_bytes());
+            hasher.write(code.as_bytes());
+        }
+        Source::Package { path } => {
+            hasher.write(b"package");
+            hasher.write_path(path);
+        }
+    }
+
+    // The library name is part of the output path, keep it in the key too
+    hasher.write_path(Path::new(source.output.file_name()?));
+
+    Some(hasher.finish())
+}
@@ -34,6 +34,7 @@ use rustc_session::config::{
 use rustc_session::search_paths::SearchPath;
 use rustc_session::utils::CanonicalizedPath;
 use rustc_span::source_map;
+use serde::{Deserialize, Serialize};
 use std::io::Write;
 use std::iter::{self, FromIterator};
 use std::{
@@ -43,6 +44,7 @@ use std::{
     sync,
 };
 mod ast;
+mod cache;
 pub mod file;
 pub mod memory;
 mod middle;
@@ -207,6 +209,25 @@ fn compiler_sys_root() -> Option<PathBuf> {
         })
 }
 
+// Options shared by every compilation, the artifact cache key is derived from them
+fn compiler_options() -> config::Options {
+    let mut opts = config::Options {
+        maybe_sysroot: compiler_sys_root(),
+        crate_types: vec![CrateType::Cdylib],
+        ..Default::default()
+    };
+
+    opts.output_types = config::OutputTypes::new(&[(config::OutputType::Exe, None)]);
+    opts.optimize = config::OptLevel::Default;
+    opts.unstable_features = rustc_feature::UnstableFeatures::Allow;
+    opts.real_rust_source_base_dir = compiler_source();
+    opts.edition = rustc_span::edition::Edition::Edition2021;
+    // list the rlibs in the dep-info too, so the cache detects changes in the dependencies
+    opts.debugging_opts.binary_dep_depinfo = true;
+
+    opts
+}
+
 fn compiler_source() -> Option<PathBuf> {
     match compiler_sys_root() {
         Some(sys_root) => {
@@ -281,19 +302,19 @@ impl DlopenLibrary {
     }
 }
 
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, Serialize, Deserialize)]
 pub enum Mutability {
     Yes,
     No,
 }
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, Serialize, Deserialize)]
 pub enum Reference {
     Yes,
     No,
 }
 
 #[allow(non_camel_case_types)]
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, Serialize, Deserialize)]
 pub enum FunctionType {
     i16,
     i32,
@@ -324,7 +345,7 @@ impl fmt::Display for FunctionType {
     }
 }
 
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, Serialize, Deserialize)]
 pub struct FunctionParameter {
     name: String,
     mutability: Mutability,
@@ -333,7 +354,7 @@ pub struct FunctionParameter {
     generic: Vec<FunctionParameter>,
 }
 
-#[derive(Clone, Debug, Default)]
+#[derive(Clone, Debug, Default, Serialize, Deserialize)]
 pub struct Function {
     name: String,
     ret: Option<FunctionParameter>,
@@ -349,13 +370,13 @@ impl Function {
     }
 }
 
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, Serialize, Deserialize)]
 pub struct Attribute {
     name: String,
     ty: FunctionParameter,
 }
 
-#[derive(Clone, Debug, Default)]
+#[derive(Clone, Debug, Default, Serialize, Deserialize)]
 pub struct Class {
     name: String,
     constructor: Option<Function>,
@@ -365,11 +386,20 @@ pub struct Class {
     attributes: Vec<Attribute>,
     // static_attributes: Vec<Attribute>, // we don't handle static attrs in rust
 }
-#[derive(Clone, Debug)]
+#[derive(Clone, Debug, Serialize, Deserialize)]
 pub struct CompilerState {
     output: PathBuf,
     functions: Vec<Function>,
     classes: Vec<Class>,
+    // true when the output has been loaded from the artifact cache
+    #[serde(skip)]
+    cached: bool,
+}
+
+impl CompilerState {
+    pub fn is_cached(&self) -> bool {
+        self.cached
+    }
 }
 
 #[derive(Clone, Debug)]
@@ -588,13 +618,15 @@ impl rustc_driver::Callbacks for CompilerCallbacks {
             self.source.output = self.destination.join(file_name);
         } else {
             config.output_file = Some(self.source.output.clone());
+            // emit the files the library depends on, they are validated by the cache
+            config.opts.output_types = config::OutputTypes::new(&[
+                (config::OutputType::Exe, None),
+                (
+                    config::OutputType::DepInfo,
+                    Some(self.destination.join(cache::DEP_INFO_FILE)),
+                ),
+            ]);
         }
-        // Setting up default compiler flags
-        config.opts.output_types = config::OutputTypes::new(&[(config::OutputType::Exe, None)]);
-        config.opts.optimize = config::OptLevel::Default;
-        config.opts.unstable_features = rustc_feature::UnstableFeatures::Allow;
-        config.opts.real_rust_source_base_dir = compiler_source();
-        config.opts.edition = rustc_span::edition::Edition::Edition2021;
     }
 
     fn after_expansion<'tcx>(
@@ -817,11 +849,7 @@ fn run_compiler(
 ) -> Result<(), rustc_errors::ErrorReported> {
     let mut config = Config {
         // Command line options
-        opts: config::Options {
-            maybe_sysroot: compiler_sys_root(),
-            crate_types: vec![CrateType::Cdylib],
-            ..Default::default()
-        },
+        opts: compiler_options(),
         // cfg! configuration in addition to the default ones
         crate_cfg: rustc_hash::FxHashSet::default(), // FxHashSet<(String, Option<String>)>
         input: config::Input::File(PathBuf::new()),
@@ -900,6 +928,12 @@ fn run_compiler(
 }
 
 pub fn compile(source: SourceImpl) -> Result<CompilerState, CompilerError> {
+    // skip the compiler entirely if the artifact is already cached
+    let cache = cache::CacheEntry::new(&source);
+    if let Some(state) = cache.as_ref().and_then(|cache| cache.load()) {
+        return Ok(state);
+    }
+
     let destination = std::env::temp_dir().join(generate_random_string(5));
     let result = std::fs::create_dir(&destination);
     if result.is_err() {
@@ -966,11 +1000,28 @@ pub fn compile(source: SourceImpl) -> Result<CompilerState, CompilerError> {
     })
     .and_then(|result| result)
     {
-        Ok(()) => Ok(CompilerState {
-            output: patched_callback.source.output.clone(),
-            functions: patched_callback.functions,
-            classes: patched_callback.classes,
-        }),
+        Ok(()) => {
+            let state = CompilerState {
+                output: patched_callback.source.output.clone(),
+                functions: patched_callback.functions,
+                classes: patched_callback.classes,
+                cached: false,
+            };
+
+            if let Some(cache) = &cache {
+                let dep_info = patched_callback.destination.join(cache::DEP_INFO_FILE);
+
+                if let Err(error) = cache.store(&state, &dep_info, &patched_callback.destination) {
+                    eprintln!(
+                        "rs_loader was unable to store '{}' in the cache: {}",
+                        state.output.display(),
+                        error
+                    );
+                }
+            }
+
+            Ok(state)
+        }
         Err(err) => {
             // Read buffered diagnostics
             let diagnostics = String::from_utf8(
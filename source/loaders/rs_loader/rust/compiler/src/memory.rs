@@ -28,10 +28,12 @@ impl MemoryRegistration {
             Ok(instance) => instance,
             Err(error) => return Err(RegistrationError::DlopenError(error)),
         };
-        // cleanup temp dir
-        let mut destination = state.output.clone();
-        destination.pop();
-        std::fs::remove_dir_all(destination).expect("Unable to cleanup tempdir");
+        // cleanup temp dir (cached artifacts are owned by the cache)
+        if !state.is_cached() {
+            let mut destination = state.output.clone();
+            destination.pop();
+            std::fs::remove_dir_all(destination).expect("Unable to cleanup tempdir");
+        }
 
         Ok(MemoryRegistration {
             name,
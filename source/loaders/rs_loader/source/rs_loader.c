@@ -33,7 +33,9 @@ loader_impl_interface rs_loader_impl_interface_singleton(void)
 		&rs_loader_impl_load_from_package,
 		&rs_loader_impl_clear,
 		&rs_loader_impl_discover,
-		&rs_loader_impl_destroy
+		&rs_loader_impl_destroy,
+		NULL,
+		0
 	};
 
 	return &loader_impl_interface_rs;
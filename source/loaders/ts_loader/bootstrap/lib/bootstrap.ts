@@ -1,5 +1,6 @@
 #!/usr/bin/env node
-import { readFileSync } from 'fs';
+import { createHash } from 'crypto';
+import { mkdirSync, readdirSync, readFileSync, renameSync, writeFileSync } from 'fs';
 import * as Module from 'module';
 import { EOL } from 'os';
 import * as path from 'path';
@@ -52,11 +53,100 @@ type MetacallExports = Record<string, MetacallExport>;
 
 type MetacallHandle = Record<string, unknown>;
 
+/** Output of a compilation, stored in the cache so it can be replayed without TypeScript */
+type ProgramEmit = {
+	fileName: string;
+	data: string;
+	exports: string[];
+};
+
+/** Cache entry of a program, it is valid while all its source files keep the same hash and no file is added or removed in their directories */
+type ProgramCache = {
+	files: Record<string, string>;
+	directories: Record<string, string>;
+	emits: ProgramEmit[];
+	exportTypes: MetacallExports;
+	diagnostics: string;
+};
+
+/** Cache entry of the exports of a single source file, checked means it was generated by the type checker, which also depends on the files it imports */
+type DeclarationCache = {
+	checked: boolean;
+	dependencies: Record<string, string>;
+	exportTypes: MetacallExports;
+};
+
 const discoverTypes = new Map<string, MetacallExports>();
 
 /** Logging util */
 const log = process.env.METACALL_DEBUG ? console.log : noop;
 
+/** Directory of the on-disk compilation cache, the cache is disabled if it is not defined */
+const cachePath = process.env['TS_LOADER_CACHE_PATH'];
+
+/** Skip the type checker, modules are transpiled one by one and signatures come from the declaration index */
+const transpileOnly = ['1', 'on', 'true', 'yes'].includes((process.env['TS_LOADER_TRANSPILE_ONLY'] || '').toLowerCase());
+
+/** Version of the layout of the cache entries, entries written by other versions are never read */
+const cacheVersion = '2';
+
+/** Util: Hash a list of strings, used for generating the cache keys */
+const hash = (...data: string[]) => {
+	const h = createHash('sha256');
+	for (const d of data) {
+		h.update(d);
+		h.update('\0');
+	}
+	return h.digest('hex');
+};
+
+const cacheRead = <T>(kind: string, key: string): T | null => {
+	if (!cachePath) {
+		return null;
+	}
+	try {
+		return JSON.parse(readFileSync(path.join(cachePath, kind, `${key}.json`), 'utf8')) as T;
+	} catch (_) {
+		return null;
+	}
+};
+
+const cacheWrite = (kind: string, key: string, data: unknown) => {
+	if (!cachePath) {
+		return;
+	}
+	try {
+		const dir = path.join(cachePath, kind);
+		const file = path.join(dir, `${key}.json`);
+		const tmp = `${file}.${process.pid}.tmp`;
+		mkdirSync(dir, { recursive: true });
+		/* Write and rename so other processes never read an incomplete entry */
+		writeFileSync(tmp, JSON.stringify(data));
+		renameSync(tmp, file);
+	} catch (err) {
+		log('Failed to write the cache entry', kind, key, err);
+	}
+};
+
+const declarationKey = (source: string, options: ts.CompilerOptions) =>
+	hash(cacheVersion, ts.version, JSON.stringify(options), source);
+
+/** Util: Check that all the files still have the hash they had when the cache entry was written */
+const isFilesValid = (files: Record<string, string>) =>
+	Object.entries(files).every(([fileName, fileHash]) => {
+		const source = ts.sys.readFile(fileName);
+		return source !== undefined && hash(source) === fileHash;
+	});
+
+/** Util: Hash the entries of a directory, adding or removing a file may change how an import is resolved */
+const hashDirectory = (dir: string) => {
+	try {
+		return hash(...readdirSync(dir).sort());
+	} catch (_) {
+		return '';
+	}
+};
+
 /** Util: Wraps a function in try / catch and possibly logs */
 const safe = <F extends anyF, Def>(f: F, def: Def) =>
 	(...args: Parameters<F>): ReturnType<F> | Def => {
@@ -80,10 +170,8 @@ const defaultCompilerOptions = {
 	lib: ['lib.es2017.d.ts'],
 };
 
-/** Generate diagnostics if any, the return value true means there was an error, false otherwise */
-const generateDiagnostics = (program: ts.Program, diagnostics: readonly ts.Diagnostic[], errors: readonly ts.Diagnostic[]) => {
-	const allDiagnostics = ts.getPreEmitDiagnostics(program).concat(diagnostics, errors);
-
+/** Print the diagnostics if any, the formatted message is returned so it can be cached */
+const printDiagnostics = (allDiagnostics: readonly ts.Diagnostic[]) => {
 	if (allDiagnostics.length) {
 		const formatHost: ts.FormatDiagnosticsHost = {
 			getCanonicalFileName: (path) => path,
@@ -92,9 +180,15 @@ const generateDiagnostics = (program: ts.Program, diagnostics: readonly ts.Diagn
 		};
 		const message = ts.formatDiagnosticsWithColorAndContext(allDiagnostics, formatHost);
 		console.log(message);
+		return message;
 	}
+	return '';
 };
 
+/** Generate diagnostics if any, the formatted message is returned so it can be cached */
+const generateDiagnostics = (program: ts.Program, diagnostics: readonly ts.Diagnostic[], errors: readonly ts.Diagnostic[]) =>
+	printDiagnostics(ts.getPreEmitDiagnostics(program).concat(diagnostics, errors));
+
 const getProgramOptions = (paths: string[] = []) => {
 	const defaultOptions = { options: defaultCompilerOptions, rootNames: paths, configFileParsingDiagnostics: [] };
 	const configFile = ts.findConfigFile(
@@ -130,6 +224,40 @@ const getTranspileOptions = (moduleName: string, path: string) => {
 	};
 };
 
+/** Get the source files of the program imported or referenced by a source file */
+const getImportedFiles = (p: ts.Program, sourceFile: ts.SourceFile) => {
+	const { importedFiles, referencedFiles } = ts.preProcessFile(sourceFile.text, true, true);
+	const options = p.getCompilerOptions();
+	const fileNames = [
+		...importedFiles.map(({ fileName }) =>
+			ts.resolveModuleName(fileName, sourceFile.fileName, options, ts.sys).resolvedModule?.resolvedFileName),
+		...referencedFiles.map(({ fileName }) => path.resolve(path.dirname(sourceFile.fileName), fileName)),
+	];
+	return fileNames
+		.map((fileName) => fileName === undefined ? undefined : p.getSourceFile(fileName))
+		.filter((s): s is ts.SourceFile => s !== undefined && !p.isSourceFileDefaultLibrary(s));
+};
+
+/** Hash the files a source file depends on transitively, the declaration files of the program are always included because they can declare globals */
+const getDependencies = (p: ts.Program, sourceFile: ts.SourceFile) => {
+	const dependencies: Record<string, string> = {};
+	const pending = [
+		sourceFile,
+		...p.getSourceFiles().filter((s) => s.isDeclarationFile && !p.isSourceFileDefaultLibrary(s)),
+	];
+	while (pending.length > 0) {
+		const current = pending.pop() as ts.SourceFile;
+		if (dependencies[current.fileName] !== undefined) {
+			continue;
+		}
+		dependencies[current.fileName] = hash(current.text);
+		pending.push(...getImportedFiles(p, current));
+	}
+	/* The source itself is already part of the key, and it may not exist on disk (i.e. load from memory) */
+	delete dependencies[sourceFile.fileName];
+	return dependencies;
+};
+
 const getMetacallExportTypes = (
 	p: ts.Program,
 	paths: string[] = [],
@@ -156,6 +284,7 @@ const getMetacallExportTypes = (
 		const c = p.getTypeChecker();
 		const sym = c.getSymbolAtLocation(sourceFile);
 		const moduleExports = sym ? c.getExportsOfModule(sym) : [];
+		const fileExportTypes: MetacallExports = {};
 		for (const e of moduleExports) {
 			const metacallType =
 				(exportTypes[e.name] = exportTypes[e.name] || ({} as MetacallExport));
@@ -165,6 +294,7 @@ const getMetacallExportTypes = (
 			if (callSignatures.length === 0) {
 				continue;
 			}
+			fileExportTypes[e.name] = metacallType;
 			for (const signature of callSignatures) {
 				const parameters = signature.getParameters();
 				metacallType.signature = parameters.map((p) => p.name);
@@ -177,12 +307,140 @@ const getMetacallExportTypes = (
 				metacallType.async = Boolean(flags & ts.ModifierFlags.Async);
 			}
 		}
+		/* Feed the declaration index so transpile-only loads get the checked signatures */
+		cacheWrite('declarations', declarationKey(sourceFile.text, p.getCompilerOptions()), {
+			checked: true,
+			dependencies: getDependencies(p, sourceFile),
+			exportTypes: fileExportTypes,
+		});
 		cb(sourceFile, exportTypes);
 	}
 
 	return exportTypes;
 };
 
+/** Extract the signatures of the exported functions without the type checker (types are taken from the annotations) */
+const getSyntacticExportTypes = (fileName: string, source: string, target: ts.ScriptTarget) => {
+	const exportTypes: MetacallExports = {};
+	const sourceFile = ts.createSourceFile(fileName, source, target, true);
+	const typeText = (node?: ts.TypeNode) => node ? node.getText(sourceFile) : 'any';
+	const hasModifier = (node: ts.Node, flag: ts.ModifierFlags) =>
+		Boolean(ts.getCombinedModifierFlags(node as ts.Declaration) & flag);
+	const addFunction = (name: string, fn: ts.SignatureDeclaration) => {
+		const async = hasModifier(fn, ts.ModifierFlags.Async);
+		exportTypes[name] = {
+			signature: fn.parameters.map((p) => p.name.getText(sourceFile)),
+			types: fn.parameters.map((p) => typeText(p.type)),
+			ret: fn.type ? typeText(fn.type) : async ? 'Promise<any>' : 'any',
+			async,
+		} as MetacallExport;
+	};
+
+	for (const statement of sourceFile.statements) {
+		if (ts.isFunctionDeclaration(statement)) {
+			if (statement.name && hasModifier(statement, ts.ModifierFlags.Export)) {
+				addFunction(statement.name.text, statement);
+			}
+		} else if (ts.isVariableStatement(statement)) {
+			for (const d of statement.declarationList.declarations) {
+				if (ts.isIdentifier(d.name) && d.initializer && hasModifier(d, ts.ModifierFlags.Export) &&
+					(ts.isArrowFunction(d.initializer) || ts.isFunctionExpression(d.initializer))) {
+					addFunction(d.name.text, d.initializer);
+				}
+			}
+		}
+	}
+
+	return exportTypes;
+};
+
+/** Get the exports of a source file from the declaration index, if it is not present they are extracted syntactically */
+const getDeclarationExportTypes = (fileName: string, source: string, options: ts.CompilerOptions): MetacallExports => {
+	const key = declarationKey(source, options);
+	const cached = cacheRead<DeclarationCache>('declarations', key);
+	if (cached !== null && isFilesValid(cached.dependencies)) {
+		return cached.exportTypes;
+	}
+	const exportTypes = getSyntacticExportTypes(fileName, source, options.target ?? defaultCompilerOptions.target);
+	cacheWrite('declarations', key, { checked: false, dependencies: {}, exportTypes });
+	return exportTypes;
+};
+
+/** Hash all the non default library source files of a program, the program cache depends on them */
+const getProgramFiles = (p: ts.Program) =>
+	p.getSourceFiles()
+		.filter((sourceFile) => !p.isSourceFileDefaultLibrary(sourceFile))
+		.reduce<Record<string, string>>((acc, sourceFile) => {
+			acc[sourceFile.fileName] = hash(sourceFile.text);
+			return acc;
+		}, {});
+
+/** Hash the directories of the program files, so a new file that could be resolved by an import invalidates the program */
+const getProgramDirectories = (files: string[]) =>
+	[...new Set(files.map((fileName) => path.dirname(fileName)))]
+		.reduce<Record<string, string>>((acc, dir) => {
+			acc[dir] = hashDirectory(dir);
+			return acc;
+		}, {});
+
+/** The program cache is valid if none of the files it was built from has changed and no file was added next to them */
+const isProgramCacheValid = (cache: ProgramCache) =>
+	isFilesValid(cache.files) &&
+	Object.entries(cache.directories).every(([dir, dirHash]) => hashDirectory(dir) === dirHash);
+
+/** Compile an emitted JavaScript module and link the exported functions with their types */
+const emitModule = (
+	emit: ProgramEmit,
+	exportTypes: MetacallExports,
+	discover: boolean,
+	result: MetacallHandle,
+) => {
+	const { fileName, data } = emit;
+	// @ts-ignore
+	const nodeModulePaths = Module._nodeModulePaths(path.dirname(fileName));
+	const parent = module.parent;
+	const m = new Module(fileName, parent || undefined);
+	m.filename = fileName;
+	m.paths = nodeModulePaths;
+	(m as any)._compile(data, fileName);
+	const wrappedExports = wrapFunctionExport(m.exports);
+	const emitExportTypes: MetacallExports = {};
+	for (const name of emit.exports) {
+		const handle = emitExportTypes[name] = exportTypes[name];
+		handle.ptr = wrappedExports[name] as anyF;
+	}
+	if (discover) {
+		discoverTypes.set(fileName, {
+			...(discoverTypes.get(fileName) ?? {}),
+			...emitExportTypes,
+		});
+	}
+	result[fileName] = wrappedExports;
+};
+
+/** Loads TypeScript files without type checking, each file is transpiled in isolation */
+const transpileFromFile = (fileNames: string[], options: ts.CompilerOptions, discover: boolean) => {
+	const result: MetacallHandle = {};
+	const exportTypes: MetacallExports = {};
+	for (const fileName of fileNames) {
+		const source = readFileSync(fileName, 'utf8');
+		const { outputText, diagnostics } = ts.transpileModule(source, {
+			compilerOptions: options,
+			fileName,
+			reportDiagnostics: true,
+		});
+		printDiagnostics(diagnostics ?? []);
+		const fileExportTypes = getDeclarationExportTypes(fileName, source, options);
+		Object.assign(exportTypes, fileExportTypes);
+		emitModule({
+			fileName: fileName.replace(/\.(ts|tsx|jsx)$/, '.js'),
+			data: outputText,
+			exports: Object.keys(fileExportTypes),
+		}, exportTypes, discover, result);
+	}
+	return result;
+};
+
 const fileResolve = (p: string): string => {
     try {
         return node_resolve(p);
@@ -219,35 +477,56 @@ const fileResolveNoThrow = (p: string): string => {
 /** Loads a TypeScript file from disk */
 export const load_from_file = safe(function load_from_file(paths: string[], discover = true) {
 	const result: MetacallHandle = {};
-	const options = getProgramOptions(paths.map(p => fileResolve(p)));
+	const fileNames = paths.map(p => fileResolve(p));
+	const options = getProgramOptions(fileNames);
+
+	if (transpileOnly) {
+		return transpileFromFile(fileNames, options.options, discover);
+	}
+
+	/* Reuse the output of a previous compilation (even from another process) if no source file has changed */
+	const cacheKey = hash(cacheVersion, ts.version, JSON.stringify(options.options), ...options.rootNames.map(path.normalize).sort());
+	const cache = cacheRead<ProgramCache>('programs', cacheKey);
+
+	if (cache !== null && isProgramCacheValid(cache)) {
+		if (cache.diagnostics) {
+			console.log(cache.diagnostics);
+		}
+		for (const emit of cache.emits) {
+			emitModule(emit, cache.exportTypes, discover, result);
+		}
+		return result;
+	}
+
 	const p = ts.createProgram(options);
+	const emits: ProgramEmit[] = [];
+	let diagnosticsMessage = '';
 	// TODO: Handle the emitSkipped?
 	const exportTypes = getMetacallExportTypes(p, paths, (sourceFile, exportTypes) => {
 		const { diagnostics /*, emitSkipped */ } = p.emit(sourceFile, (fileName, data) => {
-			// @ts-ignore
-			const nodeModulePaths = Module._nodeModulePaths(path.dirname(fileName));
-			const parent = module.parent;
-			const m = new Module(fileName, parent || undefined);
-			m.filename = fileName;
-			m.paths = nodeModulePaths;
-			(m as any)._compile(data, fileName);
-			const wrappedExports = wrapFunctionExport(m.exports);
-			for (const [name, handle] of Object.entries(exportTypes)) {
-				handle.ptr = wrappedExports[name] as anyF;
-			}
-			if (discover) {
-				discoverTypes.set(fileName, {
-					...(discoverTypes.get(fileName) ?? {}),
-					...exportTypes,
-				});
-			}
-			result[fileName] = wrappedExports;
+			const emit = { fileName, data, exports: Object.keys(exportTypes) };
+			emitModule(emit, exportTypes, discover, result);
+			emits.push(emit);
 		});
 
-		generateDiagnostics(p, diagnostics, options.configFileParsingDiagnostics);
+		diagnosticsMessage += generateDiagnostics(p, diagnostics, options.configFileParsingDiagnostics);
+	});
+
+	if (exportTypes === null) {
+		return null;
+	}
+
+	const files = getProgramFiles(p);
+
+	cacheWrite('programs', cacheKey, {
+		files,
+		directories: getProgramDirectories(Object.keys(files)),
+		emits,
+		exportTypes,
+		diagnostics: diagnosticsMessage,
 	});
 
-	return exportTypes === null ? null : result;
+	return result;
 }, null);
 
 /** Loads a TypeScript file from memory */
@@ -257,7 +536,7 @@ export const load_from_memory = safe(
 		const { programOptions, transpileOptions } = getTranspileOptions(name, extName);
 		const transpileOutput = ts.transpileModule(data, transpileOptions);
 		const target = programOptions.options.target ?? defaultCompilerOptions.target;
-		const p = ts.createProgram([extName], programOptions.options, {
+		const createProgram = () => ts.createProgram([extName], programOptions.options, {
 			fileExists: (fileName) => fileName === extName,
 			getCanonicalFileName: (fileName) => fileName,
 			getCurrentDirectory: ts.sys.getCurrentDirectory,
@@ -288,7 +567,13 @@ export const load_from_memory = safe(
 			useCaseSensitiveFileNames: () => true,
 			writeFile: () => { },
 		});
-		const exportTypes = getMetacallExportTypes(p);
+		/* Avoid creating the program if the signatures of this source are already in the declaration index */
+		const declarationCache = cacheRead<DeclarationCache>('declarations', declarationKey(data, programOptions.options));
+		const exportTypes = declarationCache !== null && (declarationCache.checked || transpileOnly) && isFilesValid(declarationCache.dependencies)
+			? declarationCache.exportTypes
+			: transpileOnly
+				? getDeclarationExportTypes(extName, data, programOptions.options)
+				: getMetacallExportTypes(createProgram());
 		if (exportTypes === null) {
 			// TODO: Improve error handling
 			return null;
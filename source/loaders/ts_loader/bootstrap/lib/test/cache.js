@@ -0,0 +1,76 @@
+#!/usr/bin/env node
+'use strict';
+
+const path = require('path');
+const os = require('os');
+const fs = require('fs');
+const assert = require('assert');
+const { execFileSync } = require('child_process');
+
+// The cache and the transpile-only mode are read when the bootstrap is loaded, so each load runs in a child process
+if (process.argv[2] === 'child') {
+	const {
+		initialize,
+		discover,
+		load_from_file,
+		destroy,
+	} = require('../build/bootstrap.js');
+
+	initialize();
+	process.chdir(process.argv[3]);
+	const handle = load_from_file(process.argv.slice(4).map(f => path.join(process.argv[3], f)));
+	assert(handle !== null);
+	console.log(`RESULT ${JSON.stringify(discover(handle))}`);
+	destroy();
+	return;
+}
+
+const tempDir = fs.mkdtempSync(path.join(os.tmpdir(), 'ts-loader-bootstrap-cache-test-'));
+const cacheDir = path.join(tempDir, 'cache');
+const sourceDir = path.join(tempDir, 'source');
+
+fs.mkdirSync(sourceDir);
+
+const write = (fileName, data) => fs.writeFileSync(path.join(sourceDir, fileName), data);
+
+const load = (files, transpileOnly = false) => {
+	const env = { ...process.env, TS_LOADER_CACHE_PATH: cacheDir };
+	if (transpileOnly) {
+		env.TS_LOADER_TRANSPILE_ONLY = '1';
+	} else {
+		delete env.TS_LOADER_TRANSPILE_ONLY;
+	}
+	const output = execFileSync(process.execPath, [__filename, 'child', sourceDir, ...files], { env, encoding: 'utf8' });
+	const line = output.split(/\r?\n/).find(l => l.startsWith('RESULT '));
+	assert(line !== undefined, output);
+	return JSON.parse(line.substring('RESULT '.length));
+};
+
+// The return type of a is inferred from b, so it depends on the file it imports
+write('b.ts', `export function b(x: number): number { return x; }\n`);
+write('a.ts', `import { b } from './b';\nexport function a(x: number) { return b(x); }\n`);
+
+assert.strictEqual(load(['a.ts']).a.ret, 'number');
+
+// Cached program and checked declaration are reused
+assert.strictEqual(load(['a.ts']).a.ret, 'number');
+assert.strictEqual(load(['a.ts'], true).a.ret, 'number');
+
+// Changing an imported file invalidates both the program and the checked declaration
+write('b.ts', `export function b(x: number): string { return String(x); }\n`);
+
+assert.notStrictEqual(load(['a.ts'], true).a.ret, 'number');
+assert.strictEqual(load(['a.ts']).a.ret, 'string');
+assert.strictEqual(load(['a.ts'], true).a.ret, 'string');
+
+// A new file which takes precedence in the import resolution invalidates the program
+write('d.js', `exports.d = () => 1;\n`);
+write('c.ts', `import { d } from './d';\nexport function c() { return d(); }\n`);
+
+assert.strictEqual(load(['c.ts']).c.ret, 'any');
+
+write('d.ts', `export function d(): number { return 1; }\n`);
+
+assert.strictEqual(load(['c.ts']).c.ret, 'number');
+
+fs.rmSync(tempDir, { recursive: true, force: true });
@@ -37,6 +37,7 @@ WASM_LOADER_API loader_handle wasm_loader_impl_load_from_package(loader_impl imp
 WASM_LOADER_API int wasm_loader_impl_clear(loader_impl impl, loader_handle handle);
 WASM_LOADER_API int wasm_loader_impl_discover(loader_impl impl, loader_handle handle, context ctx);
 WASM_LOADER_API int wasm_loader_impl_destroy(loader_impl impl);
+WASM_LOADER_API int wasm_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id);
 
 #ifdef __cplusplus
 }
@@ -480,3 +480,12 @@ error_read_file:
 	free(buffer);
 	return ret;
 }
+
+int wasm_loader_impl_fork(loader_impl impl, enum loader_impl_fork_id id)
+{
+	(void)impl;
+	(void)id;
+
+	/* Modules are already compiled and the instances are plain memory, they remain valid in the child */
+	return 0;
+}
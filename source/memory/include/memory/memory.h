@@ -26,6 +26,7 @@
 #include <memory/memory_api.h>
 
 #include <memory/memory_allocator.h>
+#include <memory/memory_allocator_arena.h>
 #include <memory/memory_allocator_nginx.h>
 #include <memory/memory_allocator_std.h>
 
@@ -0,0 +1,242 @@
+/*
+ *	Memory Library by Parra Studios
+ *	A generic cross-platform memory utility.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <memory/memory_allocator_arena_impl.h>
+
+#include <stdint.h>
+#include <string.h>
+
+/* -- Definitions -- */
+
+#define MEMORY_ALLOCATOR_ARENA_ALIGNMENT (sizeof(void *) * 2)
+#define MEMORY_ALLOCATOR_ARENA_ALIGN(size) (((size) + MEMORY_ALLOCATOR_ARENA_ALIGNMENT - 1) & ~(MEMORY_ALLOCATOR_ARENA_ALIGNMENT - 1))
+#define MEMORY_ALLOCATOR_ARENA_CHUNK_SIZE ((size_t)0x1000)
+#define MEMORY_ALLOCATOR_ARENA_CHUNK_LIMIT ((size_t)0x100000)
+
+/* -- Forward Declarations -- */
+
+struct memory_allocator_arena_chunk_type;
+
+struct memory_allocator_arena_impl_type;
+
+/* -- Type Definitions -- */
+
+typedef struct memory_allocator_arena_chunk_type *memory_allocator_arena_chunk;
+
+typedef struct memory_allocator_arena_impl_type *memory_allocator_arena_impl;
+
+/* -- Member Data -- */
+
+struct memory_allocator_arena_chunk_type
+{
+	memory_allocator_arena_chunk next;
+	size_t size;
+	size_t used;
+	size_t last;
+};
+
+struct memory_allocator_arena_impl_type
+{
+	memory_allocator_arena_chunk head;
+	size_t chunk_size;
+};
+
+/* -- Private Methods -- */
+
+static memory_allocator_impl memory_allocator_arena_create(void *ctx);
+
+static void *memory_allocator_arena_allocate(memory_allocator_impl impl, size_t size);
+
+static void *memory_allocator_arena_reallocate(memory_allocator_impl impl, void *data, size_t size, size_t new_size);
+
+static void memory_allocator_arena_deallocate(memory_allocator_impl impl, void *data);
+
+static void memory_allocator_arena_destroy(memory_allocator_impl impl);
+
+static memory_allocator_arena_chunk memory_allocator_arena_chunk_create(memory_allocator_arena_impl arena_impl, size_t size);
+
+static void *memory_allocator_arena_chunk_data(memory_allocator_arena_chunk chunk, size_t offset);
+
+/* -- Methods -- */
+
+memory_allocator_iface memory_allocator_arena_iface(void)
+{
+	static struct memory_allocator_iface_type allocator_arena_iface = {
+		&memory_allocator_arena_create,
+		&memory_allocator_arena_allocate,
+		&memory_allocator_arena_reallocate,
+		&memory_allocator_arena_deallocate,
+		&memory_allocator_arena_destroy
+	};
+
+	return &allocator_arena_iface;
+}
+
+memory_allocator_impl memory_allocator_arena_create(void *ctx)
+{
+	memory_allocator_arena_ctx arena_ctx = (memory_allocator_arena_ctx)ctx;
+
+	memory_allocator_arena_impl arena_impl = malloc(sizeof(struct memory_allocator_arena_impl_type));
+
+	if (arena_impl == NULL)
+	{
+		return NULL;
+	}
+
+	arena_impl->head = NULL;
+	arena_impl->chunk_size = (arena_ctx == NULL || arena_ctx->chunk_size == 0) ? MEMORY_ALLOCATOR_ARENA_CHUNK_SIZE : MEMORY_ALLOCATOR_ARENA_ALIGN(arena_ctx->chunk_size);
+
+	return (memory_allocator_impl)arena_impl;
+}
+
+memory_allocator_arena_chunk memory_allocator_arena_chunk_create(memory_allocator_arena_impl arena_impl, size_t size)
+{
+	size_t chunk_size = arena_impl->chunk_size;
+	memory_allocator_arena_chunk chunk;
+
+	if (chunk_size < size)
+	{
+		chunk_size = size;
+	}
+
+	chunk = malloc(MEMORY_ALLOCATOR_ARENA_ALIGN(sizeof(struct memory_allocator_arena_chunk_type)) + chunk_size);
+
+	if (chunk == NULL)
+	{
+		return NULL;
+	}
+
+	chunk->next = arena_impl->head;
+	chunk->size = chunk_size;
+	chunk->used = 0;
+	chunk->last = 0;
+
+	arena_impl->head = chunk;
+
+	/* Grow the chunks geometrically so big scopes only need a few of them */
+	if (arena_impl->chunk_size < MEMORY_ALLOCATOR_ARENA_CHUNK_LIMIT)
+	{
+		arena_impl->chunk_size *= 2;
+	}
+
+	return chunk;
+}
+
+void *memory_allocator_arena_chunk_data(memory_allocator_arena_chunk chunk, size_t offset)
+{
+	return (void *)(((uintptr_t)chunk) + MEMORY_ALLOCATOR_ARENA_ALIGN(sizeof(struct memory_allocator_arena_chunk_type)) + offset);
+}
+
+void *memory_allocator_arena_allocate(memory_allocator_impl impl, size_t size)
+{
+	memory_allocator_arena_impl arena_impl = (memory_allocator_arena_impl)impl;
+
+	memory_allocator_arena_chunk chunk = arena_impl->head;
+
+	size = MEMORY_ALLOCATOR_ARENA_ALIGN(size);
+
+	if (chunk == NULL || chunk->size - chunk->used < size)
+	{
+		chunk = memory_allocator_arena_chunk_create(arena_impl, size);
+
+		if (chunk == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	chunk->last = chunk->used;
+	chunk->used += size;
+
+	return memory_allocator_arena_chunk_data(chunk, chunk->last);
+}
+
+void *memory_allocator_arena_reallocate(memory_allocator_impl impl, void *data, size_t size, size_t new_size)
+{
+	memory_allocator_arena_impl arena_impl = (memory_allocator_arena_impl)impl;
+
+	memory_allocator_arena_chunk chunk = arena_impl->head;
+
+	void *new_data;
+
+	if (data == NULL)
+	{
+		return memory_allocator_arena_allocate(impl, new_size);
+	}
+
+	/* The last block of the current chunk can be resized in place */
+	if (chunk != NULL && data == memory_allocator_arena_chunk_data(chunk, chunk->last))
+	{
+		size_t aligned_size = MEMORY_ALLOCATOR_ARENA_ALIGN(new_size);
+
+		if (chunk->size - chunk->last >= aligned_size)
+		{
+			chunk->used = chunk->last + aligned_size;
+
+			return data;
+		}
+	}
+
+	new_data = memory_allocator_arena_allocate(impl, new_size);
+
+	if (new_data == NULL)
+	{
+		return NULL;
+	}
+
+	memcpy(new_data, data, size < new_size ? size : new_size);
+
+	return new_data;
+}
+
+void memory_allocator_arena_deallocate(memory_allocator_impl impl, void *data)
+{
+	memory_allocator_arena_impl arena_impl = (memory_allocator_arena_impl)impl;
+
+	memory_allocator_arena_chunk chunk = arena_impl->head;
+
+	/* Memory is released all at once when the arena is destroyed, only the
+	* last block can be reclaimed earlier, which is the common case for temporaries
+	*/
+	if (chunk != NULL && data == memory_allocator_arena_chunk_data(chunk, chunk->last))
+	{
+		chunk->used = chunk->last;
+	}
+}
+
+void memory_allocator_arena_destroy(memory_allocator_impl impl)
+{
+	memory_allocator_arena_impl arena_impl = (memory_allocator_arena_impl)impl;
+
+	memory_allocator_arena_chunk chunk = arena_impl->head;
+
+	while (chunk != NULL)
+	{
+		memory_allocator_arena_chunk next = chunk->next;
+
+		free(chunk);
+
+		chunk = next;
+	}
+
+	free(arena_impl);
+}
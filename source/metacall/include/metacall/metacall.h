@@ -26,9 +26,12 @@
 #include <metacall/metacall_api.h>
 
 #include <metacall/metacall_allocator.h>
+#include <metacall/metacall_arena.h>
 #include <metacall/metacall_def.h>
 #include <metacall/metacall_error.h>
 #include <metacall/metacall_log.h>
+#include <metacall/metacall_metrics.h>
+#include <metacall/metacall_queue.h>
 #include <metacall/metacall_value.h>
 #include <metacall/metacall_version.h>
 
@@ -48,7 +51,9 @@ extern "C" {
 
 /* -- Definitions -- */
 
-#define METACALL_FLAGS_FORK_SAFE 0x01 << 0x00
+#define METACALL_FLAGS_FORK_SAFE   0x01 << 0x00
+#define METACALL_FLAGS_FORK_ZYGOTE 0x01 << 0x01
+#define METACALL_FLAGS_METRICS     0x01 << 0x02
 
 /* -- Forward Declarations -- */
 
@@ -604,6 +609,20 @@ METACALL_API size_t metacall_function_size(void *func);
 */
 METACALL_API int metacall_function_async(void *func);
 
+/**
+*  @brief
+*    Check if the function @func can be called from any thread, or only
+*    from the thread that initialized the loader which the function belongs to
+*
+*  @param[in] func
+*    Function reference
+*
+*  @return
+*    Return 1 if it can be called from any thread, 0 if it can be called
+*    only from the thread of its loader and -1 if the function is NULL
+*/
+METACALL_API int metacall_function_multithread(void *func);
+
 /**
 *  @brief
 *    Get the handle by @name
@@ -1438,6 +1457,28 @@ METACALL_API char *metacall_serialize(const char *name, void *v, size_t *size, v
 */
 METACALL_API void *metacall_deserialize(const char *name, const char *buffer, size_t size, void *allocator);
 
+/**
+*  @brief
+*    Convert the string @buffer to value, buffers of the value may
+*    reference @buffer instead of being copied if the serial supports it
+*
+*  @param[in] name
+*    Name of the serial to be used
+*
+*  @param[in] buffer
+*    String to be deserialized, it must outlive the returned value
+*
+*  @param[in] size
+*    Size of string @buffer
+*
+*  @param[in] allocator
+*    Pointer to allocator will allocate the value
+*
+*  @return
+*    New allocated value representing the string (must be freed)
+*/
+METACALL_API void *metacall_deserialize_borrowed(const char *name, const char *buffer, size_t size, void *allocator);
+
 /**
 *  @brief
 *    Clear handle from memory and unload related resources
@@ -1450,6 +1491,45 @@ METACALL_API void *metacall_deserialize(const char *name, const char *buffer, si
 */
 METACALL_API int metacall_clear(void *handle);
 
+/**
+*  @brief
+*    Load again the files of a handle and replace its functions, the previous
+*    versions are kept until the next reload, or while their functions are referenced
+*    by a value or a call in flight, if the reload fails the previous version is kept
+*
+*  @param[in] handle
+*    Reference to the handle to be reloaded (it must be loaded from file)
+*
+*  @return
+*    Zero if success, different from zero otherwise
+*/
+METACALL_API int metacall_reload(void *handle);
+
+/**
+*  @brief
+*    Watch the files of a handle and reload it in background each time they change,
+*    relative paths are resolved with the execution paths of the loader as it is done
+*    when loading them, the handle stops being watched when it is cleared
+*
+*  @param[in] handle
+*    Reference to the handle to be watched (it must be loaded from file)
+*
+*  @return
+*    Zero if success, different from zero otherwise
+*/
+METACALL_API int metacall_watch(void *handle);
+
+/**
+*  @brief
+*    Get a counter which is increased each time a handle is reloaded or cleared,
+*    the functions obtained before the counter changed may be outdated or destroyed,
+*    so they must be obtained again by name (i.e. metacall_function)
+*
+*  @return
+*    Current value of the counter
+*/
+METACALL_API size_t metacall_generation(void);
+
 /**
 *  @brief
 *    Get the plugin extension handle to be used for loading plugins
@@ -145,6 +145,33 @@ METACALL_API void metacall_allocator_free(void *allocator, void *data);
 */
 METACALL_API void metacall_allocator_destroy(void *allocator);
 
+/**
+*  @brief
+*    Begin an allocator scope in the current thread, all values created
+*    from now on in this thread (arguments, return values, nested arrays and
+*    maps, and values produced by loaders or deserialization) are reserved
+*    from @allocator, so they can be released all together with it
+*
+*  @param[in] allocator
+*    Pointer to allocator instance, or null to use the default heap allocation
+*
+*  @return
+*    Pointer to the allocator that was active before, it must be passed
+*    to metacall_allocator_scope_end in order to restore it
+*/
+METACALL_API void *metacall_allocator_scope_begin(void *allocator);
+
+/**
+*  @brief
+*    End an allocator scope in the current thread, values created inside the
+*    scope still belong to its allocator and must not outlive it, use
+*    metacall_value_copy after the scope has ended in order to keep them
+*
+*  @param[in] previous
+*    Pointer to the allocator returned by metacall_allocator_scope_begin
+*/
+METACALL_API void metacall_allocator_scope_end(void *previous);
+
 #ifdef __cplusplus
 }
 #endif
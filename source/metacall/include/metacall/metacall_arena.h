@@ -0,0 +1,84 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#ifndef METACALL_ARENA_H
+#define METACALL_ARENA_H 1
+
+/* -- Headers -- */
+
+#include <metacall/metacall_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -- Methods -- */
+
+/**
+*  @brief
+*    Begin a value arena in the current thread, all values created from
+*    now on in this thread (arguments, return values, nested arrays and maps)
+*    are bump allocated from the arena and released together at its end,
+*    so they do not need to be destroyed one by one
+*
+*  @return
+*    Pointer to the arena on success, null otherwise
+*/
+METACALL_API void *metacall_arena_begin(void);
+
+/**
+*  @brief
+*    Copy a value out of the arena, the copy is allocated from the allocator
+*    that was active when the arena began (the heap, or the enclosing arena
+*    when arenas are nested), so it outlives the arena
+*
+*  @param[in] arena
+*    Pointer to the arena returned by metacall_arena_begin
+*
+*  @param[in] v
+*    Value created inside the arena
+*
+*  @return
+*    Copy of the value on success, null otherwise
+*/
+METACALL_API void *metacall_arena_escape(void *arena, void *v);
+
+/**
+*  @brief
+*    End a value arena and release all values created inside it at once,
+*    the finalizers of the values still alive (i.e opaque pointers to objects
+*    of a runtime) are run and the functions, classes, objects, futures or
+*    exceptions held by them are released before the memory is freed
+*
+*  @param[in] arena
+*    Pointer to the arena returned by metacall_arena_begin
+*
+*  @return
+*    Zero if success, different from zero otherwise, arenas must be ended in
+*    reverse order of creation and from the thread that began them, if not,
+*    the arena is not ended and the current one stays active
+*/
+METACALL_API int metacall_arena_end(void *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METACALL_ARENA_H */
@@ -59,6 +59,12 @@ typedef pid_t metacall_pid;
 	#error "Unknown metacall fork safety platform"
 #endif
 
+enum metacall_fork_mode_id
+{
+	METACALL_FORK_MODE_RESTART, /* Destroy MetaCall before the fork and initialize it again after (default) */
+	METACALL_FORK_MODE_ZYGOTE	/* Keep loaded runtimes and handles across the fork */
+};
+
 typedef int (*metacall_pre_fork_callback_ptr)(void *);
 typedef int (*metacall_post_fork_callback_ptr)(metacall_pid, void *);
 
@@ -85,6 +91,21 @@ METACALL_API int metacall_fork_initialize(void);
 */
 METACALL_API void metacall_fork(metacall_pre_fork_callback_ptr pre_callback, metacall_post_fork_callback_ptr post_callback);
 
+/**
+*  @brief
+*    Set how MetaCall behaves when the process forks
+*
+*    In zygote mode, a warmed parent keeps its loaders and handles across the fork. Fork safe
+*    runtimes (Python, C, WebAssembly...) keep their state in the child, so spawning a worker
+*    does not pay the initialization cost again. Runtimes that do not survive a fork (NodeJS,
+*    Java...) are detached in the child and initialized again on demand the next time their tag
+*    is used, so their handles must be loaded again in the child (i.e in the post fork callback)
+*
+*  @param[in] mode
+*    Fork mode to be used, METACALL_FORK_MODE_RESTART by default
+*/
+METACALL_API void metacall_fork_mode(enum metacall_fork_mode_id mode);
+
 /**
 *  @brief
 *    Unregister fork detours and destroy shared memory
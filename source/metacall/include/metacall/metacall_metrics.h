@@ -0,0 +1,90 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#ifndef METACALL_METRICS_H
+#define METACALL_METRICS_H 1
+
+/* -- Headers -- */
+
+#include <metacall/metacall_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -- Headers -- */
+
+#include <stdlib.h>
+
+/* -- Methods -- */
+
+/**
+*  @brief
+*    Enable or disable the call metrics, while disabled calls are not
+*    instrumented and the metrics already collected are preserved, it
+*    can also be enabled at initialization with METACALL_FLAGS_METRICS
+*
+*  @param[in] enable
+*    Different from zero to enable the metrics, zero to disable them
+*/
+METACALL_API void metacall_metrics_enable(int enable);
+
+/**
+*  @brief
+*    Check if the call metrics are enabled
+*
+*  @return
+*    Different from zero if enabled, zero otherwise
+*/
+METACALL_API int metacall_metrics_enabled(void);
+
+/**
+*  @brief
+*    Provide the call metrics of all loaders, indexed by loader tag, each loader
+*    contains the merged metrics of all its functions in "total" and the metrics of
+*    each called function in "functions", indexed by name, with the number of calls,
+*    errors, calls in flight, total latency, latency percentiles and histogram
+*
+*  @return
+*    Value containing the metrics, it must be destroyed with metacall_value_destroy
+*/
+METACALL_API void *metacall_metrics(void);
+
+/**
+*  @brief
+*    Provide the call metrics of all loaders in Prometheus text exposition format,
+*    the latency histograms use the buckets with at least one sample as boundaries
+*
+*  @param[out] size
+*    Size in bytes of return buffer, including the null terminator
+*
+*  @param[in] allocator
+*    Pointer to allocator will allocate the string
+*
+*  @return
+*    String containing the metrics, null if there was an error
+*/
+METACALL_API char *metacall_metrics_prometheus(size_t *size, void *allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METACALL_METRICS_H */
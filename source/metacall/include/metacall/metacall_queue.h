@@ -0,0 +1,175 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#ifndef METACALL_QUEUE_H
+#define METACALL_QUEUE_H 1
+
+/* -- Headers -- */
+
+#include <metacall/metacall_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -- Headers -- */
+
+#include <stddef.h>
+
+/* -- Enumerations -- */
+
+enum metacall_completion_id
+{
+	METACALL_COMPLETION_RESOLVE = 0,
+	METACALL_COMPLETION_REJECT = 1,
+	METACALL_COMPLETION_ERROR = 2
+};
+
+/* -- Member Data -- */
+
+struct metacall_completion_type
+{
+	void *tag;
+	void *result;
+	enum metacall_completion_id id;
+};
+
+/* -- Methods -- */
+
+/**
+*  @brief
+*    Create a completion queue where the results of the submitted calls are posted
+*
+*  @return
+*    Pointer to the queue on success, null otherwise
+*/
+METACALL_API void *metacall_queue_create(void);
+
+/**
+*  @brief
+*    Get the file descriptor that becomes readable while there are completions or deferred calls in the queue,
+*    it can be registered into an event loop (epoll, poll, select...) but it must not be read directly
+*
+*  @param[in] q
+*    Pointer to the completion queue
+*
+*  @return
+*    File descriptor of the queue, -1 if it is not supported in this platform
+*/
+METACALL_API int metacall_queue_fd(void *q);
+
+/**
+*  @brief
+*    Call a function @func with arguments @args and post the result into the queue @q,
+*    if the function is synchronous the arguments are copied and the call is deferred until
+*    the queue is reaped (metacall_queue_poll or metacall_queue_wait), where the pending
+*    synchronous calls are executed in submission order, otherwise the completion is
+*    posted when the future is settled, from the thread of the runtime that settles it
+*
+*  @param[in] q
+*    Pointer to the completion queue
+*
+*  @param[in] func
+*    Reference to function to be called
+*
+*  @param[in] args
+*    Array of pointers to values
+*
+*  @param[in] size
+*    Number of elements of the array @args
+*
+*  @param[in] tag
+*    User defined pointer that will be returned in the completion of this call
+*
+*  @return
+*    Zero if the call has been submitted, in that case exactly one completion will be posted,
+*    different from zero otherwise (no completion will be posted)
+*/
+METACALL_API int metacall_queue_submit(void *q, void *func, void *args[], size_t size, void *tag);
+
+/**
+*  @brief
+*    Execute the deferred synchronous calls and reap up to @size completions from the queue @q
+*    without blocking, the ownership of the result of each completion is transferred to the caller,
+*    that must destroy it with metacall_value_destroy
+*
+*  @param[in] q
+*    Pointer to the completion queue
+*
+*  @param[out] completions
+*    Array where the completions will be stored
+*
+*  @param[in] size
+*    Number of elements of the array @completions
+*
+*  @return
+*    Number of completions stored in @completions
+*/
+METACALL_API size_t metacall_queue_poll(void *q, struct metacall_completion_type completions[], size_t size);
+
+/**
+*  @brief
+*    Reap up to @size completions from the queue @q, blocking until at least one completion is available
+*
+*  @param[in] q
+*    Pointer to the completion queue
+*
+*  @param[out] completions
+*    Array where the completions will be stored
+*
+*  @param[in] size
+*    Number of elements of the array @completions
+*
+*  @param[in] timeout
+*    Maximum time to wait in milliseconds, a negative value waits indefinitely
+*
+*  @return
+*    Number of completions stored in @completions, zero if the timeout expired
+*/
+METACALL_API size_t metacall_queue_wait(void *q, struct metacall_completion_type completions[], size_t size, int timeout);
+
+/**
+*  @brief
+*    Get the number of submitted calls whose completion has not been posted yet
+*
+*  @param[in] q
+*    Pointer to the completion queue
+*
+*  @return
+*    Number of calls in flight
+*/
+METACALL_API size_t metacall_queue_pending(void *q);
+
+/**
+*  @brief
+*    Destroy the queue @q and the completions that have not been reaped, the deferred synchronous
+*    calls are discarded without being executed and the calls that are still in flight will discard
+*    their results when they complete
+*
+*  @param[in] q
+*    Pointer to the completion queue
+*/
+METACALL_API void metacall_queue_destroy(void *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METACALL_QUEUE_H */
@@ -384,7 +384,8 @@ METACALL_API const char *metacall_value_type_name(void *v);
 /**
 *  @brief
 *    Deep copies the value @v, the result copy resets
-*    the reference counter and ownership, including the finalizer
+*    the reference counter and ownership, including the finalizer,
+*    copies made inside an arena belong to it (see metacall_arena_escape)
 *
 *  @param[in] v
 *    Reference to the value to be copied
@@ -394,6 +395,25 @@ METACALL_API const char *metacall_value_type_name(void *v);
 */
 METACALL_API void *metacall_value_copy(void *v);
 
+/**
+*  @brief
+*    Copies the value @v on write, arrays and maps get their own list of
+*    elements, so elements can be replaced through metacall_value_to_array
+*    or metacall_value_to_map without modifying the containers of @v, the
+*    rest of values are shared with @v by incrementing their reference
+*    counter, writing into a shared value with metacall_value_from_* or
+*    casting it duplicates it first, so the returned value must be used
+*    (and stored back into its container) from then on, both @v and the
+*    result must be destroyed
+*
+*  @param[in] v
+*    Reference to the value to be shared
+*
+*  @return
+*    Shared copy of the value @v on success, null otherwhise
+*/
+METACALL_API void *metacall_value_share(void *v);
+
 /**
 *  @brief
 *    Creates a new pointer value, with a reference to the
@@ -25,6 +25,8 @@
 
 #include <loader/loader.h>
 
+#include <adt/adt_intern.h>
+
 #include <reflect/reflect.h>
 
 #include <configuration/configuration.h>
@@ -178,10 +180,28 @@ int metacall_initialize(void)
 			log_write("metacall", LOG_LEVEL_ERROR, "Invalid MetaCall fork initialization");
 		}
 
+		if (metacall_config_flags & METACALL_FLAGS_FORK_ZYGOTE)
+		{
+			metacall_fork_mode(METACALL_FORK_MODE_ZYGOTE);
+		}
+
 		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall fork initialized");
 	}
 #endif /* METACALL_FORK_SAFE */
 
+	if (metacall_config_flags & METACALL_FLAGS_METRICS)
+	{
+		metacall_metrics_enable(1);
+
+		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall metrics enabled");
+	}
+
+	if (intern_initialize() != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid MetaCall intern string pool initialization");
+		return 1;
+	}
+
 	allocator = memory_allocator_std(&malloc, &realloc, &free);
 
 	if (configuration_initialize(metacall_serial(), NULL, allocator) != 0)
@@ -966,6 +986,18 @@ int metacall_function_async(void *func)
 	return -1;
 }
 
+int metacall_function_multithread(void *func)
+{
+	function f = (function)func;
+
+	if (f != NULL)
+	{
+		return loader_get_multithread(f);
+	}
+
+	return -1;
+}
+
 void *metacall_handle(const char *tag, const char *name)
 {
 	return (void *)loader_get_handle(tag, name);
@@ -1219,8 +1251,8 @@ void *metacallfs(void *func, const char *buffer, size_t size, void *allocator)
 
 			for (iterator = 0; iterator < args_count; ++iterator)
 			{
-				/* This step is necessary in order to handle type castings */
-				args[iterator] = metacall_value_copy(v_array[iterator]);
+				/* This step is necessary in order to handle type castings, a cast releases the shared argument instead of destroying it */
+				args[iterator] = value_type_copy_on_write(v_array[iterator]);
 			}
 
 			ret = metacallfv_s(f, args, args_count);
@@ -1774,8 +1806,8 @@ void *metacallfs_await(void *func, const char *buffer, size_t size, void *alloca
 
 			for (iterator = 0; iterator < args_count; ++iterator)
 			{
-				/* This step is necessary in order to handle type castings */
-				args[iterator] = value_type_copy(v_array[iterator]);
+				/* This step is necessary in order to handle type castings, a cast releases the shared argument instead of destroying it */
+				args[iterator] = value_type_copy_on_write(v_array[iterator]);
 			}
 
 			ret = metacallfv_await(f, args, resolve_callback, reject_callback, data);
@@ -2214,6 +2246,13 @@ void *metacall_deserialize(const char *name, const char *buffer, size_t size, vo
 	return (void *)serial_deserialize(s, buffer, size, (memory_allocator)allocator);
 }
 
+void *metacall_deserialize_borrowed(const char *name, const char *buffer, size_t size, void *allocator)
+{
+	serial s = serial_create(name);
+
+	return (void *)serial_deserialize_borrowed(s, buffer, size, (memory_allocator)allocator);
+}
+
 int metacall_clear(void *handle)
 {
 	if (loader_impl_handle_validate(handle) != 0)
@@ -2226,6 +2265,33 @@ int metacall_clear(void *handle)
 	return loader_clear(handle);
 }
 
+int metacall_reload(void *handle)
+{
+	if (loader_impl_handle_validate(handle) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Handle %p passed to metacall_reload is not valid", handle);
+		return 1;
+	}
+
+	return loader_reload(handle);
+}
+
+int metacall_watch(void *handle)
+{
+	if (loader_impl_handle_validate(handle) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Handle %p passed to metacall_watch is not valid", handle);
+		return 1;
+	}
+
+	return loader_watch(handle);
+}
+
+size_t metacall_generation(void)
+{
+	return loader_generation();
+}
+
 void *metacall_plugin_extension(void)
 {
 	return plugin_extension_handle;
@@ -2261,6 +2327,9 @@ int metacall_destroy(void)
 		/* Print stats from functions, classes, objects and exceptions */
 		reflect_memory_tracker_debug();
 
+		/* Release the names of the symbols, nothing references them once the loaders are destroyed */
+		intern_destroy();
+
 		/* Set to null the plugin extension and core plugin handles */
 		plugin_extension_handle = NULL;
 		plugin_core_handle = NULL;
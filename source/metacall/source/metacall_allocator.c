@@ -24,6 +24,8 @@
 
 #include <memory/memory.h>
 
+#include <reflect/reflect_value.h>
+
 /* -- Methods -- */
 
 void *metacall_allocator_create(enum metacall_allocator_id allocator_id, void *ctx)
@@ -68,3 +70,13 @@ void metacall_allocator_destroy(void *allocator)
 {
 	memory_allocator_destroy((memory_allocator)allocator);
 }
+
+void *metacall_allocator_scope_begin(void *allocator)
+{
+	return value_allocator((memory_allocator)allocator);
+}
+
+void metacall_allocator_scope_end(void *previous)
+{
+	(void)value_allocator((memory_allocator)previous);
+}
@@ -0,0 +1,126 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <metacall/metacall_arena.h>
+
+#include <memory/memory.h>
+
+#include <reflect/reflect_value.h>
+#include <reflect/reflect_value_type.h>
+
+#include <log/log.h>
+
+/* -- Forward Declarations -- */
+
+struct metacall_arena_type;
+
+/* -- Type Definitions -- */
+
+typedef struct metacall_arena_type *metacall_arena;
+
+/* -- Member Data -- */
+
+struct metacall_arena_type
+{
+	memory_allocator allocator;
+	memory_allocator previous;
+};
+
+/* -- Methods -- */
+
+void *metacall_arena_begin(void)
+{
+	memory_allocator allocator = memory_allocator_arena(0);
+	metacall_arena arena;
+
+	if (allocator == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid arena allocation");
+		return NULL;
+	}
+
+	/* The arena descriptor lives in the arena itself, so it is released with it */
+	arena = memory_allocator_allocate(allocator, sizeof(struct metacall_arena_type));
+
+	if (arena == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid arena descriptor allocation");
+		memory_allocator_destroy(allocator);
+		return NULL;
+	}
+
+	arena->allocator = allocator;
+	arena->previous = value_allocator(allocator);
+
+	return arena;
+}
+
+void *metacall_arena_escape(void *arena, void *v)
+{
+	metacall_arena a = (metacall_arena)arena;
+	memory_allocator current;
+	value copy;
+
+	if (a == NULL || v == NULL)
+	{
+		return NULL;
+	}
+
+	current = value_allocator(a->previous);
+
+	copy = value_type_copy(v);
+
+	(void)value_allocator(current);
+
+	return copy;
+}
+
+int metacall_arena_end(void *arena)
+{
+	metacall_arena a = (metacall_arena)arena;
+	memory_allocator allocator;
+
+	if (a == NULL)
+	{
+		return 1;
+	}
+
+	allocator = a->allocator;
+
+	/* Ending an arena which is not the current one would leave the current thread allocating from a released arena */
+	if (value_allocator_current() != allocator)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid arena end, arenas must be ended in reverse order of creation and from the thread that began them");
+		return 1;
+	}
+
+	(void)value_allocator(a->previous);
+
+	/* Chunks are released at once, so the values still alive are not destroyed one by one, only their
+	* finalizers are run and the functions, classes, objects, futures or exceptions they hold are released
+	*/
+	value_type_allocator_finalize(allocator);
+
+	memory_allocator_destroy(allocator);
+
+	return 0;
+}
@@ -13,6 +13,8 @@
 
 #include <detour/detour.h>
 
+#include <loader/loader.h>
+
 #include <log/log.h>
 
 #include <stdlib.h>
@@ -35,6 +37,9 @@
 
 	#define metacall_fork_pid _getpid
 
+	/* Status returned by RtlCloneUserProcess in the child process */
+	#define METACALL_FORK_RTL_CLONE_CHILD ((NTSTATUS)0x00000129L)
+
 /* -- Type Definitions -- */
 
 typedef long NTSTATUS;
@@ -113,6 +118,8 @@ static metacall_post_fork_callback_ptr metacall_post_fork_callback = NULL;
 
 static int metacall_fork_flag = 1;
 
+static enum metacall_fork_mode_id metacall_fork_mode_current = METACALL_FORK_MODE_RESTART;
+
 /* -- Methods -- */
 
 #if defined(WIN32) || defined(_WIN32) || \
@@ -163,32 +170,53 @@ NTSTATUS NTAPI metacall_fork_hook(ULONG ProcessFlags,
 		}
 	}
 
-	log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork auto destroy");
-
-	/* Destroy metacall before the fork */
-	if (metacall_destroy() != 0)
+	if (metacall_fork_mode_current == METACALL_FORK_MODE_ZYGOTE)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto destruction");
-	}
+		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork zygote");
+
+		/* Keep the runtimes loaded, only prepare them for the fork */
+		if (loader_fork(LOADER_IMPL_FORK_PREPARE) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork zygote preparation");
+		}
 
-	/* Execute the real fork */
-	result = metacall_fork_trampoline(ProcessFlags, ProcessSecurityDescriptor, ThreadSecurityDescriptor, DebugPort, ProcessInformation);
+		/* Execute the real fork */
+		result = metacall_fork_trampoline(ProcessFlags, ProcessSecurityDescriptor, ThreadSecurityDescriptor, DebugPort, ProcessInformation);
 
-	if (result != ((NTSTATUS)0x00000000L))
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork trampoline invocation");
+		if (loader_fork(result == METACALL_FORK_RTL_CLONE_CHILD ? LOADER_IMPL_FORK_CHILD : LOADER_IMPL_FORK_PARENT) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork zygote restoration");
+		}
 	}
+	else
+	{
+		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork auto destroy");
 
-	log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork re-initialize");
+		/* Destroy metacall before the fork */
+		if (metacall_destroy() != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto destruction");
+		}
 
-	/* Initialize metacall again */
-	if (metacall_initialize() != 0)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto initialization");
-	}
+		/* Execute the real fork */
+		result = metacall_fork_trampoline(ProcessFlags, ProcessSecurityDescriptor, ThreadSecurityDescriptor, DebugPort, ProcessInformation);
 
-	/* Set again the callbacks in the new process */
-	metacall_fork(pre_callback, post_callback);
+		if (result != ((NTSTATUS)0x00000000L))
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork trampoline invocation");
+		}
+
+		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork re-initialize");
+
+		/* Initialize metacall again */
+		if (metacall_initialize() != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto initialization");
+		}
+
+		/* Set again the callbacks in the new process */
+		metacall_fork(pre_callback, post_callback);
+	}
 
 	/* Execute post fork callback */
 	if (post_callback != NULL)
@@ -238,27 +266,48 @@ pid_t metacall_fork_hook(void)
 		}
 	}
 
-	log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork auto destroy");
-
-	/* Destroy metacall before the fork */
-	if (metacall_destroy() != 0)
+	if (metacall_fork_mode_current == METACALL_FORK_MODE_ZYGOTE)
 	{
-		log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto destruction fail");
-	}
+		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork zygote");
 
-	/* Execute the real fork */
-	pid = metacall_fork_trampoline();
+		/* Keep the runtimes loaded, only prepare them for the fork */
+		if (loader_fork(LOADER_IMPL_FORK_PREPARE) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork zygote preparation");
+		}
 
-	log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork re-initialize");
+		/* Execute the real fork */
+		pid = metacall_fork_trampoline();
 
-	/* Initialize metacall again */
-	if (metacall_initialize() != 0)
-	{
-		log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto initialization");
+		if (loader_fork(pid == 0 ? LOADER_IMPL_FORK_CHILD : LOADER_IMPL_FORK_PARENT) != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork zygote restoration");
+		}
 	}
+	else
+	{
+		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork auto destroy");
+
+		/* Destroy metacall before the fork */
+		if (metacall_destroy() != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto destruction fail");
+		}
+
+		/* Execute the real fork */
+		pid = metacall_fork_trampoline();
+
+		log_write("metacall", LOG_LEVEL_DEBUG, "MetaCall process fork re-initialize");
 
-	/* Set again the callbacks in the new process */
-	metacall_fork(pre_callback, post_callback);
+		/* Initialize metacall again */
+		if (metacall_initialize() != 0)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "MetaCall fork auto initialization");
+		}
+
+		/* Set again the callbacks in the new process */
+		metacall_fork(pre_callback, post_callback);
+	}
 
 	/* Execute post fork callback */
 	if (post_callback != NULL)
@@ -353,6 +402,11 @@ void metacall_fork(metacall_pre_fork_callback_ptr pre_callback, metacall_post_fo
 	metacall_post_fork_callback = post_callback;
 }
 
+void metacall_fork_mode(enum metacall_fork_mode_id mode)
+{
+	metacall_fork_mode_current = mode;
+}
+
 int metacall_fork_destroy(void)
 {
 	int result = 0;
@@ -386,5 +440,7 @@ int metacall_fork_destroy(void)
 	metacall_pre_fork_callback = NULL;
 	metacall_post_fork_callback = NULL;
 
+	metacall_fork_mode_current = METACALL_FORK_MODE_RESTART;
+
 	return result;
 }
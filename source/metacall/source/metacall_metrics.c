@@ -0,0 +1,367 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <metacall/metacall_metrics.h>
+
+#include <loader/loader.h>
+
+#include <reflect/reflect_function.h>
+#include <reflect/reflect_value_type.h>
+
+#include <memory/memory_allocator.h>
+
+#include <log/log.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* -- Definitions -- */
+
+#define METACALL_METRICS_PROMETHEUS_CAPACITY 0x0400
+
+/* -- Forward Declarations -- */
+
+struct metacall_metrics_buffer_type;
+
+struct metacall_metrics_family_type;
+
+/* -- Type Definitions -- */
+
+typedef struct metacall_metrics_buffer_type *metacall_metrics_buffer;
+
+typedef const struct metacall_metrics_family_type *metacall_metrics_family;
+
+/* -- Member Data -- */
+
+struct metacall_metrics_buffer_type
+{
+	memory_allocator allocator;
+	char *data;
+	size_t length;
+	size_t capacity;
+	int error;
+};
+
+struct metacall_metrics_family_type
+{
+	const char *name;
+	const char *type;
+	const char *help;
+	const char *key; /* Key of the metrics map, null for the latency histogram */
+	int function;	 /* Zero for the loader totals, one for the function series */
+};
+
+/* -- Private Data -- */
+
+static const struct metacall_metrics_family_type metacall_metrics_families[] = {
+	{ "metacall_loader_calls_total", "counter", "Number of calls to the functions of a loader.", "calls", 0 },
+	{ "metacall_loader_errors_total", "counter", "Number of calls to the functions of a loader which returned an exception.", "errors", 0 },
+	{ "metacall_loader_calls_in_flight", "gauge", "Number of calls to the functions of a loader not finished yet.", "in_flight", 0 },
+	{ "metacall_loader_call_duration_seconds", "histogram", "Latency of the calls to the functions of a loader.", NULL, 0 },
+	{ "metacall_function_calls_total", "counter", "Number of calls to a function.", "calls", 1 },
+	{ "metacall_function_errors_total", "counter", "Number of calls to a function which returned an exception.", "errors", 1 },
+	{ "metacall_function_calls_in_flight", "gauge", "Number of calls to a function not finished yet.", "in_flight", 1 },
+	{ "metacall_function_call_duration_seconds", "histogram", "Latency of the calls to a function.", NULL, 1 }
+};
+
+/* -- Private Methods -- */
+
+static value metacall_metrics_get(value v, const char *key);
+
+static void metacall_metrics_printf(metacall_metrics_buffer buffer, const char *format, ...);
+
+static void metacall_metrics_labels(metacall_metrics_buffer buffer, const char *tag, const char *name, const char *le);
+
+static void metacall_metrics_series(metacall_metrics_buffer buffer, metacall_metrics_family family, const char *tag, const char *name, value m);
+
+/* -- Methods -- */
+
+value metacall_metrics_get(value v, const char *key)
+{
+	size_t iterator, size;
+	value *v_map;
+
+	if (v == NULL || type_id_map(value_type_id(v)) != 0)
+	{
+		return NULL;
+	}
+
+	size = value_type_count(v);
+	v_map = value_to_map(v);
+
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		value *tuple = value_to_array(v_map[iterator]);
+
+		if (strcmp(value_to_string(tuple[0]), key) == 0)
+		{
+			return tuple[1];
+		}
+	}
+
+	return NULL;
+}
+
+void metacall_metrics_printf(metacall_metrics_buffer buffer, const char *format, ...)
+{
+	va_list args;
+	int length;
+
+	if (buffer->error != 0)
+	{
+		return;
+	}
+
+	va_start(args, format);
+	length = vsnprintf(&buffer->data[buffer->length], buffer->capacity - buffer->length, format, args);
+	va_end(args);
+
+	if (length < 0)
+	{
+		buffer->error = 1;
+		return;
+	}
+
+	if (buffer->length + (size_t)length >= buffer->capacity)
+	{
+		size_t capacity = buffer->capacity;
+		char *data;
+
+		while (buffer->length + (size_t)length >= capacity)
+		{
+			capacity <<= 1;
+		}
+
+		data = memory_allocator_reallocate(buffer->allocator, buffer->data, buffer->capacity, capacity);
+
+		if (data == NULL)
+		{
+			buffer->error = 1;
+			return;
+		}
+
+		buffer->data = data;
+		buffer->capacity = capacity;
+
+		va_start(args, format);
+		length = vsnprintf(&buffer->data[buffer->length], buffer->capacity - buffer->length, format, args);
+		va_end(args);
+	}
+
+	buffer->length += (size_t)length;
+}
+
+void metacall_metrics_labels(metacall_metrics_buffer buffer, const char *tag, const char *name, const char *le)
+{
+	const char *labels[] = { "loader", "function", "le" };
+	const char *values[] = { tag, name, le };
+	size_t iterator;
+	int first = 1;
+
+	metacall_metrics_printf(buffer, "{");
+
+	for (iterator = 0; iterator < sizeof(labels) / sizeof(labels[0]); ++iterator)
+	{
+		const char *str = values[iterator];
+
+		if (str == NULL)
+		{
+			continue;
+		}
+
+		metacall_metrics_printf(buffer, "%s%s=\"", first ? "" : ",", labels[iterator]);
+
+		first = 0;
+
+		/* Escape the label value as required by the exposition format */
+		for (; *str != '\0'; ++str)
+		{
+			if (*str == '\\')
+			{
+				metacall_metrics_printf(buffer, "\\\\");
+			}
+			else if (*str == '"')
+			{
+				metacall_metrics_printf(buffer, "\\\"");
+			}
+			else if (*str == '\n')
+			{
+				metacall_metrics_printf(buffer, "\\n");
+			}
+			else
+			{
+				metacall_metrics_printf(buffer, "%c", *str);
+			}
+		}
+
+		metacall_metrics_printf(buffer, "\"");
+	}
+
+	metacall_metrics_printf(buffer, "}");
+}
+
+void metacall_metrics_series(metacall_metrics_buffer buffer, metacall_metrics_family family, const char *tag, const char *name, value m)
+{
+	value histogram;
+	size_t iterator, size;
+	unsigned long count = 0;
+	char le[0x40];
+
+	if (family->key != NULL)
+	{
+		value v = metacall_metrics_get(m, family->key);
+
+		metacall_metrics_printf(buffer, "%s", family->name);
+		metacall_metrics_labels(buffer, tag, name, NULL);
+		metacall_metrics_printf(buffer, " %lu\n", v != NULL ? (unsigned long)value_to_long(v) : 0UL);
+
+		return;
+	}
+
+	histogram = metacall_metrics_get(m, "histogram");
+	size = histogram != NULL ? value_type_count(histogram) : 0;
+
+	/* Buckets are cumulative and their upper bound is inclusive, as the histogram ones */
+	for (iterator = 0; iterator < size; ++iterator)
+	{
+		value *bucket = value_to_array(value_to_array(histogram)[iterator]);
+
+		count += (unsigned long)value_to_long(bucket[1]);
+
+		snprintf(le, sizeof(le), "%.9g", (double)value_to_long(bucket[0]) / 1e9);
+
+		metacall_metrics_printf(buffer, "%s_bucket", family->name);
+		metacall_metrics_labels(buffer, tag, name, le);
+		metacall_metrics_printf(buffer, " %lu\n", count);
+	}
+
+	metacall_metrics_printf(buffer, "%s_bucket", family->name);
+	metacall_metrics_labels(buffer, tag, name, "+Inf");
+	metacall_metrics_printf(buffer, " %lu\n", count);
+
+	metacall_metrics_printf(buffer, "%s_sum", family->name);
+	metacall_metrics_labels(buffer, tag, name, NULL);
+	metacall_metrics_printf(buffer, " %.9f\n", (double)value_to_long(metacall_metrics_get(m, "total_ns")) / 1e9);
+
+	metacall_metrics_printf(buffer, "%s_count", family->name);
+	metacall_metrics_labels(buffer, tag, name, NULL);
+	metacall_metrics_printf(buffer, " %lu\n", count);
+}
+
+void metacall_metrics_enable(int enable)
+{
+	function_metrics_enable(enable);
+}
+
+int metacall_metrics_enabled(void)
+{
+	return function_metrics_enabled();
+}
+
+void *metacall_metrics(void)
+{
+	return loader_metrics();
+}
+
+char *metacall_metrics_prometheus(size_t *size, void *allocator)
+{
+	struct metacall_metrics_buffer_type buffer;
+	size_t family, loader, function;
+	value v;
+	value *loaders;
+
+	if (size == NULL || allocator == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid MetaCall metrics Prometheus parameters");
+		return NULL;
+	}
+
+	v = loader_metrics();
+
+	if (v == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid MetaCall metrics map creation");
+		return NULL;
+	}
+
+	buffer.allocator = (memory_allocator)allocator;
+	buffer.length = 0;
+	buffer.capacity = METACALL_METRICS_PROMETHEUS_CAPACITY;
+	buffer.error = 0;
+	buffer.data = memory_allocator_allocate(buffer.allocator, buffer.capacity);
+
+	if (buffer.data == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid MetaCall metrics Prometheus buffer allocation");
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	buffer.data[0] = '\0';
+
+	loaders = value_to_map(v);
+
+	/* Samples of the same metric must be grouped, so iterate the loaders once per metric */
+	for (family = 0; family < sizeof(metacall_metrics_families) / sizeof(metacall_metrics_families[0]); ++family)
+	{
+		metacall_metrics_family f = &metacall_metrics_families[family];
+
+		metacall_metrics_printf(&buffer, "# HELP %s %s\n# TYPE %s %s\n", f->name, f->help, f->name, f->type);
+
+		for (loader = 0; loader < value_type_count(v); ++loader)
+		{
+			value *tuple = value_to_array(loaders[loader]);
+			const char *tag = value_to_string(tuple[0]);
+
+			if (f->function == 0)
+			{
+				metacall_metrics_series(&buffer, f, tag, NULL, metacall_metrics_get(tuple[1], "total"));
+			}
+			else
+			{
+				value functions = metacall_metrics_get(tuple[1], "functions");
+				value *functions_map = value_to_map(functions);
+
+				for (function = 0; function < value_type_count(functions); ++function)
+				{
+					value *function_tuple = value_to_array(functions_map[function]);
+
+					metacall_metrics_series(&buffer, f, tag, value_to_string(function_tuple[0]), function_tuple[1]);
+				}
+			}
+		}
+	}
+
+	value_type_destroy(v);
+
+	if (buffer.error != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid MetaCall metrics Prometheus serialization");
+		memory_allocator_deallocate(buffer.allocator, buffer.data);
+		return NULL;
+	}
+
+	*size = buffer.length + 1;
+
+	return buffer.data;
+}
@@ -0,0 +1,682 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_queue.h>
+
+#include <threading/threading_mutex.h>
+
+#include <log/log.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#if (defined(linux) || defined(__linux) || defined(__linux__) || defined(__gnu_linux) || defined(__gnu_linux__) || defined(__TOS_LINUX__))
+	#define METACALL_QUEUE_EVENTFD 1
+	#include <sys/eventfd.h>
+#endif
+
+#if defined(unix) || defined(__unix__) || defined(__unix) || \
+	defined(linux) || defined(__linux__) || defined(__linux) || defined(__gnu_linux) || \
+	defined(__CYGWIN__) || defined(__CYGWIN32__) || \
+	(defined(__APPLE__) && defined(__MACH__)) || defined(__MACOSX__)
+	#define METACALL_QUEUE_SUPPORTED 1
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+/* -- Definitions -- */
+
+#define METACALL_QUEUE_CAPACITY 0x40
+
+/* -- Forward Declarations -- */
+
+struct metacall_queue_type;
+
+struct metacall_queue_submission_type;
+
+/* -- Type Definitions -- */
+
+typedef struct metacall_queue_type *metacall_queue;
+
+typedef struct metacall_queue_submission_type *metacall_queue_submission;
+
+/* -- Member Data -- */
+
+struct metacall_queue_type
+{
+	struct threading_mutex_type mutex;		 /**< Protects all the fields of the queue and its submissions */
+	struct metacall_completion_type *buffer; /**< Ring buffer of completions */
+	size_t capacity;						 /**< Number of elements allocated in the ring buffer */
+	size_t head;							 /**< Position of the oldest completion */
+	size_t size;							 /**< Number of completions ready to be reaped */
+	size_t pending;							 /**< Number of submitted calls not completed yet */
+	size_t ref;								 /**< Owner reference plus one reference per alive submission */
+	metacall_queue_submission deferred;		 /**< First synchronous call waiting to be executed by the reaper */
+	metacall_queue_submission deferred_tail; /**< Last synchronous call waiting to be executed by the reaper */
+	int closed;								 /**< The owner destroyed the queue, results are discarded */
+	int signaled;							 /**< The notification file descriptor is readable */
+	int fd[2];								 /**< Read and write ends of the notification (same descriptor with eventfd) */
+};
+
+struct metacall_queue_submission_type
+{
+	metacall_queue q;				/**< Queue where the completion is posted */
+	void *tag;						/**< User defined pointer returned with the completion */
+	int completed;					/**< The completion has been already posted */
+	size_t ref;						/**< Submitter reference plus runtime callbacks reference */
+	void *func;						/**< Synchronous function deferred until the queue is reaped */
+	void **args;					/**< Copy of the arguments of the deferred call */
+	size_t size;					/**< Number of arguments of the deferred call */
+	metacall_queue_submission next; /**< Next deferred call in submission order */
+};
+
+/* -- Private Methods -- */
+
+static void metacall_queue_free(metacall_queue q);
+
+static int metacall_queue_grow(metacall_queue q);
+
+static void metacall_queue_signal(metacall_queue q);
+
+static void metacall_queue_post(metacall_queue q, void *tag, void *result, enum metacall_completion_id id);
+
+static void metacall_queue_submission_args_destroy(metacall_queue_submission s);
+
+static int metacall_queue_submission_release(metacall_queue_submission s);
+
+static void metacall_queue_complete(metacall_queue_submission s, void *result, enum metacall_completion_id id);
+
+static void *metacall_queue_resolve(void *result, void *data);
+
+static void *metacall_queue_reject(void *result, void *data);
+
+static void metacall_queue_run(metacall_queue q);
+
+/* -- Methods -- */
+
+void metacall_queue_free(metacall_queue q)
+{
+	size_t iterator;
+
+	for (iterator = 0; iterator < q->size; ++iterator)
+	{
+		struct metacall_completion_type *completion = &q->buffer[(q->head + iterator) % q->capacity];
+
+		if (completion->result != NULL)
+		{
+			metacall_value_destroy(completion->result);
+		}
+	}
+
+#if defined(METACALL_QUEUE_SUPPORTED)
+	close(q->fd[0]);
+
+	if (q->fd[1] != q->fd[0])
+	{
+		close(q->fd[1]);
+	}
+#endif
+
+	threading_mutex_destroy(&q->mutex);
+
+	free(q->buffer);
+	free(q);
+}
+
+int metacall_queue_grow(metacall_queue q)
+{
+	size_t capacity = q->capacity << 1;
+	struct metacall_completion_type *buffer = realloc(q->buffer, sizeof(struct metacall_completion_type) * capacity);
+
+	if (buffer == NULL)
+	{
+		return 1;
+	}
+
+	/* Unwrap the ring, the wrapped part is moved after the old end (it always fits because the capacity is doubled) */
+	if (q->head + q->size > q->capacity)
+	{
+		size_t wrapped = q->head + q->size - q->capacity;
+		size_t iterator;
+
+		for (iterator = 0; iterator < wrapped; ++iterator)
+		{
+			buffer[q->capacity + iterator] = buffer[iterator];
+		}
+	}
+
+	q->buffer = buffer;
+	q->capacity = capacity;
+
+	return 0;
+}
+
+void metacall_queue_post(metacall_queue q, void *tag, void *result, enum metacall_completion_id id)
+{
+	struct metacall_completion_type *completion;
+
+	if (q->closed == 1)
+	{
+		if (result != NULL)
+		{
+			metacall_value_destroy(result);
+		}
+
+		return;
+	}
+
+	if (q->size == q->capacity && metacall_queue_grow(q) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue allocation, the completion of tag %p has been lost", tag);
+
+		if (result != NULL)
+		{
+			metacall_value_destroy(result);
+		}
+
+		return;
+	}
+
+	completion = &q->buffer[(q->head + q->size) % q->capacity];
+
+	completion->tag = tag;
+	completion->result = result;
+	completion->id = id;
+
+	++q->size;
+
+	metacall_queue_signal(q);
+}
+
+void metacall_queue_signal(metacall_queue q)
+{
+#if defined(METACALL_QUEUE_SUPPORTED)
+	if (q->signaled == 0)
+	{
+	#if defined(METACALL_QUEUE_EVENTFD)
+		uint64_t event = 1;
+	#else
+		unsigned char event = 1;
+	#endif
+
+		if (write(q->fd[1], &event, sizeof(event)) == (ssize_t)sizeof(event))
+		{
+			q->signaled = 1;
+		}
+	}
+#else
+	(void)q;
+#endif
+}
+
+void metacall_queue_submission_args_destroy(metacall_queue_submission s)
+{
+	size_t iterator;
+
+	for (iterator = 0; iterator < s->size; ++iterator)
+	{
+		metacall_value_destroy(s->args[iterator]);
+	}
+
+	free(s->args);
+
+	s->args = NULL;
+	s->size = 0;
+}
+
+int metacall_queue_submission_release(metacall_queue_submission s)
+{
+	metacall_queue q = s->q;
+
+	if (--s->ref > 0)
+	{
+		return 0;
+	}
+
+	free(s);
+
+	return --q->ref == 0;
+}
+
+void metacall_queue_complete(metacall_queue_submission s, void *result, enum metacall_completion_id id)
+{
+	metacall_queue q = s->q;
+	int release;
+
+	threading_mutex_lock(&q->mutex);
+
+	if (s->completed == 0)
+	{
+		s->completed = 1;
+		--q->pending;
+		metacall_queue_post(q, s->tag, result, id);
+	}
+	else if (result != NULL)
+	{
+		metacall_value_destroy(result);
+	}
+
+	release = metacall_queue_submission_release(s);
+
+	threading_mutex_unlock(&q->mutex);
+
+	if (release == 1)
+	{
+		metacall_queue_free(q);
+	}
+}
+
+void *metacall_queue_resolve(void *result, void *data)
+{
+	/* The result is owned by the runtime that settled the future */
+	metacall_queue_complete((metacall_queue_submission)data, result != NULL ? metacall_value_share(result) : NULL, METACALL_COMPLETION_RESOLVE);
+
+	return NULL;
+}
+
+void *metacall_queue_reject(void *result, void *data)
+{
+	metacall_queue_complete((metacall_queue_submission)data, result != NULL ? metacall_value_share(result) : NULL, METACALL_COMPLETION_REJECT);
+
+	return NULL;
+}
+
+void metacall_queue_run(metacall_queue q)
+{
+	metacall_queue_submission s;
+
+	/* Detach the deferred calls, so the functions can submit again into the queue while they are executed */
+	threading_mutex_lock(&q->mutex);
+	s = q->deferred;
+	q->deferred = q->deferred_tail = NULL;
+	threading_mutex_unlock(&q->mutex);
+
+	while (s != NULL)
+	{
+		metacall_queue_submission next = s->next;
+		void *result = metacallfv_s(s->func, s->args, s->size);
+		enum metacall_completion_id id = METACALL_COMPLETION_RESOLVE;
+
+		if (result == NULL)
+		{
+			id = METACALL_COMPLETION_ERROR;
+		}
+		else if (metacall_value_id(result) == METACALL_THROWABLE || metacall_value_id(result) == METACALL_EXCEPTION)
+		{
+			id = METACALL_COMPLETION_REJECT;
+		}
+
+		metacall_queue_submission_args_destroy(s);
+
+		/* The owner holds a reference while reaping, so the queue cannot be freed here */
+		metacall_queue_complete(s, result, id);
+
+		s = next;
+	}
+}
+
+void *metacall_queue_create(void)
+{
+#if defined(METACALL_QUEUE_SUPPORTED)
+	metacall_queue q = malloc(sizeof(struct metacall_queue_type));
+
+	if (q == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue allocation");
+		return NULL;
+	}
+
+	q->buffer = malloc(sizeof(struct metacall_completion_type) * METACALL_QUEUE_CAPACITY);
+
+	if (q->buffer == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue buffer allocation");
+		goto alloc_buffer_error;
+	}
+
+	#if defined(METACALL_QUEUE_EVENTFD)
+	q->fd[0] = q->fd[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+	if (q->fd[0] == -1)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue event file descriptor creation");
+		goto fd_error;
+	}
+	#else
+	if (pipe(q->fd) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue pipe creation");
+		goto fd_error;
+	}
+
+	fcntl(q->fd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(q->fd[1], F_SETFD, FD_CLOEXEC);
+	fcntl(q->fd[0], F_SETFL, fcntl(q->fd[0], F_GETFL) | O_NONBLOCK);
+	fcntl(q->fd[1], F_SETFL, fcntl(q->fd[1], F_GETFL) | O_NONBLOCK);
+	#endif
+
+	if (threading_mutex_initialize(&q->mutex) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue mutex initialization");
+		goto mutex_error;
+	}
+
+	q->capacity = METACALL_QUEUE_CAPACITY;
+	q->head = 0;
+	q->size = 0;
+	q->pending = 0;
+	q->ref = 1;
+	q->deferred = NULL;
+	q->deferred_tail = NULL;
+	q->closed = 0;
+	q->signaled = 0;
+
+	return q;
+
+mutex_error:
+	close(q->fd[0]);
+
+	if (q->fd[1] != q->fd[0])
+	{
+		close(q->fd[1]);
+	}
+fd_error:
+	free(q->buffer);
+alloc_buffer_error:
+	free(q);
+	return NULL;
+#else
+	log_write("metacall", LOG_LEVEL_ERROR, "Completion queue not supported in this platform");
+	return NULL;
+#endif
+}
+
+int metacall_queue_fd(void *q)
+{
+	if (q == NULL)
+	{
+		return -1;
+	}
+
+	return ((metacall_queue)q)->fd[0];
+}
+
+int metacall_queue_submit(void *q, void *func, void *args[], size_t size, void *tag)
+{
+	metacall_queue queue = (metacall_queue)q;
+	metacall_queue_submission s;
+	void *future;
+	int async, release;
+
+	if (queue == NULL || func == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue or function in metacall_queue_submit");
+		return 1;
+	}
+
+	s = malloc(sizeof(struct metacall_queue_submission_type));
+
+	if (s == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue submission allocation");
+		return 1;
+	}
+
+	async = metacall_function_async(func);
+
+	/* The callbacks hold their own reference because they may run in another thread after this call returns */
+	s->q = queue;
+	s->tag = tag;
+	s->completed = 0;
+	s->ref = async == 1 ? 2 : 1;
+	s->func = func;
+	s->args = NULL;
+	s->size = 0;
+	s->next = NULL;
+
+	if (async != 1 && size > 0)
+	{
+		/* Synchronous calls are executed later by the reaper, so the arguments are copied */
+		s->args = malloc(sizeof(void *) * size);
+
+		if (s->args == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue arguments allocation");
+			free(s);
+			return 1;
+		}
+
+		for (s->size = 0; s->size < size; ++s->size)
+		{
+			s->args[s->size] = metacall_value_copy(args[s->size]);
+
+			if (s->args[s->size] == NULL)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Invalid completion queue argument copy");
+				metacall_queue_submission_args_destroy(s);
+				free(s);
+				return 1;
+			}
+		}
+	}
+
+	threading_mutex_lock(&queue->mutex);
+	++queue->ref;
+	++queue->pending;
+
+	if (async != 1)
+	{
+		/* Synchronous calls are batched and run in submission order from metacall_queue_poll or metacall_queue_wait */
+		if (queue->deferred_tail == NULL)
+		{
+			queue->deferred = s;
+		}
+		else
+		{
+			queue->deferred_tail->next = s;
+		}
+
+		queue->deferred_tail = s;
+
+		metacall_queue_signal(queue);
+
+		threading_mutex_unlock(&queue->mutex);
+
+		return 0;
+	}
+
+	threading_mutex_unlock(&queue->mutex);
+
+	future = metacallfv_await_s(func, args, size, &metacall_queue_resolve, &metacall_queue_reject, s);
+
+	threading_mutex_lock(&queue->mutex);
+
+	if (future == NULL && s->completed == 0)
+	{
+		/* The await failed before the future was created, the callbacks will never be called so their reference is dropped too */
+		s->completed = 1;
+		--queue->pending;
+		--s->ref;
+		metacall_queue_post(queue, s->tag, NULL, METACALL_COMPLETION_ERROR);
+	}
+
+	release = metacall_queue_submission_release(s);
+
+	threading_mutex_unlock(&queue->mutex);
+
+	if (future != NULL)
+	{
+		metacall_value_destroy(future);
+	}
+
+	if (release == 1)
+	{
+		metacall_queue_free(queue);
+	}
+
+	return 0;
+}
+
+size_t metacall_queue_poll(void *q, struct metacall_completion_type completions[], size_t size)
+{
+	metacall_queue queue = (metacall_queue)q;
+	size_t count = 0;
+
+	if (queue == NULL || completions == NULL)
+	{
+		return 0;
+	}
+
+	metacall_queue_run(queue);
+
+	threading_mutex_lock(&queue->mutex);
+
+	while (count < size && queue->size > 0)
+	{
+		completions[count++] = queue->buffer[queue->head];
+		queue->head = (queue->head + 1) % queue->capacity;
+		--queue->size;
+	}
+
+	if (queue->size == 0)
+	{
+		queue->head = 0;
+	}
+
+	if (queue->size == 0 && queue->deferred == NULL)
+	{
+#if defined(METACALL_QUEUE_SUPPORTED)
+		/* Drain the notification so the descriptor is only readable while there are completions or deferred calls */
+		if (queue->signaled == 1)
+		{
+	#if defined(METACALL_QUEUE_EVENTFD)
+			uint64_t event;
+	#else
+			unsigned char event;
+	#endif
+
+			while (read(queue->fd[0], &event, sizeof(event)) > 0)
+				;
+
+			queue->signaled = 0;
+		}
+#endif
+	}
+
+	threading_mutex_unlock(&queue->mutex);
+
+	return count;
+}
+
+size_t metacall_queue_wait(void *q, struct metacall_completion_type completions[], size_t size, int timeout)
+{
+	size_t count = metacall_queue_poll(q, completions, size);
+
+#if defined(METACALL_QUEUE_SUPPORTED)
+	if (count == 0 && q != NULL && completions != NULL && size > 0)
+	{
+		struct pollfd fds;
+		int result;
+
+		fds.fd = ((metacall_queue)q)->fd[0];
+		fds.events = POLLIN;
+		fds.revents = 0;
+
+		do
+		{
+			result = poll(&fds, 1, timeout);
+		} while (result == -1 && errno == EINTR);
+
+		if (result > 0)
+		{
+			count = metacall_queue_poll(q, completions, size);
+		}
+	}
+#else
+	(void)timeout;
+#endif
+
+	return count;
+}
+
+size_t metacall_queue_pending(void *q)
+{
+	metacall_queue queue = (metacall_queue)q;
+	size_t pending;
+
+	if (queue == NULL)
+	{
+		return 0;
+	}
+
+	threading_mutex_lock(&queue->mutex);
+	pending = queue->pending;
+	threading_mutex_unlock(&queue->mutex);
+
+	return pending;
+}
+
+void metacall_queue_destroy(void *q)
+{
+	metacall_queue queue = (metacall_queue)q;
+	metacall_queue_submission s;
+	int release;
+
+	if (queue == NULL)
+	{
+		return;
+	}
+
+	threading_mutex_lock(&queue->mutex);
+
+	queue->closed = 1;
+
+	/* The deferred calls that have not been executed yet are discarded */
+	s = queue->deferred;
+	queue->deferred = queue->deferred_tail = NULL;
+
+	while (s != NULL)
+	{
+		metacall_queue_submission next = s->next;
+
+		metacall_queue_submission_args_destroy(s);
+
+		s->completed = 1;
+		--queue->pending;
+
+		metacall_queue_submission_release(s);
+
+		s = next;
+	}
+
+	release = --queue->ref == 0;
+
+	threading_mutex_unlock(&queue->mutex);
+
+	if (release == 1)
+	{
+		metacall_queue_free(queue);
+	}
+}
@@ -223,6 +223,11 @@ void *metacall_value_copy(void *v)
 	return value_type_copy(v);
 }
 
+void *metacall_value_share(void *v)
+{
+	return value_type_copy_on_write(v);
+}
+
 void *metacall_value_reference(void *v)
 {
 	return value_type_reference(v);
@@ -373,96 +378,134 @@ void *metacall_value_to_throwable(void *v)
 
 void *metacall_value_from_bool(void *v, boolean b)
 {
+	v = value_type_unshare(v);
+
 	return value_from_bool(v, b);
 }
 
 void *metacall_value_from_char(void *v, char c)
 {
+	v = value_type_unshare(v);
+
 	return value_from_char(v, c);
 }
 
 void *metacall_value_from_short(void *v, short s)
 {
+	v = value_type_unshare(v);
+
 	return value_from_short(v, s);
 }
 
 void *metacall_value_from_int(void *v, int i)
 {
+	v = value_type_unshare(v);
+
 	return value_from_int(v, i);
 }
 
 void *metacall_value_from_long(void *v, long l)
 {
+	v = value_type_unshare(v);
+
 	return value_from_long(v, l);
 }
 
 void *metacall_value_from_float(void *v, float f)
 {
+	v = value_type_unshare(v);
+
 	return value_from_float(v, f);
 }
 
 void *metacall_value_from_double(void *v, double d)
 {
+	v = value_type_unshare(v);
+
 	return value_from_double(v, d);
 }
 
 void *metacall_value_from_string(void *v, const char *str, size_t length)
 {
+	v = value_type_unshare(v);
+
 	return value_from_string(v, str, length);
 }
 
 void *metacall_value_from_buffer(void *v, const void *buffer, size_t size)
 {
+	v = value_type_unshare(v);
+
 	return value_from_buffer(v, buffer, size);
 }
 
 void *metacall_value_from_array(void *v, const void *values[], size_t size)
 {
+	v = value_type_unshare(v);
+
 	return value_from_array(v, (const value *)values, size);
 }
 
 void *metacall_value_from_map(void *v, const void *tuples[], size_t size)
 {
+	v = value_type_unshare(v);
+
 	return value_from_map(v, (const value *)tuples, size);
 }
 
 void *metacall_value_from_ptr(void *v, const void *ptr)
 {
+	v = value_type_unshare(v);
+
 	return value_from_ptr(v, ptr);
 }
 
 void *metacall_value_from_future(void *v, void *f)
 {
+	v = value_type_unshare(v);
+
 	return value_from_future(v, f);
 }
 
 void *metacall_value_from_function(void *v, void *f)
 {
+	v = value_type_unshare(v);
+
 	return value_from_function(v, f);
 }
 
 void *metacall_value_from_null(void *v)
 {
+	v = value_type_unshare(v);
+
 	return value_from_null(v);
 }
 
 void *metacall_value_from_class(void *v, void *c)
 {
+	v = value_type_unshare(v);
+
 	return value_from_class(v, c);
 }
 
 void *metacall_value_from_object(void *v, void *o)
 {
+	v = value_type_unshare(v);
+
 	return value_from_object(v, o);
 }
 
 void *metacall_value_from_exception(void *v, void *ex)
 {
+	v = value_type_unshare(v);
+
 	return value_from_exception(v, ex);
 }
 
 void *metacall_value_from_throwable(void *v, void *th)
 {
+	v = value_type_unshare(v);
+
 	return value_from_throwable(v, th);
 }
 
@@ -88,6 +88,8 @@ PLUGIN_API plugin plugin_manager_get(plugin_manager manager, const char *name);
 
 PLUGIN_API void plugin_manager_iterate(plugin_manager manager, int (*iterator)(plugin_manager, plugin, void *), void *data);
 
+PLUGIN_API int plugin_manager_unregister(plugin_manager manager, plugin p);
+
 PLUGIN_API int plugin_manager_clear(plugin_manager manager, plugin p);
 
 PLUGIN_API void plugin_manager_destroy(plugin_manager manager);
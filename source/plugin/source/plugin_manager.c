@@ -45,7 +45,6 @@ struct plugin_manager_iterate_cb_type
 
 /* -- Private Methods -- */
 
-static int plugin_manager_unregister(plugin_manager manager, plugin p);
 static int plugin_manager_iterate_cb(set s, set_key key, set_value val, set_cb_iterate_args args);
 static int plugin_manager_destroy_cb(set s, set_key key, set_value val, set_cb_iterate_args args);
 
@@ -0,0 +1,40 @@
+/*
+ *	Trace Plugin by Parra Studios
+ *	A plugin implementing call tracing functionality for MetaCall Core.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#ifndef TRACE_PLUGIN_H
+#define TRACE_PLUGIN_H 1
+
+#include <trace_plugin/trace_plugin_api.h>
+
+#include <dynlink/dynlink.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+TRACE_PLUGIN_API int trace_plugin(void *loader, void *handle);
+
+DYNLINK_SYMBOL_EXPORT(trace_plugin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_PLUGIN_H */
@@ -0,0 +1,635 @@
+/*
+ *	Trace Plugin by Parra Studios
+ *	A plugin implementing call tracing functionality for MetaCall Core.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <trace_plugin/trace_plugin.h>
+
+#include <plugin/plugin_interface.hpp>
+
+#include <reflect/reflect_function.h>
+#include <reflect/reflect_metrics.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#if defined(WIN32) || defined(_WIN32)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+
+	#include <windows.h>
+
+	#include <process.h>
+	#define trace_plugin_getpid _getpid
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+	#define trace_plugin_getpid getpid
+#endif
+
+/* Environment variables for starting the tracing when the plugin is loaded */
+#define TRACE_FILE_ENV		  "METACALL_TRACE_FILE"
+#define TRACE_SAMPLE_RATE_ENV "METACALL_TRACE_SAMPLE_RATE"
+
+/* Number of spans buffered per thread (it must be a power of two) and flush period of the buffers */
+#define TRACE_RING_SIZE		   0x0400
+#define TRACE_FLUSH_PERIOD_MS  100
+
+/* Error messages */
+#define TRACE_START_ERROR "Trace plugin failed to start the tracing"
+#define TRACE_STOP_ERROR  "Trace plugin failed to stop the tracing"
+#define TRACE_FLUSH_ERROR "Trace plugin failed to flush the tracing"
+
+struct trace_event
+{
+	const char *name;
+	uint64_t id;
+	uint64_t parent;
+	uint64_t start;
+	uint64_t end;
+	uint64_t thread;
+	int async;
+	int error;
+};
+
+/* Single producer (the owner thread) single consumer (the flush) ring of finished spans */
+struct trace_ring
+{
+	std::atomic<uint64_t> head{ 0 };
+	std::atomic<uint64_t> tail{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<bool> exited{ false }; /* The owner thread has finished, the ring can be deleted once it is drained */
+	std::atomic<int> *writing = nullptr;
+	trace_ring *next = nullptr;
+	trace_event events[TRACE_RING_SIZE];
+};
+
+/* The plugin can be unloaded before the threads finish, so the thread local state must not have a destructor,
+* the rings of the finished threads are released through a thread specific key which is deleted on unload */
+struct trace_thread
+{
+	uint64_t id = 0;
+	uint64_t counter = 0;
+	uint64_t seed = 0;
+	trace_ring *ring = nullptr;
+	function_trace_span current = nullptr;
+	std::atomic<int> writing{ 0 }; /* The thread is writing into its ring */
+};
+
+static_assert(std::is_trivially_destructible<trace_thread>::value, "Trace thread state must be trivially destructible");
+
+#if defined(WIN32) || defined(_WIN32)
+typedef DWORD trace_key;
+#else
+typedef pthread_key_t trace_key;
+#endif
+
+struct trace_state
+{
+	std::mutex mutex; /* Protects the file and the consumer side of the rings */
+	std::condition_variable cv;
+	std::thread flusher;
+	std::FILE *file = nullptr;
+	bool active = false;
+	bool first = true;
+	int pid = 0;
+	trace_key key;
+	bool key_valid = false;
+
+	trace_state();
+	~trace_state();
+};
+
+static std::atomic<trace_ring *> trace_rings{ nullptr };
+static std::atomic<uint64_t> trace_threads{ 0 };
+static std::atomic<uint64_t> trace_threshold{ UINT64_MAX };
+static std::atomic<bool> trace_loaded{ true };
+static thread_local trace_thread trace_current;
+static trace_state trace;
+
+static void trace_thread_exit(void *data)
+{
+	trace_ring *ring = static_cast<trace_ring *>(data);
+
+	/* The flusher deletes the ring once it is drained */
+	if (ring != nullptr)
+	{
+		ring->exited.store(true, std::memory_order_release);
+	}
+}
+
+#if defined(WIN32) || defined(_WIN32)
+static VOID NTAPI trace_thread_exit_fls(PVOID data)
+{
+	trace_thread_exit(data);
+}
+#endif
+
+static void trace_key_set(trace_ring *ring)
+{
+	if (!trace.key_valid)
+	{
+		return;
+	}
+
+#if defined(WIN32) || defined(_WIN32)
+	FlsSetValue(trace.key, ring);
+#else
+	pthread_setspecific(trace.key, ring);
+#endif
+}
+
+static trace_thread &trace_thread_get()
+{
+	trace_thread &t = trace_current;
+
+	if (t.id == 0)
+	{
+		t.id = trace_threads.fetch_add(1, std::memory_order_relaxed) + 1;
+		t.seed = (t.id * 0x9E3779B97F4A7C15ULL) ^ metrics_time();
+	}
+
+	return t;
+}
+
+static bool trace_sample(trace_thread &t)
+{
+	uint64_t threshold = trace_threshold.load(std::memory_order_relaxed);
+
+	if (threshold == UINT64_MAX)
+	{
+		return true;
+	}
+
+	/* xorshift64* is enough for sampling and keeps the decision in a few cycles */
+	t.seed ^= t.seed >> 12;
+	t.seed ^= t.seed << 25;
+	t.seed ^= t.seed >> 27;
+
+	return t.seed * 0x2545F4914F6CDD1DULL < threshold;
+}
+
+static void trace_begin(function func, function_trace_span span)
+{
+	trace_thread &t = trace_thread_get();
+	function_trace_span parent = t.current;
+
+	(void)func;
+
+	span->previous = parent;
+	span->thread = t.id;
+
+	/* The sampling is decided at the root span and inherited by all its children */
+	if (parent != nullptr ? parent->id != 0 : trace_sample(t))
+	{
+		span->id = (t.id << 32) | ++t.counter;
+		span->parent = parent != nullptr ? parent->id : 0;
+		span->start = metrics_time();
+	}
+	else
+	{
+		span->id = 0;
+	}
+
+	t.current = span;
+}
+
+static function_trace_span trace_swap(function_trace_span span)
+{
+	trace_thread &t = trace_current;
+	function_trace_span previous = t.current;
+
+	t.current = span;
+
+	return previous;
+}
+
+static void trace_end(function func, function_trace_span span, int error)
+{
+	if (span->id == 0)
+	{
+		return;
+	}
+
+	trace_thread &t = trace_thread_get();
+
+	/* Announce the write before checking if the plugin is being unloaded, so either the unload waits for it or it sees the unload */
+	t.writing.store(1, std::memory_order_seq_cst);
+
+	if (!trace_loaded.load(std::memory_order_seq_cst))
+	{
+		t.writing.store(0, std::memory_order_release);
+		return;
+	}
+
+	if (t.ring == nullptr)
+	{
+		t.ring = new trace_ring();
+		t.ring->writing = &t.writing;
+
+		trace_key_set(t.ring);
+
+		/* Rings are only pushed by the producers and only removed by the consumer, so they can be pushed without locking */
+		t.ring->next = trace_rings.load(std::memory_order_relaxed);
+
+		while (!trace_rings.compare_exchange_weak(t.ring->next, t.ring, std::memory_order_release, std::memory_order_relaxed))
+			;
+	}
+
+	trace_ring *ring = t.ring;
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+
+	if (head - ring->tail.load(std::memory_order_acquire) >= TRACE_RING_SIZE)
+	{
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		t.writing.store(0, std::memory_order_release);
+		return;
+	}
+
+	trace_event &event = ring->events[head & (TRACE_RING_SIZE - 1)];
+
+	event.name = function_name(func);
+	event.id = span->id;
+	event.parent = span->parent;
+	event.start = span->start;
+	event.end = metrics_time();
+	event.thread = span->thread;
+	event.async = span->async;
+	event.error = error;
+
+	ring->head.store(head + 1, std::memory_order_release);
+
+	t.writing.store(0, std::memory_order_release);
+}
+
+static struct function_trace_interface_type trace_interface = {
+	&trace_begin,
+	&trace_swap,
+	&trace_end
+};
+
+static void trace_write_name(std::FILE *file, const char *name)
+{
+	if (name == nullptr)
+	{
+		name = "<anonymous>";
+	}
+
+	for (; *name != '\0'; ++name)
+	{
+		if (*name == '"' || *name == '\\')
+		{
+			std::fputc('\\', file);
+		}
+
+		std::fputc(*name, file);
+	}
+}
+
+static void trace_write_event(const trace_event &event)
+{
+	std::FILE *file = trace.file;
+
+	/* Synchronous calls nest inside their thread, awaits are async events because they overlap with other calls */
+	const char *phases[] = { "X", "b", "e" };
+	size_t phases_size = event.async ? 2 : 1;
+
+	for (size_t iterator = 0; iterator < phases_size; ++iterator)
+	{
+		const char *phase = event.async ? phases[iterator + 1] : phases[0];
+		double ts = (double)(iterator == 0 ? event.start : event.end) / 1000.0;
+
+		std::fprintf(file, "%s{\"name\":\"", trace.first ? "" : ",\n");
+		trace_write_name(file, event.name);
+		std::fprintf(file, "\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,", event.async ? "await" : "call", phase, ts);
+
+		if (event.async)
+		{
+			std::fprintf(file, "\"id\":\"0x%llx\",", (unsigned long long)event.id);
+		}
+		else
+		{
+			std::fprintf(file, "\"dur\":%.3f,", (double)(event.end - event.start) / 1000.0);
+		}
+
+		std::fprintf(file, "\"pid\":%d,\"tid\":%llu,\"args\":{\"span\":%llu,\"parent\":%llu,\"error\":%d}}",
+			trace.pid, (unsigned long long)event.thread, (unsigned long long)event.id, (unsigned long long)event.parent, event.error);
+
+		trace.first = false;
+	}
+}
+
+/* It must be called with the state mutex locked */
+static void trace_ring_unlink(trace_ring *&previous, trace_ring *ring)
+{
+	if (previous == nullptr)
+	{
+		trace_ring *head = ring;
+
+		if (trace_rings.compare_exchange_strong(head, ring->next, std::memory_order_acq_rel, std::memory_order_acquire))
+		{
+			return;
+		}
+
+		/* Other threads have pushed their rings in front of this one meanwhile */
+		for (previous = head; previous->next != ring; previous = previous->next)
+			;
+	}
+
+	previous->next = ring->next;
+}
+
+/* It must be called with the state mutex locked, the rings of the threads which have finished are deleted once they are drained */
+static void trace_reclaim_rings()
+{
+	trace_ring *previous = nullptr;
+
+	for (trace_ring *ring = trace_rings.load(std::memory_order_acquire); ring != nullptr;)
+	{
+		trace_ring *next = ring->next;
+
+		if (ring->exited.load(std::memory_order_acquire) &&
+			(trace.file == nullptr || ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire)))
+		{
+			trace_ring_unlink(previous, ring);
+
+			delete ring;
+		}
+		else
+		{
+			previous = ring;
+		}
+
+		ring = next;
+	}
+}
+
+/* It must be called with the state mutex locked */
+static void trace_flush_rings()
+{
+	if (trace.file == nullptr)
+	{
+		return;
+	}
+
+	for (trace_ring *ring = trace_rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+	{
+		uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+
+		for (; tail != head; ++tail)
+		{
+			trace_write_event(ring->events[tail & (TRACE_RING_SIZE - 1)]);
+		}
+
+		ring->tail.store(tail, std::memory_order_release);
+	}
+
+	std::fflush(trace.file);
+}
+
+static void trace_flusher()
+{
+	std::unique_lock<std::mutex> lock(trace.mutex);
+
+	while (trace.active)
+	{
+		trace.cv.wait_for(lock, std::chrono::milliseconds(TRACE_FLUSH_PERIOD_MS));
+
+		trace_flush_rings();
+		trace_reclaim_rings();
+	}
+}
+
+static int trace_plugin_start(const char *path, double rate)
+{
+	std::unique_lock<std::mutex> lock(trace.mutex);
+
+	if (trace.active)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, TRACE_START_ERROR ", the tracing is already started");
+		return 1;
+	}
+
+	trace.file = std::fopen(path, "w");
+
+	if (trace.file == nullptr)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, TRACE_START_ERROR ", the file %s could not be opened", path);
+		return 1;
+	}
+
+	/* Spans buffered from a previous session belong to the previous file */
+	for (trace_ring *ring = trace_rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+	{
+		ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+		ring->dropped.store(0, std::memory_order_relaxed);
+	}
+
+	if (rate >= 1.0)
+	{
+		trace_threshold.store(UINT64_MAX, std::memory_order_relaxed);
+	}
+	else if (rate <= 0.0)
+	{
+		trace_threshold.store(0, std::memory_order_relaxed);
+	}
+	else
+	{
+		trace_threshold.store((uint64_t)(rate * 18446744073709551615.0), std::memory_order_relaxed);
+	}
+
+	/* Chrome trace-event JSON array format, which is also supported by Perfetto */
+	std::fputs("[\n", trace.file);
+
+	trace.pid = (int)trace_plugin_getpid();
+	trace.first = true;
+	trace.active = true;
+	trace.flusher = std::thread(&trace_flusher);
+
+	function_trace(&trace_interface);
+
+	return 0;
+}
+
+static int trace_plugin_stop()
+{
+	std::unique_lock<std::mutex> lock(trace.mutex);
+
+	if (!trace.active)
+	{
+		return 1;
+	}
+
+	function_trace(NULL);
+
+	trace.active = false;
+	trace.cv.notify_all();
+
+	lock.unlock();
+	trace.flusher.join();
+	lock.lock();
+
+	trace_flush_rings();
+
+	uint64_t dropped = 0;
+
+	for (trace_ring *ring = trace_rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+	{
+		dropped += ring->dropped.load(std::memory_order_relaxed);
+	}
+
+	if (dropped != 0)
+	{
+		log_write("metacall", LOG_LEVEL_WARNING, "Trace plugin dropped %llu spans because the buffers were full", (unsigned long long)dropped);
+	}
+
+	std::fprintf(trace.file, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"metacall\"}}\n]\n", trace.first ? "" : ",\n", trace.pid);
+	std::fclose(trace.file);
+
+	trace.file = nullptr;
+
+	trace_reclaim_rings();
+
+	return 0;
+}
+
+trace_state::trace_state()
+{
+#if defined(WIN32) || defined(_WIN32)
+	key = FlsAlloc(&trace_thread_exit_fls);
+	key_valid = (key != FLS_OUT_OF_INDEXES);
+#else
+	key_valid = (pthread_key_create(&key, &trace_thread_exit) == 0);
+#endif
+}
+
+trace_state::~trace_state()
+{
+	/* The plugin can be unloaded while tracing, so remove the hooks before the code is unmapped */
+	trace_plugin_stop();
+
+	/* Spans which were open before removing the hooks may still end, they are discarded from now on */
+	trace_loaded.store(false, std::memory_order_seq_cst);
+
+	/* Wait for the threads in the middle of a write, the ones which have finished do not write anymore */
+	for (trace_ring *ring = trace_rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+	{
+		while (!ring->exited.load(std::memory_order_acquire) && ring->writing->load(std::memory_order_seq_cst) != 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	/* No thread exit callback must run once the code of the plugin is unmapped */
+	if (key_valid)
+	{
+#if defined(WIN32) || defined(_WIN32)
+		FlsFree(key);
+#else
+		pthread_key_delete(key);
+#endif
+		key_valid = false;
+	}
+
+	for (trace_ring *ring = trace_rings.exchange(nullptr); ring != nullptr;)
+	{
+		trace_ring *next = ring->next;
+
+		delete ring;
+
+		ring = next;
+	}
+}
+
+void *trace_start(size_t argc, void *args[], void *data)
+{
+	/* Validate function parameters */
+	EXTENSION_FUNCTION_CHECK(TRACE_START_ERROR, METACALL_STRING, METACALL_DOUBLE);
+
+	if (trace_plugin_start(metacall_value_to_string(args[0]), metacall_value_to_double(args[1])) != 0)
+	{
+		EXTENSION_FUNCTION_THROW(TRACE_START_ERROR);
+	}
+
+	return metacall_value_create_int(0);
+}
+
+void *trace_stop(size_t argc, void *args[], void *data)
+{
+	/* Validate function parameters */
+	EXTENSION_FUNCTION_CHECK(TRACE_STOP_ERROR);
+
+	if (trace_plugin_stop() != 0)
+	{
+		EXTENSION_FUNCTION_THROW(TRACE_STOP_ERROR);
+	}
+
+	return metacall_value_create_int(0);
+}
+
+void *trace_flush(size_t argc, void *args[], void *data)
+{
+	/* Validate function parameters */
+	EXTENSION_FUNCTION_CHECK(TRACE_FLUSH_ERROR);
+
+	std::unique_lock<std::mutex> lock(trace.mutex);
+
+	if (!trace.active)
+	{
+		EXTENSION_FUNCTION_THROW(TRACE_FLUSH_ERROR);
+	}
+
+	trace_flush_rings();
+	trace_reclaim_rings();
+
+	return metacall_value_create_int(0);
+}
+
+int trace_plugin(void *loader, void *handle)
+{
+	EXTENSION_FUNCTION(METACALL_INT, trace_start, METACALL_STRING, METACALL_DOUBLE);
+	EXTENSION_FUNCTION(METACALL_INT, trace_stop);
+	EXTENSION_FUNCTION(METACALL_INT, trace_flush);
+
+	const char *path = std::getenv(TRACE_FILE_ENV);
+
+	if (path != NULL)
+	{
+		const char *rate = std::getenv(TRACE_SAMPLE_RATE_ENV);
+
+		if (trace_plugin_start(path, rate != NULL ? std::atof(rate) : 1.0) != 0)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -26,9 +26,169 @@
 #include <metacall/metacall_api.hpp>
 
 #include <string>
+#include <type_traits>
+#include <vector>
+
+/* The C API is declared in the global scope, but its variadic function named
+* metacall cannot coexist with this namespace, so it is renamed while the header
+* is included and it is not available from C++, metacall::metacall replaces it
+*/
+#if defined(METACALL_H)
+	#error "Include metacall/metacall.hpp instead of metacall/metacall.h when using the C++ port"
+#endif
+
+#define metacall metacall_variadic
+#include <metacall/metacall.h>
+#undef metacall
 
 namespace metacall
 {
+
+/* -- Type Traits -- */
+
+/**
+*  @brief
+*    Compile time mapping between a C++ type and a MetaCall value, it defines
+*    the value id, how to create a value from the type and how to convert it back,
+*    unsupported types do not have a specialization and fail at compile time,
+*    strings and buffers are taken by reference and not moved because the C API
+*    always copies them into the value
+*/
+template <typename T>
+struct value_traits;
+
+template <typename T>
+using value_traits_of = value_traits<typename std::decay<T>::type>;
+
+#define METACALL_CXX_VALUE_TRAITS_SCALAR(TYPE, ID, NAME) \
+	template <> \
+	struct value_traits<TYPE> \
+	{ \
+		static constexpr enum metacall_value_id id = ID; \
+		static void *create(TYPE v) \
+		{ \
+			return ::metacall_value_create_##NAME(v); \
+		} \
+		static TYPE to(void **v) \
+		{ \
+			return ::metacall_value_cast_##NAME(v); \
+		} \
+	}
+
+template <>
+struct value_traits<bool>
+{
+	static constexpr enum metacall_value_id id = METACALL_BOOL;
+
+	static void *create(bool v)
+	{
+		return ::metacall_value_create_bool(static_cast<boolean>(v ? 1 : 0));
+	}
+
+	static bool to(void **v)
+	{
+		return ::metacall_value_cast_bool(v) != 0;
+	}
+};
+
+METACALL_CXX_VALUE_TRAITS_SCALAR(char, METACALL_CHAR, char);
+METACALL_CXX_VALUE_TRAITS_SCALAR(short, METACALL_SHORT, short);
+METACALL_CXX_VALUE_TRAITS_SCALAR(int, METACALL_INT, int);
+METACALL_CXX_VALUE_TRAITS_SCALAR(long, METACALL_LONG, long);
+METACALL_CXX_VALUE_TRAITS_SCALAR(float, METACALL_FLOAT, float);
+METACALL_CXX_VALUE_TRAITS_SCALAR(double, METACALL_DOUBLE, double);
+
+#undef METACALL_CXX_VALUE_TRAITS_SCALAR
+
+template <>
+struct value_traits<std::string>
+{
+	static constexpr enum metacall_value_id id = METACALL_STRING;
+
+	static void *create(const std::string &v)
+	{
+		return ::metacall_value_create_string(v.c_str(), v.size());
+	}
+
+	static std::string to(void **v);
+};
+
+template <>
+struct value_traits<const char *>
+{
+	static constexpr enum metacall_value_id id = METACALL_STRING;
+
+	static void *create(const char *v)
+	{
+		return ::metacall_value_create_string(v, std::char_traits<char>::length(v));
+	}
+};
+
+template <>
+struct value_traits<char *> : value_traits<const char *>
+{
+};
+
+template <>
+struct value_traits<std::vector<unsigned char>>
+{
+	static constexpr enum metacall_value_id id = METACALL_BUFFER;
+
+	static void *create(const std::vector<unsigned char> &v)
+	{
+		return ::metacall_value_create_buffer(v.data(), v.size());
+	}
+
+	static std::vector<unsigned char> to(void **v);
+};
+
+template <>
+struct value_traits<void *>
+{
+	static constexpr enum metacall_value_id id = METACALL_PTR;
+
+	static void *create(void *v)
+	{
+		return ::metacall_value_create_ptr(v);
+	}
+
+	static void *to(void **v)
+	{
+		return ::metacall_value_cast_ptr(v);
+	}
+};
+
+/* -- Classes -- */
+
+template <typename Signature>
+class function;
+
+/**
+*  @brief
+*    Typed handle to a MetaCall function, the function is resolved and its
+*    signature is checked once at construction, calls map the arguments and
+*    the return value at compile time and do not perform any lookup by name
+*/
+template <typename R, typename... Args>
+class function<R(Args...)>
+{
+public:
+	explicit function(const std::string &name);
+
+	explicit function(void *func);
+
+	R operator()(const Args &...args) const;
+
+	void *handle() const;
+
+private:
+	void bind();
+
+	void *func;
+};
+
+/* -- Methods -- */
+
 template <typename... Ts>
 METACALL_API int metacall(std::string name, Ts... ts);
 
@@ -25,14 +25,220 @@
 
 #include <metacall/metacall_api.hpp>
 
+#include <stdexcept>
 #include <string>
 
 namespace metacall
 {
+namespace detail
+{
+inline bool numeric(enum metacall_value_id id)
+{
+	return id >= METACALL_BOOL && id <= METACALL_DOUBLE;
+}
+
+inline bool compatible(enum metacall_value_id expected, enum metacall_value_id id)
+{
+	/* Numbers are casted between them when calling, so any of them is valid */
+	return expected == id || (numeric(expected) && numeric(id));
+}
+
+inline void check(void *ret)
+{
+	if (ret == NULL)
+	{
+		throw std::runtime_error("Invalid function call");
+	}
+
+	enum metacall_value_id id = ::metacall_value_id(ret);
+
+	if (id == METACALL_THROWABLE || id == METACALL_EXCEPTION)
+	{
+		struct metacall_exception_type ex;
+		std::string message("Function call has thrown an exception");
+
+		if (::metacall_error_from_value(ret, &ex) == 0 && ex.message != NULL)
+		{
+			message = ex.message;
+		}
+
+		::metacall_value_destroy(ret);
+
+		throw std::runtime_error(message);
+	}
+}
+
+template <typename R>
+struct result
+{
+	static void bind(void *func)
+	{
+		enum metacall_value_id id;
+
+		if (::metacall_function_return_type(func, &id) == 0 && id != METACALL_INVALID && !compatible(value_traits_of<R>::id, id))
+		{
+			throw std::invalid_argument(std::string("Invalid return type, the function returns ") + ::metacall_value_id_name(id));
+		}
+	}
+
+	static R from(void *ret)
+	{
+		check(ret);
+
+		if (!compatible(value_traits_of<R>::id, ::metacall_value_id(ret)))
+		{
+			std::string name(::metacall_value_type_name(ret));
+
+			::metacall_value_destroy(ret);
+
+			throw std::runtime_error("Invalid return value of type " + name);
+		}
+
+		R r = value_traits_of<R>::to(&ret);
+
+		::metacall_value_destroy(ret);
+
+		return r;
+	}
+};
+
+template <>
+struct result<void>
+{
+	static void bind(void *)
+	{
+	}
+
+	static void from(void *ret)
+	{
+		check(ret);
+
+		::metacall_value_destroy(ret);
+	}
+};
+
+template <typename... Args>
+struct parameters;
+
+template <>
+struct parameters<>
+{
+	static void bind(void *, size_t)
+	{
+	}
+};
+
+template <typename T, typename... Args>
+struct parameters<T, Args...>
+{
+	static void bind(void *func, size_t index)
+	{
+		enum metacall_value_id id;
+
+		if (::metacall_function_parameter_type(func, index, &id) == 0 && id != METACALL_INVALID && !compatible(value_traits_of<T>::id, id))
+		{
+			throw std::invalid_argument("Invalid type of parameter " + std::to_string(index) + ", the function expects " + ::metacall_value_id_name(id));
+		}
+
+		parameters<Args...>::bind(func, index + 1);
+	}
+};
+
+} /* namespace detail */
+
+inline std::string value_traits<std::string>::to(void **v)
+{
+	const char *str = ::metacall_value_to_string(*v);
+	size_t size = ::metacall_value_size(*v);
+
+	return std::string(str, size > 0 ? size - 1 : 0);
+}
+
+inline std::vector<unsigned char> value_traits<std::vector<unsigned char>>::to(void **v)
+{
+	const unsigned char *data = static_cast<const unsigned char *>(::metacall_value_to_buffer(*v));
+
+	return std::vector<unsigned char>(data, data + ::metacall_value_size(*v));
+}
+
+template <typename R, typename... Args>
+function<R(Args...)>::function(const std::string &name) :
+	func(::metacall_function(name.c_str()))
+{
+	if (func == NULL)
+	{
+		throw std::invalid_argument("Function " + name + " not found");
+	}
+
+	bind();
+}
+
+template <typename R, typename... Args>
+function<R(Args...)>::function(void *func) :
+	func(func)
+{
+	if (func == NULL)
+	{
+		throw std::invalid_argument("Invalid function");
+	}
+
+	bind();
+}
+
+template <typename R, typename... Args>
+void function<R(Args...)>::bind()
+{
+	size_t size = ::metacall_function_size(func);
+
+	if (size != sizeof...(Args))
+	{
+		throw std::invalid_argument("Invalid number of arguments, the function expects " + std::to_string(size));
+	}
+
+	detail::parameters<Args...>::bind(func, 0);
+	detail::result<R>::bind(func);
+}
+
+template <typename R, typename... Args>
+R function<R(Args...)>::operator()(const Args &...args) const
+{
+	/* Arguments live in the stack, the array has at least one element for functions without parameters */
+	void *argv[sizeof...(Args) > 0 ? sizeof...(Args) : 1] = { value_traits_of<Args>::create(args)... };
+
+	for (size_t iterator = 0; iterator < sizeof...(Args); ++iterator)
+	{
+		if (argv[iterator] == NULL)
+		{
+			for (size_t index = 0; index < sizeof...(Args); ++index)
+			{
+				::metacall_value_destroy(argv[index]);
+			}
+
+			throw std::bad_alloc();
+		}
+	}
+
+	void *ret = ::metacallfv_s(func, argv, sizeof...(Args));
+
+	/* Arguments may have been replaced by casts during the call, so destroy the ones in the array */
+	for (size_t iterator = 0; iterator < sizeof...(Args); ++iterator)
+	{
+		::metacall_value_destroy(argv[iterator]);
+	}
+
+	return detail::result<R>::from(ret);
+}
+
+template <typename R, typename... Args>
+void *function<R(Args...)>::handle() const
+{
+	return func;
+}
+
 template <typename... Ts>
 METACALL_API int metacall(std::string name, Ts... ts)
 {
-	return 0;
+	return function<int(Ts...)>(name)(ts...);
 }
 
 } /* namespace metacall */
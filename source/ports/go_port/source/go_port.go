@@ -53,6 +53,7 @@ import (
 	"reflect"
 	"runtime"
 	"sync"
+	"sync/atomic"
 	"unsafe"
 )
 
@@ -68,21 +69,38 @@ type loadFromMemorySafeWork struct {
 	err    chan error
 }
 
+type functionReturnSafeWork struct {
+	function *Function
+	err      error
+}
+
+type functionSafeWork struct {
+	name string
+	ret  chan functionReturnSafeWork
+}
+
 type callReturnSafeWork struct {
 	value interface{}
 	err   error
 }
 
 type callSafeWork struct {
-	function string
+	function *Function
 	args     []interface{}
 	ret      chan callReturnSafeWork
 }
 
+type batchSafeWork struct {
+	calls   []BatchCall
+	results []CallResult
+	indices []int // Positions of the calls (and their results) served by this work
+	done    chan struct{}
+}
+
 type awaitCallback func(interface{}, interface{}) interface{}
 
 type awaitSafeWork struct {
-	function string
+	function *Function
 	args     []interface{}
 	ret      chan callReturnSafeWork
 	resolve  awaitCallback
@@ -96,13 +114,42 @@ type awaitCallbacks struct {
 	ctx     interface{}
 }
 
+// Function is a handle to a MetaCall function, resolved once by name and reused
+// on each call. It is resolved again when a handle has been reloaded or cleared
+// since then, and handles are invalidated when MetaCall is destroyed.
+type Function struct {
+	name    string
+	binding unsafe.Pointer // Current *functionBinding, replaced atomically by the workers
+}
+
+type functionBinding struct {
+	ptr         unsafe.Pointer
+	generation  C.size_t
+	multithread bool // The loader of the function allows calling it from any worker
+}
+
+// BatchCall describes a single call submitted through CallBatch
+type BatchCall struct {
+	Function *Function
+	Args     []interface{}
+}
+
+// CallResult holds the result of a single call submitted through CallBatch
+type CallResult struct {
+	Value interface{}
+	Err   error
+}
+
 const PtrSizeInBytes = (32 << uintptr(^uintptr(0)>>63)) >> 3
 
 var (
-	queue  = make(chan interface{}, 1) // Queue for dispatching the work
-	toggle chan struct{}               // Channel for stopping the queue
-	lock   sync.Mutex                  // Lock for the queue
-	wg     sync.WaitGroup              // Wait group for the queue (needed to obtain return values)
+	queue     = make(chan interface{}, 1) // Queue for dispatching the work bound to the main thread (loads and awaits)
+	calls     = make(chan interface{}, 1) // Queue for dispatching the calls, served by all the workers
+	toggle    chan struct{}               // Channel for stopping the queue
+	lock      sync.Mutex                  // Lock for the queue
+	wg        sync.WaitGroup              // Wait group for the queue (needed to obtain return values)
+	workers   = 1                         // Amount of workers serving the calls queue
+	functions sync.Map                    // Cache of resolved functions indexed by name
 )
 
 func InitializeUnsafe() error {
@@ -119,6 +166,14 @@ func InitializeUnsafe() error {
 
 // Start starts the metacall adapter
 func Initialize() error {
+	return InitializeWorkers(1)
+}
+
+// InitializeWorkers starts the metacall adapter with a pool of workers, each one bound
+// to its own OS thread. The first worker initializes MetaCall and it is the only one
+// that loads scripts and awaits. Calls to functions whose loader allows being called
+// from multiple threads are served by all the workers, the rest only by the first one.
+func InitializeWorkers(count int) error {
 	lock.Lock()
 	defer lock.Unlock()
 
@@ -127,10 +182,15 @@ func Initialize() error {
 		return nil
 	}
 
+	if count < 1 {
+		return fmt.Errorf("invalid number of workers: %d", count)
+	}
+
 	toggle = make(chan struct{}, 1)
+	workers = count
 	initErr := make(chan error, 1)
 
-	go func(initErr chan error, toggle <-chan struct{}) {
+	go func(initErr chan error, toggle <-chan struct{}, count int) {
 		// Bind this goroutine to its thread
 		runtime.LockOSThread()
 
@@ -140,45 +200,93 @@ func Initialize() error {
 			return
 		}
 
+		// Spawn the rest of workers, they only serve calls
+		stop := make(chan struct{})
+		var pool sync.WaitGroup
+
+		pool.Add(count - 1)
+
+		for i := 1; i < count; i++ {
+			go callWorker(stop, &pool)
+		}
+
 		close(initErr)
 
 		for {
 			select {
 			case <-toggle:
-				// Shutdown
+				// Shutdown, wait for the workers before destroying
+				close(stop)
+				pool.Wait()
 				DestroyUnsafe()
 				return
 			case w := <-queue:
-				switch v := w.(type) {
-				case loadFromFileSafeWork:
-					{
-						err := LoadFromFileUnsafe(v.tag, v.scripts)
-						v.err <- err
-					}
-				case loadFromMemorySafeWork:
-					{
-						err := LoadFromMemoryUnsafe(v.tag, v.buffer)
-						v.err <- err
-					}
-				case callSafeWork:
-					{
-						value, err := CallUnsafe(v.function, v.args...)
-						v.ret <- callReturnSafeWork{value, err}
-					}
-				case awaitSafeWork:
-					{
-						value, err := AwaitUnsafe(v.function, v.resolve, v.reject, v.ctx, v.args...)
-						v.ret <- callReturnSafeWork{value, err}
-					}
-				}
-				wg.Done()
+				dispatch(w)
+			case w := <-calls:
+				dispatch(w)
 			}
 		}
-	}(initErr, toggle)
+	}(initErr, toggle, count)
 
 	return <-initErr
 }
 
+func callWorker(stop <-chan struct{}, pool *sync.WaitGroup) {
+	defer pool.Done()
+
+	// Bind this goroutine to its thread
+	runtime.LockOSThread()
+
+	for {
+		select {
+		case <-stop:
+			return
+		case w := <-calls:
+			dispatch(w)
+		}
+	}
+}
+
+func dispatch(w interface{}) {
+	switch v := w.(type) {
+	case loadFromFileSafeWork:
+		{
+			err := LoadFromFileUnsafe(v.tag, v.scripts)
+			v.err <- err
+		}
+	case loadFromMemorySafeWork:
+		{
+			err := LoadFromMemoryUnsafe(v.tag, v.buffer)
+			v.err <- err
+		}
+	case functionSafeWork:
+		{
+			function, err := getFunction(v.name)
+			v.ret <- functionReturnSafeWork{function, err}
+		}
+	case callSafeWork:
+		{
+			value, err := v.function.CallUnsafe(v.args...)
+			v.ret <- callReturnSafeWork{value, err}
+		}
+	case batchSafeWork:
+		{
+			for _, index := range v.indices {
+				call := v.calls[index]
+				value, err := call.Function.CallUnsafe(call.Args...)
+				v.results[index] = CallResult{value, err}
+			}
+			v.done <- struct{}{}
+		}
+	case awaitSafeWork:
+		{
+			value, err := v.function.AwaitUnsafe(v.resolve, v.reject, v.ctx, v.args...)
+			v.ret <- callReturnSafeWork{value, err}
+		}
+	}
+	wg.Done()
+}
+
 func LoadFromFileUnsafe(tag string, scripts []string) error {
 	size := len(scripts)
 
@@ -218,28 +326,48 @@ func LoadFromMemoryUnsafe(tag string, buffer string) error {
 	return nil
 }
 
-func CallUnsafe(function string, args ...interface{}) (interface{}, error) {
-	cFunc, err := getFunction(function)
-	if err != nil {
-		return nil, err
+// GetFunction resolves a function by name, the handle is cached so next calls avoid the lookup
+func GetFunction(name string) (*Function, error) {
+	if function, ok := functions.Load(name); ok {
+		return function.(*Function), nil
 	}
 
-	length := C.size_t(len(args))
-	cArgs := C.malloc(length * C.size_t(unsafe.Sizeof(uintptr(0))))
+	ret := make(chan functionReturnSafeWork, 1)
 
-	for index, arg := range args {
-		goToValue(arg, (*unsafe.Pointer)(unsafe.Pointer(uintptr(unsafe.Pointer(cArgs))+uintptr(index)*PtrSizeInBytes)))
+	w := functionSafeWork{
+		name: name,
+		ret:  ret,
 	}
 
-	defer func() {
-		for index, _ := range args {
-			C.metacall_value_destroy(*(*unsafe.Pointer)(unsafe.Pointer(uintptr(unsafe.Pointer(cArgs)) + uintptr(index)*PtrSizeInBytes)))
-		}
+	wg.Add(1)
+	queue <- w
+
+	result := <-ret
+
+	return result.function, result.err
+}
+
+// Name returns the name used for resolving the function
+func (f *Function) Name() string {
+	return f.name
+}
 
-		C.free(unsafe.Pointer(cArgs))
-	}()
+func (f *Function) CallUnsafe(args ...interface{}) (interface{}, error) {
+	ptr, err := f.bind()
+	if err != nil {
+		return nil, err
+	}
 
-	ret := C.metacallfv_s(cFunc, (*unsafe.Pointer)(cArgs), length)
+	cArgs := argsToValues(args)
+	defer argsDestroy(cArgs)
+
+	var ret unsafe.Pointer
+
+	if len(cArgs) > 0 {
+		ret = C.metacallfv_s(ptr, &cArgs[0], C.size_t(len(cArgs)))
+	} else {
+		ret = C.metacallfv_s(ptr, nil, 0)
+	}
 
 	if ret != nil {
 		defer C.metacall_value_destroy(ret)
@@ -249,24 +377,109 @@ func CallUnsafe(function string, args ...interface{}) (interface{}, error) {
 	return nil, nil
 }
 
-// Call sends work and blocks until it's processed
-func Call(function string, args ...interface{}) (interface{}, error) {
+// Call sends the call to the workers and blocks until it's processed, the call is
+// served by the first worker unless the loader of the function allows multiple threads
+func (f *Function) Call(args ...interface{}) (interface{}, error) {
 	ret := make(chan callReturnSafeWork, 1)
 
 	w := callSafeWork{
-		function: function,
+		function: f,
 		args:     args,
 		ret:      ret,
 	}
 
 	wg.Add(1)
-	queue <- w
+	f.queue() <- w
 
 	result := <-ret
 
 	return result.value, result.err
 }
 
+func CallUnsafe(function string, args ...interface{}) (interface{}, error) {
+	f, err := getFunction(function)
+	if err != nil {
+		return nil, err
+	}
+
+	return f.CallUnsafe(args...)
+}
+
+// Call sends work and blocks until it's processed
+func Call(function string, args ...interface{}) (interface{}, error) {
+	f, err := GetFunction(function)
+	if err != nil {
+		return nil, err
+	}
+
+	return f.Call(args...)
+}
+
+// CallBatch splits the calls between the workers and blocks until all of them are
+// processed, the results are returned in the same order as the calls. The calls to
+// functions whose loader does not allow multiple threads are served by the first worker
+func CallBatch(batch []BatchCall) []CallResult {
+	results := make([]CallResult, len(batch))
+
+	if len(batch) == 0 {
+		return results
+	}
+
+	lock.Lock()
+	count := workers
+	lock.Unlock()
+
+	var shared, bound []int
+
+	for index, call := range batch {
+		if call.Function.queue() == calls {
+			shared = append(shared, index)
+		} else {
+			bound = append(bound, index)
+		}
+	}
+
+	done := make(chan struct{}, count+1)
+	pending := 0
+
+	submit := func(indices []int, q chan interface{}) {
+		w := batchSafeWork{
+			calls:   batch,
+			results: results,
+			indices: indices,
+			done:    done,
+		}
+
+		wg.Add(1)
+		q <- w
+		pending++
+	}
+
+	if len(bound) > 0 {
+		submit(bound, queue)
+	}
+
+	if len(shared) > 0 {
+		size := (len(shared) + count - 1) / count
+
+		for begin := 0; begin < len(shared); begin += size {
+			end := begin + size
+
+			if end > len(shared) {
+				end = len(shared)
+			}
+
+			submit(shared[begin:end], calls)
+		}
+	}
+
+	for ; pending > 0; pending-- {
+		<-done
+	}
+
+	return results
+}
+
 //export goResolve
 func goResolve(v unsafe.Pointer, ctx unsafe.Pointer) unsafe.Pointer {
 	var ptr unsafe.Pointer
@@ -287,26 +500,14 @@ func goReject(v unsafe.Pointer, ctx unsafe.Pointer) unsafe.Pointer {
 	return ptr
 }
 
-func AwaitUnsafe(function string, resolve, reject awaitCallback, ctx interface{}, args ...interface{}) (interface{}, error) {
-	cFunc, err := getFunction(function)
+func (f *Function) AwaitUnsafe(resolve, reject awaitCallback, ctx interface{}, args ...interface{}) (interface{}, error) {
+	ptr, err := f.bind()
 	if err != nil {
 		return nil, err
 	}
 
-	length := C.size_t(len(args))
-	cArgs := C.malloc(length * C.size_t(unsafe.Sizeof(uintptr(0))))
-
-	for index, arg := range args {
-		goToValue(arg, (*unsafe.Pointer)(unsafe.Pointer(uintptr(unsafe.Pointer(cArgs))+uintptr(index)*PtrSizeInBytes)))
-	}
-
-	defer func() {
-		for index, _ := range args {
-			C.metacall_value_destroy(*(*unsafe.Pointer)(unsafe.Pointer(uintptr(unsafe.Pointer(cArgs)) + uintptr(index)*PtrSizeInBytes)))
-		}
-
-		C.free(unsafe.Pointer(cArgs))
-	}()
+	cArgs := argsToValues(args)
+	defer argsDestroy(cArgs)
 
 	cCallbacks := C.metacall_await_callbacks{}
 
@@ -330,7 +531,13 @@ func AwaitUnsafe(function string, resolve, reject awaitCallback, ctx interface{}
 
 	goCallbacksPtr := pointerSave(&goCallbacks)
 
-	ret := C.metacallfv_await_struct_s(cFunc, (*unsafe.Pointer)(cArgs), length, cCallbacks, goCallbacksPtr)
+	var ret unsafe.Pointer
+
+	if len(cArgs) > 0 {
+		ret = C.metacallfv_await_struct_s(ptr, &cArgs[0], C.size_t(len(cArgs)), cCallbacks, goCallbacksPtr)
+	} else {
+		ret = C.metacallfv_await_struct_s(ptr, nil, 0, cCallbacks, goCallbacksPtr)
+	}
 
 	if ret != nil {
 		defer C.metacall_value_destroy(ret)
@@ -340,12 +547,12 @@ func AwaitUnsafe(function string, resolve, reject awaitCallback, ctx interface{}
 	return nil, nil
 }
 
-// Await sends asynchronous work and blocks until it's processed
-func Await(function string, resolve, reject awaitCallback, ctx interface{}, args ...interface{}) (interface{}, error) {
+// Await sends asynchronous work to the main worker and blocks until it's processed
+func (f *Function) Await(resolve, reject awaitCallback, ctx interface{}, args ...interface{}) (interface{}, error) {
 	ret := make(chan callReturnSafeWork, 1)
 
 	w := awaitSafeWork{
-		function: function,
+		function: f,
 		args:     args,
 		ret:      ret,
 		resolve:  resolve,
@@ -361,14 +568,107 @@ func Await(function string, resolve, reject awaitCallback, ctx interface{}, args
 	return result.value, result.err
 }
 
-func getFunction(function string) (unsafe.Pointer, error) {
+func AwaitUnsafe(function string, resolve, reject awaitCallback, ctx interface{}, args ...interface{}) (interface{}, error) {
+	f, err := getFunction(function)
+	if err != nil {
+		return nil, err
+	}
+
+	return f.AwaitUnsafe(resolve, reject, ctx, args...)
+}
+
+// Await sends asynchronous work and blocks until it's processed
+func Await(function string, resolve, reject awaitCallback, ctx interface{}, args ...interface{}) (interface{}, error) {
+	f, err := GetFunction(function)
+	if err != nil {
+		return nil, err
+	}
+
+	return f.Await(resolve, reject, ctx, args...)
+}
+
+func getFunction(function string) (*Function, error) {
+	if f, ok := functions.Load(function); ok {
+		return f.(*Function), nil
+	}
+
+	binding, err := resolveFunction(function)
+	if err != nil {
+		return nil, err
+	}
+	f, _ := functions.LoadOrStore(function, &Function{function, unsafe.Pointer(binding)})
+	return f.(*Function), nil
+}
+
+func resolveFunction(function string) (*functionBinding, error) {
+	// Obtain the generation before resolving, so a reload meanwhile is detected in the next call
+	generation := C.metacall_generation()
 	cFunction := C.CString(function)
 	defer C.free(unsafe.Pointer(cFunction))
 	cFunc := C.metacall_function(cFunction)
 	if cFunc == nil {
 		return nil, errors.New("function not found: " + function)
 	}
-	return cFunc, nil
+	multithread := C.metacall_function_multithread(cFunc) == 1
+	return &functionBinding{cFunc, generation, multithread}, nil
+}
+
+// Returns the queue which serves the calls to the function, the calls queue is shared by
+// all the workers, so it is only used when the loader allows calls from multiple threads
+func (f *Function) queue() chan interface{} {
+	if f == nil {
+		// Invalid handles fail when they are dispatched, any worker can report it
+		return calls
+	}
+
+	binding := (*functionBinding)(atomic.LoadPointer(&f.binding))
+
+	if binding.multithread {
+		return calls
+	}
+
+	return queue
+}
+
+// Returns the function pointer, it is resolved again by name if any handle has been
+// reloaded or cleared since the last time, because the previous one may be outdated
+func (f *Function) bind() (unsafe.Pointer, error) {
+	if f == nil {
+		return nil, errors.New("invalid function handle")
+	}
+
+	binding := (*functionBinding)(atomic.LoadPointer(&f.binding))
+
+	if binding.generation == C.metacall_generation() {
+		return binding.ptr, nil
+	}
+
+	binding, err := resolveFunction(f.name)
+	if err != nil {
+		return nil, err
+	}
+
+	atomic.StorePointer(&f.binding, unsafe.Pointer(binding))
+
+	return binding.ptr, nil
+}
+
+// The array of arguments only holds C pointers, so it can live in Go memory
+// and be passed directly to MetaCall without an intermediate allocation
+func argsToValues(args []interface{}) []unsafe.Pointer {
+	cArgs := make([]unsafe.Pointer, len(args))
+
+	for index, arg := range args {
+		goToValue(arg, &cArgs[index])
+	}
+
+	return cArgs
+}
+
+func argsDestroy(cArgs []unsafe.Pointer) {
+	for _, arg := range cArgs {
+		C.metacall_value_destroy(arg)
+	}
 }
 
 func goToValue(arg interface{}, ptr *unsafe.Pointer) {
@@ -613,6 +913,12 @@ func LoadFromMemory(tag string, buffer string) error {
 }
 
 func DestroyUnsafe() {
+	// Function handles are not valid anymore after destroying
+	functions.Range(func(key, value interface{}) bool {
+		functions.Delete(key)
+		return true
+	})
+
 	C.metacall_destroy()
 }
 
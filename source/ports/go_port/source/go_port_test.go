@@ -2,6 +2,7 @@ package metacall
 
 import (
 	"bytes"
+	"fmt"
 	"log"
 	"os"
 	"reflect"
@@ -10,8 +11,11 @@ import (
 	"unsafe"
 )
 
+// Calls are served by more than one worker, so the tests also cover the pool
+const testWorkers = 4
+
 func TestMain(m *testing.M) {
-	if err := Initialize(); err != nil {
+	if err := InitializeWorkers(testWorkers); err != nil {
 		log.Fatal(err)
 	}
 
@@ -29,10 +33,22 @@ func TestMain(m *testing.M) {
 	os.Exit(code)
 }
 
-func TestMock(t *testing.T) {
-	scripts := []string{"test.mock"}
+var (
+	mockOnce sync.Once
+	mockErr  error
+)
 
-	if err := LoadFromFile("mock", scripts); err != nil {
+// The same handle cannot be loaded twice, so the tests share it
+func loadMock() error {
+	mockOnce.Do(func() {
+		mockErr = LoadFromFile("mock", []string{"test.mock"})
+	})
+
+	return mockErr
+}
+
+func TestMock(t *testing.T) {
+	if err := loadMock(); err != nil {
 		t.Fatal(err)
 		return
 	}
@@ -51,6 +67,223 @@ func TestMock(t *testing.T) {
 	}
 }
 
+func TestMockFunction(t *testing.T) {
+	if err := loadMock(); err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	f, err := GetFunction("three_str")
+
+	if err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	if cached, err := GetFunction("three_str"); err != nil || cached != f {
+		t.Fatal("expected the function handle to be cached")
+		return
+	}
+
+	if _, err := GetFunction("this_function_does_not_exist"); err == nil {
+		t.Fatal("expected an error when resolving an unknown function")
+		return
+	}
+
+	ret, err := f.Call("e", "f", "g")
+
+	if err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	if str, ok := ret.(string); !ok || str != "Hello World" {
+		t.Fatalf("expected 'Hello World', received %v", ret)
+	}
+}
+
+func TestMockBatch(t *testing.T) {
+	if err := loadMock(); err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	f, err := GetFunction("three_str")
+
+	if err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	batch := make([]BatchCall, 10)
+
+	for i := range batch {
+		batch[i] = BatchCall{f, []interface{}{"e", "f", "g"}}
+	}
+
+	// Invalid handles must fail only the call that contains them
+	batch[5].Function = nil
+
+	results := CallBatch(batch)
+
+	if len(results) != len(batch) {
+		t.Fatalf("expected %d results, received %d", len(batch), len(results))
+		return
+	}
+
+	for i, result := range results {
+		if i == 5 {
+			if result.Err == nil {
+				t.Fatal("expected an error in the call with an invalid handle")
+			}
+			continue
+		}
+
+		if result.Err != nil {
+			t.Fatal(result.Err)
+			return
+		}
+
+		if str, ok := result.Value.(string); !ok || str != "Hello World" {
+			t.Fatalf("expected 'Hello World' at position %d, received %v", i, result.Value)
+		}
+	}
+}
+
+func TestMockConcurrent(t *testing.T) {
+	if err := loadMock(); err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	f, err := GetFunction("three_str")
+
+	if err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	var wg sync.WaitGroup
+
+	errs := make(chan error, testWorkers*8)
+
+	// Goroutines outnumber the workers, so the calls are spread between all of them
+	for i := 0; i < testWorkers*8; i++ {
+		wg.Add(1)
+
+		go func() {
+			defer wg.Done()
+
+			for j := 0; j < 100; j++ {
+				ret, err := f.Call("e", "f", "g")
+
+				if err != nil {
+					errs <- err
+					return
+				}
+
+				if str, ok := ret.(string); !ok || str != "Hello World" {
+					errs <- fmt.Errorf("expected 'Hello World', received %v", ret)
+					return
+				}
+			}
+		}()
+	}
+
+	wg.Wait()
+	close(errs)
+
+	for err := range errs {
+		t.Fatal(err)
+	}
+}
+
+func TestRubyConcurrent(t *testing.T) {
+	// Ruby only allows calls from the thread that initialized it, so they must not reach the pool
+	buffer := "def go_port_rb_add(a, b)\n\ta + b\nend\n"
+
+	if err := LoadFromMemory("rb", buffer); err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	if err := loadMock(); err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	add, err := GetFunction("go_port_rb_add")
+
+	if err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	mock, err := GetFunction("three_str")
+
+	if err != nil {
+		t.Fatal(err)
+		return
+	}
+
+	var wg sync.WaitGroup
+
+	errs := make(chan error, testWorkers*8)
+
+	for i := 0; i < testWorkers*8; i++ {
+		wg.Add(1)
+
+		go func(i int) {
+			defer wg.Done()
+
+			for j := 0; j < 10; j++ {
+				ret, err := add.Call(i, j)
+
+				if err != nil {
+					errs <- err
+					return
+				}
+
+				if ret != i+j {
+					errs <- fmt.Errorf("expected %d, received %v", i+j, ret)
+					return
+				}
+			}
+		}(i)
+	}
+
+	wg.Wait()
+	close(errs)
+
+	for err := range errs {
+		t.Fatal(err)
+	}
+
+	// Batches mixing both kinds of functions keep the order of the results
+	batch := make([]BatchCall, 16)
+
+	for i := range batch {
+		if i%2 == 0 {
+			batch[i] = BatchCall{add, []interface{}{i, 1}}
+		} else {
+			batch[i] = BatchCall{mock, []interface{}{"e", "f", "g"}}
+		}
+	}
+
+	for i, result := range CallBatch(batch) {
+		if result.Err != nil {
+			t.Fatal(result.Err)
+			return
+		}
+
+		if i%2 == 0 && result.Value != i+1 {
+			t.Fatalf("expected %d at position %d, received %v", i+1, i, result.Value)
+		} else if i%2 != 0 && result.Value != "Hello World" {
+			t.Fatalf("expected 'Hello World' at position %d, received %v", i, result.Value)
+		}
+	}
+}
+
 func TestNodeJSArray(t *testing.T) {
 	buffer := "module.exports = { g: () => [0, 1, 2] }"
 
@@ -237,3 +470,52 @@ func BenchmarkNodeJSParallel(b *testing.B) {
 		}
 	})
 }
+
+func benchmarkMockFunction(b *testing.B) *Function {
+	if err := loadMock(); err != nil {
+		b.Fatal(err)
+	}
+
+	f, err := GetFunction("three_str")
+
+	if err != nil {
+		b.Fatal(err)
+	}
+
+	return f
+}
+
+func BenchmarkMockCallParallel(b *testing.B) {
+	f := benchmarkMockFunction(b)
+
+	b.ResetTimer()
+
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			if _, err := f.Call("e", "f", "g"); err != nil {
+				b.Fatal(err)
+				return
+			}
+		}
+	})
+}
+
+func BenchmarkMockCallBatch(b *testing.B) {
+	f := benchmarkMockFunction(b)
+	batch := make([]BatchCall, 64)
+
+	for i := range batch {
+		batch[i] = BatchCall{f, []interface{}{"e", "f", "g"}}
+	}
+
+	b.ResetTimer()
+
+	for i := 0; i < b.N; i += len(batch) {
+		for _, result := range CallBatch(batch) {
+			if result.Err != nil {
+				b.Fatal(result.Err)
+				return
+			}
+		}
+	}
+}
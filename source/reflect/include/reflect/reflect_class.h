@@ -77,6 +77,8 @@ REFLECT_API int class_increment_reference(klass cls);
 
 REFLECT_API int class_decrement_reference(klass cls);
 
+REFLECT_API size_t class_reference_count(klass cls);
+
 REFLECT_API class_impl class_impl_get(klass cls);
 
 REFLECT_API object class_new(klass cls, const char *name, constructor ctor, class_args args, size_t argc);
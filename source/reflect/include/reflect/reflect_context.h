@@ -45,6 +45,10 @@ REFLECT_API int context_contains(context dest, context src, char **duplicated);
 
 REFLECT_API int context_remove(context dest, context src);
 
+REFLECT_API int context_replace(context dest, context old_ctx, context new_ctx, char **duplicated);
+
+REFLECT_API size_t context_references(context ctx);
+
 REFLECT_API void context_destroy(context ctx);
 
 #ifdef __cplusplus
@@ -22,6 +22,7 @@
 #define REFLECT_FUNCTION_H 1
 
 #include <reflect/reflect_async.h>
+#include <reflect/reflect_metrics.h>
 #include <reflect/reflect_signature.h>
 #include <reflect/reflect_value.h>
 
@@ -62,12 +63,39 @@ typedef struct function_interface_type
 
 typedef function_interface (*function_impl_interface_singleton)(void);
 
+struct function_trace_span_type;
+
+typedef struct function_trace_span_type *function_trace_span;
+
+struct function_trace_span_type
+{
+	uint64_t id;				  /**< Identifier of the span, zero if it has not been sampled */
+	uint64_t parent;			  /**< Identifier of the parent span, zero if it is a root span */
+	uint64_t start;				  /**< Start time of the span in nanoseconds */
+	uint64_t thread;			  /**< Identifier of the thread where the span started */
+	int async;					  /**< Different from zero if the span is an await */
+	function_trace_span previous; /**< Current span of the thread before this one started */
+};
+
+/* Tracing hooks, begin makes the span the current one of the thread, swap replaces the current
+* span of the thread returning the previous one, and end is called once the call has finished
+*/
+typedef struct function_trace_interface_type
+{
+	void (*begin)(function, function_trace_span);
+	function_trace_span (*swap)(function_trace_span);
+	void (*end)(function, function_trace_span, int);
+
+} * function_trace_interface;
+
 REFLECT_API function function_create(const char *name, size_t args_count, function_impl impl, function_impl_interface_singleton singleton);
 
 REFLECT_API int function_increment_reference(function func);
 
 REFLECT_API int function_decrement_reference(function func);
 
+REFLECT_API size_t function_reference_count(function func);
+
 REFLECT_API void function_async(function func, enum async_id async);
 
 REFLECT_API enum async_id function_async_id(function func);
@@ -86,6 +114,14 @@ REFLECT_API function_return function_call(function func, function_args args, siz
 
 REFLECT_API function_return function_await(function func, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context);
 
+REFLECT_API void function_metrics_enable(int enable);
+
+REFLECT_API int function_metrics_enabled(void);
+
+REFLECT_API metrics function_metrics(function func);
+
+REFLECT_API void function_trace(function_trace_interface iface);
+
 REFLECT_API void function_stats_debug(void);
 
 REFLECT_API void function_destroy(function func);
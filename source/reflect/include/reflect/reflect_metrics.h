@@ -0,0 +1,187 @@
+/*
+ *	Reflect Library by Parra Studios
+ *	A library for provide reflection and metadata representation.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+*/
+
+#ifndef REFLECT_METRICS_H
+#define REFLECT_METRICS_H 1
+
+/* -- Headers -- */
+
+#include <reflect/reflect_api.h>
+
+#include <reflect/reflect_value.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -- Headers -- */
+
+#include <stdint.h>
+
+/* -- Definitions -- */
+
+/* The latency histogram is log-linear (HDR style): values below 4ns have their own
+* bucket and every power of two above is split in 4 linear sub-buckets, which bounds
+* the relative error to 25% and covers up to 2^41ns (~36 minutes) with 160 buckets
+*/
+#define METRICS_HISTOGRAM_SUB_BITS 2
+#define METRICS_HISTOGRAM_SUB_SIZE (1 << METRICS_HISTOGRAM_SUB_BITS)
+#define METRICS_HISTOGRAM_SIZE (40 * METRICS_HISTOGRAM_SUB_SIZE)
+
+/* -- Forward Declarations -- */
+
+struct metrics_type;
+
+struct metrics_snapshot_type;
+
+/* -- Type Definitions -- */
+
+typedef struct metrics_type *metrics;
+
+typedef struct metrics_snapshot_type *metrics_snapshot;
+
+/* -- Member Data -- */
+
+struct metrics_snapshot_type
+{
+	uint64_t calls;								 /**< Number of calls started */
+	uint64_t errors;							 /**< Number of calls returning an exception or throwable */
+	uint64_t in_flight;							 /**< Number of calls started but not finished yet */
+	uint64_t total;								 /**< Sum of the latency of the finished calls in nanoseconds */
+	uint64_t histogram[METRICS_HISTOGRAM_SIZE]; /**< Latency of the finished calls */
+};
+
+/* -- Methods -- */
+
+/**
+*  @brief
+*    Create the metrics of a function, counters are split in per-thread
+*    shards so concurrent calls do not contend on the same cache lines
+*
+*  @return
+*    Pointer to the metrics if success, null otherwise
+*/
+REFLECT_API metrics metrics_create(void);
+
+/**
+*  @brief
+*    Get the current time of the monotonic clock in nanoseconds
+*
+*  @return
+*    Monotonic time in nanoseconds
+*/
+REFLECT_API uint64_t metrics_time(void);
+
+/**
+*  @brief
+*    Register the start of a call
+*
+*  @param[in] m
+*    Metrics where the call is accounted
+*
+*  @return
+*    Start timestamp which must be passed to metrics_end
+*/
+REFLECT_API uint64_t metrics_begin(metrics m);
+
+/**
+*  @brief
+*    Register the end of a call started with metrics_begin,
+*    it can be called from a different thread than the start
+*
+*  @param[in] m
+*    Metrics where the call is accounted
+*
+*  @param[in] start
+*    Timestamp returned by metrics_begin
+*
+*  @param[in] error
+*    Different from zero if the call failed
+*/
+REFLECT_API void metrics_end(metrics m, uint64_t start, int error);
+
+/**
+*  @brief
+*    Accumulate the shards of @m into @snapshot, the snapshot is not
+*    reset so the metrics of many functions can be merged into one
+*
+*  @param[in] m
+*    Metrics to be read
+*
+*  @param[out] snapshot
+*    Snapshot where the counters are added
+*/
+REFLECT_API void metrics_collect(metrics m, metrics_snapshot snapshot);
+
+/**
+*  @brief
+*    Get the highest latency in nanoseconds stored in the histogram bucket @index
+*
+*  @param[in] index
+*    Index of the bucket, lower than METRICS_HISTOGRAM_SIZE
+*
+*  @return
+*    Inclusive upper bound of the bucket in nanoseconds
+*/
+REFLECT_API uint64_t metrics_histogram_bound(size_t index);
+
+/**
+*  @brief
+*    Estimate a latency quantile from the histogram of @snapshot
+*
+*  @param[in] snapshot
+*    Snapshot to be read
+*
+*  @param[in] q
+*    Quantile in the range [0, 1]
+*
+*  @return
+*    Upper bound in nanoseconds of the bucket containing the quantile, zero if there are no calls
+*/
+REFLECT_API uint64_t metrics_quantile(metrics_snapshot snapshot, double q);
+
+/**
+*  @brief
+*    Convert the snapshot into a map value with the counters, the total
+*    latency, the 50th, 90th and 99th percentiles and the non-empty histogram
+*    buckets as an array of [upper bound in nanoseconds, count] pairs
+*
+*  @param[in] snapshot
+*    Snapshot to be converted
+*
+*  @return
+*    Map value if success, null otherwise
+*/
+REFLECT_API value metrics_value(metrics_snapshot snapshot);
+
+/**
+*  @brief
+*    Destroy the metrics of a function
+*
+*  @param[in] m
+*    Metrics to be destroyed
+*/
+REFLECT_API void metrics_destroy(metrics m);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REFLECT_METRICS_H */
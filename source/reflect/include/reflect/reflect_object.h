@@ -79,6 +79,8 @@ REFLECT_API int object_increment_reference(object obj);
 
 REFLECT_API int object_decrement_reference(object obj);
 
+REFLECT_API size_t object_reference_count(object obj);
+
 REFLECT_API object_impl object_impl_get(object obj);
 
 REFLECT_API int object_set(object obj, const char *key, value v);
@@ -46,6 +46,8 @@ REFLECT_API value scope_metadata(scope sp);
 
 REFLECT_API value scope_export(scope sp);
 
+REFLECT_API value scope_metrics(scope sp, metrics_snapshot total);
+
 REFLECT_API value scope_get(scope sp, const char *key);
 
 REFLECT_API value scope_undef(scope sp, const char *key);
@@ -56,6 +58,10 @@ REFLECT_API int scope_contains(scope dest, scope src, char **duplicated);
 
 REFLECT_API int scope_remove(scope dest, scope src);
 
+REFLECT_API int scope_replace(scope dest, scope old_sp, scope new_sp, char **duplicated);
+
+REFLECT_API size_t scope_references(scope sp);
+
 REFLECT_API size_t *scope_stack_return(scope sp);
 
 REFLECT_API scope_stack_ptr scope_stack_push(scope sp, size_t bytes);
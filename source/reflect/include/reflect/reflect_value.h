@@ -25,6 +25,8 @@
 
 #include <reflect/reflect_api.h>
 
+#include <memory/memory_allocator.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -45,8 +47,74 @@ typedef void *value;
 
 typedef void (*value_finalizer_cb)(value, void *);
 
+typedef value (*value_view_element_cb)(void *, size_t);
+
+typedef int (*value_view_find_cb)(void *, const char *, size_t, size_t *);
+
+typedef void (*value_view_destroy_cb)(void *);
+
+typedef struct value_view_interface_type
+{
+	value_view_element_cb element; /* Converts the element of the foreign object at an index (a key value tuple in maps) */
+	value_view_find_cb find;	   /* Optional, obtains the index of a string key in a map, returns zero if it is found */
+	value_view_destroy_cb destroy; /* Releases the foreign object */
+
+} * value_view_interface;
+
 /* -- Methods -- */
 
+/**
+*  @brief
+*    Set the allocator used for the values created by the current thread,
+*    all values reserved from now on (including the ones produced by loaders
+*    and serializers during a call) are allocated from it, until it is reset
+*
+*  @param[in] allocator
+*    Allocator to be used, or null to go back to the default heap allocation
+*
+*  @return
+*    Allocator that was in use before the call, it must be restored by the caller
+*/
+REFLECT_API memory_allocator value_allocator(memory_allocator allocator);
+
+/**
+*  @brief
+*    Get the allocator used for the values created by the current thread
+*
+*  @return
+*    Allocator set by value_allocator or null if values are heap allocated
+*/
+REFLECT_API memory_allocator value_allocator_current(void);
+
+/**
+*  @brief
+*    Keep track of a value reserved from an allocator which holds a reference
+*    (i.e to a function or an object), so it is released by value_allocator_finalize
+*    if the value is not destroyed before, heap values are not tracked
+*
+*  @param[in] v
+*    Reference to the value
+*/
+REFLECT_API void value_allocator_reference(value v);
+
+/**
+*  @brief
+*    Run the finalizers and release the references of the values reserved
+*    from @allocator by the current thread that are still alive, allocators
+*    which do not release each value on its own (i.e an arena) must call it
+*    before being destroyed
+*
+*  @param[in] allocator
+*    Allocator whose values are going to be released
+*
+*  @param[in] release
+*    Callback invoked for each value tracked by value_allocator_reference
+*
+*  @param[in] release_data
+*    User defined data passed to @release
+*/
+REFLECT_API void value_allocator_finalize(memory_allocator allocator, value_finalizer_cb release, void *release_data);
+
 /**
 *  @brief
 *    Reserve memory for a value with size @bytes
@@ -59,6 +127,70 @@ typedef void (*value_finalizer_cb)(value, void *);
 */
 REFLECT_API value value_alloc(size_t bytes);
 
+/**
+*  @brief
+*    Reserve memory for a compact value with size @bytes, compact values
+*    have a smaller header because they cannot hold a finalizer, which
+*    makes them suitable for scalars
+*
+*  @param[in] bytes
+*    Size in bytes to be allocated
+*
+*  @return
+*    Pointer to uninitialized value if success, null otherwhise
+*/
+REFLECT_API value value_alloc_compact(size_t bytes);
+
+/**
+*  @brief
+*    Reserve memory for a value with size @bytes backed by the foreign
+*    object @source (a view), which is accessed through @iface
+*
+*  @param[in] bytes
+*    Size in bytes to be allocated
+*
+*  @param[in] source
+*    Foreign object backing the value, the value owns it on success
+*
+*  @param[in] iface
+*    Interface for accessing to @source
+*
+*  @return
+*    Pointer to uninitialized value if success, null otherwhise
+*/
+REFLECT_API value value_alloc_view(size_t bytes, void *source, value_view_interface iface);
+
+/**
+*  @brief
+*    Get the foreign object backing the value @v
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @param[out] source
+*    Foreign object backing the value, it can be null
+*
+*  @return
+*    Interface of the foreign object, or null if @v is not a view or it has been detached
+*/
+REFLECT_API value_view_interface value_view(value v, void **source);
+
+/**
+*  @brief
+*    Detach the foreign object from the value @v, the value is not a view anymore
+*    and the caller takes the ownership of the foreign object
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @param[out] source
+*    Foreign object backing the value
+*
+*  @return
+*    Interface of the foreign object, or null if @v is not a view or it has been detached
+*/
+REFLECT_API value_view_interface value_view_detach(value v, void **source);
+
 /**
 *  @brief
 *    Create a value from @data with size @bytes
@@ -141,6 +273,44 @@ REFLECT_API void value_ref_inc(value v);
 */
 REFLECT_API void value_ref_dec(value v);
 
+/**
+*  @brief
+*    Decrement reference count of a value without destroying it
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @return
+*    Returns zero if the last reference was released and the value
+*    must be destroyed, different from zero otherwise
+*/
+REFLECT_API int value_ref_release(value v);
+
+/**
+*  @brief
+*    Check if a value has more than one owner
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @return
+*    Returns zero if the value is shared, different from zero otherwise
+*/
+REFLECT_API int value_ref_shared(value v);
+
+/**
+*  @brief
+*    Add a new owner to the value @v, the value must be released once by each owner
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @return
+*    The same value @v, or null if it was not reserved from the current allocator
+*    (see value_allocator) and therefore cannot be shared
+*/
+REFLECT_API value value_share(value v);
+
 /**
 *  @brief
 *    Set up the value finalizer, a callback that
@@ -157,6 +327,28 @@ REFLECT_API void value_ref_dec(value v);
 */
 REFLECT_API void value_finalizer(value v, value_finalizer_cb finalizer, void *finalizer_data);
 
+/**
+*  @brief
+*    Mark the value as borrowed, its data does not contain the memory
+*    block itself but a reference to a memory block owned by someone else
+*
+*  @param[in] v
+*    Reference to the value
+*/
+REFLECT_API void value_borrow(value v);
+
+/**
+*  @brief
+*    Check if the value references borrowed memory
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @return
+*    Returns zero if the value is borrowed, different from zero otherwise
+*/
+REFLECT_API int value_borrowed(value v);
+
 /**
 *  @brief
 *    Get pointer reference to value data
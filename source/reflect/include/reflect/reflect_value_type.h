@@ -71,6 +71,51 @@ REFLECT_API value value_type_create(const void *data, size_t bytes, type_id id);
 */
 REFLECT_API value value_type_copy(value v);
 
+/**
+*  @brief
+*    Make a shared copy of value @v, the value is not duplicated but its reference
+*    count is incremented, it falls back to a deep copy when it cannot be shared
+*    (borrowed values or values not reserved from the current allocator), value_from_*
+*    writes in place, so the owners must not write into a shared value unless it is
+*    unshared before (see value_type_unshare). Inside a scoped allocator (i.e an arena)
+*    the result belongs to it and dies along with it
+*
+*  @param[in] v
+*    Reference to the value is going to be copied
+*
+*  @return
+*    Pointer to the shared value or to a deep copy if success, null otherwhise
+*/
+REFLECT_API value value_type_share(value v);
+
+/**
+*  @brief
+*    Make a copy on write of value @v, arrays and maps are duplicated without
+*    their elements, which are copied on write too, the rest of values are shared
+*    (see value_type_share), so each owner can replace the elements of its
+*    containers and must unshare the rest of values before writing into them
+*
+*  @param[in] v
+*    Reference to the value is going to be copied
+*
+*  @return
+*    Pointer to the copy on write of @v if success, null otherwhise
+*/
+REFLECT_API value value_type_copy_on_write(value v);
+
+/**
+*  @brief
+*    Obtain a value owned only by the caller, duplicating @v if it is shared
+*
+*  @param[in] v
+*    Reference to the value is going to be written
+*
+*  @return
+*    The same value if it has a single owner, or a deep copy of it otherwise,
+*    in the latter case the reference of the caller to @v is released
+*/
+REFLECT_API value value_type_unshare(value v);
+
 /**
 *  @brief
 *    Creates a new pointer value, with a reference to the
@@ -137,6 +182,41 @@ REFLECT_API size_t value_type_size(value v);
 */
 REFLECT_API size_t value_type_count(void *v);
 
+/**
+*  @brief
+*    Get the element at @index of the array @v (or the tuple of the map @v),
+*    the elements of a view are converted on the first access only
+*
+*  @param[in] v
+*    Reference to the array or map value
+*
+*  @param[in] index
+*    Position of the element
+*
+*  @return
+*    Element owned by @v, or null if @index is out of bounds
+*/
+REFLECT_API value value_type_at(value v, size_t index);
+
+/**
+*  @brief
+*    Find the element of the map @v whose key is the string @key, in
+*    a view only the tuple of that element is converted
+*
+*  @param[in] v
+*    Reference to the map value
+*
+*  @param[in] key
+*    String of the key
+*
+*  @param[in] length
+*    Length of the string @key without the null terminator
+*
+*  @return
+*    Element owned by @v, or null if there is no element with that key
+*/
+REFLECT_API value value_type_find(value v, const char *key, size_t length);
+
 /**
 *  @brief
 *    Provide type id of value
@@ -263,6 +343,22 @@ REFLECT_API value value_create_string(const char *str, size_t length);
 */
 REFLECT_API value value_create_buffer(const void *buffer, size_t size);
 
+/**
+*  @brief
+*    Create a value buffer referencing @buffer without copying it,
+*    the memory must outlive the value, use value_finalizer for releasing it
+*
+*  @param[in] buffer
+*    Memory block owned by the caller
+*
+*  @param[in] size
+*    Size in bytes of the memory block
+*
+*  @return
+*    Pointer to value if success, null otherwhise
+*/
+REFLECT_API value value_create_buffer_borrowed(void *buffer, size_t size);
+
 /**
 *  @brief
 *    Create a value array from array of values @values
@@ -293,6 +389,47 @@ REFLECT_API value value_create_array(const value *values, size_t size);
 */
 REFLECT_API value value_create_map(const value *tuples, size_t size);
 
+/**
+*  @brief
+*    Create a value array backed by the foreign object @source (a view), its elements
+*    are converted by @iface when they are accessed through value_type_at, while
+*    value_to_array converts the remaining ones and detaches @source from the array
+*
+*  @param[in] source
+*    Foreign object, the array owns it on success and releases it with @iface
+*
+*  @param[in] size
+*    Number of elements contained in the array
+*
+*  @param[in] iface
+*    Interface for converting the elements of @source
+*
+*  @return
+*    Pointer to value if success, null otherwhise
+*/
+REFLECT_API value value_create_array_view(void *source, size_t size, value_view_interface iface);
+
+/**
+*  @brief
+*    Create a value map backed by the foreign object @source (a view), its tuples
+*    are converted by @iface when they are accessed through value_type_at or
+*    value_type_find, while value_to_map converts the remaining ones and detaches
+*    @source from the map
+*
+*  @param[in] source
+*    Foreign object, the map owns it on success and releases it with @iface
+*
+*  @param[in] size
+*    Number of elements contained in the map
+*
+*  @param[in] iface
+*    Interface for converting the tuples of @source
+*
+*  @return
+*    Pointer to value if success, null otherwhise
+*/
+REFLECT_API value value_create_map_view(void *source, size_t size, value_view_interface iface);
+
 /**
 *  @brief
 *    Create a value from pointer @ptr
@@ -511,7 +648,8 @@ REFLECT_API void *value_to_buffer(value v);
 
 /**
 *  @brief
-*    Convert value @v to array of values
+*    Convert value @v to array of values, if @v is a view all its
+*    elements are converted and it is not backed by a view anymore
 *
 *  @param[in] v
 *    Reference to the value
@@ -523,7 +661,8 @@ REFLECT_API value *value_to_array(value v);
 
 /**
 *  @brief
-*    Convert value @v to map
+*    Convert value @v to map, if @v is a view all its tuples
+*    are converted and it is not backed by a view anymore
 *
 *  @param[in] v
 *    Reference to the value
@@ -924,6 +1063,17 @@ REFLECT_API value value_from_exception(value v, exception ex);
 */
 REFLECT_API value value_from_throwable(value v, throwable th);
 
+/**
+*  @brief
+*    Run the finalizers of the values reserved from @allocator by the current
+*    thread that are still alive and release the functions, classes, objects,
+*    futures, exceptions and throwables held by them (see value_allocator_finalize)
+*
+*  @param[in] allocator
+*    Allocator whose values are going to be released
+*/
+REFLECT_API void value_type_allocator_finalize(memory_allocator allocator);
+
 /**
 *  @brief
 *    Destroy recursively a value type @v
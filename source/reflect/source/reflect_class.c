@@ -18,6 +18,7 @@
  *
  */
 
+#include <adt/adt_intern.h>
 #include <adt/adt_map.h>
 #include <adt/adt_set.h>
 #include <adt/adt_vector.h>
@@ -38,7 +39,7 @@
 
 struct class_type
 {
-	char *name;
+	const char *name;
 	enum accessor_type_id accessor;
 	class_impl impl;
 	class_interface interface;
@@ -86,9 +87,7 @@ klass class_create(const char *name, enum accessor_type_id accessor, class_impl
 
 	if (name != NULL)
 	{
-		size_t cls_name_size = strlen(name) + 1;
-
-		cls->name = malloc(sizeof(char) * cls_name_size);
+		cls->name = intern_str(name);
 
 		if (cls->name == NULL)
 		{
@@ -98,8 +97,6 @@ klass class_create(const char *name, enum accessor_type_id accessor, class_impl
 
 			return NULL;
 		}
-
-		memcpy(cls->name, name, cls_name_size);
 	}
 	else
 	{
@@ -122,7 +119,6 @@ klass class_create(const char *name, enum accessor_type_id accessor, class_impl
 		{
 			log_write("metacall", LOG_LEVEL_ERROR, "Invalid class (%s) create callback <%p>", cls->name, cls->interface->create);
 
-			free(cls->name);
 			vector_destroy(cls->constructors);
 			map_destroy(cls->methods);
 			map_destroy(cls->static_methods);
@@ -173,6 +169,16 @@ int class_decrement_reference(klass cls)
 	return 0;
 }
 
+size_t class_reference_count(klass cls)
+{
+	if (cls == NULL)
+	{
+		return 0;
+	}
+
+	return (size_t)threading_atomic_ref_count_load(&cls->ref);
+}
+
 class_impl class_impl_get(klass cls)
 {
 	return cls->impl;
@@ -871,11 +877,6 @@ void class_destroy(klass cls)
 				cls->interface->destroy(cls, cls->impl);
 			}
 
-			if (cls->name != NULL)
-			{
-				free(cls->name);
-			}
-
 			if (cls->constructors != NULL)
 			{
 				vector_destroy(cls->constructors);
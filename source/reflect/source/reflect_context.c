@@ -97,6 +97,16 @@ int context_remove(context dest, context src)
 	return scope_remove(dest->sp, src->sp);
 }
 
+int context_replace(context dest, context old_ctx, context new_ctx, char **duplicated)
+{
+	return scope_replace(dest->sp, old_ctx->sp, new_ctx->sp, duplicated);
+}
+
+size_t context_references(context ctx)
+{
+	return scope_references(ctx->sp);
+}
+
 void context_destroy(context ctx)
 {
 	if (ctx != NULL)
@@ -25,6 +25,10 @@
 
 #include <reflect/reflect_memory_tracker.h>
 
+#include <threading/threading_atomic.h>
+
+#include <adt/adt_intern.h>
+
 #include <log/log.h>
 
 #include <stdlib.h>
@@ -32,20 +36,55 @@
 
 struct function_type
 {
-	char *name;
+	const char *name;
 	signature s;
 	function_impl impl;
 	function_interface interface;
 	struct threading_atomic_ref_count_type ref;
 	enum async_id async;
 	void *data;
+	atomic_uintptr_t metrics; /**< Call metrics, created on the first call once metrics are enabled */
+};
+
+struct function_instrument_await_type
+{
+	function func;
+	metrics m;
+	uint64_t start;
+	function_trace_interface trace;
+	struct function_trace_span_type span;
+	function_resolve_callback resolve_callback;
+	function_reject_callback reject_callback;
+	void *context;
+	atomic_flag callback; /**< Claimed by the callback which runs, or by the caller when the await fails without calling any */
+	atomic_uint references;
 };
 
+typedef struct function_instrument_await_type *function_instrument_await;
+
 reflect_memory_tracker(function_stats);
 
+/* Metrics and tracing are opt-in, while both are disabled function_call only pays for reading these flags */
+#define FUNCTION_INSTRUMENT_METRICS 0x01
+#define FUNCTION_INSTRUMENT_TRACE	0x02
+
+static atomic_int function_instrument_flags = 0;
+
+static atomic_uintptr_t function_trace_iface = 0;
+
 static value function_metadata_name(function func);
 static value function_metadata_async(function func);
 static value function_metadata_signature(function func);
+static value function_metadata_metrics(function func);
+static metrics function_metrics_instance(function func);
+static int function_instrument_error(value v);
+static function_return function_call_instrument(function func, function_args args, size_t size, int flags);
+static function_return function_await_instrument(function func, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context, int flags);
+static void function_instrument_await_finish(function_instrument_await await_ctx, int error);
+static value function_instrument_await_callback(function_instrument_await await_ctx, value v, int error, function_resolve_callback callback);
+static value function_instrument_await_resolve(value v, void *data);
+static value function_instrument_await_reject(value v, void *data);
+static void function_instrument_await_release(function_instrument_await await_ctx);
 
 function function_create(const char *name, size_t args_count, function_impl impl, function_impl_interface_singleton singleton)
 {
@@ -58,9 +97,8 @@ function function_create(const char *name, size_t args_count, function_impl impl
 
 	if (name != NULL)
 	{
-		size_t func_name_size = strlen(name) + 1;
-
-		func->name = malloc(sizeof(char) * func_name_size);
+		/* Names are interned so the scope lookups do not need to hash them again */
+		func->name = intern_str(name);
 
 		if (func->name == NULL)
 		{
@@ -70,8 +108,6 @@ function function_create(const char *name, size_t args_count, function_impl impl
 
 			return NULL;
 		}
-
-		memcpy(func->name, name, func_name_size);
 	}
 	else
 	{
@@ -82,6 +118,8 @@ function function_create(const char *name, size_t args_count, function_impl impl
 	func->async = SYNCHRONOUS;
 	func->data = NULL;
 
+	atomic_store_explicit(&func->metrics, (uintptr_t)NULL, memory_order_relaxed);
+
 	func->s = signature_create(args_count);
 
 	if (func->s == NULL)
@@ -110,7 +148,6 @@ function function_create(const char *name, size_t args_count, function_impl impl
 	return func;
 
 function_create_error:
-	free(func->name);
 	free(func);
 
 	return NULL;
@@ -150,6 +187,16 @@ int function_decrement_reference(function func)
 	return 0;
 }
 
+size_t function_reference_count(function func)
+{
+	if (func == NULL)
+	{
+		return 0;
+	}
+
+	return (size_t)threading_atomic_ref_count_load(&func->ref);
+}
+
 void function_async(function func, enum async_id async)
 {
 	func->async = async;
@@ -303,9 +350,54 @@ value function_metadata_signature(function func)
 	return sig;
 }
 
+value function_metadata_metrics(function func)
+{
+	static const char metrics_str[] = "metrics";
+
+	struct metrics_snapshot_type snapshot;
+	value *v_ptr, v;
+	metrics m = function_metrics(func);
+
+	if (m == NULL)
+	{
+		return NULL;
+	}
+
+	v = value_create_array(NULL, 2);
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	v_ptr = value_to_array(v);
+
+	v_ptr[0] = value_create_string(metrics_str, sizeof(metrics_str) - 1);
+
+	if (v_ptr[0] == NULL)
+	{
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	memset(&snapshot, 0, sizeof(struct metrics_snapshot_type));
+
+	metrics_collect(m, &snapshot);
+
+	v_ptr[1] = metrics_value(&snapshot);
+
+	if (v_ptr[1] == NULL)
+	{
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	return v;
+}
+
 value function_metadata(function func)
 {
-	value name, sig, async, f;
+	value name, sig, async, metrics_v, f;
 	value *f_map;
 
 	/* Create function name array */
@@ -332,8 +424,11 @@ value function_metadata(function func)
 		goto error_async;
 	}
 
-	/* Create function map (name + signature + async) */
-	f = value_create_map(NULL, 3);
+	/* Create function metrics array, only present if the function has been called with metrics enabled */
+	metrics_v = function_metadata_metrics(func);
+
+	/* Create function map (name + signature + async + metrics) */
+	f = value_create_map(NULL, metrics_v == NULL ? 3 : 4);
 
 	if (f == NULL)
 	{
@@ -346,9 +441,15 @@ value function_metadata(function func)
 	f_map[1] = sig;
 	f_map[2] = async;
 
+	if (metrics_v != NULL)
+	{
+		f_map[3] = metrics_v;
+	}
+
 	return f;
 
 error_function:
+	value_type_destroy(metrics_v);
 	value_type_destroy(async);
 error_async:
 	value_type_destroy(sig);
@@ -601,7 +702,213 @@ function_return function_call(function func, function_args args, size_t size)
 	#endif
 	*/
 
-	return func->interface->invoke(func, func->impl, args, size);
+	function_return ret;
+	int flags;
+
+	/* Keep a reference while the call is in flight, so the owner of the function can
+	* defer its destruction (i.e. when it is replaced by a reload) without locking here
+	*/
+	threading_atomic_ref_count_increment(&func->ref);
+
+	flags = atomic_load_explicit(&function_instrument_flags, memory_order_relaxed);
+
+	if (flags != 0)
+	{
+		ret = function_call_instrument(func, args, size, flags);
+	}
+	else
+	{
+		ret = func->interface->invoke(func, func->impl, args, size);
+	}
+
+	threading_atomic_ref_count_decrement(&func->ref);
+
+	return ret;
+}
+
+function_return function_call_instrument(function func, function_args args, size_t size, int flags)
+{
+	struct function_trace_span_type span;
+	function_trace_interface trace = NULL;
+	metrics m = NULL;
+	uint64_t start = 0;
+	function_return ret;
+	int error;
+
+	if (flags & FUNCTION_INSTRUMENT_METRICS)
+	{
+		m = function_metrics_instance(func);
+
+		if (m != NULL)
+		{
+			start = metrics_begin(m);
+		}
+	}
+
+	if (flags & FUNCTION_INSTRUMENT_TRACE)
+	{
+		trace = (function_trace_interface)atomic_load_explicit(&function_trace_iface, memory_order_acquire);
+
+		if (trace != NULL)
+		{
+			span.async = 0;
+			trace->begin(func, &span);
+		}
+	}
+
+	ret = func->interface->invoke(func, func->impl, args, size);
+
+	error = function_instrument_error(ret);
+
+	if (trace != NULL)
+	{
+		trace->swap(span.previous);
+		trace->end(func, &span, error);
+	}
+
+	if (m != NULL)
+	{
+		metrics_end(m, start, error);
+	}
+
+	return ret;
+}
+
+void function_instrument_await_finish(function_instrument_await await_ctx, int error)
+{
+	if (await_ctx->m != NULL)
+	{
+		metrics_end(await_ctx->m, await_ctx->start, error);
+	}
+
+	if (await_ctx->trace != NULL)
+	{
+		await_ctx->trace->end(await_ctx->func, &await_ctx->span, error);
+	}
+}
+
+value function_instrument_await_callback(function_instrument_await await_ctx, value v, int error, function_resolve_callback callback)
+{
+	function_trace_span previous = NULL;
+	value ret;
+
+	/* Only one of the callbacks is called, and only once */
+	if (atomic_flag_test_and_set(&await_ctx->callback) != 0)
+	{
+		return NULL;
+	}
+
+	function_instrument_await_finish(await_ctx, error);
+
+	/* The continuation may run in another thread, calls done from it are children of the await span */
+	if (await_ctx->trace != NULL)
+	{
+		previous = await_ctx->trace->swap(&await_ctx->span);
+	}
+
+	ret = callback != NULL ? callback(v, await_ctx->context) : NULL;
+
+	if (await_ctx->trace != NULL)
+	{
+		await_ctx->trace->swap(previous);
+	}
+
+	function_instrument_await_release(await_ctx);
+
+	return ret;
+}
+
+value function_instrument_await_resolve(value v, void *data)
+{
+	function_instrument_await await_ctx = (function_instrument_await)data;
+
+	return function_instrument_await_callback(await_ctx, v, 0, await_ctx->resolve_callback);
+}
+
+value function_instrument_await_reject(value v, void *data)
+{
+	function_instrument_await await_ctx = (function_instrument_await)data;
+
+	return function_instrument_await_callback(await_ctx, v, 1, await_ctx->reject_callback);
+}
+
+void function_instrument_await_release(function_instrument_await await_ctx)
+{
+	if (atomic_fetch_sub_explicit(&await_ctx->references, 1, memory_order_acq_rel) == 1)
+	{
+		/* Release the reference to the function, it may have been destroyed while the await was pending */
+		function_destroy(await_ctx->func);
+
+		free(await_ctx);
+	}
+}
+
+function_return function_await_instrument(function func, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context, int flags)
+{
+	function_instrument_await await_ctx = malloc(sizeof(struct function_instrument_await_type));
+	function_return ret;
+
+	if (await_ctx == NULL)
+	{
+		return func->interface->await(func, func->impl, args, size, resolve_callback, reject_callback, context);
+	}
+
+	await_ctx->func = func;
+	await_ctx->m = (flags & FUNCTION_INSTRUMENT_METRICS) ? function_metrics_instance(func) : NULL;
+	await_ctx->trace = (flags & FUNCTION_INSTRUMENT_TRACE) ? (function_trace_interface)atomic_load_explicit(&function_trace_iface, memory_order_acquire) : NULL;
+	await_ctx->resolve_callback = resolve_callback;
+	await_ctx->reject_callback = reject_callback;
+	await_ctx->context = context;
+	atomic_flag_clear(&await_ctx->callback);
+
+	if (await_ctx->m == NULL && await_ctx->trace == NULL)
+	{
+		free(await_ctx);
+
+		return func->interface->await(func, func->impl, args, size, resolve_callback, reject_callback, context);
+	}
+
+	/* The span and the metrics refer to the function until the await is resolved, so keep it alive meanwhile */
+	if (function_increment_reference(func) != 0)
+	{
+		free(await_ctx);
+
+		return func->interface->await(func, func->impl, args, size, resolve_callback, reject_callback, context);
+	}
+
+	/* One reference for the caller and one for the callbacks, the callbacks may run before the await returns */
+	atomic_store_explicit(&await_ctx->references, 2, memory_order_relaxed);
+
+	if (await_ctx->m != NULL)
+	{
+		await_ctx->start = metrics_begin(await_ctx->m);
+	}
+
+	if (await_ctx->trace != NULL)
+	{
+		await_ctx->span.async = 1;
+		await_ctx->trace->begin(func, &await_ctx->span);
+	}
+
+	ret = func->interface->await(func, func->impl, args, size, &function_instrument_await_resolve, &function_instrument_await_reject, await_ctx);
+
+	/* The await span remains open until it is resolved, but this thread continues with its parent */
+	if (await_ctx->trace != NULL)
+	{
+		await_ctx->trace->swap(await_ctx->span.previous);
+	}
+
+	/* If the await fails without calling any callback (loaders do not call them once they return NULL), the
+	* caller releases the reference of the callbacks too; if a callback already ran, it has released its own */
+	if (ret == NULL && atomic_flag_test_and_set(&await_ctx->callback) == 0)
+	{
+		function_instrument_await_finish(await_ctx, 1);
+		function_instrument_await_release(await_ctx);
+	}
+
+	function_instrument_await_release(await_ctx);
+
+	return ret;
 }
 
 function_return function_await(function func, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context)
@@ -623,13 +930,115 @@ function_return function_await(function func, function_args args, size_t size, f
 			}
 			*/
 
-			return func->interface->await(func, func->impl, args, size, resolve_callback, reject_callback, context);
+			function_return ret;
+			int flags;
+
+			/* The loaders which settle the await later on hold their own reference to the function */
+			threading_atomic_ref_count_increment(&func->ref);
+
+			flags = atomic_load_explicit(&function_instrument_flags, memory_order_relaxed);
+
+			if (flags != 0)
+			{
+				ret = function_await_instrument(func, args, size, resolve_callback, reject_callback, context, flags);
+			}
+			else
+			{
+				ret = func->interface->await(func, func->impl, args, size, resolve_callback, reject_callback, context);
+			}
+
+			threading_atomic_ref_count_decrement(&func->ref);
+
+			return ret;
 		}
 	}
 
 	return NULL;
 }
 
+metrics function_metrics_instance(function func)
+{
+	uintptr_t expected = (uintptr_t)NULL;
+	uintptr_t current = atomic_load_explicit(&func->metrics, memory_order_acquire);
+	metrics m;
+
+	if (current != (uintptr_t)NULL)
+	{
+		return (metrics)current;
+	}
+
+	m = metrics_create();
+
+	if (m == NULL)
+	{
+		return NULL;
+	}
+
+	/* Another thread may have created the metrics meanwhile, keep the first one */
+	if (atomic_compare_exchange_strong_explicit(&func->metrics, &expected, (uintptr_t)m, memory_order_acq_rel, memory_order_acquire) == 0)
+	{
+		metrics_destroy(m);
+
+		return (metrics)expected;
+	}
+
+	return m;
+}
+
+int function_instrument_error(value v)
+{
+	if (v != NULL)
+	{
+		type_id id = value_type_id(v);
+
+		return type_id_throwable(id) == 0 || type_id_exception(id) == 0;
+	}
+
+	return 0;
+}
+
+void function_metrics_enable(int enable)
+{
+	if (enable != 0)
+	{
+		atomic_fetch_or_explicit(&function_instrument_flags, FUNCTION_INSTRUMENT_METRICS, memory_order_relaxed);
+	}
+	else
+	{
+		atomic_fetch_and_explicit(&function_instrument_flags, ~FUNCTION_INSTRUMENT_METRICS, memory_order_relaxed);
+	}
+}
+
+int function_metrics_enabled(void)
+{
+	return (atomic_load_explicit(&function_instrument_flags, memory_order_relaxed) & FUNCTION_INSTRUMENT_METRICS) != 0;
+}
+
+void function_trace(function_trace_interface iface)
+{
+	if (iface != NULL)
+	{
+		/* Publish the interface before enabling the flag, so calls never see the flag without it */
+		atomic_store_explicit(&function_trace_iface, (uintptr_t)iface, memory_order_release);
+		atomic_fetch_or_explicit(&function_instrument_flags, FUNCTION_INSTRUMENT_TRACE, memory_order_release);
+	}
+	else
+	{
+		atomic_fetch_and_explicit(&function_instrument_flags, ~FUNCTION_INSTRUMENT_TRACE, memory_order_release);
+		atomic_store_explicit(&function_trace_iface, (uintptr_t)NULL, memory_order_release);
+	}
+}
+
+metrics function_metrics(function func)
+{
+	if (func == NULL)
+	{
+		return NULL;
+	}
+
+	return (metrics)atomic_load_explicit(&func->metrics, memory_order_acquire);
+}
+
 void function_stats_debug(void)
 {
 	reflect_memory_tracker_print(function_stats, "FUNCTIONS");
@@ -726,13 +1135,10 @@ void function_destroy(function func)
 
 			signature_destroy(func->s);
 
-			if (func->name != NULL)
-			{
-				free(func->name);
-			}
-
 			threading_atomic_ref_count_destroy(&func->ref);
 
+			metrics_destroy(function_metrics(func));
+
 			free(func);
 
 			reflect_memory_tracker_deallocation(function_stats);
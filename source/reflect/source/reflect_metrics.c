@@ -0,0 +1,428 @@
+/*
+ *	Reflect Library by Parra Studios
+ *	A library for provide reflection and metadata representation.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+*/
+
+/* -- Headers -- */
+
+#include <reflect/reflect_metrics.h>
+#include <reflect/reflect_value_type.h>
+
+#include <threading/threading_atomic.h>
+
+#include <log/log.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32) || \
+	defined(__CYGWIN__) || defined(__CYGWIN32__) || \
+	defined(__MINGW32__) || defined(__MINGW64__)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+/* -- Definitions -- */
+
+#if defined(_MSC_VER)
+	#define METRICS_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+	#define METRICS_THREAD_LOCAL __thread
+#else
+	#define METRICS_THREAD_LOCAL _Thread_local
+#endif
+
+/* Number of shards per function, threads are assigned to them in round robin */
+#define METRICS_SHARD_SIZE 8
+
+/* Counters of a shard followed by padding up to a multiple of the cache line size */
+#define METRICS_SHARD_COUNTERS (4 + METRICS_HISTOGRAM_SIZE)
+#define METRICS_SHARD_PADDING (8 - (METRICS_SHARD_COUNTERS % 8))
+
+/* -- Member Data -- */
+
+struct metrics_shard_type
+{
+	atomic_uintmax_t started;
+	atomic_uintmax_t finished;
+	atomic_uintmax_t errors;
+	atomic_uintmax_t total;
+	atomic_uintmax_t histogram[METRICS_HISTOGRAM_SIZE];
+	uintmax_t padding[METRICS_SHARD_PADDING];
+};
+
+struct metrics_type
+{
+	struct metrics_shard_type shards[METRICS_SHARD_SIZE];
+};
+
+/* -- Private Member Data -- */
+
+static atomic_size_t metrics_shard_counter = 0;
+
+/* Index of the shard used by the current thread plus one, zero if not assigned yet */
+static METRICS_THREAD_LOCAL size_t metrics_shard_index = 0;
+
+/* -- Private Methods -- */
+
+static struct metrics_shard_type *metrics_shard(metrics m)
+{
+	if (metrics_shard_index == 0)
+	{
+		metrics_shard_index = (atomic_fetch_add_explicit(&metrics_shard_counter, 1, memory_order_relaxed) % METRICS_SHARD_SIZE) + 1;
+	}
+
+	return &m->shards[metrics_shard_index - 1];
+}
+
+static size_t metrics_log2(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return (size_t)(63 - __builtin_clzll(v));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long index;
+
+	_BitScanReverse64(&index, v);
+
+	return (size_t)index;
+#else
+	size_t e = 0;
+
+	while (v >>= 1)
+	{
+		++e;
+	}
+
+	return e;
+#endif
+}
+
+static size_t metrics_histogram_index(uint64_t v)
+{
+	size_t e;
+
+	if (v < METRICS_HISTOGRAM_SUB_SIZE)
+	{
+		return (size_t)v;
+	}
+
+	e = metrics_log2(v);
+
+	if (e >= (METRICS_HISTOGRAM_SIZE / METRICS_HISTOGRAM_SUB_SIZE) + 1)
+	{
+		return METRICS_HISTOGRAM_SIZE - 1;
+	}
+
+	return (e - 1) * METRICS_HISTOGRAM_SUB_SIZE + (size_t)((v >> (e - METRICS_HISTOGRAM_SUB_BITS)) & (METRICS_HISTOGRAM_SUB_SIZE - 1));
+}
+
+static value metrics_value_tuple(const char *key, value v)
+{
+	value *v_array, tuple;
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	tuple = value_create_array(NULL, 2);
+
+	if (tuple == NULL)
+	{
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	v_array = value_to_array(tuple);
+
+	v_array[0] = value_create_string(key, strlen(key));
+
+	if (v_array[0] == NULL)
+	{
+		value_type_destroy(v);
+		value_type_destroy(tuple);
+		return NULL;
+	}
+
+	v_array[1] = v;
+
+	return tuple;
+}
+
+static value metrics_value_histogram(metrics_snapshot snapshot)
+{
+	value *v_array, v;
+	size_t iterator, size = 0;
+
+	for (iterator = 0; iterator < METRICS_HISTOGRAM_SIZE; ++iterator)
+	{
+		if (snapshot->histogram[iterator] != 0)
+		{
+			++size;
+		}
+	}
+
+	v = value_create_array(NULL, size);
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	v_array = value_to_array(v);
+
+	for (iterator = 0, size = 0; iterator < METRICS_HISTOGRAM_SIZE; ++iterator)
+	{
+		if (snapshot->histogram[iterator] != 0)
+		{
+			value *bucket_array, bucket = value_create_array(NULL, 2);
+
+			if (bucket == NULL)
+			{
+				value_type_destroy(v);
+				return NULL;
+			}
+
+			v_array[size++] = bucket;
+
+			bucket_array = value_to_array(bucket);
+
+			bucket_array[0] = value_create_long((long)metrics_histogram_bound(iterator));
+			bucket_array[1] = value_create_long((long)snapshot->histogram[iterator]);
+
+			if (bucket_array[0] == NULL || bucket_array[1] == NULL)
+			{
+				value_type_destroy(v);
+				return NULL;
+			}
+		}
+	}
+
+	return v;
+}
+
+/* -- Methods -- */
+
+metrics metrics_create(void)
+{
+	metrics m = malloc(sizeof(struct metrics_type));
+
+	if (m == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid metrics allocation");
+		return NULL;
+	}
+
+	memset(m, 0, sizeof(struct metrics_type));
+
+	return m;
+}
+
+uint64_t metrics_time(void)
+{
+#if defined(WIN32) || defined(_WIN32) || \
+	defined(__CYGWIN__) || defined(__CYGWIN32__) || \
+	defined(__MINGW32__) || defined(__MINGW64__)
+	static LARGE_INTEGER frequency = { 0 };
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+
+	QueryPerformanceCounter(&counter);
+
+	/* Split the conversion to avoid overflowing the multiplication */
+	return (uint64_t)((counter.QuadPart / frequency.QuadPart) * 1000000000) +
+		   (uint64_t)(((counter.QuadPart % frequency.QuadPart) * 1000000000) / frequency.QuadPart);
+#else
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+	{
+		return 0;
+	}
+
+	return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+uint64_t metrics_begin(metrics m)
+{
+	struct metrics_shard_type *shard = metrics_shard(m);
+
+	atomic_fetch_add_explicit(&shard->started, 1, memory_order_relaxed);
+
+	return metrics_time();
+}
+
+void metrics_end(metrics m, uint64_t start, int error)
+{
+	uint64_t end = metrics_time();
+	uint64_t elapsed = end > start ? end - start : 0;
+	struct metrics_shard_type *shard = metrics_shard(m);
+
+	atomic_fetch_add_explicit(&shard->histogram[metrics_histogram_index(elapsed)], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&shard->total, elapsed, memory_order_relaxed);
+
+	if (error != 0)
+	{
+		atomic_fetch_add_explicit(&shard->errors, 1, memory_order_relaxed);
+	}
+
+	atomic_fetch_add_explicit(&shard->finished, 1, memory_order_relaxed);
+}
+
+void metrics_collect(metrics m, metrics_snapshot snapshot)
+{
+	uint64_t started = 0, finished = 0;
+	size_t shard, iterator;
+
+	for (shard = 0; shard < METRICS_SHARD_SIZE; ++shard)
+	{
+		struct metrics_shard_type *s = &m->shards[shard];
+
+		finished += atomic_load_explicit(&s->finished, memory_order_relaxed);
+		started += atomic_load_explicit(&s->started, memory_order_relaxed);
+		snapshot->errors += atomic_load_explicit(&s->errors, memory_order_relaxed);
+		snapshot->total += atomic_load_explicit(&s->total, memory_order_relaxed);
+
+		for (iterator = 0; iterator < METRICS_HISTOGRAM_SIZE; ++iterator)
+		{
+			snapshot->histogram[iterator] += atomic_load_explicit(&s->histogram[iterator], memory_order_relaxed);
+		}
+	}
+
+	/* A call can start and finish in different shards, so the difference may be
+	* transiently negative while the shards are read, in that case clamp it to zero
+	*/
+	snapshot->calls += started > finished ? started : finished;
+	snapshot->in_flight += started > finished ? started - finished : 0;
+}
+
+uint64_t metrics_histogram_bound(size_t index)
+{
+	size_t e, m;
+
+	if (index < METRICS_HISTOGRAM_SUB_SIZE)
+	{
+		return (uint64_t)index;
+	}
+
+	e = index / METRICS_HISTOGRAM_SUB_SIZE + 1;
+	m = index % METRICS_HISTOGRAM_SUB_SIZE;
+
+	return ((uint64_t)(METRICS_HISTOGRAM_SUB_SIZE + m + 1) << (e - METRICS_HISTOGRAM_SUB_BITS)) - 1;
+}
+
+uint64_t metrics_quantile(metrics_snapshot snapshot, double q)
+{
+	uint64_t count = 0, accumulated = 0, target;
+	size_t iterator;
+
+	for (iterator = 0; iterator < METRICS_HISTOGRAM_SIZE; ++iterator)
+	{
+		count += snapshot->histogram[iterator];
+	}
+
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	if (q < 0.0)
+	{
+		q = 0.0;
+	}
+	else if (q > 1.0)
+	{
+		q = 1.0;
+	}
+
+	/* Rank of the sample, starting at one */
+	target = (uint64_t)(q * (double)count);
+
+	if ((double)target < q * (double)count || target == 0)
+	{
+		++target;
+	}
+
+	for (iterator = 0; iterator < METRICS_HISTOGRAM_SIZE; ++iterator)
+	{
+		accumulated += snapshot->histogram[iterator];
+
+		if (accumulated >= target)
+		{
+			return metrics_histogram_bound(iterator);
+		}
+	}
+
+	return metrics_histogram_bound(METRICS_HISTOGRAM_SIZE - 1);
+}
+
+value metrics_value(metrics_snapshot snapshot)
+{
+	value *v_map, v = value_create_map(NULL, 8);
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	v_map = value_to_map(v);
+
+	v_map[0] = metrics_value_tuple("calls", value_create_long((long)snapshot->calls));
+	v_map[1] = metrics_value_tuple("errors", value_create_long((long)snapshot->errors));
+	v_map[2] = metrics_value_tuple("in_flight", value_create_long((long)snapshot->in_flight));
+	v_map[3] = metrics_value_tuple("total_ns", value_create_long((long)snapshot->total));
+	v_map[4] = metrics_value_tuple("p50_ns", value_create_long((long)metrics_quantile(snapshot, 0.50)));
+	v_map[5] = metrics_value_tuple("p90_ns", value_create_long((long)metrics_quantile(snapshot, 0.90)));
+	v_map[6] = metrics_value_tuple("p99_ns", value_create_long((long)metrics_quantile(snapshot, 0.99)));
+	v_map[7] = metrics_value_tuple("histogram", metrics_value_histogram(snapshot));
+
+	if (v_map[0] == NULL || v_map[1] == NULL || v_map[2] == NULL || v_map[3] == NULL ||
+		v_map[4] == NULL || v_map[5] == NULL || v_map[6] == NULL || v_map[7] == NULL)
+	{
+		value_type_destroy(v);
+		return NULL;
+	}
+
+	return v;
+}
+
+void metrics_destroy(metrics m)
+{
+	if (m != NULL)
+	{
+		free(m);
+	}
+}
@@ -139,6 +139,16 @@ int object_decrement_reference(object obj)
 	return 0;
 }
 
+size_t object_reference_count(object obj)
+{
+	if (obj == NULL)
+	{
+		return 0;
+	}
+
+	return (size_t)threading_atomic_ref_count_load(&obj->ref);
+}
+
 object_impl object_impl_get(object obj)
 {
 	return obj->impl;
@@ -22,9 +22,12 @@
 #include <reflect/reflect_scope.h>
 #include <reflect/reflect_value_type.h>
 
+#include <adt/adt_intern.h>
 #include <adt/adt_set.h>
 #include <adt/adt_vector.h>
 
+#include <threading/threading_atomic.h>
+
 #include <log/log.h>
 
 #include <stdlib.h>
@@ -34,15 +37,24 @@ struct scope_metadata_array_cb_iterator_type;
 
 struct scope_export_cb_iterator_type;
 
+struct scope_replace_cb_iterator_type;
+
+struct scope_metrics_cb_iterator_type;
+
 typedef struct scope_metadata_array_cb_iterator_type *scope_metadata_array_cb_iterator;
 
 typedef struct scope_export_cb_iterator_type *scope_export_cb_iterator;
 
+typedef struct scope_replace_cb_iterator_type *scope_replace_cb_iterator;
+
+typedef struct scope_metrics_cb_iterator_type *scope_metrics_cb_iterator;
+
 struct scope_type
 {
-	char *name;		   /**< Scope name */
-	set objects;	   /**< Map of scope objects indexed by name string */
-	vector call_stack; /**< Scope call stack */
+	char *name;				  /**< Scope name */
+	atomic_uintptr_t objects; /**< Map of scope objects indexed by name string */
+	vector retired;			  /**< Maps replaced by scope_replace, they are kept until destroy because lookups do not lock */
+	vector call_stack;		  /**< Scope call stack */
 };
 
 struct scope_metadata_array_cb_iterator_type
@@ -62,6 +74,22 @@ struct scope_export_cb_iterator_type
 	value *values;
 };
 
+struct scope_metrics_cb_iterator_type
+{
+	size_t iterator;
+	size_t size;
+	value *values;
+	metrics_snapshot total;
+};
+
+struct scope_replace_cb_iterator_type
+{
+	set objects;
+	set other;
+	char *duplicated;
+	int result;
+};
+
 static int scope_metadata_array_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
 
 static int scope_export_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
@@ -70,6 +98,20 @@ static int scope_metadata_array(scope sp, value v_array[3]);
 
 static value scope_metadata_name(scope sp);
 
+static int scope_metrics_cb_iterate_counter(set s, set_key key, set_value val, set_cb_iterate_args args);
+
+static int scope_metrics_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
+
+static set scope_objects(scope sp);
+
+static int scope_replace_check_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
+
+static int scope_replace_insert_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
+
+static int scope_replace_remove_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
+
+static int scope_references_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
+
 static int scope_destroy_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args);
 
 scope scope_create(const char *name)
@@ -97,9 +139,9 @@ scope scope_create(const char *name)
 
 			memcpy(sp->name, name, sp_name_size);
 
-			sp->objects = set_create(&hash_callback_str, &comparable_callback_str);
+			set objects = set_create(&hash_callback_str, &comparable_callback_str);
 
-			if (sp->objects == NULL)
+			if (objects == NULL)
 			{
 				log_write("metacall", LOG_LEVEL_ERROR, "Scope create map bad allocation");
 
@@ -110,13 +152,17 @@ scope scope_create(const char *name)
 				return NULL;
 			}
 
+			atomic_store_explicit(&sp->objects, (uintptr_t)objects, memory_order_relaxed);
+
+			sp->retired = NULL;
+
 			sp->call_stack = vector_create(sizeof(char));
 
 			if (sp->call_stack == NULL)
 			{
 				log_write("metacall", LOG_LEVEL_ERROR, "Scope create call stack bad allocation");
 
-				set_destroy(sp->objects);
+				set_destroy(objects);
 
 				free(sp->name);
 
@@ -131,7 +177,7 @@ scope scope_create(const char *name)
 
 				vector_destroy(sp->call_stack);
 
-				set_destroy(sp->objects);
+				set_destroy(objects);
 
 				free(sp->name);
 
@@ -170,7 +216,7 @@ size_t scope_size(scope sp)
 {
 	if (sp != NULL)
 	{
-		return set_size(sp->objects);
+		return set_size(scope_objects(sp));
 	}
 
 	return 0;
@@ -180,14 +226,25 @@ int scope_define(scope sp, const char *key, value val)
 {
 	if (sp != NULL && key != NULL && val != NULL)
 	{
-		if (set_contains(sp->objects, (set_key)key) == 0)
+		/* Keys are interned so looking them up later on (for example when
+		* merging the scope of a handle into the loader scope) reuses the hash */
+		const char *interned = intern_str(key);
+
+		if (interned == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Scope failed to allocate the key '%s'", key);
+
+			return 1;
+		}
+
+		if (set_contains(scope_objects(sp), (set_key)interned) == 0)
 		{
-			log_write("metacall", LOG_LEVEL_ERROR, "Scope failed to define a object with key '%s', this key as already been defined", (char *)key);
+			log_write("metacall", LOG_LEVEL_ERROR, "Scope failed to define a object with key '%s', this key as already been defined", interned);
 
 			return 1;
 		}
 
-		return set_insert(sp->objects, (set_key)key, (set_value)val);
+		return set_insert(scope_objects(sp), (set_key)interned, (set_value)val);
 	}
 
 	return 1;
@@ -249,7 +306,7 @@ int scope_metadata_array(scope sp, value v_array[3])
 		NULL, NULL, NULL, 0, 0, 0
 	};
 
-	set_iterate(sp->objects, &scope_metadata_array_cb_iterate_counter, (set_cb_iterate_args)&metadata_iterator);
+	set_iterate(scope_objects(sp), &scope_metadata_array_cb_iterate_counter, (set_cb_iterate_args)&metadata_iterator);
 
 	value functions_val = value_create_array(NULL, metadata_iterator.functions_size);
 
@@ -286,7 +343,7 @@ int scope_metadata_array(scope sp, value v_array[3])
 	metadata_iterator.functions_size = 0;
 	metadata_iterator.objects_size = 0;
 
-	set_iterate(sp->objects, &scope_metadata_array_cb_iterate, (set_cb_iterate_args)&metadata_iterator);
+	set_iterate(scope_objects(sp), &scope_metadata_array_cb_iterate, (set_cb_iterate_args)&metadata_iterator);
 
 	v_array[0] = functions_val;
 	v_array[1] = classes_val;
@@ -434,16 +491,130 @@ value scope_export(scope sp)
 	export_iterator.iterator = 0;
 	export_iterator.values = value_to_map(export);
 
-	set_iterate(sp->objects, &scope_export_cb_iterate, (set_cb_iterate_args)&export_iterator);
+	set_iterate(scope_objects(sp), &scope_export_cb_iterate, (set_cb_iterate_args)&export_iterator);
 
 	return export;
 }
 
+int scope_metrics_cb_iterate_counter(set s, set_key key, set_value val, set_cb_iterate_args args)
+{
+	scope_metrics_cb_iterator metrics_iterator = (scope_metrics_cb_iterator)args;
+
+	(void)s;
+	(void)key;
+
+	if (value_type_id(val) == TYPE_FUNCTION && function_metrics(value_to_function(val)) != NULL)
+	{
+		++metrics_iterator->iterator;
+	}
+
+	return 0;
+}
+
+int scope_metrics_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args)
+{
+	scope_metrics_cb_iterator metrics_iterator = (scope_metrics_cb_iterator)args;
+	struct metrics_snapshot_type snapshot;
+	const char *key_str = (const char *)key;
+	value *v_array, v;
+	metrics m;
+
+	(void)s;
+
+	if (value_type_id(val) != TYPE_FUNCTION)
+	{
+		return 0;
+	}
+
+	m = function_metrics(value_to_function(val));
+
+	if (m == NULL)
+	{
+		return 0;
+	}
+
+	/* Metrics of a function may have been created by a call after counting them */
+	if (metrics_iterator->iterator == metrics_iterator->size)
+	{
+		return 1;
+	}
+
+	memset(&snapshot, 0, sizeof(struct metrics_snapshot_type));
+
+	metrics_collect(m, &snapshot);
+	metrics_collect(m, metrics_iterator->total);
+
+	v = value_create_array(NULL, 2);
+
+	if (v == NULL)
+	{
+		return 1;
+	}
+
+	v_array = value_to_array(v);
+
+	v_array[0] = value_create_string(key_str, strlen(key_str));
+	v_array[1] = metrics_value(&snapshot);
+
+	if (v_array[0] == NULL || v_array[1] == NULL)
+	{
+		value_type_destroy(v);
+		return 1;
+	}
+
+	metrics_iterator->values[metrics_iterator->iterator++] = v;
+
+	return 0;
+}
+
+value scope_metrics(scope sp, metrics_snapshot total)
+{
+	struct scope_metrics_cb_iterator_type metrics_iterator = {
+		0, 0, NULL, total
+	};
+
+	value v;
+
+	set_iterate(scope_objects(sp), &scope_metrics_cb_iterate_counter, (set_cb_iterate_args)&metrics_iterator);
+
+	v = value_create_map(NULL, metrics_iterator.iterator);
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	/* Reuse the counter to fill the map */
+	metrics_iterator.size = metrics_iterator.iterator;
+	metrics_iterator.iterator = 0;
+	metrics_iterator.values = value_to_map(v);
+
+	set_iterate(scope_objects(sp), &scope_metrics_cb_iterate, (set_cb_iterate_args)&metrics_iterator);
+
+	/* The functions may have been removed from the scope after counting them, or the iteration stopped on an allocation error */
+	if (metrics_iterator.iterator != metrics_iterator.size)
+	{
+		value shrink = value_create_map(metrics_iterator.values, metrics_iterator.iterator);
+
+		if (shrink == NULL)
+		{
+			value_type_destroy(v);
+			return NULL;
+		}
+
+		value_destroy(v);
+
+		return shrink;
+	}
+
+	return v;
+}
+
 value scope_get(scope sp, const char *key)
 {
 	if (sp != NULL && key != NULL)
 	{
-		return (value)set_get(sp->objects, (set_key)key);
+		return (value)set_get(scope_objects(sp), (set_key)key);
 	}
 
 	return NULL;
@@ -453,7 +624,7 @@ value scope_undef(scope sp, const char *key)
 {
 	if (sp != NULL && key != NULL)
 	{
-		return (value)set_remove(sp->objects, (set_key)key);
+		return (value)set_remove(scope_objects(sp), (set_key)key);
 	}
 
 	return NULL;
@@ -461,17 +632,194 @@ value scope_undef(scope sp, const char *key)
 
 int scope_append(scope dest, scope src)
 {
-	return set_append(dest->objects, src->objects);
+	return set_append(scope_objects(dest), scope_objects(src));
 }
 
 int scope_contains(scope dest, scope src, char **duplicated)
 {
-	return set_contains_which(dest->objects, src->objects, (set_key *)duplicated);
+	return set_contains_which(scope_objects(dest), scope_objects(src), (set_key *)duplicated);
 }
 
 int scope_remove(scope dest, scope src)
 {
-	return set_disjoint(dest->objects, src->objects);
+	return set_disjoint(scope_objects(dest), scope_objects(src));
+}
+
+set scope_objects(scope sp)
+{
+	return (set)atomic_load_explicit(&sp->objects, memory_order_acquire);
+}
+
+int scope_replace_check_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args)
+{
+	scope_replace_cb_iterator replace_iterator = (scope_replace_cb_iterator)args;
+
+	(void)s;
+	(void)val;
+
+	/* A new symbol is duplicated if it was not defined by the old scope but it already exists in the destination */
+	if (set_contains(replace_iterator->other, key) != 0 && set_contains(replace_iterator->objects, key) == 0)
+	{
+		replace_iterator->duplicated = (char *)key;
+		replace_iterator->result = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+int scope_replace_insert_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args)
+{
+	scope_replace_cb_iterator replace_iterator = (scope_replace_cb_iterator)args;
+
+	(void)s;
+
+	if (set_insert(replace_iterator->objects, key, val) != 0)
+	{
+		replace_iterator->result = 1;
+		return 1;
+	}
+
+	return 0;
+}
+
+int scope_replace_remove_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args)
+{
+	scope_replace_cb_iterator replace_iterator = (scope_replace_cb_iterator)args;
+
+	(void)s;
+
+	/* Only remove the symbols which belong to the old scope */
+	if (set_get(replace_iterator->objects, key) == val)
+	{
+		set_remove(replace_iterator->objects, key);
+	}
+
+	return 0;
+}
+
+int scope_replace(scope dest, scope old_sp, scope new_sp, char **duplicated)
+{
+	struct scope_replace_cb_iterator_type replace_iterator;
+	set current;
+
+	if (dest == NULL || old_sp == NULL || new_sp == NULL)
+	{
+		return 1;
+	}
+
+	current = scope_objects(dest);
+
+	replace_iterator.objects = current;
+	replace_iterator.other = scope_objects(old_sp);
+	replace_iterator.duplicated = NULL;
+	replace_iterator.result = 0;
+
+	/* Check the duplicates before building the new map, so the destination is left untouched on error */
+	set_iterate(scope_objects(new_sp), &scope_replace_check_cb_iterate, (set_cb_iterate_args)&replace_iterator);
+
+	if (duplicated != NULL)
+	{
+		*duplicated = replace_iterator.duplicated;
+	}
+
+	if (replace_iterator.result != 0)
+	{
+		return 1;
+	}
+
+	if (dest->retired == NULL)
+	{
+		dest->retired = vector_create_type(set);
+
+		if (dest->retired == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Scope replace retired maps bad allocation");
+
+			return 1;
+		}
+	}
+
+	/* Lookups in the destination do not lock, so the new map is built aside and published at once */
+	replace_iterator.objects = set_create(&hash_callback_str, &comparable_callback_str);
+
+	if (replace_iterator.objects == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Scope replace map bad allocation");
+
+		return 1;
+	}
+
+	set_append(replace_iterator.objects, current);
+
+	set_iterate(scope_objects(old_sp), &scope_replace_remove_cb_iterate, (set_cb_iterate_args)&replace_iterator);
+
+	set_iterate(scope_objects(new_sp), &scope_replace_insert_cb_iterate, (set_cb_iterate_args)&replace_iterator);
+
+	if (replace_iterator.result != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Scope replace failed to insert the new symbols");
+
+		set_destroy(replace_iterator.objects);
+
+		return 1;
+	}
+
+	/* The previous map may still be traversed by a concurrent lookup, so it is released along with the scope */
+	vector_push_back_var(dest->retired, current);
+
+	atomic_store_explicit(&dest->objects, (uintptr_t)replace_iterator.objects, memory_order_release);
+
+	return 0;
+}
+
+int scope_references_cb_iterate(set s, set_key key, set_value val, set_cb_iterate_args args)
+{
+	size_t *references = (size_t *)args;
+	size_t count = 0;
+	value v = (value)val;
+
+	(void)s;
+	(void)key;
+
+	switch (value_type_id(v))
+	{
+		case TYPE_FUNCTION: {
+			count = function_reference_count(value_to_function(v));
+			break;
+		}
+		case TYPE_CLASS: {
+			count = class_reference_count(value_to_class(v));
+			break;
+		}
+		case TYPE_OBJECT: {
+			count = object_reference_count(value_to_object(v));
+			break;
+		}
+		default: {
+			return 0;
+		}
+	}
+
+	/* The value stored in the scope holds one of the references */
+	if (count > 1)
+	{
+		*references += count - 1;
+	}
+
+	return 0;
+}
+
+size_t scope_references(scope sp)
+{
+	size_t references = 0;
+
+	if (sp != NULL)
+	{
+		set_iterate(scope_objects(sp), &scope_references_cb_iterate, (set_cb_iterate_args)&references);
+	}
+
+	return references;
 }
 
 size_t *scope_stack_return(scope sp)
@@ -612,9 +960,21 @@ void scope_destroy(scope sp)
 {
 	if (sp != NULL)
 	{
-		set_iterate(sp->objects, &scope_destroy_cb_iterate, NULL);
+		set_iterate(scope_objects(sp), &scope_destroy_cb_iterate, NULL);
+
+		set_destroy(scope_objects(sp));
 
-		set_destroy(sp->objects);
+		if (sp->retired != NULL)
+		{
+			size_t iterator, size = vector_size(sp->retired);
+
+			for (iterator = 0; iterator < size; ++iterator)
+			{
+				set_destroy(vector_at_type(sp->retired, iterator, set));
+			}
+
+			vector_destroy(sp->retired);
+		}
 
 		vector_destroy(sp->call_stack);
 
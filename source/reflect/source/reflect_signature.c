@@ -21,6 +21,7 @@
 #include <reflect/reflect_signature.h>
 #include <reflect/reflect_value_type.h>
 
+#include <adt/adt_intern.h>
 #include <adt/adt_set.h>
 
 #include <log/log.h>
@@ -33,7 +34,7 @@
 typedef struct signature_node_type
 {
 	size_t index;
-	char *name;
+	const char *name;
 	type t;
 
 } * signature_node;
@@ -219,9 +220,7 @@ void signature_set(signature s, size_t index, const char *name, type t)
 	{
 		signature_node node = signature_at(s, index);
 
-		size_t name_size = strlen(name) + 1;
-
-		char *name_node = malloc(sizeof(char) * name_size);
+		const char *name_node = intern_str(name);
 
 		if (name_node == NULL)
 		{
@@ -230,23 +229,20 @@ void signature_set(signature s, size_t index, const char *name, type t)
 			return;
 		}
 
-		if (node->name != NULL)
+		/* Remove the previous name of the argument, unless another argument owns it */
+		if (node->name != NULL && node->name != name_node && set_get(s->map, (set_key)node->name) == node)
 		{
-			free(node->name);
+			set_remove(s->map, (set_key)node->name);
 		}
 
 		node->name = name_node;
 
-		memcpy(node->name, name, name_size);
-
 		node->t = t;
 
 		node->index = index;
 
 		if (set_insert(s->map, (set_key)node->name, (set_value)node) != 0)
 		{
-			free(node->name);
-
 			node->index = REFLECT_SIGNATURE_INVALID_INDEX;
 			node->name = NULL;
 			node->t = NULL;
@@ -516,18 +512,6 @@ void signature_destroy(signature s)
 {
 	if (s != NULL)
 	{
-		size_t index;
-
-		for (index = 0; index < s->count; ++index)
-		{
-			signature_node node = signature_at(s, index);
-
-			if (node != NULL && node->name != NULL)
-			{
-				free(node->name);
-			}
-		}
-
 		set_destroy(s->map);
 
 		free(s);
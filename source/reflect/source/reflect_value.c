@@ -22,6 +22,12 @@
 
 #include <reflect/reflect_value.h>
 
+#include <adt/adt_vector.h>
+
+#include <log/log.h>
+
+#include <threading/threading_atomic.h>
+
 #include <stdint.h>
 #include <string.h>
 
@@ -29,25 +35,73 @@
 
 struct value_impl_type;
 
+struct value_impl_finalizer_type;
+
+struct value_impl_view_type;
+
 /* -- Type Definitions -- */
 
 typedef struct value_impl_type *value_impl;
 
+typedef struct value_impl_finalizer_type *value_impl_finalizer;
+
+typedef struct value_impl_view_type *value_impl_view;
+
 /* -- Member Data -- */
 
 struct value_impl_type
 {
-	uintptr_t magic;
 	size_t bytes;
-	size_t ref_count;
+	atomic_uint ref_count;
+	uint16_t magic;
+	uint16_t flags;
+};
+
+struct value_impl_finalizer_type
+{
 	value_finalizer_cb finalizer;
 	void *finalizer_data;
 };
 
+struct value_impl_view_type
+{
+	void *source;
+	value_view_interface iface;
+};
+
 /* -- Private Member Data -- */
 
-static const char value_impl_magic_alloc[] = "value_impl_magic_alloc";
-static const char value_impl_magic_free[] = "value_impl_magic_free";
+#define VALUE_IMPL_FLAG_BORROWED 0x01
+#define VALUE_IMPL_FLAG_ALLOCATOR 0x02
+#define VALUE_IMPL_FLAG_FINALIZER 0x04
+#define VALUE_IMPL_FLAG_REFERENCE 0x08
+#define VALUE_IMPL_FLAG_VIEW	  0x10
+
+#if defined(_MSC_VER)
+	#define VALUE_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+	#define VALUE_THREAD_LOCAL __thread
+#else
+	#define VALUE_THREAD_LOCAL _Thread_local
+#endif
+
+/* The header only holds what every value needs, optional parts are stored
+* right before it and are flagged in the header, from the lowest address:
+* allocator (only for scoped values), view (only for values backed by a
+* foreign object), finalizer (all except compact values), header and data
+*/
+#define VALUE_IMPL_ALLOCATOR_SIZE (sizeof(memory_allocator))
+
+#define VALUE_IMPL_MAGIC_ALLOC ((uint16_t)0xA11C)
+#define VALUE_IMPL_MAGIC_FREE ((uint16_t)0xF4EE)
+
+static VALUE_THREAD_LOCAL memory_allocator value_impl_allocator = NULL;
+
+/* Scoped values with a finalizer, they are finalized by value_allocator_finalize if they are not destroyed before */
+static VALUE_THREAD_LOCAL vector value_impl_finalizers = NULL;
+
+/* Scoped values holding a reference, they are released by value_allocator_finalize if they are not destroyed before */
+static VALUE_THREAD_LOCAL vector value_impl_references = NULL;
 
 /* -- Private Methods -- */
 
@@ -63,6 +117,96 @@ static const char value_impl_magic_free[] = "value_impl_magic_free";
 */
 value_impl value_descriptor(value v);
 
+/**
+*  @brief
+*    Size of the optional parts stored before the header
+*
+*  @param[in] flags
+*    Flags of the value header
+*
+*  @return
+*    Size in bytes of the prefix of the value
+*/
+static size_t value_impl_prefix_size(uint16_t flags);
+
+/**
+*  @brief
+*    Access to the finalizer of a value
+*
+*  @param[in] impl
+*    Pointer to the header of a value
+*
+*  @return
+*    Pointer to the finalizer or null if the value is compact
+*/
+static value_impl_finalizer value_impl_finalizer_get(value_impl impl);
+
+/**
+*  @brief
+*    Access to the foreign object of a value
+*
+*  @param[in] impl
+*    Pointer to the header of a value
+*
+*  @return
+*    Pointer to the view or null if the value is not backed by a foreign object
+*/
+static value_impl_view value_impl_view_get(value_impl impl);
+
+/**
+*  @brief
+*    Reserve memory for a value with size @bytes and the optional parts defined by @flags
+*
+*  @param[in] bytes
+*    Size in bytes to be allocated
+*
+*  @param[in] flags
+*    Optional parts of the header (VALUE_IMPL_FLAG_FINALIZER, VALUE_IMPL_FLAG_VIEW)
+*
+*  @return
+*    Pointer to uninitialized value if success, null otherwhise
+*/
+static value value_impl_alloc(size_t bytes, uint16_t flags);
+
+/**
+*  @brief
+*    Keep track of a scoped value with a finalizer, so it can be finalized along with its allocator
+*
+*  @param[in] v
+*    Reference to the value
+*/
+static void value_impl_finalizer_track(value v);
+
+/**
+*  @brief
+*    Stop tracking a scoped value, because it has been destroyed or its finalizer has been removed
+*
+*  @param[in] v
+*    Reference to the value
+*/
+static void value_impl_finalizer_untrack(value v);
+
+/**
+*  @brief
+*    Stop tracking a scoped value holding a reference, because it has been destroyed
+*
+*  @param[in] v
+*    Reference to the value
+*/
+static void value_impl_reference_untrack(value v);
+
+/**
+*  @brief
+*    Get the allocator a scoped value was reserved from
+*
+*  @param[in] impl
+*    Pointer to the header of a value
+*
+*  @return
+*    Allocator of the value or null if it is heap allocated
+*/
+static memory_allocator value_impl_owner(value_impl impl);
+
 /* -- Methods -- */
 
 value_impl value_descriptor(value v)
@@ -75,24 +219,362 @@ value_impl value_descriptor(value v)
 	return (value_impl)(((uintptr_t)v) - sizeof(struct value_impl_type));
 }
 
-value value_alloc(size_t bytes)
+size_t value_impl_prefix_size(uint16_t flags)
 {
-	value_impl impl = malloc(sizeof(struct value_impl_type) + bytes);
+	size_t size = 0;
 
-	if (impl == NULL)
+	if (flags & VALUE_IMPL_FLAG_ALLOCATOR)
+	{
+		size += VALUE_IMPL_ALLOCATOR_SIZE;
+	}
+
+	if (flags & VALUE_IMPL_FLAG_VIEW)
+	{
+		size += sizeof(struct value_impl_view_type);
+	}
+
+	if (flags & VALUE_IMPL_FLAG_FINALIZER)
+	{
+		size += sizeof(struct value_impl_finalizer_type);
+	}
+
+	return size;
+}
+
+value_impl_finalizer value_impl_finalizer_get(value_impl impl)
+{
+	if (impl == NULL || !(impl->flags & VALUE_IMPL_FLAG_FINALIZER))
+	{
+		return NULL;
+	}
+
+	return (value_impl_finalizer)(((uintptr_t)impl) - sizeof(struct value_impl_finalizer_type));
+}
+
+value_impl_view value_impl_view_get(value_impl impl)
+{
+	size_t offset = sizeof(struct value_impl_view_type);
+
+	if (impl == NULL || !(impl->flags & VALUE_IMPL_FLAG_VIEW))
 	{
 		return NULL;
 	}
 
-	impl->magic = (uintptr_t)value_impl_magic_alloc;
+	if (impl->flags & VALUE_IMPL_FLAG_FINALIZER)
+	{
+		offset += sizeof(struct value_impl_finalizer_type);
+	}
+
+	return (value_impl_view)(((uintptr_t)impl) - offset);
+}
+
+memory_allocator value_impl_owner(value_impl impl)
+{
+	if (!(impl->flags & VALUE_IMPL_FLAG_ALLOCATOR))
+	{
+		return NULL;
+	}
+
+	return *((memory_allocator *)(((uintptr_t)impl) - value_impl_prefix_size(impl->flags)));
+}
+
+memory_allocator value_allocator(memory_allocator allocator)
+{
+	memory_allocator previous = value_impl_allocator;
+
+	value_impl_allocator = allocator;
+
+	return previous;
+}
+
+memory_allocator value_allocator_current(void)
+{
+	return value_impl_allocator;
+}
+
+void value_impl_finalizer_track(value v)
+{
+	if (!(value_descriptor(v)->flags & VALUE_IMPL_FLAG_ALLOCATOR))
+	{
+		return;
+	}
+
+	if (value_impl_finalizers == NULL)
+	{
+		value_impl_finalizers = vector_create_type(value);
+
+		if (value_impl_finalizers == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid allocation of the scoped value finalizers");
+			return;
+		}
+	}
+
+	vector_push_back_var(value_impl_finalizers, v);
+}
+
+void value_impl_finalizer_untrack(value v)
+{
+	size_t iterator, size;
+
+	if (value_impl_finalizers == NULL || !(value_descriptor(v)->flags & VALUE_IMPL_FLAG_ALLOCATOR))
+	{
+		return;
+	}
+
+	size = vector_size(value_impl_finalizers);
+
+	/* Values are usually destroyed in reverse order of creation */
+	for (iterator = size; iterator > 0; --iterator)
+	{
+		if (vector_at_type(value_impl_finalizers, iterator - 1, value) == v)
+		{
+			vector_erase(value_impl_finalizers, iterator - 1);
+			break;
+		}
+	}
+}
+
+void value_allocator_reference(value v)
+{
+	value_impl impl = value_descriptor(v);
+
+	if (impl == NULL || !(impl->flags & VALUE_IMPL_FLAG_ALLOCATOR))
+	{
+		return;
+	}
+
+	if (value_impl_references == NULL)
+	{
+		value_impl_references = vector_create_type(value);
+
+		if (value_impl_references == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid allocation of the scoped value references");
+			return;
+		}
+	}
+
+	vector_push_back_var(value_impl_references, v);
+
+	impl->flags |= VALUE_IMPL_FLAG_REFERENCE;
+}
+
+void value_impl_reference_untrack(value v)
+{
+	size_t iterator;
+
+	if (value_impl_references == NULL)
+	{
+		return;
+	}
+
+	/* Values are usually destroyed in reverse order of creation */
+	for (iterator = vector_size(value_impl_references); iterator > 0; --iterator)
+	{
+		if (vector_at_type(value_impl_references, iterator - 1, value) == v)
+		{
+			vector_erase(value_impl_references, iterator - 1);
+			break;
+		}
+	}
+}
+
+void value_allocator_finalize(memory_allocator allocator, value_finalizer_cb release, void *release_data)
+{
+	size_t iterator = 0;
+
+	while (value_impl_finalizers != NULL && iterator < vector_size(value_impl_finalizers))
+	{
+		value v = vector_at_type(value_impl_finalizers, iterator, value);
+		value_impl impl = value_descriptor(v);
+
+		if (value_impl_owner(impl) == allocator)
+		{
+			value_impl_finalizer impl_finalizer = value_impl_finalizer_get(impl);
+			value_finalizer_cb finalizer = impl_finalizer->finalizer;
+
+			vector_erase(value_impl_finalizers, iterator);
+
+			impl_finalizer->finalizer = NULL;
+
+			/* Values destroyed from another thread are not untracked, but the allocator still holds their memory */
+			if (finalizer != NULL && impl->magic == VALUE_IMPL_MAGIC_ALLOC)
+			{
+				/* The finalizer may destroy other values, so the iterator is not advanced after erasing */
+				finalizer(v, impl_finalizer->finalizer_data);
+			}
+		}
+		else
+		{
+			++iterator;
+		}
+	}
+
+	if (value_impl_finalizers != NULL && vector_size(value_impl_finalizers) == 0)
+	{
+		vector_destroy(value_impl_finalizers);
+		value_impl_finalizers = NULL;
+	}
+
+	/* References are released after the finalizers, as the finalizers may still use them, and from the
+	* newest to the oldest value, so values owning older ones (i.e a throwable holding an exception) destroy
+	* them, and untrack them, before they are reached
+	*/
+	iterator = value_impl_references != NULL ? vector_size(value_impl_references) : 0;
+
+	while (iterator > 0)
+	{
+		value v = vector_at_type(value_impl_references, iterator - 1, value);
+		value_impl impl = value_descriptor(v);
+
+		if (value_impl_owner(impl) != allocator)
+		{
+			--iterator;
+			continue;
+		}
+
+		vector_erase(value_impl_references, iterator - 1);
+
+		/* Values destroyed from another thread are not untracked, but the allocator still holds their memory */
+		if (impl->magic == VALUE_IMPL_MAGIC_ALLOC && (impl->flags & VALUE_IMPL_FLAG_REFERENCE))
+		{
+			impl->flags &= ~VALUE_IMPL_FLAG_REFERENCE;
+
+			if (release != NULL)
+			{
+				release(v, release_data);
+			}
+		}
+
+		/* The release may destroy other values, so the scan starts again from the end */
+		iterator = vector_size(value_impl_references);
+	}
+
+	if (value_impl_references != NULL && vector_size(value_impl_references) == 0)
+	{
+		vector_destroy(value_impl_references);
+		value_impl_references = NULL;
+	}
+}
+
+value value_impl_alloc(size_t bytes, uint16_t flags)
+{
+	memory_allocator allocator = value_impl_allocator;
+	size_t prefix_size;
+	void *block;
+	value_impl impl;
+
+	if (allocator != NULL)
+	{
+		flags |= VALUE_IMPL_FLAG_ALLOCATOR;
+	}
+
+	prefix_size = value_impl_prefix_size(flags);
+
+	if (allocator == NULL)
+	{
+		block = malloc(prefix_size + sizeof(struct value_impl_type) + bytes);
+	}
+	else
+	{
+		block = memory_allocator_allocate(allocator, prefix_size + sizeof(struct value_impl_type) + bytes);
+	}
+
+	if (block == NULL)
+	{
+		return NULL;
+	}
+
+	if (allocator != NULL)
+	{
+		*((memory_allocator *)block) = allocator;
+	}
+
+	impl = (value_impl)(((uintptr_t)block) + prefix_size);
+
 	impl->bytes = bytes;
-	impl->ref_count = 1;
-	impl->finalizer = NULL;
-	impl->finalizer_data = NULL;
+	atomic_init(&impl->ref_count, 1);
+	impl->magic = VALUE_IMPL_MAGIC_ALLOC;
+	impl->flags = flags;
+
+	if (flags & VALUE_IMPL_FLAG_FINALIZER)
+	{
+		value_impl_finalizer finalizer = value_impl_finalizer_get(impl);
+
+		finalizer->finalizer = NULL;
+		finalizer->finalizer_data = NULL;
+	}
+
+	if (flags & VALUE_IMPL_FLAG_VIEW)
+	{
+		value_impl_view view = value_impl_view_get(impl);
+
+		view->source = NULL;
+		view->iface = NULL;
+	}
 
 	return (value)(((uintptr_t)impl) + sizeof(struct value_impl_type));
 }
 
+value value_alloc(size_t bytes)
+{
+	return value_impl_alloc(bytes, VALUE_IMPL_FLAG_FINALIZER);
+}
+
+value value_alloc_compact(size_t bytes)
+{
+	return value_impl_alloc(bytes, 0);
+}
+
+value value_alloc_view(size_t bytes, void *source, value_view_interface iface)
+{
+	value v = value_impl_alloc(bytes, VALUE_IMPL_FLAG_FINALIZER | VALUE_IMPL_FLAG_VIEW);
+
+	if (v != NULL)
+	{
+		value_impl_view view = value_impl_view_get(value_descriptor(v));
+
+		view->source = source;
+		view->iface = iface;
+	}
+
+	return v;
+}
+
+value_view_interface value_view(value v, void **source)
+{
+	value_impl_view view = value_impl_view_get(value_descriptor(v));
+
+	if (view == NULL || view->iface == NULL)
+	{
+		return NULL;
+	}
+
+	if (source != NULL)
+	{
+		*source = view->source;
+	}
+
+	return view->iface;
+}
+
+value_view_interface value_view_detach(value v, void **source)
+{
+	value_view_interface iface = value_view(v, source);
+
+	if (iface != NULL)
+	{
+		value_impl_view view = value_impl_view_get(value_descriptor(v));
+
+		/* The flag is kept because the layout of the prefix depends on it */
+		view->source = NULL;
+		view->iface = NULL;
+	}
+
+	return iface;
+}
+
 value value_create(const void *data, size_t bytes)
 {
 	value v = value_alloc(bytes);
@@ -111,14 +593,23 @@ int value_validate(value v)
 {
 	value_impl impl = value_descriptor(v);
 
-	return !(impl != NULL && impl->magic == (uintptr_t)value_impl_magic_alloc);
+	return !(impl != NULL && impl->magic == VALUE_IMPL_MAGIC_ALLOC);
 }
 
 value value_copy(value v)
 {
-	size_t size = value_size(v);
+	value_impl impl = value_descriptor(v);
+	size_t size;
+	value copy;
 
-	value copy = value_alloc(size);
+	if (impl == NULL)
+	{
+		return NULL;
+	}
+
+	size = impl->bytes;
+
+	copy = value_impl_alloc(size, impl->flags & VALUE_IMPL_FLAG_FINALIZER);
 
 	if (copy == NULL)
 	{
@@ -134,14 +625,42 @@ void value_move(value src, value dst)
 {
 	if (src != NULL && dst != NULL)
 	{
-		value_impl impl_src = value_descriptor(src);
-		value_impl impl_dst = value_descriptor(dst);
+		value_impl_finalizer finalizer_src = value_impl_finalizer_get(value_descriptor(src));
+		value_impl_finalizer finalizer_dst = value_impl_finalizer_get(value_descriptor(dst));
+
+		if (finalizer_src == NULL)
+		{
+			return;
+		}
 
-		impl_dst->finalizer = impl_src->finalizer;
-		impl_dst->finalizer_data = impl_src->finalizer_data;
+		if (finalizer_dst != NULL)
+		{
+			if (finalizer_dst->finalizer != NULL)
+			{
+				value_impl_finalizer_untrack(dst);
+			}
+
+			finalizer_dst->finalizer = finalizer_src->finalizer;
+			finalizer_dst->finalizer_data = finalizer_src->finalizer_data;
+
+			if (finalizer_dst->finalizer != NULL)
+			{
+				value_impl_finalizer_track(dst);
+			}
+		}
+		else if (finalizer_src->finalizer != NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid finalizer move into a compact value");
+			return;
+		}
 
-		impl_src->finalizer = NULL;
-		impl_src->finalizer_data = NULL;
+		if (finalizer_src->finalizer != NULL)
+		{
+			value_impl_finalizer_untrack(src);
+		}
+
+		finalizer_src->finalizer = NULL;
+		finalizer_src->finalizer_data = NULL;
 	}
 }
 
@@ -163,23 +682,75 @@ void value_ref_inc(value v)
 
 	if (impl != NULL)
 	{
-		++impl->ref_count;
+		atomic_fetch_add_explicit(&impl->ref_count, 1, memory_order_relaxed);
 	}
 }
 
 void value_ref_dec(value v)
+{
+	if (value_ref_release(v) == 0)
+	{
+		value_destroy(v);
+	}
+}
+
+int value_ref_release(value v)
 {
 	value_impl impl = value_descriptor(v);
 
-	if (impl != NULL)
+	if (impl == NULL)
+	{
+		return 1;
+	}
+
+	if (atomic_fetch_sub_explicit(&impl->ref_count, 1, memory_order_release) > 1)
+	{
+		return 1;
+	}
+
+	atomic_thread_fence(memory_order_acquire);
+
+	return 0;
+}
+
+int value_ref_shared(value v)
+{
+	value_impl impl = value_descriptor(v);
+
+	return !(impl != NULL && atomic_load_explicit(&impl->ref_count, memory_order_acquire) > 1);
+}
+
+value value_share(value v)
+{
+	value_impl impl = value_descriptor(v);
+
+	if (impl == NULL)
 	{
-		--impl->ref_count;
+		return NULL;
+	}
+
+	/* Values can only be shared inside the allocator they were reserved from. A share of a scoped
+	* value would not outlive the allocator as a copy is expected to do, and a share of a heap value
+	* made inside a scope would never be released, because values of a scope (i.e an arena) are not
+	* destroyed one by one
+	*/
+	{
+		memory_allocator owner = NULL;
 
-		if (impl->ref_count == 0)
+		if (impl->flags & VALUE_IMPL_FLAG_ALLOCATOR)
 		{
-			value_destroy(v);
+			owner = *((memory_allocator *)(((uintptr_t)impl) - value_impl_prefix_size(impl->flags)));
+		}
+
+		if (owner != value_impl_allocator)
+		{
+			return NULL;
 		}
 	}
+
+	value_ref_inc(v);
+
+	return v;
 }
 
 void value_finalizer(value v, value_finalizer_cb finalizer, void *finalizer_data)
@@ -188,11 +759,46 @@ void value_finalizer(value v, value_finalizer_cb finalizer, void *finalizer_data
 
 	if (impl != NULL)
 	{
-		impl->finalizer = finalizer;
-		impl->finalizer_data = finalizer_data;
+		value_impl_finalizer impl_finalizer = value_impl_finalizer_get(impl);
+
+		if (impl_finalizer == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid finalizer registration in a compact value");
+			return;
+		}
+
+		if (impl_finalizer->finalizer != NULL)
+		{
+			value_impl_finalizer_untrack(v);
+		}
+
+		impl_finalizer->finalizer = finalizer;
+		impl_finalizer->finalizer_data = finalizer_data;
+
+		if (finalizer != NULL)
+		{
+			value_impl_finalizer_track(v);
+		}
+	}
+}
+
+void value_borrow(value v)
+{
+	value_impl impl = value_descriptor(v);
+
+	if (impl != NULL)
+	{
+		impl->flags |= VALUE_IMPL_FLAG_BORROWED;
 	}
 }
 
+int value_borrowed(value v)
+{
+	value_impl impl = value_descriptor(v);
+
+	return !(impl != NULL && (impl->flags & VALUE_IMPL_FLAG_BORROWED));
+}
+
 void *value_data(value v)
 {
 	if (v == NULL)
@@ -254,15 +860,32 @@ void value_destroy(value v)
 {
 	value_impl impl = value_descriptor(v);
 
-	if (impl != NULL && impl->ref_count <= 1)
+	if (impl != NULL && atomic_load_explicit(&impl->ref_count, memory_order_acquire) <= 1)
 	{
-		if (impl->finalizer != NULL)
+		value_impl_finalizer impl_finalizer = value_impl_finalizer_get(impl);
+		void *block = (void *)(((uintptr_t)impl) - value_impl_prefix_size(impl->flags));
+
+		if (impl_finalizer != NULL && impl_finalizer->finalizer != NULL)
+		{
+			value_impl_finalizer_untrack(v);
+
+			impl_finalizer->finalizer(v, impl_finalizer->finalizer_data);
+		}
+
+		if (impl->flags & VALUE_IMPL_FLAG_REFERENCE)
 		{
-			impl->finalizer(v, impl->finalizer_data);
+			value_impl_reference_untrack(v);
 		}
 
-		impl->magic = (uintptr_t)value_impl_magic_free;
+		impl->magic = VALUE_IMPL_MAGIC_FREE;
 
-		free(impl);
+		if (impl->flags & VALUE_IMPL_FLAG_ALLOCATOR)
+		{
+			memory_allocator_deallocate(*((memory_allocator *)block), block);
+		}
+		else
+		{
+			free(block);
+		}
 	}
 }
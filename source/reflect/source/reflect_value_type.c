@@ -25,12 +25,87 @@
 #include <log/log.h>
 
 #include <stdint.h>
+#include <string.h>
+
+/* -- Type Definitions -- */
+
+struct value_type_borrowed_type
+{
+	void *data;
+	size_t size;
+};
+
+/* -- Private Methods -- */
+
+/**
+*  @brief
+*    Release the function, class, object, future, exception, throwable or foreign object (of a view) held by a value
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @param[in] id
+*    Type of the value
+*/
+static void value_type_release(value v, type_id id);
+
+/**
+*  @brief
+*    Release callback for the values of an allocator that are still alive when it is finalized
+*
+*  @param[in] v
+*    Reference to the value
+*
+*  @param[in] data
+*    Unused
+*/
+static void value_type_allocator_release(value v, void *data);
+
+/**
+*  @brief
+*    Create an array or map value of type @id backed by the foreign object @source
+*
+*  @param[in] source
+*    Foreign object backing the value
+*
+*  @param[in] size
+*    Number of elements contained in the value
+*
+*  @param[in] iface
+*    Interface for converting the elements of @source
+*
+*  @param[in] id
+*    Type of the value
+*
+*  @return
+*    Pointer to value if success, null otherwhise
+*/
+static value value_type_create_view(void *source, size_t size, value_view_interface iface, type_id id);
+
+/**
+*  @brief
+*    Convert the elements of a view that have not been accessed yet and release its foreign object
+*
+*  @param[in] v
+*    Reference to the value
+*/
+static void value_type_view_materialize(value v);
+
+/**
+*  @brief
+*    Release the foreign object of a view without converting the rest of its elements
+*
+*  @param[in] v
+*    Reference to the value
+*/
+static void value_type_view_release(value v);
 
 /* -- Methods -- */
 
 value value_type_create(const void *data, size_t bytes, type_id id)
 {
-	value v = value_alloc(bytes + sizeof(type_id));
+	/* Scalars never hold a finalizer, so they can use the compact header */
+	value v = ((id >= TYPE_BOOL && id <= TYPE_DOUBLE) || id == TYPE_NULL) ? value_alloc_compact(bytes + sizeof(type_id)) : value_alloc(bytes + sizeof(type_id));
 
 	if (v == NULL)
 	{
@@ -43,6 +118,12 @@ value value_type_create(const void *data, size_t bytes, type_id id)
 	/* Memset header */
 	value_from((value)(((uintptr_t)v) + bytes), &id, sizeof(type_id));
 
+	/* Scoped values holding a reference must release it when their allocator is finalized */
+	if (id == TYPE_FUTURE || id == TYPE_FUNCTION || id == TYPE_CLASS || id == TYPE_OBJECT || id == TYPE_EXCEPTION || id == TYPE_THROWABLE)
+	{
+		value_allocator_reference(v);
+	}
+
 	return v;
 }
 
@@ -95,6 +176,8 @@ value value_type_copy(value v)
 				function f = value_to_function(cpy);
 
 				function_increment_reference(f);
+
+				value_allocator_reference(cpy);
 			}
 
 			return cpy;
@@ -108,6 +191,8 @@ value value_type_copy(value v)
 				klass cls = value_to_class(v);
 
 				class_increment_reference(cls);
+
+				value_allocator_reference(cpy);
 			}
 
 			return cpy;
@@ -121,6 +206,8 @@ value value_type_copy(value v)
 				object obj = value_to_object(cpy);
 
 				object_increment_reference(obj);
+
+				value_allocator_reference(cpy);
 			}
 
 			return cpy;
@@ -134,10 +221,17 @@ value value_type_copy(value v)
 				exception ex = value_to_exception(cpy);
 
 				exception_increment_reference(ex);
+
+				value_allocator_reference(cpy);
 			}
 
 			return cpy;
 		}
+		else if (type_id_buffer(id) == 0 && value_borrowed(v) == 0)
+		{
+			/* The owner of the borrowed memory may release it with the original value, so the copy owns its data */
+			return value_create_buffer(value_to_buffer(v), value_type_size(v));
+		}
 		else if (type_id_throwable(id) == 0)
 		{
 			/* Just create a new throwable from the previous one, it will get flattened after creation */
@@ -153,6 +247,157 @@ value value_type_copy(value v)
 	return NULL;
 }
 
+value value_type_share(value v)
+{
+	value share;
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	/* Borrowed values reference memory owned by someone else, which does not outlive them as a copy does */
+	if (value_borrowed(v) == 0)
+	{
+		return value_type_copy(v);
+	}
+
+	share = value_share(v);
+
+	if (share == NULL)
+	{
+		return value_type_copy(v);
+	}
+
+	return share;
+}
+
+value value_type_create_view(void *source, size_t size, value_view_interface iface, type_id id)
+{
+	size_t bytes = sizeof(const value) * size;
+	value v = value_alloc_view(bytes + sizeof(type_id), source, iface);
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	/* Null elements have not been converted yet */
+	value_from(v, NULL, bytes);
+
+	value_from((value)(((uintptr_t)v) + bytes), &id, sizeof(type_id));
+
+	/* Scoped views must release the foreign object when their allocator is finalized */
+	value_allocator_reference(v);
+
+	return v;
+}
+
+void value_type_view_materialize(value v)
+{
+	void *source;
+	value_view_interface iface = value_view(v, &source);
+
+	if (iface != NULL)
+	{
+		size_t index, size = value_type_count(v);
+		value *values = value_data(v);
+
+		for (index = 0; index < size; ++index)
+		{
+			if (values[index] == NULL)
+			{
+				values[index] = iface->element(source, index);
+			}
+		}
+
+		/* Once all the elements are converted the foreign object is not needed anymore */
+		value_view_detach(v, NULL);
+
+		iface->destroy(source);
+	}
+}
+
+void value_type_view_release(value v)
+{
+	void *source;
+	value_view_interface iface = value_view_detach(v, &source);
+
+	if (iface != NULL)
+	{
+		iface->destroy(source);
+	}
+}
+
+value value_type_copy_on_write(value v)
+{
+	type_id id;
+
+	if (v == NULL)
+	{
+		return NULL;
+	}
+
+	id = value_type_id(v);
+
+	/* Containers are not shared, each owner gets its own list of elements, so writing an element
+	* through value_to_array or value_to_map does not modify the containers of the other owners
+	*/
+	if (type_id_array(id) == 0 || type_id_map(id) == 0)
+	{
+		size_t index, size = value_type_count(v);
+		value new_v = type_id_array(id) == 0 ? value_create_array(NULL, size) : value_create_map(NULL, size);
+		value *new_values, *values;
+
+		if (new_v == NULL)
+		{
+			return NULL;
+		}
+
+		new_values = type_id_array(id) == 0 ? value_to_array(new_v) : value_to_map(new_v);
+		values = type_id_array(id) == 0 ? value_to_array(v) : value_to_map(v);
+
+		for (index = 0; index < size; ++index)
+		{
+			new_values[index] = value_type_copy_on_write(values[index]);
+
+			if (new_values[index] == NULL)
+			{
+				/* The remaining elements are null, so the container can be destroyed as it is */
+				value_type_destroy(new_v);
+
+				return NULL;
+			}
+		}
+
+		return new_v;
+	}
+
+	return value_type_share(v);
+}
+
+value value_type_unshare(value v)
+{
+	value copy;
+
+	if (v == NULL || value_ref_shared(v) != 0)
+	{
+		return v;
+	}
+
+	copy = value_type_copy(v);
+
+	if (copy == NULL)
+	{
+		return NULL;
+	}
+
+	/* Release the reference of the caller, the other owners keep the original */
+	value_type_destroy(v);
+
+	return copy;
+}
+
 value value_type_reference(value v)
 {
 	void *data = value_data(v);
@@ -169,6 +414,13 @@ value value_type_dereference(value v)
 
 size_t value_type_size(value v)
 {
+	if (value_borrowed(v) == 0)
+	{
+		struct value_type_borrowed_type *borrowed = value_data(v);
+
+		return borrowed->size;
+	}
+
 	size_t size = value_size(v);
 
 	return size - sizeof(type_id);
@@ -193,6 +445,79 @@ size_t value_type_count(void *v)
 	return 1;
 }
 
+value value_type_at(value v, size_t index)
+{
+	type_id id = value_type_id(v);
+	value *values;
+	value_view_interface iface;
+	void *source;
+
+	if ((type_id_array(id) != 0 && type_id_map(id) != 0) || index >= value_type_count(v))
+	{
+		return NULL;
+	}
+
+	values = value_data(v);
+
+	if (values[index] == NULL && (iface = value_view(v, &source)) != NULL)
+	{
+		values[index] = iface->element(source, index);
+	}
+
+	return values[index];
+}
+
+value value_type_find(value v, const char *key, size_t length)
+{
+	size_t index, size;
+	value_view_interface iface;
+	void *source;
+
+	if (key == NULL || type_id_map(value_type_id(v)) != 0)
+	{
+		return NULL;
+	}
+
+	iface = value_view(v, &source);
+
+	/* Views that can find the key only convert the tuple of the element */
+	if (iface != NULL && iface->find != NULL)
+	{
+		value tuple;
+
+		if (iface->find(source, key, length, &index) != 0)
+		{
+			return NULL;
+		}
+
+		tuple = value_type_at(v, index);
+
+		return tuple != NULL ? value_to_array(tuple)[1] : NULL;
+	}
+
+	size = value_type_count(v);
+
+	for (index = 0; index < size; ++index)
+	{
+		value tuple = value_type_at(v, index);
+		value *tuple_array;
+
+		if (tuple == NULL)
+		{
+			continue;
+		}
+
+		tuple_array = value_to_array(tuple);
+
+		if (type_id_string(value_type_id(tuple_array[0])) == 0 && value_type_size(tuple_array[0]) == length + 1 && memcmp(value_to_string(tuple_array[0]), key, length) == 0)
+		{
+			return tuple_array[1];
+		}
+	}
+
+	return NULL;
+}
+
 type_id value_type_id(value v)
 {
 	type_id id = TYPE_INVALID;
@@ -254,6 +579,20 @@ value value_create_buffer(const void *buffer, size_t size)
 	return value_type_create(buffer, sizeof(char) * size, TYPE_BUFFER);
 }
 
+value value_create_buffer_borrowed(void *buffer, size_t size)
+{
+	struct value_type_borrowed_type borrowed = { buffer, size };
+
+	value v = value_type_create(&borrowed, sizeof(struct value_type_borrowed_type), TYPE_BUFFER);
+
+	if (v != NULL)
+	{
+		value_borrow(v);
+	}
+
+	return v;
+}
+
 value value_create_array(const value *values, size_t size)
 {
 	return value_type_create(values, sizeof(const value) * size, TYPE_ARRAY);
@@ -264,6 +603,16 @@ value value_create_map(const value *tuples, size_t size)
 	return value_type_create(tuples, sizeof(const value) * size, TYPE_MAP);
 }
 
+value value_create_array_view(void *source, size_t size, value_view_interface iface)
+{
+	return value_type_create_view(source, size, iface, TYPE_ARRAY);
+}
+
+value value_create_map_view(void *source, size_t size, value_view_interface iface)
+{
+	return value_type_create_view(source, size, iface, TYPE_MAP);
+}
+
 value value_create_ptr(const void *ptr)
 {
 	return value_type_create(&ptr, sizeof(const void *), TYPE_PTR);
@@ -419,16 +768,27 @@ char *value_to_string(value v)
 
 void *value_to_buffer(value v)
 {
+	if (value_borrowed(v) == 0)
+	{
+		struct value_type_borrowed_type *borrowed = value_data(v);
+
+		return borrowed->data;
+	}
+
 	return value_data(v);
 }
 
 value *value_to_array(value v)
 {
+	value_type_view_materialize(v);
+
 	return value_data(v);
 }
 
 value *value_to_map(value v)
 {
+	value_type_view_materialize(v);
+
 	return value_data(v);
 }
 
@@ -559,6 +919,9 @@ value value_from_array(value v, const value *values, size_t size)
 	{
 		size_t current_size = value_size(v);
 
+		/* The elements not overwritten must be converted before the foreign object is released */
+		value_type_view_materialize(v);
+
 		size_t bytes = sizeof(const value) * size;
 
 		return value_from(v, values, (bytes <= current_size) ? bytes : current_size);
@@ -573,6 +936,9 @@ value value_from_map(value v, const value *tuples, size_t size)
 	{
 		size_t current_size = value_size(v);
 
+		/* The elements not overwritten must be converted before the foreign object is released */
+		value_type_view_materialize(v);
+
 		size_t bytes = sizeof(const value) * size;
 
 		return value_from(v, tuples, (bytes <= current_size) ? bytes : current_size);
@@ -621,128 +987,164 @@ value value_from_throwable(value v, throwable th)
 	return value_from(v, &th, sizeof(throwable));
 }
 
-void value_type_destroy(value v)
+void value_type_release(value v, type_id id)
 {
-	/* TODO: Disable logs here until log is completely thread safe and async signal safe */
+	if (type_id_array(id) == 0 || type_id_map(id) == 0)
+	{
+		value_type_view_release(v);
+	}
+	else if (type_id_future(id) == 0)
+	{
+		future f = value_to_future(v);
 
-	if (v != NULL)
+		/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy future value <%p>", (void *)v); */
+
+		future_destroy(f);
+	}
+	else if (type_id_function(id) == 0)
 	{
-		type_id id = value_type_id(v);
+		function f = value_to_function(v);
 
-		if (type_id_array(id) == 0)
+		/*
+		const char *name = function_name(f);
+
+		if (name == NULL)
 		{
-			size_t index, size = value_type_count(v);
+			log_write("metacall", LOG_LEVEL_DEBUG, "Destroy anonymous function <%p> value <%p>", (void *)f, (void *)v);
+		}
+		else
+		{
+			log_write("metacall", LOG_LEVEL_DEBUG, "Destroy function %s <%p> value <%p>", name, (void *)f, (void *)v);
+		}
+		*/
 
-			value *v_array = value_to_array(v);
+		function_destroy(f);
+	}
+	else if (type_id_class(id) == 0)
+	{
+		klass c = value_to_class(v);
 
-			/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy array value <%p> of size %u", (void *)v, size); */
+		/*
+		const char *name = class_name(c);
 
-			for (index = 0; index < size; ++index)
-			{
-				value_type_destroy(v_array[index]);
-			}
+		if (name == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_DEBUG, "Destroy anonymous class <%p> value <%p>", (void *)c, (void *)v);
 		}
-		else if (type_id_map(id) == 0)
+		else
 		{
-			size_t index, size = value_type_count(v);
+			log_write("metacall", LOG_LEVEL_DEBUG, "Destroy class %s <%p> value <%p>", name, (void *)c, (void *)v);
+		}
+		*/
 
-			value *v_map = value_to_map(v);
+		class_destroy(c);
+	}
+	else if (type_id_object(id) == 0)
+	{
+		object o = value_to_object(v);
+		int delete_return;
 
-			/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy map value <%p> of size %u", (void *)v, size); */
+		/*
+		const char *name = object_name(o);
 
-			for (index = 0; index < size; ++index)
-			{
-				value_type_destroy(v_map[index]);
-			}
+		if (name == NULL)
+		{
+			log_write("metacall", LOG_LEVEL_DEBUG, "Destroy anonymous object <%p> value <%p>", (void *)o, (void *)v);
 		}
-		else if (type_id_future(id) == 0)
+		else
 		{
-			future f = value_to_future(v);
+			log_write("metacall", LOG_LEVEL_DEBUG, "Destroy object %s <%p> value <%p>", name, (void *)o, (void *)v);
+		}
+		*/
 
-			/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy future value <%p>", (void *)v); */
+		delete_return = object_delete(o);
 
-			future_destroy(f);
-		}
-		else if (type_id_function(id) == 0)
+		if (delete_return != 0)
 		{
-			function f = value_to_function(v);
+			log_write("metacall", LOG_LEVEL_ERROR, "Invalid deletion of object <%p>, destructor return error code %d", (void *)o, delete_return);
+		}
 
-			/*
-			const char *name = function_name(f);
+		object_destroy(o);
+	}
+	else if (type_id_exception(id) == 0)
+	{
+		exception ex = value_to_exception(v);
 
-			if (name == NULL)
-			{
-				log_write("metacall", LOG_LEVEL_DEBUG, "Destroy anonymous function <%p> value <%p>", (void *)f, (void *)v);
-			}
-			else
-			{
-				log_write("metacall", LOG_LEVEL_DEBUG, "Destroy function %s <%p> value <%p>", name, (void *)f, (void *)v);
-			}
-			*/
+		/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy exception value <%p>", (void *)v); */
 
-			function_destroy(f);
-		}
-		else if (type_id_class(id) == 0)
-		{
-			klass c = value_to_class(v);
+		exception_destroy(ex);
+	}
+	else if (type_id_throwable(id) == 0)
+	{
+		throwable th = value_to_throwable(v);
 
-			/*
-			const char *name = class_name(c);
+		/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy throwable value <%p> containing the value <%p>", (void *)v, (void *)throwable_value(th)); */
 
-			if (name == NULL)
-			{
-				log_write("metacall", LOG_LEVEL_DEBUG, "Destroy anonymous class <%p> value <%p>", (void *)c, (void *)v);
-			}
-			else
-			{
-				log_write("metacall", LOG_LEVEL_DEBUG, "Destroy class %s <%p> value <%p>", name, (void *)c, (void *)v);
-			}
-			*/
+		throwable_destroy(th);
+	}
+}
 
-			class_destroy(c);
-		}
-		else if (type_id_object(id) == 0)
+void value_type_allocator_release(value v, void *data)
+{
+	(void)data;
+
+	value_type_release(v, value_type_id(v));
+}
+
+void value_type_allocator_finalize(memory_allocator allocator)
+{
+	value_allocator_finalize(allocator, &value_type_allocator_release, NULL);
+}
+
+void value_type_destroy(value v)
+{
+	/* TODO: Disable logs here until log is completely thread safe and async signal safe */
+
+	if (v != NULL)
+	{
+		type_id id = value_type_id(v);
+
+		/* Shared values are only destroyed when the last owner releases them */
+		if (value_ref_release(v) != 0)
 		{
-			object o = value_to_object(v);
-			int delete_return;
+			return;
+		}
 
-			/*
-			const char *name = object_name(o);
+		if (type_id_array(id) == 0)
+		{
+			size_t index, size = value_type_count(v);
 
-			if (name == NULL)
-			{
-				log_write("metacall", LOG_LEVEL_DEBUG, "Destroy anonymous object <%p> value <%p>", (void *)o, (void *)v);
-			}
-			else
-			{
-				log_write("metacall", LOG_LEVEL_DEBUG, "Destroy object %s <%p> value <%p>", name, (void *)o, (void *)v);
-			}
-			*/
+			/* Elements of a view that have not been accessed are not converted just for destroying them */
+			value *v_array = value_data(v);
 
-			delete_return = object_delete(o);
+			/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy array value <%p> of size %u", (void *)v, size); */
 
-			if (delete_return != 0)
+			for (index = 0; index < size; ++index)
 			{
-				log_write("metacall", LOG_LEVEL_ERROR, "Invalid deletion of object <%p>, destructor return error code %d", (void *)o, delete_return);
+				value_type_destroy(v_array[index]);
 			}
 
-			object_destroy(o);
+			value_type_view_release(v);
 		}
-		else if (type_id_exception(id) == 0)
+		else if (type_id_map(id) == 0)
 		{
-			exception ex = value_to_exception(v);
+			size_t index, size = value_type_count(v);
 
-			/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy exception value <%p>", (void *)v); */
+			/* Elements of a view that have not been accessed are not converted just for destroying them */
+			value *v_map = value_data(v);
 
-			exception_destroy(ex);
-		}
-		else if (type_id_throwable(id) == 0)
-		{
-			throwable th = value_to_throwable(v);
+			/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy map value <%p> of size %u", (void *)v, size); */
 
-			/* log_write("metacall", LOG_LEVEL_DEBUG, "Destroy throwable value <%p> containing the value <%p>", (void *)v, (void *)throwable_value(th)); */
+			for (index = 0; index < size; ++index)
+			{
+				value_type_destroy(v_map[index]);
+			}
 
-			throwable_destroy(th);
+			value_type_view_release(v);
+		}
+		else
+		{
+			value_type_release(v, id);
 		}
 
 		if (type_id_invalid(id) != 0)
@@ -125,6 +125,30 @@ SERIAL_API char *serial_serialize(serial s, value v, size_t *size, memory_alloca
 */
 SERIAL_API value serial_deserialize(serial s, const char *buffer, size_t size, memory_allocator allocator);
 
+/**
+*  @brief
+*    Convert a string @buffer to a deserialized value using serial @s, buffers
+*    of the value may reference @buffer instead of copying it if the serial
+*    supports it, otherwise it behaves like serial_deserialize
+*
+*  @param[in] s
+*    Reference to the serial will be used to deserialize string @buffer
+*
+*  @param[in] buffer
+*    Reference to the string is going to be deserialized, it must outlive the value
+*
+*  @param[in] size
+*    Size in bytes of the string @buffer
+*
+*  @param[in] allocator
+*    Allocator to be used deserialize @buffer
+*
+*  @return
+*    Pointer to value deserialized on correct serialization, null otherwise
+*
+*/
+SERIAL_API value serial_deserialize_borrowed(serial s, const char *buffer, size_t size, memory_allocator allocator);
+
 /**
 *  @brief
 *    Destroy serial by handle @s
@@ -32,6 +32,7 @@ struct serial_interface_type
 	char *(*serialize)(serial_handle, value, size_t *);
 	value (*deserialize)(serial_handle, const char *, size_t);
 	int (*destroy)(serial_handle);
+	value (*deserialize_borrowed)(serial_handle, const char *, size_t); /* Optional, values may reference the input buffer */
 };
 
 /* -- Type Definitions -- */
@@ -130,6 +130,44 @@ value serial_deserialize(serial s, const char *buffer, size_t size, memory_alloc
 	return v;
 }
 
+value serial_deserialize_borrowed(serial s, const char *buffer, size_t size, memory_allocator allocator)
+{
+	if (s == NULL || buffer == NULL || size == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid deserialization arguments");
+
+		return NULL;
+	}
+
+	if (serial_iface(s)->deserialize_borrowed == NULL)
+	{
+		return serial_deserialize(s, buffer, size, allocator);
+	}
+
+	serial_handle handle = serial_iface(s)->initialize(allocator);
+
+	if (handle == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid serial implementation handle initialization");
+
+		return NULL;
+	}
+
+	value v = serial_iface(s)->deserialize_borrowed(handle, buffer, size);
+
+	if (v == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid serial implementation handle deserialization");
+	}
+
+	if (serial_iface(s)->destroy(handle) != 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid serial implementation handle destruction");
+	}
+
+	return v;
+}
+
 int serial_clear(serial s)
 {
 	return plugin_manager_clear(&serial_manager, s);
@@ -22,7 +22,8 @@ serial_interface metacall_serial_impl_interface_singleton(void)
 		&metacall_serial_impl_initialize,
 		&metacall_serial_impl_serialize,
 		&metacall_serial_impl_deserialize,
-		&metacall_serial_impl_destroy
+		&metacall_serial_impl_destroy,
+		NULL
 	};
 
 	return &interface_instance_metacall;
@@ -0,0 +1,856 @@
+/*
+ *	Serial Library by Parra Studios
+ *	A cross-platform library for managing multiple serialization and deserialization formats.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <msgpack_serial/msgpack_serial_impl.h>
+
+#include <format/format_specifier.h>
+
+#include <log/log.h>
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* -- Definitions -- */
+
+#define MSGPACK_SERIAL_IMPL_DEPTH_MAX 512
+
+/* -- Type Definitions -- */
+
+typedef struct msgpack_serial_impl_writer_type
+{
+	uint8_t *data; /* When null, the writer only computes the size */
+	size_t size;
+} * msgpack_serial_impl_writer;
+
+typedef struct msgpack_serial_impl_reader_type
+{
+	const uint8_t *data;
+	size_t size;
+	size_t offset;
+	int borrowed;
+} * msgpack_serial_impl_reader;
+
+/* -- Private Methods -- */
+
+static void msgpack_serial_impl_write(msgpack_serial_impl_writer w, const void *data, size_t size);
+
+static void msgpack_serial_impl_write_tag(msgpack_serial_impl_writer w, uint8_t tag, uint64_t n, size_t bytes);
+
+static void msgpack_serial_impl_write_int(msgpack_serial_impl_writer w, int64_t i);
+
+static void msgpack_serial_impl_write_str(msgpack_serial_impl_writer w, const char *str, size_t length);
+
+static void msgpack_serial_impl_write_length(msgpack_serial_impl_writer w, uint8_t fix, uint8_t fix_max, uint8_t tag, size_t length);
+
+static int msgpack_serial_impl_serialize_value(msgpack_serial_impl_writer w, value v);
+
+static int msgpack_serial_impl_read(msgpack_serial_impl_reader r, size_t bytes, uint64_t *n);
+
+static value msgpack_serial_impl_deserialize_str(msgpack_serial_impl_reader r, size_t length);
+
+static value msgpack_serial_impl_deserialize_array(msgpack_serial_impl_reader r, size_t length, size_t depth);
+
+static value msgpack_serial_impl_deserialize_map(msgpack_serial_impl_reader r, size_t length, size_t depth);
+
+static value msgpack_serial_impl_deserialize_value(msgpack_serial_impl_reader r, size_t depth);
+
+static value msgpack_serial_impl_deserialize_impl(serial_handle handle, const char *buffer, size_t size, int borrowed);
+
+/* -- Methods -- */
+
+const char *msgpack_serial_impl_extension(void)
+{
+	static const char extension[] = "msgpack";
+
+	return extension;
+}
+
+serial_handle msgpack_serial_impl_initialize(memory_allocator allocator)
+{
+	return allocator;
+}
+
+void msgpack_serial_impl_write(msgpack_serial_impl_writer w, const void *data, size_t size)
+{
+	if (w->data != NULL)
+	{
+		memcpy(&w->data[w->size], data, size);
+	}
+
+	w->size += size;
+}
+
+void msgpack_serial_impl_write_tag(msgpack_serial_impl_writer w, uint8_t tag, uint64_t n, size_t bytes)
+{
+	uint8_t data[9];
+	size_t iterator;
+
+	data[0] = tag;
+
+	/* MessagePack stores multi-byte numbers in big endian order */
+	for (iterator = 0; iterator < bytes; ++iterator)
+	{
+		data[bytes - iterator] = (uint8_t)(n >> (iterator * 8));
+	}
+
+	msgpack_serial_impl_write(w, data, bytes + 1);
+}
+
+void msgpack_serial_impl_write_int(msgpack_serial_impl_writer w, int64_t i)
+{
+	if (i >= 0)
+	{
+		uint64_t u = (uint64_t)i;
+
+		if (u < 0x80)
+		{
+			uint8_t fixint = (uint8_t)u;
+
+			msgpack_serial_impl_write(w, &fixint, 1);
+		}
+		else if (u <= UINT8_MAX)
+		{
+			msgpack_serial_impl_write_tag(w, 0xcc, u, 1);
+		}
+		else if (u <= UINT16_MAX)
+		{
+			msgpack_serial_impl_write_tag(w, 0xcd, u, 2);
+		}
+		else if (u <= UINT32_MAX)
+		{
+			msgpack_serial_impl_write_tag(w, 0xce, u, 4);
+		}
+		else
+		{
+			msgpack_serial_impl_write_tag(w, 0xcf, u, 8);
+		}
+	}
+	else
+	{
+		if (i >= -32)
+		{
+			uint8_t fixint = (uint8_t)(int8_t)i;
+
+			msgpack_serial_impl_write(w, &fixint, 1);
+		}
+		else if (i >= INT8_MIN)
+		{
+			msgpack_serial_impl_write_tag(w, 0xd0, (uint64_t)i, 1);
+		}
+		else if (i >= INT16_MIN)
+		{
+			msgpack_serial_impl_write_tag(w, 0xd1, (uint64_t)i, 2);
+		}
+		else if (i >= INT32_MIN)
+		{
+			msgpack_serial_impl_write_tag(w, 0xd2, (uint64_t)i, 4);
+		}
+		else
+		{
+			msgpack_serial_impl_write_tag(w, 0xd3, (uint64_t)i, 8);
+		}
+	}
+}
+
+void msgpack_serial_impl_write_length(msgpack_serial_impl_writer w, uint8_t fix, uint8_t fix_max, uint8_t tag, size_t length)
+{
+	/* Families (str, bin, array and map) are laid out as fix, 8 bits (only str and bin), 16 bits and 32 bits */
+	if (fix != 0 && length <= (size_t)(fix_max - fix))
+	{
+		uint8_t fixlength = (uint8_t)(fix + length);
+
+		msgpack_serial_impl_write(w, &fixlength, 1);
+	}
+	else if (fix == 0 && length <= UINT8_MAX)
+	{
+		msgpack_serial_impl_write_tag(w, tag, length, 1);
+	}
+	else if (length <= UINT16_MAX)
+	{
+		msgpack_serial_impl_write_tag(w, (uint8_t)(fix == 0 ? tag + 1 : tag), length, 2);
+	}
+	else
+	{
+		msgpack_serial_impl_write_tag(w, (uint8_t)(fix == 0 ? tag + 2 : tag + 1), length, 4);
+	}
+}
+
+void msgpack_serial_impl_write_str(msgpack_serial_impl_writer w, const char *str, size_t length)
+{
+	if (length <= 31)
+	{
+		msgpack_serial_impl_write_length(w, 0xa0, 0xbf, 0, length);
+	}
+	else
+	{
+		msgpack_serial_impl_write_length(w, 0, 0, 0xd9, length);
+	}
+
+	msgpack_serial_impl_write(w, str, length);
+}
+
+int msgpack_serial_impl_serialize_value(msgpack_serial_impl_writer w, value v)
+{
+	type_id id = value_type_id(v);
+
+	switch (id)
+	{
+		case TYPE_BOOL: {
+			uint8_t b = value_to_bool(v) == 0L ? 0xc2 : 0xc3;
+
+			msgpack_serial_impl_write(w, &b, 1);
+
+			return 0;
+		}
+
+		case TYPE_CHAR: {
+			char c = value_to_char(v);
+
+			msgpack_serial_impl_write_str(w, &c, 1);
+
+			return 0;
+		}
+
+		case TYPE_SHORT: {
+			msgpack_serial_impl_write_int(w, (int64_t)value_to_short(v));
+
+			return 0;
+		}
+
+		case TYPE_INT: {
+			msgpack_serial_impl_write_int(w, (int64_t)value_to_int(v));
+
+			return 0;
+		}
+
+		case TYPE_LONG: {
+			msgpack_serial_impl_write_int(w, (int64_t)value_to_long(v));
+
+			return 0;
+		}
+
+		case TYPE_FLOAT: {
+			float f = value_to_float(v);
+			uint32_t n;
+
+			memcpy(&n, &f, sizeof(n));
+
+			msgpack_serial_impl_write_tag(w, 0xca, n, 4);
+
+			return 0;
+		}
+
+		case TYPE_DOUBLE: {
+			double d = value_to_double(v);
+			uint64_t n;
+
+			memcpy(&n, &d, sizeof(n));
+
+			msgpack_serial_impl_write_tag(w, 0xcb, n, 8);
+
+			return 0;
+		}
+
+		case TYPE_STRING: {
+			size_t size = value_type_size(v);
+
+			msgpack_serial_impl_write_str(w, value_to_string(v), size > 0 ? size - 1 : 0);
+
+			return 0;
+		}
+
+		case TYPE_BUFFER: {
+			size_t size = value_type_size(v);
+
+			msgpack_serial_impl_write_length(w, 0, 0, 0xc4, size);
+			msgpack_serial_impl_write(w, value_to_buffer(v), size);
+
+			return 0;
+		}
+
+		case TYPE_ARRAY: {
+			value *values = value_to_array(v);
+			size_t iterator, size = value_type_count(v);
+
+			msgpack_serial_impl_write_length(w, 0x90, 0x9f, 0xdc, size);
+
+			for (iterator = 0; iterator < size; ++iterator)
+			{
+				if (msgpack_serial_impl_serialize_value(w, values[iterator]) != 0)
+				{
+					return 1;
+				}
+			}
+
+			return 0;
+		}
+
+		case TYPE_MAP: {
+			value *tuples = value_to_map(v);
+			size_t iterator, size = value_type_count(v);
+
+			msgpack_serial_impl_write_length(w, 0x80, 0x8f, 0xde, size);
+
+			for (iterator = 0; iterator < size; ++iterator)
+			{
+				value *tupla = value_to_array(tuples[iterator]);
+
+				if (msgpack_serial_impl_serialize_value(w, tupla[0]) != 0 || msgpack_serial_impl_serialize_value(w, tupla[1]) != 0)
+				{
+					return 1;
+				}
+			}
+
+			return 0;
+		}
+
+		case TYPE_PTR: {
+			char str[32];
+			int length = snprintf(str, sizeof(str), "%p", value_to_ptr(v));
+
+			if (length < 0 || (size_t)length >= sizeof(str))
+			{
+				return 1;
+			}
+
+			msgpack_serial_impl_write_str(w, str, (size_t)length);
+
+			return 0;
+		}
+
+		case TYPE_FUTURE: {
+			/* TODO: Improve future serialization */
+			static const char str[] = "[Future]";
+
+			msgpack_serial_impl_write_str(w, str, sizeof(str) - 1);
+
+			return 0;
+		}
+
+		case TYPE_FUNCTION: {
+			/* TODO: Improve function serialization */
+			static const char str[] = "[Function]";
+
+			msgpack_serial_impl_write_str(w, str, sizeof(str) - 1);
+
+			return 0;
+		}
+
+		case TYPE_NULL: {
+			uint8_t nil = 0xc0;
+
+			msgpack_serial_impl_write(w, &nil, 1);
+
+			return 0;
+		}
+
+		case TYPE_CLASS: {
+			/* TODO: Improve class serialization */
+			static const char str[] = "[Class]";
+
+			msgpack_serial_impl_write_str(w, str, sizeof(str) - 1);
+
+			return 0;
+		}
+
+		case TYPE_OBJECT: {
+			/* TODO: Improve object serialization */
+			static const char str[] = "[Object]";
+
+			msgpack_serial_impl_write_str(w, str, sizeof(str) - 1);
+
+			return 0;
+		}
+
+		case TYPE_EXCEPTION: {
+			static const char message_str[] = "message";
+			static const char label_str[] = "label";
+			static const char code_str[] = "code";
+			static const char stacktrace_str[] = "stacktrace";
+
+			exception ex = value_to_exception(v);
+
+			msgpack_serial_impl_write_length(w, 0x80, 0x8f, 0xde, 4);
+
+			msgpack_serial_impl_write_str(w, message_str, sizeof(message_str) - 1);
+			msgpack_serial_impl_write_str(w, exception_message(ex), strlen(exception_message(ex)));
+
+			msgpack_serial_impl_write_str(w, label_str, sizeof(label_str) - 1);
+			msgpack_serial_impl_write_str(w, exception_label(ex), strlen(exception_label(ex)));
+
+			msgpack_serial_impl_write_str(w, code_str, sizeof(code_str) - 1);
+			msgpack_serial_impl_write_int(w, exception_error_code(ex));
+
+			msgpack_serial_impl_write_str(w, stacktrace_str, sizeof(stacktrace_str) - 1);
+			msgpack_serial_impl_write_str(w, exception_stacktrace(ex), strlen(exception_stacktrace(ex)));
+
+			return 0;
+		}
+
+		case TYPE_THROWABLE: {
+			static const char str[] = "ExceptionThrown";
+
+			throwable th = value_to_throwable(v);
+
+			msgpack_serial_impl_write_length(w, 0x80, 0x8f, 0xde, 1);
+			msgpack_serial_impl_write_str(w, str, sizeof(str) - 1);
+
+			return msgpack_serial_impl_serialize_value(w, throwable_value(th));
+		}
+
+		default: {
+			log_write("metacall", LOG_LEVEL_ERROR, "Unsupported value type (%d) in MessagePack implementation", (int)id);
+
+			return 1;
+		}
+	}
+}
+
+char *msgpack_serial_impl_serialize(serial_handle handle, value v, size_t *size)
+{
+	memory_allocator allocator;
+
+	struct msgpack_serial_impl_writer_type writer = { NULL, 0 };
+
+	if (handle == NULL || v == NULL || size == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Serialization called with wrong arguments in MessagePack implementation");
+
+		return NULL;
+	}
+
+	allocator = (memory_allocator)handle;
+
+	/* First pass computes the exact size, so the buffer is allocated only once */
+	if (msgpack_serial_impl_serialize_value(&writer, v) != 0 || writer.size == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Serialization invalid length calculation in MessagePack implementation");
+
+		*size = 0;
+
+		return NULL;
+	}
+
+	*size = writer.size;
+
+	writer.data = memory_allocator_allocate(allocator, sizeof(char) * writer.size);
+
+	if (writer.data == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Serialization invalid buffer allocation in MessagePack implementation");
+
+		*size = 0;
+
+		return NULL;
+	}
+
+	writer.size = 0;
+
+	if (msgpack_serial_impl_serialize_value(&writer, v) != 0 || writer.size != *size)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Serialization invalid length (%" PRIuS " != %" PRIuS ") in MessagePack implementation", writer.size, *size);
+
+		memory_allocator_deallocate(allocator, writer.data);
+
+		*size = 0;
+
+		return NULL;
+	}
+
+	return (char *)writer.data;
+}
+
+int msgpack_serial_impl_read(msgpack_serial_impl_reader r, size_t bytes, uint64_t *n)
+{
+	size_t iterator;
+
+	if (r->size - r->offset < bytes)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization unexpected end of buffer in MessagePack implementation");
+
+		return 1;
+	}
+
+	*n = 0;
+
+	for (iterator = 0; iterator < bytes; ++iterator)
+	{
+		*n = (*n << 8) | r->data[r->offset + iterator];
+	}
+
+	r->offset += bytes;
+
+	return 0;
+}
+
+value msgpack_serial_impl_deserialize_str(msgpack_serial_impl_reader r, size_t length)
+{
+	value v;
+
+	if (r->size - r->offset < length)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization string length out of bounds in MessagePack implementation");
+
+		return NULL;
+	}
+
+	/* Strings are always copied because values require them to be null terminated */
+	v = value_create_string(NULL, length);
+
+	if (v != NULL)
+	{
+		memcpy(value_to_string(v), &r->data[r->offset], length);
+	}
+
+	r->offset += length;
+
+	return v;
+}
+
+value msgpack_serial_impl_deserialize_array(msgpack_serial_impl_reader r, size_t length, size_t depth)
+{
+	value v;
+	size_t iterator;
+
+	/* Each element takes at least one byte, this bounds the allocation by the input size */
+	if (r->size - r->offset < length)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization array length out of bounds in MessagePack implementation");
+
+		return NULL;
+	}
+
+	v = value_create_array(NULL, length);
+
+	if (v != NULL)
+	{
+		value *values = value_to_array(v);
+
+		for (iterator = 0; iterator < length; ++iterator)
+		{
+			values[iterator] = msgpack_serial_impl_deserialize_value(r, depth + 1);
+
+			if (values[iterator] == NULL)
+			{
+				value_type_destroy(v);
+
+				return NULL;
+			}
+		}
+	}
+
+	return v;
+}
+
+value msgpack_serial_impl_deserialize_map(msgpack_serial_impl_reader r, size_t length, size_t depth)
+{
+	value v;
+	size_t iterator;
+
+	if ((r->size - r->offset) / 2 < length)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization map length out of bounds in MessagePack implementation");
+
+		return NULL;
+	}
+
+	v = value_create_map(NULL, length);
+
+	if (v != NULL)
+	{
+		value *tuples = value_to_map(v);
+
+		for (iterator = 0; iterator < length; ++iterator)
+		{
+			value tupla[2];
+
+			tupla[0] = msgpack_serial_impl_deserialize_value(r, depth + 1);
+			tupla[1] = tupla[0] != NULL ? msgpack_serial_impl_deserialize_value(r, depth + 1) : NULL;
+
+			if (tupla[1] != NULL)
+			{
+				tuples[iterator] = value_create_array(tupla, 2);
+			}
+
+			if (tupla[1] == NULL || tuples[iterator] == NULL)
+			{
+				if (tupla[0] != NULL)
+				{
+					value_type_destroy(tupla[0]);
+				}
+
+				if (tupla[1] != NULL)
+				{
+					value_type_destroy(tupla[1]);
+				}
+
+				value_type_destroy(v);
+
+				return NULL;
+			}
+		}
+	}
+
+	return v;
+}
+
+value msgpack_serial_impl_deserialize_value(msgpack_serial_impl_reader r, size_t depth)
+{
+	uint8_t tag;
+	uint64_t n;
+
+	if (depth > MSGPACK_SERIAL_IMPL_DEPTH_MAX)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization exceeded maximum nesting depth (%d) in MessagePack implementation", MSGPACK_SERIAL_IMPL_DEPTH_MAX);
+
+		return NULL;
+	}
+
+	if (msgpack_serial_impl_read(r, 1, &n) != 0)
+	{
+		return NULL;
+	}
+
+	tag = (uint8_t)n;
+
+	/* Positive and negative fixint */
+	if (tag <= 0x7f || tag >= 0xe0)
+	{
+		return value_create_int((int)(int8_t)tag);
+	}
+
+	/* Fixed length families */
+	if (tag >= 0x80 && tag <= 0x8f)
+	{
+		return msgpack_serial_impl_deserialize_map(r, tag & 0x0f, depth);
+	}
+	else if (tag >= 0x90 && tag <= 0x9f)
+	{
+		return msgpack_serial_impl_deserialize_array(r, tag & 0x0f, depth);
+	}
+	else if (tag >= 0xa0 && tag <= 0xbf)
+	{
+		return msgpack_serial_impl_deserialize_str(r, tag & 0x1f);
+	}
+
+	switch (tag)
+	{
+		case 0xc0: {
+			return value_create_null();
+		}
+
+		case 0xc2:
+		case 0xc3: {
+			return value_create_bool(tag == 0xc3 ? 1L : 0L);
+		}
+
+		case 0xc4:
+		case 0xc5:
+		case 0xc6: {
+			size_t length;
+			value v;
+
+			if (msgpack_serial_impl_read(r, (size_t)1 << (tag - 0xc4), &n) != 0)
+			{
+				return NULL;
+			}
+
+			length = (size_t)n;
+
+			if (r->size - r->offset < length)
+			{
+				log_write("metacall", LOG_LEVEL_ERROR, "Deserialization binary length out of bounds in MessagePack implementation");
+
+				return NULL;
+			}
+
+			/* Borrowed buffers reference the input directly, the caller keeps it alive */
+			v = r->borrowed != 0 ? value_create_buffer_borrowed((void *)&r->data[r->offset], length) : value_create_buffer(&r->data[r->offset], length);
+
+			r->offset += length;
+
+			return v;
+		}
+
+		case 0xca: {
+			uint32_t u;
+			float f;
+
+			if (msgpack_serial_impl_read(r, sizeof(u), &n) != 0)
+			{
+				return NULL;
+			}
+
+			u = (uint32_t)n;
+			memcpy(&f, &u, sizeof(f));
+
+			return value_create_float(f);
+		}
+
+		case 0xcb: {
+			double d;
+
+			if (msgpack_serial_impl_read(r, sizeof(n), &n) != 0)
+			{
+				return NULL;
+			}
+
+			memcpy(&d, &n, sizeof(d));
+
+			return value_create_double(d);
+		}
+
+		case 0xcc:
+		case 0xcd:
+		case 0xce:
+		case 0xcf: {
+			if (msgpack_serial_impl_read(r, (size_t)1 << (tag - 0xcc), &n) != 0)
+			{
+				return NULL;
+			}
+
+			if (n <= INT_MAX)
+			{
+				return value_create_int((int)n);
+			}
+
+			if (n > LONG_MAX)
+			{
+				log_write("metacall", LOG_LEVEL_WARNING, "Casting unsigned long to long (posible overflow) in MessagePack implementation");
+			}
+
+			return value_create_long((long)n);
+		}
+
+		case 0xd0:
+		case 0xd1:
+		case 0xd2:
+		case 0xd3: {
+			size_t bytes = (size_t)1 << (tag - 0xd0);
+			int64_t i;
+
+			if (msgpack_serial_impl_read(r, bytes, &n) != 0)
+			{
+				return NULL;
+			}
+
+			/* Sign extend from the encoded width */
+			if (bytes < sizeof(n) && (n & ((uint64_t)1 << (bytes * 8 - 1))) != 0)
+			{
+				n |= ~(uint64_t)0 << (bytes * 8);
+			}
+
+			i = (int64_t)n;
+
+			if (i >= INT_MIN && i <= INT_MAX)
+			{
+				return value_create_int((int)i);
+			}
+
+			return value_create_long((long)i);
+		}
+
+		case 0xd9:
+		case 0xda:
+		case 0xdb: {
+			if (msgpack_serial_impl_read(r, (size_t)1 << (tag - 0xd9), &n) != 0)
+			{
+				return NULL;
+			}
+
+			return msgpack_serial_impl_deserialize_str(r, (size_t)n);
+		}
+
+		case 0xdc:
+		case 0xdd: {
+			if (msgpack_serial_impl_read(r, (size_t)2 << (tag - 0xdc), &n) != 0)
+			{
+				return NULL;
+			}
+
+			return msgpack_serial_impl_deserialize_array(r, (size_t)n, depth);
+		}
+
+		case 0xde:
+		case 0xdf: {
+			if (msgpack_serial_impl_read(r, (size_t)2 << (tag - 0xde), &n) != 0)
+			{
+				return NULL;
+			}
+
+			return msgpack_serial_impl_deserialize_map(r, (size_t)n, depth);
+		}
+
+		default: {
+			/* Extension types (0xc7 - 0xc9, 0xd4 - 0xd8) and the never used tag (0xc1) */
+			log_write("metacall", LOG_LEVEL_ERROR, "Deserialization unsupported tag (0x%02x) in MessagePack implementation", (unsigned int)tag);
+
+			return NULL;
+		}
+	}
+}
+
+value msgpack_serial_impl_deserialize_impl(serial_handle handle, const char *buffer, size_t size, int borrowed)
+{
+	struct msgpack_serial_impl_reader_type reader = { (const uint8_t *)buffer, size, 0, borrowed };
+
+	value v;
+
+	if (handle == NULL || buffer == NULL || size == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization called with wrong arguments in MessagePack implementation");
+
+		return NULL;
+	}
+
+	v = msgpack_serial_impl_deserialize_value(&reader, 0);
+
+	if (v != NULL && reader.offset != reader.size)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization found %" PRIuS " trailing bytes in MessagePack implementation", reader.size - reader.offset);
+
+		value_type_destroy(v);
+
+		return NULL;
+	}
+
+	return v;
+}
+
+value msgpack_serial_impl_deserialize(serial_handle handle, const char *buffer, size_t size)
+{
+	return msgpack_serial_impl_deserialize_impl(handle, buffer, size, 0);
+}
+
+value msgpack_serial_impl_deserialize_borrowed(serial_handle handle, const char *buffer, size_t size)
+{
+	return msgpack_serial_impl_deserialize_impl(handle, buffer, size, 1);
+}
+
+int msgpack_serial_impl_destroy(serial_handle handle)
+{
+	(void)handle;
+
+	return 0;
+}
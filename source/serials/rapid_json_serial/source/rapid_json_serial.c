@@ -22,7 +22,8 @@ serial_interface rapid_json_serial_impl_interface_singleton(void)
 		&rapid_json_serial_impl_initialize,
 		&rapid_json_serial_impl_serialize,
 		&rapid_json_serial_impl_deserialize,
-		&rapid_json_serial_impl_destroy
+		&rapid_json_serial_impl_destroy,
+		NULL
 	};
 
 	return &interface_instance_rapid_json;
@@ -0,0 +1,553 @@
+/*
+ *	Serial Library by Parra Studios
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	A cross-platform library for managing multiple serialization and deserialization formats.
+ *
+ */
+
+/* -- Headers -- */
+
+/* SimdJSON must be included first, reflect defines boolean as a macro which collides with its identifiers */
+#include <simdjson.h>
+
+#include <simd_json_serial/simd_json_serial_impl.h>
+
+#include <log/log.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+
+/* -- Type Definitions -- */
+
+typedef struct simd_json_document_type
+{
+	std::string json;
+	memory_allocator allocator;
+
+} * simd_json_document;
+
+/* -- Private Methods -- */
+
+static void simd_json_serial_impl_serialize_value(value v, std::string &json);
+
+static void simd_json_serial_impl_serialize_string(const char *str, size_t length, std::string &json);
+
+static void simd_json_serial_impl_serialize_double(double d, std::string &json);
+
+static value simd_json_serial_impl_deserialize_value(simdjson::dom::element element);
+
+/* -- Methods -- */
+
+const char *simd_json_serial_impl_extension()
+{
+	static const char extension[] = "json";
+
+	return extension;
+}
+
+serial_handle simd_json_serial_impl_initialize(memory_allocator allocator)
+{
+	simd_json_document document = new simd_json_document_type();
+
+	if (document == nullptr)
+	{
+		return NULL;
+	}
+
+	document->allocator = allocator;
+
+	return (serial_handle)document;
+}
+
+void simd_json_serial_impl_serialize_string(const char *str, size_t length, std::string &json)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	json.push_back('"');
+
+	for (size_t iterator = 0; iterator < length; ++iterator)
+	{
+		unsigned char c = (unsigned char)str[iterator];
+
+		switch (c)
+		{
+			case '"':
+				json.append("\\\"", 2);
+				break;
+			case '\\':
+				json.append("\\\\", 2);
+				break;
+			case '\b':
+				json.append("\\b", 2);
+				break;
+			case '\f':
+				json.append("\\f", 2);
+				break;
+			case '\n':
+				json.append("\\n", 2);
+				break;
+			case '\r':
+				json.append("\\r", 2);
+				break;
+			case '\t':
+				json.append("\\t", 2);
+				break;
+			default: {
+				if (c < 0x20)
+				{
+					const char escape[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0f] };
+
+					json.append(escape, sizeof(escape));
+				}
+				else
+				{
+					json.push_back((char)c);
+				}
+			}
+		}
+	}
+
+	json.push_back('"');
+}
+
+void simd_json_serial_impl_serialize_double(double d, std::string &json)
+{
+	char str[32];
+	int length = 0;
+
+	/* JSON has no representation for NaN or infinity */
+	if (std::isfinite(d) == 0)
+	{
+		json.append("null", 4);
+		return;
+	}
+
+	/* Use the shortest representation that round trips */
+	for (int precision = 15; precision <= 17; ++precision)
+	{
+		length = std::snprintf(str, sizeof(str), "%.*g", precision, d);
+
+		if (std::strtod(str, NULL) == d)
+		{
+			break;
+		}
+	}
+
+	json.append(str, (size_t)length);
+
+	/* Keep it as a floating point number when it is deserialized again */
+	if (std::strpbrk(str, ".eE") == NULL)
+	{
+		json.append(".0", 2);
+	}
+}
+
+void simd_json_serial_impl_serialize_value(value v, std::string &json)
+{
+	type_id id = value_type_id(v);
+
+	if (id == TYPE_BOOL)
+	{
+		if (value_to_bool(v) == 1L)
+		{
+			json.append("true", 4);
+		}
+		else
+		{
+			json.append("false", 5);
+		}
+	}
+	else if (id == TYPE_CHAR)
+	{
+		char c = value_to_char(v);
+
+		simd_json_serial_impl_serialize_string(&c, 1, json);
+	}
+	else if (id == TYPE_SHORT)
+	{
+		json.append(std::to_string(value_to_short(v)));
+	}
+	else if (id == TYPE_INT)
+	{
+		json.append(std::to_string(value_to_int(v)));
+	}
+	else if (id == TYPE_LONG)
+	{
+		json.append(std::to_string(value_to_long(v)));
+	}
+	else if (id == TYPE_FLOAT)
+	{
+		simd_json_serial_impl_serialize_double((double)value_to_float(v), json);
+	}
+	else if (id == TYPE_DOUBLE)
+	{
+		simd_json_serial_impl_serialize_double(value_to_double(v), json);
+	}
+	else if (id == TYPE_STRING)
+	{
+		size_t size = value_type_size(v);
+
+		simd_json_serial_impl_serialize_string(value_to_string(v), size > 0 ? size - 1 : 0, json);
+	}
+	else if (id == TYPE_BUFFER)
+	{
+		const unsigned char *buffer = (const unsigned char *)value_to_buffer(v);
+
+		size_t size = value_type_size(v);
+
+		json.append("{\"data\":[", 9);
+
+		for (size_t iterator = 0; iterator < size; ++iterator)
+		{
+			if (iterator > 0)
+			{
+				json.push_back(',');
+			}
+
+			json.append(std::to_string((unsigned int)buffer[iterator]));
+		}
+
+		json.append("],\"length\":", 11);
+		json.append(std::to_string((unsigned long long)size));
+		json.push_back('}');
+	}
+	else if (id == TYPE_ARRAY)
+	{
+		value *value_array = value_to_array(v);
+
+		size_t array_size = value_type_count(v);
+
+		json.push_back('[');
+
+		for (size_t iterator = 0; iterator < array_size; ++iterator)
+		{
+			if (iterator > 0)
+			{
+				json.push_back(',');
+			}
+
+			simd_json_serial_impl_serialize_value(value_array[iterator], json);
+		}
+
+		json.push_back(']');
+	}
+	else if (id == TYPE_MAP)
+	{
+		value *value_map = value_to_map(v);
+
+		size_t map_size = value_type_count(v);
+
+		json.push_back('{');
+
+		for (size_t iterator = 0; iterator < map_size; ++iterator)
+		{
+			value *tupla_array = value_to_array(value_map[iterator]);
+
+			if (iterator > 0)
+			{
+				json.push_back(',');
+			}
+
+			/* JSON keys must be strings, other keys are stringified first */
+			if (value_type_id(tupla_array[0]) == TYPE_STRING)
+			{
+				simd_json_serial_impl_serialize_value(tupla_array[0], json);
+			}
+			else
+			{
+				std::string key;
+
+				simd_json_serial_impl_serialize_value(tupla_array[0], key);
+
+				simd_json_serial_impl_serialize_string(key.c_str(), key.length(), json);
+			}
+
+			json.push_back(':');
+
+			simd_json_serial_impl_serialize_value(tupla_array[1], json);
+		}
+
+		json.push_back('}');
+	}
+	else if (id == TYPE_FUTURE)
+	{
+		/* TODO: Improve future serialization */
+		json.append("\"[Future]\"");
+	}
+	else if (id == TYPE_FUNCTION)
+	{
+		/* TODO: Improve function serialization */
+		json.append("\"[Function]\"");
+	}
+	else if (id == TYPE_CLASS)
+	{
+		/* TODO: Improve class serialization */
+		json.append("\"[Class]\"");
+	}
+	else if (id == TYPE_OBJECT)
+	{
+		/* TODO: Improve object serialization */
+		json.append("\"[Object]\"");
+	}
+	else if (id == TYPE_EXCEPTION)
+	{
+		exception ex = value_to_exception(v);
+
+		json.append("{\"message\":");
+		simd_json_serial_impl_serialize_string(exception_message(ex), std::strlen(exception_message(ex)), json);
+
+		json.append(",\"label\":");
+		simd_json_serial_impl_serialize_string(exception_label(ex), std::strlen(exception_label(ex)), json);
+
+		json.append(",\"code\":");
+		json.append(std::to_string((long long)exception_error_code(ex)));
+
+		json.append(",\"stacktrace\":");
+		simd_json_serial_impl_serialize_string(exception_stacktrace(ex), std::strlen(exception_stacktrace(ex)), json);
+
+		json.push_back('}');
+	}
+	else if (id == TYPE_THROWABLE)
+	{
+		throwable th = value_to_throwable(v);
+
+		json.append("{\"ExceptionThrown\":");
+
+		simd_json_serial_impl_serialize_value(throwable_value(th), json);
+
+		json.push_back('}');
+	}
+	else if (id == TYPE_PTR)
+	{
+		char str[32];
+
+		int length = std::snprintf(str, sizeof(str), "%p", value_to_ptr(v));
+
+		simd_json_serial_impl_serialize_string(str, length > 0 ? (size_t)length : 0, json);
+	}
+	else if (id == TYPE_NULL)
+	{
+		json.append("null", 4);
+	}
+}
+
+char *simd_json_serial_impl_serialize(serial_handle handle, value v, size_t *size)
+{
+	simd_json_document document = static_cast<simd_json_document>(handle);
+
+	if (handle == NULL || v == NULL || size == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Serialization called with wrong arguments in SimdJSON implementation");
+
+		return NULL;
+	}
+
+	simd_json_serial_impl_serialize_value(v, document->json);
+
+	size_t buffer_size = document->json.length();
+	size_t buffer_str_size = buffer_size + 1;
+	char *buffer_str = static_cast<char *>(memory_allocator_allocate(document->allocator, sizeof(char) * buffer_str_size));
+
+	if (buffer_str == NULL)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid string allocation for document stringifycation in SimdJSON implementation");
+		return NULL;
+	}
+
+	std::memcpy(buffer_str, document->json.c_str(), buffer_str_size);
+
+	*size = buffer_str_size;
+
+	return buffer_str;
+}
+
+value simd_json_serial_impl_deserialize_value(simdjson::dom::element element)
+{
+	switch (element.type())
+	{
+		case simdjson::dom::element_type::NULL_VALUE: {
+			return value_create_null();
+		}
+
+		case simdjson::dom::element_type::BOOL: {
+			return value_create_bool(element.get_bool().value_unsafe() == true ? 1L : 0L);
+		}
+
+		case simdjson::dom::element_type::INT64: {
+			int64_t i = element.get_int64().value_unsafe();
+
+			if (i >= std::numeric_limits<int>::min() && i <= std::numeric_limits<int>::max())
+			{
+				return value_create_int((int)i);
+			}
+
+			return value_create_long((long)i);
+		}
+
+		case simdjson::dom::element_type::UINT64: {
+			uint64_t ui = element.get_uint64().value_unsafe();
+
+			log_write("metacall", LOG_LEVEL_WARNING, "Casting unsigned long to long (posible overflow) in SimdJSON implementation");
+
+			return value_create_long((long)ui);
+		}
+
+		case simdjson::dom::element_type::DOUBLE: {
+			double d = element.get_double().value_unsafe();
+
+			/* Keep the same typing as the RapidJSON serial, numbers in float range become floats */
+			if (d >= -std::numeric_limits<float>::max() && d <= std::numeric_limits<float>::max())
+			{
+				return value_create_float((float)d);
+			}
+
+			return value_create_double(d);
+		}
+
+		case simdjson::dom::element_type::STRING: {
+			/* Strings in the tape are null terminated, so they can be copied directly */
+			const char *str = element.get_c_str().value_unsafe();
+
+			size_t length = element.get_string_length().value_unsafe();
+
+			return value_create_string(str, length);
+		}
+
+		case simdjson::dom::element_type::ARRAY: {
+			simdjson::dom::array array = element.get_array().value_unsafe();
+
+			size_t size = array.size();
+
+			value v_array = value_create_array(NULL, size);
+
+			size_t index = 0;
+
+			if (size == 0 || v_array == NULL)
+			{
+				return v_array;
+			}
+
+			value *values = static_cast<value *>(value_to_array(v_array));
+
+			for (simdjson::dom::element child : array)
+			{
+				values[index] = simd_json_serial_impl_deserialize_value(child);
+
+				if (values[index] == NULL)
+				{
+					value_type_destroy(v_array);
+
+					return NULL;
+				}
+
+				++index;
+			}
+
+			return v_array;
+		}
+
+		case simdjson::dom::element_type::OBJECT: {
+			simdjson::dom::object object = element.get_object().value_unsafe();
+
+			size_t size = object.size();
+
+			value v_map = value_create_map(NULL, size);
+
+			size_t index = 0;
+
+			if (size == 0 || v_map == NULL)
+			{
+				return v_map;
+			}
+
+			value *tuples = static_cast<value *>(value_to_map(v_map));
+
+			for (simdjson::dom::object::iterator it = object.begin(); it != object.end(); ++it)
+			{
+				const value tupla[] = {
+					value_create_string(it.key_c_str(), it.key_length()),
+					simd_json_serial_impl_deserialize_value(it.value())
+				};
+
+				if (tupla[0] == NULL || tupla[1] == NULL)
+				{
+					if (tupla[0] != NULL)
+					{
+						value_type_destroy(tupla[0]);
+					}
+
+					if (tupla[1] != NULL)
+					{
+						value_type_destroy(tupla[1]);
+					}
+
+					value_type_destroy(v_map);
+
+					return NULL;
+				}
+
+				tuples[index++] = value_create_array(tupla, sizeof(tupla) / sizeof(tupla[0]));
+			}
+
+			return v_map;
+		}
+
+		default: {
+			break;
+		}
+	}
+
+	log_write("metacall", LOG_LEVEL_ERROR, "Unsuported value type in SimdJSON implementation");
+
+	return NULL;
+}
+
+value simd_json_serial_impl_deserialize(serial_handle handle, const char *buffer, size_t size)
+{
+	/* The parser keeps its tape and padded input buffers between documents, one per thread avoids reallocating them on each call */
+	static thread_local simdjson::dom::parser parser;
+
+	simdjson::dom::element element;
+
+	if (handle == NULL || buffer == NULL || size == 0)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Deserialization called with wrong arguments in SimdJSON implementation");
+
+		return NULL;
+	}
+
+	/* Sizes include the null terminator, as in the RapidJSON serial */
+	if (buffer[size - 1] == '\0')
+	{
+		--size;
+	}
+
+	simdjson::error_code error = parser.parse(buffer, size).get(element);
+
+	if (error != simdjson::SUCCESS)
+	{
+		log_write("metacall", LOG_LEVEL_ERROR, "Invalid parsing of document (%.*s) in SimdJSON implementation: %s",
+			(int)(size > 64 ? 64 : size), buffer, simdjson::error_message(error));
+
+		return NULL;
+	}
+
+	return simd_json_serial_impl_deserialize_value(element);
+}
+
+int simd_json_serial_impl_destroy(serial_handle handle)
+{
+	simd_json_document document = static_cast<simd_json_document>(handle);
+
+	if (document != NULL)
+	{
+		delete document;
+	}
+
+	return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ *	Abstract Data Type Library by Parra Studios
+ *	A abstract data type library providing generic containers.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <adt/adt_hash.h>
+#include <adt/adt_intern.h>
+#include <adt/adt_set.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+class adt_intern_test : public testing::Test
+{
+public:
+};
+
+TEST_F(adt_intern_test, Hash)
+{
+	/* The first character must contribute to the hash */
+	EXPECT_NE((hash)hash_callback_str((hash_key) "abc"), (hash)hash_callback_str((hash_key) "bbc"));
+	EXPECT_NE((hash)hash_callback_str((hash_key) "a"), (hash)hash_callback_str((hash_key) "b"));
+	EXPECT_NE((hash)hash_callback_str((hash_key) ""), (hash)hash_callback_str((hash_key) "a"));
+
+	/* Cover all the length ranges of the hash */
+	for (size_t length = 0; length < 128; ++length)
+	{
+		std::string a(length, 'x'), b(length, 'x');
+
+		EXPECT_EQ((hash)hash_bytes(a.c_str(), length), (hash)hash_callback_str((hash_key)a.c_str()));
+
+		if (length > 0)
+		{
+			b[0] = 'y';
+
+			EXPECT_NE((hash)hash_callback_str((hash_key)a.c_str()), (hash)hash_callback_str((hash_key)b.c_str()));
+
+			b[0] = 'x';
+			b[length - 1] = 'y';
+
+			EXPECT_NE((hash)hash_callback_str((hash_key)a.c_str()), (hash)hash_callback_str((hash_key)b.c_str()));
+		}
+	}
+}
+
+TEST_F(adt_intern_test, DefaultConstructor)
+{
+	static const char name[] = "my_function_name";
+
+	std::string copy(name);
+
+	const char *interned = intern_str(name);
+
+	ASSERT_NE((const char *)NULL, (const char *)interned);
+	EXPECT_NE((const char *)name, (const char *)interned);
+	EXPECT_STREQ(name, interned);
+
+	/* The same string always gives the same pointer */
+	EXPECT_EQ((const char *)interned, (const char *)intern_str(copy.c_str()));
+	EXPECT_EQ((const char *)interned, (const char *)intern_str(interned));
+
+	/* Interned strings carry the hash of their contents */
+	hash h = 0;
+
+	EXPECT_EQ((int)0, (int)intern_hash(interned, &h));
+	EXPECT_EQ((hash)hash_bytes(name, sizeof(name) - 1), (hash)h);
+	EXPECT_EQ((hash)hash_callback_str((hash_key)name), (hash)hash_callback_str((hash_key)interned));
+
+	/* Non interned strings, including the ones pointing inside of an interned string */
+	EXPECT_NE((int)0, (int)intern_hash(name, &h));
+	EXPECT_NE((int)0, (int)intern_hash(copy.c_str(), &h));
+	EXPECT_NE((int)0, (int)intern_hash(interned + 3, &h));
+
+	/* Interned and non interned keys are interchangeable in a set */
+	set s = set_create(&hash_callback_str, &comparable_callback_str);
+
+	EXPECT_EQ((int)0, (int)set_insert(s, (set_key)interned, (set_value)name));
+	EXPECT_EQ((const char *)name, (const char *)set_get(s, (set_key)copy.c_str()));
+	EXPECT_EQ((const char *)name, (const char *)set_get(s, (set_key)interned));
+
+	set_destroy(s);
+}
+
+TEST_F(adt_intern_test, Chunks)
+{
+	/* Fill more than one chunk */
+	static const size_t size = 4096;
+
+	std::string prefix(64, 'z');
+
+	std::vector<const char *> interned(size);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		std::string str = prefix + std::to_string(i);
+
+		interned[i] = intern_str(str.c_str());
+
+		ASSERT_NE((const char *)NULL, (const char *)interned[i]);
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		std::string str = prefix + std::to_string(i);
+		hash h = 0;
+
+		EXPECT_STREQ(str.c_str(), interned[i]);
+		EXPECT_EQ((const char *)interned[i], (const char *)intern_str(str.c_str()));
+		EXPECT_EQ((int)0, (int)intern_hash(interned[i], &h));
+		EXPECT_EQ((hash)hash_bytes(str.c_str(), str.length()), (hash)h);
+	}
+}
+
+TEST_F(adt_intern_test, Threads)
+{
+	static const size_t threads_size = 8;
+	static const size_t size = 1024;
+
+	std::vector<std::vector<const char *>> interned(threads_size, std::vector<const char *>(size));
+	std::vector<std::thread> threads;
+
+	/* All the threads intern the same strings at the same time */
+	for (size_t t = 0; t < threads_size; ++t)
+	{
+		threads.emplace_back([&interned, t]() {
+			for (size_t i = 0; i < size; ++i)
+			{
+				interned[t][i] = intern_str(("threads_" + std::to_string(i)).c_str());
+			}
+		});
+	}
+
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		ASSERT_NE((const char *)NULL, (const char *)interned[0][i]);
+		EXPECT_STREQ(("threads_" + std::to_string(i)).c_str(), interned[0][i]);
+
+		for (size_t t = 1; t < threads_size; ++t)
+		{
+			EXPECT_EQ((const char *)interned[0][i], (const char *)interned[t][i]);
+		}
+	}
+}
+
+TEST_F(adt_intern_test, Destroy)
+{
+	static const char name[] = "my_destroyed_name";
+
+	const char *interned = intern_str(name);
+	hash h = 0;
+
+	ASSERT_NE((const char *)NULL, (const char *)interned);
+	EXPECT_EQ((int)0, (int)intern_hash(interned, &h));
+
+	/* Once the pool is destroyed no pointer is considered interned */
+	intern_destroy();
+
+	EXPECT_NE((int)0, (int)intern_hash(interned, &h));
+
+	/* Destroying it twice does nothing */
+	intern_destroy();
+
+	/* The pool is created again on demand */
+	interned = intern_str(name);
+
+	ASSERT_NE((const char *)NULL, (const char *)interned);
+	EXPECT_STREQ(name, interned);
+	EXPECT_EQ((const char *)interned, (const char *)intern_str(name));
+	EXPECT_EQ((int)0, (int)intern_hash(interned, &h));
+	EXPECT_EQ((hash)hash_bytes(name, sizeof(name) - 1), (hash)h);
+
+	intern_destroy();
+
+	EXPECT_EQ((int)0, (int)intern_initialize());
+	EXPECT_EQ((int)0, (int)intern_initialize());
+
+	intern_destroy();
+}
@@ -224,3 +224,80 @@ TEST_F(adt_set_test, DefaultConstructor)
 		set_destroy(s);
 	}
 }
+
+TEST_F(adt_set_test, Tombstones)
+{
+	EXPECT_EQ((int)0, (int)log_configure("metacall",
+						  log_policy_format_text(),
+						  log_policy_schedule_sync(),
+						  log_policy_storage_sequential(),
+						  log_policy_stream_stdio(stdout)));
+
+	static const size_t key_array_size = 2048;
+
+	static int key_array[key_array_size];
+
+	set s = set_create(&hash_callback_ptr, &comparable_callback_ptr);
+
+	/* Grow the table */
+	for (size_t i = 0; i < key_array_size; ++i)
+	{
+		key_array[i] = (int)i;
+
+		EXPECT_EQ((int)0, (int)set_insert(s, &key_array[i], &key_array[i]));
+	}
+
+	EXPECT_EQ((size_t)key_array_size, (size_t)set_size(s));
+
+	/* Remove the odd keys and insert them again several times, so deleted slots are reused */
+	for (size_t round = 0; round < 4; ++round)
+	{
+		for (size_t i = 1; i < key_array_size; i += 2)
+		{
+			EXPECT_EQ((int *)&key_array[i], (int *)set_remove(s, &key_array[i]));
+		}
+
+		EXPECT_EQ((size_t)key_array_size / 2, (size_t)set_size(s));
+
+		for (size_t i = 0; i < key_array_size; ++i)
+		{
+			EXPECT_EQ((int)(i % 2), (int)set_contains(s, &key_array[i]));
+		}
+
+		for (size_t i = 1; i < key_array_size; i += 2)
+		{
+			EXPECT_EQ((int)0, (int)set_insert(s, &key_array[i], &key_array[i]));
+		}
+	}
+
+	/* Iterate all the keys */
+	size_t count = 0, sum = 0;
+
+	for (set_iterator it = set_iterator_begin(s); set_iterator_end(&it) > 0; set_iterator_next(it))
+	{
+		int *key = (int *)set_iterator_get_key(it);
+
+		EXPECT_EQ((int *)key, (int *)set_iterator_get_value(it));
+
+		sum += (size_t)*key;
+		++count;
+	}
+
+	EXPECT_EQ((size_t)key_array_size, (size_t)count);
+	EXPECT_EQ((size_t)(key_array_size * (key_array_size - 1)) / 2, (size_t)sum);
+
+	/* Shrink the table */
+	for (size_t i = 0; i < key_array_size - 1; ++i)
+	{
+		EXPECT_EQ((int *)&key_array[i], (int *)set_remove(s, &key_array[i]));
+	}
+
+	EXPECT_EQ((size_t)1, (size_t)set_size(s));
+	EXPECT_EQ((int *)&key_array[key_array_size - 1], (int *)set_get(s, &key_array[key_array_size - 1]));
+
+	EXPECT_EQ((int)0, (int)set_clear(s));
+	EXPECT_EQ((size_t)0, (size_t)set_size(s));
+	EXPECT_EQ((int)1, (int)set_contains(s, &key_array[0]));
+
+	set_destroy(s);
+}
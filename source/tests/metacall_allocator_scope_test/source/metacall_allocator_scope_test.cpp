@@ -0,0 +1,201 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <cstdlib>
+#include <cstring>
+
+static size_t scope_alloc_count = 0;
+static size_t scope_free_count = 0;
+
+static void *scope_malloc(size_t size)
+{
+	++scope_alloc_count;
+
+	return std::malloc(size);
+}
+
+static void *scope_realloc(void *data, size_t size)
+{
+	return std::realloc(data, size);
+}
+
+static void scope_free(void *data)
+{
+	++scope_free_count;
+
+	std::free(data);
+}
+
+class metacall_allocator_scope_test : public testing::Test
+{
+public:
+};
+
+TEST_F(metacall_allocator_scope_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+	struct metacall_allocator_std_type std_ctx = { &scope_malloc, &scope_realloc, &scope_free };
+
+	void *allocator = metacall_allocator_create(METACALL_ALLOCATOR_STD, (void *)&std_ctx);
+
+	ASSERT_NE((void *)NULL, (void *)allocator);
+
+	/* Values created inside the scope, including nested ones */
+	{
+		size_t alloc_count = scope_alloc_count;
+
+		void *previous = metacall_allocator_scope_begin(allocator);
+
+		EXPECT_EQ((void *)NULL, (void *)previous);
+
+		void *array[] = {
+			metacall_value_create_long(7),
+			metacall_value_create_string("abc", 3)
+		};
+
+		void *v = metacall_value_create_array((const void **)array, sizeof(array) / sizeof(array[0]));
+
+		metacall_allocator_scope_end(previous);
+
+		/* Array plus its two elements */
+		EXPECT_EQ((size_t)alloc_count + 3, (size_t)scope_alloc_count);
+
+		/* Copies made outside of the scope escape from the allocator */
+		void *copy = metacall_value_copy(v);
+
+		EXPECT_EQ((size_t)alloc_count + 3, (size_t)scope_alloc_count);
+
+		size_t free_count = scope_free_count;
+
+		metacall_value_destroy(v);
+
+		EXPECT_EQ((size_t)free_count + 3, (size_t)scope_free_count);
+
+		void **copy_array = metacall_value_to_array(copy);
+
+		EXPECT_EQ((long)7, (long)metacall_value_to_long(copy_array[0]));
+		EXPECT_EQ((int)0, (int)strcmp("abc", metacall_value_to_string(copy_array[1])));
+
+		metacall_value_destroy(copy);
+
+		EXPECT_EQ((size_t)free_count + 3, (size_t)scope_free_count);
+	}
+
+	/* Values produced by deserialization */
+	{
+		static const char buffer[] = "[1, {\"a\": 2}]";
+
+		size_t alloc_count = scope_alloc_count;
+
+		void *previous = metacall_allocator_scope_begin(allocator);
+
+		void *v = metacall_deserialize(metacall_serial(), buffer, sizeof(buffer), allocator);
+
+		metacall_allocator_scope_end(previous);
+
+		ASSERT_NE((void *)NULL, (void *)v);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_ARRAY, (enum metacall_value_id)metacall_value_id(v));
+
+		EXPECT_LT((size_t)alloc_count, (size_t)scope_alloc_count);
+
+		size_t free_count = scope_free_count;
+
+		metacall_value_destroy(v);
+
+		EXPECT_LT((size_t)free_count, (size_t)scope_free_count);
+	}
+
+/* Python */
+#if defined(OPTION_BUILD_LOADERS_PY)
+	{
+		static const char buffer[] =
+			"def nested(a):\n"
+			"\treturn [a, {'b': a}]\n";
+
+		EXPECT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+		size_t alloc_count = scope_alloc_count;
+
+		void *previous = metacall_allocator_scope_begin(allocator);
+
+		void *args[] = {
+			metacall_value_create_long(3)
+		};
+
+		void *ret = metacallv_s("nested", args, sizeof(args) / sizeof(args[0]));
+
+		metacall_value_destroy(args[0]);
+
+		metacall_allocator_scope_end(previous);
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_ARRAY, (enum metacall_value_id)metacall_value_id(ret));
+
+		/* The argument plus the return value, its elements and the map tuple */
+		EXPECT_LT((size_t)alloc_count + 4, (size_t)scope_alloc_count);
+
+		size_t free_count = scope_free_count;
+
+		metacall_value_destroy(ret);
+
+		EXPECT_LT((size_t)free_count, (size_t)scope_free_count);
+	}
+
+	/* Loading inside the scope does not reserve anything from the allocator, the handle outlives it */
+	{
+		static const char buffer[] =
+			"def loaded_in_scope(a):\n"
+			"\treturn [a, a]\n";
+
+		size_t alloc_count = scope_alloc_count;
+
+		void *previous = metacall_allocator_scope_begin(allocator);
+
+		EXPECT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+		metacall_allocator_scope_end(previous);
+
+		EXPECT_EQ((size_t)alloc_count, (size_t)scope_alloc_count);
+
+		void *ret = metacall("loaded_in_scope", 5);
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_ARRAY, (enum metacall_value_id)metacall_value_id(ret));
+
+		metacall_value_destroy(ret);
+	}
+#endif /* OPTION_BUILD_LOADERS_PY */
+
+	metacall_allocator_destroy(allocator);
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
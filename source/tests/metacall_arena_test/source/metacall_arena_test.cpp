@@ -0,0 +1,230 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <cstring>
+
+class metacall_arena_test : public testing::Test
+{
+public:
+};
+
+TEST_F(metacall_arena_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+	/* Values created inside the arena are released at once */
+	{
+		void *arena = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)arena);
+
+		for (size_t iterator = 0; iterator < 1000; ++iterator)
+		{
+			void *tuple[] = {
+				metacall_value_create_string("key", 3),
+				metacall_value_create_double(3.0)
+			};
+
+			void *tuples[] = {
+				metacall_value_create_array((const void **)tuple, sizeof(tuple) / sizeof(tuple[0]))
+			};
+
+			void *m = metacall_value_create_map((const void **)tuples, sizeof(tuples) / sizeof(tuples[0]));
+
+			ASSERT_NE((void *)NULL, (void *)m);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_MAP, (enum metacall_value_id)metacall_value_id(m));
+		}
+
+		/* Destroying values inside the arena is still allowed */
+		void *v = metacall_value_create_long(5);
+
+		metacall_value_destroy(v);
+
+		EXPECT_EQ((int)0, (int)metacall_arena_end(arena));
+	}
+
+	/* Nested arenas and escaping values */
+	{
+		void *outer = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)outer);
+
+		void *inner = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)inner);
+
+		void *array[] = {
+			metacall_value_create_long(7),
+			metacall_value_create_string("abc", 3)
+		};
+
+		void *v = metacall_value_create_array((const void **)array, sizeof(array) / sizeof(array[0]));
+
+		/* Escaping from the inner arena moves the value into the outer one */
+		void *outer_v = metacall_arena_escape(inner, v);
+
+		EXPECT_EQ((int)0, (int)metacall_arena_end(inner));
+
+		ASSERT_NE((void *)NULL, (void *)outer_v);
+
+		void *escaped = metacall_arena_escape(outer, outer_v);
+
+		EXPECT_EQ((int)0, (int)metacall_arena_end(outer));
+
+		ASSERT_NE((void *)NULL, (void *)escaped);
+
+		void **escaped_array = metacall_value_to_array(escaped);
+
+		EXPECT_EQ((size_t)2, (size_t)metacall_value_count(escaped));
+		EXPECT_EQ((long)7, (long)metacall_value_to_long(escaped_array[0]));
+		EXPECT_EQ((int)0, (int)strcmp("abc", metacall_value_to_string(escaped_array[1])));
+
+		metacall_value_destroy(escaped);
+	}
+
+	/* Arenas ended out of order are not ended, the current one stays active */
+	{
+		void *outer = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)outer);
+
+		void *inner = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)inner);
+
+		EXPECT_NE((int)0, (int)metacall_arena_end(outer));
+
+		void *v = metacall_value_create_string("inner", 5);
+
+		ASSERT_NE((void *)NULL, (void *)v);
+
+		EXPECT_EQ((int)0, (int)metacall_arena_end(inner));
+
+		EXPECT_EQ((int)0, (int)metacall_arena_end(outer));
+	}
+
+/* Python */
+#if defined(OPTION_BUILD_LOADERS_PY)
+	{
+		static const char buffer[] =
+			"def nested(a):\n"
+			"\treturn [a, {'b': a}]\n";
+
+		/* Scripts must be loaded outside of the arena, they outlive it */
+		EXPECT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+		void *escaped = NULL;
+
+		for (long iterator = 0; iterator < 100; ++iterator)
+		{
+			void *arena = metacall_arena_begin();
+
+			ASSERT_NE((void *)NULL, (void *)arena);
+
+			void *args[] = {
+				metacall_value_create_long(iterator)
+			};
+
+			void *ret = metacallv_s("nested", args, sizeof(args) / sizeof(args[0]));
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_ARRAY, (enum metacall_value_id)metacall_value_id(ret));
+
+			if (escaped != NULL)
+			{
+				metacall_value_destroy(escaped);
+			}
+
+			escaped = metacall_arena_escape(arena, ret);
+
+			EXPECT_EQ((int)0, (int)metacall_arena_end(arena));
+		}
+
+		ASSERT_NE((void *)NULL, (void *)escaped);
+
+		void **escaped_array = metacall_value_to_array(escaped);
+
+		EXPECT_EQ((long)99, (long)metacall_value_to_long(escaped_array[0]));
+		EXPECT_EQ((enum metacall_value_id)METACALL_MAP, (enum metacall_value_id)metacall_value_id(escaped_array[1]));
+
+		metacall_value_destroy(escaped);
+	}
+
+	/* Objects and functions returned inside the arena are released at its end */
+	{
+		static const char buffer[] =
+			"deleted = 0\n"
+			"class ArenaTracked:\n"
+			"\tdef __del__(self):\n"
+			"\t\tglobal deleted\n"
+			"\t\tdeleted = deleted + 1\n"
+			"def arena_object():\n"
+			"\treturn ArenaTracked()\n"
+			"def arena_function():\n"
+			"\tt = ArenaTracked()\n"
+			"\treturn lambda: t\n"
+			"def arena_deleted():\n"
+			"\treturn deleted\n";
+
+		EXPECT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+		for (size_t iterator = 0; iterator < 10; ++iterator)
+		{
+			void *arena = metacall_arena_begin();
+
+			ASSERT_NE((void *)NULL, (void *)arena);
+
+			void *obj = metacall("arena_object");
+
+			ASSERT_NE((void *)NULL, (void *)obj);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_OBJECT, (enum metacall_value_id)metacall_value_id(obj));
+
+			void *func = metacall("arena_function");
+
+			ASSERT_NE((void *)NULL, (void *)func);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_FUNCTION, (enum metacall_value_id)metacall_value_id(func));
+
+			EXPECT_EQ((int)0, (int)metacall_arena_end(arena));
+		}
+
+		void *ret = metacall("arena_deleted");
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((long)20L, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+	}
+#endif /* OPTION_BUILD_LOADERS_PY */
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
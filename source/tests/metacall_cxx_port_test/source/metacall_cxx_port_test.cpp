@@ -0,0 +1,99 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.hpp>
+
+#include <stdexcept>
+
+class metacall_cxx_port_test : public testing::Test
+{
+public:
+};
+
+TEST_F(metacall_cxx_port_test, DefaultConstructor)
+{
+	::metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)::metacall_initialize());
+
+	static const char buffer[] =
+		"def cxx_port_sum(a: int, b: int) -> int:\n"
+		"\treturn a + b\n"
+		"def cxx_port_concat(a: str, b: str) -> str:\n"
+		"\treturn a + b\n"
+		"def cxx_port_reverse(b):\n"
+		"\treturn bytes(reversed(b))\n"
+		"def cxx_port_nothing():\n"
+		"\tpass\n"
+		"def cxx_port_throw():\n"
+		"\traise ValueError('cxx port error')\n";
+
+	ASSERT_EQ((int)0, (int)::metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+	/* Scalars, the C++ int is casted to the Python int */
+	{
+		metacall::function<long(int, long)> sum("cxx_port_sum");
+
+		for (int iterator = 0; iterator < 10; ++iterator)
+		{
+			EXPECT_EQ((long)(iterator + 3L), (long)sum(iterator, 3L));
+		}
+	}
+
+	/* Strings */
+	{
+		metacall::function<std::string(std::string, const char *)> concat("cxx_port_concat");
+
+		EXPECT_EQ((std::string) "hello world", (std::string)concat(std::string("hello "), "world"));
+	}
+
+	/* Buffers */
+	{
+		metacall::function<std::vector<unsigned char>(std::vector<unsigned char>)> reverse("cxx_port_reverse");
+
+		std::vector<unsigned char> data = { 0x01, 0x02, 0x03 };
+		std::vector<unsigned char> expected = { 0x03, 0x02, 0x01 };
+
+		EXPECT_EQ((std::vector<unsigned char>)expected, (std::vector<unsigned char>)reverse(data));
+	}
+
+	/* Functions without parameters and without return value */
+	{
+		metacall::function<void()> nothing("cxx_port_nothing");
+
+		nothing();
+	}
+
+	/* Exceptions are propagated */
+	{
+		metacall::function<void()> fail("cxx_port_throw");
+
+		EXPECT_THROW(fail(), std::runtime_error);
+	}
+
+	/* Signature is checked at bind time */
+	EXPECT_THROW(metacall::function<long(int)>("cxx_port_sum"), std::invalid_argument);
+	EXPECT_THROW((metacall::function<std::string(int, int)>("cxx_port_sum")), std::invalid_argument);
+	EXPECT_THROW(metacall::function<void()>("cxx_port_does_not_exist"), std::invalid_argument);
+
+	EXPECT_EQ((int)0, (int)::metacall_destroy());
+}
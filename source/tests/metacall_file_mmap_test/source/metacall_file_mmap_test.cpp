@@ -0,0 +1,157 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+class metacall_file_mmap_test : public testing::Test
+{
+public:
+};
+
+static size_t file_mmap_test_mappings(const char *name)
+{
+	std::ifstream maps("/proc/self/maps");
+	std::string line;
+	size_t count = 0;
+
+	while (std::getline(maps, line))
+	{
+		if (line.find(name) != std::string::npos)
+		{
+			++count;
+		}
+	}
+
+	return count;
+}
+
+TEST_F(metacall_file_mmap_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+/* File */
+#if defined(OPTION_BUILD_LOADERS_FILE)
+	{
+		const char *scripts[] = {
+			"favicon.ico",
+			"a/a.txt"
+		};
+
+		const size_t size = sizeof(scripts) / sizeof(scripts[0]);
+
+		EXPECT_EQ((int)0, (int)metacall_load_from_file("file", scripts, size, NULL));
+
+		/* Files are exposed as read only buffers mapped into memory */
+		void *ret = metacall("favicon.ico");
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_BUFFER, (enum metacall_value_id)metacall_value_id(ret));
+
+		EXPECT_EQ((size_t)33310, (size_t)metacall_value_size(ret));
+
+		const unsigned char ico_header[] = { 0x00, 0x00, 0x01, 0x00 };
+
+		EXPECT_EQ((int)0, (int)memcmp(metacall_value_to_buffer(ret), ico_header, sizeof(ico_header)));
+
+		/* Copies own their memory, they must outlive the mapping */
+		void *copy = metacall_value_copy(ret);
+
+		EXPECT_NE((void *)ret, (void *)copy);
+
+		metacall_value_destroy(ret);
+
+		EXPECT_EQ((size_t)33310, (size_t)metacall_value_size(copy));
+
+		EXPECT_EQ((int)0, (int)memcmp(metacall_value_to_buffer(copy), ico_header, sizeof(ico_header)));
+
+		metacall_value_destroy(copy);
+
+		ret = metacall("a/a.txt");
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_BUFFER, (enum metacall_value_id)metacall_value_id(ret));
+
+		EXPECT_EQ((size_t)1, (size_t)metacall_value_size(ret));
+
+		EXPECT_EQ((char)'a', (char)((const char *)metacall_value_to_buffer(ret))[0]);
+
+		metacall_value_destroy(ret);
+
+	#if defined(__linux__)
+		/* Mappings returned inside an arena are released when it ends, even if they are not destroyed */
+		size_t mappings = file_mmap_test_mappings("favicon.ico");
+
+		void *arena = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)arena);
+
+		for (size_t iterator = 0; iterator < 10; ++iterator)
+		{
+			ret = metacall("favicon.ico");
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			EXPECT_EQ((size_t)33310, (size_t)metacall_value_size(ret));
+		}
+
+		EXPECT_LT((size_t)mappings, (size_t)file_mmap_test_mappings("favicon.ico"));
+
+		metacall_arena_end(arena);
+
+		EXPECT_EQ((size_t)mappings, (size_t)file_mmap_test_mappings("favicon.ico"));
+	#endif /* __linux__ */
+	}
+#endif /* OPTION_BUILD_LOADERS_FILE */
+
+	/* Print inspect information */
+	{
+		size_t size = 0;
+
+		struct metacall_allocator_std_type std_ctx = { &std::malloc, &std::realloc, &std::free };
+
+		void *allocator = metacall_allocator_create(METACALL_ALLOCATOR_STD, (void *)&std_ctx);
+
+		char *inspect_str = metacall_inspect(&size, allocator);
+
+		EXPECT_NE((char *)NULL, (char *)inspect_str);
+
+		EXPECT_GT((size_t)size, (size_t)0);
+
+		std::cout << inspect_str << std::endl;
+
+		metacall_allocator_free(allocator, inspect_str);
+
+		metacall_allocator_destroy(allocator);
+	}
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
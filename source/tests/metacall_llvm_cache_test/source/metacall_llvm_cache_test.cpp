@@ -0,0 +1,249 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define LLVM_CACHE_TEST_PATH "metacall_llvm_cache_test_cache"
+
+class metacall_llvm_cache_test : public testing::Test
+{
+public:
+};
+
+static const char buffer[] =
+	"define i64 @sum_squares(i64 %n) {\n"
+	"entry:\n"
+	"  br label %loop\n"
+	"loop:\n"
+	"  %i = phi i64 [ 0, %entry ], [ %next, %loop ]\n"
+	"  %acc = phi i64 [ 0, %entry ], [ %sum, %loop ]\n"
+	"  %square = mul i64 %i, %i\n"
+	"  %sum = add i64 %acc, %square\n"
+	"  %next = add i64 %i, 1\n"
+	"  %done = icmp eq i64 %next, %n\n"
+	"  br i1 %done, label %exit, label %loop\n"
+	"exit:\n"
+	"  ret i64 %sum\n"
+	"}\n";
+
+static std::vector<std::string> llvm_cache_test_entries()
+{
+	std::vector<std::string> entries;
+	DIR *dir = opendir(LLVM_CACHE_TEST_PATH);
+
+	if (dir == NULL)
+	{
+		return entries;
+	}
+
+	for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+	{
+		std::string name(entry->d_name);
+
+		if (name.size() > 2 && name.compare(name.size() - 2, 2, ".o") == 0)
+		{
+			entries.push_back(std::string(LLVM_CACHE_TEST_PATH "/") + name);
+		}
+	}
+
+	closedir(dir);
+
+	std::sort(entries.begin(), entries.end());
+
+	return entries;
+}
+
+static std::string llvm_cache_test_read(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void llvm_cache_test_write(const std::string &path, const std::string &data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	file << data;
+}
+
+static int llvm_cache_test_load(const char *optimization)
+{
+	/* The options are read when the loader is initialized, so each run is done in a new process */
+	pid_t pid = fork();
+
+	if (pid == -1)
+	{
+		return 1;
+	}
+
+	if (pid == 0)
+	{
+		int result = 1;
+
+		if (setenv("LLVM_LOADER_OPTIMIZATION", optimization, 1) == 0 && metacall_initialize() == 0)
+		{
+			if (metacall_load_from_memory("llvm", buffer, sizeof(buffer), NULL) == 0)
+			{
+				void *ret = metacall("sum_squares", 10L);
+
+				result = (ret != NULL && metacall_value_id(ret) == METACALL_LONG && metacall_value_to_long(ret) == 285L) ? 0 : 1;
+
+				metacall_value_destroy(ret);
+			}
+
+			result = metacall_destroy() != 0 || result;
+		}
+
+		_exit(result);
+	}
+
+	int status = 0;
+
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+	{
+		return 1;
+	}
+
+	return WEXITSTATUS(status);
+}
+
+static int llvm_cache_test_hit(const std::string &entry)
+{
+	/* The entry is aged, if it is loaded from the cache it is not written again */
+	struct utimbuf times = { 0, 0 };
+	struct stat entry_stat;
+
+	if (utime(entry.c_str(), &times) != 0 || llvm_cache_test_load("2") != 0 || stat(entry.c_str(), &entry_stat) != 0)
+	{
+		return 1;
+	}
+
+	return entry_stat.st_mtime != 0;
+}
+
+static std::vector<std::string> llvm_cache_test_difference(const std::vector<std::string> &after, const std::vector<std::string> &before)
+{
+	std::vector<std::string> result;
+
+	std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(result));
+
+	return result;
+}
+
+TEST_F(metacall_llvm_cache_test, DefaultConstructor)
+{
+/* LLVM */
+#if defined(OPTION_BUILD_LOADERS_LLVM)
+	for (const std::string &entry : llvm_cache_test_entries())
+	{
+		unlink(entry.c_str());
+	}
+
+	ASSERT_EQ((int)0, (int)setenv("LLVM_LOADER_CACHE_PATH", LLVM_CACHE_TEST_PATH, 1));
+
+	/* Cold start, the module is compiled and stored */
+	ASSERT_EQ((int)0, (int)llvm_cache_test_load("2"));
+
+	std::vector<std::string> entries = llvm_cache_test_entries();
+
+	ASSERT_EQ((size_t)1, (size_t)entries.size());
+
+	const std::string object = llvm_cache_test_read(entries[0]);
+
+	ASSERT_GT((size_t)object.size(), (size_t)8);
+
+	/* Warm start, the object is loaded from the cache */
+	EXPECT_EQ((int)0, (int)llvm_cache_test_hit(entries[0]));
+
+	/* A corrupt entry is detected, the module is compiled again and the entry is replaced by a valid one */
+	std::string corrupt = object;
+
+	corrupt[corrupt.size() / 2] ^= 0x5A;
+
+	llvm_cache_test_write(entries[0], corrupt);
+
+	EXPECT_EQ((int)0, (int)llvm_cache_test_load("2"));
+
+	EXPECT_NE((std::string)corrupt, (std::string)llvm_cache_test_read(entries[0]));
+
+	EXPECT_EQ((int)0, (int)llvm_cache_test_hit(entries[0]));
+
+	/* A truncated entry is handled the same way */
+	llvm_cache_test_write(entries[0], object.substr(0, object.size() / 2));
+
+	EXPECT_EQ((int)0, (int)llvm_cache_test_load("2"));
+
+	EXPECT_EQ((size_t)object.size(), (size_t)llvm_cache_test_read(entries[0]).size());
+
+	EXPECT_EQ((int)0, (int)llvm_cache_test_hit(entries[0]));
+
+	/* Each optimization level generates different code, so it has its own entry */
+	EXPECT_EQ((int)0, (int)llvm_cache_test_load("0"));
+
+	std::vector<std::string> o0 = llvm_cache_test_difference(llvm_cache_test_entries(), entries);
+
+	ASSERT_EQ((size_t)1, (size_t)o0.size());
+
+	entries = llvm_cache_test_entries();
+
+	EXPECT_EQ((int)0, (int)llvm_cache_test_load("3"));
+
+	std::vector<std::string> o3 = llvm_cache_test_difference(llvm_cache_test_entries(), entries);
+
+	ASSERT_EQ((size_t)1, (size_t)o3.size());
+
+	/* The loop is kept at O0 and reduced by the optimizer at O3 */
+	EXPECT_NE((std::string)llvm_cache_test_read(o0[0]), (std::string)llvm_cache_test_read(o3[0]));
+
+	EXPECT_LT((size_t)llvm_cache_test_read(o3[0]).size(), (size_t)llvm_cache_test_read(o0[0]).size());
+
+	/* An invalid level falls back to the default one, which is already cached */
+	entries = llvm_cache_test_entries();
+
+	EXPECT_EQ((int)0, (int)llvm_cache_test_load("9"));
+
+	EXPECT_EQ((size_t)entries.size(), (size_t)llvm_cache_test_entries().size());
+
+	for (const std::string &entry : llvm_cache_test_entries())
+	{
+		unlink(entry.c_str());
+	}
+
+	rmdir(LLVM_CACHE_TEST_PATH);
+#endif /* OPTION_BUILD_LOADERS_LLVM */
+}
@@ -52,29 +52,52 @@ TEST_F(metacall_llvm_test, DefaultConstructor)
 
 		ASSERT_EQ((int)0, (int)metacall_load_from_file(tag, llvm_scripts, sizeof(llvm_scripts) / sizeof(llvm_scripts[0]), NULL));
 
-		/* TODO: Uncomment this when calls are implemented */
-		/*
-		void *ret = ret = metacallt_s("adder", hello_string_ids, args_size, 3.4f, 12.0f);
+		void *ret = metacallt_s("adder", hello_string_ids, args_size, 3.4f, 12.0f);
 
 		EXPECT_NE((void *)NULL, (void *)ret);
 
 		EXPECT_EQ((float)metacall_value_to_float(ret), (float)15.4f);
 
 		metacall_value_destroy(ret);
-		*/
 
-		/* TODO: Test load from memory */
-		/*
 		static const char buffer[] =
-			"define dso_local float @whatever(float, float) #0 {\n"
-			"...\n"
-			"...\n"
-			"...\n";
+			"define i64 @sum_squares(i64 %n) {\n"
+			"entry:\n"
+			"  br label %loop\n"
+			"loop:\n"
+			"  %i = phi i64 [ 0, %entry ], [ %next, %loop ]\n"
+			"  %acc = phi i64 [ 0, %entry ], [ %sum, %loop ]\n"
+			"  %square = mul i64 %i, %i\n"
+			"  %sum = add i64 %acc, %square\n"
+			"  %next = add i64 %i, 1\n"
+			"  %done = icmp eq i64 %next, %n\n"
+			"  br i1 %done, label %exit, label %loop\n"
+			"exit:\n"
+			"  ret i64 %sum\n"
+			"}\n"
+			"define double @scale(double %x, i32 %factor) {\n"
+			"  %f = sitofp i32 %factor to double\n"
+			"  %r = fmul double %x, %f\n"
+			"  ret double %r\n"
+			"}\n";
 
 		EXPECT_EQ((int)0, (int)metacall_load_from_memory(tag, buffer, sizeof(buffer), NULL));
-		*/
 
-		/* TODO: Call to the functions of the load from memory script */
+		ret = metacall("sum_squares", 10L);
+
+		EXPECT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((long)metacall_value_to_long(ret), (long)285L);
+
+		metacall_value_destroy(ret);
+
+		ret = metacall("scale", 1.5, 4);
+
+		EXPECT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((double)metacall_value_to_double(ret), (double)6.0);
+
+		metacall_value_destroy(ret);
 
 		/* TODO: Test load from package */
 	}
@@ -0,0 +1,207 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <loader/loader.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+class metacall_loader_fork_test : public testing::Test
+{
+public:
+};
+
+static const char py_buffer[] =
+	"counter = 0\n"
+	"def py_fork_increment() -> int:\n"
+	"	global counter\n"
+	"	counter = counter + 1\n"
+	"	return counter\n"
+	"async def py_fork_async(a):\n"
+	"	return a + 1\n"
+	"\n";
+
+static long py_fork_increment()
+{
+	void *ret = metacall("py_fork_increment");
+	long result = (ret != NULL && metacall_value_id(ret) == METACALL_LONG) ? metacall_value_to_long(ret) : -1L;
+
+	metacall_value_destroy(ret);
+
+	return result;
+}
+
+struct loader_fork_test_await_type
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	bool done;
+	long result;
+};
+
+static void *loader_fork_test_await_resolve(void *result, void *data)
+{
+	loader_fork_test_await_type *await_data = static_cast<loader_fork_test_await_type *>(data);
+	std::unique_lock<std::mutex> lock(await_data->mutex);
+
+	await_data->result = (result != NULL && metacall_value_id(result) == METACALL_LONG) ? metacall_value_to_long(result) : -1L;
+	await_data->done = true;
+	await_data->cv.notify_one();
+
+	return NULL;
+}
+
+static void *loader_fork_test_await_reject(void *, void *data)
+{
+	loader_fork_test_await_type *await_data = static_cast<loader_fork_test_await_type *>(data);
+	std::unique_lock<std::mutex> lock(await_data->mutex);
+
+	await_data->result = -1L;
+	await_data->done = true;
+	await_data->cv.notify_one();
+
+	return NULL;
+}
+
+static long py_fork_async()
+{
+	loader_fork_test_await_type await_data;
+	void *args[] = {
+		metacall_value_create_long(41L)
+	};
+
+	await_data.done = false;
+	await_data.result = -1L;
+
+	void *future = metacall_await("py_fork_async", args, loader_fork_test_await_resolve, loader_fork_test_await_reject, &await_data);
+
+	metacall_value_destroy(args[0]);
+
+	if (future == NULL)
+	{
+		return -1L;
+	}
+
+	/* The coroutine runs in the asyncio event loop thread, if it is not running the callbacks are never called */
+	{
+		std::unique_lock<std::mutex> lock(await_data.mutex);
+
+		if (await_data.cv.wait_for(lock, std::chrono::seconds(10), [&await_data] { return await_data.done; }) == false)
+		{
+			await_data.result = -2L;
+		}
+	}
+
+	metacall_value_destroy(future);
+
+	return await_data.result;
+}
+
+static int loader_fork_test_child()
+{
+	/* The Python runtime survives the fork, so the state of the module loaded in the parent is still there */
+	if (py_fork_increment() != 3L)
+	{
+		return 1;
+	}
+
+	/* Loading new scripts must keep working in the child */
+	static const char child_buffer[] =
+		"def py_fork_child(a: int) -> int:\n"
+		"	return a * 2\n"
+		"\n";
+
+	if (metacall_load_from_memory("py", child_buffer, sizeof(child_buffer), NULL) != 0)
+	{
+		return 2;
+	}
+
+	/* The asyncio event loop thread of the parent does not exist in the child, async calls need a new one */
+	if (py_fork_async() != 42L)
+	{
+		return 6;
+	}
+
+	void *ret = metacall("py_fork_child", 21L);
+	int result = (ret != NULL && metacall_value_id(ret) == METACALL_LONG && metacall_value_to_long(ret) == 42L) ? 0 : 3;
+
+	metacall_value_destroy(ret);
+
+	if (result != 0)
+	{
+		return result;
+	}
+
+	return metacall_destroy() != 0 ? 4 : 0;
+}
+
+TEST_F(metacall_loader_fork_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+	ASSERT_EQ((int)0, (int)metacall_load_from_memory("py", py_buffer, sizeof(py_buffer), NULL));
+
+	EXPECT_EQ((long)1L, (long)py_fork_increment());
+	EXPECT_EQ((long)2L, (long)py_fork_increment());
+	EXPECT_EQ((long)42L, (long)py_fork_async());
+
+	/* Same sequence as the fork detour, the loaders are prepared before the fork and notified after it in both processes */
+	ASSERT_EQ((int)0, (int)loader_fork(LOADER_IMPL_FORK_PREPARE));
+
+	pid_t pid = fork();
+
+	if (pid == 0)
+	{
+		if (loader_fork(LOADER_IMPL_FORK_CHILD) != 0)
+		{
+			_exit(5);
+		}
+
+		_exit(loader_fork_test_child());
+	}
+
+	ASSERT_EQ((int)0, (int)loader_fork(LOADER_IMPL_FORK_PARENT));
+
+	ASSERT_NE((pid_t)-1, (pid_t)pid);
+
+	int status = 0;
+
+	ASSERT_EQ((pid_t)pid, (pid_t)waitpid(pid, &status, 0));
+	ASSERT_TRUE(WIFEXITED(status));
+	EXPECT_EQ((int)0, (int)WEXITSTATUS(status));
+
+	/* The parent is not affected by the calls done in the child */
+	EXPECT_EQ((long)3L, (long)py_fork_increment());
+	EXPECT_EQ((long)42L, (long)py_fork_async());
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
@@ -24,11 +24,42 @@
 #include <metacall/metacall_loaders.h>
 #include <metacall/metacall_value.h>
 
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
 class metacall_lua_test : public testing::Test
 {
 public:
 };
 
+static void *lua_await_resolve(void *result, void *data)
+{
+	int *resolved = static_cast<int *>(data);
+
+	EXPECT_NE((void *)NULL, (void *)result);
+
+	EXPECT_EQ((long)metacall_value_cast_long(&result), (long)6L);
+
+	*resolved = 1;
+
+	return NULL;
+}
+
+static void *lua_await_reject(void *error, void *data)
+{
+	int *rejected = static_cast<int *>(data);
+
+	EXPECT_NE((void *)NULL, (void *)error);
+
+	EXPECT_EQ((enum metacall_value_id)METACALL_THROWABLE, (enum metacall_value_id)metacall_value_id(error));
+
+	*rejected = 1;
+
+	return NULL;
+}
+
 TEST_F(metacall_lua_test, DefaultConstructor)
 {
 	metacall_print_info();
@@ -61,7 +92,59 @@ TEST_F(metacall_lua_test, DefaultConstructor)
 
 			EXPECT_NE((void *)NULL, (void *)ret);
 
-			EXPECT_EQ((float)metacall_value_to_float(ret), (float)3.0f);
+			/* Floats are pushed as Lua numbers, which are returned as double */
+			EXPECT_EQ((enum metacall_value_id)METACALL_DOUBLE, (enum metacall_value_id)metacall_value_id(ret));
+
+			EXPECT_EQ((double)metacall_value_to_double(ret), (double)3.0);
+
+			metacall_value_destroy(ret);
+		}
+
+		/* Return type depends on the returned number, not on the arguments */
+		{
+			static const char buffer[] =
+				"function luadiv(left, right)\n"
+				"	return left / right\n"
+				"end\n"
+				"function luaadd(left, right)\n"
+				"	return left + right\n"
+				"end\n"
+				"function luafrac()\n"
+				"	return 3.7\n"
+				"end\n";
+
+			const enum metacall_value_id int_ids[] = {
+				METACALL_INT, METACALL_INT
+			};
+
+			ASSERT_EQ((int)0, (int)metacall_load_from_memory(tag, buffer, sizeof(buffer), NULL));
+
+			void *ret = metacallt_s("luadiv", int_ids, 2, 1, 2);
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_DOUBLE, (enum metacall_value_id)metacall_value_id(ret));
+
+			EXPECT_EQ((double)metacall_value_to_double(ret), (double)0.5);
+
+			metacall_value_destroy(ret);
+
+			ret = metacallt_s("luaadd", int_ids, 2, 2, 3);
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			/* Integers are returned as long in Lua 5.3+ and as double in older versions and LuaJIT */
+			EXPECT_EQ((long)metacall_value_cast_long(&ret), (long)5L);
+
+			metacall_value_destroy(ret);
+
+			ret = metacall("luafrac");
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_DOUBLE, (enum metacall_value_id)metacall_value_id(ret));
+
+			EXPECT_EQ((double)metacall_value_to_double(ret), (double)3.7);
 
 			metacall_value_destroy(ret);
 		}
@@ -82,10 +165,179 @@ TEST_F(metacall_lua_test, DefaultConstructor)
 
 			EXPECT_NE((void *)NULL, (void *)ret);
 
-			EXPECT_EQ((int)metacall_value_to_int(ret), (int)6);
+			EXPECT_EQ((int)metacall_value_cast_int(&ret), (int)6);
 
 			metacall_value_destroy(ret);
 		}
+
+		/* Await (Lua calls are synchronous, the future is settled before returning) */
+		{
+			void *args[] = {
+				metacall_value_create_int(3),
+				metacall_value_create_int(6)
+			};
+
+			int resolved = 0, rejected = 0;
+
+			void *future = metacall_await("luamax", args, &lua_await_resolve, &lua_await_reject, &resolved);
+
+			ASSERT_NE((void *)NULL, (void *)future);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_FUTURE, (enum metacall_value_id)metacall_value_id(future));
+
+			EXPECT_EQ((int)1, (int)resolved);
+
+			/* The settled future can be awaited again */
+			resolved = 0;
+
+			metacall_value_destroy(metacall_await_future(metacall_value_to_future(future), &lua_await_resolve, &lua_await_reject, &resolved));
+
+			EXPECT_EQ((int)1, (int)resolved);
+
+			metacall_value_destroy(future);
+
+			static const char buffer[] =
+				"function luaerror()\n"
+				"	error(\"lua await error\")\n"
+				"end\n";
+
+			ASSERT_EQ((int)0, (int)metacall_load_from_memory(tag, buffer, sizeof(buffer), NULL));
+
+			future = metacall_await("luaerror", metacall_null_args, &lua_await_resolve, &lua_await_reject, &rejected);
+
+			ASSERT_NE((void *)NULL, (void *)future);
+
+			EXPECT_EQ((int)1, (int)rejected);
+
+			metacall_value_destroy(future);
+
+			metacall_value_destroy(args[0]);
+			metacall_value_destroy(args[1]);
+		}
+
+		/* Cyclic and deeply nested tables are rejected instead of overflowing the stack */
+		{
+			static const char buffer[] =
+				"function luacycle()\n"
+				"	local t = { 1 }\n"
+				"	t[2] = t\n"
+				"	return t\n"
+				"end\n"
+				"function luanested(depth)\n"
+				"	local t = {}\n"
+				"	for i = 1, depth do\n"
+				"		t = { t }\n"
+				"	end\n"
+				"	return t\n"
+				"end\n";
+
+			ASSERT_EQ((int)0, (int)metacall_load_from_memory(tag, buffer, sizeof(buffer), NULL));
+
+			void *ret = metacall("luacycle");
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_THROWABLE, (enum metacall_value_id)metacall_value_id(ret));
+
+			metacall_value_destroy(ret);
+
+			const enum metacall_value_id nested_ids[] = {
+				METACALL_INT
+			};
+
+			ret = metacallt_s("luanested", nested_ids, 1, 10);
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_ARRAY, (enum metacall_value_id)metacall_value_id(ret));
+
+			metacall_value_destroy(ret);
+
+			ret = metacallt_s("luanested", nested_ids, 1, 100000);
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			EXPECT_EQ((enum metacall_value_id)METACALL_THROWABLE, (enum metacall_value_id)metacall_value_id(ret));
+
+			metacall_value_destroy(ret);
+		}
+
+		/* State pool */
+		{
+			static const char buffer[] =
+				"function luastate()\n"
+				"	return tostring(_G)\n"
+				"end\n";
+
+			ASSERT_EQ((int)0, (int)metacall_load_from_memory(tag, buffer, sizeof(buffer), NULL));
+
+			void *ret = metacall("luastate");
+
+			ASSERT_NE((void *)NULL, (void *)ret);
+
+			const std::string main_state(metacall_value_to_string(ret));
+
+			metacall_value_destroy(ret);
+
+			/* Concurrent threads get their own state and see the chunks loaded by the main thread */
+			const size_t thread_count = 8, call_count = 1000;
+
+			std::vector<std::thread> threads;
+			std::vector<int> failures(thread_count, 0);
+
+			for (size_t iterator = 0; iterator < thread_count; ++iterator)
+			{
+				threads.emplace_back([iterator, call_count, &failures]() {
+					const enum metacall_value_id int_ids[] = {
+						METACALL_INT, METACALL_INT
+					};
+
+					for (size_t call = 0; call < call_count; ++call)
+					{
+						void *ret = metacallt_s("luaadd", int_ids, 2, (int)iterator, (int)call);
+
+						if (ret == NULL || metacall_value_cast_long(&ret) != (long)(iterator + call))
+						{
+							++failures[iterator];
+						}
+
+						metacall_value_destroy(ret);
+					}
+				});
+			}
+
+			for (auto &thread : threads)
+			{
+				thread.join();
+			}
+
+			for (size_t iterator = 0; iterator < thread_count; ++iterator)
+			{
+				EXPECT_EQ((int)0, (int)failures[iterator]);
+			}
+
+			/* Threads which exit release their state, so more threads than the pool size never fall back into the main state */
+			std::set<std::string> states;
+
+			for (size_t iterator = 0; iterator < 0x80; ++iterator)
+			{
+				std::thread thread([&states]() {
+					void *ret = metacall("luastate");
+
+					ASSERT_NE((void *)NULL, (void *)ret);
+
+					states.insert(metacall_value_to_string(ret));
+
+					metacall_value_destroy(ret);
+				});
+
+				thread.join();
+			}
+
+			EXPECT_EQ((size_t)0, (size_t)states.count(main_state));
+
+			EXPECT_EQ((size_t)1, (size_t)states.size());
+		}
 	}
 #endif /* OPTION_BUILD_LOADERS_LUA */
 
@@ -0,0 +1,203 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <cstring>
+
+class metacall_metrics_test : public testing::Test
+{
+public:
+};
+
+static void *metacall_metrics_test_get(void *v, const char *key)
+{
+	void **v_map = metacall_value_to_map(v);
+
+	for (size_t iterator = 0; iterator < metacall_value_count(v); ++iterator)
+	{
+		void **tuple = metacall_value_to_array(v_map[iterator]);
+
+		if (strcmp(metacall_value_to_string(tuple[0]), key) == 0)
+		{
+			return tuple[1];
+		}
+	}
+
+	return NULL;
+}
+
+TEST_F(metacall_metrics_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	metacall_flags(METACALL_FLAGS_METRICS);
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+	EXPECT_NE((int)0, (int)metacall_metrics_enabled());
+
+/* Python */
+#if defined(OPTION_BUILD_LOADERS_PY)
+	{
+		static const char buffer[] =
+			"def py_metrics_multiply(a, b):\n"
+			"	return a * b\n"
+			"\n"
+			"def py_metrics_throw():\n"
+			"	raise TypeError('yeet')\n"
+			"\n"
+			"def py_metrics_unused():\n"
+			"	return 0\n"
+			"\n";
+
+		ASSERT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+		void *args[] = {
+			metacall_value_create_long(3L),
+			metacall_value_create_long(4L)
+		};
+
+		for (int iterator = 0; iterator < 10; ++iterator)
+		{
+			void *ret = metacallv_s("py_metrics_multiply", args, 2);
+
+			EXPECT_EQ((long)12, (long)metacall_value_to_long(ret));
+
+			metacall_value_destroy(ret);
+		}
+
+		for (int iterator = 0; iterator < 3; ++iterator)
+		{
+			metacall_value_destroy(metacall("py_metrics_throw"));
+		}
+
+		/* Per function and per loader metrics */
+		void *v = metacall_metrics();
+
+		ASSERT_NE((void *)NULL, (void *)v);
+
+		void *py = metacall_metrics_test_get(v, "py");
+
+		ASSERT_NE((void *)NULL, (void *)py);
+
+		void *functions = metacall_metrics_test_get(py, "functions");
+
+		ASSERT_NE((void *)NULL, (void *)functions);
+
+		/* Functions never called have no metrics */
+		EXPECT_EQ((void *)NULL, (void *)metacall_metrics_test_get(functions, "py_metrics_unused"));
+
+		void *multiply = metacall_metrics_test_get(functions, "py_metrics_multiply");
+
+		ASSERT_NE((void *)NULL, (void *)multiply);
+
+		EXPECT_EQ((long)10, (long)metacall_value_to_long(metacall_metrics_test_get(multiply, "calls")));
+		EXPECT_EQ((long)0, (long)metacall_value_to_long(metacall_metrics_test_get(multiply, "errors")));
+		EXPECT_EQ((long)0, (long)metacall_value_to_long(metacall_metrics_test_get(multiply, "in_flight")));
+		EXPECT_GT((long)metacall_value_to_long(metacall_metrics_test_get(multiply, "p99_ns")), (long)0);
+		EXPECT_GE((long)metacall_value_to_long(metacall_metrics_test_get(multiply, "p99_ns")),
+			(long)metacall_value_to_long(metacall_metrics_test_get(multiply, "p50_ns")));
+
+		void *py_throw = metacall_metrics_test_get(functions, "py_metrics_throw");
+
+		ASSERT_NE((void *)NULL, (void *)py_throw);
+
+		EXPECT_EQ((long)3, (long)metacall_value_to_long(metacall_metrics_test_get(py_throw, "calls")));
+		EXPECT_EQ((long)3, (long)metacall_value_to_long(metacall_metrics_test_get(py_throw, "errors")));
+
+		void *total = metacall_metrics_test_get(py, "total");
+
+		ASSERT_NE((void *)NULL, (void *)total);
+
+		EXPECT_EQ((long)13, (long)metacall_value_to_long(metacall_metrics_test_get(total, "calls")));
+		EXPECT_EQ((long)3, (long)metacall_value_to_long(metacall_metrics_test_get(total, "errors")));
+
+		/* The histogram holds one sample per finished call */
+		void *histogram = metacall_metrics_test_get(total, "histogram");
+		void **histogram_array = metacall_value_to_array(histogram);
+		long samples = 0;
+
+		for (size_t iterator = 0; iterator < metacall_value_count(histogram); ++iterator)
+		{
+			samples += metacall_value_to_long(metacall_value_to_array(histogram_array[iterator])[1]);
+		}
+
+		EXPECT_EQ((long)13, (long)samples);
+
+		metacall_value_destroy(v);
+
+		/* Inspect and Prometheus exporter */
+		struct metacall_allocator_std_type std_ctx = { &std::malloc, &std::realloc, &std::free };
+
+		void *allocator = metacall_allocator_create(METACALL_ALLOCATOR_STD, (void *)&std_ctx);
+
+		size_t size = 0;
+
+		char *inspect_str = metacall_inspect(&size, allocator);
+
+		ASSERT_NE((char *)NULL, (char *)inspect_str);
+
+		EXPECT_NE((char *)NULL, (char *)strstr(inspect_str, "\"metrics\""));
+
+		metacall_allocator_free(allocator, inspect_str);
+
+		char *prometheus_str = metacall_metrics_prometheus(&size, allocator);
+
+		ASSERT_NE((char *)NULL, (char *)prometheus_str);
+
+		EXPECT_EQ((size_t)strlen(prometheus_str) + 1, (size_t)size);
+
+		EXPECT_NE((char *)NULL, (char *)strstr(prometheus_str, "# TYPE metacall_function_call_duration_seconds histogram\n"));
+		EXPECT_NE((char *)NULL, (char *)strstr(prometheus_str, "metacall_function_calls_total{loader=\"py\",function=\"py_metrics_multiply\"} 10\n"));
+		EXPECT_NE((char *)NULL, (char *)strstr(prometheus_str, "metacall_function_errors_total{loader=\"py\",function=\"py_metrics_throw\"} 3\n"));
+		EXPECT_NE((char *)NULL, (char *)strstr(prometheus_str, "metacall_loader_call_duration_seconds_bucket{loader=\"py\",le=\"+Inf\"} 13\n"));
+		EXPECT_NE((char *)NULL, (char *)strstr(prometheus_str, "metacall_loader_call_duration_seconds_count{loader=\"py\"} 13\n"));
+
+		metacall_allocator_free(allocator, prometheus_str);
+
+		metacall_allocator_destroy(allocator);
+
+		/* Calls are not accounted once the metrics are disabled */
+		metacall_metrics_enable(0);
+
+		EXPECT_EQ((int)0, (int)metacall_metrics_enabled());
+
+		metacall_value_destroy(metacallv_s("py_metrics_multiply", args, 2));
+
+		metacall_value_destroy(args[0]);
+		metacall_value_destroy(args[1]);
+
+		v = metacall_metrics();
+
+		multiply = metacall_metrics_test_get(metacall_metrics_test_get(metacall_metrics_test_get(v, "py"), "functions"), "py_metrics_multiply");
+
+		EXPECT_EQ((long)10, (long)metacall_value_to_long(metacall_metrics_test_get(multiply, "calls")));
+
+		metacall_value_destroy(v);
+	}
+#endif /* OPTION_BUILD_LOADERS_PY */
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
@@ -0,0 +1,139 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <dirent.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#define NODE_CACHE_TEST_PATH "metacall_node_cache_test_cache"
+
+std::atomic<int> success_callbacks{};
+
+class metacall_node_cache_test : public testing::Test
+{
+public:
+};
+
+static size_t node_cache_test_entries()
+{
+	size_t count = 0;
+	DIR *dir = opendir(NODE_CACHE_TEST_PATH);
+
+	if (dir == NULL)
+	{
+		return 0;
+	}
+
+	for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+	{
+		if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+		{
+			++count;
+		}
+	}
+
+	closedir(dir);
+
+	return count;
+}
+
+TEST_F(metacall_node_cache_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	/* The bootstrap reads the cache directory when the loader is initialized */
+	ASSERT_EQ((int)0, (int)setenv("NODE_LOADER_CACHE_PATH", NODE_CACHE_TEST_PATH, 1));
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+/* NodeJS */
+#if defined(OPTION_BUILD_LOADERS_NODE)
+	{
+		const char buffer[] =
+			"const path = require('path');\n"
+			"function node_cache_join(a, b) {\n"
+			"\treturn path.posix.join(a, b);\n"
+			"}\n"
+			"async function node_cache_import() {\n"
+			"\tconst { posix } = await import('path');\n"
+			"\treturn posix.join('c', 'd');\n"
+			"}\n"
+			"module.exports = { node_cache_join, node_cache_import };\n";
+
+		ASSERT_EQ((int)0, (int)metacall_load_from_memory("node", buffer, sizeof(buffer), NULL));
+
+		void *ret = metacall("node_cache_join", "a", "b");
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_STREQ("a/b", metacall_value_to_string(ret));
+
+		metacall_value_destroy(ret);
+
+		/* Dynamic import must keep working in the scripts compiled with the code cache */
+		void *future = metacall_await(
+			"node_cache_import",
+			metacall_null_args,
+			[](void *result, void *) -> void * {
+				EXPECT_NE((void *)NULL, (void *)result);
+
+				EXPECT_EQ((enum metacall_value_id)METACALL_STRING, (enum metacall_value_id)metacall_value_id(result));
+
+				EXPECT_STREQ("c/d", metacall_value_to_string(result));
+
+				++success_callbacks;
+
+				return NULL;
+			},
+			[](void *, void *) -> void * {
+				int this_should_never_be_executed = 0;
+
+				EXPECT_EQ((int)1, (int)this_should_never_be_executed);
+
+				return NULL;
+			},
+			NULL);
+
+		EXPECT_NE((void *)NULL, (void *)future);
+
+		metacall_value_destroy(future);
+	}
+#endif /* OPTION_BUILD_LOADERS_NODE */
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+
+/* NodeJS */
+#if defined(OPTION_BUILD_LOADERS_NODE)
+	{
+		EXPECT_EQ((int)1, (int)success_callbacks);
+
+		/* The code cache is written to disk once the script has been executed */
+		EXPECT_GT((size_t)node_cache_test_entries(), (size_t)0);
+	}
+#endif /* OPTION_BUILD_LOADERS_NODE */
+}
@@ -0,0 +1,4 @@
+#!/usr/bin/env python3
+
+def pluginA_sum(a: int, b: int) -> int:
+	return a + b
@@ -0,0 +1,5 @@
+#!/usr/bin/env python3
+
+def pluginB():
+	print('Hello World from extensionB!!')
+	return 7
@@ -0,0 +1,204 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+class metacall_plugin_extension_manifest_test : public testing::Test
+{
+public:
+};
+
+static void *plugin_load(void *ext_handle)
+{
+	void *handle = NULL;
+
+	void *args[] = {
+		metacall_value_create_string(METACALL_PLUGIN_WORK_PATH, sizeof(METACALL_PLUGIN_WORK_PATH) - 1),
+		metacall_value_create_ptr(&handle)
+	};
+
+	void *result = metacallhv_s(ext_handle, "plugin_load_from_path", args, sizeof(args) / sizeof(args[0]));
+
+	EXPECT_NE((void *)NULL, (void *)result);
+
+	EXPECT_EQ((enum metacall_value_id)METACALL_INT, (enum metacall_value_id)metacall_value_id(result));
+
+	EXPECT_EQ((int)0, (int)metacall_value_to_int(result));
+
+	metacall_value_destroy(args[0]);
+	metacall_value_destroy(args[1]);
+	metacall_value_destroy(result);
+
+	return handle;
+}
+
+static void plugin_call(void *handle, long sum)
+{
+	ASSERT_NE((void *)NULL, (void *)handle);
+
+	{
+		void *args[] = {
+			metacall_value_create_long(3),
+			metacall_value_create_long(4)
+		};
+
+		void *ret = metacallhv_s(handle, "pluginA_sum", args, sizeof(args) / sizeof(args[0]));
+
+		EXPECT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_LONG, (enum metacall_value_id)metacall_value_id(ret));
+
+		EXPECT_EQ((long)sum, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(args[0]);
+		metacall_value_destroy(args[1]);
+		metacall_value_destroy(ret);
+	}
+
+	{
+		void *ret = metacallhv_s(handle, "pluginB", metacall_null_args, 0);
+
+		EXPECT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_LONG, (enum metacall_value_id)metacall_value_id(ret));
+
+		EXPECT_EQ((long)7, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+	}
+}
+
+TEST_F(metacall_plugin_extension_manifest_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	/* Start without manifest, so the first load scans the plugin folder */
+	std::error_code ec;
+
+	fs::remove_all(METACALL_PLUGIN_CACHE_PATH, ec);
+
+	/* Work on a copy of the plugins, so they can be modified */
+	fs::remove_all(METACALL_PLUGIN_WORK_PATH, ec);
+
+	fs::copy(METACALL_PLUGIN_PATH, METACALL_PLUGIN_WORK_PATH, fs::copy_options::recursive, ec);
+
+	ASSERT_EQ((bool)false, (bool)ec);
+
+	/* Load eagerly and generate the manifest */
+	{
+		ASSERT_EQ((int)0, (int)metacall_initialize());
+
+		void *ext_handle = metacall_plugin_extension();
+
+		ASSERT_NE((void *)NULL, (void *)ext_handle);
+
+		void *handle = plugin_load(ext_handle);
+
+		EXPECT_EQ((bool)true, (bool)fs::is_directory(METACALL_PLUGIN_CACHE_PATH));
+
+		EXPECT_EQ((bool)false, (bool)fs::is_empty(METACALL_PLUGIN_CACHE_PATH));
+
+		plugin_call(handle, 7);
+
+		EXPECT_EQ((int)0, (int)metacall_destroy());
+	}
+
+	/* Load again from the manifest, plugins are registered lazily */
+	{
+		ASSERT_EQ((int)0, (int)metacall_initialize());
+
+		void *ext_handle = metacall_plugin_extension();
+
+		ASSERT_NE((void *)NULL, (void *)ext_handle);
+
+		void *handle = plugin_load(ext_handle);
+
+		ASSERT_NE((void *)NULL, (void *)handle);
+
+		/* The plugin runtime is not initialized until the first call */
+		EXPECT_NE((int)0, (int)metacall_is_initialized("py"));
+
+		void *func = metacall_handle_function(handle, "pluginA_sum");
+
+		ASSERT_NE((void *)NULL, (void *)func);
+
+		EXPECT_EQ((size_t)2, (size_t)metacall_function_size(func));
+
+		plugin_call(handle, 7);
+
+		EXPECT_EQ((int)0, (int)metacall_destroy());
+	}
+
+	/* Modify a plugin script, the manifest is not valid anymore */
+	{
+		std::ofstream script(METACALL_PLUGIN_WORK_PATH "/test_pluginA/pluginA.py", std::ios::trunc);
+
+		script << "def pluginA_sum(a: int, b: int) -> int:\n"
+				  "\treturn a + b + 1\n";
+	}
+
+	/* Load eagerly from the folder and generate the manifest again */
+	{
+		ASSERT_EQ((int)0, (int)metacall_initialize());
+
+		void *ext_handle = metacall_plugin_extension();
+
+		ASSERT_NE((void *)NULL, (void *)ext_handle);
+
+		void *handle = plugin_load(ext_handle);
+
+		ASSERT_NE((void *)NULL, (void *)handle);
+
+		EXPECT_EQ((int)0, (int)metacall_is_initialized("py"));
+
+		plugin_call(handle, 8);
+
+		EXPECT_EQ((int)0, (int)metacall_destroy());
+	}
+
+	/* The new manifest describes the modified plugin */
+	{
+		ASSERT_EQ((int)0, (int)metacall_initialize());
+
+		void *ext_handle = metacall_plugin_extension();
+
+		ASSERT_NE((void *)NULL, (void *)ext_handle);
+
+		void *handle = plugin_load(ext_handle);
+
+		ASSERT_NE((void *)NULL, (void *)handle);
+
+		EXPECT_NE((int)0, (int)metacall_is_initialized("py"));
+
+		plugin_call(handle, 8);
+
+		EXPECT_EQ((int)0, (int)metacall_destroy());
+	}
+
+	fs::remove_all(METACALL_PLUGIN_WORK_PATH, ec);
+}
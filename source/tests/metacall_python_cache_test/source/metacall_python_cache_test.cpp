@@ -0,0 +1,185 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_value.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define PY_CACHE_TEST_PATH "metacall_python_cache_test_cache"
+
+/* Magic number, hash, name size and source size, followed by the name, the source and the marshaled code */
+#define PY_CACHE_TEST_HEADER_SIZE (sizeof(long) + sizeof(uint64_t) * 3)
+
+class metacall_python_cache_test : public testing::Test
+{
+public:
+};
+
+static const char buffer[] =
+	"def py_cache_multiply(a: int, b: int) -> int:\n"
+	"	return a * b\n"
+	"\n";
+
+static std::vector<std::string> py_cache_test_entries()
+{
+	std::vector<std::string> entries;
+	DIR *dir = opendir(PY_CACHE_TEST_PATH);
+
+	if (dir == NULL)
+	{
+		return entries;
+	}
+
+	for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+	{
+		std::string name(entry->d_name);
+
+		if (name.size() > 8 && name.compare(name.size() - 8, 8, ".marshal") == 0)
+		{
+			entries.push_back(std::string(PY_CACHE_TEST_PATH "/") + name);
+		}
+	}
+
+	closedir(dir);
+
+	return entries;
+}
+
+static std::string py_cache_test_read(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void py_cache_test_write(const std::string &path, const std::string &data)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	file << data;
+}
+
+static int py_cache_test_load()
+{
+	if (metacall_initialize() != 0)
+	{
+		return 1;
+	}
+
+	if (metacall_load_from_memory("py", buffer, sizeof(buffer), NULL) != 0)
+	{
+		return 1;
+	}
+
+	void *ret = metacall("py_cache_multiply", 3L, 4L);
+
+	int result = (ret != NULL && metacall_value_id(ret) == METACALL_LONG && metacall_value_to_long(ret) == 12L) ? 0 : 1;
+
+	metacall_value_destroy(ret);
+
+	return metacall_destroy() != 0 || result;
+}
+
+TEST_F(metacall_python_cache_test, DefaultConstructor)
+{
+	for (const std::string &entry : py_cache_test_entries())
+	{
+		unlink(entry.c_str());
+	}
+
+	ASSERT_EQ((int)0, (int)setenv("PY_LOADER_CACHE_PATH", PY_CACHE_TEST_PATH, 1));
+
+	/* Populate the cache in a child process, so this process can initialize the Python loader from it */
+	pid_t pid = fork();
+
+	ASSERT_NE((pid_t)-1, (pid_t)pid);
+
+	if (pid == 0)
+	{
+		_exit(py_cache_test_load());
+	}
+
+	int status = 0;
+
+	ASSERT_EQ((pid_t)pid, (pid_t)waitpid(pid, &status, 0));
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ((int)0, (int)WEXITSTATUS(status));
+
+	/* At least the modules of the loader itself are compiled from memory */
+	std::vector<std::string> entries = py_cache_test_entries();
+
+	ASSERT_GE((size_t)entries.size(), (size_t)2);
+
+	/* Simulate hash collisions, each entry keeps its header and code but the source it was generated from is different */
+	std::vector<std::string> contents;
+
+	for (const std::string &entry : entries)
+	{
+		std::string content = py_cache_test_read(entry);
+		uint64_t name_size;
+
+		ASSERT_GT((size_t)content.size(), (size_t)PY_CACHE_TEST_HEADER_SIZE);
+
+		memcpy(&name_size, &content[sizeof(long) + sizeof(uint64_t)], sizeof(uint64_t));
+
+		ASSERT_GT((size_t)content.size(), (size_t)(PY_CACHE_TEST_HEADER_SIZE + name_size));
+
+		contents.push_back(content);
+
+		content[PY_CACHE_TEST_HEADER_SIZE + name_size] ^= 0x20;
+
+		py_cache_test_write(entry, content);
+	}
+
+	/* The collisions are detected and the sources are compiled again */
+	EXPECT_EQ((int)0, (int)py_cache_test_load());
+
+	/* The entries of the loader modules are written again, the memory module name depends on the loader address so it may differ */
+	size_t rewritten = 0;
+
+	for (size_t iterator = 0; iterator < entries.size(); ++iterator)
+	{
+		if (py_cache_test_read(entries[iterator]) == contents[iterator])
+		{
+			++rewritten;
+		}
+
+		unlink(entries[iterator].c_str());
+	}
+
+	EXPECT_GE((size_t)rewritten, (size_t)2);
+
+	rmdir(PY_CACHE_TEST_PATH);
+}
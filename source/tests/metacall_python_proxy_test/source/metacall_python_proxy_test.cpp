@@ -0,0 +1,303 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+
+class metacall_python_proxy_test : public testing::Test
+{
+public:
+};
+
+static void *create_long_array(const long *values, size_t size)
+{
+	void *v = metacall_value_create_array(NULL, size);
+	void **array = metacall_value_to_array(v);
+
+	for (size_t iterator = 0; iterator < size; ++iterator)
+	{
+		array[iterator] = metacall_value_create_long(values[iterator]);
+	}
+
+	return v;
+}
+
+static void *create_map(const char *keys[], const long *values, size_t size)
+{
+	void *v = metacall_value_create_map(NULL, size);
+	void **map = metacall_value_to_map(v);
+
+	for (size_t iterator = 0; iterator < size; ++iterator)
+	{
+		map[iterator] = metacall_value_create_array(NULL, 2);
+
+		void **pair = metacall_value_to_array(map[iterator]);
+
+		pair[0] = metacall_value_create_string(keys[iterator], strlen(keys[iterator]));
+		pair[1] = metacall_value_create_long(values[iterator]);
+	}
+
+	return v;
+}
+
+TEST_F(metacall_python_proxy_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+/* Python */
+#if defined(OPTION_BUILD_LOADERS_PY)
+	{
+		static const char buffer[] =
+			"import collections.abc\n"
+			"def kind(a):\n"
+			"	return type(a).__name__\n"
+			"def is_sequence(a):\n"
+			"	return isinstance(a, collections.abc.Sequence) and not isinstance(a, list)\n"
+			"def is_mapping(m):\n"
+			"	return isinstance(m, collections.abc.Mapping) and not isinstance(m, dict)\n"
+			"def first_last(a):\n"
+			"	return a[0] + a[-1] + len(a)\n"
+			"def slice_sum(a):\n"
+			"	return sum(a[1:4]) + sum(a)\n"
+			"def nested(a):\n"
+			"	return a[1][1]\n"
+			"def lookup(m):\n"
+			"	return m['b'] + m.get('z', 100) + ('a' in m) + len(m.keys())\n"
+			"def items(m):\n"
+			"	return sum(v for k, v in m.items()) + sum(m.values()) + len([k for k in m])\n"
+			"def sequence_mixins(a):\n"
+			"	return a.index(3) + a.count(2) + (4 in a) + (9 in a) + list(reversed(a))[0] + sum(iter(a))\n"
+			"def mapping_mixins(m):\n"
+			"	return (m == {'a': 1, 'b': 2, 'c': 3}) + (m != {'a': 1}) + (m == m) + ({'a': 1, 'b': 2, 'c': 3} == m)\n"
+			"kept = None\n"
+			"def keep(a):\n"
+			"	global kept\n"
+			"	kept = a\n"
+			"def kept_sum():\n"
+			"	return sum(kept)\n"
+			"def identity(a):\n"
+			"	return a\n"
+			"made = None\n"
+			"def make_list():\n"
+			"	global made\n"
+			"	made = [1, 2, 3, 4, 5]\n"
+			"	return made\n"
+			"def make_dict():\n"
+			"	global made\n"
+			"	made = {'a': 1, 'b': 2, 'c': 3}\n"
+			"	return made\n"
+			"def is_made(a):\n"
+			"	return a is made\n";
+
+		ASSERT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+		static const long numbers[] = { 1, 2, 3, 4, 5 };
+		static const char *keys[] = { "a", "b", "c" };
+
+		/* Arrays and maps above the threshold are converted into lazy views */
+		void *args[] = { create_long_array(numbers, 5) };
+		void *ret = metacallv_s("kind", args, 1);
+
+		EXPECT_STREQ("ArrayProxy", metacall_value_to_string(ret));
+
+		metacall_value_destroy(ret);
+
+		ret = metacallv_s("is_sequence", args, 1);
+
+		EXPECT_EQ((boolean)1, (boolean)metacall_value_to_bool(ret));
+
+		metacall_value_destroy(ret);
+
+		ret = metacallv_s("first_last", args, 1);
+
+		EXPECT_EQ((long)11, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		ret = metacallv_s("slice_sum", args, 1);
+
+		EXPECT_EQ((long)24, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		/* The methods of collections.abc.Sequence are available although they are not inherited */
+		ret = metacallv_s("sequence_mixins", args, 1);
+
+		EXPECT_EQ((long)24, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		/* Passing back a lazy view shares the original value instead of converting it */
+		ret = metacallv_s("identity", args, 1);
+
+		ASSERT_EQ((enum metacall_value_id)METACALL_ARRAY, (enum metacall_value_id)metacall_value_id(ret));
+		EXPECT_EQ((size_t)5, (size_t)metacall_value_count(ret));
+		EXPECT_EQ((long)5, (long)metacall_value_to_long(metacall_value_to_array(ret)[4]));
+
+		metacall_value_destroy(ret);
+		metacall_value_destroy(args[0]);
+
+		/* Arrays below the threshold keep being converted eagerly */
+		args[0] = create_long_array(numbers, 1);
+		ret = metacallv_s("kind", args, 1);
+
+		EXPECT_STREQ("list", metacall_value_to_string(ret));
+
+		metacall_value_destroy(ret);
+		metacall_value_destroy(args[0]);
+
+		/* Nested arrays are converted lazily when they are accessed */
+		args[0] = metacall_value_create_array(NULL, 2);
+
+		void **nested = metacall_value_to_array(args[0]);
+
+		nested[0] = create_long_array(numbers, 2);
+		nested[1] = create_long_array(&numbers[2], 3);
+
+		ret = metacallv_s("nested", args, 1);
+
+		EXPECT_EQ((long)4, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+		metacall_value_destroy(args[0]);
+
+		/* Maps */
+		args[0] = create_map(keys, numbers, 3);
+		ret = metacallv_s("is_mapping", args, 1);
+
+		EXPECT_EQ((boolean)1, (boolean)metacall_value_to_bool(ret));
+
+		metacall_value_destroy(ret);
+
+		ret = metacallv_s("lookup", args, 1);
+
+		EXPECT_EQ((long)106, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		ret = metacallv_s("items", args, 1);
+
+		EXPECT_EQ((long)15, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		ret = metacallv_s("mapping_mixins", args, 1);
+
+		EXPECT_EQ((long)4, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		ret = metacallv_s("identity", args, 1);
+
+		ASSERT_EQ((enum metacall_value_id)METACALL_MAP, (enum metacall_value_id)metacall_value_id(ret));
+		EXPECT_EQ((size_t)3, (size_t)metacall_value_count(ret));
+
+		metacall_value_destroy(ret);
+		metacall_value_destroy(args[0]);
+
+		/* A lazy view kept by Python outlives the arena where its value was allocated */
+		void *arena = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)arena);
+
+		args[0] = create_long_array(numbers, 5);
+		ret = metacallv_s("keep", args, 1);
+
+		metacall_value_destroy(ret);
+		metacall_value_destroy(args[0]);
+
+		metacall_arena_end(arena);
+
+		ret = metacallv_s("kept_sum", metacall_null_args, 0);
+
+		EXPECT_EQ((long)15, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		/* Python lists above the threshold are returned as views of the list */
+		void *list = metacall("make_list");
+
+		ASSERT_EQ((enum metacall_value_id)METACALL_ARRAY, (enum metacall_value_id)metacall_value_id(list));
+		EXPECT_EQ((size_t)5, (size_t)metacall_value_count(list));
+
+		/* Passing back a view that has not been converted yet gives the same list */
+		args[0] = list;
+		ret = metacallv_s("is_made", args, 1);
+
+		EXPECT_EQ((boolean)1, (boolean)metacall_value_to_bool(ret));
+
+		metacall_value_destroy(ret);
+
+		/* Accessing the elements converts the whole view and detaches it from the list */
+		void **list_array = metacall_value_to_array(list);
+
+		for (size_t iterator = 0; iterator < 5; ++iterator)
+		{
+			EXPECT_EQ((long)numbers[iterator], (long)metacall_value_to_long(list_array[iterator]));
+		}
+
+		ret = metacallv_s("is_made", args, 1);
+
+		EXPECT_EQ((boolean)0, (boolean)metacall_value_to_bool(ret));
+
+		metacall_value_destroy(ret);
+		metacall_value_destroy(list);
+
+		/* Python dicts work the same way */
+		void *dict = metacall("make_dict");
+
+		ASSERT_EQ((enum metacall_value_id)METACALL_MAP, (enum metacall_value_id)metacall_value_id(dict));
+		EXPECT_EQ((size_t)3, (size_t)metacall_value_count(dict));
+
+		args[0] = dict;
+		ret = metacallv_s("is_made", args, 1);
+
+		EXPECT_EQ((boolean)1, (boolean)metacall_value_to_bool(ret));
+
+		metacall_value_destroy(ret);
+
+		void **dict_map = metacall_value_to_map(dict);
+
+		for (size_t iterator = 0; iterator < 3; ++iterator)
+		{
+			void **pair = metacall_value_to_array(dict_map[iterator]);
+
+			EXPECT_STREQ(keys[iterator], metacall_value_to_string(pair[0]));
+			EXPECT_EQ((long)numbers[iterator], (long)metacall_value_to_long(pair[1]));
+		}
+
+		ret = metacallv_s("is_made", args, 1);
+
+		EXPECT_EQ((boolean)0, (boolean)metacall_value_to_bool(ret));
+
+		metacall_value_destroy(ret);
+
+		/* Views that are never converted release the object when they are destroyed */
+		metacall_value_destroy(metacall("make_list"));
+		metacall_value_destroy(dict);
+	}
+#endif /* OPTION_BUILD_LOADERS_PY */
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
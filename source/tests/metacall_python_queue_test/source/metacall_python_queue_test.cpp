@@ -0,0 +1,159 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+
+class metacall_python_queue_test : public testing::Test
+{
+public:
+};
+
+TEST_F(metacall_python_queue_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+/* Python */
+#if defined(OPTION_BUILD_LOADERS_PY)
+	{
+		static const char buffer[] =
+			"def queue_sync(n):\n"
+			"\treturn n * 2\n"
+			"async def queue_async(n):\n"
+			"\treturn n + 1\n"
+			"async def queue_async_fail(n):\n"
+			"\traise Exception(n)\n";
+
+		static const size_t calls = 64;
+
+		ASSERT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+		void *q = metacall_queue_create();
+
+		ASSERT_NE((void *)NULL, (void *)q);
+
+		EXPECT_NE((int)-1, (int)metacall_queue_fd(q));
+
+		void *queue_sync = metacall_function("queue_sync");
+		void *queue_async = metacall_function("queue_async");
+		void *queue_async_fail = metacall_function("queue_async_fail");
+
+		/* Submit synchronous and asynchronous calls interleaved, tagged by index */
+		for (size_t iterator = 0; iterator < calls; ++iterator)
+		{
+			void *args[] = {
+				metacall_value_create_long((long)iterator)
+			};
+
+			void *func = iterator % 2 == 0 ? queue_sync : queue_async;
+
+			EXPECT_EQ((int)0, (int)metacall_queue_submit(q, func, args, 1, (void *)(iterator + 1)));
+
+			metacall_value_destroy(args[0]);
+		}
+
+		/* Submit a call that fails */
+		{
+			void *args[] = {
+				metacall_value_create_long(15L)
+			};
+
+			EXPECT_EQ((int)0, (int)metacall_queue_submit(q, queue_async_fail, args, 1, NULL));
+
+			metacall_value_destroy(args[0]);
+		}
+
+		/* Synchronous calls are not executed until the queue is reaped */
+		EXPECT_GE((size_t)metacall_queue_pending(q), (size_t)(calls / 2));
+
+		/* Reap all the completions in batches */
+		size_t resolved = 0, rejected = 0;
+
+		while (resolved + rejected < calls + 1)
+		{
+			struct metacall_completion_type completions[16];
+
+			size_t count = metacall_queue_wait(q, completions, sizeof(completions) / sizeof(completions[0]), 5000);
+
+			ASSERT_NE((size_t)0, (size_t)count);
+
+			for (size_t iterator = 0; iterator < count; ++iterator)
+			{
+				if (completions[iterator].tag == NULL)
+				{
+					EXPECT_EQ((enum metacall_completion_id)METACALL_COMPLETION_REJECT, (enum metacall_completion_id)completions[iterator].id);
+
+					++rejected;
+				}
+				else
+				{
+					long index = (long)((size_t)completions[iterator].tag - 1);
+
+					EXPECT_EQ((enum metacall_completion_id)METACALL_COMPLETION_RESOLVE, (enum metacall_completion_id)completions[iterator].id);
+
+					EXPECT_EQ((enum metacall_value_id)METACALL_LONG, (enum metacall_value_id)metacall_value_id(completions[iterator].result));
+
+					EXPECT_EQ((long)(index % 2 == 0 ? index * 2 : index + 1), (long)metacall_value_to_long(completions[iterator].result));
+
+					++resolved;
+				}
+
+				if (completions[iterator].result != NULL)
+				{
+					metacall_value_destroy(completions[iterator].result);
+				}
+			}
+		}
+
+		EXPECT_EQ((size_t)calls, (size_t)resolved);
+
+		EXPECT_EQ((size_t)1, (size_t)rejected);
+
+		EXPECT_EQ((size_t)0, (size_t)metacall_queue_pending(q));
+
+		metacall_queue_destroy(q);
+
+		/* Deferred calls are discarded if the queue is destroyed before reaping them */
+		q = metacall_queue_create();
+
+		ASSERT_NE((void *)NULL, (void *)q);
+
+		{
+			void *args[] = {
+				metacall_value_create_long(3L)
+			};
+
+			EXPECT_EQ((int)0, (int)metacall_queue_submit(q, queue_sync, args, 1, NULL));
+
+			metacall_value_destroy(args[0]);
+		}
+
+		EXPECT_EQ((size_t)1, (size_t)metacall_queue_pending(q));
+
+		metacall_queue_destroy(q);
+	}
+#endif /* OPTION_BUILD_LOADERS_PY */
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
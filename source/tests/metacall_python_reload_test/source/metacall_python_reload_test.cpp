@@ -0,0 +1,175 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+
+#include <loader/loader_impl.h>
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+class metacall_python_reload_test : public testing::Test
+{
+public:
+	static void write_script(const char *body)
+	{
+		std::ofstream script(METACALL_PYTHON_RELOAD_TEST_PATH "/" METACALL_PYTHON_RELOAD_TEST_NAME, std::ios::out | std::ios::trunc);
+
+		script << body;
+	}
+
+	static long call_value(void *handle)
+	{
+		void *ret = metacallhv_s(handle, "reload_value", metacall_null_args, 0);
+
+		EXPECT_NE((void *)NULL, (void *)ret);
+
+		if (ret == NULL)
+		{
+			return 0L;
+		}
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_LONG, (enum metacall_value_id)metacall_value_id(ret));
+
+		long result = metacall_value_to_long(ret);
+
+		metacall_value_destroy(ret);
+
+		return result;
+	}
+};
+
+TEST_F(metacall_python_reload_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+/* Python */
+#if defined(OPTION_BUILD_LOADERS_PY)
+	{
+		/* The script is not in the current working directory, it is found through the execution path */
+		const char *py_scripts[] = {
+			METACALL_PYTHON_RELOAD_TEST_NAME
+		};
+
+		void *handle = NULL;
+
+		ASSERT_EQ((int)0, (int)metacall_execution_path("py", METACALL_PYTHON_RELOAD_TEST_PATH));
+
+		/* All the versions have the same size and are written within the same second, so the bytecode cache must be validated by content */
+		write_script("def reload_value():\n\treturn 1\n");
+
+		ASSERT_EQ((int)0, (int)metacall_load_from_file("py", py_scripts, sizeof(py_scripts) / sizeof(py_scripts[0]), &handle));
+
+		EXPECT_EQ((long)1L, (long)call_value(handle));
+
+		void *func = metacall_handle_function(handle, "reload_value");
+
+		ASSERT_NE((void *)NULL, (void *)func);
+
+		size_t generation = metacall_generation();
+
+		/* Explicit reload */
+		write_script("def reload_value():\n\treturn 2\n");
+
+		EXPECT_EQ((int)0, (int)metacall_reload(handle));
+
+		/* Cached functions are outdated after a reload */
+		EXPECT_NE((size_t)generation, (size_t)metacall_generation());
+
+		EXPECT_EQ((long)2L, (long)call_value(handle));
+
+		/* Functions obtained before the reload are kept alive until the next reload */
+		void *ret = metacallfv_s(func, metacall_null_args, 0);
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((long)1L, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		/* Previous versions are released once nothing references them, only the last replaced one is kept */
+		const size_t reload_count = 10;
+
+		for (size_t iterator = 0; iterator < reload_count; ++iterator)
+		{
+			EXPECT_EQ((int)0, (int)metacall_reload(handle));
+		}
+
+		EXPECT_EQ((size_t)1, (size_t)loader_impl_handle_retired_size(handle));
+
+		/* A version whose function is held by a value is kept until the value is destroyed */
+		void *func_value = metacall_value_create_function(metacall_handle_function(handle, "reload_value"));
+
+		ASSERT_NE((void *)NULL, (void *)func_value);
+
+		for (size_t iterator = 0; iterator < reload_count; ++iterator)
+		{
+			EXPECT_EQ((int)0, (int)metacall_reload(handle));
+		}
+
+		EXPECT_EQ((size_t)2, (size_t)loader_impl_handle_retired_size(handle));
+
+		ret = metacallfv_s(metacall_value_to_function(func_value), metacall_null_args, 0);
+
+		ASSERT_NE((void *)NULL, (void *)ret);
+
+		EXPECT_EQ((long)2L, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+
+		metacall_value_destroy(func_value);
+
+		EXPECT_EQ((int)0, (int)metacall_reload(handle));
+
+		EXPECT_EQ((size_t)1, (size_t)loader_impl_handle_retired_size(handle));
+
+		/* Reload driven by the file system watcher */
+		if (metacall_watch(handle) == 0)
+		{
+			long value = 0L;
+
+			write_script("def reload_value():\n\treturn 3\n");
+
+			for (int retry = 0; retry < 50 && value != 3L; ++retry)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+				value = call_value(handle);
+			}
+
+			EXPECT_EQ((long)3L, (long)value);
+		}
+
+		generation = metacall_generation();
+
+		EXPECT_EQ((int)0, (int)metacall_clear(handle));
+
+		EXPECT_NE((size_t)generation, (size_t)metacall_generation());
+	}
+#endif /* OPTION_BUILD_LOADERS_PY */
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
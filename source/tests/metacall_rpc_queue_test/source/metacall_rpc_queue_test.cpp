@@ -0,0 +1,164 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_loaders.h>
+#include <metacall/metacall_queue.h>
+#include <metacall/metacall_value.h>
+
+class metacall_rpc_queue_test : public testing::Test
+{
+public:
+};
+
+TEST_F(metacall_rpc_queue_test, DefaultConstructor)
+{
+	metacall_print_info();
+
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+/* RPC */
+#if defined(OPTION_BUILD_LOADERS_RPC)
+	{
+		static const char buffer[] = "http://localhost:6095/viferga/queue/v1";
+
+		static const size_t calls = 32;
+
+		ASSERT_EQ((int)0, (int)metacall_load_from_memory("rpc", buffer, sizeof(buffer), NULL));
+
+		void *q = metacall_queue_create();
+
+		ASSERT_NE((void *)NULL, (void *)q);
+
+		void *queue_sum = metacall_function("queue_sum");
+		void *queue_sleep = metacall_function("queue_sleep");
+		void *queue_fail = metacall_function("queue_fail");
+
+		ASSERT_NE((void *)NULL, (void *)queue_sum);
+		ASSERT_NE((void *)NULL, (void *)queue_sleep);
+		ASSERT_NE((void *)NULL, (void *)queue_fail);
+
+		EXPECT_EQ((int)0, (int)metacall_function_async(queue_sum));
+		EXPECT_EQ((int)1, (int)metacall_function_async(queue_sleep));
+
+		/* Submit synchronous calls and asynchronous calls (driven by the await worker) interleaved, tagged by index */
+		for (size_t iterator = 0; iterator < calls; ++iterator)
+		{
+			void *args[] = {
+				metacall_value_create_int((int)iterator),
+				metacall_value_create_int(1)
+			};
+
+			void *func = iterator % 2 == 0 ? queue_sum : queue_sleep;
+
+			EXPECT_EQ((int)0, (int)metacall_queue_submit(q, func, args, 2, (void *)(iterator + 1)));
+
+			metacall_value_destroy(args[0]);
+			metacall_value_destroy(args[1]);
+		}
+
+		/* Submit a call whose endpoint fails */
+		EXPECT_EQ((int)0, (int)metacall_queue_submit(q, queue_fail, metacall_null_args, 0, NULL));
+
+		/* Reap all the completions in batches */
+		size_t resolved = 0, rejected = 0;
+
+		while (resolved + rejected < calls + 1)
+		{
+			struct metacall_completion_type completions[8];
+
+			size_t count = metacall_queue_wait(q, completions, sizeof(completions) / sizeof(completions[0]), 10000);
+
+			ASSERT_NE((size_t)0, (size_t)count);
+
+			for (size_t iterator = 0; iterator < count; ++iterator)
+			{
+				if (completions[iterator].tag == NULL)
+				{
+					EXPECT_EQ((enum metacall_completion_id)METACALL_COMPLETION_REJECT, (enum metacall_completion_id)completions[iterator].id);
+
+					++rejected;
+				}
+				else
+				{
+					long index = (long)((size_t)completions[iterator].tag - 1);
+
+					EXPECT_EQ((enum metacall_completion_id)METACALL_COMPLETION_RESOLVE, (enum metacall_completion_id)completions[iterator].id);
+
+					ASSERT_NE((void *)NULL, (void *)completions[iterator].result);
+
+					EXPECT_EQ((long)(index + 1), (long)metacall_value_cast_long(&completions[iterator].result));
+
+					++resolved;
+				}
+
+				if (completions[iterator].result != NULL)
+				{
+					metacall_value_destroy(completions[iterator].result);
+				}
+			}
+		}
+
+		EXPECT_EQ((size_t)calls, (size_t)resolved);
+
+		EXPECT_EQ((size_t)1, (size_t)rejected);
+
+		EXPECT_EQ((size_t)0, (size_t)metacall_queue_pending(q));
+
+		metacall_queue_destroy(q);
+
+		/* Calls still in flight when the loader is destroyed are rejected */
+		q = metacall_queue_create();
+
+		ASSERT_NE((void *)NULL, (void *)q);
+
+		{
+			void *args[] = {
+				metacall_value_create_int(1),
+				metacall_value_create_int(2)
+			};
+
+			EXPECT_EQ((int)0, (int)metacall_queue_submit(q, queue_sleep, args, 2, NULL));
+
+			metacall_value_destroy(args[0]);
+			metacall_value_destroy(args[1]);
+		}
+
+		EXPECT_EQ((int)0, (int)metacall_destroy());
+
+		struct metacall_completion_type completion;
+
+		EXPECT_EQ((size_t)1, (size_t)metacall_queue_poll(q, &completion, 1));
+
+		EXPECT_EQ((enum metacall_completion_id)METACALL_COMPLETION_REJECT, (enum metacall_completion_id)completion.id);
+
+		if (completion.result != NULL)
+		{
+			metacall_value_destroy(completion.result);
+		}
+
+		metacall_queue_destroy(q);
+	}
+#else
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+#endif /* OPTION_BUILD_LOADERS_RPC */
+}
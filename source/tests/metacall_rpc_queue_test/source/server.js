@@ -0,0 +1,96 @@
+const http = require('http');
+const port = 6095;
+
+const inspect = JSON.stringify({
+	py: [{
+		name: 'queue.py',
+		scope: {
+			name: 'global_namespace',
+			funcs: [
+				{
+					name: 'queue_sum',
+					signature: { ret: { type: { name: 'int', id: 3 } }, args: [{ name: 'left', type: { name: 'int', id: 3 } }, { name: 'right', type: { name: 'int', id: 3 } }] },
+					async: false
+				},
+				{
+					name: 'queue_sleep',
+					signature: { ret: { type: { name: 'int', id: 3 } }, args: [{ name: 'left', type: { name: 'int', id: 3 } }, { name: 'right', type: { name: 'int', id: 3 } }] },
+					async: true
+				},
+				{
+					name: 'queue_fail',
+					signature: { ret: { type: { name: '', id: 18 } }, args: [] },
+					async: true
+				}
+			],
+			classes: [],
+			objects: []
+		}
+	}]
+});
+
+const server = http.createServer((req, res) => {
+	req.on('error', err => {
+		console.error(err);
+		process.exit(1);
+	});
+
+	res.on('error', err => {
+		console.error(err);
+		process.exit(1);
+	});
+
+	const data = new Promise((resolve) => {
+		let body = [];
+
+		req.on('data', (chunk) => {
+			body.push(chunk);
+		}).on('end', () => {
+			resolve(Buffer.concat(body).toString());
+		});
+	});
+
+	if (req.method === 'GET') {
+		if (req.url === '/ready') {
+			res.end('OK');
+			return;
+		} else if (req.url === '/viferga/queue/v1/inspect') {
+			res.setHeader('Content-Type', 'application/json');
+			res.end(inspect);
+			return;
+		}
+	} else if (req.method === 'POST') {
+		if (req.url === '/viferga/queue/v1/call/queue_sum') {
+			data.then((body) => {
+				const [left, right] = JSON.parse(body);
+				res.setHeader('Content-Type', 'application/json');
+				res.end(JSON.stringify(left + right));
+			});
+			return;
+		} else if (req.url === '/viferga/queue/v1/await/queue_sleep') {
+			/* Reply after a delay, so all the asynchronous calls are in flight at the same time */
+			data.then((body) => {
+				const [left, right] = JSON.parse(body);
+				setTimeout(() => {
+					res.setHeader('Content-Type', 'application/json');
+					res.end(JSON.stringify(left + right));
+				}, 200);
+			});
+			return;
+		} else if (req.url === '/viferga/queue/v1/await/queue_fail') {
+			data.then(() => {
+				res.statusCode = 500;
+				res.setHeader('Content-Type', 'application/json');
+				res.end('"queue_fail"');
+			});
+			return;
+		}
+	}
+
+	console.error('Invalid request method or url:', req.method, req.url);
+	process.exit(1);
+});
+
+server.listen(port, () => {
+	console.log(`MetaCall server listening at ${port}`);
+});
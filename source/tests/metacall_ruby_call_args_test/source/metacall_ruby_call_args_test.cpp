@@ -0,0 +1,140 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+
+#include <string>
+#include <thread>
+
+#define RUBY_CALL_ARGS_TEST_SIZE 20
+
+class metacall_ruby_call_args_test : public testing::Test
+{
+protected:
+};
+
+static std::string ruby_call_args_test_function(const char *name, const char *prefix, const char *type, size_t first_typed)
+{
+	std::string params, body;
+
+	for (size_t iterator = 0; iterator < RUBY_CALL_ARGS_TEST_SIZE; ++iterator)
+	{
+		const std::string param = prefix + std::to_string(iterator);
+
+		params += (iterator > 0 ? ", " : "") + param + (iterator >= first_typed ? std::string(": ") + type : "");
+		body += (iterator > 0 ? " + " : "") + std::string("(") + param + " * " + std::to_string(iterator + 1) + ")";
+	}
+
+	return std::string("def ") + name + "(" + params + ")\n\treturn " + body + "\nend\n";
+}
+
+static void *ruby_call_args_test_call(const char *name)
+{
+	void *args[RUBY_CALL_ARGS_TEST_SIZE];
+
+	for (size_t iterator = 0; iterator < RUBY_CALL_ARGS_TEST_SIZE; ++iterator)
+	{
+		args[iterator] = metacall_value_create_int((int)iterator);
+	}
+
+	void *ret = metacallv_s(name, args, RUBY_CALL_ARGS_TEST_SIZE);
+
+	for (size_t iterator = 0; iterator < RUBY_CALL_ARGS_TEST_SIZE; ++iterator)
+	{
+		metacall_value_destroy(args[iterator]);
+	}
+
+	return ret;
+}
+
+TEST_F(metacall_ruby_call_args_test, DefaultConstructor)
+{
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+	/* More arguments than the stack buffer used by Ruby for small calls, positional, keyword and mixed */
+	const std::string script =
+		ruby_call_args_test_function("call_args_positional", "a", "", RUBY_CALL_ARGS_TEST_SIZE) +
+		ruby_call_args_test_function("call_args_keywords", "k", "Fixnum", 0) +
+		ruby_call_args_test_function("call_args_mixed", "m", "Fixnum", RUBY_CALL_ARGS_TEST_SIZE / 2);
+
+	ASSERT_EQ((int)0, (int)metacall_load_from_memory("rb", script.c_str(), script.size() + 1, NULL));
+
+	/* Sum of i * (i + 1) for i in [0, 20) */
+	const long expected = 2660L;
+
+	const char *functions[] = {
+		"call_args_positional",
+		"call_args_keywords",
+		"call_args_mixed"
+	};
+
+	for (const char *name : functions)
+	{
+		void *ret = ruby_call_args_test_call(name);
+
+		ASSERT_NE((void *)NULL, (void *)ret) << name;
+
+		EXPECT_EQ((long)expected, (long)metacall_value_cast_long(&ret)) << name;
+
+		metacall_value_destroy(ret);
+
+		/* The keyword hash is reused between calls, a second call must not see stale values */
+		ret = ruby_call_args_test_call(name);
+
+		ASSERT_NE((void *)NULL, (void *)ret) << name;
+
+		EXPECT_EQ((long)expected, (long)metacall_value_cast_long(&ret)) << name;
+
+		metacall_value_destroy(ret);
+	}
+
+	/* Threads not created by Ruby are rejected instead of running without the GVL, for all kind of calls */
+	std::thread thread([&functions]() {
+		for (const char *name : functions)
+		{
+			void *ret = ruby_call_args_test_call(name);
+
+			EXPECT_EQ((void *)NULL, (void *)ret) << name;
+
+			if (ret != NULL)
+			{
+				metacall_value_destroy(ret);
+			}
+		}
+	});
+
+	thread.join();
+
+	/* The rejection does not leave the interpreter in a broken state for the thread which owns it */
+	for (const char *name : functions)
+	{
+		void *ret = ruby_call_args_test_call(name);
+
+		ASSERT_NE((void *)NULL, (void *)ret) << name;
+
+		EXPECT_EQ((long)expected, (long)metacall_value_cast_long(&ret)) << name;
+
+		metacall_value_destroy(ret);
+	}
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
@@ -0,0 +1,259 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#define TRACE_PLUGIN_TEST_FILE "metacall_trace_plugin_test.json"
+
+class metacall_trace_plugin_test : public testing::Test
+{
+protected:
+};
+
+void *c_outer(size_t argc, void *args[], void *data)
+{
+	(void)argc;
+	(void)data;
+
+	/* Nested call from the host into Python, it must be a child span of this one */
+	return metacallv_s("py_inner", args, 1);
+}
+
+void *c_child(size_t argc, void *args[], void *data)
+{
+	(void)argc;
+	(void)args;
+	(void)data;
+
+	return metacall_value_create_long(0L);
+}
+
+static std::atomic<int> trace_plugin_test_resolved{ 0 };
+
+static void trace_plugin_test_call(void *handle, const char *name, void *args[], size_t size)
+{
+	void *ret = metacallhv_s(handle, name, args, size);
+
+	ASSERT_NE((void *)NULL, (void *)ret);
+	EXPECT_EQ((enum metacall_value_id)METACALL_INT, (enum metacall_value_id)metacall_value_id(ret));
+	EXPECT_EQ((int)0, (int)metacall_value_to_int(ret));
+
+	metacall_value_destroy(ret);
+}
+
+static void trace_plugin_test_trace(void *handle, double rate, size_t calls)
+{
+	void *args[] = {
+		metacall_value_create_string(TRACE_PLUGIN_TEST_FILE, sizeof(TRACE_PLUGIN_TEST_FILE) - 1),
+		metacall_value_create_double(rate)
+	};
+
+	trace_plugin_test_call(handle, "trace_start", args, 2);
+
+	metacall_value_destroy(args[0]);
+	metacall_value_destroy(args[1]);
+
+	void *value_args[] = {
+		metacall_value_create_long(3L)
+	};
+
+	for (size_t iterator = 0; iterator < calls; ++iterator)
+	{
+		void *ret = metacallv_s("c_outer", value_args, 1);
+
+		EXPECT_EQ((long)6, (long)metacall_value_to_long(ret));
+
+		metacall_value_destroy(ret);
+	}
+
+	metacall_value_destroy(value_args[0]);
+
+	trace_plugin_test_call(handle, "trace_flush", metacall_null_args, 0);
+	trace_plugin_test_call(handle, "trace_stop", metacall_null_args, 0);
+}
+
+static std::string trace_plugin_test_read()
+{
+	std::ifstream file(TRACE_PLUGIN_TEST_FILE);
+	std::stringstream buffer;
+
+	buffer << file.rdbuf();
+
+	return buffer.str();
+}
+
+TEST_F(metacall_trace_plugin_test, DefaultConstructor)
+{
+	ASSERT_EQ((int)0, (int)metacall_initialize());
+
+	void *handle = metacall_plugin_core();
+
+	ASSERT_NE((void *)NULL, (void *)handle);
+
+	static const char buffer[] =
+		"def py_inner(a):\n"
+		"	return a * 2\n"
+		"\n"
+		"import asyncio\n"
+		"async def py_async(a):\n"
+		"	await asyncio.sleep(0.01)\n"
+		"	return a * 2\n"
+		"\n";
+
+	ASSERT_EQ((int)0, (int)metacall_load_from_memory("py", buffer, sizeof(buffer), NULL));
+
+	ASSERT_EQ((int)0, (int)metacall_register("c_outer", c_outer, NULL, METACALL_LONG, 1, METACALL_LONG));
+
+	ASSERT_EQ((int)0, (int)metacall_register("c_child", c_child, NULL, METACALL_LONG, 0));
+
+	/* Trace all the calls */
+	trace_plugin_test_trace(handle, 1.0, 10);
+
+	std::string trace = trace_plugin_test_read();
+
+	EXPECT_EQ((char)'[', (char)trace.front());
+	EXPECT_NE(std::string::npos, trace.find("\"ph\":\"M\""));
+	EXPECT_EQ(std::string::npos, trace.find("trace_start"));
+
+	static const std::regex event("\\{\"name\":\"(\\w+)\",\"cat\":\"call\",\"ph\":\"X\"[^\\n]*\"args\":\\{\"span\":(\\d+),\"parent\":(\\d+),\"error\":0\\}\\}");
+
+	std::set<std::string> outer;
+	size_t inner = 0, nested = 0;
+
+	for (std::sregex_iterator it(trace.begin(), trace.end(), event), end; it != end; ++it)
+	{
+		const std::smatch &match = *it;
+
+		if (match[1] == "c_outer")
+		{
+			EXPECT_EQ("0", match[3].str());
+			outer.insert(match[2].str());
+		}
+	}
+
+	/* Each Python call must be the child of the host call which invoked it */
+	for (std::sregex_iterator it(trace.begin(), trace.end(), event), end; it != end; ++it)
+	{
+		const std::smatch &match = *it;
+
+		if (match[1] == "py_inner")
+		{
+			nested += outer.count(match[3].str());
+			++inner;
+		}
+	}
+
+	EXPECT_EQ((size_t)10, (size_t)outer.size());
+	EXPECT_EQ((size_t)10, (size_t)inner);
+	EXPECT_EQ((size_t)10, (size_t)nested);
+
+	/* Sample none of the calls */
+	trace_plugin_test_trace(handle, 0.0, 10);
+
+	trace = trace_plugin_test_read();
+
+	EXPECT_EQ(std::string::npos, trace.find("c_outer"));
+	EXPECT_EQ(std::string::npos, trace.find("py_inner"));
+	EXPECT_NE(std::string::npos, trace.find("]"));
+
+	/* Trace an await which is resolved in the thread of the Python event loop */
+	void *args[] = {
+		metacall_value_create_string(TRACE_PLUGIN_TEST_FILE, sizeof(TRACE_PLUGIN_TEST_FILE) - 1),
+		metacall_value_create_double(1.0)
+	};
+
+	trace_plugin_test_call(handle, "trace_start", args, 2);
+
+	metacall_value_destroy(args[0]);
+	metacall_value_destroy(args[1]);
+
+	void *value_args[] = {
+		metacall_value_create_long(3L)
+	};
+
+	void *future = metacall_await(
+		"py_async",
+		value_args,
+		[](void *result, void *) -> void * {
+			EXPECT_EQ((long)6, (long)metacall_value_to_long(result));
+
+			/* Calls done from the continuation are children of the await span, even if it runs in another thread */
+			void *ret = metacall("c_child");
+
+			metacall_value_destroy(ret);
+
+			trace_plugin_test_resolved.store(1);
+
+			return NULL;
+		},
+		[](void *, void *) -> void * {
+			int this_should_never_be_executed = 0;
+
+			EXPECT_EQ((int)1, (int)this_should_never_be_executed);
+
+			return NULL;
+		},
+		NULL);
+
+	ASSERT_NE((void *)NULL, (void *)future);
+
+	metacall_value_destroy(future);
+	metacall_value_destroy(value_args[0]);
+
+	for (size_t iterator = 0; iterator < 500 && trace_plugin_test_resolved.load() == 0; ++iterator)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	ASSERT_EQ((int)1, (int)trace_plugin_test_resolved.load());
+
+	trace_plugin_test_call(handle, "trace_stop", metacall_null_args, 0);
+
+	trace = trace_plugin_test_read();
+
+	static const std::regex await_event("\\{\"name\":\"py_async\",\"cat\":\"await\",\"ph\":\"(b|e)\"[^\\n]*\"tid\":(\\d+),\"args\":\\{\"span\":(\\d+),\"parent\":0,\"error\":0\\}\\}");
+	static const std::regex child_event("\\{\"name\":\"c_child\",\"cat\":\"call\",\"ph\":\"X\"[^\\n]*\"tid\":(\\d+),\"args\":\\{\"span\":(\\d+),\"parent\":(\\d+),\"error\":0\\}\\}");
+
+	std::smatch await_match, child_match;
+
+	/* The await is exported as an async begin and end pair */
+	ASSERT_TRUE(std::regex_search(trace, await_match, await_event));
+	EXPECT_EQ((size_t)2, (size_t)std::distance(std::sregex_iterator(trace.begin(), trace.end(), await_event), std::sregex_iterator()));
+
+	ASSERT_TRUE(std::regex_search(trace, child_match, child_event));
+	EXPECT_EQ(await_match[3].str(), child_match[3].str());
+	EXPECT_NE(await_match[2].str(), child_match[1].str());
+
+	std::remove(TRACE_PLUGIN_TEST_FILE);
+
+	EXPECT_EQ((int)0, (int)metacall_destroy());
+}
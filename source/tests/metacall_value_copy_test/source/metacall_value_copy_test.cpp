@@ -0,0 +1,223 @@
+/*
+ *	MetaCall Library by Parra Studios
+ *	A library for providing a foreign function interface calls.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <metacall/metacall.h>
+#include <metacall/metacall_value.h>
+
+#include <cstring>
+
+class metacall_value_copy_test : public testing::Test
+{
+public:
+};
+
+TEST_F(metacall_value_copy_test, DefaultConstructor)
+{
+	/* Copies duplicate the value, so they can be written in place */
+	{
+		void *array[] = {
+			metacall_value_create_long(7),
+			metacall_value_create_string("abc", 3)
+		};
+
+		void *v = metacall_value_create_array((const void **)array, sizeof(array) / sizeof(array[0]));
+
+		void *copy = metacall_value_copy(v);
+
+		EXPECT_NE((void *)v, (void *)copy);
+
+		void **copy_array = metacall_value_to_array(copy);
+
+		EXPECT_NE((void *)metacall_value_to_array(v)[0], (void *)copy_array[0]);
+
+		void *same = metacall_value_from_long(copy_array[0], 8);
+
+		EXPECT_EQ((void *)copy_array[0], (void *)same);
+
+		metacall_value_destroy(v);
+
+		EXPECT_EQ((long)8, (long)metacall_value_to_long(copy_array[0]));
+		EXPECT_EQ((int)0, (int)strcmp("abc", metacall_value_to_string(copy_array[1])));
+
+		metacall_value_destroy(copy);
+	}
+
+	/* Shared values are not duplicated until they are written */
+	{
+		void *v = metacall_value_create_long(3);
+
+		void *shared = metacall_value_share(v);
+
+		EXPECT_EQ((void *)v, (void *)shared);
+
+		shared = metacall_value_from_long(shared, 5);
+
+		EXPECT_NE((void *)v, (void *)shared);
+		EXPECT_EQ((long)3, (long)metacall_value_to_long(v));
+		EXPECT_EQ((long)5, (long)metacall_value_to_long(shared));
+
+		/* Once the value has a single owner it is written in place */
+		void *same = metacall_value_from_long(shared, 6);
+
+		EXPECT_EQ((void *)shared, (void *)same);
+		EXPECT_EQ((long)6, (long)metacall_value_to_long(shared));
+
+		metacall_value_destroy(v);
+		metacall_value_destroy(shared);
+	}
+
+	/* Shared arrays have their own list of elements, writing into it does not modify the original */
+	{
+		void *array[] = {
+			metacall_value_create_long(7),
+			metacall_value_create_string("abc", 3)
+		};
+
+		void *v = metacall_value_create_array((const void **)array, sizeof(array) / sizeof(array[0]));
+
+		void *shared = metacall_value_share(v);
+
+		EXPECT_NE((void *)v, (void *)shared);
+
+		void **v_array = metacall_value_to_array(v);
+		void **shared_array = metacall_value_to_array(shared);
+
+		/* Elements are shared until they are written */
+		EXPECT_EQ((void *)v_array[0], (void *)shared_array[0]);
+		EXPECT_EQ((void *)v_array[1], (void *)shared_array[1]);
+
+		/* Replacing an element only modifies the array where it is replaced */
+		metacall_value_destroy(shared_array[0]);
+		shared_array[0] = metacall_value_create_long(8);
+
+		/* Writing a shared element duplicates it, so it must be stored back */
+		shared_array[1] = metacall_value_from_string(shared_array[1], "def", 3);
+
+		EXPECT_NE((void *)v_array[1], (void *)shared_array[1]);
+
+		EXPECT_EQ((long)7, (long)metacall_value_to_long(v_array[0]));
+		EXPECT_EQ((int)0, (int)strcmp("abc", metacall_value_to_string(v_array[1])));
+		EXPECT_EQ((long)8, (long)metacall_value_to_long(shared_array[0]));
+		EXPECT_EQ((int)0, (int)strcmp("def", metacall_value_to_string(shared_array[1])));
+
+		metacall_value_destroy(v);
+		metacall_value_destroy(shared);
+	}
+
+	/* Shared maps have their own tuples too */
+	{
+		void *tuple[] = {
+			metacall_value_create_string("a", 1),
+			metacall_value_create_int(1)
+		};
+
+		void *tuples[] = {
+			metacall_value_create_array((const void **)tuple, sizeof(tuple) / sizeof(tuple[0]))
+		};
+
+		void *v = metacall_value_create_map((const void **)tuples, sizeof(tuples) / sizeof(tuples[0]));
+
+		void *shared = metacall_value_share(v);
+
+		void **v_tuple = metacall_value_to_array(metacall_value_to_map(v)[0]);
+		void **shared_tuple = metacall_value_to_array(metacall_value_to_map(shared)[0]);
+
+		EXPECT_NE((void *)v_tuple, (void *)shared_tuple);
+
+		shared_tuple[1] = metacall_value_from_int(shared_tuple[1], 2);
+
+		EXPECT_EQ((int)1, (int)metacall_value_to_int(v_tuple[1]));
+		EXPECT_EQ((int)2, (int)metacall_value_to_int(shared_tuple[1]));
+
+		metacall_value_destroy(v);
+		metacall_value_destroy(shared);
+	}
+
+	/* Casting a shared value leaves the other owners untouched */
+	{
+		void *v = metacall_value_create_int(9);
+
+		void *shared = metacall_value_share(v);
+
+		shared = metacall_value_cast(shared, METACALL_BUFFER);
+
+		ASSERT_NE((void *)NULL, (void *)shared);
+
+		EXPECT_EQ((enum metacall_value_id)METACALL_INT, (enum metacall_value_id)metacall_value_id(v));
+		EXPECT_EQ((enum metacall_value_id)METACALL_BUFFER, (enum metacall_value_id)metacall_value_id(shared));
+		EXPECT_EQ((int)9, (int)metacall_value_to_int(v));
+
+		metacall_value_destroy(v);
+		metacall_value_destroy(shared);
+	}
+
+	/* Values from an allocator scope are duplicated when shared out of it */
+	{
+		struct metacall_allocator_std_type std_ctx = { &std::malloc, &std::realloc, &std::free };
+
+		void *allocator = metacall_allocator_create(METACALL_ALLOCATOR_STD, (void *)&std_ctx);
+
+		void *previous = metacall_allocator_scope_begin(allocator);
+
+		void *v = metacall_value_create_double(1.5);
+
+		void *shared = metacall_value_share(v);
+
+		metacall_allocator_scope_end(previous);
+
+		EXPECT_EQ((void *)v, (void *)shared);
+
+		void *copy = metacall_value_share(v);
+
+		EXPECT_NE((void *)v, (void *)copy);
+		EXPECT_EQ((double)1.5, (double)metacall_value_to_double(copy));
+
+		metacall_value_destroy(shared);
+		metacall_value_destroy(v);
+		metacall_value_destroy(copy);
+
+		metacall_allocator_destroy(allocator);
+	}
+
+	/* Values shared inside an arena belong to it, even if the value comes from the heap */
+	{
+		void *v = metacall_value_create_string("abc", 3);
+
+		void *arena = metacall_arena_begin();
+
+		ASSERT_NE((void *)NULL, (void *)arena);
+
+		void *shared = metacall_value_share(v);
+
+		EXPECT_NE((void *)v, (void *)shared);
+		EXPECT_EQ((int)0, (int)strcmp("abc", metacall_value_to_string(shared)));
+
+		EXPECT_EQ((int)0, (int)metacall_arena_end(arena));
+
+		/* The heap value still has a single owner, so it is written in place */
+		void *same = metacall_value_from_string(v, "def", 3);
+
+		EXPECT_EQ((void *)v, (void *)same);
+
+		metacall_value_destroy(v);
+	}
+}
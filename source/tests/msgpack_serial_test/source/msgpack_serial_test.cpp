@@ -0,0 +1,204 @@
+/*
+ *	Reflect Library by Parra Studios
+ *	A library for provide reflection and metadata representation.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <serial/serial.h>
+
+#include <log/log.h>
+
+class msgpack_serial_test : public testing::Test
+{
+public:
+	const char *name()
+	{
+		return "msgpack";
+	}
+	const char *extension()
+	{
+		return "msgpack";
+	}
+};
+
+TEST_F(msgpack_serial_test, DefaultConstructor)
+{
+	EXPECT_EQ((int)0, (int)log_configure("metacall",
+						  log_policy_format_text(),
+						  log_policy_schedule_sync(),
+						  log_policy_storage_sequential(),
+						  log_policy_stream_stdio(stdout)));
+
+	// Create allocator
+	memory_allocator allocator = memory_allocator_std(&malloc, &realloc, &free);
+
+	EXPECT_NE((memory_allocator)NULL, (memory_allocator)allocator);
+
+	// Initialize serial
+	EXPECT_EQ((int)0, (int)serial_initialize());
+
+	// Create MessagePack serial
+	serial s = serial_create(name());
+
+	ASSERT_NE((serial)NULL, (serial)s);
+
+	EXPECT_EQ((int)0, (int)strcmp(name(), serial_name(s)));
+	EXPECT_EQ((int)0, (int)strcmp(extension(), serial_extension(s)));
+
+	// Array of scalars is encoded with the smallest representations
+	{
+		static const char hello_world[] = "hello world";
+
+		value value_list[] = {
+			value_create_int(244),
+			value_create_long(-1099511627776L),
+			value_create_double(6.8),
+			value_create_string(hello_world, sizeof(hello_world) - 1)
+		};
+
+		static const size_t value_list_size = sizeof(value_list) / sizeof(value_list[0]);
+
+		static const unsigned char msgpack_array_header[] = { 0x94, 0xcc, 0xf4, 0xd3 };
+		static const size_t msgpack_array_size = 1 + 2 + 9 + 9 + 12;
+
+		size_t serialize_size = 0;
+
+		value v = value_create_array(value_list, value_list_size);
+
+		char *buffer = serial_serialize(s, v, &serialize_size, allocator);
+
+		ASSERT_NE((char *)NULL, (char *)buffer);
+
+		EXPECT_EQ((size_t)msgpack_array_size, (size_t)serialize_size);
+
+		EXPECT_EQ((int)0, (int)memcmp(buffer, msgpack_array_header, sizeof(msgpack_array_header)));
+
+		value_type_destroy(v);
+
+		v = serial_deserialize(s, buffer, serialize_size, allocator);
+
+		ASSERT_NE((value)NULL, (value)v);
+
+		EXPECT_EQ((type_id)TYPE_ARRAY, (type_id)value_type_id(v));
+
+		EXPECT_EQ((size_t)value_list_size, (size_t)value_type_count(v));
+
+		value *v_array = value_to_array(v);
+
+		EXPECT_EQ((type_id)TYPE_INT, (type_id)value_type_id(v_array[0]));
+		EXPECT_EQ((int)244, (int)value_to_int(v_array[0]));
+
+		EXPECT_EQ((type_id)TYPE_LONG, (type_id)value_type_id(v_array[1]));
+		EXPECT_EQ((long)-1099511627776L, (long)value_to_long(v_array[1]));
+
+		EXPECT_EQ((type_id)TYPE_DOUBLE, (type_id)value_type_id(v_array[2]));
+		EXPECT_EQ((double)6.8, (double)value_to_double(v_array[2]));
+
+		EXPECT_EQ((type_id)TYPE_STRING, (type_id)value_type_id(v_array[3]));
+		EXPECT_EQ((int)0, (int)strcmp(hello_world, value_to_string(v_array[3])));
+
+		value_type_destroy(v);
+
+		memory_allocator_deallocate(allocator, buffer);
+	}
+
+	// Map with a binary payload
+	{
+		static const char map_key[] = "data";
+
+		static const char buffer_data[] = { 0x01, 0x02, 0x03, 0x04 };
+
+		value map_tupla[] = {
+			value_create_string(map_key, sizeof(map_key) - 1),
+			value_create_buffer(buffer_data, sizeof(buffer_data))
+		};
+
+		value map_tuples[] = {
+			value_create_array(map_tupla, sizeof(map_tupla) / sizeof(map_tupla[0]))
+		};
+
+		size_t serialize_size = 0;
+
+		value v = value_create_map(map_tuples, sizeof(map_tuples) / sizeof(map_tuples[0]));
+
+		char *buffer = serial_serialize(s, v, &serialize_size, allocator);
+
+		ASSERT_NE((char *)NULL, (char *)buffer);
+
+		value_type_destroy(v);
+
+		// Owned deserialization copies the binary payload
+		v = serial_deserialize(s, buffer, serialize_size, allocator);
+
+		ASSERT_NE((value)NULL, (value)v);
+
+		EXPECT_EQ((type_id)TYPE_MAP, (type_id)value_type_id(v));
+
+		value *v_tupla = value_to_array(value_to_map(v)[0]);
+
+		EXPECT_EQ((int)0, (int)strcmp(map_key, value_to_string(v_tupla[0])));
+		EXPECT_EQ((type_id)TYPE_BUFFER, (type_id)value_type_id(v_tupla[1]));
+		EXPECT_EQ((size_t)sizeof(buffer_data), (size_t)value_type_size(v_tupla[1]));
+		EXPECT_EQ((int)0, (int)memcmp(buffer_data, value_to_buffer(v_tupla[1]), sizeof(buffer_data)));
+
+		const char *payload = (const char *)value_to_buffer(v_tupla[1]);
+
+		EXPECT_FALSE(payload >= buffer && payload < buffer + serialize_size);
+
+		value_type_destroy(v);
+
+		// Borrowed deserialization references the serialized buffer
+		v = serial_deserialize_borrowed(s, buffer, serialize_size, allocator);
+
+		ASSERT_NE((value)NULL, (value)v);
+
+		v_tupla = value_to_array(value_to_map(v)[0]);
+
+		EXPECT_EQ((size_t)sizeof(buffer_data), (size_t)value_type_size(v_tupla[1]));
+
+		payload = (const char *)value_to_buffer(v_tupla[1]);
+
+		EXPECT_TRUE(payload >= buffer && payload < buffer + serialize_size);
+		EXPECT_EQ((int)0, (int)memcmp(buffer_data, payload, sizeof(buffer_data)));
+
+		value_type_destroy(v);
+
+		memory_allocator_deallocate(allocator, buffer);
+	}
+
+	// Malformed inputs are rejected
+	{
+		static const char msgpack_truncated[] = { (char)0x93, 0x01, 0x02 };
+		static const char msgpack_trailing[] = { 0x01, 0x02 };
+		static const char msgpack_ext[] = { (char)0xd4, 0x01, 0x02 };
+
+		EXPECT_EQ((value)NULL, (value)serial_deserialize(s, msgpack_truncated, sizeof(msgpack_truncated), allocator));
+		EXPECT_EQ((value)NULL, (value)serial_deserialize(s, msgpack_trailing, sizeof(msgpack_trailing), allocator));
+		EXPECT_EQ((value)NULL, (value)serial_deserialize(s, msgpack_ext, sizeof(msgpack_ext), allocator));
+	}
+
+	// Clear MessagePack serial
+	EXPECT_EQ((int)0, (int)serial_clear(s));
+
+	// Destroy serial
+	serial_destroy();
+
+	// Destroy allocator
+	memory_allocator_destroy(allocator);
+}
@@ -21,6 +21,7 @@
 #include <gtest/gtest.h>
 
 #include <reflect/reflect_function.h>
+#include <reflect/reflect_metrics.h>
 
 #include <log/log.h>
 
@@ -35,6 +36,10 @@ typedef struct example_arg_type
 
 typedef void (*function_example_ptr)(char, int, void *);
 
+static int function_example_await_reject = 0;
+static int function_example_rejected = 0;
+static int function_example_destroyed = 0;
+
 typedef struct function_impl_example_type
 {
 	function_example_ptr ptr;
@@ -80,15 +85,17 @@ function_return function_example_interface_invoke(function func, function_impl f
 
 function_return function_example_interface_await(function func, function_impl impl, function_args args, size_t size, function_resolve_callback resolve_callback, function_reject_callback reject_callback, void *context)
 {
-	/* TODO */
-
 	(void)func;
 	(void)impl;
 	(void)args;
 	(void)size;
 	(void)resolve_callback;
-	(void)reject_callback;
-	(void)context;
+
+	/* Fail the await, rejecting it before returning or without calling any callback */
+	if (function_example_await_reject != 0)
+	{
+		reject_callback(NULL, context);
+	}
 
 	return NULL;
 }
@@ -97,6 +104,8 @@ void function_example_interface_destroy(function func, function_impl func_impl)
 {
 	(void)func;
 
+	++function_example_destroyed;
+
 	free(func_impl);
 }
 
@@ -170,3 +179,49 @@ TEST_F(reflect_function_test, DefaultConstructor)
 		type_destroy(ptr_type);
 	}
 }
+
+TEST_F(reflect_function_test, AwaitInstrumentFailed)
+{
+	function_metrics_enable(1);
+
+	for (function_example_await_reject = 0; function_example_await_reject < 2; ++function_example_await_reject)
+	{
+		function_impl_example example_impl = (function_impl_example)malloc(sizeof(struct function_impl_example_type));
+		function f = function_create("example_await", 0, example_impl, &function_example_singleton);
+
+		ASSERT_NE((function)f, (function)NULL);
+		EXPECT_EQ((int)function_increment_reference(f), (int)0);
+
+		function_example_rejected = 0;
+		function_example_destroyed = 0;
+
+		function_args args = { NULL };
+
+		EXPECT_EQ((function_return)NULL, (function_return)function_await(
+											 f, args, 0, NULL, [](value, void *) -> value {
+												 ++function_example_rejected;
+												 return NULL;
+											 },
+											 NULL));
+
+		EXPECT_EQ((int)function_example_await_reject, (int)function_example_rejected);
+
+		/* The failed await is recorded once as an error and does not stay in flight */
+		struct metrics_snapshot_type snapshot = {};
+
+		ASSERT_NE((metrics)NULL, (metrics)function_metrics(f));
+
+		metrics_collect(function_metrics(f), &snapshot);
+
+		EXPECT_EQ((uint64_t)1, (uint64_t)snapshot.calls);
+		EXPECT_EQ((uint64_t)1, (uint64_t)snapshot.errors);
+		EXPECT_EQ((uint64_t)0, (uint64_t)snapshot.in_flight);
+
+		/* The await context does not keep the function alive once it has failed */
+		function_destroy(f);
+
+		EXPECT_EQ((int)1, (int)function_example_destroyed);
+	}
+
+	function_metrics_enable(0);
+}
@@ -0,0 +1,238 @@
+/*
+ *	Reflect Library by Parra Studios
+ *	A library for provide reflection and metadata representation.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <serial/serial.h>
+
+#include <log/log.h>
+
+#include <string>
+
+class simd_json_serial_test : public testing::Test
+{
+public:
+	const char *name()
+	{
+		return "simd_json";
+	}
+	const char *extension()
+	{
+		return "json";
+	}
+};
+
+TEST_F(simd_json_serial_test, DefaultConstructor)
+{
+	EXPECT_EQ((int)0, (int)log_configure("metacall",
+						  log_policy_format_text(),
+						  log_policy_schedule_sync(),
+						  log_policy_storage_sequential(),
+						  log_policy_stream_stdio(stdout)));
+
+	// Create allocator
+	memory_allocator allocator = memory_allocator_std(&malloc, &realloc, &free);
+
+	EXPECT_NE((memory_allocator)NULL, (memory_allocator)allocator);
+
+	// Initialize serial
+	EXPECT_EQ((int)0, (int)serial_initialize());
+
+	// Create SimdJSON serial
+	serial s = serial_create(name());
+
+	ASSERT_NE((serial)NULL, (serial)s);
+
+	EXPECT_EQ((int)0, (int)strcmp(name(), serial_name(s)));
+	EXPECT_EQ((int)0, (int)strcmp(extension(), serial_extension(s)));
+
+	// Serialization
+	{
+		static const char hello_world[] = "hello \"world\"\n";
+
+		value value_list[] = {
+			value_create_int(244),
+			value_create_double(6.8),
+			value_create_double(4.0),
+			value_create_string(hello_world, sizeof(hello_world) - 1),
+			value_create_null()
+		};
+
+		static const char value_list_str[] = "[244,6.8,4.0,\"hello \\\"world\\\"\\n\",null]";
+
+		static const char map_index_a[] = "aaa";
+		static const char map_index_b[] = "bbb";
+
+		value value_map_a[] = {
+			value_create_string(map_index_a, sizeof(map_index_a) - 1),
+			value_create_double(3.333)
+		};
+
+		value value_map_b[] = {
+			value_create_string(map_index_b, sizeof(map_index_b) - 1),
+			value_create_bool(1L)
+		};
+
+		value value_map[] = {
+			value_create_array(value_map_a, sizeof(value_map_a) / sizeof(value_map_a[0])),
+			value_create_array(value_map_b, sizeof(value_map_b) / sizeof(value_map_b[0]))
+		};
+
+		static const char value_map_str[] = "{\"aaa\":3.333,\"bbb\":true}";
+
+		size_t serialize_size = 0;
+
+		value v = value_create_array(value_list, sizeof(value_list) / sizeof(value_list[0]));
+
+		char *buffer = serial_serialize(s, v, &serialize_size, allocator);
+
+		ASSERT_NE((char *)NULL, (char *)buffer);
+		EXPECT_EQ((size_t)sizeof(value_list_str), (size_t)serialize_size);
+		EXPECT_EQ((int)0, (int)strcmp(buffer, value_list_str));
+
+		value_type_destroy(v);
+
+		memory_allocator_deallocate(allocator, buffer);
+
+		v = value_create_map(value_map, sizeof(value_map) / sizeof(value_map[0]));
+
+		buffer = serial_serialize(s, v, &serialize_size, allocator);
+
+		ASSERT_NE((char *)NULL, (char *)buffer);
+		EXPECT_EQ((size_t)sizeof(value_map_str), (size_t)serialize_size);
+		EXPECT_EQ((int)0, (int)strcmp(buffer, value_map_str));
+
+		value_type_destroy(v);
+
+		memory_allocator_deallocate(allocator, buffer);
+	}
+
+	// Deserialization
+	{
+		static const char json_buffer_array[] = "[\"asdf\",443,3.2,-5000000000,false,null,\"\\u0041\\n\"]";
+		static const char json_buffer_map[] = "{\"abc\":9.9,\"cde\":{\"nested\":[1,2]}}";
+		static const char json_invalid[] = "[1,2";
+
+		value v = serial_deserialize(s, json_buffer_array, sizeof(json_buffer_array), allocator);
+
+		ASSERT_NE((value)NULL, (value)v);
+		EXPECT_EQ((type_id)TYPE_ARRAY, (type_id)value_type_id(v));
+		EXPECT_EQ((size_t)7, (size_t)value_type_count(v));
+
+		value *v_array = value_to_array(v);
+
+		EXPECT_EQ((type_id)TYPE_STRING, (type_id)value_type_id(v_array[0]));
+		EXPECT_EQ((int)0, (int)strcmp(value_to_string(v_array[0]), "asdf"));
+
+		EXPECT_EQ((type_id)TYPE_INT, (type_id)value_type_id(v_array[1]));
+		EXPECT_EQ((int)443, (int)value_to_int(v_array[1]));
+
+		EXPECT_EQ((type_id)TYPE_FLOAT, (type_id)value_type_id(v_array[2]));
+		EXPECT_EQ((float)3.2f, (float)value_to_float(v_array[2]));
+
+		EXPECT_EQ((type_id)TYPE_LONG, (type_id)value_type_id(v_array[3]));
+		EXPECT_EQ((long)-5000000000L, (long)value_to_long(v_array[3]));
+
+		EXPECT_EQ((type_id)TYPE_BOOL, (type_id)value_type_id(v_array[4]));
+		EXPECT_EQ((boolean)0L, (boolean)value_to_bool(v_array[4]));
+
+		EXPECT_EQ((type_id)TYPE_NULL, (type_id)value_type_id(v_array[5]));
+
+		EXPECT_EQ((type_id)TYPE_STRING, (type_id)value_type_id(v_array[6]));
+		EXPECT_EQ((int)0, (int)strcmp(value_to_string(v_array[6]), "A\n"));
+
+		value_type_destroy(v);
+
+		v = serial_deserialize(s, json_buffer_map, sizeof(json_buffer_map), allocator);
+
+		ASSERT_NE((value)NULL, (value)v);
+		EXPECT_EQ((type_id)TYPE_MAP, (type_id)value_type_id(v));
+		EXPECT_EQ((size_t)2, (size_t)value_type_count(v));
+
+		value *v_map = value_to_map(v);
+
+		value *tupla = value_to_array(v_map[0]);
+
+		EXPECT_EQ((int)0, (int)strcmp(value_to_string(tupla[0]), "abc"));
+		EXPECT_EQ((float)9.9f, (float)value_to_float(tupla[1]));
+
+		tupla = value_to_array(v_map[1]);
+
+		EXPECT_EQ((int)0, (int)strcmp(value_to_string(tupla[0]), "cde"));
+		EXPECT_EQ((type_id)TYPE_MAP, (type_id)value_type_id(tupla[1]));
+
+		value_type_destroy(v);
+
+		// Sizes without null terminator are accepted too
+		v = serial_deserialize(s, json_buffer_map, sizeof(json_buffer_map) - 1, allocator);
+
+		ASSERT_NE((value)NULL, (value)v);
+		EXPECT_EQ((type_id)TYPE_MAP, (type_id)value_type_id(v));
+
+		value_type_destroy(v);
+
+		EXPECT_EQ((value)NULL, (value)serial_deserialize(s, json_invalid, sizeof(json_invalid), allocator));
+	}
+
+	// Large document, round trip through serialization
+	{
+		const size_t size = 100000;
+
+		std::string json = "[";
+
+		for (size_t iterator = 0; iterator < size; ++iterator)
+		{
+			if (iterator > 0)
+			{
+				json += ",";
+			}
+
+			json += "{\"id\":" + std::to_string(iterator) + ",\"name\":\"item " + std::to_string(iterator) + "\"}";
+		}
+
+		json += "]";
+
+		value v = serial_deserialize(s, json.c_str(), json.length() + 1, allocator);
+
+		ASSERT_NE((value)NULL, (value)v);
+		EXPECT_EQ((size_t)size, (size_t)value_type_count(v));
+
+		size_t serialize_size = 0;
+
+		char *buffer = serial_serialize(s, v, &serialize_size, allocator);
+
+		ASSERT_NE((char *)NULL, (char *)buffer);
+		EXPECT_EQ((size_t)json.length() + 1, (size_t)serialize_size);
+		EXPECT_EQ((int)0, (int)strcmp(buffer, json.c_str()));
+
+		memory_allocator_deallocate(allocator, buffer);
+
+		value_type_destroy(v);
+	}
+
+	// Clear SimdJSON serial
+	EXPECT_EQ((int)0, (int)serial_clear(s));
+
+	// Destroy serial
+	serial_destroy();
+
+	// Destroy allocator
+	memory_allocator_destroy(allocator);
+}
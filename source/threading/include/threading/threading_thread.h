@@ -0,0 +1,93 @@
+/*
+ *	Thrading Library by Parra Studios
+ *	A threading library providing utilities for lock-free data structures and more.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+#ifndef THREADING_THREAD_H
+#define THREADING_THREAD_H 1
+
+/* -- Headers -- */
+
+#include <threading/threading_api.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -- Type Definitions -- */
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(_WIN64)
+	#include <windows.h>
+typedef HANDLE threading_thread_impl_type;
+#else
+	#include <pthread.h>
+typedef pthread_t threading_thread_impl_type;
+#endif
+
+typedef void (*threading_thread_routine)(void *);
+
+/* -- Member Data -- */
+
+struct threading_thread_type
+{
+	threading_thread_impl_type impl;
+	threading_thread_routine routine;
+	void *data;
+};
+
+/* -- Type Definitions -- */
+
+typedef struct threading_thread_type *threading_thread;
+
+/* -- Methods -- */
+
+/**
+*  @brief
+*    Launch a new thread which executes @routine with @data as argument
+*
+*  @param[out] t
+*    Thread to be initialized, it must remain valid until it is joined
+*
+*  @param[in] routine
+*    Function executed by the thread
+*
+*  @param[in] data
+*    Argument passed to @routine
+*
+*  @return
+*    Zero on success, different from zero otherwise
+*/
+THREADING_API int threading_thread_create(threading_thread t, threading_thread_routine routine, void *data);
+
+/**
+*  @brief
+*    Wait until the thread @t finishes and release its resources
+*
+*  @param[in] t
+*    Thread previously created with threading_thread_create
+*
+*  @return
+*    Zero on success, different from zero otherwise
+*/
+THREADING_API int threading_thread_join(threading_thread t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREADING_THREAD_H */
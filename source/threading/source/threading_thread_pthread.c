@@ -0,0 +1,61 @@
+/*
+ *	Thrading Library by Parra Studios
+ *	A threading library providing utilities for lock-free data structures and more.
+ *
+ *	Copyright (C) 2016 - 2024 Vicente Eduardo Ferrer Garcia <vic798@gmail.com>
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ *
+ */
+
+/* -- Headers -- */
+
+#include <threading/threading_thread.h>
+
+#include <stdlib.h>
+
+/* -- Private Methods -- */
+
+static void *threading_thread_start(void *data)
+{
+	threading_thread t = (threading_thread)data;
+
+	t->routine(t->data);
+
+	return NULL;
+}
+
+/* -- Methods -- */
+
+int threading_thread_create(threading_thread t, threading_thread_routine routine, void *data)
+{
+	if (t == NULL || routine == NULL)
+	{
+		return 1;
+	}
+
+	t->routine = routine;
+	t->data = data;
+
+	return pthread_create(&t->impl, NULL, &threading_thread_start, t);
+}
+
+int threading_thread_join(threading_thread t)
+{
+	if (t == NULL)
+	{
+		return 1;
+	}
+
+	return pthread_join(t->impl, NULL);
+}